@@ -2,8 +2,8 @@
 #define PCAPPP_IP_UTILS
 
 #include <stdint.h>
-#ifdef LINUX
-#include <in.h>
+#if defined(LINUX) || defined(__linux__)
+#include <netinet/in.h>
 #include <arpa/inet.h>
 #endif
 #ifdef MAC_OS_X
@@ -101,13 +101,49 @@ namespace pcpp
 	};
 
 	/**
-	 * Computes the checksum for a vector of buffers
+	 * Computes the checksum for a vector of buffers. On x86 CPUs the buffers are summed with SSE2 or AVX2 instructions, chosen at
+	 * runtime by the instruction sets the CPU supports
 	 * @param[in] vec The vector of buffers
 	 * @param[in] vecSize Number of ScalarBuffers in vector
 	 * @return The checksum result
 	 */
 	uint16_t compute_checksum(ScalarBuffer<uint16_t> vec[], size_t vecSize);
 
+	/**
+	 * Incrementally updates a checksum after a 16-bit word of the checksummed data changed, as described in RFC 1624. It takes
+	 * constant time regardless of the length of the data, so it's much faster than computing the checksum again when only a few
+	 * header fields are rewritten, for example a port in NAT. The checksum and the values can be in either byte order as long as
+	 * all of them are in the same one, so they can be taken from the packet as they are.<BR>
+	 * Notice a UDP checksum of zero means the checksum isn't used, so it shouldn't be updated
+	 * @param[in] checksum The current checksum
+	 * @param[in] oldValue The old value of the word
+	 * @param[in] newValue The new value of the word
+	 * @return The updated checksum
+	 */
+	uint16_t update_checksum16(uint16_t checksum, uint16_t oldValue, uint16_t newValue);
+
+	/**
+	 * Incrementally updates a checksum after a 32-bit field of the checksummed data changed, for example an IPv4 address which is
+	 * covered by both the IPv4 header checksum and the TCP/UDP pseudo header checksum. The field must start at an even offset of
+	 * the checksummed data. See update_checksum16() for more details
+	 * @param[in] checksum The current checksum
+	 * @param[in] oldValue The old value of the field
+	 * @param[in] newValue The new value of the field
+	 * @return The updated checksum
+	 */
+	uint16_t update_checksum32(uint16_t checksum, uint32_t oldValue, uint32_t newValue);
+
+	/**
+	 * Incrementally updates a checksum after a field of any even length changed, for example an IPv6 address. The field must start
+	 * at an even offset of the checksummed data. See update_checksum16() for more details
+	 * @param[in] checksum The current checksum
+	 * @param[in] oldData A pointer to the old value of the field
+	 * @param[in] newData A pointer to the new value of the field
+	 * @param[in] len The length of the field in bytes. Must be even
+	 * @return The updated checksum
+	 */
+	uint16_t update_checksum(uint16_t checksum, const uint8_t* oldData, const uint8_t* newData, size_t len);
+
 	/**
 	 * Computes Fowler-Noll-Vo (FNV-1) 32bit hash function on an array of byte buffers. The hash is calculated on each
 	 * byte in each byte buffer, as if all byte buffers were one long byte buffer
@@ -1,11 +1,15 @@
 #ifndef PCAPPP_LRU_LIST
 #define PCAPPP_LRU_LIST
 
-#include <map>
-#include <list>
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <utility>
 
 #if __cplusplus > 199711L || _MSC_VER >= 1800
-#include <utility>
+#include <tuple>
+#include <type_traits>
 #endif
 
 /// @file
@@ -17,35 +21,151 @@
 namespace pcpp
 {
 
+	/**
+	 * Combine the hash value of an element into the hash value of the elements before it. Used by the LRUListHash specializations for
+	 * compound types
+	 * @param[in] seed The hash value of the previous elements
+	 * @param[in] value The hash value of the element
+	 * @return The combined hash value
+	 */
+	inline size_t combineLRUListHash(size_t seed, size_t value)
+	{
+		return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+	}
+
+	/**
+	 * @struct LRUListHash
+	 * The default hash function used by LRUList. It supports integral, enum and pointer types (and any type that can be converted to
+	 * size_t), std::string, std::pair and (in C++11) std::tuple of supported types. For other types a custom hash function object should
+	 * be provided as the second template argument of LRUList
+	 */
+	template<typename T>
+	struct LRUListHash
+	{
+		/**
+		 * @param[in] element The element to hash
+		 * @return The hash value of the element
+		 */
+		size_t operator()(const T& element) const { return (size_t)element; }
+	};
+
+	/**
+	 * A specialization of LRUListHash for std::string, using the FNV-1a hash function
+	 */
+	template<>
+	struct LRUListHash<std::string>
+	{
+		/**
+		 * @param[in] element The string to hash
+		 * @return The hash value of the string
+		 */
+		size_t operator()(const std::string& element) const
+		{
+			uint32_t hash = 2166136261u;
+			for (size_t i = 0; i < element.size(); i++)
+			{
+				hash ^= (uint8_t)element[i];
+				hash *= 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	/**
+	 * A specialization of LRUListHash for std::pair, combining the hash values of both members
+	 */
+	template<typename First, typename Second>
+	struct LRUListHash<std::pair<First, Second> >
+	{
+		/**
+		 * @param[in] element The pair to hash
+		 * @return The hash value of the pair
+		 */
+		size_t operator()(const std::pair<First, Second>& element) const
+		{
+			return combineLRUListHash(LRUListHash<First>()(element.first), LRUListHash<Second>()(element.second));
+		}
+	};
+
+#if __cplusplus > 199711L || _MSC_VER >= 1800
+	/**
+	 * A specialization of LRUListHash for std::tuple, combining the hash values of all members
+	 */
+	template<typename... Types>
+	struct LRUListHash<std::tuple<Types...> >
+	{
+		/**
+		 * @param[in] element The tuple to hash
+		 * @return The hash value of the tuple
+		 */
+		size_t operator()(const std::tuple<Types...>& element) const { return hashMembers<0>(element, 0); }
+
+	private:
+		template<size_t Index>
+		typename std::enable_if<Index == sizeof...(Types), size_t>::type hashMembers(const std::tuple<Types...>&, size_t seed) const
+		{
+			return seed;
+		}
+
+		template<size_t Index>
+		typename std::enable_if<(Index < sizeof...(Types)), size_t>::type hashMembers(const std::tuple<Types...>& element, size_t seed) const
+		{
+			typedef typename std::tuple_element<Index, std::tuple<Types...> >::type MemberType;
+			return hashMembers<Index + 1>(element, combineLRUListHash(seed, LRUListHash<MemberType>()(std::get<Index>(element))));
+		}
+	};
+#endif
+
 	/**
 	 * @class LRUList
 	 * A template class that implements a LRU cache with limited size. Each time the user puts an element it goes to head of the
 	 * list as the most recently used element (if the element was already in the list it advances to the head of the list).
 	 * The last element in the list is the one least recently used and will be pulled out of the list if it reaches its max size
-	 * and a new element comes in. All actions on this LRU list are O(1)
+	 * and a new element comes in.<BR>
+	 * All elements are stored in a node array allocated in the c'tor, which is linked both into the LRU list and into a hash
+	 * index, so all actions on this LRU list are O(1) and no memory is allocated after construction.<BR>
+	 * Unlike the previous std::list and std::map based implementation, which only required T to be copyable and to have operator<,
+	 * this implementation requires T to be:
+	 * - default-constructible and copy-assignable, since the node array is allocated up front and nodes are re-used
+	 * - comparable with operator==
+	 * - hashable by the Hash function object, which defaults to LRUListHash (see the types it supports). Other types need a custom
+	 *   hash function object
+	 *
+	 * Nodes are linked by 32-bit indices, so a list holds at most getMaxSupportedSize() elements
 	 */
-	template<typename T>
+	template<typename T, typename Hash = LRUListHash<T> >
 	class LRUList
 	{
 	public:
 
-		typedef typename std::list<T>::iterator ListIterator;
-		typedef typename std::map<T, ListIterator>::iterator MapIterator;
-
 		/**
-		 * A c'tor for this class
-		 * @param[in] maxSize The max size this list can go
+		 * A c'tor for this class. It allocates all memory the list will use
+		 * @param[in] maxSize The max size this list can go. Values larger than getMaxSupportedSize() are clamped to it
+		 * @param[in] hash The hash function object. This parameter is optional, a default-constructed object is used if not provided
 		 */
-		LRUList(size_t maxSize)
+		LRUList(size_t maxSize, const Hash& hash = Hash())
+			: m_Nodes(clampMaxSize(maxSize)), m_Hash(hash), m_MaxSize(clampMaxSize(maxSize)), m_Size(0), m_Head(NullIndex), m_Tail(NullIndex),
+			  m_FreeList(NullIndex)
 		{
-			m_MaxSize = maxSize;
+			// all nodes start in the free list
+			for (size_t i = m_MaxSize; i > 0; i--)
+			{
+				m_Nodes[i - 1].next = m_FreeList;
+				m_FreeList = (uint32_t)(i - 1);
+			}
+
+			// at least 2 buckets per element keeps the hash chains short
+			size_t numOfBuckets = 1;
+			while (numOfBuckets < 2 * m_MaxSize)
+				numOfBuckets *= 2;
+			m_Buckets.resize(numOfBuckets, (uint32_t)NullIndex);
 		}
 
 		/**
 		 * Puts an element in the list. This element will be inserted (or advanced if it already exists) to the head of the
 		 * list as the most recently used element. If the list already reached its max size and the element is new this method
-		 * will remove the least recently used element and return a value in deletedValue. Method complexity is O(log(getSize())).
-		 * This is a optimized version of the method T* put(const T&).
+		 * will remove the least recently used element and return a value in deletedValue. Method complexity is O(1) and it doesn't
+		 * allocate memory.
 		 * @param[in] element The element to insert or to advance to the head of the list (if already exists)
 		 * @param[out] deletedValue The value of deleted element if a pointer is not NULL. This parameter is optional.
 		 * @return 0 if the list didn't reach its max size, 1 otherwise. In case the list already reached its max size
@@ -53,33 +173,80 @@ namespace pcpp
 		 */
 		int put(const T& element, T* deletedValue = NULL)
 		{
-			m_CacheItemsList.push_front(element);
+			size_t hash = m_Hash(element);
+			uint32_t index = findNode(element, hash);
+			if (index != NullIndex)
+			{
+				moveToHead(index);
+				return 0;
+			}
 
-			// Inserting a new element. If an element with an equivalent key already exists the method returns an iterator to the element that prevented the insertion
-			std::pair<MapIterator, bool> pair = m_CacheItemsMap.insert(std::make_pair(element, m_CacheItemsList.begin()));
-			if (pair.second == false) // already exists
+			// a list with no room evicts the new element itself
+			if (m_MaxSize == 0)
 			{
-				m_CacheItemsList.erase(pair.first->second);
-				pair.first->second = m_CacheItemsList.begin();
+				if (deletedValue != NULL)
+					*deletedValue = element;
+				return 1;
 			}
 
-			if (m_CacheItemsMap.size() > m_MaxSize)
+			int result = 0;
+			if (m_Size == m_MaxSize)
 			{
-				ListIterator lruIter = m_CacheItemsList.end();
-				lruIter--;
+				// re-use the node of the least recently used element
+				index = m_Tail;
+				unlinkNode(index);
+				removeFromBucket(index);
 
 				if (deletedValue != NULL)
 #if __cplusplus > 199711L || _MSC_VER >= 1800
-					*deletedValue = std::move(*lruIter);
+					*deletedValue = std::move(m_Nodes[index].element);
 #else
-					*deletedValue = *lruIter;
+					*deletedValue = m_Nodes[index].element;
 #endif
-				m_CacheItemsMap.erase(*lruIter);
-				m_CacheItemsList.erase(lruIter);
-				return 1;
+				result = 1;
+			}
+			else
+			{
+				index = m_FreeList;
+				m_FreeList = m_Nodes[index].next;
+				m_Size++;
 			}
 
-			return 0;
+			Node& node = m_Nodes[index];
+			node.element = element;
+			node.hash = hash;
+			uint32_t& bucket = m_Buckets[getBucketIndex(hash)];
+			node.bucketNext = bucket;
+			bucket = index;
+			linkAtHead(index);
+
+			return result;
+		}
+
+		/**
+		 * Look up an element and, if it's in the list, advance it to the head of the list as the most recently used element.
+		 * Method complexity is O(1)
+		 * @param[in] element The element to look up
+		 * @return True if the element is in the list, false otherwise
+		 */
+		bool touch(const T& element)
+		{
+			uint32_t index = findNode(element, m_Hash(element));
+			if (index == NullIndex)
+				return false;
+
+			moveToHead(index);
+			return true;
+		}
+
+		/**
+		 * Check whether an element is in the list without changing its position. Method complexity is O(1)
+		 * @param[in] element The element to look up
+		 * @return True if the element is in the list, false otherwise
+		 */
+		bool contains(const T& element) const
+		{
+			return findNode(element, m_Hash(element)) != NullIndex;
 		}
 
 		/**
@@ -88,7 +255,7 @@ namespace pcpp
 		 */
 		const T& getMRUElement() const
 		{
-			return m_CacheItemsList.front();
+			return m_Nodes[m_Head].element;
 		}
 
 		/**
@@ -97,7 +264,7 @@ namespace pcpp
 		 */
 		const T& getLRUElement() const
 		{
-			return m_CacheItemsList.back();
+			return m_Nodes[m_Tail].element;
 		}
 
 		/**
@@ -106,12 +273,15 @@ namespace pcpp
 		 */
 		void eraseElement(const T& element)
 		{
-			MapIterator iter = m_CacheItemsMap.find(element);
-			if (iter == m_CacheItemsMap.end())
+			uint32_t index = findNode(element, m_Hash(element));
+			if (index == NullIndex)
 				return;
 
-			m_CacheItemsList.erase(iter->second);
-			m_CacheItemsMap.erase(iter);
+			unlinkNode(index);
+			removeFromBucket(index);
+			m_Nodes[index].next = m_FreeList;
+			m_FreeList = index;
+			m_Size--;
 		}
 
 		/**
@@ -122,12 +292,115 @@ namespace pcpp
 		/**
 		 * @return The number of elements currently in this list
 		 */
-		size_t getSize() const { return m_CacheItemsMap.size(); }
+		size_t getSize() const { return m_Size; }
+
+		/**
+		 * @return The largest max size a list can have. Nodes are linked by 32-bit indices (one of which marks the end of a list), and
+		 * the bucket count, which is at least twice the max size, must fit in size_t
+		 */
+		static size_t getMaxSupportedSize()
+		{
+			size_t maxIndexSize = (size_t)NullIndex;
+			size_t maxBucketSize = ((size_t)-1) / 4;
+			return (maxIndexSize < maxBucketSize ? maxIndexSize : maxBucketSize);
+		}
 
 	private:
-		std::list<T> m_CacheItemsList;
-		std::map<T, ListIterator> m_CacheItemsMap;
+		enum { NullIndex = 0xFFFFFFFF };
+
+		// nodes are linked by their indices so the list can be copied as is
+		struct Node
+		{
+			T element;
+			size_t hash;
+			uint32_t prev;
+			uint32_t next;
+			uint32_t bucketNext;
+
+			Node() : element(), hash(0), prev(NullIndex), next(NullIndex), bucketNext(NullIndex) {}
+		};
+
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_Buckets;
+		Hash m_Hash;
 		size_t m_MaxSize;
+		size_t m_Size;
+		uint32_t m_Head;
+		uint32_t m_Tail;
+		// unused nodes, linked by their next index
+		uint32_t m_FreeList;
+
+		static size_t clampMaxSize(size_t maxSize)
+		{
+			return (maxSize > getMaxSupportedSize() ? getMaxSupportedSize() : maxSize);
+		}
+
+		size_t getBucketIndex(size_t hash) const
+		{
+			// mix the bits since the default hash of integers is the identity
+			uint32_t mixed = (uint32_t)hash ^ (uint32_t)((uint64_t)hash >> 32);
+			mixed ^= mixed >> 16;
+			mixed *= 0x45d9f3bu;
+			mixed ^= mixed >> 16;
+			return mixed & (m_Buckets.size() - 1);
+		}
+
+		uint32_t findNode(const T& element, size_t hash) const
+		{
+			uint32_t index = m_Buckets[getBucketIndex(hash)];
+			while (index != NullIndex)
+			{
+				const Node& node = m_Nodes[index];
+				if (node.hash == hash && node.element == element)
+					return index;
+				index = node.bucketNext;
+			}
+
+			return NullIndex;
+		}
+
+		void removeFromBucket(uint32_t index)
+		{
+			uint32_t* link = &m_Buckets[getBucketIndex(m_Nodes[index].hash)];
+			while (*link != index)
+				link = &m_Nodes[*link].bucketNext;
+			*link = m_Nodes[index].bucketNext;
+		}
+
+		void linkAtHead(uint32_t index)
+		{
+			Node& node = m_Nodes[index];
+			node.prev = NullIndex;
+			node.next = m_Head;
+			if (m_Head != NullIndex)
+				m_Nodes[m_Head].prev = index;
+			else
+				m_Tail = index;
+			m_Head = index;
+		}
+
+		void unlinkNode(uint32_t index)
+		{
+			Node& node = m_Nodes[index];
+			if (node.prev != NullIndex)
+				m_Nodes[node.prev].next = node.next;
+			else
+				m_Head = node.next;
+
+			if (node.next != NullIndex)
+				m_Nodes[node.next].prev = node.prev;
+			else
+				m_Tail = node.prev;
+		}
+
+		void moveToHead(uint32_t index)
+		{
+			if (index == m_Head)
+				return;
+
+			unlinkNode(index);
+			linkAtHead(index);
+		}
 	};
 
 } // namespace pcpp
@@ -3,6 +3,8 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
 
 #ifndef LOG_MODULE
 #define LOG_MODULE UndefinedLogModule
@@ -10,6 +12,34 @@
 
 /// @file
 
+/** Compile-time log level in which both debug and error log statements are compiled */
+#define PCPP_LOG_LEVEL_DEBUG 0
+/** Compile-time log level in which only error log statements are compiled */
+#define PCPP_LOG_LEVEL_ERROR 1
+/** Compile-time log level in which no log statements are compiled */
+#define PCPP_LOG_LEVEL_NONE 2
+
+/**
+ * The minimum log level compiled into the code. Log statements below this level are removed at compile time, so they cost nothing
+ * even in hot paths and can't be enabled at runtime. It can be set for example with -DPCPP_MIN_LOG_LEVEL=1 (see the
+ * --disable-debug-log switch of the configure scripts). The default is PCPP_LOG_LEVEL_DEBUG which keeps all log statements
+ */
+#ifndef PCPP_MIN_LOG_LEVEL
+#define PCPP_MIN_LOG_LEVEL PCPP_LOG_LEVEL_DEBUG
+#endif
+
+/** The default number of messages each thread can queue when asynchronous logging is enabled */
+#define PCPP_ASYNC_LOG_DEFAULT_QUEUE_SIZE 256
+
+/** The maximum length of a message written with asynchronous logging. Longer messages are truncated */
+#define PCPP_ASYNC_LOG_MAX_MESSAGE_LEN 512
+
+#if defined(__GNUC__)
+#define PCPP_LOG_PRINTF_FORMAT(formatIndex, firstArgIndex) __attribute__((format(printf, formatIndex, firstArgIndex)))
+#else
+#define PCPP_LOG_PRINTF_FORMAT(formatIndex, firstArgIndex)
+#endif
+
 /**
  * \namespace pcpp
  * \brief The main namespace for the PcapPlusPlus lib
@@ -63,9 +93,25 @@ namespace pcpp
 		PcapLogModuleDpdkDevice, ///< DpdkDevice module (Pcap++)
 		PcapLogModuleKniDevice, ///< KniDevice module (Pcap++)
 		NetworkUtils, ///< NetworkUtils module (Pcap++)
+		PcapLogModuleAfPacketDevice, ///< AfPacketDevice module (Pcap++)
 		NumOfLogModules
 	};
 
+	/**
+	 * @struct LogRateLimitState
+	 * The error rate limit state of a single LOG_ERROR statement. Every LOG_ERROR statement holds a static instance of this struct,
+	 * it shouldn't be used directly
+	 */
+	struct LogRateLimitState
+	{
+		/** The second in which the current rate limit window started */
+		uint32_t WindowStart;
+		/** The number of errors printed in the current window */
+		uint32_t NumOfErrorsInWindow;
+		/** The number of errors dropped in the current window */
+		uint32_t NumOfSuppressedErrors;
+	};
+
 	/**
 	 * @class LoggerPP
 	 * The PcapPlusPlus log manager class.
@@ -77,6 +123,14 @@ namespace pcpp
 	 * Error logs: errors are printed by default to stderr. The user can change this behavior in several manners:
 	 * 1. Suppress errors - no errors will be printed (for all modules)
 	 * 2. Print error logs to a string provided by the user instead of stderr
+	 * 3. Limit the number of errors each LOG_ERROR statement prints per second (see setErrorRateLimit()), so a burst of malformed
+	 *    traffic doesn't flood the output
+	 *
+	 * Asynchronous logging: by default messages are written to stdout/stderr by the thread that logs them. When asynchronous logging
+	 * is enabled (see enableAsyncLogging()) each thread formats its messages into its own lock-free queue and a background thread
+	 * writes them, so capture threads never block on console or file I/O. If a thread's queue is full the message is dropped
+	 *
+	 * Log statements can also be removed at compile time by setting PCPP_MIN_LOG_LEVEL.
 	 *
 	 * PcapPlusPlus logger is a singleton which can be reached from anywhere in the code *
 	 */
@@ -163,6 +217,82 @@ namespace pcpp
 		 */
 		bool isSupressErrors() const { return m_SuppressErrors; }
 
+		/**
+		 * Limit the number of errors each LOG_ERROR statement prints per second. Errors above the limit are dropped, and when the
+		 * statement prints again a line with the number of errors dropped is printed before it. When several threads log from the
+		 * same statement the limit is approximate
+		 * @param[in] maxErrorsPerSecond The maximum number of errors per second per LOG_ERROR statement. Zero means no limit, which
+		 * is the default
+		 */
+		void setErrorRateLimit(uint32_t maxErrorsPerSecond) { m_ErrorRateLimit = maxErrorsPerSecond; }
+
+		/**
+		 * @return The maximum number of errors per second per LOG_ERROR statement, or zero if errors aren't rate limited
+		 */
+		uint32_t getErrorRateLimit() const { return m_ErrorRateLimit; }
+
+		/**
+		 * @return The number of error messages dropped by the error rate limit since the application started
+		 */
+		uint64_t getNumOfRateLimitedErrors() const { return m_NumOfRateLimitedErrors; }
+
+		/**
+		 * Start writing log messages asynchronously. From now on every thread that logs a message gets its own queue, allocated on its
+		 * first message, and a background thread writes the queued messages to stdout/stderr. Errors written to a user-provided error
+		 * string (see setErrorString()) are still written synchronously
+		 * @param[in] queueSizePerThread The number of messages each thread can queue. Messages logged while the queue is full are
+		 * dropped. The default is PCPP_ASYNC_LOG_DEFAULT_QUEUE_SIZE
+		 * @return True if asynchronous logging was started or is already enabled, false if the queue size is zero or the background
+		 * thread couldn't be created
+		 */
+		bool enableAsyncLogging(size_t queueSizePerThread = PCPP_ASYNC_LOG_DEFAULT_QUEUE_SIZE);
+
+		/**
+		 * Stop writing log messages asynchronously. All queued messages are written and the background thread is stopped. This method
+		 * shouldn't be called while other threads are logging, for example it should be called after capture threads were stopped
+		 */
+		void disableAsyncLogging();
+
+		/**
+		 * @return True if asynchronous logging is enabled, false otherwise
+		 */
+		bool isAsyncLoggingEnabled() const { return m_AsyncLogSink != NULL; }
+
+		/**
+		 * Wait until all messages queued so far are written. Does nothing if asynchronous logging isn't enabled
+		 */
+		void flushAsyncLog();
+
+		/**
+		 * @return The number of messages dropped because a thread's queue was full since asynchronous logging was enabled
+		 */
+		uint64_t getNumOfDroppedLogMessages() const;
+
+		/**
+		 * Write a debug message. This method is used by LOG_DEBUG and shouldn't be called directly
+		 * @param[in] format A printf-like format string
+		 */
+		void writeDebugLog(const char* format, ...) PCPP_LOG_PRINTF_FORMAT(2, 3);
+
+		/**
+		 * Write an error message. This method is used by LOG_ERROR and shouldn't be called directly
+		 * @param[in] format A printf-like format string
+		 */
+		void writeErrorLog(const char* format, ...) PCPP_LOG_PRINTF_FORMAT(2, 3);
+
+		/**
+		 * Check whether a LOG_ERROR statement may print another error under the error rate limit. This method is used by LOG_ERROR
+		 * and shouldn't be called directly
+		 * @param[in] state The rate limit state of the statement
+		 * @param[in] file The source file of the statement
+		 * @param[in] line The source line of the statement
+		 * @return True if the error should be printed, false if it should be dropped
+		 */
+		bool checkErrorRateLimit(LogRateLimitState& state, const char* file, int line)
+		{
+			return m_ErrorRateLimit == 0 || checkErrorRateLimitWindow(state, file, line);
+		}
+
 		/**
 		 * Get access to LoggerPP singleton
 		 * @todo: make this singleton thread-safe/
@@ -177,26 +307,49 @@ namespace pcpp
 		char* m_ErrorString;
 		int m_ErrorStringLen;
 		bool m_SuppressErrors;
+		uint32_t m_ErrorRateLimit;
+		uint64_t m_NumOfRateLimitedErrors;
+		void* m_AsyncLogSink;
 		LoggerPP::LogLevel m_LogModulesArray[NumOfLogModules];
 		LoggerPP();
+		~LoggerPP();
+
+		bool checkErrorRateLimitWindow(LogRateLimitState& state, const char* file, int line);
+		void writeAsyncLog(bool isError, const char* format, va_list args);
 	};
 
+// when a log level is compiled out the statement is kept inside "if (false)" so the format string and arguments are still checked
+// by the compiler, but no code is generated for it
+
+#if PCPP_MIN_LOG_LEVEL <= PCPP_LOG_LEVEL_DEBUG
 #define LOG_DEBUG(format, ...) do { \
 			if(pcpp::LoggerPP::getInstance().isDebugEnabled(LOG_MODULE)) { \
-				printf("[%-35s: %-25s: line:%-4d] " format "\n", __FILE__, __FUNCTION__, __LINE__, ## __VA_ARGS__); \
+				pcpp::LoggerPP::getInstance().writeDebugLog("[%-35s: %-25s: line:%-4d] " format "\n", __FILE__, __FUNCTION__, __LINE__, ## __VA_ARGS__); \
 			} \
 	} while(0)
 
+#define IS_DEBUG pcpp::LoggerPP::getInstance().isDebugEnabled(LOG_MODULE)
+#else
+#define LOG_DEBUG(format, ...) do { \
+			if (false) \
+				printf(format "\n", ## __VA_ARGS__); \
+	} while(0)
+
+#define IS_DEBUG false
+#endif
+
+#if PCPP_MIN_LOG_LEVEL <= PCPP_LOG_LEVEL_ERROR
 #define LOG_ERROR(format, ...) do { \
-			if (!pcpp::LoggerPP::getInstance().isSupressErrors()) {\
-				if(pcpp::LoggerPP::getInstance().isErrorStringSet()) \
-					snprintf(pcpp::LoggerPP::getInstance().getErrorString(), pcpp::LoggerPP::getInstance().getErrorStringLength(), format "\n", ## __VA_ARGS__); \
-				else \
-					fprintf(stderr, format "\n", ## __VA_ARGS__); \
-			} \
+			static pcpp::LogRateLimitState pcppLogRateLimitState = { 0, 0, 0 }; \
+			if (!pcpp::LoggerPP::getInstance().isSupressErrors() && pcpp::LoggerPP::getInstance().checkErrorRateLimit(pcppLogRateLimitState, __FILE__, __LINE__)) \
+				pcpp::LoggerPP::getInstance().writeErrorLog(format "\n", ## __VA_ARGS__); \
 		} while (0)
-
-#define IS_DEBUG pcpp::LoggerPP::getInstance().isDebugEnabled(LOG_MODULE)
+#else
+#define LOG_ERROR(format, ...) do { \
+			if (false) \
+				fprintf(stderr, format "\n", ## __VA_ARGS__); \
+		} while (0)
+#endif
 
 } // namespace pcpp
 
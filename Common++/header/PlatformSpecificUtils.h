@@ -14,6 +14,12 @@
 #define PCAP_SLEEP(seconds) sleep(seconds)
 #endif
 
+#ifdef WIN32
+#define PCAP_MSLEEP(milliseconds) Sleep(milliseconds)
+#else
+#define PCAP_MSLEEP(milliseconds) usleep((milliseconds)*1000)
+#endif
+
 #ifdef WIN32
 #define CREATE_DIRECTORY(dir) CreateDirectoryA(dir, NULL)
 #else
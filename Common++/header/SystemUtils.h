@@ -14,6 +14,11 @@
 
 #define MAX_NUM_OF_CORES 32
 
+/**
+ * The maximum number of cores a CoreSet can hold, same as the default CPU_SETSIZE on Linux
+ */
+#define MAX_NUM_OF_CORES_IN_CORE_SET 1024
+
 #ifdef _MSC_VER
 int gettimeofday(struct timeval * tp, struct timezone * tzp);
 #endif
@@ -27,7 +32,7 @@ namespace pcpp
 
 	/**
 	 * @struct SystemCore
-	 * Represents data of 1 CPU core. Current implementation supports up to 32 cores
+	 * Represents data of 1 CPU core. Cores 0-31 can also be represented in a CoreMask, cores of any ID can be represented in a CoreSet
 	 */
 	struct SystemCore
 	{
@@ -35,13 +40,14 @@ namespace pcpp
 		 * Core position in a 32-bit mask. For each core this attribute holds a 4B integer where only 1 bit is set, according to the core ID.
 		 * For example: in core #0 the right-most bit will be set (meaning the number 0x01);
 		 * 				in core #5 the 5th right-most bit will be set (meaning the number 0x20)...
+		 * For cores 32 and above, which can't be represented in a 32-bit mask, this value is 0
 		 */
 		uint32_t Mask;
 
 		/**
-		 * Core ID - a value between 0 and 31
+		 * Core ID - a value between 0 and MAX_NUM_OF_CORES_IN_CORE_SET-1
 		 */
-		uint8_t Id;
+		uint16_t Id;
 
 		/**
 		* Overload of the comparison operator
@@ -229,6 +235,167 @@ namespace pcpp
 	 */
 	void createCoreVectorFromCoreMask(CoreMask coreMask, std::vector<SystemCore>& resultVec);
 
+	/**
+	 * Get the SystemCore representation of a core by its ID. Unlike SystemCores#IdToSystemCore, this works for cores 32 and above too
+	 * @param[in] coreId The core ID
+	 * @return The SystemCore of this core. Its mask is 0 if the core ID is 32 or above
+	 */
+	SystemCore getSystemCoreById(int coreId);
+
+	/**
+	 * @class CoreSet
+	 * A set of CPU cores, for machines that have more cores than a CoreMask can represent. It can hold cores with IDs up to
+	 * MAX_NUM_OF_CORES_IN_CORE_SET-1. A CoreMask is implicitly converted to a CoreSet, so methods that get a CoreSet can also be
+	 * called with a CoreMask. The cores of a set can be iterated like this:
+	 * @code
+	 * for (int coreId = coreSet.getFirstCore(); coreId >= 0; coreId = coreSet.getNextCore(coreId))
+	 * @endcode
+	 */
+	class CoreSet
+	{
+	public:
+		/**
+		 * A c'tor that creates an empty set
+		 */
+		CoreSet();
+
+		/**
+		 * A c'tor that creates a set from a core mask
+		 * @param[in] coreMask The core mask
+		 */
+		CoreSet(CoreMask coreMask);
+
+		/**
+		 * A c'tor that creates a set from a vector of core IDs. IDs out of range are ignored
+		 * @param[in] coreIds The core IDs
+		 */
+		explicit CoreSet(const std::vector<int>& coreIds);
+
+		/**
+		 * Add a core to the set
+		 * @param[in] coreId The core ID
+		 * @return True if the core was added or was already in the set, false if the core ID is out of range
+		 */
+		bool addCore(int coreId);
+
+		/**
+		 * Remove a core from the set
+		 * @param[in] coreId The core ID
+		 */
+		void removeCore(int coreId);
+
+		/**
+		 * @param[in] coreId The core ID
+		 * @return True if the core is in the set, false otherwise
+		 */
+		bool containsCore(int coreId) const;
+
+		/**
+		 * @return The number of cores in the set
+		 */
+		int getCoreCount() const;
+
+		/**
+		 * @return True if the set has no cores, false otherwise
+		 */
+		bool isEmpty() const;
+
+		/**
+		 * Remove all cores from the set
+		 */
+		void clear();
+
+		/**
+		 * @return The lowest core ID in the set, or -1 if the set is empty
+		 */
+		int getFirstCore() const;
+
+		/**
+		 * @param[in] coreId A core ID
+		 * @return The lowest core ID in the set which is larger than coreId, or -1 if there is none
+		 */
+		int getNextCore(int coreId) const;
+
+		/**
+		 * Get the IDs of all cores in the set
+		 * @param[out] coreIds A vector to which the core IDs are added in ascending order
+		 */
+		void getCoreIds(std::vector<int>& coreIds) const;
+
+		/**
+		 * @return A core mask of cores 0-31 in the set. Cores 32 and above are omitted
+		 */
+		CoreMask toCoreMask() const;
+
+		/**
+		 * @return The set as a list of cores and core ranges, for example "0-3,8,10-11". This is the format Linux uses for CPU lists
+		 * and DPDK uses for the -l argument. An empty set is an empty string
+		 */
+		std::string toString() const;
+
+		/**
+		 * Set the cores of the set from a list of cores and core ranges, for example "0-3,8,10-11". Whitespace is ignored
+		 * @param[in] coreList The core list
+		 * @return True if the list was parsed successfully, false if it's malformed or has a core ID out of range, in which case the
+		 * set is left empty
+		 */
+		bool fromString(const std::string& coreList);
+
+		/**
+		 * Add all cores of another set to this set
+		 * @param[in] other The other set
+		 * @return A reference to this set
+		 */
+		CoreSet& operator|=(const CoreSet& other);
+
+		/**
+		 * Remove all cores which aren't in another set from this set
+		 * @param[in] other The other set
+		 * @return A reference to this set
+		 */
+		CoreSet& operator&=(const CoreSet& other);
+
+		/**
+		 * @return True if both sets contain the same cores, false otherwise
+		 */
+		bool operator==(const CoreSet& other) const;
+
+		/**
+		 * @return True if the sets don't contain the same cores, false otherwise
+		 */
+		bool operator!=(const CoreSet& other) const { return !(*this == other); }
+
+	private:
+		uint64_t m_Bits[MAX_NUM_OF_CORES_IN_CORE_SET / 64];
+	};
+
+	/**
+	 * Create a core set of all cores available on machine. Unlike getCoreMaskForAllMachineCores() it isn't limited to 32 cores
+	 * @return A core set of all cores available on machine
+	 */
+	CoreSet getCoreSetForAllMachineCores();
+
+	/**
+	 * @return The number of NUMA nodes on the machine. On platforms where NUMA information isn't available the machine is considered
+	 * to have one node
+	 */
+	int getNumOfNumaNodes();
+
+	/**
+	 * Get the NUMA node a core belongs to
+	 * @param[in] coreId The core ID
+	 * @return The NUMA node of the core or -1 if the core doesn't exist. On platforms where NUMA information isn't available all cores
+	 * belong to node 0
+	 */
+	int getNumaNodeOfCore(int coreId);
+
+	/**
+	 * Get the cores of a NUMA node, for example to run capture threads on the node a NIC is attached to
+	 * @param[in] numaNode The NUMA node
+	 * @return The cores of the node, or an empty set if the node doesn't exist
+	 */
+	CoreSet getCoreSetForNumaNode(int numaNode);
+
 	/**
 	 * Execute a shell command and return its output
 	 * @param[in] command The command to run
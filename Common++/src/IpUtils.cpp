@@ -4,6 +4,14 @@
 #include "Logger.h"
 #include <string.h>
 #include <stdio.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PCPP_CHECKSUM_SSE2
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#include <immintrin.h>
+#define PCPP_CHECKSUM_AVX2
+#endif
+#endif
 #ifndef NS_INADDRSZ
 #define NS_INADDRSZ	4
 #endif
@@ -59,48 +67,177 @@ uint32_t in_addr2int(in_addr inAddr)
 #endif
 }
 
-uint16_t compute_checksum(ScalarBuffer<uint16_t> vec[], size_t vecSize)
+// all sum functions add the buffer as 16-bit words in host byte order, and add a trailing odd byte as is. The result isn't folded
+typedef uint64_t (*ChecksumSumFunc)(const uint8_t* buffer, size_t len);
+
+static uint64_t checksumSumScalar(const uint8_t* buffer, size_t len)
 {
-	uint32_t sum = 0;
-	for (size_t i = 0; i<vecSize; i++)
+	// adding 32-bit words and folding later gives the same result as adding 16-bit words
+	uint64_t sum = 0;
+	while (len >= 4)
 	{
-		uint32_t local_sum = 0;
-		size_t buff_len = vec[i].len;
-		while (buff_len > 1) {
-			LOG_DEBUG("Value to add = 0x%4X", *(vec[i].buffer));
-			local_sum += *(vec[i].buffer);
-			++(vec[i].buffer);
-			buff_len -= 2;
-		}
-		LOG_DEBUG("Local sum = %d, 0x%4X", local_sum, local_sum);
+		uint32_t word;
+		memcpy(&word, buffer, sizeof(word));
+		sum += word;
+		buffer += 4;
+		len -= 4;
+	}
+
+	if (len >= 2)
+	{
+		uint16_t word;
+		memcpy(&word, buffer, sizeof(word));
+		sum += word;
+		buffer += 2;
+		len -= 2;
+	}
+
+	if (len == 1)
+		sum += *buffer;
+
+	return sum;
+}
+
+// the number of vectors added to 32-bit lanes before they're moved to the 64-bit sum. Each vector adds 2 words of up to 0xffff
+// to every lane, so the lanes can't overflow
+#define CHECKSUM_SIMD_VECTORS_PER_CHUNK 0x8000
+
+#ifdef PCPP_CHECKSUM_SSE2
 
-		if (buff_len == 1)
+static uint64_t checksumSumSse2(const uint8_t* buffer, size_t len)
+{
+	const __m128i zero = _mm_setzero_si128();
+	uint64_t sum = 0;
+	size_t numOfVectors = len / 16;
+
+	while (numOfVectors > 0)
+	{
+		size_t chunkSize = (numOfVectors < CHECKSUM_SIMD_VECTORS_PER_CHUNK ? numOfVectors : CHECKSUM_SIMD_VECTORS_PER_CHUNK);
+		numOfVectors -= chunkSize;
+
+		// zero-extend the 16-bit words to 32-bit lanes and add them
+		__m128i lanes = zero;
+		for (size_t i = 0; i < chunkSize; i++)
 		{
-			uint8_t lastByte = *(vec[i].buffer);
-			LOG_DEBUG("1 byte left, adding value: 0x%4X", lastByte);
-			local_sum += lastByte;
-			LOG_DEBUG("Local sum = %d, 0x%4X", local_sum, local_sum);
+			__m128i vec = _mm_loadu_si128((const __m128i*)buffer);
+			lanes = _mm_add_epi32(lanes, _mm_unpacklo_epi16(vec, zero));
+			lanes = _mm_add_epi32(lanes, _mm_unpackhi_epi16(vec, zero));
+			buffer += 16;
 		}
 
-		while (local_sum>>16) {
-			local_sum = (local_sum & 0xffff) + (local_sum >> 16);
+		uint32_t laneSums[4];
+		_mm_storeu_si128((__m128i*)laneSums, lanes);
+		sum += (uint64_t)laneSums[0] + laneSums[1] + laneSums[2] + laneSums[3];
+	}
+
+	return sum + checksumSumScalar(buffer, len % 16);
+}
+
+#endif // PCPP_CHECKSUM_SSE2
+
+#ifdef PCPP_CHECKSUM_AVX2
+
+__attribute__((target("avx2")))
+static uint64_t checksumSumAvx2(const uint8_t* buffer, size_t len)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	uint64_t sum = 0;
+	size_t numOfVectors = len / 32;
+
+	while (numOfVectors > 0)
+	{
+		size_t chunkSize = (numOfVectors < CHECKSUM_SIMD_VECTORS_PER_CHUNK ? numOfVectors : CHECKSUM_SIMD_VECTORS_PER_CHUNK);
+		numOfVectors -= chunkSize;
+
+		__m256i lanes = zero;
+		for (size_t i = 0; i < chunkSize; i++)
+		{
+			__m256i vec = _mm256_loadu_si256((const __m256i*)buffer);
+			lanes = _mm256_add_epi32(lanes, _mm256_unpacklo_epi16(vec, zero));
+			lanes = _mm256_add_epi32(lanes, _mm256_unpackhi_epi16(vec, zero));
+			buffer += 32;
 		}
-		local_sum = ntohs(local_sum);
-		LOG_DEBUG("Local sum = %d, 0x%4X", local_sum, local_sum);
-		sum += local_sum;
+
+		uint32_t laneSums[8];
+		_mm256_storeu_si256((__m256i*)laneSums, lanes);
+		for (int i = 0; i < 8; i++)
+			sum += laneSums[i];
 	}
 
-	while (sum>>16) {
+	return sum + checksumSumSse2(buffer, len % 32);
+}
+
+#endif // PCPP_CHECKSUM_AVX2
+
+static ChecksumSumFunc selectChecksumSumFunc()
+{
+#ifdef PCPP_CHECKSUM_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return checksumSumAvx2;
+#endif
+#ifdef PCPP_CHECKSUM_SSE2
+	return checksumSumSse2;
+#else
+	return checksumSumScalar;
+#endif
+}
+
+// chosen on first use. Threads racing on the first use all store the same value
+static ChecksumSumFunc ChecksumSum = NULL;
+
+static inline uint16_t foldChecksumSum(uint64_t sum)
+{
+	while (sum >> 16)
 		sum = (sum & 0xffff) + (sum >> 16);
+
+	return (uint16_t)sum;
+}
+
+uint16_t compute_checksum(ScalarBuffer<uint16_t> vec[], size_t vecSize)
+{
+	if (ChecksumSum == NULL)
+		ChecksumSum = selectChecksumSumFunc();
+
+	uint32_t sum = 0;
+	for (size_t i = 0; i<vecSize; i++)
+	{
+		// each buffer is folded on its own, so a buffer with an odd length is padded with zero regardless of the next buffer
+		uint16_t localSum = foldChecksumSum(ChecksumSum((const uint8_t*)vec[i].buffer, vec[i].len));
+		sum += ntohs(localSum);
 	}
 
-	LOG_DEBUG("Sum before invert = %d, 0x%4X", sum, sum);
+	return (uint16_t)~foldChecksumSum(sum);
+}
 
-	sum = ~sum;
+uint16_t update_checksum16(uint16_t checksum, uint16_t oldValue, uint16_t newValue)
+{
+	// HC' = ~(~HC + ~m + m')
+	uint32_t sum = (uint32_t)(uint16_t)~checksum + (uint16_t)~oldValue + newValue;
+	return (uint16_t)~foldChecksumSum(sum);
+}
+
+uint16_t update_checksum32(uint16_t checksum, uint32_t oldValue, uint32_t newValue)
+{
+	uint32_t sum = (uint32_t)(uint16_t)~checksum
+			+ (uint16_t)~(oldValue >> 16) + (uint16_t)~(oldValue & 0xffff)
+			+ (newValue >> 16) + (newValue & 0xffff);
+	return (uint16_t)~foldChecksumSum(sum);
+}
 
-	LOG_DEBUG("Calculated checksum = %d, 0x%4X", sum, sum);
+uint16_t update_checksum(uint16_t checksum, const uint8_t* oldData, const uint8_t* newData, size_t len)
+{
+	uint64_t sum = (uint16_t)~checksum;
+	for (size_t i = 0; i + 1 < len; i += 2)
+	{
+		uint16_t oldWord, newWord;
+		memcpy(&oldWord, oldData + i, sizeof(oldWord));
+		memcpy(&newWord, newData + i, sizeof(newWord));
+		sum += (uint16_t)~oldWord;
+		sum += newWord;
+	}
 
-	return ((uint16_t) sum);
+	return (uint16_t)~foldChecksumSum(sum);
 }
 
 
@@ -1,11 +1,345 @@
 #include "Logger.h"
+#include "PlatformSpecificUtils.h"
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#ifdef _MSC_VER
+#include <windows.h>
+#define PCPP_LOG_MEMORY_BARRIER() MemoryBarrier()
+#else
+#define PCPP_LOG_MEMORY_BARRIER() __sync_synchronize()
+#endif
 
 namespace pcpp
 {
 
-LoggerPP::LoggerPP() : m_ErrorString(NULL), m_ErrorStringLen(0), m_SuppressErrors(false)
+struct AsyncLogMessage
+{
+	bool IsError;
+	char Text[PCPP_ASYNC_LOG_MAX_MESSAGE_LEN];
+};
+
+// A single-producer single-consumer ring of one logging thread. Only the owner thread advances Head and only the writer thread
+// advances Tail, so no locks are needed to queue a message
+struct AsyncLogQueue
+{
+	AsyncLogMessage* Messages;
+	size_t Size;
+	volatile size_t Head;
+	volatile size_t Tail;
+	volatile bool IsOwnerThreadExited;
+	uint64_t NumOfDroppedMessages;
+	AsyncLogQueue* Next;
+};
+
+struct AsyncLogSink
+{
+	pthread_t WriterThread;
+	pthread_key_t QueueKey;
+	// protects QueueList. It's taken by logging threads only once, when their queue is created
+	pthread_mutex_t QueueListMutex;
+	AsyncLogQueue* QueueList;
+	size_t QueueSize;
+	volatile bool StopWriter;
+	uint64_t NumOfDroppedMessagesInFreedQueues;
+};
+
+static void freeAsyncLogQueue(AsyncLogQueue* queue)
+{
+	delete [] queue->Messages;
+	delete queue;
+}
+
+static void onAsyncLogThreadExit(void* queue)
+{
+	// the queue may still have messages, so it's freed by the writer thread once it's empty
+	PCPP_LOG_MEMORY_BARRIER();
+	((AsyncLogQueue*)queue)->IsOwnerThreadExited = true;
+}
+
+static AsyncLogQueue* getThreadAsyncLogQueue(AsyncLogSink* sink)
+{
+	AsyncLogQueue* queue = (AsyncLogQueue*)pthread_getspecific(sink->QueueKey);
+	if (queue != NULL)
+		return queue;
+
+	queue = new AsyncLogQueue;
+	queue->Messages = new AsyncLogMessage[sink->QueueSize];
+	queue->Size = sink->QueueSize;
+	queue->Head = 0;
+	queue->Tail = 0;
+	queue->IsOwnerThreadExited = false;
+	queue->NumOfDroppedMessages = 0;
+	pthread_setspecific(sink->QueueKey, queue);
+
+	pthread_mutex_lock(&sink->QueueListMutex);
+	queue->Next = sink->QueueList;
+	sink->QueueList = queue;
+	pthread_mutex_unlock(&sink->QueueListMutex);
+
+	return queue;
+}
+
+// write all queued messages, and free the queues of threads that exited. Returns true if any message was written
+static bool drainAsyncLogQueues(AsyncLogSink* sink)
+{
+	bool wroteMessages = false;
+
+	pthread_mutex_lock(&sink->QueueListMutex);
+
+	AsyncLogQueue** queuePtr = &sink->QueueList;
+	while (*queuePtr != NULL)
+	{
+		AsyncLogQueue* queue = *queuePtr;
+
+		// read the exit flag before the head so no message queued right before the thread exited is missed
+		bool isOwnerThreadExited = queue->IsOwnerThreadExited;
+		PCPP_LOG_MEMORY_BARRIER();
+		size_t head = queue->Head;
+		PCPP_LOG_MEMORY_BARRIER();
+
+		size_t tail = queue->Tail;
+		for (; tail != head; tail++)
+		{
+			AsyncLogMessage& message = queue->Messages[tail % queue->Size];
+			fputs(message.Text, (message.IsError ? stderr : stdout));
+		}
+
+		if (tail != queue->Tail)
+		{
+			wroteMessages = true;
+			// the slots can be reused only after they were written
+			PCPP_LOG_MEMORY_BARRIER();
+			queue->Tail = tail;
+		}
+
+		if (isOwnerThreadExited)
+		{
+			*queuePtr = queue->Next;
+			sink->NumOfDroppedMessagesInFreedQueues += queue->NumOfDroppedMessages;
+			freeAsyncLogQueue(queue);
+		}
+		else
+			queuePtr = &queue->Next;
+	}
+
+	// flush while holding the lock so flushAsyncLog() returns only after the messages reached the output
+	if (wroteMessages)
+	{
+		fflush(stdout);
+		fflush(stderr);
+	}
+
+	pthread_mutex_unlock(&sink->QueueListMutex);
+
+	return wroteMessages;
+}
+
+static void* asyncLogWriterThreadMain(void* ptr)
+{
+	AsyncLogSink* sink = (AsyncLogSink*)ptr;
+
+	while (!sink->StopWriter)
+	{
+		if (!drainAsyncLogQueues(sink))
+			PCAP_MSLEEP(1);
+	}
+
+	// write messages queued until the writer was stopped
+	drainAsyncLogQueues(sink);
+
+	return NULL;
+}
+
+LoggerPP::LoggerPP() : m_ErrorString(NULL), m_ErrorStringLen(0), m_SuppressErrors(false), m_ErrorRateLimit(0), m_NumOfRateLimitedErrors(0), m_AsyncLogSink(NULL)
 {
 	for (int i = 0; i<NumOfLogModules; i++)
 		m_LogModulesArray[i] = Normal;
 }
+
+LoggerPP::~LoggerPP()
+{
+	disableAsyncLogging();
+}
+
+bool LoggerPP::enableAsyncLogging(size_t queueSizePerThread)
+{
+	if (m_AsyncLogSink != NULL)
+		return true;
+
+	if (queueSizePerThread == 0)
+	{
+		LOG_ERROR("Asynchronous log queue size must be greater than zero");
+		return false;
+	}
+
+	AsyncLogSink* sink = new AsyncLogSink;
+	sink->QueueList = NULL;
+	sink->QueueSize = queueSizePerThread;
+	sink->StopWriter = false;
+	sink->NumOfDroppedMessagesInFreedQueues = 0;
+
+	if (pthread_key_create(&sink->QueueKey, onAsyncLogThreadExit) != 0)
+	{
+		LOG_ERROR("Cannot create thread-specific key for asynchronous logging");
+		delete sink;
+		return false;
+	}
+
+	pthread_mutex_init(&sink->QueueListMutex, NULL);
+
+	int err = pthread_create(&sink->WriterThread, NULL, asyncLogWriterThreadMain, sink);
+	if (err != 0)
+	{
+		LOG_ERROR("Cannot create asynchronous log writer thread: [%s]", strerror(err));
+		pthread_mutex_destroy(&sink->QueueListMutex);
+		pthread_key_delete(sink->QueueKey);
+		delete sink;
+		return false;
+	}
+
+	m_AsyncLogSink = sink;
+	return true;
+}
+
+void LoggerPP::disableAsyncLogging()
+{
+	AsyncLogSink* sink = (AsyncLogSink*)m_AsyncLogSink;
+	if (sink == NULL)
+		return;
+
+	// messages logged from now on are written synchronously
+	m_AsyncLogSink = NULL;
+
+	sink->StopWriter = true;
+	pthread_join(sink->WriterThread, NULL);
+
+	while (sink->QueueList != NULL)
+	{
+		AsyncLogQueue* queue = sink->QueueList;
+		sink->QueueList = queue->Next;
+		freeAsyncLogQueue(queue);
+	}
+
+	pthread_key_delete(sink->QueueKey);
+	pthread_mutex_destroy(&sink->QueueListMutex);
+	delete sink;
+}
+
+void LoggerPP::flushAsyncLog()
+{
+	AsyncLogSink* sink = (AsyncLogSink*)m_AsyncLogSink;
+	if (sink == NULL)
+		return;
+
+	while (true)
+	{
+		bool isEmpty = true;
+		pthread_mutex_lock(&sink->QueueListMutex);
+		for (AsyncLogQueue* queue = sink->QueueList; queue != NULL; queue = queue->Next)
+		{
+			if (queue->Head != queue->Tail)
+			{
+				isEmpty = false;
+				break;
+			}
+		}
+		pthread_mutex_unlock(&sink->QueueListMutex);
+
+		if (isEmpty)
+			return;
+
+		PCAP_MSLEEP(1);
+	}
+}
+
+uint64_t LoggerPP::getNumOfDroppedLogMessages() const
+{
+	AsyncLogSink* sink = (AsyncLogSink*)m_AsyncLogSink;
+	if (sink == NULL)
+		return 0;
+
+	pthread_mutex_lock(&sink->QueueListMutex);
+	uint64_t result = sink->NumOfDroppedMessagesInFreedQueues;
+	for (AsyncLogQueue* queue = sink->QueueList; queue != NULL; queue = queue->Next)
+		result += queue->NumOfDroppedMessages;
+	pthread_mutex_unlock(&sink->QueueListMutex);
+
+	return result;
+}
+
+void LoggerPP::writeAsyncLog(bool isError, const char* format, va_list args)
+{
+	AsyncLogQueue* queue = getThreadAsyncLogQueue((AsyncLogSink*)m_AsyncLogSink);
+
+	size_t head = queue->Head;
+	if (head - queue->Tail >= queue->Size)
+	{
+		// never block the logging thread, drop the message instead
+		queue->NumOfDroppedMessages++;
+		return;
+	}
+
+	AsyncLogMessage& message = queue->Messages[head % queue->Size];
+	message.IsError = isError;
+	int len = vsnprintf(message.Text, PCPP_ASYNC_LOG_MAX_MESSAGE_LEN, format, args);
+	if (len >= PCPP_ASYNC_LOG_MAX_MESSAGE_LEN)
+		message.Text[PCPP_ASYNC_LOG_MAX_MESSAGE_LEN - 2] = '\n';
+	else if (len < 0)
+		message.Text[0] = '\0';
+
+	// the message must be visible to the writer thread before the new head
+	PCPP_LOG_MEMORY_BARRIER();
+	queue->Head = head + 1;
+}
+
+void LoggerPP::writeDebugLog(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	if (m_AsyncLogSink != NULL)
+		writeAsyncLog(false, format, args);
+	else
+		vprintf(format, args);
+	va_end(args);
+}
+
+void LoggerPP::writeErrorLog(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	if (m_ErrorString != NULL)
+		vsnprintf(m_ErrorString, m_ErrorStringLen, format, args);
+	else if (m_AsyncLogSink != NULL)
+		writeAsyncLog(true, format, args);
+	else
+		vfprintf(stderr, format, args);
+	va_end(args);
+}
+
+bool LoggerPP::checkErrorRateLimitWindow(LogRateLimitState& state, const char* file, int line)
+{
+	uint32_t now = (uint32_t)time(NULL);
+	if (state.WindowStart != now)
+	{
+		uint32_t numOfSuppressedErrors = state.NumOfSuppressedErrors;
+		state.WindowStart = now;
+		state.NumOfErrorsInWindow = 0;
+		state.NumOfSuppressedErrors = 0;
+
+		if (numOfSuppressedErrors > 0)
+			writeErrorLog("%u errors logged at %s:%d were suppressed by the error rate limit\n", numOfSuppressedErrors, file, line);
+	}
+
+	if (state.NumOfErrorsInWindow < m_ErrorRateLimit)
+	{
+		state.NumOfErrorsInWindow++;
+		return true;
+	}
+
+	state.NumOfSuppressedErrors++;
+	m_NumOfRateLimitedErrors++;
+	return false;
+}
+
 } // namespace pcpp
@@ -4,6 +4,7 @@
 #include <unistd.h>
 #endif
 #include <stdio.h>
+#include <stdlib.h>
 #include <iostream>
 #include <signal.h>
 #include <string.h>
@@ -147,6 +148,10 @@ CoreMask createCoreMaskFromCoreIds(std::vector<int> coreIds)
 	CoreMask result = 0;
 	for (std::vector<int>::iterator iter = coreIds.begin(); iter != coreIds.end(); iter++)
 	{
+		// cores that don't fit in a core mask are ignored
+		if (*iter < 0 || *iter >= MAX_NUM_OF_CORES)
+			continue;
+
 		result |= SystemCores::IdToSystemCore[*iter].Mask;
 	}
 
@@ -168,6 +173,316 @@ void createCoreVectorFromCoreMask(CoreMask coreMask, std::vector<SystemCore>& re
 	}
 }
 
+SystemCore getSystemCoreById(int coreId)
+{
+	if (coreId >= 0 && coreId < MAX_NUM_OF_CORES)
+		return SystemCores::IdToSystemCore[coreId];
+
+	SystemCore core = { 0, (uint16_t)coreId };
+	return core;
+}
+
+
+#define CORE_SET_NUM_OF_WORDS (MAX_NUM_OF_CORES_IN_CORE_SET / 64)
+
+CoreSet::CoreSet()
+{
+	clear();
+}
+
+CoreSet::CoreSet(CoreMask coreMask)
+{
+	clear();
+	m_Bits[0] = coreMask;
+}
+
+CoreSet::CoreSet(const std::vector<int>& coreIds)
+{
+	clear();
+	for (std::vector<int>::const_iterator iter = coreIds.begin(); iter != coreIds.end(); iter++)
+		addCore(*iter);
+}
+
+bool CoreSet::addCore(int coreId)
+{
+	if (coreId < 0 || coreId >= MAX_NUM_OF_CORES_IN_CORE_SET)
+		return false;
+
+	m_Bits[coreId / 64] |= ((uint64_t)1 << (coreId % 64));
+	return true;
+}
+
+void CoreSet::removeCore(int coreId)
+{
+	if (coreId < 0 || coreId >= MAX_NUM_OF_CORES_IN_CORE_SET)
+		return;
+
+	m_Bits[coreId / 64] &= ~((uint64_t)1 << (coreId % 64));
+}
+
+bool CoreSet::containsCore(int coreId) const
+{
+	if (coreId < 0 || coreId >= MAX_NUM_OF_CORES_IN_CORE_SET)
+		return false;
+
+	return ((m_Bits[coreId / 64] >> (coreId % 64)) & 1) != 0;
+}
+
+int CoreSet::getCoreCount() const
+{
+	int count = 0;
+	for (int i = 0; i < CORE_SET_NUM_OF_WORDS; i++)
+	{
+		// clear the lowest set bit until the word is empty
+		for (uint64_t word = m_Bits[i]; word != 0; word &= (word - 1))
+			count++;
+	}
+
+	return count;
+}
+
+bool CoreSet::isEmpty() const
+{
+	for (int i = 0; i < CORE_SET_NUM_OF_WORDS; i++)
+	{
+		if (m_Bits[i] != 0)
+			return false;
+	}
+
+	return true;
+}
+
+void CoreSet::clear()
+{
+	memset(m_Bits, 0, sizeof(m_Bits));
+}
+
+int CoreSet::getFirstCore() const
+{
+	return getNextCore(-1);
+}
+
+int CoreSet::getNextCore(int coreId) const
+{
+	int curCore = (coreId < 0 ? 0 : coreId + 1);
+	while (curCore < MAX_NUM_OF_CORES_IN_CORE_SET)
+	{
+		uint64_t word = m_Bits[curCore / 64] >> (curCore % 64);
+		if (word == 0)
+		{
+			// skip to the next word
+			curCore = (curCore / 64 + 1) * 64;
+			continue;
+		}
+
+		while ((word & 1) == 0)
+		{
+			word >>= 1;
+			curCore++;
+		}
+
+		return curCore;
+	}
+
+	return -1;
+}
+
+void CoreSet::getCoreIds(std::vector<int>& coreIds) const
+{
+	for (int coreId = getFirstCore(); coreId >= 0; coreId = getNextCore(coreId))
+		coreIds.push_back(coreId);
+}
+
+CoreMask CoreSet::toCoreMask() const
+{
+	return (CoreMask)(m_Bits[0] & 0xffffffff);
+}
+
+std::string CoreSet::toString() const
+{
+	std::string result;
+	int coreId = getFirstCore();
+	while (coreId >= 0)
+	{
+		// find the end of the range starting at this core
+		int rangeEnd = coreId;
+		int nextCore = getNextCore(coreId);
+		while (nextCore == rangeEnd + 1)
+		{
+			rangeEnd = nextCore;
+			nextCore = getNextCore(nextCore);
+		}
+
+		char range[16];
+		if (rangeEnd == coreId)
+			snprintf(range, sizeof(range), "%d", coreId);
+		else
+			snprintf(range, sizeof(range), "%d-%d", coreId, rangeEnd);
+
+		if (!result.empty())
+			result += ",";
+		result += range;
+
+		coreId = nextCore;
+	}
+
+	return result;
+}
+
+static bool parseCoreId(const std::string& str, int& coreId)
+{
+	if (str.empty() || str.size() > 5 || str.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+
+	coreId = atoi(str.c_str());
+	return coreId < MAX_NUM_OF_CORES_IN_CORE_SET;
+}
+
+bool CoreSet::fromString(const std::string& coreList)
+{
+	clear();
+
+	std::string list;
+	for (std::string::const_iterator iter = coreList.begin(); iter != coreList.end(); iter++)
+	{
+		if (*iter != ' ' && *iter != '\t' && *iter != '\n' && *iter != '\r')
+			list += *iter;
+	}
+
+	if (list.empty())
+		return true;
+
+	size_t itemStart = 0;
+	while (itemStart <= list.size())
+	{
+		size_t itemEnd = list.find(',', itemStart);
+		if (itemEnd == std::string::npos)
+			itemEnd = list.size();
+
+		std::string item = list.substr(itemStart, itemEnd - itemStart);
+		size_t dashPos = item.find('-');
+		int firstCore, lastCore;
+		bool isValid = false;
+		if (dashPos == std::string::npos)
+		{
+			isValid = parseCoreId(item, firstCore);
+			lastCore = firstCore;
+		}
+		else
+		{
+			isValid = parseCoreId(item.substr(0, dashPos), firstCore) && parseCoreId(item.substr(dashPos + 1), lastCore) && firstCore <= lastCore;
+		}
+
+		if (!isValid)
+		{
+			clear();
+			return false;
+		}
+
+		for (int coreId = firstCore; coreId <= lastCore; coreId++)
+			addCore(coreId);
+
+		itemStart = itemEnd + 1;
+	}
+
+	return true;
+}
+
+CoreSet& CoreSet::operator|=(const CoreSet& other)
+{
+	for (int i = 0; i < CORE_SET_NUM_OF_WORDS; i++)
+		m_Bits[i] |= other.m_Bits[i];
+
+	return *this;
+}
+
+CoreSet& CoreSet::operator&=(const CoreSet& other)
+{
+	for (int i = 0; i < CORE_SET_NUM_OF_WORDS; i++)
+		m_Bits[i] &= other.m_Bits[i];
+
+	return *this;
+}
+
+bool CoreSet::operator==(const CoreSet& other) const
+{
+	return memcmp(m_Bits, other.m_Bits, sizeof(m_Bits)) == 0;
+}
+
+CoreSet getCoreSetForAllMachineCores()
+{
+	CoreSet result;
+	int numOfCores = getNumOfCores();
+	for (int i = 0; i < numOfCores; i++)
+		result.addCore(i);
+
+	return result;
+}
+
+#ifdef LINUX
+static bool readSysFsList(const std::string& path, CoreSet& result)
+{
+	FILE* file = fopen(path.c_str(), "r");
+	if (file == NULL)
+		return false;
+
+	char line[4096];
+	bool success = (fgets(line, sizeof(line), file) != NULL && result.fromString(line));
+	fclose(file);
+	return success;
+}
+#endif
+
+int getNumOfNumaNodes()
+{
+#ifdef LINUX
+	// NUMA node IDs are listed in the same format as cores, so a CoreSet can hold them
+	CoreSet onlineNodes;
+	if (readSysFsList("/sys/devices/system/node/online", onlineNodes) && !onlineNodes.isEmpty())
+	{
+		int lastNode = 0;
+		for (int node = onlineNodes.getFirstCore(); node >= 0; node = onlineNodes.getNextCore(node))
+			lastNode = node;
+		return lastNode + 1;
+	}
+#endif
+
+	return 1;
+}
+
+int getNumaNodeOfCore(int coreId)
+{
+	if (coreId < 0 || coreId >= MAX_NUM_OF_CORES_IN_CORE_SET)
+		return -1;
+
+	int numOfNodes = getNumOfNumaNodes();
+	for (int node = 0; node < numOfNodes; node++)
+	{
+		if (getCoreSetForNumaNode(node).containsCore(coreId))
+			return node;
+	}
+
+	return -1;
+}
+
+CoreSet getCoreSetForNumaNode(int numaNode)
+{
+	CoreSet result;
+
+#ifdef LINUX
+	char path[64];
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", numaNode);
+	if (readSysFsList(path, result))
+		return result;
+#endif
+
+	// without NUMA information all cores are considered to be on node 0
+	if (numaNode == 0 && getNumOfNumaNodes() == 1)
+		result = getCoreSetForAllMachineCores();
+
+	return result;
+}
+
 std::string executeShellCommand(const std::string command)
 {
 	FILE* pipe = POPEN(command.c_str(), "r");
@@ -15,17 +15,100 @@
 
 #include <Packet.h>
 #include <DnsLayer.h>
+#include <DnsRecordIterator.h>
+#include <UdpLayer.h>
+#include <TcpLayer.h>
+#include <SSLLayer.h>
+#include <SSLFingerprint.h>
+#include <PacketUtils.h>
+#include <LRUList.h>
 #include <PcapFileDevice.h>
+#include <PcapFilter.h>
 #include <iostream>
 #include <chrono>
 #include <string>
 #include <vector>
 #include <numeric>
+#include <list>
+#include <map>
 
 using namespace pcpp;
 
 size_t count = 0;
 
+// the number of flows kept in the flow cache in the "lru" modes
+#define FLOW_CACHE_SIZE 4096
+
+// the LRU list implementation LRUList replaced, which pairs a std::list with a std::map. Kept here for comparison
+template<typename T>
+class MapLRUList
+{
+public:
+    MapLRUList(size_t maxSize) : m_MaxSize(maxSize) {}
+
+    int put(const T& element, T* deletedValue = NULL)
+    {
+        m_CacheItemsList.push_front(element);
+        std::pair<typename std::map<T, typename std::list<T>::iterator>::iterator, bool> pair =
+            m_CacheItemsMap.insert(std::make_pair(element, m_CacheItemsList.begin()));
+        if (pair.second == false)
+        {
+            m_CacheItemsList.erase(pair.first->second);
+            pair.first->second = m_CacheItemsList.begin();
+        }
+
+        if (m_CacheItemsMap.size() > m_MaxSize)
+        {
+            typename std::list<T>::iterator lruIter = m_CacheItemsList.end();
+            lruIter--;
+            if (deletedValue != NULL)
+                *deletedValue = *lruIter;
+            m_CacheItemsMap.erase(*lruIter);
+            m_CacheItemsList.erase(lruIter);
+            return 1;
+        }
+
+        return 0;
+    }
+
+private:
+    std::list<T> m_CacheItemsList;
+    std::map<T, typename std::list<T>::iterator> m_CacheItemsMap;
+    size_t m_MaxSize;
+};
+
+template<typename LRU>
+void handle_flow_keys(const std::vector<uint32_t>& flowKeys) {
+    LRU flowCache(FLOW_CACHE_SIZE);
+    uint32_t evictedFlow;
+    for (std::vector<uint32_t>::const_iterator iter = flowKeys.begin(); iter != flowKeys.end(); ++iter)
+    {
+        flowCache.put(*iter, &evictedFlow);
+        count++;
+    }
+}
+
+// a filter which exposes only the BPF string of another filter, so it can't be compiled natively and is always matched with
+// libpcap's BPF. Used by the "filter-bpf" mode for comparison
+class BPFOnlyFilter : public GeneralFilter
+{
+public:
+    BPFOnlyFilter(GeneralFilter& filter) : m_Filter(filter) {}
+
+    void parseToString(std::string& result) { m_Filter.parseToString(result); }
+
+private:
+    GeneralFilter& m_Filter;
+};
+
+void handle_filter(GeneralFilter& filter, RawPacketVector& rawPackets) {
+    for (RawPacketVector::VectorIterator iter = rawPackets.begin(); iter != rawPackets.end(); ++iter)
+    {
+        if (filter.matchPacketWithFilter(*iter))
+            count++;
+    }
+}
+
 bool handle_dns(Packet& packet) {
     if (!packet.isPacketOfType(DNS))
     	return true;
@@ -49,6 +132,77 @@ bool handle_dns(Packet& packet) {
     return true;
 }
 
+// same as handle_dns() but the packet is parsed only up to UDP and the DNS records are visited with DnsRecordIterator, so no
+// DnsLayer, DnsQuery or DnsResource objects are created and query names are decoded into a stack buffer
+bool handle_dns_iterator(Packet& packet) {
+    UdpLayer* udpLayer = packet.getLayerOfType<UdpLayer>();
+    if (udpLayer == NULL ||
+        (!DnsLayer::isDnsPort(be16toh(udpLayer->getUdpHeader()->portSrc)) && !DnsLayer::isDnsPort(be16toh(udpLayer->getUdpHeader()->portDst))))
+        return true;
+
+    DnsRecordIterator iter(udpLayer->getLayerPayload(), udpLayer->getLayerPayloadSize());
+    DnsRecordView record;
+    char name[PCPP_DNS_MAX_DECODED_NAME_LEN];
+    while (iter.getNextRecord(record))
+    {
+        if (record.getType() == DnsQueryType)
+        {
+            record.decodeName(name, sizeof(name));
+            count++;
+        }
+        else if (record.getType() == DnsAnswerType)
+            count++;
+    }
+
+    return true;
+}
+
+// visits the cipher-suites and extensions of every client-hello and server-hello the way it's done with the SSL layer
+// objects, i.e the values a JA3/JA3S fingerprint is made of. Used by the "ssl" mode for comparison with the "ja3" modes
+bool handle_ssl(Packet& packet) {
+    SSLHandshakeLayer* handshakeLayer = packet.getLayerOfType<SSLHandshakeLayer>();
+    while (handshakeLayer != NULL)
+    {
+        SSLClientHelloMessage* clientHello = handshakeLayer->getHandshakeMessageOfType<SSLClientHelloMessage>();
+        if (clientHello != NULL)
+        {
+            bool isValid;
+            for (int i = 0; i < clientHello->getCipherSuiteCount(); i++)
+                clientHello->getCipherSuiteID(i, isValid);
+            for (int i = 0; i < clientHello->getExtensionCount(); i++)
+                clientHello->getExtension(i)->getTypeAsInt();
+            count++;
+        }
+
+        SSLServerHelloMessage* serverHello = handshakeLayer->getHandshakeMessageOfType<SSLServerHelloMessage>();
+        if (serverHello != NULL)
+        {
+            bool isValid;
+            serverHello->getCipherSuiteID(isValid);
+            for (int i = 0; i < serverHello->getExtensionCount(); i++)
+                serverHello->getExtension(i)->getTypeAsInt();
+            count++;
+        }
+
+        handshakeLayer = packet.getNextLayerOfType<SSLHandshakeLayer>(handshakeLayer);
+    }
+
+    return true;
+}
+
+// computes the JA3/JA3S fingerprint of a packet parsed only up to TCP, without creating any SSL objects
+bool handle_ja3(Packet& packet) {
+    TcpLayer* tcpLayer = packet.getLayerOfType<TcpLayer>();
+    if (tcpLayer == NULL)
+        return true;
+
+    SSLFingerprint fingerprint;
+    if (fingerprint.computeFromRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayloadSize()))
+        count++;
+
+    return true;
+}
+
 bool handle_packet(Packet& packet) {
     count++;
     return true;
@@ -56,7 +210,7 @@ bool handle_packet(Packet& packet) {
 
 int main(int argc, char *argv[]) { 
     if(argc != 4) {
-        std::cout << "Usage: " << *argv << " <input-file> <dns|packet> <repetitions>\n";
+        std::cout << "Usage: " << *argv << " <input-file> <dns|dns-iterator|ssl|ja3|ja3-batch|packet|packet-reuse|lru|lru-map|filter|filter-bpf> <repetitions>\n";
         return 1;
     }
     std::chrono::high_resolution_clock myClock;
@@ -64,6 +218,45 @@ int main(int argc, char *argv[]) {
     int total_runs = std::stoi(argv[3]);
     size_t total_packets = 0;
     std::vector<std::chrono::high_resolution_clock::duration> durations;
+
+    // the "lru" modes measure only the flow cache, so the flow keys are read from the file once before measuring
+    std::vector<uint32_t> flowKeys;
+    if(input_type == "lru" || input_type == "lru-map") {
+        PcapFileReaderDevice reader(argv[1]);
+        reader.open();
+        RawPacket rawPacket;
+        while (reader.getNextPacket(rawPacket))
+        {
+            Packet packet(&rawPacket, pcpp::TCP);
+            flowKeys.push_back(hash5Tuple(&packet));
+        }
+        reader.close();
+    }
+    // the "filter" modes measure only filter matching, so the packets are read from the file once before measuring.
+    // The filter is "(tcp and dst portrange 1-1023) or (udp and port 53)"
+    RawPacketVector rawPackets;
+    ProtoFilter tcpFilter(TCP), udpFilter(UDP);
+    PortRangeFilter wellKnownPortsFilter(1, 1023, DST);
+    PortFilter dnsPortFilter(53, SRC_OR_DST);
+    std::vector<GeneralFilter*> tcpFilters, udpFilters, orFilters;
+    tcpFilters.push_back(&tcpFilter);
+    tcpFilters.push_back(&wellKnownPortsFilter);
+    udpFilters.push_back(&udpFilter);
+    udpFilters.push_back(&dnsPortFilter);
+    AndFilter tcpAndFilter(tcpFilters), udpAndFilter(udpFilters);
+    orFilters.push_back(&tcpAndFilter);
+    orFilters.push_back(&udpAndFilter);
+    OrFilter filter(orFilters);
+    BPFOnlyFilter bpfFilter(filter);
+    if(input_type == "filter" || input_type == "filter-bpf" || input_type == "ja3-batch") {
+        PcapFileReaderDevice reader(argv[1]);
+        reader.open();
+        reader.getNextPackets(rawPackets);
+        reader.close();
+    }
+    // the "ja3-batch" mode computes the fingerprints of all packets in a single SSLFingerprint::computeBatch() call
+    std::vector<RawPacket*> batch(rawPackets.begin(), rawPackets.end());
+    std::vector<SSLFingerprint> fingerprints(batch.size());
     for(int i = 0; i < total_runs; ++i) {
         count = 0;
         PcapFileReaderDevice reader(argv[1]);
@@ -78,6 +271,66 @@ int main(int argc, char *argv[]) {
             	handle_dns(packet);
             }
         }
+        else if(input_type == "dns-iterator") {
+            start = std::chrono::high_resolution_clock::now();
+            RawPacket rawPacket;
+            while (reader.getNextPacket(rawPacket))
+            {
+                Packet packet(&rawPacket, pcpp::UDP);
+                handle_dns_iterator(packet);
+            }
+        }
+        else if(input_type == "ssl") {
+            start = std::chrono::high_resolution_clock::now();
+            RawPacket rawPacket;
+            while (reader.getNextPacket(rawPacket))
+            {
+                Packet packet(&rawPacket);
+                handle_ssl(packet);
+            }
+        }
+        else if(input_type == "ja3") {
+            start = std::chrono::high_resolution_clock::now();
+            RawPacket rawPacket;
+            while (reader.getNextPacket(rawPacket))
+            {
+                Packet packet(&rawPacket, pcpp::TCP);
+                handle_ja3(packet);
+            }
+        }
+        else if(input_type == "ja3-batch") {
+            start = std::chrono::high_resolution_clock::now();
+            if (!batch.empty())
+                count += SSLFingerprint::computeBatch(&batch[0], batch.size(), &fingerprints[0]);
+        }
+        else if(input_type == "lru") {
+            start = std::chrono::high_resolution_clock::now();
+            handle_flow_keys<LRUList<uint32_t> >(flowKeys);
+        }
+        else if(input_type == "lru-map") {
+            start = std::chrono::high_resolution_clock::now();
+            handle_flow_keys<MapLRUList<uint32_t> >(flowKeys);
+        }
+        else if(input_type == "filter") {
+            start = std::chrono::high_resolution_clock::now();
+            handle_filter(filter, rawPackets);
+        }
+        else if(input_type == "filter-bpf") {
+            start = std::chrono::high_resolution_clock::now();
+            handle_filter(bpfFilter, rawPackets);
+        }
+        else if(input_type == "packet-reuse") {
+            // same as "packet" but a single Packet instance is re-parsed for all packets, so the memory
+            // of its layers is recycled instead of being allocated and freed for every packet
+            start = std::chrono::high_resolution_clock::now();
+            RawPacket rawPacket;
+            Packet packet;
+            while (reader.getNextPacket(rawPacket))
+            {
+                packet.setRawPacket(&rawPacket, false, pcpp::TCP);
+                handle_packet(packet);
+            }
+        }
         else {
             start = std::chrono::high_resolution_clock::now();
             RawPacket rawPacket;
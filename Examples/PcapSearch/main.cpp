@@ -19,6 +19,14 @@
  * There are switches that allows the user to search only in the provided folder (without sub-directories), search user-defined file extensions (sometimes
  * pcap files have an extension which is not '.pcap'), and output or not output the detailed report
  *
+ * Large pcap files can be searched by several threads in parallel (see the -t switch). The file is indexed, split into chunks and each
+ * thread searches its own chunk. The index can be saved next to the file so following searches don't have to rebuild it (see the -i switch)
+ *
+ * Packets can also be searched by their payload content (see the -p and -f switches), for example to scan capture archives for a list of
+ * indicators of compromise. All patterns are matched in a single pass over each payload using PayloadMatcher, and can be combined with a BPF
+ * search criteria. By default each packet payload is matched on its own, and with the -a switch TCP payloads are reassembled so patterns
+ * which are split between segments are found too
+ *
  * For more details about modes of operation and parameters please run PcapSearch -h
  */
 
@@ -36,6 +44,9 @@
 #include <RawPacket.h>
 #include <Packet.h>
 #include <PcapFileDevice.h>
+#include <ParallelPcapFileReader.h>
+#include <PayloadMatcher.h>
+#include <TcpReassembly.h>
 #include <getopt.h>
 
 
@@ -48,6 +59,12 @@ static struct option PcapSearchOptions[] =
 	{"search", required_argument, 0, 's'},
 	{"detailed-report", required_argument, 0, 'r'},
 	{"set-extensions", required_argument, 0, 'e'},
+	{"threads", required_argument, 0, 't'},
+	{"save-index", no_argument, 0, 'i'},
+	{"pattern", required_argument, 0, 'p'},
+	{"patterns-file", required_argument, 0, 'f'},
+	{"ignore-case", no_argument, 0, 'c'},
+	{"reassemble", no_argument, 0, 'a'},
 	{"version", no_argument, 0, 'v'},
 	{"help", no_argument, 0, 'h'},
     {0, 0, 0, 0}
@@ -79,14 +96,24 @@ void printUsage()
 {
 	printf("\nUsage:\n"
 			"-------\n"
-			"%s [-h] [-v] [-n] [-r file_name] [-e extension_list] -d directory -s search_criteria\n"
+			"%s [-h] [-v] [-n] [-i] [-c] [-a] [-r file_name] [-e extension_list] [-t num_of_threads] [-p pattern] [-f patterns_file] -d directory [-s search_criteria]\n"
 			"\nOptions:\n\n"
 			"    -d directory        : Input directory\n"
 			"    -n                  : Don't include sub-directories (default is include them)\n"
 			"    -s search_criteria  : Criteria to search in Berkeley Packet Filter (BPF) syntax (http://biot.com/capstats/bpf.html) i.e: 'ip net 1.1.1.1'\n"
+			"    -p pattern          : Search packets whose payload contains this string. Can be used several times, a packet matches if it\n"
+			"                          contains any of the patterns. If a search criteria is also given, packets must match both\n"
+			"    -f patterns_file    : Read payload patterns from a file, one pattern per line (empty lines are ignored)\n"
+			"    -c                  : Match payload patterns case-insensitively\n"
+			"    -a                  : Reassemble TCP streams before matching payload patterns, so patterns split between segments are found. Missing TCP data is skipped.\n"
+			"                          A packet is counted if a pattern match ends in its payload. Files are searched with a single thread\n"
 			"    -r file_name        : Write a detailed search report to a file\n"
 			"    -e extension_list   : Set file extensions to search. The default is searching '.pcap' and '.pcapng' files.\n"
 			"                          extnesions_list should be a comma-separated list of extensions, for example: pcap,net,dmp\n"
+			"    -t num_of_threads   : Search each pcap file with this number of threads. The default is 1. Applies only to classic pcap files\n"
+			"                          (not pcapng) and only on platforms that support memory-mapped files\n"
+			"    -i                  : When searching with more than 1 thread, save the index built for each pcap file next to it\n"
+			"                          (with a '.pcppidx' extension) so following searches of the same file start faster\n"
 			"    -v                  : Displays the current version and exists\n"
 			"    -h                  : Displays this help message and exits\n", AppName::get().c_str());
 	exit(0);
@@ -114,13 +141,159 @@ std::string getExtension(std::string fileName)
 }
 
 
+/**
+ * Writes a packet that matched the search criteria to the detailed report file
+ */
+void writePacketToReport(Packet& packet, void* detailedReportFile)
+{
+	std::ofstream* reportFile = (std::ofstream*)detailedReportFile;
+
+	// print layer by layer by layer as we want to add a few spaces before each layer
+	std::vector<std::string> packetLayers;
+	packet.toStringList(packetLayers);
+	for (std::vector<std::string>::iterator iter = packetLayers.begin(); iter != packetLayers.end(); iter++)
+		(*reportFile) << "\n    " << (*iter);
+	(*reportFile) << std::endl;
+}
+
+
+/**
+ * The data shared by the workers of the parallel search
+ */
+struct ParallelSearchData
+{
+	const PayloadMatcher* payloadMatcher;
+	std::vector<int> packetsFoundPerWorker;
+};
+
+
+/**
+ * A worker callback of the parallel search. Packets reaching it already matched the search criteria, so only the payload patterns (if any)
+ * are left to match. The matcher is read-only during the search so all workers share it
+ */
+bool onPacketParallel(Packet& packet, int workerId, void* cookie)
+{
+	ParallelSearchData* data = (ParallelSearchData*)cookie;
+
+	if (data->payloadMatcher != NULL && !data->payloadMatcher->matchPacket(packet))
+		return false;
+
+	data->packetsFoundPerWorker[workerId]++;
+	return true;
+}
+
+
+/**
+ * The data of a search that matches payload patterns over reassembled TCP streams
+ */
+struct TcpStreamSearchData
+{
+	TcpStreamMatcher* streamMatcher;
+	bool curPacketMatched;
+};
+
+
+/**
+ * Called by TcpReassembly when new data of a TCP stream is ready. Matches the payload patterns over it
+ */
+void onTcpMessageReady(int side, const TcpStreamData& tcpData, void* userCookie)
+{
+	TcpStreamSearchData* data = (TcpStreamSearchData*)userCookie;
+
+	if (data->streamMatcher->findMatches(side, tcpData) > 0)
+		data->curPacketMatched = true;
+}
+
+
+/**
+ * Called by TcpReassembly when a TCP connection ends. Frees the matching state of the connection
+ */
+void onTcpConnectionEnd(const ConnectionData& connectionData, TcpReassembly::ConnectionEndReason reason, void* userCookie)
+{
+	((TcpStreamSearchData*)userCookie)->streamMatcher->removeConnection(connectionData.flowKey);
+}
+
+
+/**
+ * Searches all packets in a given classic pcap file using several threads. Returns how many packets matched the search criteria
+ */
+int searchPcapParallel(std::string pcapFilePath, std::string searchCriteria, const PayloadMatcher* payloadMatcher, std::ofstream* detailedReportFile,
+		int numOfThreads, bool saveIndex)
+{
+	ParallelPcapFileReader reader(pcapFilePath, numOfThreads);
+
+	// if the reader fails to open or index the file
+	if (!reader.open(saveIndex))
+	{
+		if (detailedReportFile != NULL)
+		{
+			(*detailedReportFile) << "File '" << pcapFilePath << "':" << std::endl;
+			(*detailedReportFile) << "    ";
+			std::string errorStr = errorString;
+			(*detailedReportFile) << errorStr << std::endl;
+		}
+
+		return 0;
+	}
+
+	// the filter is compiled once and run by all threads
+	if (searchCriteria != "" && !reader.setFilter(searchCriteria))
+		return 0;
+
+	ParallelSearchData searchData;
+	searchData.payloadMatcher = payloadMatcher;
+	searchData.packetsFoundPerWorker.resize(reader.getNumOfWorkers(), 0);
+
+	if (detailedReportFile != NULL)
+	{
+		(*detailedReportFile) << "File '" << pcapFilePath << "':" << std::endl;
+
+		// threads filter, parse and match the packets while this thread writes them to the report in their original order
+		reader.processPacketsOrdered(onPacketParallel, &searchData, writePacketToReport, detailedReportFile);
+	}
+	else
+	{
+		// only counting is needed so the order in which packets are found doesn't matter
+		reader.processPackets(onPacketParallel, &searchData);
+	}
+
+	int packetCount = 0;
+	for (std::vector<int>::iterator iter = searchData.packetsFoundPerWorker.begin(); iter != searchData.packetsFoundPerWorker.end(); iter++)
+		packetCount += *iter;
+
+	reader.close();
+
+	// finalize the report
+	if (detailedReportFile != NULL)
+	{
+		if (packetCount > 0)
+			(*detailedReportFile) << "\n";
+
+		(*detailedReportFile) << "    ----> Found " << packetCount << " packets" << std::endl << std::endl;
+	}
+
+	return packetCount;
+}
+
+
 /**
  * Searches all packet in a given pcap file for a certain search criteria. Returns how many packets matched the seatch criteria
  */
-int searchPcap(std::string pcapFilePath, std::string searchCriteria, std::ofstream* detailedReportFile)
+int searchPcap(std::string pcapFilePath, std::string searchCriteria, const PayloadMatcher* payloadMatcher, bool reassembleTcp,
+		std::ofstream* detailedReportFile, int numOfThreads, bool saveIndex)
 {
-	// create the pcap/pcap-ng reader
-	IFileReaderDevice* reader = IFileReaderDevice::getReader(pcapFilePath.c_str());
+	// classic pcap files which can be memory-mapped can be searched in parallel. TCP streams span the chunks of all threads so they
+	// can only be reassembled by a single thread
+	bool searchInParallel = (numOfThreads > 1 && !reassembleTcp);
+
+	// create the pcap/pcap-ng reader. The memory-mapped reader is requested only to find out whether the file can be searched in parallel
+	IFileReaderDevice* reader = IFileReaderDevice::getReader(pcapFilePath.c_str(), searchInParallel);
+
+	if (searchInParallel && dynamic_cast<MmapPcapFileReaderDevice*>(reader) != NULL)
+	{
+		delete reader;
+		return searchPcapParallel(pcapFilePath, searchCriteria, payloadMatcher, detailedReportFile, numOfThreads, saveIndex);
+	}
 
 	// if the reader fails to open
 	if (!reader->open())
@@ -141,7 +314,7 @@ int searchPcap(std::string pcapFilePath, std::string searchCriteria, std::ofstre
 	}
 
 	// set the filter for the file so only packets that match the search criteria will be read
-	if (!reader->setFilter(searchCriteria))
+	if (searchCriteria != "" && !reader->setFilter(searchCriteria))
 	{
 		// free the reader memory and return
 		delete reader;
@@ -156,27 +329,64 @@ int searchPcap(std::string pcapFilePath, std::string searchCriteria, std::ofstre
 	int packetCount = 0;
 	RawPacket rawPacket;
 
+	// when matching over reassembled TCP streams the matching state of each connection is kept between its packets
+	TcpStreamMatcher* streamMatcher = NULL;
+	TcpReassembly* tcpReassembly = NULL;
+	TcpStreamSearchData streamSearchData;
+	if (payloadMatcher != NULL && reassembleTcp)
+	{
+		streamMatcher = new TcpStreamMatcher(*payloadMatcher);
+		streamSearchData.streamMatcher = streamMatcher;
+		streamSearchData.curPacketMatched = false;
+		tcpReassembly = new TcpReassembly(onTcpMessageReady, &streamSearchData, NULL, onTcpConnectionEnd);
+	}
+
 	// read packets from the file. Since we already set the filter, only packets that matches the filter will be read
 	while (reader->getNextPacket(rawPacket))
 	{
+		if (payloadMatcher != NULL)
+		{
+			// payload patterns only need the packet to be parsed up to the transport layer, unless it's written to the report
+			Packet parsedPacket(&rawPacket, false, UnknownProtocol, (detailedReportFile != NULL ? OsiModelLayerUnknown : OsiModelTransportLayer));
+
+			bool packetMatched = false;
+			if (tcpReassembly != NULL)
+			{
+				streamSearchData.curPacketMatched = false;
+				if (tcpReassembly->reassemblePacket(parsedPacket) == TcpReassembly::NonTcpPacket)
+					packetMatched = payloadMatcher->matchPacket(parsedPacket);
+				else
+					packetMatched = streamSearchData.curPacketMatched;
+			}
+			else
+				packetMatched = payloadMatcher->matchPacket(parsedPacket);
+
+			if (!packetMatched)
+				continue;
+
+			if (detailedReportFile != NULL)
+				writePacketToReport(parsedPacket, detailedReportFile);
+		}
 		// if a detailed report is required, parse the packet and print it to the report file
-		if (detailedReportFile != NULL)
+		else if (detailedReportFile != NULL)
 		{
 			// parse the packet
 			Packet parsedPacket(&rawPacket);
-
-			// print layer by layer by layer as we want to add a few spaces before each layer
-			std::vector<std::string> packetLayers;
-			parsedPacket.toStringList(packetLayers);
-			for (std::vector<std::string>::iterator iter = packetLayers.begin(); iter != packetLayers.end(); iter++)
-				(*detailedReportFile) << "\n    " << (*iter);
-			(*detailedReportFile) << std::endl;
+			writePacketToReport(parsedPacket, detailedReportFile);
 		}
 
 		// count the packet read
 		packetCount++;
 	}
 
+	if (tcpReassembly != NULL)
+	{
+		// data which is still buffered can't be attributed to any packet, closing the connections only frees their state
+		tcpReassembly->closeAllConnections();
+		delete tcpReassembly;
+		delete streamMatcher;
+	}
+
 	// close the reader file
 	reader->close();
 
@@ -202,8 +412,9 @@ int searchPcap(std::string pcapFilePath, std::string searchCriteria, std::ofstre
  * Searches all pcap files in given directory (and sub-directories if directed by the user) and output how many packets in each file matches a given
  * search criteria. This method outputs how many directories were searched, how many files were searched and how many packets were matched
  */
-void searchtDirectories(std::string directory, bool includeSubDirectories, std::string searchCriteria, std::ofstream* detailedReportFile,
-		std::map<std::string, bool> extensionsToSearch,
+void searchtDirectories(std::string directory, bool includeSubDirectories, std::string searchCriteria, const PayloadMatcher* payloadMatcher,
+		bool reassembleTcp, std::ofstream* detailedReportFile,
+		std::map<std::string, bool> extensionsToSearch, int numOfThreads, bool saveIndex,
 		int& totalDirSearched, int& totalFilesSearched, int& totalPacketsFound)
 {
     // open the directory
@@ -259,7 +470,7 @@ void searchtDirectories(std::string directory, bool includeSubDirectories, std::
     	// if we got to here it means the file is actually a directory. If required to search sub-directories, call this method recursively to search
     	// inside this sub-directory
         if (includeSubDirectories)
-        	searchtDirectories(dirPath, true, searchCriteria, detailedReportFile, extensionsToSearch, totalDirSearched, totalFilesSearched, totalPacketsFound);
+        	searchtDirectories(dirPath, true, searchCriteria, payloadMatcher, reassembleTcp, detailedReportFile, extensionsToSearch, numOfThreads, saveIndex, totalDirSearched, totalFilesSearched, totalPacketsFound);
 
         // move to the next file
         entry = readdir(dir);
@@ -275,7 +486,7 @@ void searchtDirectories(std::string directory, bool includeSubDirectories, std::
     for (std::vector<std::string>::iterator iter = pcapList.begin(); iter != pcapList.end(); iter++)
     {
     	// do the actual search
-    	int packetsFound = searchPcap(*iter, searchCriteria, detailedReportFile);
+    	int packetsFound = searchPcap(*iter, searchCriteria, payloadMatcher, reassembleTcp, detailedReportFile, numOfThreads, saveIndex);
 
     	// add to total matched packets
     	totalFilesSearched++;
@@ -307,6 +518,16 @@ int main(int argc, char* argv[])
 
 	std::map<std::string, bool> extensionsToSearch;
 
+	int numOfThreads = 1;
+
+	bool saveIndex = false;
+
+	std::vector<std::string> payloadPatterns;
+
+	bool ignoreCase = false;
+
+	bool reassembleTcp = false;
+
 	// the default (unless set otherwise) is to search in '.pcap' and '.pcapng' extensions
 	extensionsToSearch["pcap"] = true;
 	extensionsToSearch["pcapng"] = true;
@@ -314,7 +535,7 @@ int main(int argc, char* argv[])
 	int optionIndex = 0;
 	char opt = 0;
 
-	while((opt = getopt_long (argc, argv, "d:s:r:e:hvn", PcapSearchOptions, &optionIndex)) != -1)
+	while((opt = getopt_long (argc, argv, "d:s:r:e:t:p:f:cahvni", PcapSearchOptions, &optionIndex)) != -1)
 	{
 		switch (opt)
 		{
@@ -354,6 +575,49 @@ int main(int argc, char* argv[])
 				}
 				break;
 			}
+			case 't':
+				numOfThreads = atoi(optarg);
+				if (numOfThreads < 1)
+				{
+					EXIT_WITH_ERROR("Number of threads must be a positive number");
+				}
+				break;
+			case 'i':
+				saveIndex = true;
+				break;
+			case 'p':
+				if (optarg[0] == '\0')
+				{
+					EXIT_WITH_ERROR("Payload pattern cannot be empty");
+				}
+				payloadPatterns.push_back(optarg);
+				break;
+			case 'f':
+			{
+				std::ifstream patternsFile(optarg);
+				if (!patternsFile.is_open())
+				{
+					EXIT_WITH_ERROR("Couldn't open patterns file '%s'", optarg);
+				}
+
+				std::string pattern;
+				while (std::getline(patternsFile, pattern))
+				{
+					// remove the carriage return of files with Windows line endings
+					if (!pattern.empty() && pattern[pattern.length() - 1] == '\r')
+						pattern.erase(pattern.length() - 1);
+
+					if (!pattern.empty())
+						payloadPatterns.push_back(pattern);
+				}
+				break;
+			}
+			case 'c':
+				ignoreCase = true;
+				break;
+			case 'a':
+				reassembleTcp = true;
+				break;
 			case 'h':
 				printUsage();
 				break;
@@ -371,9 +635,9 @@ int main(int argc, char* argv[])
 		EXIT_WITH_ERROR("Input directory was not given");
 	}
 
-	if (searchCriteria == "")
+	if (searchCriteria == "" && payloadPatterns.empty())
 	{
-		EXIT_WITH_ERROR("Search criteria was not given");
+		EXIT_WITH_ERROR("Neither search criteria nor payload patterns were given");
 	}
 
 	DIR *dir = opendir(inputDirectory.c_str());
@@ -384,11 +648,25 @@ int main(int argc, char* argv[])
 
 	// verify the search criteria is a valid BPF filter
 	BPFStringFilter filter(searchCriteria);
-	if(!filter.verifyFilter())
+	if(searchCriteria != "" && !filter.verifyFilter())
 	{
 		EXIT_WITH_ERROR("Search criteria isn't valid");
 	}
 
+	// compile all payload patterns into a single matcher
+	PayloadMatcher* payloadMatcher = NULL;
+	if (!payloadPatterns.empty())
+	{
+		payloadMatcher = new PayloadMatcher(ignoreCase);
+		for (std::vector<std::string>::iterator iter = payloadPatterns.begin(); iter != payloadPatterns.end(); iter++)
+			payloadMatcher->addPattern(*iter);
+
+		if (!payloadMatcher->compile())
+		{
+			EXIT_WITH_ERROR("Couldn't compile payload patterns");
+		}
+	}
+
 	// open the detailed report file if requested by the user
 	std::ofstream* detailedReportFile = NULL;
 	if (detailedReportFileName != "")
@@ -412,7 +690,7 @@ int main(int argc, char* argv[])
 	int totalPacketsFound = 0;
 
 	// the main call - start searching!
-	searchtDirectories(inputDirectory, includeSubDirectories, searchCriteria, detailedReportFile, extensionsToSearch, totalDirSearched, totalFilesSearched, totalPacketsFound);
+	searchtDirectories(inputDirectory, includeSubDirectories, searchCriteria, payloadMatcher, reassembleTcp, detailedReportFile, extensionsToSearch, numOfThreads, saveIndex, totalDirSearched, totalFilesSearched, totalPacketsFound);
 
 	// after search is done, close the report file and delete its instance
 	printf("\n\nDone! Searched %d files in %d directories, %d packets were matched to search criteria\n", totalFilesSearched, totalDirSearched, totalPacketsFound);
@@ -425,5 +703,7 @@ int main(int argc, char* argv[])
 		printf("Detailed report written to '%s'\n", detailedReportFileName.c_str());
 	}
 
+	delete payloadMatcher;
+
 	return 0;
 }
@@ -39,6 +39,8 @@
  * - In options 3-5 & 7 all packets which aren't UDP or TCP (hence don't belong to any connection) will be written to
  *   one output file, separate from the other output files (usually file#0)
  * - Works only on files of the pcap (TCPDUMP) format
+ * - Classic pcap files can be read and parsed by several threads (see the -t switch). Packets are still split and written
+ *   in their original order by a single thread, so the output is identical to a single-threaded run
  *
  */
 
@@ -53,6 +55,7 @@
 #include <RawPacket.h>
 #include <Packet.h>
 #include <PcapFileDevice.h>
+#include <ParallelPcapFileReader.h>
 #include "SimpleSplitters.h"
 #include "IPPortSplitters.h"
 #include "ConnectionSplitters.h"
@@ -70,6 +73,7 @@ static struct option PcapSplitterOptions[] =
 	{"method", required_argument, 0, 'm'},
 	{"param", required_argument, 0, 'p'},
 	{"filter", required_argument, 0, 'i'},
+	{"threads", required_argument, 0, 't'},
 	{"help", no_argument, 0, 'h'},
 	{"version", no_argument, 0, 'v'},
 	{0, 0, 0, 0}
@@ -106,7 +110,7 @@ void printUsage()
 {
 	printf("\nUsage:\n"
 			"-------\n"
-			"%s [-h] [-v] [-i filter] -f pcap_file -o output_dir -m split_method [-p split_param]\n"
+			"%s [-h] [-v] [-i filter] [-t num_of_threads] -f pcap_file -o output_dir -m split_method [-p split_param]\n"
 			"\nOptions:\n\n"
 			"    -f pcap_file    : Input pcap file name\n"
 			"    -o output_dir   : The directory where the output files shall be written\n"
@@ -146,6 +150,8 @@ void printUsage()
 			"                      'method = bpf-filter'   => split-param is the BPF filter to match upon\n"
 			"                      'method = round-robin'  => split-param is number of files to round-robin packets between\n"
 			"    -i filter       : Apply a BPF filter, meaning only filtered packets will be counted in the split\n"
+			"    -t num_of_threads : Read, filter and parse the input file with this number of threads. The default is 1.\n"
+			"                      Applies only to pcap files (not pcapng) and only on platforms that support memory-mapped files\n"
 			"    -v              : Displays the current version and exists\n"
 			"    -h              : Displays this help message and exits\n", AppName::get().c_str());
 	exit(0);
@@ -203,6 +209,111 @@ std::string getFileNameWithoutExtension(const std::string& path)
 	return("");
 }
 
+/**
+ * The state of the split which is shared between the packets of the input file
+ */
+struct SplitContext
+{
+	Splitter* splitter;
+	std::string outputPcapFileName;
+	std::string outputFileExtension;
+	bool isReaderPcapng;
+	std::map<int, IFileWriterDevice*> outputFiles;
+	int packetCountSoFar;
+	int numOfFiles;
+	bool writeError;
+};
+
+
+/**
+ * Create the writer of a certain output file number
+ */
+IFileWriterDevice* createWriter(SplitContext& context, Packet& parsedPacket, int fileNum)
+{
+	// get file name from the splitter and add the .pcap extension
+	std::string fileName = context.splitter->getFileName(parsedPacket, context.outputPcapFileName, fileNum) + context.outputFileExtension;
+
+	// if reader is pcapng, create a pcapng writer
+	if (context.isReaderPcapng)
+		return new PcapNgFileWriterDevice(fileName.c_str());
+
+	// if reader is pcap, create a pcap writer
+	return new PcapFileWriterDevice(fileName.c_str(), parsedPacket.getRawPacket()->getLinkLayerType());
+}
+
+
+/**
+ * Split a single packet: find its output file using the splitter, open that file if needed and write the packet to it.
+ * Returns false if the output file couldn't be opened
+ */
+bool splitPacket(SplitContext& context, Packet& parsedPacket)
+{
+	std::vector<int> filesToClose;
+
+	// call the splitter to get the file number to write the current packet to
+	int fileNum = context.splitter->getFileNumber(parsedPacket, filesToClose);
+
+	// if file number is seen for the first time (meaning it's the first packet written to it)
+	if (context.outputFiles.find(fileNum) == context.outputFiles.end())
+	{
+		// create a new IFileWriterDevice for this file and open it
+		context.outputFiles[fileNum] = createWriter(context, parsedPacket, fileNum);
+		if (!context.outputFiles[fileNum]->open())
+			return false;
+
+		context.numOfFiles++;
+	}
+
+	// if file number exists in the map but PcapFileWriterDevice is null it means this file was open once and
+	// then closed. In this case we need to re-open the PcapFileWriterDevice in append mode
+	else if (context.outputFiles[fileNum] == NULL)
+	{
+		// re-create the IFileWriterDevice object and open it in __append__ mode
+		context.outputFiles[fileNum] = createWriter(context, parsedPacket, fileNum);
+		if (!context.outputFiles[fileNum]->open(true))
+			return false;
+	}
+
+	// write the packet to the writer
+	context.outputFiles[fileNum]->writePacket(*parsedPacket.getRawPacket());
+
+	// if splitter wants us to close files - go over the file numbers and close them
+	for (std::vector<int>::iterator it = filesToClose.begin(); it != filesToClose.end(); it++)
+	{
+		// check if that file number is in the map
+		if (context.outputFiles.find(*it) != context.outputFiles.end())
+		{
+			// close the writer
+			context.outputFiles[*it]->close();
+
+			// free the writer memory and put null in the map record
+			delete context.outputFiles[*it];
+			context.outputFiles[*it] = NULL;
+		}
+	}
+
+	context.packetCountSoFar++;
+	return true;
+}
+
+
+/**
+ * Called by the parallel reader for each packet in the original order of the file. The packet was already filtered and
+ * parsed by one of the reader threads
+ */
+void onOrderedPacket(Packet& parsedPacket, void* cookie)
+{
+	SplitContext* context = (SplitContext*)cookie;
+
+	// stop writing after the first error, like the single-threaded loop does
+	if (context->writeError)
+		return;
+
+	if (!splitPacket(*context, parsedPacket))
+		context->writeError = true;
+}
+
+
 /**
  * main method of this utility
  */
@@ -222,10 +333,12 @@ int main(int argc, char* argv[])
 
 	bool paramWasSet = false;
 
+	int numOfThreads = 1;
+
 	int optionIndex = 0;
 	char opt = 0;
 
-	while((opt = getopt_long (argc, argv, "f:o:m:p:i:vh", PcapSplitterOptions, &optionIndex)) != -1)
+	while((opt = getopt_long (argc, argv, "f:o:m:p:i:t:vh", PcapSplitterOptions, &optionIndex)) != -1)
 	{
 		switch (opt)
 		{
@@ -247,6 +360,13 @@ int main(int argc, char* argv[])
 			case 'i':
 				filter = optarg;
 				break;
+			case 't':
+				numOfThreads = atoi(optarg);
+				if (numOfThreads < 1)
+				{
+					EXIT_WITH_ERROR("Number of threads must be a positive number");
+				}
+				break;
 			case 'h':
 				printUsage();
 				break;
@@ -342,125 +462,93 @@ int main(int argc, char* argv[])
 	std::string outputPcapFileName = outputPcapDir + std::string(1, SEPARATOR) + getFileNameWithoutExtension(inputPcapFileName) + "-";
 
 	// open a pcap file for reading
-	IFileReaderDevice* reader = IFileReaderDevice::getReader(inputPcapFileName.c_str());
+	IFileReaderDevice* reader = IFileReaderDevice::getReader(inputPcapFileName.c_str(), numOfThreads > 1);
 	bool isReaderPcapng = (dynamic_cast<PcapNgFileReaderDevice*>(reader) != NULL);
 
-	if (reader == NULL || !reader->open())
+	// classic pcap files which can be memory-mapped can be read by several threads
+	bool isParallel = (numOfThreads > 1 && dynamic_cast<MmapPcapFileReaderDevice*>(reader) != NULL);
+
+	ParallelPcapFileReader parallelReader(inputPcapFileName, numOfThreads);
+
+	if (isParallel)
 	{
-		EXIT_WITH_ERROR("Error opening input pcap file\n");
-	}
+		delete reader;
+		reader = NULL;
 
-	// set a filter if provided
-	if (filter != "")
+		if (!parallelReader.open())
+		{
+			EXIT_WITH_ERROR("Error opening input pcap file\n");
+		}
+
+		// set a filter if provided. Packets are filtered by the reader threads
+		if (filter != "")
+		{
+			if (!parallelReader.setFilter(filter))
+				EXIT_WITH_ERROR("Couldn't set filter '%s'", filter.c_str());
+		}
+	}
+	else
 	{
-		if (!reader->setFilter(filter))
-			EXIT_WITH_ERROR("Couldn't set filter '%s'", filter.c_str());
+		if (reader == NULL || !reader->open())
+		{
+			EXIT_WITH_ERROR("Error opening input pcap file\n");
+		}
+
+		// set a filter if provided
+		if (filter != "")
+		{
+			if (!reader->setFilter(filter))
+				EXIT_WITH_ERROR("Couldn't set filter '%s'", filter.c_str());
+		}
 	}
 
 	printf("Started...\n");
 
+	SplitContext context;
+	context.splitter = splitter;
+	context.outputPcapFileName = outputPcapFileName;
 	// determine output file extension
-	std::string outputFileExtenison = (isReaderPcapng ? ".pcapng" : ".pcap");
-
-	int packetCountSoFar = 0;
-	int numOfFiles = 0;
-	RawPacket rawPacket;
+	context.outputFileExtension = (isReaderPcapng ? ".pcapng" : ".pcap");
+	context.isReaderPcapng = isReaderPcapng;
+	context.packetCountSoFar = 0;
+	context.numOfFiles = 0;
+	context.writeError = false;
 
-	// prepare a map of file number to IFileWriterDevice
-	std::map<int, IFileWriterDevice*> outputFiles;
-
-	// read all packets from input file, for each packet do:
-	while (reader->getNextPacket(rawPacket))
+	if (isParallel)
 	{
-		// parse the raw packet into a parsed packet
-		Packet parsedPacket(&rawPacket);
-
-		std::vector<int> filesToClose;
+		// reader threads read, filter and parse the packets while this thread splits them in their original order
+		parallelReader.processPacketsOrdered(NULL, NULL, onOrderedPacket, &context);
 
-		// call the splitter to get the file number to write the current packet to
-		int fileNum = splitter->getFileNumber(parsedPacket, filesToClose);
+		// close the reader file
+		parallelReader.close();
+	}
+	else
+	{
+		RawPacket rawPacket;
 
-		// if file number is seen for the first time (meaning it's the first packet written to it)
-		if (outputFiles.find(fileNum) == outputFiles.end())
+		// read all packets from input file, for each packet do:
+		while (reader->getNextPacket(rawPacket))
 		{
-			// get file name from the splitter and add the .pcap extension
-			std::string fileName = splitter->getFileName(parsedPacket, outputPcapFileName, fileNum) + outputFileExtenison;
-
-			// create a new IFileWriterDevice for this file
-			if (isReaderPcapng)
-			{
-				// if reader is pcapng, create a pcapng writer
-				outputFiles[fileNum] = new PcapNgFileWriterDevice(fileName.c_str());
-			}
-			else
-			{
-				// if reader is pcap, create a pcap writer
-				outputFiles[fileNum] = new PcapFileWriterDevice(fileName.c_str(), rawPacket.getLinkLayerType());
-			}
-
-			// open the writer
-			if (!outputFiles[fileNum]->open())
-				break;
+			// parse the raw packet into a parsed packet
+			Packet parsedPacket(&rawPacket);
 
-			numOfFiles++;
-		}
-
-		// if file number exists in the map but PcapFileWriterDevice is null it means this file was open once and
-		// then closed. In this case we need to re-open the PcapFileWriterDevice in append mode
-		else if (outputFiles[fileNum] == NULL)
-		{
-			// get file name from the splitter and add the .pcap extension
-			std::string fileName = splitter->getFileName(parsedPacket, outputPcapFileName, fileNum) + outputFileExtenison;
-
-			// re-create the IFileWriterDevice object
-			if (isReaderPcapng)
-			{
-				// if reader is pcapng, create a pcapng writer
-				outputFiles[fileNum] = new PcapNgFileWriterDevice(fileName.c_str());
-			}
-			else
-			{
-				// if reader is pcap, create a pcap writer
-				outputFiles[fileNum] = new PcapFileWriterDevice(fileName.c_str(), rawPacket.getLinkLayerType());
-			}
-
-			// open the writer in __append__ mode
-			if (!outputFiles[fileNum]->open(true))
+			if (!splitPacket(context, parsedPacket))
 				break;
 		}
 
-		// write the packet to the writer
-		outputFiles[fileNum]->writePacket(*parsedPacket.getRawPacket());
+		// close the reader file
+		reader->close();
 
-		// if splitter wants us to close files - go over the file numbers and close them
-		for (std::vector<int>::iterator it = filesToClose.begin(); it != filesToClose.end(); it++)
-		{
-			// check if that file number is in the map
-			if (outputFiles.find(*it) != outputFiles.end())
-			{
-				// close the writer
-				outputFiles[*it]->close();
-
-				// free the writer memory and put null in the map record
-				delete outputFiles[*it];
-				outputFiles[*it] = NULL;
-			}
-		}
-
-		packetCountSoFar++;
+		// free reader memory
+		delete reader;
 	}
 
-	std::cout << "Finished. Read and written " << packetCountSoFar << " packets to " << numOfFiles << " files" << std::endl;
-
-	// close the reader file
-	reader->close();
+	std::cout << "Finished. Read and written " << context.packetCountSoFar << " packets to " << context.numOfFiles << " files" << std::endl;
 
-	// free reader memory
-	delete reader;
 	delete splitter;
 
 	// close the writer files which are still open
-	for(std::map<int, IFileWriterDevice*>::iterator it = outputFiles.begin(); it != outputFiles.end(); ++it)
+	for(std::map<int, IFileWriterDevice*>::iterator it = context.outputFiles.begin(); it != context.outputFiles.end(); ++it)
 	{
 		if (it->second != NULL)
 		{
@@ -136,5 +136,7 @@ namespace pcpp
 		OsiModelLayer getOsiModelLayer() const { return OsiModelNetworkLayer; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(ArpLayer, ARP, true);
+
 } // namespace pcpp
 #endif /* PACKETPP_ARP_LAYER */
@@ -92,6 +92,15 @@ public:
    */
   static BgpLayer* parseBgpLayer(uint8_t* data, size_t dataLen, Layer* prevLayer, Packet* packet);
 
+  /**
+   * A static method that validates the input data, i.e checks that it's long enough to contain a BGP message header,
+   * that the message length in the header is legal and that the message type is known
+   * @param[in] data A pointer to the raw data
+   * @param[in] dataLen Size of the data in bytes
+   * @return True if the data can be parsed by parseBgpLayer(), false otherwise
+   */
+  static bool isDataValid(const uint8_t* data, size_t dataLen);
+
   // implement abstract methods
 
   /**
@@ -129,6 +138,8 @@ protected:
 
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(BgpLayer, BGP, true);
+
 
 
 /**
@@ -263,6 +274,8 @@ private:
 
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(BgpOpenMessageLayer, BGP, false);
+
 
 
 /**
@@ -456,6 +469,8 @@ private:
 
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(BgpUpdateMessageLayer, BGP, false);
+
 
 
 /**
@@ -568,6 +583,8 @@ private:
 
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(BgpNotificationMessageLayer, BGP, false);
+
 
 
 /**
@@ -610,6 +627,8 @@ public:
 
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(BgpKeepaliveMessageLayer, BGP, false);
+
 
 
 /**
@@ -664,6 +683,8 @@ public:
 
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(BgpRouteRefreshMessageLayer, BGP, false);
+
 }
 
 #endif //PACKETPP_BGP_LAYER
\ No newline at end of file
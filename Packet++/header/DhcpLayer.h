@@ -792,6 +792,8 @@ namespace pcpp
 
 		DhcpOption addOptionAt(const DhcpOptionBuilder& optionBuilder, int offset);
 	};
+
+	PCPP_DECLARE_LAYER_PROTOCOL(DhcpLayer, DHCP, true);
 }
 
 #endif /* PACKETPP_DHCP_LAYER */
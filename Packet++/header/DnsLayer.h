@@ -458,6 +458,8 @@ namespace pcpp
 
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(DnsLayer, DNS, true);
+
 
 	// implementation of inline methods
 
@@ -0,0 +1,203 @@
+#ifndef PACKETPP_DNS_RECORD_ITERATOR
+#define PACKETPP_DNS_RECORD_ITERATOR
+
+#include "DnsLayer.h"
+#include <string>
+#include <stdint.h>
+
+/// @file
+
+/**
+ * The size of a buffer that is always large enough to hold a decoded DNS name, including the terminating '\0'
+ */
+#define PCPP_DNS_MAX_DECODED_NAME_LEN 256
+
+/**
+ * The maximum number of compression pointers followed while walking a single DNS name. Names with more pointers are treated as
+ * malformed (this also stops pointer loops)
+ */
+#define PCPP_DNS_MAX_NAME_POINTERS 20
+
+/**
+ * \namespace pcpp
+ * \brief The main namespace for the PcapPlusPlus lib
+ */
+namespace pcpp
+{
+
+	/**
+	 * @class DnsRecordView
+	 * A lightweight, read-only view of a single DNS record (query, answer, authority or additional record) in raw DNS data. Unlike
+	 * DnsQuery and DnsResource it holds only the record's offset in the data and never allocates memory: the record name isn't decoded
+	 * when the view is created, it is decoded on demand into a buffer supplied by the user with decodeName() or compared in its wire
+	 * format with isNameEqual(). A view is filled by DnsRecordIterator and is valid only as long as the DNS data it points to
+	 */
+	class DnsRecordView
+	{
+		friend class DnsRecordIterator;
+
+	public:
+
+		/**
+		 * A c'tor for this class that creates an empty view. A view is filled by DnsRecordIterator#getNextRecord()
+		 */
+		DnsRecordView() : m_Data(NULL), m_DataLen(0), m_OffsetInLayer(0), m_NameLength(0), m_ResourceType(DnsQueryType) {}
+
+		/**
+		 * @return The type of this record (query, answer, authority, additional)
+		 */
+		DnsResourceType getType() const { return m_ResourceType; }
+
+		/**
+		 * @return The offset of the record (which is also the offset of its name) from the start of the DNS data
+		 */
+		size_t getOffsetInLayer() const { return m_OffsetInLayer; }
+
+		/**
+		 * @return The length of the record name in its wire format, meaning the number of bytes the name takes in this record. If the name
+		 * ends with a compression pointer the bytes it points to aren't counted
+		 */
+		size_t getNameLength() const { return m_NameLength; }
+
+		/**
+		 * @return The DNS type of this record
+		 */
+		DnsType getDnsType() const;
+
+		/**
+		 * @return The DNS class of this record
+		 */
+		DnsClass getDnsClass() const;
+
+		/**
+		 * @return The time-to-leave value of this record or 0 if this record is a query
+		 */
+		uint32_t getTTL() const;
+
+		/**
+		 * @return The data length value of this record (taken from the "data length" field of the record) or 0 if this record is a query
+		 */
+		size_t getDataLength() const;
+
+		/**
+		 * @return A pointer to the record data or NULL if this record is a query. Notice the return value points directly to the DNS data
+		 */
+		const uint8_t* getData() const;
+
+		/**
+		 * @return The offset of the record data from the start of the DNS data or 0 if this record is a query
+		 */
+		size_t getDataOffset() const;
+
+		/**
+		 * @return The total size in bytes of this record
+		 */
+		size_t getSize() const;
+
+		/**
+		 * Decode the record name (following compression pointers if there are any) into a buffer supplied by the user. The decoded name is
+		 * in the same format DnsQuery#getName() and DnsResource#getName() return, e.g 'www.google.com'
+		 * @param[out] result The buffer to write the decoded name to. The name is terminated with '\0'. A buffer of
+		 * PCPP_DNS_MAX_DECODED_NAME_LEN bytes is always large enough
+		 * @param[in] resultLen The size of the buffer in bytes
+		 * @return True if the name was decoded successfully or false if the name is malformed or the buffer is too small
+		 */
+		bool decodeName(char* result, size_t resultLen) const;
+
+		/**
+		 * Compare the record name to a name without decoding it. The name is compared label by label in its wire format (following
+		 * compression pointers if there are any), and the comparison is case-insensitive as DNS names are
+		 * @param[in] name The name to compare to, e.g 'www.google.com'. A single trailing '.' is ignored
+		 * @param[in] nameLen The length of the name to compare to
+		 * @return True if the names are equal, false otherwise or if the record name is malformed
+		 */
+		bool isNameEqual(const char* name, size_t nameLen) const;
+
+		/**
+		 * Compare the record name to a name without decoding it. See isNameEqual(const char*, size_t) const for details
+		 * @param[in] name The name to compare to
+		 * @return True if the names are equal, false otherwise or if the record name is malformed
+		 */
+		bool isNameEqual(const std::string& name) const { return isNameEqual(name.c_str(), name.length()); }
+
+	private:
+		const uint8_t* m_Data;
+		size_t m_DataLen;
+		size_t m_OffsetInLayer;
+		size_t m_NameLength;
+		DnsResourceType m_ResourceType;
+
+		const uint8_t* getFieldsPtr() const { return m_Data + m_OffsetInLayer + m_NameLength; }
+	};
+
+
+	/**
+	 * @class DnsRecordIterator
+	 * An iterator over the records of raw DNS data which doesn't allocate memory. It walks the queries, answers, authorities and
+	 * additional records in the order they appear in the data, according to the record counts in the DNS header, and fills a
+	 * DnsRecordView for each of them. It can work on a DnsLayer, but it can also work directly on the payload of a UDP layer (when the
+	 * packet was parsed only up to the transport layer) which saves creating the DnsLayer and the DnsQuery and DnsResource objects it
+	 * allocates for every record. DNS messages over TCP start with a 2-byte length field, so a TCP payload should be iterated with
+	 * hasTcpLengthPrefix set, which skips the length field and limits the iteration to the message length. For example:
+	 *
+	 * @code
+	 * pcpp::DnsRecordIterator iter(udpLayer->getLayerPayload(), udpLayer->getLayerPayloadSize());
+	 * pcpp::DnsRecordView record;
+	 * char name[PCPP_DNS_MAX_DECODED_NAME_LEN];
+	 * while (iter.getNextRecord(record))
+	 * {
+	 *     if (record.getType() == pcpp::DnsQueryType && record.decodeName(name, sizeof(name)))
+	 *         printf("%s\n", name);
+	 * }
+	 * @endcode
+	 */
+	class DnsRecordIterator
+	{
+	public:
+
+		/**
+		 * A c'tor for this class that iterates over raw DNS data
+		 * @param[in] data A pointer to the DNS data, starting with the DNS header (dnshdr), or with the 2-byte message length if
+		 * hasTcpLengthPrefix is set. The data isn't copied so it must remain valid while the iterator and the views it fills are used
+		 * @param[in] dataLen The length of the DNS data
+		 * @param[in] hasTcpLengthPrefix Set to true if the data is a DNS over TCP message which starts with a 2-byte length field. Record
+		 * offsets and compression pointers are relative to the message after this field. The default is false
+		 */
+		DnsRecordIterator(const uint8_t* data, size_t dataLen, bool hasTcpLengthPrefix = false);
+
+		/**
+		 * A c'tor for this class that iterates over the data of a DNS layer
+		 * @param[in] dnsLayer The DNS layer to iterate over
+		 */
+		explicit DnsRecordIterator(const DnsLayer& dnsLayer);
+
+		/**
+		 * Move to the next record
+		 * @param[out] record The view to fill with the next record
+		 * @return True if the next record was found or false if all records were already visited or the data is malformed (in this
+		 * case isMalformed() returns true)
+		 */
+		bool getNextRecord(DnsRecordView& record);
+
+		/**
+		 * @return True if the iteration stopped because a record exceeded the DNS data or the DNS data is shorter than the DNS header
+		 */
+		bool isMalformed() const { return m_IsMalformed; }
+
+		/**
+		 * Start the iteration over from the first record
+		 */
+		void reset();
+
+	private:
+		const uint8_t* m_Data;
+		size_t m_DataLen;
+		size_t m_NextOffset;
+		uint16_t m_RecordsLeft[4];
+		int m_CurResourceType;
+		bool m_IsMalformed;
+	};
+
+} // namespace pcpp
+
+#endif /* PACKETPP_DNS_RECORD_ITERATOR */
@@ -105,6 +105,8 @@ namespace pcpp
 
 		OsiModelLayer getOsiModelLayer() const { return OsiModelDataLinkLayer; }
 	};
+
+	PCPP_DECLARE_LAYER_PROTOCOL(EthDot3Layer, EthernetDot3, true);
 }
 
 #endif // PACKETPP_ETH_DOT3_LAYER
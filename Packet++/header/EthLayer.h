@@ -146,6 +146,8 @@ namespace pcpp
 		OsiModelLayer getOsiModelLayer() const { return OsiModelDataLinkLayer; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(EthLayer, Ethernet, true);
+
 } // namespace pcpp
 
 #endif /* PACKETPP_ETH_LAYER */
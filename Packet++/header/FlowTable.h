@@ -0,0 +1,884 @@
+#ifndef PACKETPP_FLOW_TABLE
+#define PACKETPP_FLOW_TABLE
+
+#include "Packet.h"
+#include "IpAddress.h"
+#include <vector>
+#include <time.h>
+#include <pthread.h>
+
+/**
+ * @file
+ * This file includes pcpp#FlowTable, a table that tracks the flows (connections) packets belong to and keeps a user-defined state object per
+ * flow, and pcpp#ConcurrentFlowTable, a variant of it that can be shared by multiple threads.<BR>
+ *
+ * The logic works as follows:
+ * - A flow is identified by a pcpp#FlowKey: the IP version, the 2 IP addresses, the 2 TCP/UDP ports and the IP protocol. The key stores the
+ *   2 endpoints in a canonical order so both directions of a flow get the same key, and it remembers which direction it was created in. The
+ *   whole key is compared on lookup, so flows whose keys have the same hash value are never mixed up
+ * - Each flow holds an object of the user type T which is default-constructed when the flow starts, along with the flow start time, the time of
+ *   its last packet and packet and byte counters for each direction. The direction of a packet is relative to the endpoint which sent the first
+ *   packet of the flow (the initiator)
+ * - The table has a fixed capacity determined in the c'tor. All memory, including the state objects of all flows, is allocated in the c'tor,
+ *   so processing packets never allocates memory (unless T does). When a new flow arrives and the table is full, the flow that was least
+ *   recently active is closed to make room for it
+ * - Two timeouts can be set in the c'tor: an idle timeout which closes flows that didn't see packets for that many seconds, and an active
+ *   timeout which closes flows that started that many seconds ago even if they are still active (a later packet of such a flow starts a new
+ *   flow). Time is measured by packet timestamps: the current time of a table is the latest timestamp processed so far, so processing a
+ *   capture file gives the same result regardless of how fast it's processed. Timed out flows are closed when the next packet is processed
+ *   or when pcpp#FlowTable#purgeTimedOutFlows() is called
+ * - Whenever a flow is closed, for any of the reasons above or by the user, the pcpp#FlowTable#OnFlowClosed callback is called with the flow
+ *   and its state, which is then reset to a default-constructed object
+ *
+ * pcpp#FlowTable isn't thread-safe. There are 2 ways of tracking flows in multiple threads:
+ * - Per-thread sharding: each thread has its own pcpp#FlowTable and packets are dispatched to threads by pcpp#fastHash5Tuple(), which gives
+ *   both directions of a flow the same value, so all packets of a flow are handled by the same thread and no locking is needed
+ * - pcpp#ConcurrentFlowTable, which splits the flows into shards by their key hash. Each shard is a pcpp#FlowTable protected by its own lock,
+ *   so threads handling flows of different shards don't block each other
+ */
+
+/**
+ * \namespace pcpp
+ * \brief The main namespace for the PcapPlusPlus lib
+ */
+namespace pcpp
+{
+
+	/**
+	 * @class FlowKey
+	 * The key of a flow in pcpp#FlowTable: the IP version, the 2 IP addresses, the 2 TCP/UDP ports and the IP protocol. Packets of both
+	 * directions of a flow have equal keys, but the key also remembers the direction it was created in (which endpoint is the source)
+	 */
+	class FlowKey
+	{
+	public:
+
+		/**
+		 * A c'tor that creates an invalid key
+		 */
+		FlowKey();
+
+		/**
+		 * A c'tor that creates a key out of its fields
+		 * @param[in] srcIP The source IP address
+		 * @param[in] dstIP The destination IP address. It must be of the same IP version as srcIP, otherwise the key is invalid
+		 * @param[in] srcPort The source port. It's ignored if protocol isn't TCP or UDP
+		 * @param[in] dstPort The destination port. It's ignored if protocol isn't TCP or UDP
+		 * @param[in] protocol The IP protocol, for example PACKETPP_IPPROTO_TCP
+		 */
+		FlowKey(const IPAddress& srcIP, const IPAddress& dstIP, uint16_t srcPort, uint16_t dstPort, uint8_t protocol);
+
+		/**
+		 * Set the key from a parsed packet. The innermost IPv4 or IPv6 layer of the packet is used (the IP header quoted inside an ICMP
+		 * error message is skipped), and if it's followed by a TCP or UDP layer the ports are used as well. Packets which have an IP layer
+		 * but no TCP or UDP layer, such as ICMP packets and IP fragments, get a key with both ports zero. For IPv6 packets the protocol is
+		 * the next header of the last extension header
+		 * @param[in] packet The packet to set the key from
+		 * @return True if the packet has an IPv4 or IPv6 layer, false otherwise. In that case the key is invalid
+		 */
+		bool setFromPacket(Packet* packet);
+
+		/**
+		 * @return True if this is a valid key, meaning it was set from an IPv4 or IPv6 packet or created out of valid fields
+		 */
+		bool isValid() const { return m_IPVersion != 0; }
+
+		/**
+		 * @return The source IP address in the direction the key was created in
+		 */
+		IPAddress getSrcIP() const { return getIP(m_IsReversed ? 1 : 0); }
+
+		/**
+		 * @return The destination IP address in the direction the key was created in
+		 */
+		IPAddress getDstIP() const { return getIP(m_IsReversed ? 0 : 1); }
+
+		/**
+		 * @return The source port in the direction the key was created in, or 0 if the key has no ports
+		 */
+		uint16_t getSrcPort() const { return m_Ports[m_IsReversed ? 1 : 0]; }
+
+		/**
+		 * @return The destination port in the direction the key was created in, or 0 if the key has no ports
+		 */
+		uint16_t getDstPort() const { return m_Ports[m_IsReversed ? 0 : 1]; }
+
+		/**
+		 * @return The IP protocol
+		 */
+		uint8_t getProtocol() const { return m_Protocol; }
+
+		/**
+		 * @return The hash value of the key. Both directions of a flow have the same hash value
+		 */
+		uint32_t getHash() const { return m_Hash; }
+
+		/**
+		 * Check whether this key and an equal key were created in the same direction
+		 * @param[in] other The key to compare to. It's assumed to be equal to this key
+		 * @return True if both keys have the same source endpoint, false otherwise
+		 */
+		bool isSameDirection(const FlowKey& other) const { return m_IsReversed == other.m_IsReversed; }
+
+		/**
+		 * Compare 2 keys regardless of the direction they were created in
+		 * @param[in] other The key to compare to
+		 * @return True if both keys belong to the same flow, false otherwise
+		 */
+		bool operator==(const FlowKey& other) const;
+
+		/**
+		 * Compare 2 keys regardless of the direction they were created in
+		 * @param[in] other The key to compare to
+		 * @return True if the keys belong to different flows, false otherwise
+		 */
+		bool operator!=(const FlowKey& other) const { return !(*this == other); }
+
+	private:
+		// the endpoints in canonical order: the one with the lower address (or the lower port if the addresses are equal) goes first
+		uint8_t m_Addresses[2][16];
+		uint16_t m_Ports[2];
+		uint32_t m_Hash;
+		uint8_t m_IPVersion;
+		uint8_t m_Protocol;
+		// true if the source endpoint is the second one
+		bool m_IsReversed;
+
+		void init(const uint8_t* srcAddr, const uint8_t* dstAddr, uint8_t ipVersion, uint16_t srcPort, uint16_t dstPort, uint8_t protocol);
+		IPAddress getIP(int endpoint) const;
+	};
+
+
+	/**
+	 * The direction of a packet in a flow
+	 */
+	enum FlowDirection
+	{
+		/** The packet was sent by the endpoint which sent the first packet of the flow */
+		FlowDirectionFromInitiator = 0,
+		/** The packet was sent by the other endpoint */
+		FlowDirectionFromResponder = 1
+	};
+
+
+	/**
+	 * The reason a flow was closed
+	 */
+	enum FlowCloseReason
+	{
+		/** The flow didn't see packets for the idle timeout */
+		FlowClosedByIdleTimeout,
+		/** The flow started more than the active timeout ago */
+		FlowClosedByActiveTimeout,
+		/** The table was full when a new flow arrived and this flow was the least recently active one */
+		FlowClosedByEviction,
+		/** The flow was closed by the user */
+		FlowClosedManually
+	};
+
+
+	/**
+	 * @class FlowTable
+	 * A table of flows with a fixed capacity and a user state object of type T per flow. T must be default-constructible and assignable.
+	 * Please read more about the logic in the FlowTable.h file description
+	 */
+	template<typename T>
+	class FlowTable
+	{
+	public:
+
+		/**
+		 * @class Flow
+		 * A flow in the table, holding the user state object and the flow statistics
+		 */
+		class Flow
+		{
+			friend class FlowTable;
+		public:
+
+			/**
+			 * @return The key of the flow, in the direction of the first packet of the flow
+			 */
+			const FlowKey& getKey() const { return m_Key; }
+
+			/**
+			 * @return The time (in seconds) the flow started at, measured by the table clock
+			 */
+			time_t getStartTime() const { return m_StartTime; }
+
+			/**
+			 * @return The time (in seconds) of the last packet of the flow, measured by the table clock
+			 */
+			time_t getLastSeenTime() const { return m_LastSeenTime; }
+
+			/**
+			 * @param[in] direction The direction to get the packet count of
+			 * @return The number of packets seen in this direction
+			 */
+			uint64_t getNumOfPackets(FlowDirection direction) const { return m_NumOfPackets[direction]; }
+
+			/**
+			 * @param[in] direction The direction to get the byte count of
+			 * @return The number of bytes seen in this direction
+			 */
+			uint64_t getNumOfBytes(FlowDirection direction) const { return m_NumOfBytes[direction]; }
+
+			/**
+			 * @return The user state object of the flow
+			 */
+			T& getState() { return m_State; }
+
+			/**
+			 * @return The user state object of the flow
+			 */
+			const T& getState() const { return m_State; }
+
+		private:
+			FlowKey m_Key;
+			time_t m_StartTime;
+			time_t m_LastSeenTime;
+			uint64_t m_NumOfPackets[2];
+			uint64_t m_NumOfBytes[2];
+			T m_State;
+
+			Flow() : m_StartTime(0), m_LastSeenTime(0), m_State() { m_NumOfPackets[0] = m_NumOfPackets[1] = 0; m_NumOfBytes[0] = m_NumOfBytes[1] = 0; }
+		};
+
+		/**
+		 * @typedef OnFlowClosed
+		 * A callback that is called when a flow is closed. The flow is already removed from the table when it's called, and its state is
+		 * reset to a default-constructed object right after the callback returns. The callback must not modify the table
+		 * @param[in] flow The flow being closed
+		 * @param[in] reason The reason the flow is closed
+		 * @param[in] userCookie A pointer to the cookie provided by the user in the c'tor (or NULL if no cookie provided)
+		 */
+		typedef void (*OnFlowClosed)(Flow& flow, FlowCloseReason reason, void* userCookie);
+
+		/**
+		 * @typedef FlowVisitor
+		 * A callback that is called for each flow by forEachFlow(). The callback must not modify the table
+		 * @param[in] flow The flow
+		 * @param[in] userCookie A pointer to the cookie provided by the user in forEachFlow()
+		 */
+		typedef void (*FlowVisitor)(Flow& flow, void* userCookie);
+
+		/**
+		 * A c'tor for this class. It allocates all memory the table uses
+		 * @param[in] maxNumOfFlows The maximum number of flows in the table. Values larger than getMaxSupportedNumOfFlows() are clamped to it
+		 * @param[in] idleTimeout The number of seconds (measured by packet timestamps) a flow may go without packets before it's closed.
+		 * This parameter is optional, default value is 0 which means flows never time out this way
+		 * @param[in] activeTimeout The number of seconds (measured by packet timestamps) after its start a flow is closed even if it's still
+		 * active. This parameter is optional, default value is 0 which means flows never time out this way
+		 * @param[in] onFlowClosed The callback to call when a flow is closed. This parameter is optional, default value is NULL (no callback)
+		 * @param[in] userCookie A pointer to an object provided by the user which is passed to onFlowClosed. This parameter is optional,
+		 * default cookie is NULL
+		 */
+		FlowTable(size_t maxNumOfFlows, uint32_t idleTimeout = 0, uint32_t activeTimeout = 0, OnFlowClosed onFlowClosed = NULL, void* userCookie = NULL)
+			: m_Nodes(clampMaxNumOfFlows(maxNumOfFlows)), m_MaxNumOfFlows(clampMaxNumOfFlows(maxNumOfFlows)), m_NumOfFlows(0), m_IdleTimeout(idleTimeout), m_ActiveTimeout(activeTimeout),
+			  m_CurrentTime(0), m_NumOfEvictedFlows(0), m_NumOfTimedOutFlows(0), m_OnFlowClosed(onFlowClosed), m_UserCookie(userCookie),
+			  m_FreeList(NullIndex)
+		{
+			// all nodes start in the free list
+			for (size_t i = m_MaxNumOfFlows; i > 0; i--)
+			{
+				m_Nodes[i - 1].lruNext = m_FreeList;
+				m_FreeList = (uint32_t)(i - 1);
+			}
+
+			// at least 2 buckets per flow keeps the hash chains short
+			size_t numOfBuckets = 1;
+			while (numOfBuckets < 2 * m_MaxNumOfFlows)
+				numOfBuckets *= 2;
+			m_Buckets.resize(numOfBuckets, (uint32_t)NullIndex);
+		}
+
+		/**
+		 * Find the flow of a packet, or start a new flow if it doesn't exist, and update its statistics. The packet timestamp advances the
+		 * table clock, and flows that timed out are closed before the lookup
+		 * @param[in] packet The packet to process
+		 * @param[out] direction If not NULL, the direction of the packet in the flow is written to it
+		 * @param[out] isNewFlow If not NULL, it's set to true if the packet started a new flow and to false otherwise
+		 * @return The flow of the packet, or NULL if the packet isn't an IPv4 or IPv6 packet or the table capacity is zero
+		 */
+		Flow* processPacket(Packet* packet, FlowDirection* direction = NULL, bool* isNewFlow = NULL)
+		{
+			FlowKey key;
+			if (!key.setFromPacket(packet))
+				return NULL;
+
+			RawPacket* rawPacket = packet->getRawPacketReadOnly();
+			return processFlowPacket(key, rawPacket->getPacketTimeStamp().tv_sec, rawPacket->getFrameLength(), direction, isNewFlow);
+		}
+
+		/**
+		 * Find the flow of a key, or start a new flow if it doesn't exist, and count a packet in it. This is the same as
+		 * processPacket() for callers which extract the key by themselves
+		 * @param[in] key The flow key of the packet
+		 * @param[in] timestamp The packet timestamp in seconds
+		 * @param[in] numOfBytes The packet length to add to the flow byte count
+		 * @param[out] direction If not NULL, the direction of the packet in the flow is written to it
+		 * @param[out] isNewFlow If not NULL, it's set to true if the packet started a new flow and to false otherwise
+		 * @return The flow of the key, or NULL if the key is invalid or the table capacity is zero
+		 */
+		Flow* processFlowPacket(const FlowKey& key, time_t timestamp, size_t numOfBytes, FlowDirection* direction = NULL, bool* isNewFlow = NULL)
+		{
+			if (!key.isValid() || m_MaxNumOfFlows == 0)
+				return NULL;
+
+			purgeTimedOutFlows(timestamp);
+
+			bool newFlow = false;
+			uint32_t index = findNode(key);
+			if (index == NullIndex)
+			{
+				if (m_NumOfFlows == m_MaxNumOfFlows)
+				{
+					m_NumOfEvictedFlows++;
+					closeNode(m_LRUList.head, FlowClosedByEviction);
+				}
+
+				index = m_FreeList;
+				m_FreeList = m_Nodes[index].lruNext;
+				m_NumOfFlows++;
+
+				Node& node = m_Nodes[index];
+				node.flow.m_Key = key;
+				node.flow.m_StartTime = m_CurrentTime;
+				uint32_t& bucket = m_Buckets[getBucketIndex(key.getHash())];
+				node.bucketNext = bucket;
+				bucket = index;
+				linkAtTail(m_AgeList, index, &Node::agePrev, &Node::ageNext);
+				newFlow = true;
+			}
+			else
+				unlink(m_LRUList, index, &Node::lruPrev, &Node::lruNext);
+
+			// the least recently active flow is always at the head of the LRU list
+			linkAtTail(m_LRUList, index, &Node::lruPrev, &Node::lruNext);
+
+			Flow& flow = m_Nodes[index].flow;
+			flow.m_LastSeenTime = m_CurrentTime;
+			FlowDirection packetDirection = (flow.m_Key.isSameDirection(key) ? FlowDirectionFromInitiator : FlowDirectionFromResponder);
+			flow.m_NumOfPackets[packetDirection]++;
+			flow.m_NumOfBytes[packetDirection] += numOfBytes;
+
+			if (direction != NULL)
+				*direction = packetDirection;
+			if (isNewFlow != NULL)
+				*isNewFlow = newFlow;
+
+			return &flow;
+		}
+
+		/**
+		 * Find a flow without changing it or the table clock
+		 * @param[in] key The flow key, in any direction
+		 * @return The flow or NULL if it's not in the table
+		 */
+		Flow* getFlow(const FlowKey& key)
+		{
+			uint32_t index = findNode(key);
+			return (index == NullIndex ? NULL : &m_Nodes[index].flow);
+		}
+
+		/**
+		 * Close a flow. The OnFlowClosed callback is called with reason FlowClosedManually
+		 * @param[in] key The flow key, in any direction
+		 * @return True if the flow was found and closed, false if it's not in the table
+		 */
+		bool closeFlow(const FlowKey& key)
+		{
+			uint32_t index = findNode(key);
+			if (index == NullIndex)
+				return false;
+
+			closeNode(index, FlowClosedManually);
+			return true;
+		}
+
+		/**
+		 * Close all flows in the table. The OnFlowClosed callback is called for each of them with reason FlowClosedManually.
+		 * Notice flows still in the table when it's destroyed are not reported to the callback, so call this method first if needed
+		 */
+		void closeAllFlows()
+		{
+			while (m_LRUList.head != NullIndex)
+				closeNode(m_LRUList.head, FlowClosedManually);
+		}
+
+		/**
+		 * Advance the table clock and close the flows that timed out. This is done automatically when packets are processed, but a table
+		 * which doesn't get packets for a while should have this method called periodically
+		 * @param[in] currentTime The current time in seconds. The clock never goes backwards, so a time earlier than the current table
+		 * time is ignored
+		 */
+		void purgeTimedOutFlows(time_t currentTime)
+		{
+			if (currentTime > m_CurrentTime)
+				m_CurrentTime = currentTime;
+
+			if (m_IdleTimeout > 0)
+			{
+				while (m_LRUList.head != NullIndex && m_Nodes[m_LRUList.head].flow.m_LastSeenTime + (time_t)m_IdleTimeout <= m_CurrentTime)
+				{
+					m_NumOfTimedOutFlows++;
+					closeNode(m_LRUList.head, FlowClosedByIdleTimeout);
+				}
+			}
+
+			if (m_ActiveTimeout > 0)
+			{
+				while (m_AgeList.head != NullIndex && m_Nodes[m_AgeList.head].flow.m_StartTime + (time_t)m_ActiveTimeout <= m_CurrentTime)
+				{
+					m_NumOfTimedOutFlows++;
+					closeNode(m_AgeList.head, FlowClosedByActiveTimeout);
+				}
+			}
+		}
+
+		/**
+		 * Call a callback for each flow in the table, from the least recently active flow to the most recently active one
+		 * @param[in] visitor The callback to call
+		 * @param[in] userCookie A pointer to an object provided by the user which is passed to the callback
+		 */
+		void forEachFlow(FlowVisitor visitor, void* userCookie)
+		{
+			for (uint32_t index = m_LRUList.head; index != NullIndex; index = m_Nodes[index].lruNext)
+				visitor(m_Nodes[index].flow, userCookie);
+		}
+
+		/**
+		 * @return The number of flows currently in the table
+		 */
+		size_t getNumOfFlows() const { return m_NumOfFlows; }
+
+		/**
+		 * @return The maximum number of flows in the table as determined in the c'tor
+		 */
+		size_t getMaxNumOfFlows() const { return m_MaxNumOfFlows; }
+
+		/**
+		 * @return The largest maximum number of flows a table can have. Flows are linked by 32-bit indices (one of which marks the end of a
+		 * list), and the bucket count, which is at least twice the maximum number of flows, must fit in size_t
+		 */
+		static size_t getMaxSupportedNumOfFlows()
+		{
+			size_t maxIndexSize = (size_t)NullIndex;
+			size_t maxBucketSize = ((size_t)-1) / 4;
+			return (maxIndexSize < maxBucketSize ? maxIndexSize : maxBucketSize);
+		}
+
+		/**
+		 * @return The idle timeout in seconds as determined in the c'tor. 0 means flows never time out this way
+		 */
+		uint32_t getIdleTimeout() const { return m_IdleTimeout; }
+
+		/**
+		 * @return The active timeout in seconds as determined in the c'tor. 0 means flows never time out this way
+		 */
+		uint32_t getActiveTimeout() const { return m_ActiveTimeout; }
+
+		/**
+		 * @return The table clock: the latest timestamp processed so far
+		 */
+		time_t getCurrentTime() const { return m_CurrentTime; }
+
+		/**
+		 * @return The number of flows closed so far to make room for new flows
+		 */
+		uint64_t getNumOfEvictedFlows() const { return m_NumOfEvictedFlows; }
+
+		/**
+		 * @return The number of flows closed so far by the idle or active timeout
+		 */
+		uint64_t getNumOfTimedOutFlows() const { return m_NumOfTimedOutFlows; }
+
+	private:
+		enum { NullIndex = 0xFFFFFFFF };
+
+		// flows are linked by their node indices into a hash bucket chain, the LRU list and the age list
+		struct Node
+		{
+			Flow flow;
+			uint32_t bucketNext;
+			uint32_t lruPrev;
+			uint32_t lruNext;
+			uint32_t agePrev;
+			uint32_t ageNext;
+
+			Node() : bucketNext(NullIndex), lruPrev(NullIndex), lruNext(NullIndex), agePrev(NullIndex), ageNext(NullIndex) {}
+		};
+
+		struct List
+		{
+			uint32_t head;
+			uint32_t tail;
+
+			List() : head(NullIndex), tail(NullIndex) {}
+		};
+
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_Buckets;
+		size_t m_MaxNumOfFlows;
+		size_t m_NumOfFlows;
+		uint32_t m_IdleTimeout;
+		uint32_t m_ActiveTimeout;
+		time_t m_CurrentTime;
+		uint64_t m_NumOfEvictedFlows;
+		uint64_t m_NumOfTimedOutFlows;
+		OnFlowClosed m_OnFlowClosed;
+		void* m_UserCookie;
+		// flows ordered from the least recently active to the most recently active
+		List m_LRUList;
+		// flows ordered by start time, which is also the order they reach the active timeout at
+		List m_AgeList;
+		// unused nodes, linked by their lruNext index
+		uint32_t m_FreeList;
+
+		// private copy c'tor and assignment operator
+		FlowTable(const FlowTable& other);
+		FlowTable& operator=(const FlowTable& other);
+
+		static size_t clampMaxNumOfFlows(size_t maxNumOfFlows)
+		{
+			return (maxNumOfFlows > getMaxSupportedNumOfFlows() ? getMaxSupportedNumOfFlows() : maxNumOfFlows);
+		}
+
+		size_t getBucketIndex(uint32_t hash) const
+		{
+			// mix the bits since a ConcurrentFlowTable shard holds only keys with the same hash remainder
+			hash ^= hash >> 16;
+			hash *= 0x45d9f3bu;
+			hash ^= hash >> 16;
+			return hash & (m_Buckets.size() - 1);
+		}
+
+		uint32_t findNode(const FlowKey& key) const
+		{
+			if (m_Buckets.empty())
+				return NullIndex;
+
+			uint32_t index = m_Buckets[getBucketIndex(key.getHash())];
+			while (index != NullIndex)
+			{
+				const Node& node = m_Nodes[index];
+				if (node.flow.m_Key == key)
+					return index;
+				index = node.bucketNext;
+			}
+
+			return NullIndex;
+		}
+
+		void linkAtTail(List& list, uint32_t index, uint32_t Node::*prev, uint32_t Node::*next)
+		{
+			Node& node = m_Nodes[index];
+			node.*prev = list.tail;
+			node.*next = NullIndex;
+			if (list.tail != NullIndex)
+				m_Nodes[list.tail].*next = index;
+			else
+				list.head = index;
+			list.tail = index;
+		}
+
+		void unlink(List& list, uint32_t index, uint32_t Node::*prev, uint32_t Node::*next)
+		{
+			Node& node = m_Nodes[index];
+			if (node.*prev != NullIndex)
+				m_Nodes[node.*prev].*next = node.*next;
+			else
+				list.head = node.*next;
+
+			if (node.*next != NullIndex)
+				m_Nodes[node.*next].*prev = node.*prev;
+			else
+				list.tail = node.*prev;
+		}
+
+		void closeNode(uint32_t index, FlowCloseReason reason)
+		{
+			Node& node = m_Nodes[index];
+
+			// remove the flow from the table before the callback so the table is consistent while it runs
+			unlink(m_LRUList, index, &Node::lruPrev, &Node::lruNext);
+			unlink(m_AgeList, index, &Node::agePrev, &Node::ageNext);
+
+			uint32_t* link = &m_Buckets[getBucketIndex(node.flow.m_Key.getHash())];
+			while (*link != index)
+				link = &m_Nodes[*link].bucketNext;
+			*link = node.bucketNext;
+			m_NumOfFlows--;
+
+			if (m_OnFlowClosed != NULL)
+				m_OnFlowClosed(node.flow, reason, m_UserCookie);
+
+			// release whatever the state holds and make the node ready for the next flow
+			node.flow = Flow();
+			node.lruNext = m_FreeList;
+			m_FreeList = index;
+		}
+	};
+
+
+	/**
+	 * @class ConcurrentFlowTable
+	 * A thread-safe variant of pcpp#FlowTable. The flows are split into shards by their key hash, and each shard is a pcpp#FlowTable
+	 * protected by its own lock. Since flows can't be used outside the shard lock, they are accessed through callbacks which are called
+	 * while the lock is held. Notice each shard has its own clock which is advanced only by the packets of its flows, so
+	 * purgeTimedOutFlows() should be called periodically to close the timed out flows of shards that don't get packets.
+	 * Please read more about the logic in the FlowTable.h file description
+	 */
+	template<typename T>
+	class ConcurrentFlowTable
+	{
+	public:
+
+		/**
+		 * The flow type, see pcpp#FlowTable#Flow
+		 */
+		typedef typename FlowTable<T>::Flow Flow;
+
+		/**
+		 * The callback called when a flow is closed, see pcpp#FlowTable#OnFlowClosed. It's called while the shard lock is held
+		 */
+		typedef typename FlowTable<T>::OnFlowClosed OnFlowClosed;
+
+		/**
+		 * The callback called for flows by visitFlow() and forEachFlow(), see pcpp#FlowTable#FlowVisitor. It's called while the shard lock
+		 * is held
+		 */
+		typedef typename FlowTable<T>::FlowVisitor FlowVisitor;
+
+		/**
+		 * @typedef OnFlowPacket
+		 * A callback that is called with the flow of a packet by processPacket() and processFlowPacket(), while the shard lock is held.
+		 * The callback must not access the table
+		 * @param[in] flow The flow of the packet
+		 * @param[in] direction The direction of the packet in the flow
+		 * @param[in] isNewFlow True if the packet started a new flow, false otherwise
+		 * @param[in] userCookie A pointer to the cookie provided by the user in processPacket() or processFlowPacket()
+		 */
+		typedef void (*OnFlowPacket)(Flow& flow, FlowDirection direction, bool isNewFlow, void* userCookie);
+
+		/**
+		 * A c'tor for this class. It allocates all memory the table uses
+		 * @param[in] numOfShards The number of shards. More shards mean less lock contention between threads
+		 * @param[in] maxNumOfFlows The maximum number of flows in the table. It's split evenly between the shards
+		 * @param[in] idleTimeout The idle timeout in seconds, see pcpp#FlowTable#FlowTable(). Default value is 0 (no idle timeout)
+		 * @param[in] activeTimeout The active timeout in seconds, see pcpp#FlowTable#FlowTable(). Default value is 0 (no active timeout)
+		 * @param[in] onFlowClosed The callback to call when a flow is closed. This parameter is optional, default value is NULL (no callback)
+		 * @param[in] userCookie A pointer to an object provided by the user which is passed to onFlowClosed. This parameter is optional,
+		 * default cookie is NULL
+		 */
+		ConcurrentFlowTable(size_t numOfShards, size_t maxNumOfFlows, uint32_t idleTimeout = 0, uint32_t activeTimeout = 0,
+				OnFlowClosed onFlowClosed = NULL, void* userCookie = NULL)
+		{
+			m_NumOfShards = (numOfShards > 0 ? numOfShards : 1);
+			size_t maxFlowsPerShard = (maxNumOfFlows + m_NumOfShards - 1) / m_NumOfShards;
+			m_Shards = new Shard[m_NumOfShards];
+			for (size_t i = 0; i < m_NumOfShards; i++)
+			{
+				m_Shards[i].table = new FlowTable<T>(maxFlowsPerShard, idleTimeout, activeTimeout, onFlowClosed, userCookie);
+				pthread_mutex_init(&m_Shards[i].mutex, NULL);
+			}
+		}
+
+		/**
+		 * A d'tor for this class. Flows still in the table are not reported to the OnFlowClosed callback
+		 */
+		~ConcurrentFlowTable()
+		{
+			for (size_t i = 0; i < m_NumOfShards; i++)
+			{
+				delete m_Shards[i].table;
+				pthread_mutex_destroy(&m_Shards[i].mutex);
+			}
+			delete [] m_Shards;
+		}
+
+		/**
+		 * Find the flow of a packet, or start a new flow if it doesn't exist, and update its statistics. See pcpp#FlowTable#processPacket()
+		 * @param[in] packet The packet to process
+		 * @param[in] onFlowPacket A callback to call with the flow of the packet. It may be NULL
+		 * @param[in] userCookie A pointer to an object provided by the user which is passed to the callback
+		 * @return True if the packet was counted in a flow, false if it isn't an IPv4 or IPv6 packet or the table capacity is zero
+		 */
+		bool processPacket(Packet* packet, OnFlowPacket onFlowPacket, void* userCookie)
+		{
+			FlowKey key;
+			if (!key.setFromPacket(packet))
+				return false;
+
+			RawPacket* rawPacket = packet->getRawPacketReadOnly();
+			return processFlowPacket(key, rawPacket->getPacketTimeStamp().tv_sec, rawPacket->getFrameLength(), onFlowPacket, userCookie);
+		}
+
+		/**
+		 * Find the flow of a key, or start a new flow if it doesn't exist, and count a packet in it. See pcpp#FlowTable#processFlowPacket()
+		 * @param[in] key The flow key of the packet
+		 * @param[in] timestamp The packet timestamp in seconds
+		 * @param[in] numOfBytes The packet length to add to the flow byte count
+		 * @param[in] onFlowPacket A callback to call with the flow of the packet. It may be NULL
+		 * @param[in] userCookie A pointer to an object provided by the user which is passed to the callback
+		 * @return True if the packet was counted in a flow, false if the key is invalid or the table capacity is zero
+		 */
+		bool processFlowPacket(const FlowKey& key, time_t timestamp, size_t numOfBytes, OnFlowPacket onFlowPacket, void* userCookie)
+		{
+			if (!key.isValid())
+				return false;
+
+			Shard& shard = getShard(key);
+			pthread_mutex_lock(&shard.mutex);
+			FlowDirection direction;
+			bool isNewFlow;
+			Flow* flow = shard.table->processFlowPacket(key, timestamp, numOfBytes, &direction, &isNewFlow);
+			if (flow != NULL && onFlowPacket != NULL)
+				onFlowPacket(*flow, direction, isNewFlow, userCookie);
+			pthread_mutex_unlock(&shard.mutex);
+
+			return flow != NULL;
+		}
+
+		/**
+		 * Find a flow and call a callback with it, without changing the flow or the shard clock
+		 * @param[in] key The flow key, in any direction
+		 * @param[in] visitor The callback to call with the flow
+		 * @param[in] userCookie A pointer to an object provided by the user which is passed to the callback
+		 * @return True if the flow was found, false otherwise
+		 */
+		bool visitFlow(const FlowKey& key, FlowVisitor visitor, void* userCookie)
+		{
+			Shard& shard = getShard(key);
+			pthread_mutex_lock(&shard.mutex);
+			Flow* flow = shard.table->getFlow(key);
+			if (flow != NULL)
+				visitor(*flow, userCookie);
+			pthread_mutex_unlock(&shard.mutex);
+
+			return flow != NULL;
+		}
+
+		/**
+		 * Close a flow, see pcpp#FlowTable#closeFlow()
+		 * @param[in] key The flow key, in any direction
+		 * @return True if the flow was found and closed, false if it's not in the table
+		 */
+		bool closeFlow(const FlowKey& key)
+		{
+			Shard& shard = getShard(key);
+			pthread_mutex_lock(&shard.mutex);
+			bool result = shard.table->closeFlow(key);
+			pthread_mutex_unlock(&shard.mutex);
+
+			return result;
+		}
+
+		/**
+		 * Close all flows in all shards, see pcpp#FlowTable#closeAllFlows()
+		 */
+		void closeAllFlows()
+		{
+			for (size_t i = 0; i < m_NumOfShards; i++)
+			{
+				pthread_mutex_lock(&m_Shards[i].mutex);
+				m_Shards[i].table->closeAllFlows();
+				pthread_mutex_unlock(&m_Shards[i].mutex);
+			}
+		}
+
+		/**
+		 * Advance the clock of all shards and close the flows that timed out, see pcpp#FlowTable#purgeTimedOutFlows()
+		 * @param[in] currentTime The current time in seconds
+		 */
+		void purgeTimedOutFlows(time_t currentTime)
+		{
+			for (size_t i = 0; i < m_NumOfShards; i++)
+			{
+				pthread_mutex_lock(&m_Shards[i].mutex);
+				m_Shards[i].table->purgeTimedOutFlows(currentTime);
+				pthread_mutex_unlock(&m_Shards[i].mutex);
+			}
+		}
+
+		/**
+		 * Call a callback for each flow in the table. Shards are locked one at a time, so flows may be added or closed in other shards
+		 * while this method runs
+		 * @param[in] visitor The callback to call
+		 * @param[in] userCookie A pointer to an object provided by the user which is passed to the callback
+		 */
+		void forEachFlow(FlowVisitor visitor, void* userCookie)
+		{
+			for (size_t i = 0; i < m_NumOfShards; i++)
+			{
+				pthread_mutex_lock(&m_Shards[i].mutex);
+				m_Shards[i].table->forEachFlow(visitor, userCookie);
+				pthread_mutex_unlock(&m_Shards[i].mutex);
+			}
+		}
+
+		/**
+		 * @return The number of flows currently in the table
+		 */
+		size_t getNumOfFlows() const { return sumShards(&FlowTable<T>::getNumOfFlows); }
+
+		/**
+		 * @return The maximum number of flows in the table, which is the capacity of a shard times the number of shards
+		 */
+		size_t getMaxNumOfFlows() const { return m_Shards[0].table->getMaxNumOfFlows() * m_NumOfShards; }
+
+		/**
+		 * @return The number of flows closed so far to make room for new flows
+		 */
+		uint64_t getNumOfEvictedFlows() const { return sumShards(&FlowTable<T>::getNumOfEvictedFlows); }
+
+		/**
+		 * @return The number of flows closed so far by the idle or active timeout
+		 */
+		uint64_t getNumOfTimedOutFlows() const { return sumShards(&FlowTable<T>::getNumOfTimedOutFlows); }
+
+		/**
+		 * @return The number of shards
+		 */
+		size_t getNumOfShards() const { return m_NumOfShards; }
+
+		/**
+		 * @param[in] key A flow key
+		 * @return The index of the shard the flow belongs to
+		 */
+		size_t getShardIndex(const FlowKey& key) const { return key.getHash() % m_NumOfShards; }
+
+	private:
+		struct Shard
+		{
+			FlowTable<T>* table;
+			pthread_mutex_t mutex;
+		};
+
+		Shard* m_Shards;
+		size_t m_NumOfShards;
+
+		// private copy c'tor and assignment operator
+		ConcurrentFlowTable(const ConcurrentFlowTable& other);
+		ConcurrentFlowTable& operator=(const ConcurrentFlowTable& other);
+
+		Shard& getShard(const FlowKey& key) { return m_Shards[getShardIndex(key)]; }
+
+		template<typename TValue>
+		TValue sumShards(TValue (FlowTable<T>::*getter)() const) const
+		{
+			TValue result = 0;
+			for (size_t i = 0; i < m_NumOfShards; i++)
+			{
+				pthread_mutex_lock(&m_Shards[i].mutex);
+				result += (m_Shards[i].table->*getter)();
+				pthread_mutex_unlock(&m_Shards[i].mutex);
+			}
+
+			return result;
+		}
+	};
+
+} // namespace pcpp
+
+#endif /* PACKETPP_FLOW_TABLE */
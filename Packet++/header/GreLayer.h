@@ -178,6 +178,8 @@ namespace pcpp
 		void computeCalculateFieldsInner();
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(GreLayer, GRE, true);
+
 
 	/**
 	 * @class GREv0Layer
@@ -290,6 +292,8 @@ namespace pcpp
 
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(GREv0Layer, GREv0, true);
+
 
 	/**
 	 * @class GREv1Layer
@@ -363,6 +367,8 @@ namespace pcpp
 
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(GREv1Layer, GREv1, true);
+
 
 	/**
 	 * @class PPP_PPTPLayer
@@ -420,6 +426,8 @@ namespace pcpp
 
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(PPP_PPTPLayer, PPP_PPTP, true);
+
 } // namespace pcpp
 
 #endif /* PACKETPP_GRE_LAYER */
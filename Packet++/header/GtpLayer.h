@@ -453,6 +453,8 @@ namespace pcpp
 
 		OsiModelLayer getOsiModelLayer() const { return OsiModelTransportLayer; }
 	};
+
+	PCPP_DECLARE_LAYER_PROTOCOL(GtpV1Layer, GTPv1, true);
 }
 
 #endif //PACKETPP_GTP_LAYER
\ No newline at end of file
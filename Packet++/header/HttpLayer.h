@@ -99,6 +99,8 @@ namespace pcpp
 		bool spacesAllowedBetweenHeaderFieldNameAndValue() const { return true; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(HttpMessage, HTTP, true);
+
 
 
 
@@ -205,6 +207,8 @@ namespace pcpp
 		HttpRequestFirstLine* m_FirstLine;
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(HttpRequestLayer, HTTPRequest, true);
+
 
 
 
@@ -470,6 +474,8 @@ namespace pcpp
 
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(HttpResponseLayer, HTTPResponse, true);
+
 
 
 
@@ -2,10 +2,10 @@
 #define PACKETPP_IP_REASSEMBLY
 
 #include "Packet.h"
-#include "LRUList.h"
 #include "IpAddress.h"
 #include "PointerVector.h"
-#include <map>
+#include <vector>
+#include <time.h>
 
 /**
  * @file
@@ -17,8 +17,9 @@
  * reassembly and returns a fully reassembled packet when done.<BR>
  *
  * The logic works as follows:
- * - There is an internal map that stores the reassembly data for each packet. The key to this map, meaning the way to uniquely associate a
- *   fragment to a (reassembled) packet is the triplet of source IP, destination IP and IP ID (for IPv4) or Fragment ID (for IPv6)
+ * - There is an internal hash table that stores the reassembly data for each packet. The key to this table, meaning the way to uniquely associate a
+ *   fragment to a (reassembled) packet is the triplet of source IP, destination IP and IP ID (for IPv4) or Fragment ID (for IPv6). The whole
+ *   triplet is compared when looking up a packet, so packets whose triplets have the same hash value are never mixed up
  * - When the first fragment arrives a new record is created in the map and the fragment data is copied
  * - With each fragment arriving the fragment data is copied right after the previous fragment and the reassembled packet is gradually being built
  * - When the last fragment arrives the packet is fully reassembled and returned to the user. Since all fragment data is copied, the packet pointer
@@ -35,6 +36,17 @@
  * dropped from the map along with all the data that was reassembled so far. This means that if the next fragment from this packet suddenly
  * appears it will be treated as a new reassembled packet (which will create another record in the map). The user can be notified when
  * reassembled packets are removed from the map by registering to the pcpp#IPReassembly#OnFragmentsClean callback in pcpp#IPReassembly c'tor
+ *
+ * Since fragment floods are a common denial-of-service technique, two more limits can be set in the c'tor:
+ * - A memory limit: the maximum number of bytes of packet data (reassembled data and out-of-order fragments) stored for all packets. When
+ *   it's exceeded, the least recently used packets are dropped until memory usage is within the limit again
+ * - A packet timeout: the maximum number of seconds a packet may take to be reassembled, counted from its first fragment seen. Time is measured
+ *   by packet timestamps: the current time is the latest timestamp of the packets processed so far, so processing a capture file gives the same
+ *   result regardless of how fast it's processed. Packets that time out are dropped when the next packet is processed
+ *
+ * The pcpp#IPReassembly#OnFragmentsClean callback is fired for packets dropped for any of these reasons. The number of packets dropped because
+ * of the capacity or memory limits and the number of packets that timed out can be retrieved with pcpp#IPReassembly#getNumOfEvictedPackets()
+ * and pcpp#IPReassembly#getNumOfTimedOutPackets()
  */
 
 /**
@@ -289,7 +301,8 @@ namespace pcpp
 		 * @typedef OnFragmentsClean
 		 * The IP reassembly mechanism has a certain capacity of concurrent packets it can handle. This capacity is determined in its c'tor
 		 * (default value is #PCPP_IP_REASSEMBLY_DEFAULT_MAX_PACKETS_TO_STORE). When traffic volume exceeds this capacity the mechanism starts
-		 * dropping packets in a LRU manner (least recently used are dropped first). Whenever a packet is dropped this callback is fired
+		 * dropping packets in a LRU manner (least recently used are dropped first). Packets are also dropped when the memory limit is exceeded
+		 * or when they time out (see IPReassembly c'tor). Whenever a packet is dropped this callback is fired
 		 * @param[in] key A pointer to the identifier of the packet that is being dropped
 		 * @param[in] userCookie A pointer to the cookie provided by the user in IPReassemby c'tor (or NULL if no cookie provided)
 		 */
@@ -323,9 +336,14 @@ namespace pcpp
 		 * @param[in] callbackUserCookie A pointer to an object provided by the user. This pointer will be returned when invoking the
 		 * onFragmentsCleanCallback. This parameter is optional, default cookie is NULL
 		 * @param[in] maxPacketsToStore Set the capacity limit of the IP reassembly mechanism. Default capacity is #PCPP_IP_REASSEMBLY_DEFAULT_MAX_PACKETS_TO_STORE
+		 * @param[in] maxBytesToStore The maximum number of bytes of packet data stored for all packets being reassembled. When it's exceeded the least
+		 * recently used packets are dropped. This parameter is optional, default value is 0 which means memory usage isn't limited
+		 * @param[in] packetTimeout The maximum number of seconds (measured by packet timestamps) a packet may take to be reassembled, counted from
+		 * its first fragment seen. Packets that don't complete in time are dropped. This parameter is optional, default value is 0 which means
+		 * packets never time out
 		 */
-		IPReassembly(OnFragmentsClean onFragmentsCleanCallback = NULL, void *callbackUserCookie = NULL, size_t maxPacketsToStore = PCPP_IP_REASSEMBLY_DEFAULT_MAX_PACKETS_TO_STORE)
-			: m_PacketLRU(maxPacketsToStore), m_OnFragmentsCleanCallback(onFragmentsCleanCallback), m_CallbackUserCookie(callbackUserCookie) {}
+		IPReassembly(OnFragmentsClean onFragmentsCleanCallback = NULL, void *callbackUserCookie = NULL, size_t maxPacketsToStore = PCPP_IP_REASSEMBLY_DEFAULT_MAX_PACKETS_TO_STORE,
+			size_t maxBytesToStore = 0, uint32_t packetTimeout = 0);
 
 		/**
 		 * A d'tor for this class
@@ -412,12 +430,37 @@ namespace pcpp
 		/**
 		 * Get the maximum capacity as determined in the c'tor
 		 */
-		size_t getMaxCapacity() const { return m_PacketLRU.getMaxSize(); }
+		size_t getMaxCapacity() const { return m_MaxPacketsToStore; }
 
 		/**
 		 * Get the current number of packets being processed
 		 */
-		size_t getCurrentCapacity() const { return m_FragmentMap.size(); }
+		size_t getCurrentCapacity() const { return m_NumOfPackets; }
+
+		/**
+		 * Get the memory limit as determined in the c'tor. 0 means memory usage isn't limited
+		 */
+		size_t getMaxMemory() const { return m_MaxBytesToStore; }
+
+		/**
+		 * Get the number of bytes of packet data currently stored for all packets being processed
+		 */
+		size_t getCurrentMemoryUsage() const { return m_CurrentMemoryUsage; }
+
+		/**
+		 * Get the packet timeout in seconds as determined in the c'tor. 0 means packets never time out
+		 */
+		uint32_t getPacketTimeout() const { return m_PacketTimeout; }
+
+		/**
+		 * Get the number of packets dropped so far because the capacity limit or the memory limit was reached
+		 */
+		uint64_t getNumOfEvictedPackets() const { return m_NumOfEvictedPackets; }
+
+		/**
+		 * Get the number of packets dropped so far because they weren't reassembled within the packet timeout
+		 */
+		uint64_t getNumOfTimedOutPackets() const { return m_NumOfTimedOutPackets; }
 
 	private:
 
@@ -431,6 +474,23 @@ namespace pcpp
 			~IPFragment() { delete [] fragmentData; }
 		};
 
+		struct IPFragmentData;
+
+		// links of an intrusive doubly-linked list of IPFragmentData objects
+		struct FragmentListLinks
+		{
+			IPFragmentData* prev;
+			IPFragmentData* next;
+			FragmentListLinks() { prev = NULL; next = NULL; }
+		};
+
+		struct FragmentList
+		{
+			IPFragmentData* head;
+			IPFragmentData* tail;
+			FragmentList() { head = NULL; tail = NULL; }
+		};
+
 		struct IPFragmentData
 		{
 			uint16_t currentOffset;
@@ -439,17 +499,50 @@ namespace pcpp
 			uint32_t fragmentID;
 			PacketKey* packetKey;
 			PointerVector<IPFragment> outOfOrderFragments;
-			IPFragmentData(PacketKey* pktKey, uint32_t fragId) { currentOffset = 0; data = NULL; deleteData = true; fragmentID = fragId; packetKey = pktKey; }
+			uint32_t hash;
+			size_t memoryUsage;
+			time_t creationTime;
+			// the next packet in the same hash table bucket
+			IPFragmentData* nextInBucket;
+			// links in the least recently used list and in the creation time list
+			FragmentListLinks lruLinks;
+			FragmentListLinks ageLinks;
+			IPFragmentData(PacketKey* pktKey, uint32_t fragId) { currentOffset = 0; data = NULL; deleteData = true; fragmentID = fragId; packetKey = pktKey; hash = 0; memoryUsage = 0; creationTime = 0; nextInBucket = NULL; }
 			~IPFragmentData() { delete packetKey; if (deleteData && data != NULL) { delete data; } }
 		};
 
-		LRUList<uint32_t> m_PacketLRU;
-		std::map<uint32_t, IPFragmentData*> m_FragmentMap;
+		// a hash table with chaining. Its size is always a power of 2
+		std::vector<IPFragmentData*> m_HashTable;
+		size_t m_NumOfPackets;
+		size_t m_MaxPacketsToStore;
+		size_t m_MaxBytesToStore;
+		size_t m_CurrentMemoryUsage;
+		uint32_t m_PacketTimeout;
+		time_t m_LatestPacketTime;
+		uint64_t m_NumOfEvictedPackets;
+		uint64_t m_NumOfTimedOutPackets;
+		// packets ordered from the least recently used to the most recently used
+		FragmentList m_LRUList;
+		// packets ordered by creation time, which is also the order they time out at
+		FragmentList m_AgeList;
 		OnFragmentsClean m_OnFragmentsCleanCallback;
 		void* m_CallbackUserCookie;
 
-		void addNewFragment(uint32_t hash, IPFragmentData* fragData);
+		// private copy c'tor and assignment operator
+		IPReassembly(const IPReassembly& other);
+		IPReassembly& operator=(const IPReassembly& other);
+
+		IPFragmentData* findPacket(uint32_t hash, const PacketKey& key);
+		void addNewPacket(uint32_t hash, IPFragmentData* fragData);
+		void removePacketData(IPFragmentData* fragData);
+		void dropPacket(IPFragmentData* fragData, bool timedOut);
+		void dropTimedOutPackets();
+		void enforceMemoryLimit();
+		void rehash(size_t newSize);
 		bool matchOutOfOrderFragments(IPFragmentData* fragData);
+
+		static void listPushBack(FragmentList& list, IPFragmentData* fragData, FragmentListLinks IPFragmentData::* links);
+		static void listRemove(FragmentList& list, IPFragmentData* fragData, FragmentListLinks IPFragmentData::* links);
 	};
 
 } // namespace pcpp
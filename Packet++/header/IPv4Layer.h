@@ -616,6 +616,8 @@ namespace pcpp
 		void initLayerInPacket(uint8_t* data, size_t dataLen, Layer* prevLayer, Packet* packet, bool setTotalLenAsDataLen);
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(IPv4Layer, IPv4, true);
+
 
 	// implementation of inline methods
 
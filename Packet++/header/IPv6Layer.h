@@ -186,6 +186,8 @@ namespace pcpp
 		size_t m_ExtensionsLen;
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(IPv6Layer, IPv6, true);
+
 
 	template<class TIPv6Extension>
 	TIPv6Extension* IPv6Layer::getExtensionOfType() const
@@ -698,6 +698,8 @@ namespace pcpp
 		OsiModelLayer getOsiModelLayer() const { return OsiModelNetworkLayer; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(IcmpLayer, ICMP, true);
+
 } // namespace pcpp
 
 #endif /* PACKETPP_ICMP_LAYER */
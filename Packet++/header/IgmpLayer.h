@@ -230,6 +230,8 @@ public:
 	OsiModelLayer getOsiModelLayer() const { return OsiModelNetworkLayer; }
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(IgmpLayer, IGMP, true);
+
 
 /**
  * @class IgmpV1Layer
@@ -269,6 +271,8 @@ public:
 
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(IgmpV1Layer, IGMPv1, true);
+
 
 /**
  * @class IgmpV2Layer
@@ -307,6 +311,8 @@ public:
 	void computeCalculateFields();
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(IgmpV2Layer, IGMPv2, true);
+
 
 /**
  * @class IgmpV3QueryLayer
@@ -398,6 +404,8 @@ public:
 	size_t getHeaderLen() const;
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(IgmpV3QueryLayer, IGMPv3, false);
+
 
 /**
  * @class IgmpV3ReportLayer
@@ -504,6 +512,8 @@ public:
 	size_t getHeaderLen() const { return m_DataLen; }
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(IgmpV3ReportLayer, IGMPv3, false);
+
 }
 
 #endif // PACKETPP_IGMP_LAYER
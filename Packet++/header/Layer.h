@@ -76,9 +76,10 @@ namespace pcpp
 		virtual ~Layer();
 
 		/**
-		 * @return A pointer to the next layer in the protocol stack or NULL if the layer is the last one
+		 * @return A pointer to the next layer in the protocol stack or NULL if the layer is the last one. If the packet was parsed
+		 * lazily (see Packet#Packet()) and the layers above this layer weren't created yet, they're created by this call
 		 */
-		Layer* getNextLayer() const { return m_NextLayer; }
+		Layer* getNextLayer() const { return m_IsNextLayerPending ? parsePendingNextLayer() : m_NextLayer; }
 
 		/**
 		 * @return A pointer to the previous layer in the protocol stack or NULL if the layer is the first one
@@ -159,6 +160,40 @@ namespace pcpp
 		 */
 		virtual OsiModelLayer getOsiModelLayer() const = 0;
 
+
+		// memory management
+
+		/**
+		 * Allocate memory for a layer instance. Each layer memory block is prefixed with a small header holding the block size,
+		 * which enables a Packet to recycle the memory of the layers it created when it is re-parsed (see Packet#setRawPacket())
+		 * @param[in] size The size of the layer instance
+		 * @return A pointer to the allocated memory
+		 */
+		static void* operator new(size_t size);
+
+		/**
+		 * Allocate memory for a layer instance created while parsing a packet. The memory is taken from the packet's cache of
+		 * recycled layer blocks if a suitable block exists, otherwise it's allocated on the heap. This is the overload used by
+		 * all parseNextLayer() implementations, so re-parsing a reused Packet instance doesn't need any heap allocations for layers
+		 * @param[in] size The size of the layer instance
+		 * @param[in] packet The packet this layer is created for. If NULL the memory is allocated on the heap
+		 * @return A pointer to the allocated memory
+		 */
+		static void* operator new(size_t size, Packet* packet);
+
+		/**
+		 * Free the memory of a layer instance allocated by one of the operator new overloads
+		 * @param[in] ptr A pointer to the layer memory
+		 */
+		static void operator delete(void* ptr);
+
+		/**
+		 * Called only if a layer constructor throws after being allocated by operator new(size_t, Packet*)
+		 * @param[in] ptr A pointer to the layer memory
+		 * @param[in] packet The packet passed to operator new
+		 */
+		static void operator delete(void* ptr, Packet* packet);
+
 	protected:
 		uint8_t* m_Data;
 		size_t m_DataLen;
@@ -167,13 +202,15 @@ namespace pcpp
 		Layer* m_NextLayer;
 		Layer* m_PrevLayer;
 		bool m_IsAllocatedInPacket;
+		// set by the packet when the layers above this layer are parsed on first access
+		bool m_IsNextLayerPending;
 
-		Layer() : m_Data(NULL), m_DataLen(0), m_Packet(NULL), m_Protocol(UnknownProtocol), m_NextLayer(NULL), m_PrevLayer(NULL), m_IsAllocatedInPacket(false) { }
+		Layer() : m_Data(NULL), m_DataLen(0), m_Packet(NULL), m_Protocol(UnknownProtocol), m_NextLayer(NULL), m_PrevLayer(NULL), m_IsAllocatedInPacket(false), m_IsNextLayerPending(false) { }
 
 		Layer(uint8_t* data, size_t dataLen, Layer* prevLayer, Packet* packet) :
 			m_Data(data), m_DataLen(dataLen),
 			m_Packet(packet), m_Protocol(UnknownProtocol),
-			m_NextLayer(NULL), m_PrevLayer(prevLayer), m_IsAllocatedInPacket(false) {}
+			m_NextLayer(NULL), m_PrevLayer(prevLayer), m_IsAllocatedInPacket(false), m_IsNextLayerPending(false) {}
 
 		// Copy c'tor
 		Layer(const Layer& other);
@@ -184,8 +221,49 @@ namespace pcpp
 
 		virtual bool extendLayer(int offsetInLayer, size_t numOfBytesToExtend);
 		virtual bool shortenLayer(int offsetInLayer, size_t numOfBytesToShorten);
+
+	private:
+		Layer* parsePendingNextLayer() const;
+
+		static void* allocateBlock(size_t size);
+		static void freeBlock(void* ptr);
+		static size_t getBlockSize(void* ptr);
+	};
+
+
+	/**
+	 * @struct LayerProtocolTraits
+	 * Maps a layer class to the protocols of its instances at compile time, so Packet#getLayerOfType() and similar methods can
+	 * find a layer by comparing protocol bits instead of calling dynamic_cast on every layer. The default (unspecialized) traits
+	 * don't map the class to any protocol, so layers of classes without a specialization are looked up by dynamic_cast.
+	 * Layer classes declare their specialization using PCPP_DECLARE_LAYER_PROTOCOL()
+	 */
+	template<class TLayer>
+	struct LayerProtocolTraits
+	{
+		/** The protocols a layer of this class may have, or ::UnknownProtocol if the class isn't mapped */
+		static const ProtocolType Protocol = UnknownProtocol;
+		/** True if every layer whose protocol is one of the bits in Protocol is an instance of this class */
+		static const bool IsExact = false;
 	};
 
+/**
+ * Declare the protocols of a layer class (see LayerProtocolTraits). Should be used inside the pcpp namespace
+ * @param[in] layerClass The layer class
+ * @param[in] protocol The protocols a layer of this class may have
+ * @param[in] isExact True if every layer whose protocol is one of these protocols is an instance of layerClass, false if
+ * these protocols are shared with other classes (for example sub-classes for different message types) and a dynamic_cast
+ * is needed to tell them apart
+ */
+#define PCPP_DECLARE_LAYER_PROTOCOL(layerClass, protocol, isExact) \
+	class layerClass; \
+	template<> \
+	struct LayerProtocolTraits<layerClass> \
+	{ \
+		static const ProtocolType Protocol = protocol; \
+		static const bool IsExact = isExact; \
+	}
+
 } // namespace pcpp
 
 #endif /* PACKETPP_LAYER */
@@ -121,6 +121,8 @@ namespace pcpp
 		OsiModelLayer getOsiModelLayer() const { return OsiModelNetworkLayer; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(MplsLayer, MPLS, true);
+
 } // namespace pcpp
 
 #endif /* PACKETPP_MPLS_LAYER */
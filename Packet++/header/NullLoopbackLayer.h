@@ -87,6 +87,8 @@ namespace pcpp
 		OsiModelLayer getOsiModelLayer() const { return OsiModelDataLinkLayer; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(NullLoopbackLayer, NULL_LOOPBACK, true);
+
 } // namespace pcpp
 
 #endif /* PACKETPP_NULL_LOOPBACK_LAYER */
@@ -107,6 +107,8 @@ namespace pcpp
 
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(PPPoELayer, PPPoE, true);
+
 
 	/**
 	 * @class PPPoESessionLayer
@@ -163,6 +165,8 @@ namespace pcpp
 		virtual std::string toString() const;
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(PPPoESessionLayer, PPPoESession, true);
+
 
 
 	/**
@@ -381,6 +385,8 @@ namespace pcpp
 		std::string codeToString(PPPoECode code) const;
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(PPPoEDiscoveryLayer, PPPoEDiscovery, true);
+
 
 	// Copied from Wireshark: ppptypes.h
 
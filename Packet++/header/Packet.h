@@ -7,6 +7,18 @@
 
 /// @file
 
+/**
+ * The size granularity (in bytes) of the layer memory blocks a Packet keeps for re-use
+ */
+#define PCPP_LAYER_BLOCK_GRANULARITY 64
+
+/**
+ * The number of layer memory block sizes a Packet keeps for re-use. Layers larger than
+ * PCPP_LAYER_BLOCK_GRANULARITY * PCPP_LAYER_BLOCK_CACHE_BUCKETS bytes are always allocated on and freed to the heap.
+ * The limit is large enough for text-based-protocol layers (HTTP, SIP, SDP) which store their header fields inline
+ */
+#define PCPP_LAYER_BLOCK_CACHE_BUCKETS 16
+
 /**
  * \namespace pcpp
  * \brief The main namespace for the PcapPlusPlus lib
@@ -33,6 +45,11 @@ namespace pcpp
 		uint64_t m_ProtocolTypes;
 		size_t m_MaxPacketLen;
 		bool m_FreeRawPacket;
+		// the layer whose next layers weren't parsed yet in lazy parsing mode, NULL when all layers are parsed
+		Layer* m_LazyParseLayer;
+		// memory blocks of layers freed by this packet, kept for re-use when the packet is re-parsed. Each bucket is a singly
+		// linked list of blocks of the same size
+		void* m_LayerBlockCache[PCPP_LAYER_BLOCK_CACHE_BUCKETS];
 
 	public:
 
@@ -56,8 +73,14 @@ namespace pcpp
 		 * @param[in] parseUntilLayer Optional parameter. Parse the packet until you reach a certain layer in the OSI model (inclusive). Can be useful for cases when you need to
 		 * parse only up to a certain OSI layer (for example transport layer) and want to avoid the performance impact and memory consumption of parsing the whole packet.
 		 * Default value is ::OsiModelLayerUnknown which means don't take this parameter into account
+		 * @param[in] lazyParsing Optional parameter. If set to true only the layers up to the transport layer (TCP/UDP) are created
+		 * when the packet is parsed. The protocol of the layer above them is identified without creating it, so isPacketOfType()
+		 * answers without parsing the rest of the packet, and the remaining layers are created on first access to them (e.g by
+		 * Layer#getNextLayer(), getLastLayer(), or when the packet is edited). Can be useful when most packets are filtered by
+		 * their protocols or by their L3/L4 headers. This parameter is ignored if parseUntil or parseUntilLayer are set. Default
+		 * value is false
 		 */
-		Packet(RawPacket* rawPacket, bool freeRawPacket = false, ProtocolType parseUntil = UnknownProtocol, OsiModelLayer parseUntilLayer = OsiModelLayerUnknown);
+		Packet(RawPacket* rawPacket, bool freeRawPacket = false, ProtocolType parseUntil = UnknownProtocol, OsiModelLayer parseUntilLayer = OsiModelLayerUnknown, bool lazyParsing = false);
 
 		/**
 		 * A constructor for creating a packet out of already allocated RawPacket. Very useful when parsing packets that came from the network.
@@ -86,14 +109,14 @@ namespace pcpp
 		 * class, for example layers that were added by addLayer() or insertLayer() ). In addition it frees the raw packet if it was allocated by
 		 * this instance (meaning if it was allocated by this instance constructor)
 		 */
-		virtual ~Packet() { destructPacketData(); }
+		virtual ~Packet() { destructPacketData(false); clearLayerBlockCache(); }
 
 		/**
 		 * A copy constructor for this class. This copy constructor copies all the raw data and re-create all layers. So when the original Packet
 		 * is being freed, no data will be lost in the copied instance
 		 * @param[in] other The instance to copy from
 		 */
-		Packet(const Packet& other) { copyDataFrom(other); }
+		Packet(const Packet& other) { initLayerBlockCache(); copyDataFrom(other); }
 
 		/**
 		 * Assignment operator overloading. It first frees all layers allocated by this instance (Notice: it doesn't free layers that weren't allocated by this
@@ -111,15 +134,19 @@ namespace pcpp
 		RawPacket* getRawPacket() const { return m_RawPacket; }
 
 		/**
-		 * Set a RawPacket and re-construct all packet layers
+		 * Set a RawPacket and re-construct all packet layers. The memory of the layers previously created by this instance is recycled
+		 * for the new layers, so re-using the same Packet instance for parsing a stream of packets doesn't require heap allocations
+		 * for layers once it has parsed a packet of a similar structure
 		 * @param[in] rawPacket Raw packet to set
 		 * @param[in] freeRawPacket A flag indicating if the destructor should also call the raw packet destructor or not
 		 * @param[in] parseUntil Parse the packet until it reaches this protocol. Can be useful for cases when you need to parse only up to a certain layer and want to avoid the
 		 * performance impact and memory consumption of parsing the whole packet. Default value is ::UnknownProtocol which means don't take this parameter into account
 		 * @param[in] parseUntilLayer Parse the packet until certain layer in OSI model. Can be useful for cases when you need to parse only up to a certain layer and want to avoid the
 		 * performance impact and memory consumption of parsing the whole packet. Default value is ::OsiModelLayerUnknown which means don't take this parameter into account
+		 * @param[in] lazyParsing Parse the layers above the transport layer on first access to them. Please refer to Packet#Packet()
+		 * for more info. Default value is false
 		 */
-		void setRawPacket(RawPacket* rawPacket, bool freeRawPacket, ProtocolType parseUntil = UnknownProtocol, OsiModelLayer parseUntilLayer = OsiModelLayerUnknown);
+		void setRawPacket(RawPacket* rawPacket, bool freeRawPacket, ProtocolType parseUntil = UnknownProtocol, OsiModelLayer parseUntilLayer = OsiModelLayerUnknown, bool lazyParsing = false);
 
 		/**
 		 * Get a pointer to the Packet's RawPacket in a read-only manner
@@ -134,10 +161,16 @@ namespace pcpp
 		Layer* getFirstLayer() const { return m_FirstLayer; }
 
 		/**
-		 * Get a pointer to the last (highest) layer in the packet
+		 * Get a pointer to the last (highest) layer in the packet. If the packet was parsed lazily, all of its layers are created
+		 * by this call
 		 * @return A pointer to the last (highest) layer in the packet
 		 */
-		Layer* getLastLayer() const { return m_LastLayer; }
+		Layer* getLastLayer() const;
+
+		/**
+		 * @return False if the packet was parsed lazily and some of its layers weren't created yet, true otherwise
+		 */
+		bool areAllLayersParsed() const { return m_LazyParseLayer == NULL; }
 
 		/**
 		 * Add a new layer as the last layer in the packet. This method gets a pointer to the new layer as a parameter
@@ -148,7 +181,7 @@ namespace pcpp
 		 * @return True if everything went well or false otherwise (an appropriate error log message will be printed in
 		 * such cases)
 		 */
-		bool addLayer(Layer* newLayer, bool ownInPacket = false) { return insertLayer(m_LastLayer, newLayer, ownInPacket); }
+		bool addLayer(Layer* newLayer, bool ownInPacket = false) { return insertLayer(getLastLayer(), newLayer, ownInPacket); }
 
 		/**
 		 * Insert a new layer after an existing layer in the packet. This method gets a pointer to the new layer as a
@@ -244,7 +277,10 @@ namespace pcpp
 		Layer* getLayerOfType(ProtocolType layerType, int index = 0) const;
 
 		/**
-		 * A templated method to get a layer of a certain type (protocol). If no layer of such type is found, NULL is returned
+		 * A templated method to get a layer of a certain type (protocol). If no layer of such type is found, NULL is returned.
+		 * Layers are matched by the protocols the layer class is mapped to (see LayerProtocolTraits), so the lookup returns NULL
+		 * right away if the packet doesn't contain any of these protocols and otherwise compares protocol bits rather than
+		 * calling dynamic_cast on each layer. Layer classes that aren't mapped to protocols are matched using dynamic_cast
 		 * @param[in] reverseOrder The optional paramter that indicates that the lookup should run in reverse order, the default value is false
 		 * @return A pointer to the layer of the requested type, NULL if not found
 		 */
@@ -274,11 +310,15 @@ namespace pcpp
 		TLayer* getPrevLayerOfType(Layer* startLayer) const;
 
 		/**
-		 * Check whether the packet contains a certain protocol
+		 * Check whether the packet contains a certain protocol. If the packet was parsed lazily, the remaining layers are created
+		 * only if the protocol can't be determined without them
 		 * @param[in] protocolType The protocol type to search
 		 * @return True if the packet contains the protocol, false otherwise
 		 */
-		bool isPacketOfType(ProtocolType protocolType) const { return m_ProtocolTypes & protocolType; }
+		bool isPacketOfType(ProtocolType protocolType) const
+		{
+			return (m_ProtocolTypes & protocolType) != 0 || (m_LazyParseLayer != NULL && isUnparsedLayerOfType(protocolType));
+		}
 
 		/**
 		 * Each layer can have fields that can be calculate automatically from other fields using Layer#computeCalculateFields(). This method forces all layers to calculate these
@@ -304,7 +344,7 @@ namespace pcpp
 	private:
 		void copyDataFrom(const Packet& other);
 
-		void destructPacketData();
+		void destructPacketData(bool recycleLayers = true);
 
 		bool extendLayer(Layer* layer, int offsetInLayer, size_t numOfBytesToExtend);
 		bool shortenLayer(Layer* layer, int offsetInLayer, size_t numOfBytesToShorten);
@@ -316,27 +356,62 @@ namespace pcpp
 		std::string printPacketInfo(bool timeAsLocalTime) const;
 
 		Layer* createFirstLayer(LinkLayerType linkType);
+
+		template<class TLayer>
+		static bool isLayerOfType(Layer* layer);
+		Layer* getLastLayerForLookup(ProtocolType protocolType) const;
+
+		int getPacketTrailerLen() const;
+		void createPacketTrailerLayer();
+
+		bool deferNextLayers(Layer* layer);
+		void parseRemainingLayers();
+		bool isUnparsedLayerOfType(ProtocolType protocolType) const;
+
+		void initLayerBlockCache();
+		void clearLayerBlockCache();
+		void recycleLayer(Layer* layer);
 	}; // class Packet
 
 
 	// implementation of inline methods
 
+	template<class TLayer>
+	bool Packet::isLayerOfType(Layer* layer)
+	{
+		if (layer == NULL)
+			return false;
+
+		if (LayerProtocolTraits<TLayer>::Protocol == UnknownProtocol)
+			return dynamic_cast<TLayer*>(layer) != NULL;
+
+		if ((layer->getProtocol() & LayerProtocolTraits<TLayer>::Protocol) == 0)
+			return false;
+
+		return LayerProtocolTraits<TLayer>::IsExact || dynamic_cast<TLayer*>(layer) != NULL;
+	}
+
 	template<class TLayer>
 	TLayer* Packet::getLayerOfType(bool reverse) const
 	{
+		// the packet doesn't contain any of the protocols of this layer class
+		if (LayerProtocolTraits<TLayer>::Protocol != UnknownProtocol && !isPacketOfType(LayerProtocolTraits<TLayer>::Protocol))
+			return NULL;
+
 		if (!reverse)
 		{
-			if (dynamic_cast<TLayer*>(getFirstLayer()) != NULL)
+			if (isLayerOfType<TLayer>(getFirstLayer()))
 				return (TLayer*)getFirstLayer();
 
 			return getNextLayerOfType<TLayer>(getFirstLayer());
 		}
 
 		// lookup in reverse order
-		if (dynamic_cast<TLayer*>(getLastLayer()) != NULL)
-			return (TLayer*)getLastLayer();
+		Layer* lastLayer = getLastLayerForLookup(LayerProtocolTraits<TLayer>::Protocol);
+		if (isLayerOfType<TLayer>(lastLayer))
+			return (TLayer*)lastLayer;
 
-		return getPrevLayerOfType<TLayer>(getLastLayer());
+		return getPrevLayerOfType<TLayer>(lastLayer);
 	}
 
 	template<class TLayer>
@@ -346,7 +421,7 @@ namespace pcpp
 			return NULL;
 
 		curLayer = curLayer->getNextLayer();
-		while ((curLayer != NULL) && (dynamic_cast<TLayer*>(curLayer) == NULL))
+		while ((curLayer != NULL) && !isLayerOfType<TLayer>(curLayer))
 		{
 			curLayer = curLayer->getNextLayer();
 		}
@@ -361,7 +436,7 @@ namespace pcpp
 			return NULL;
 
 		curLayer = curLayer->getPrevLayer();
-		while (curLayer != NULL && dynamic_cast<TLayer*>(curLayer) == NULL)
+		while (curLayer != NULL && !isLayerOfType<TLayer>(curLayer))
 		{
 			curLayer = curLayer->getPrevLayer();
 		}
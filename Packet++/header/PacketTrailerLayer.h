@@ -79,6 +79,8 @@ namespace pcpp
 		OsiModelLayer getOsiModelLayer() const { return OsiModelDataLinkLayer; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(PacketTrailerLayer, PacketTrailer, true);
+
 }
 
 #endif // PACKETPP_PACKET_TRAILER_LAYER
@@ -29,6 +29,30 @@ namespace pcpp
 	 */
 	uint32_t hash2Tuple(Packet* packet);
 
+	/**
+	 * A method that calculates a hash value by the 5-tuple of a packet directly from its raw data, without parsing it into a Packet
+	 * object. It's meant for dispatching packets to worker threads before parsing them (software RSS). Ethernet, Linux cooked capture
+	 * (SLL), BSD loopback (Null) and raw IP link layers are supported. VLAN tags (including 802.1ad QinQ), MPLS labels and PPPoE session
+	 * headers between the link layer and the IP layer are skipped, and so are IPv6 extension headers.<BR>
+	 * The hash is a CRC32C of the IP addresses, TCP/UDP ports and protocol, taken in a canonical order so both directions of a connection
+	 * get the same value. IP fragments, and IP packets which aren't TCP or UDP, are hashed by their IP addresses only, so all fragments of
+	 * a packet get the same value. Notice the value is different than the one returned by hash5Tuple() for the same packet
+	 * @param[in] data A pointer to the packet raw data
+	 * @param[in] dataLen The raw data length in bytes
+	 * @param[in] linkType The link layer type of the packet. The default value is Ethernet
+	 * @return The hash value calculated for this packet or 0 if the packet isn't IPv4/6, its link layer type isn't supported or it's
+	 * too short
+	 */
+	uint32_t fastHash5Tuple(const uint8_t* data, size_t dataLen, LinkLayerType linkType = LINKTYPE_ETHERNET);
+
+	/**
+	 * A method that calculates a hash value by the 5-tuple of a raw packet without parsing it. See
+	 * fastHash5Tuple(const uint8_t*, size_t, LinkLayerType) for more details
+	 * @param[in] rawPacket The raw packet to calculate hash for
+	 * @return The hash value calculated for this packet or 0 if the packet isn't IPv4/6
+	 */
+	uint32_t fastHash5Tuple(const RawPacket* rawPacket);
+
 } // namespace pcpp
 
 #endif /* PACKETPP_PACKET_UTILS */
@@ -89,6 +89,8 @@ namespace pcpp
 
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(PayloadLayer, GenericPayload, true);
+
 } // namespace pcpp
 
 #endif /* PACKETPP_PAYLOAD_LAYER */
@@ -0,0 +1,318 @@
+#ifndef PACKETPP_PAYLOAD_MATCHER
+#define PACKETPP_PAYLOAD_MATCHER
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <map>
+
+/**
+ * @file
+ * This file includes pcpp#PayloadMatcher, a multi-pattern matcher which searches packet payloads for many byte patterns at once, and
+ * pcpp#TcpStreamMatcher, which uses it to search the reassembled streams of pcpp#TcpReassembly.<BR>
+ *
+ * The logic works as follows:
+ * - Patterns are added with pcpp#PayloadMatcher#addPattern() and then pcpp#PayloadMatcher#compile() builds an Aho-Corasick automaton
+ *   out of them. The automaton is a DFA: each state has a transition for each input byte, so every byte of the payload is handled by a
+ *   single table lookup no matter how many patterns there are. To keep the table small the bytes are mapped to classes first: all bytes
+ *   that don't appear in any pattern share the same class
+ * - While the automaton is in its initial state only bytes that start a pattern can change the state, so the payload is first scanned
+ *   for such bytes (a prefilter). When the patterns start with only a few distinct bytes the scan is done with SSE2 instructions 16 bytes
+ *   at a time. SSE2 is used when the compiler targets it (always on x86-64). On 32-bit x86 builds without SSE2 enabled it's checked at
+ *   runtime, and without SSE2 a single start byte is searched with memchr() and several start bytes with a lookup table
+ * - The automaton can be stopped at the end of a buffer and resumed on the next buffer (see pcpp#PayloadMatcher#StreamState), so patterns
+ *   are found even when they are split between TCP segments
+ * - Once compiled the matcher isn't changed by matching, so a single matcher can be used by multiple threads at the same time as long as
+ *   each thread uses its own stream states
+ */
+
+/**
+ * The max number of distinct first bytes of the patterns for which the SIMD prefilter is used. When the patterns start with more distinct
+ * bytes the prefilter uses a lookup table instead
+ */
+#define PCPP_PAYLOAD_MATCHER_MAX_SIMD_PREFILTER_BYTES 4
+
+/**
+ * \namespace pcpp
+ * \brief The main namespace for the PcapPlusPlus lib
+ */
+namespace pcpp
+{
+
+	class Packet;
+	class TcpStreamData;
+
+	/**
+	 * @class PayloadMatcher
+	 * A multi-pattern matcher based on the Aho-Corasick algorithm. It finds all occurrences of a set of byte patterns in raw data, in the
+	 * payload of a packet or in a stream of data which arrives in several buffers. Please refer to the documentation at the top of
+	 * PayloadMatcher.h for details. For example:
+	 *
+	 * @code
+	 * pcpp::PayloadMatcher matcher;
+	 * matcher.addPattern("evil.com");
+	 * matcher.addPattern("/etc/passwd");
+	 * matcher.compile();
+	 * ...
+	 * if (matcher.matchPacket(packet))
+	 *     printf("Found a packet which contains one of the patterns\n");
+	 * @endcode
+	 */
+	class PayloadMatcher
+	{
+	public:
+
+		/**
+		 * @class StreamState
+		 * The state of matching a stream of data, used to search data which arrives in several buffers (for example the payloads of the
+		 * TCP segments of a connection) as if it was one continuous buffer. Each stream needs its own state
+		 */
+		class StreamState
+		{
+			friend class PayloadMatcher;
+
+		public:
+
+			/**
+			 * A c'tor for this class that creates a state at the beginning of a stream
+			 */
+			StreamState() : m_State(0), m_Offset(0) {}
+
+			/**
+			 * Move back to the beginning of a stream, so the data already matched has no effect on the data matched next
+			 */
+			void reset() { m_State = 0; m_Offset = 0; }
+
+			/**
+			 * Skip bytes of the stream which aren't available (for example missing TCP data). No pattern is matched across the skipped
+			 * bytes, and the offset is advanced by their number
+			 * @param[in] numOfBytes The number of bytes to skip
+			 */
+			void skip(uint64_t numOfBytes) { m_State = 0; m_Offset += numOfBytes; }
+
+			/**
+			 * @return The number of bytes of the stream matched so far
+			 */
+			uint64_t getOffset() const { return m_Offset; }
+
+		private:
+			uint32_t m_State;
+			uint64_t m_Offset;
+		};
+
+		/**
+		 * @typedef OnPatternMatch
+		 * A callback that is called for each pattern occurrence that was found
+		 * @param[in] patternId The ID of the pattern, as returned from addPattern()
+		 * @param[in] endOffset The offset right after the last byte of the occurrence. When searching a stream the offset is from the
+		 * beginning of the stream, otherwise from the beginning of the searched data
+		 * @param[in] userCookie A pointer to the object set by the user when the search started
+		 * @return True to continue searching or false to stop the search
+		 */
+		typedef bool (*OnPatternMatch)(int patternId, uint64_t endOffset, void* userCookie);
+
+		/**
+		 * A c'tor for this class that creates a matcher without patterns
+		 * @param[in] caseInsensitive If set to true ASCII letters in the patterns match both their lowercase and uppercase forms. Default
+		 * value is false
+		 */
+		explicit PayloadMatcher(bool caseInsensitive = false);
+
+		/**
+		 * Add a pattern to search. Patterns can be added only before compile() is called
+		 * @param[in] pattern A pointer to the pattern bytes
+		 * @param[in] patternLen The pattern length
+		 * @return The ID of the pattern, which is the number of patterns added before it, or -1 if the pattern is empty or the matcher is
+		 * already compiled
+		 */
+		int addPattern(const uint8_t* pattern, size_t patternLen);
+
+		/**
+		 * Add a pattern to search. Patterns can be added only before compile() is called
+		 * @param[in] pattern The pattern
+		 * @return The ID of the pattern, which is the number of patterns added before it, or -1 if the pattern is empty or the matcher is
+		 * already compiled
+		 */
+		int addPattern(const std::string& pattern) { return addPattern((const uint8_t*)pattern.data(), pattern.length()); }
+
+		/**
+		 * Build the automaton out of the patterns added so far. The matcher can be used for searching only after it's compiled
+		 * @return True if the automaton was built or false if no patterns were added or the matcher is already compiled
+		 */
+		bool compile();
+
+		/**
+		 * @return True if compile() was called successfully, false otherwise
+		 */
+		bool isCompiled() const { return m_IsCompiled; }
+
+		/**
+		 * @return True if the matcher was created as case-insensitive, false otherwise
+		 */
+		bool isCaseInsensitive() const { return m_CaseInsensitive; }
+
+		/**
+		 * @return The number of patterns added to the matcher
+		 */
+		size_t getNumOfPatterns() const { return m_PatternLengths.size(); }
+
+		/**
+		 * @param[in] patternId The ID of the pattern
+		 * @return The length of the pattern or 0 if there is no pattern with this ID
+		 */
+		size_t getPatternLength(int patternId) const;
+
+		/**
+		 * @return The number of states of the automaton or 0 if the matcher isn't compiled
+		 */
+		size_t getNumOfStates() const { return m_NumOfStates; }
+
+		/**
+		 * Check whether data contains any of the patterns. The search stops at the first occurrence found
+		 * @param[in] data A pointer to the data
+		 * @param[in] dataLen The data length
+		 * @return True if the data contains any of the patterns, false otherwise or if the matcher isn't compiled
+		 */
+		bool matchAny(const uint8_t* data, size_t dataLen) const;
+
+		/**
+		 * Find all occurrences of the patterns in data
+		 * @param[in] data A pointer to the data
+		 * @param[in] dataLen The data length
+		 * @param[in] onMatch A callback that is called for each occurrence found. Can be NULL if only the number of occurrences is needed
+		 * @param[in] userCookie A pointer to an object that is passed to the callback
+		 * @return The number of occurrences found (up to the one the callback stopped the search at)
+		 */
+		size_t findMatches(const uint8_t* data, size_t dataLen, OnPatternMatch onMatch = NULL, void* userCookie = NULL) const;
+
+		/**
+		 * Find all occurrences of the patterns in the next buffer of a stream, including occurrences that started in previous buffers
+		 * @param[in,out] state The state of the stream. It's updated so the next buffer of the stream can be searched with it
+		 * @param[in] data A pointer to the data
+		 * @param[in] dataLen The data length
+		 * @param[in] onMatch A callback that is called for each occurrence found. Can be NULL if only the number of occurrences is needed
+		 * @param[in] userCookie A pointer to an object that is passed to the callback
+		 * @return The number of occurrences found in this buffer (up to the one the callback stopped the search at). If the search was
+		 * stopped by the callback the state is updated up to the end of that occurrence
+		 */
+		size_t findMatches(StreamState& state, const uint8_t* data, size_t dataLen, OnPatternMatch onMatch = NULL, void* userCookie = NULL) const;
+
+		/**
+		 * Check whether the payload of a packet contains any of the patterns. The payload is the data following the TCP or UDP layer, or
+		 * if there isn't one the data of the first PayloadLayer. The packet can be parsed only up to the transport layer
+		 * @param[in] packet The packet to search
+		 * @return True if the payload contains any of the patterns, false otherwise
+		 */
+		bool matchPacket(Packet& packet) const;
+
+		/**
+		 * Find all occurrences of the patterns in the payload of a packet. Please refer to matchPacket() for the payload definition
+		 * @param[in] packet The packet to search
+		 * @param[in] onMatch A callback that is called for each occurrence found. Can be NULL if only the number of occurrences is needed
+		 * @param[in] userCookie A pointer to an object that is passed to the callback
+		 * @return The number of occurrences found
+		 */
+		size_t findMatches(Packet& packet, OnPatternMatch onMatch = NULL, void* userCookie = NULL) const;
+
+	private:
+		bool m_CaseInsensitive;
+		bool m_IsCompiled;
+
+		// the patterns until compile() is called
+		std::vector<uint8_t> m_PatternBytes;
+		std::vector<size_t> m_PatternOffsets;
+		std::vector<size_t> m_PatternLengths;
+
+		// the automaton: the class of each byte and the transition table, with a row of m_NumOfClasses next states for each state. A
+		// transition to a state that has outputs is marked with a flag so outputs are looked up only when there are any
+		uint16_t m_ByteClasses[256];
+		size_t m_NumOfClasses;
+		size_t m_NumOfStates;
+		std::vector<uint32_t> m_Transitions;
+
+		// the IDs of the patterns that end in each state, including patterns that end in the state's suffixes. The patterns of state i are
+		// m_OutputPatterns[m_OutputOffsets[i]] ... m_OutputPatterns[m_OutputOffsets[i+1]-1]
+		std::vector<uint32_t> m_OutputOffsets;
+		std::vector<int> m_OutputPatterns;
+
+		// the prefilter: the bytes that move the automaton out of its initial state
+		bool m_IsStartByte[256];
+		uint8_t m_SimdPrefilterBytes[PCPP_PAYLOAD_MATCHER_MAX_SIMD_PREFILTER_BYTES];
+		size_t m_NumOfSimdPrefilterBytes;
+
+		size_t findNextStartByte(const uint8_t* data, size_t pos, size_t dataLen) const;
+		size_t search(StreamState& state, const uint8_t* data, size_t dataLen, OnPatternMatch onMatch, void* userCookie, bool stopAtFirst) const;
+		static bool getPacketPayload(Packet& packet, const uint8_t*& payload, size_t& payloadLen);
+	};
+
+
+	/**
+	 * @class TcpStreamMatcher
+	 * Searches the reassembled data of TCP connections (as delivered by pcpp#TcpReassembly) using a pcpp#PayloadMatcher. It keeps a
+	 * stream state for each side of each connection, so patterns are found even when they are split between TCP segments. It's meant to
+	 * be called from the TcpReassembly callbacks, for example:
+	 *
+	 * @code
+	 * void onMessageReady(int side, const pcpp::TcpStreamData& tcpData, void* userCookie)
+	 * {
+	 *     pcpp::TcpStreamMatcher* streamMatcher = (pcpp::TcpStreamMatcher*)userCookie;
+	 *     if (streamMatcher->findMatches(side, tcpData) > 0)
+	 *         ...
+	 * }
+	 *
+	 * void onConnectionEnd(const pcpp::ConnectionData& connectionData, pcpp::TcpReassembly::ConnectionEndReason reason, void* userCookie)
+	 * {
+	 *     ((pcpp::TcpStreamMatcher*)userCookie)->removeConnection(connectionData.flowKey);
+	 * }
+	 * @endcode
+	 *
+	 * When TcpReassembly gives up on missing data it adds a "[X bytes missing]" text to the data it delivers. This text isn't searched,
+	 * the missing bytes are skipped instead (see StreamState#skip()), so no pattern matches the text or spans the gap
+	 */
+	class TcpStreamMatcher
+	{
+	public:
+
+		/**
+		 * A c'tor for this class
+		 * @param[in] matcher A compiled matcher to search the streams with. It isn't copied so it must remain valid as long as this
+		 * instance is used
+		 */
+		explicit TcpStreamMatcher(const PayloadMatcher& matcher) : m_Matcher(matcher) {}
+
+		/**
+		 * Search the next piece of data of a connection side
+		 * @param[in] side The side of the connection the data was sent from (0 or 1), as given to the TcpReassembly callback
+		 * @param[in] tcpData The data, as given to the TcpReassembly callback
+		 * @param[in] onMatch A callback that is called for each occurrence found. The offsets it gets are from the beginning of the stream
+		 * of this connection side. Can be NULL if only the number of occurrences is needed
+		 * @param[in] userCookie A pointer to an object that is passed to the callback
+		 * @return The number of occurrences found in this piece of data, or 0 if side isn't 0 or 1
+		 */
+		size_t findMatches(int side, const TcpStreamData& tcpData, PayloadMatcher::OnPatternMatch onMatch = NULL, void* userCookie = NULL);
+
+		/**
+		 * Remove the stream states of a connection. Should be called when the connection ends
+		 * @param[in] flowKey The flow key of the connection (ConnectionData#flowKey)
+		 */
+		void removeConnection(uint32_t flowKey) { m_Connections.erase(flowKey); }
+
+		/**
+		 * @return The number of connections whose stream states are kept
+		 */
+		size_t getNumOfConnections() const { return m_Connections.size(); }
+
+	private:
+		struct ConnectionStreamStates
+		{
+			PayloadMatcher::StreamState sides[2];
+		};
+
+		const PayloadMatcher& m_Matcher;
+		std::map<uint32_t, ConnectionStreamStates> m_Connections;
+	};
+
+} // namespace pcpp
+
+#endif /* PACKETPP_PAYLOAD_MATCHER */
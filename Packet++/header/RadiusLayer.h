@@ -328,6 +328,8 @@ namespace pcpp
 		OsiModelLayer getOsiModelLayer() const { return OsiModelSesionLayer; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(RadiusLayer, Radius, true);
+
 
 	// implementation of inline methods
 
@@ -279,8 +279,8 @@ namespace pcpp
 
 		/**
 		 * Assignment operator overload for this class. When using this operator on an already initialized RawPacket instance,
-		 * the original raw data is freed first. Then the other instance is copied to this instance, the same way the copy constructor works
-		 * @todo free raw data only if deleteRawDataAtDestructor was set to 'true'
+		 * the original raw data is freed first (only if deleteRawDataAtDestructor was set to 'true'). Then the other instance is copied to this
+		 * instance, the same way the copy constructor works
 		 * @param[in] other The instance to copy from
 		 */
 		RawPacket& operator=(const RawPacket& other);
@@ -314,6 +314,22 @@ namespace pcpp
 		 */
 		virtual bool setRawData(const uint8_t* pRawData, int rawDataLen, timespec timestamp, LinkLayerType layerType = LINKTYPE_ETHERNET, int frameLength = -1);
 
+		/**
+		 * Initialize the instance with new raw data and set whether this instance owns it. Current raw data is freed first if
+		 * deleteRawDataAtDestructor was set to 'true'. Unlike setRawData(), this method can be used to re-use the same instance for data
+		 * that is owned by someone else (for example a read buffer of a file device) without copying it
+		 * @param[in] pRawData A pointer to the new raw data
+		 * @param[in] rawDataLen The new raw data length in bytes
+		 * @param[in] timestamp The timestamp packet was received by the NIC (in nsec precision)
+		 * @param[in] deleteRawDataAtDestructor An indicator whether the new raw data should be freed when the instance is freed, cleared or
+		 * set with other data
+		 * @param[in] layerType The link layer type for this raw data
+		 * @param[in] frameLength The original packet length, see setRawData(). This parameter is optional, if not set or set to -1 it is
+		 * assumed to be equal to rawDataLen
+		 * @return True if raw data was set successfully, false otherwise
+		 */
+		bool initWithRawData(const uint8_t* pRawData, int rawDataLen, timespec timestamp, bool deleteRawDataAtDestructor, LinkLayerType layerType = LINKTYPE_ETHERNET, int frameLength = -1);
+
 		/**
 		 * Get raw data pointer
 		 * @return A read-only pointer to the raw data
@@ -373,9 +389,8 @@ namespace pcpp
 		bool isPacketSet() const { return m_RawPacketSet; }
 
 		/**
-		 * Clears all members of this instance, meaning setting raw data to NULL, raw data length to 0, etc. Currently raw data is always freed,
-		 * even if deleteRawDataAtDestructor was set to 'false'
-		 * @todo deleteRawDataAtDestructor was set to 'true', don't free the raw data
+		 * Clears all members of this instance, meaning setting raw data to NULL, raw data length to 0, etc. Raw data is freed only if
+		 * deleteRawDataAtDestructor was set to 'true'
 		 * @todo set timestamp to a default value as well
 		 */
 		virtual void clear();
@@ -0,0 +1,146 @@
+#ifndef PACKETPP_SSL_FINGERPRINT
+#define PACKETPP_SSL_FINGERPRINT
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include "SSLCommon.h"
+
+/**
+ * @file
+ * See detailed explanation of the TLS/SSL protocol support in PcapPlusPlus in SSLLayer.h
+ */
+
+/**
+ * The length in bytes of the MD5 digest of a JA3/JA3S fingerprint
+ */
+#define PCPP_SSL_FINGERPRINT_DIGEST_LEN 16
+
+/**
+ * \namespace pcpp
+ * \brief The main namespace for the PcapPlusPlus lib
+ */
+namespace pcpp
+{
+
+class SSLHelloReader;
+class RawPacket;
+
+/**
+ * @class SSLFingerprint
+ * Computes the JA3 fingerprint of a client-hello message or the JA3S fingerprint of a server-hello message. The
+ * fingerprint string is made of the decimal values of the message fields, where values of the same field are separated
+ * by '-' and fields are separated by ',':
+ * - JA3: SSLVersion,Ciphers,Extensions,EllipticCurves,EllipticCurvePointFormats
+ * - JA3S: SSLVersion,Cipher,Extensions
+ *
+ * GREASE values (RFC 8701) are skipped, and the fingerprint is the MD5 digest of the fingerprint string. The fields are
+ * read in place by SSLHelloReader and the string is fed to the MD5 calculation while it's being formatted, so computing
+ * a fingerprint doesn't create any extension objects or strings. The fingerprint string itself is written only if the
+ * user supplies a buffer for it. For example:
+ *
+ * @code
+ * pcpp::SSLFingerprint fingerprint;
+ * if (fingerprint.computeFromRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayloadSize()) && fingerprint.isJA3())
+ *     printf("JA3: %s\n", fingerprint.getDigestString().c_str());
+ * @endcode
+ */
+class SSLFingerprint
+{
+public:
+
+	/**
+	 * A c'tor for this class that creates an invalid fingerprint. Use one of the compute methods to compute it
+	 */
+	SSLFingerprint();
+
+	/**
+	 * Compute the fingerprint of a message that was parsed by an SSLHelloReader: JA3 for a client-hello and JA3S for
+	 * a server-hello
+	 * @param[in] reader The reader that parsed the message
+	 * @param[out] fingerprintStr An optional buffer to write the fingerprint string to. The string is null-terminated
+	 * and is truncated if the buffer is too small (getStringLength() returns the full length)
+	 * @param[in] fingerprintStrLen The size of the buffer in bytes
+	 * @return True if the fingerprint was computed or false if the reader didn't parse a message successfully
+	 */
+	bool compute(const SSLHelloReader& reader, char* fingerprintStr = NULL, size_t fingerprintStrLen = 0);
+
+	/**
+	 * Compute the fingerprint of the first client-hello or server-hello message of an SSL/TLS handshake record
+	 * @param[in] data A pointer to the record data, starting with the record header (ssl_tls_record_layer). Usually
+	 * the payload of a TCP layer
+	 * @param[in] dataLen The length of the data
+	 * @param[out] fingerprintStr An optional buffer to write the fingerprint string to. Please refer to compute()
+	 * @param[in] fingerprintStrLen The size of the buffer in bytes
+	 * @return True if the data is an SSL/TLS handshake record that contains a client-hello or server-hello message
+	 * and its fingerprint was computed, false otherwise
+	 */
+	bool computeFromRecord(const uint8_t* data, size_t dataLen, char* fingerprintStr = NULL, size_t fingerprintStrLen = 0);
+
+	/**
+	 * Compute the fingerprints of a batch of packets. Each packet is parsed up to its TCP layer (a single Packet
+	 * instance is reused for the whole batch) and the fingerprint of the TCP payload is computed as in
+	 * computeFromRecord(). Packets that aren't TCP or whose payload isn't a client-hello or server-hello get an
+	 * invalid fingerprint
+	 * @param[in] rawPackets An array of the packets
+	 * @param[in] count The number of packets in the array
+	 * @param[out] results An array of at least count fingerprints. The fingerprint of rawPackets[i] is written to
+	 * results[i]
+	 * @return The number of valid fingerprints that were computed
+	 */
+	static size_t computeBatch(RawPacket* const* rawPackets, size_t count, SSLFingerprint* results);
+
+	/**
+	 * @return True if the fingerprint was computed successfully, false otherwise
+	 */
+	bool isValid() const { return m_HandshakeType != SSL_HANDSHAKE_UNKNOWN; }
+
+	/**
+	 * @return True if this is a JA3 fingerprint (of a client-hello message), false otherwise
+	 */
+	bool isJA3() const { return m_HandshakeType == SSL_CLIENT_HELLO; }
+
+	/**
+	 * @return True if this is a JA3S fingerprint (of a server-hello message), false otherwise
+	 */
+	bool isJA3S() const { return m_HandshakeType == SSL_SERVER_HELLO; }
+
+	/**
+	 * @return The length of the fingerprint string (not including the terminating '\0') or 0 if the fingerprint isn't
+	 * valid
+	 */
+	size_t getStringLength() const { return m_StringLength; }
+
+	/**
+	 * @return A pointer to the MD5 digest of the fingerprint, which is PCPP_SSL_FINGERPRINT_DIGEST_LEN bytes long. The
+	 * digest is all zeros if the fingerprint isn't valid
+	 */
+	const uint8_t* getDigest() const { return m_Digest; }
+
+	/**
+	 * @return The MD5 digest of the fingerprint as a hex string (the format JA3 fingerprints are usually shown in), or
+	 * an empty string if the fingerprint isn't valid
+	 */
+	std::string getDigestString() const;
+
+	/**
+	 * @return True if both fingerprints are of the same type and have the same digest
+	 */
+	bool operator==(const SSLFingerprint& other) const;
+
+	/**
+	 * @return True if the fingerprints are of different types or have different digests
+	 */
+	bool operator!=(const SSLFingerprint& other) const { return !(*this == other); }
+
+private:
+	SSLHandshakeType m_HandshakeType;
+	size_t m_StringLength;
+	uint8_t m_Digest[PCPP_SSL_FINGERPRINT_DIGEST_LEN];
+
+	void clear();
+};
+
+} // namespace pcpp
+
+#endif /* PACKETPP_SSL_FINGERPRINT */
@@ -298,7 +298,8 @@ protected:
 /**
  * @class SSLClientHelloMessage
  * Represents a client-hello message (type 1). Inherits from SSLHandshakeMessage and adds parsing of all fields
- * of this message including the message extensions, cipher-suite list, etc.
+ * of this message including the message extensions, cipher-suite list, etc. The extensions are parsed only when
+ * first accessed, so a message whose extensions aren't needed doesn't allocate an object per extension
  */
 class SSLClientHelloMessage : public SSLHandshakeMessage
 {
@@ -351,6 +352,15 @@ public:
 	 */
 	SSLCipherSuite* getCipherSuite(int index) const;
 
+	/**
+	 * Get the numeric ID of a cipher-suite by index. Unlike getCipherSuite() this method doesn't look the cipher-suite
+	 * up, so it also works for cipher-suites PcapPlusPlus doesn't know (such as GREASE values)
+	 * @param[in] index The index of the cipher-suite to return
+	 * @param[out] isValid Set to false if index is out of bounds or the cipher-suite exceeds the message, true otherwise
+	 * @return The cipher-suite ID or 0 if isValid is false
+	 */
+	uint16_t getCipherSuiteID(int index, bool& isValid) const;
+
 	/**
 	 * @return The value of the compression method byte
 	 */
@@ -405,15 +415,18 @@ public:
 	std::string toString() const;
 
 private:
-	PointerVector<SSLExtension> m_ExtensionList;
+	mutable PointerVector<SSLExtension> m_ExtensionList;
+	mutable bool m_ExtensionsParsed;
 
+	void parseExtensions() const;
 };
 
 
 /**
  * @class SSLServerHelloMessage
  * Represents SSL/TLS server-hello message (type 2). Inherits from SSLHandshakeMessage and adds parsing of all fields
- * of this message including the message extensions, cipher-suite, etc.
+ * of this message including the message extensions, cipher-suite, etc. The extensions are parsed only when first
+ * accessed
  */
 class SSLServerHelloMessage : public SSLHandshakeMessage
 {
@@ -458,6 +471,14 @@ public:
 	 */
 	SSLCipherSuite* getCipherSuite() const;
 
+	/**
+	 * Get the numeric ID of the cipher-suite encapsulated in this message. Unlike getCipherSuite() this method doesn't
+	 * look the cipher-suite up, so it also works for cipher-suites PcapPlusPlus doesn't know
+	 * @param[out] isValid Set to false if the cipher-suite exceeds the message, true otherwise
+	 * @return The cipher-suite ID or 0 if isValid is false
+	 */
+	uint16_t getCipherSuiteID(bool& isValid) const;
+
 	/**
 	 * @return The value of the compression method byte
 	 */
@@ -512,7 +533,10 @@ public:
 	std::string toString() const;
 
 private:
-	PointerVector<SSLExtension> m_ExtensionList;
+	mutable PointerVector<SSLExtension> m_ExtensionList;
+	mutable bool m_ExtensionsParsed;
+
+	void parseExtensions() const;
 };
 
 
@@ -522,7 +546,7 @@ private:
  * such as extracting the certificates data. Notice that in most cases this message is spread over more than 1 packet
  * as its size is too big for a single packet. So SSLCertificateMessage instance will be created just for the first
  * part of the message - the one encapsulated in the first packet. Other parts (encapsulated in the following packets)
- * won't be recognized as SSLCertificateMessage messages
+ * won't be recognized as SSLCertificateMessage messages. The certificates are parsed only when first accessed
  */
 class SSLCertificateMessage : public SSLHandshakeMessage
 {
@@ -561,7 +585,10 @@ public:
 	std::string toString() const;
 
 private:
-	PointerVector<SSLx509Certificate> m_CertificateList;
+	mutable PointerVector<SSLx509Certificate> m_CertificateList;
+	mutable bool m_CertificatesParsed;
+
+	void parseCertificates() const;
 };
 
 
@@ -916,6 +943,7 @@ public:
 template<class TExtension>
 TExtension* SSLClientHelloMessage::getExtensionOfType() const
 {
+	parseExtensions();
 	size_t vecSize = m_ExtensionList.size();
 	for (size_t i = 0; i < vecSize; i++)
 	{
@@ -930,6 +958,7 @@ TExtension* SSLClientHelloMessage::getExtensionOfType() const
 template<class TExtension>
 TExtension* SSLServerHelloMessage::getExtensionOfType() const
 {
+	parseExtensions();
 	size_t vecSize = m_ExtensionList.size();
 	for (size_t i = 0; i < vecSize; i++)
 	{
@@ -0,0 +1,149 @@
+#ifndef PACKETPP_SSL_HELLO_READER
+#define PACKETPP_SSL_HELLO_READER
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SSLCommon.h"
+
+/**
+ * @file
+ * See detailed explanation of the TLS/SSL protocol support in PcapPlusPlus in SSLLayer.h
+ */
+
+/**
+ * \namespace pcpp
+ * \brief The main namespace for the PcapPlusPlus lib
+ */
+namespace pcpp
+{
+
+/**
+ * @class SSLHelloReader
+ * A fast-path reader of client-hello and server-hello messages which works directly on the raw message bytes. Unlike
+ * SSLHandshakeLayer, SSLClientHelloMessage and SSLServerHelloMessage it doesn't create any objects: parsing locates the
+ * cipher-suite list and the extensions block, and the cipher-suites, the extensions and the server name (SNI) are
+ * then read in place. This makes it suitable for pipelines that only need the SNI or the values used for TLS
+ * fingerprinting (such as JA3) of every connection. The reader can work on the data of an SSLHandshakeLayer but also
+ * directly on a TCP payload, so the packet can be parsed only up to the TCP layer. For example:
+ *
+ * @code
+ * pcpp::SSLHelloReader reader;
+ * if (reader.parseRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayloadSize()) &&
+ *         reader.getHandshakeType() == pcpp::SSL_CLIENT_HELLO)
+ * {
+ *     size_t serverNameLen = 0;
+ *     const char* serverName = reader.getServerName(serverNameLen);
+ *     ...
+ * }
+ * @endcode
+ *
+ * The reader points to the data it parsed, so the data must remain valid as long as the reader is used
+ */
+class SSLHelloReader
+{
+public:
+
+	/**
+	 * A c'tor for this class that creates a reader which didn't parse any message yet
+	 */
+	SSLHelloReader();
+
+	/**
+	 * Parse a client-hello or server-hello message
+	 * @param[in] data A pointer to the message data, starting with the handshake message header (ssl_tls_handshake_layer)
+	 * @param[in] dataLen The length of the data. If it's shorter than the message length (meaning the message is split
+	 * over several packets) the message is parsed up to the end of the data
+	 * @return True if the data contains a client-hello or server-hello message whose fields up to the extensions block
+	 * are complete, false otherwise
+	 */
+	bool parse(const uint8_t* data, size_t dataLen);
+
+	/**
+	 * Parse the first client-hello or server-hello message of an SSL/TLS handshake record
+	 * @param[in] data A pointer to the record data, starting with the record header (ssl_tls_record_layer)
+	 * @param[in] dataLen The length of the data
+	 * @return True if the record is a handshake record that contains a client-hello or server-hello message which was
+	 * parsed successfully (see parse()), false otherwise
+	 */
+	bool parseRecord(const uint8_t* data, size_t dataLen);
+
+	/**
+	 * @return True if the last call to parse() or parseRecord() succeeded, false otherwise
+	 */
+	bool isValid() const { return m_Data != NULL; }
+
+	/**
+	 * @return The type of the message that was parsed: ::SSL_CLIENT_HELLO or ::SSL_SERVER_HELLO, or
+	 * ::SSL_HANDSHAKE_UNKNOWN if no message was parsed
+	 */
+	SSLHandshakeType getHandshakeType() const { return m_HandshakeType; }
+
+	/**
+	 * @return The handshake version of the message or 0 if no message was parsed
+	 */
+	uint16_t getHandshakeVersion() const;
+
+	/**
+	 * @return The number of cipher-suites in the message. A server-hello message always contains 1 cipher-suite
+	 */
+	size_t getCipherSuiteCount() const { return m_CipherSuiteCount; }
+
+	/**
+	 * Get the numeric ID of a cipher-suite by index
+	 * @param[in] index The index of the cipher-suite
+	 * @return The cipher-suite ID or 0 if index is out of bounds
+	 */
+	uint16_t getCipherSuiteID(size_t index) const;
+
+	/**
+	 * Get the extension following a certain position in the extensions block. Used to iterate over the extensions
+	 * without creating objects for them:
+	 * @code
+	 * size_t pos = 0;
+	 * uint16_t extType, extDataLen;
+	 * const uint8_t* extData;
+	 * while (reader.getNextExtension(pos, extType, extData, extDataLen))
+	 * {
+	 *     ...
+	 * }
+	 * @endcode
+	 * @param[in,out] pos The position in the extensions block to read the extension from. Should be 0 for the first
+	 * extension, and is advanced to the following extension on success
+	 * @param[out] extType The extension type
+	 * @param[out] extData A pointer to the extension data
+	 * @param[out] extDataLen The extension data length
+	 * @return True if an extension was found, false if there are no more extensions or the next extension exceeds
+	 * the message
+	 */
+	bool getNextExtension(size_t& pos, uint16_t& extType, const uint8_t*& extData, uint16_t& extDataLen) const;
+
+	/**
+	 * Find the first extension of a certain type
+	 * @param[in] extType The numeric type of the extension
+	 * @param[out] extDataLen The extension data length
+	 * @return A pointer to the extension data or NULL if the message doesn't contain this extension
+	 */
+	const uint8_t* getExtensionOfType(uint16_t extType, uint16_t& extDataLen) const;
+
+	/**
+	 * Get the host name of the server name indication (SNI) extension without copying it
+	 * @param[out] nameLen The length of the host name. The host name isn't null-terminated
+	 * @return A pointer to the host name in the message data or NULL if the message doesn't contain a host name
+	 */
+	const char* getServerName(size_t& nameLen) const;
+
+private:
+	const uint8_t* m_Data;
+	size_t m_DataLen;
+	SSLHandshakeType m_HandshakeType;
+	size_t m_CipherSuiteOffset;
+	size_t m_CipherSuiteCount;
+	size_t m_ExtensionsOffset;
+	size_t m_ExtensionsLen;
+
+	void clear();
+};
+
+} // namespace pcpp
+
+#endif /* PACKETPP_SSL_HELLO_READER */
@@ -151,6 +151,15 @@
  * from SSLExtension and does the parsing for this specific extension. All other extensions aren't parsed and are
  * represented by instance of SSLExtension. Access to extensions is done through the handshake messages classes,
  * specifically SSLClientHelloMessage and SSLServerHelloMessage
+ *
+ * <BR><BR>
+ *
+ * __Lazy parsing and the hello fast-path:__    <BR>
+ *
+ * Handshake messages, extensions and certificates are parsed only when they're first accessed, so handshake layers
+ * (or messages) whose content isn't looked into don't allocate any objects. When only the server name or the
+ * cipher-suites and extensions of client-hello and server-hello messages are needed (for example for TLS
+ * fingerprinting), SSLHelloReader reads them directly from the record bytes without creating any objects at all
  */
 
 
@@ -258,6 +267,8 @@ namespace pcpp
 
 	}; // class SSLLayer
 
+	PCPP_DECLARE_LAYER_PROTOCOL(SSLLayer, SSL, true);
+
 
 	/**
 	 * @class SSLHandshakeLayer
@@ -321,7 +332,7 @@ namespace pcpp
 		/**
 		 * @return The number of messages in this layer instance
 		 */
-		size_t getHandshakeMessagesCount() const { return m_MessageList.size(); }
+		size_t getHandshakeMessagesCount() const { parseMessages(); return m_MessageList.size(); }
 
 		/**
 		 * Get a pointer to an handshake message by index. The message are numbered according to their order of appearance
@@ -361,9 +372,14 @@ namespace pcpp
 		void computeCalculateFields() {}
 
 	private:
-		PointerVector<SSLHandshakeMessage> m_MessageList;
+		mutable PointerVector<SSLHandshakeMessage> m_MessageList;
+		mutable bool m_MessagesParsed;
+
+		void parseMessages() const;
 	}; // class SSLHandshakeLayer
 
+	PCPP_DECLARE_LAYER_PROTOCOL(SSLHandshakeLayer, SSL, false);
+
 
 	/**
 	 * @class SSLChangeCipherSpecLayer
@@ -396,6 +412,8 @@ namespace pcpp
 		void computeCalculateFields() {}
 	}; // class SSLChangeCipherSpecLayer
 
+	PCPP_DECLARE_LAYER_PROTOCOL(SSLChangeCipherSpecLayer, SSL, false);
+
 
 	/**
 	 * @class SSLAlertLayer
@@ -438,6 +456,8 @@ namespace pcpp
 		void computeCalculateFields() {}
 	}; // class SSLAlertLayer
 
+	PCPP_DECLARE_LAYER_PROTOCOL(SSLAlertLayer, SSL, false);
+
 
 	/**
 	 * @class SSLApplicationDataLayer
@@ -481,10 +501,13 @@ namespace pcpp
 		void computeCalculateFields() {}
 	}; // class SSLApplicationDataLayer
 
+	PCPP_DECLARE_LAYER_PROTOCOL(SSLApplicationDataLayer, SSL, false);
+
 
 	template<class THandshakeMessage>
 	THandshakeMessage* SSLHandshakeLayer::getHandshakeMessageOfType() const
 	{
+		parseMessages();
 		size_t vecSize = m_MessageList.size();
 		for (size_t i = 0; i < vecSize; i++)
 		{
@@ -501,6 +524,7 @@ namespace pcpp
 	template<class THandshakeMessage>
 	THandshakeMessage* SSLHandshakeLayer::getNextHandshakeMessageOfType(SSLHandshakeMessage* after) const
 	{
+		parseMessages();
 		size_t vecSize = m_MessageList.size();
 		size_t afterIndex;
 
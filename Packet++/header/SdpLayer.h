@@ -164,6 +164,8 @@ namespace pcpp
 		bool spacesAllowedBetweenHeaderFieldNameAndValue() const { return false; }
 
 	};
+
+	PCPP_DECLARE_LAYER_PROTOCOL(SdpLayer, SDP, true);
 }
 
 #endif // PACKETPP_SDP_LAYER
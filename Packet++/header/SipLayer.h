@@ -129,6 +129,8 @@ namespace pcpp
 		bool spacesAllowedBetweenHeaderFieldNameAndValue() const { return true; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(SipLayer, SIP, true);
+
 
 	class SipRequestFirstLine;
 
@@ -230,6 +232,8 @@ namespace pcpp
 		SipRequestFirstLine* m_FirstLine;
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(SipRequestLayer, SIPRequest, true);
+
 
 
 
@@ -456,6 +460,8 @@ namespace pcpp
 		SipResponseFirstLine* m_FirstLine;
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(SipResponseLayer, SIPResponse, true);
+
 
 
 	/**
@@ -105,6 +105,8 @@ namespace pcpp
 		OsiModelLayer getOsiModelLayer() const { return OsiModelDataLinkLayer; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(SllLayer, SLL, true);
+
 } // namespace pcpp
 
 #endif /* PACKETPP_SLL_LAYER */
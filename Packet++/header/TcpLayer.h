@@ -445,6 +445,14 @@ namespace pcpp
 		 */
 		static inline bool isDataValid(const uint8_t* data, size_t dataLen);
 
+		/**
+		 * Identify the protocol of the layer that follows this TCP layer without creating it. The same checks that parseNextLayer()
+		 * uses are applied, so this method returns the protocol of the layer parseNextLayer() would create
+		 * @return ::HTTPRequest, ::HTTPResponse, ::SSL, ::SIPRequest, ::SIPResponse, ::BGP or ::GenericPayload. ::UnknownProtocol is
+		 * returned if the layer has no payload or if the payload can't be parsed as the protocol matching its ports
+		 */
+		ProtocolType getNextLayerProtocol() const;
+
 		// implement abstract methods
 
 		/**
@@ -478,6 +486,8 @@ namespace pcpp
 		void copyLayerData(const TcpLayer& other);
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(TcpLayer, TCP, true);
+
 
 	// implementation of inline methods
 
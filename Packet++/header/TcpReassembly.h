@@ -3,9 +3,9 @@
 
 #include "Packet.h"
 #include "IpAddress.h"
-#include "PointerVector.h"
 #include <map>
 #include <list>
+#include <vector>
 #include <time.h>
 
 
@@ -55,12 +55,33 @@
  * - pcpp#TcpReassembly#reassemblePacket() should detect the packets that arrive after the FIN packet has been received
  * - the user can use the information about connections managed by pcpp#TcpReassembly instance. Following methods are used for this purpose: pcpp#TcpReassembly#getConnectionInformation and pcpp#TcpReassembly#isConnectionOpen.
  * Cleaning of memory can be performed automatically (the default behavior) by pcpp#TcpReassembly#reassemblePacket() or manually by calling pcpp#TcpReassembly#purgeClosedConnections in the user code.
- * Automatic cleaning is performed once per second.
+ * Automatic cleaning is performed once per second.<BR>
+ * By default the delay and the cleanup frequency are measured by the system clock. When processing capture files this means the result depends on how fast the file is processed.
+ * If pcpp#TcpReassemblyConfiguration#usePacketTimestamps is set, time is measured by the timestamps of the processed packets instead: the current time is the latest packet
+ * timestamp seen so far. This way a capture file processed at full speed is cleaned up exactly like the live traffic it was captured from, and no system clock calls are made
+ * per packet.
  *
  * The struct pcpp#TcpReassemblyConfiguration allows to setup the parameters of cleanup. Following parameters are supported:
  * - pcpp#TcpReassemblyConfiguration#doNotRemoveConnInfo - if this member is set to false the automatic cleanup mode is applied
  * - pcpp#TcpReassemblyConfiguration#closedConnectionDelay - the value of delay expressed in seconds. The minimum value is 1
  * - pcpp#TcpReassemblyConfiguration#maxNumToClean - to avoid performance overhead when the cleanup is being performed, this parameter is used. It defines the maximum number of items to be removed per one call of pcpp#TcpReassembly#purgeClosedConnections
+ * - pcpp#TcpReassemblyConfiguration#usePacketTimestamps - measure time by packet timestamps instead of the system clock
+ *
+ * Connections that never see a FIN or RST packet (for example because the capture started or ended in the middle of them, or because one of the peers went silent) are never
+ * closed "naturally". To keep memory bounded when processing a large number of flows, pcpp#TcpReassemblyConfiguration also supports:
+ * - pcpp#TcpReassemblyConfiguration#connectionIdleTimeout - connections that didn't see any packet for this number of seconds are closed. Time is measured by packet timestamps,
+ *   so processing a capture file gives the same result regardless of how fast it's processed
+ * - pcpp#TcpReassemblyConfiguration#maxNumOfConnections - the maximum number of open connections. When a new connection is seen and this limit is reached, the connection that
+ *   was idle for the longest time is closed
+ * Connections closed for one of these reasons are closed exactly like connections closed manually: their out-of-order data is flushed and the connection end callback is invoked.
+ * Idle connections are tracked with a timer wheel with a resolution of 1 second, so the cost of tracking them doesn't depend on the number of open connections
+ *
+ * Out-of-order data is kept per connection side in a list sorted by sequence, and its buffers are taken from a pool owned by the pcpp#TcpReassembly instance, so
+ * buffering out-of-order segments normally doesn't allocate memory. On links with heavy packet loss the buffered data may grow a lot, so it can be limited by:
+ * - pcpp#TcpReassemblyConfiguration#maxOutOfOrderBytesPerConnection - the maximum number of out-of-order bytes buffered for one connection (both sides)
+ * - pcpp#TcpReassemblyConfiguration#maxOutOfOrderBytes - the maximum number of out-of-order bytes buffered for all connections together
+ * When buffering a segment would exceed one of these limits, the out-of-order data of that side of the connection is treated as missing data: it's sent to the user
+ * immediately, together with the "[X bytes missing]" indication, and its memory is freed
  *
  */
 
@@ -85,7 +106,8 @@ struct ConnectionData
 	uint16_t srcPort;
 	/** Destination TCP/UDP port */
 	uint16_t dstPort;
-	/** A 4-byte hash key representing the connection */
+	/** A 4-byte hash key representing the connection. It's unique among the connections the TcpReassembly instance currently tracks: if the hash of a new connection
+	 * is already the key of another connection, the new connection gets the next unused key */
 	uint32_t flowKey;
 	/** Start TimeStamp of the connection */
 	timeval startTime;
@@ -141,9 +163,11 @@ public:
 	 * @param[in] tcpData A pointer to buffer containing the TCP data piece
 	 * @param[in] tcpDataLength The length of the buffer
 	 * @param[in] connData TCP connection information for this TCP data
+	 * @param[in] missingBytes The number of bytes missing before this data. The default is 0
+	 * @param[in] missingDataTextLength The length of the "[X bytes missing]" text the buffer starts with when bytes are missing. The default is 0
 	 */
-	TcpStreamData(const uint8_t* tcpData, size_t tcpDataLength, const ConnectionData& connData)
-		: m_Data(tcpData), m_DataLen(tcpDataLength), m_Connection(connData)
+	TcpStreamData(const uint8_t* tcpData, size_t tcpDataLength, const ConnectionData& connData, size_t missingBytes = 0, size_t missingDataTextLength = 0)
+		: m_Data(tcpData), m_DataLen(tcpDataLength), m_Connection(connData), m_MissingBytes(missingBytes), m_MissingDataTextLength(missingDataTextLength)
 	{
 	}
 
@@ -165,10 +189,29 @@ public:
 	 */
 	const ConnectionData& getConnectionData() const { return m_Connection; }
 
+	/**
+	 * @return True if some bytes of the stream are missing before this data. In that case the buffer starts with a "[X bytes missing]"
+	 * text which isn't part of the stream, see getMissingDataTextLength()
+	 */
+	bool isBytesMissing() const { return m_MissingBytes > 0; }
+
+	/**
+	 * @return The number of bytes of the stream missing before this data, or 0 if no bytes are missing
+	 */
+	size_t getMissingByteCount() const { return m_MissingBytes; }
+
+	/**
+	 * @return The length of the "[X bytes missing]" text at the beginning of the buffer, or 0 if no bytes are missing. The stream data
+	 * itself starts right after it
+	 */
+	size_t getMissingDataTextLength() const { return m_MissingDataTextLength; }
+
 private:
 	const uint8_t* m_Data;
 	size_t m_DataLen;
 	const ConnectionData& m_Connection;
+	size_t m_MissingBytes;
+	size_t m_MissingDataTextLength;
 };
 
 
@@ -191,14 +234,47 @@ struct TcpReassemblyConfiguration
 	 */
 	uint32_t maxNumToClean;
 
+	/** Open connections that didn't see any packet for this number of seconds are closed. Time is measured by packet timestamps. If the value is set to 0
+	 * connections are never closed for being idle.
+	 */
+	uint32_t connectionIdleTimeout;
+
+	/** The maximum number of open connections. When a packet of a new connection arrives and this number of connections is already open, the connection that was idle
+	 * for the longest time is closed. If the value is set to 0 the number of open connections isn't limited.
+	 */
+	uint32_t maxNumOfConnections;
+
+	/** If set to true, the delay before closed connections are cleaned up and the frequency of the automatic cleanup are measured by packet timestamps instead of the
+	 * system clock. The current time is the latest timestamp of the packets processed so far. Idle timeouts are always measured by packet timestamps.
+	 */
+	bool usePacketTimestamps;
+
+	/** The maximum number of out-of-order bytes buffered for one connection (both sides together). When it's exceeded the buffered data of both sides of the
+	 * connection is treated as missing data. If the value is set to 0 it isn't limited.
+	 */
+	size_t maxOutOfOrderBytesPerConnection;
+
+	/** The maximum number of out-of-order bytes buffered for all connections together. When it's exceeded the buffered data of both sides of the connection
+	 * that exceeded it is treated as missing data. If the value is set to 0 it isn't limited.
+	 */
+	size_t maxOutOfOrderBytes;
+
 	/**
 	 * A c'tor for this struct
 	 * @param[in] removeConnInfo The flag indicating whether to remove the connection data after a connection is closed. The default is true
 	 * @param[in] closedConnectionDelay How long the closed connections will not be cleaned up. The value is expressed in seconds. If it's set to 0 the default value will be used. The default is 5.
 	 * @param[in] maxNumToClean The maximum number of items to be cleaned up per one call of purgeClosedConnections. If it's set to 0 the default value will be used. The default is 30.
+	 * @param[in] connectionIdleTimeout The number of seconds after which idle connections are closed. If it's set to 0 idle connections are never closed. The default is 0.
+	 * @param[in] maxNumOfConnections The maximum number of open connections. If it's set to 0 the number of open connections isn't limited. The default is 0.
+	 * @param[in] usePacketTimestamps Measure the cleanup delay and frequency by packet timestamps instead of the system clock. The default is false.
+	 * @param[in] maxOutOfOrderBytesPerConnection The maximum number of out-of-order bytes buffered for one connection. If it's set to 0 it isn't limited. The default is 0.
+	 * @param[in] maxOutOfOrderBytes The maximum number of out-of-order bytes buffered for all connections. If it's set to 0 it isn't limited. The default is 0.
 	 */
-	TcpReassemblyConfiguration(bool removeConnInfo = true, uint32_t closedConnectionDelay = 5, uint32_t maxNumToClean = 30) :
-		removeConnInfo(removeConnInfo), closedConnectionDelay(closedConnectionDelay), maxNumToClean(maxNumToClean)
+	TcpReassemblyConfiguration(bool removeConnInfo = true, uint32_t closedConnectionDelay = 5, uint32_t maxNumToClean = 30, uint32_t connectionIdleTimeout = 0, uint32_t maxNumOfConnections = 0,
+			bool usePacketTimestamps = false, size_t maxOutOfOrderBytesPerConnection = 0, size_t maxOutOfOrderBytes = 0) :
+		removeConnInfo(removeConnInfo), closedConnectionDelay(closedConnectionDelay), maxNumToClean(maxNumToClean),
+		connectionIdleTimeout(connectionIdleTimeout), maxNumOfConnections(maxNumOfConnections), usePacketTimestamps(usePacketTimestamps),
+		maxOutOfOrderBytesPerConnection(maxOutOfOrderBytesPerConnection), maxOutOfOrderBytes(maxOutOfOrderBytes)
 	{
 	}
 };
@@ -220,7 +296,11 @@ public:
 		/** Connection ended because of FIN or RST packet */
 		TcpReassemblyConnectionClosedByFIN_RST,
 		/** Connection ended manually by the user */
-		TcpReassemblyConnectionClosedManually
+		TcpReassemblyConnectionClosedManually,
+		/** Connection ended because it didn't see any packet for longer than the configured idle timeout */
+		TcpReassemblyConnectionClosedByIdleTimeout,
+		/** Connection ended to make room for a new connection because the configured maximum number of open connections was reached */
+		TcpReassemblyConnectionClosedByMaxConnections
 	};
 
 	/**
@@ -375,20 +455,35 @@ public:
 	int isConnectionOpen(const ConnectionData& connection) const;
 
 	/**
-	 * Clean up the closed connections from the memory
+	 * Clean up the closed connections from the memory. Only connections closed longer than the configured delay ago are cleaned up, where the current time is measured
+	 * by the system clock or by packet timestamps (see TcpReassemblyConfiguration#usePacketTimestamps)
 	 * @param[in] maxNumToClean The maximum number of items to be cleaned up per one call. This parameter, when its value is not zero, overrides the value that was set by the constructor.
 	 * @return The number of cleared items
 	 */
 	uint32_t purgeClosedConnections(uint32_t maxNumToClean = 0);
 
+	/**
+	 * @return The number of currently open connections
+	 */
+	uint32_t getNumOfOpenConnections() const { return m_NumOfOpenConnections; }
+
+	/**
+	 * @return The number of out-of-order bytes currently buffered for all connections
+	 */
+	size_t getNumOfOutOfOrderBytes() const { return m_NumOfOutOfOrderBytes; }
+
 private:
+	// a buffered out-of-order segment. Fragments are linked in a list sorted by sequence, and their buffers are re-used through the fragment pool
 	struct TcpFragment
 	{
 		uint32_t sequence;
 		size_t dataLength;
+		size_t bufferSize;
 		uint8_t* data;
+		TcpFragment* prev;
+		TcpFragment* next;
 
-		TcpFragment() { sequence = 0; dataLength = 0; data = NULL; }
+		TcpFragment() { sequence = 0; dataLength = 0; bufferSize = 0; data = NULL; prev = NULL; next = NULL; }
 		~TcpFragment() { if (data != NULL) delete [] data; }
 	};
 
@@ -397,39 +492,140 @@ private:
 		IPAddress srcIP;
 		uint16_t srcPort;
 		uint32_t sequence;
-		PointerVector<TcpFragment> tcpFragmentList;
+		// the out-of-order fragments of this side, sorted by sequence. Fragments with the same sequence are kept in arrival order
+		TcpFragment* fragListHead;
+		TcpFragment* fragListTail;
 		bool gotFinOrRst;
 
-		TcpOneSideData() { srcPort = 0; sequence = 0; gotFinOrRst = false; }
+		TcpOneSideData() { srcPort = 0; sequence = 0; fragListHead = NULL; fragListTail = NULL; gotFinOrRst = false; }
 	};
 
-	struct TcpReassemblyData
+	// a node in a circular doubly-linked list of the idle timer wheel. Each slot of the wheel is a list head
+	struct ConnectionTimerNode
+	{
+		ConnectionTimerNode* prev;
+		ConnectionTimerNode* next;
+
+		ConnectionTimerNode() { prev = NULL; next = NULL; }
+	};
+
+	struct TcpReassemblyData : public ConnectionTimerNode
 	{
 		int numOfSides;
 		int prevSide;
 		TcpOneSideData twoSides[2];
 		ConnectionData connData;
+		time_t lastActivity;
+		size_t outOfOrderBytes;
 
-		TcpReassemblyData() { numOfSides = 0; prevSide = -1; }
+		TcpReassemblyData() { numOfSides = 0; prevSide = -1; lastActivity = 0; outOfOrderBytes = 0; }
+	};
+
+	// an open-addressing (linear probing) hash table that maps flow keys to connections. A closed connection is kept in the table
+	// with a NULL value until it's purged, so packets arriving after it was closed can be identified
+	class ConnectionTable
+	{
+	public:
+		enum EntryState
+		{
+			EntryEmpty,
+			EntryOccupied,
+			EntryDeleted
+		};
+
+		struct Entry
+		{
+			uint32_t flowKey;
+			// the hash5Tuple() of the connection. It's also the flow key unless another connection already had this key when the entry was inserted
+			uint32_t hash;
+			uint8_t state;
+			TcpReassemblyData* data;
+			// the 5-tuple of the connection, compared on lookup so connections whose hashes collide aren't mixed. It's kept after the connection is closed
+			IPAddress srcIP;
+			IPAddress dstIP;
+			uint16_t srcPort;
+			uint16_t dstPort;
+		};
+
+		ConnectionTable();
+
+		// find a connection by its hash and 5-tuple, in either direction. Returns NULL if the connection isn't in the table
+		Entry* find(uint32_t hash, const IPAddress& srcIP, const IPAddress& dstIP, uint16_t srcPort, uint16_t dstPort);
+
+		// returns NULL if the flow key isn't in the table
+		Entry* findByFlowKey(uint32_t flowKey);
+		const Entry* findByFlowKey(uint32_t flowKey) const;
+
+		// the connection must not be in the table. The 5-tuple is taken from data->connData, and the flow key given to the connection is set in
+		// data->connData.flowKey. Pointers to entries returned before this call become invalid
+		Entry* insert(uint32_t hash, TcpReassemblyData* data);
+
+		void erase(Entry* entry);
+
+		size_t getCapacity() const { return m_Entries.size(); }
+		Entry& getEntryAt(size_t index) { return m_Entries[index]; }
+
+	private:
+		std::vector<Entry> m_Entries;
+		size_t m_NumOfOccupied;
+		size_t m_NumOfDeleted;
+		// flow key -> hash of the entries whose flow key isn't their hash, so they can be found by their flow key
+		std::map<uint32_t, uint32_t> m_CollidingKeys;
+
+		size_t getFirstSlot(uint32_t hash) const;
+		Entry& getFreeSlot(uint32_t hash);
+		void rehash(size_t newCapacity);
 	};
-	
-	typedef std::map<uint32_t, TcpReassemblyData *> ConnectionList;
+
 	typedef std::map<time_t, std::list<uint32_t> > CleanupList;
 
 	OnTcpMessageReady m_OnMessageReadyCallback;
 	OnTcpConnectionStart m_OnConnStart;
 	OnTcpConnectionEnd m_OnConnEnd;
 	void* m_UserCookie;
-	ConnectionList m_ConnectionList;
+	ConnectionTable m_ConnectionTable;
 	ConnectionInfoList m_ConnectionInfo;
 	CleanupList m_CleanupList;
 	bool m_RemoveConnInfo;
 	uint32_t m_ClosedConnectionDelay;
 	uint32_t m_MaxNumToClean;
 	time_t m_PurgeTimepoint;
+	bool m_UsePacketTimestamps;
+	time_t m_LatestPacketTime;
+	uint32_t m_ConnectionIdleTimeout;
+	uint32_t m_MaxNumOfConnections;
+	uint32_t m_NumOfOpenConnections;
+	size_t m_MaxOutOfOrderBytesPerConnection;
+	size_t m_MaxOutOfOrderBytes;
+	size_t m_NumOfOutOfOrderBytes;
+
+	// free fragments kept for re-use, linked by their next pointer
+	TcpFragment* m_FragmentPool;
+	size_t m_FragmentPoolSize;
+
+	// the idle timer wheel. Open connections are linked to the slot of the second they may expire at (see scheduleConnectionTimer()).
+	// It's used only if an idle timeout or a maximum number of connections is configured
+	std::vector<ConnectionTimerNode> m_TimerWheel;
+	// connections idle for longer than the wheel horizon, in the order they became idle. Used only if there is no idle timeout
+	ConnectionTimerNode m_IdleList;
+	uint32_t m_TimerWheelHorizon;
+	time_t m_TimerWheelTime;
+	bool m_TimerWheelStarted;
+
+	// private copy c'tor and assignment operator, the timer wheel lists point into the object
+	TcpReassembly(const TcpReassembly& other);
+	TcpReassembly& operator=(const TcpReassembly& other);
 
 	void checkOutOfOrderFragments(TcpReassemblyData* tcpReassemblyData, int sideIndex, bool cleanWholeFragList);
 
+	void bufferOutOfOrderFragment(TcpReassemblyData* tcpReassemblyData, int sideIndex, uint32_t sequence, const uint8_t* data, size_t dataLength);
+
+	void removeFragment(TcpReassemblyData* tcpReassemblyData, int sideIndex, TcpFragment* fragment);
+
+	TcpFragment* allocateFragment(size_t dataLength);
+
+	void releaseFragment(TcpFragment* fragment);
+
 	std::string prepareMissingDataMessage(uint32_t missingDataLen);
 
 	void handleFinOrRst(TcpReassemblyData* tcpReassemblyData, int sideIndex, uint32_t flowKey);
@@ -437,6 +633,18 @@ private:
 	void closeConnectionInternal(uint32_t flowKey, ConnectionEndReason reason);
 
 	void insertIntoCleanupList(uint32_t flowKey);
+
+	time_t getCurrentTime() const { return (m_UsePacketTimestamps ? m_LatestPacketTime : time(NULL)); }
+
+	static void linkTimerNode(ConnectionTimerNode* listHead, ConnectionTimerNode* node);
+
+	static void unlinkTimerNode(ConnectionTimerNode* node);
+
+	void scheduleConnectionTimer(TcpReassemblyData* tcpReassemblyData);
+
+	void advanceTimerWheel(time_t now);
+
+	bool evictIdlestConnection();
 };
 
 }
@@ -1,7 +1,7 @@
 #ifndef PACKETPP_TEXT_BASED_PROTOCOL_LAYER
 #define PACKETPP_TEXT_BASED_PROTOCOL_LAYER
 
-#include <map>
+#include <string>
 #include "Layer.h"
 
 /// @file
@@ -12,6 +12,12 @@ namespace pcpp
 /** End of header */
 #define PCPP_END_OF_TEXT_BASED_PROTOCOL_HEADER ""
 
+/**
+ * The number of HeaderField instances stored inside each TextBasedProtocolMessage. Parsing a message with up to this number of header
+ * fields doesn't allocate any memory, fields beyond that are allocated on the heap. Must not be larger than 32
+ */
+#define PCPP_TEXT_BASED_PROTOCOL_INLINE_FIELDS 12
+
 class TextBasedProtocolMessage;
 
 
@@ -86,12 +92,16 @@ private:
 	HeaderField *getNextField() const;
 	void initNewField(std::string name, std::string value);
 	void attachToTextBasedProtocolMessage(TextBasedProtocolMessage* message, int fieldOffsetInMessage);
+	bool isNameEqual(const char* name, size_t nameLen, uint32_t nameHash) const;
+	static uint32_t calcNameHash(const char* name, size_t nameLen);
 
 	uint8_t* m_NewFieldData;
 	TextBasedProtocolMessage* m_TextBasedProtocolMessage;
 	int m_NameOffsetInMessage;
+	uint32_t m_NameHash;
 	size_t m_FieldNameSize;
 	int m_ValueOffsetInMessage;
+	uint32_t m_InsertionOrder;
 	size_t m_FieldValueSize;
 	size_t m_FieldSize;
 	HeaderField* m_NextField;
@@ -233,7 +243,7 @@ public:
 
 protected:
 	TextBasedProtocolMessage(uint8_t* data, size_t dataLen, Layer* prevLayer, Packet* packet);
-	TextBasedProtocolMessage() : m_FieldList(NULL), m_LastField(NULL), m_FieldsOffset(0) {}
+	TextBasedProtocolMessage() : m_FieldList(NULL), m_LastField(NULL), m_FieldsOffset(0), m_NextInsertionOrder(0), m_InlineFieldsInUse(0) {}
 
 	// copy c'tor
 	TextBasedProtocolMessage(const TextBasedProtocolMessage& other);
@@ -243,6 +253,10 @@ protected:
 
 	void parseFields();
 	void shiftFieldsOffset(HeaderField* fromField, int numOfBytesToShift);
+	void* allocateField();
+	void releaseField(HeaderField* field);
+	void releaseAllFields();
+	void setFieldInsertionOrder(HeaderField* field) { field->m_InsertionOrder = m_NextInsertionOrder++; }
 
 	// abstract methods
 	virtual char getHeaderFieldNameValueSeparator() const = 0;
@@ -251,9 +265,22 @@ protected:
 	HeaderField* m_FieldList;
 	HeaderField* m_LastField;
 	int m_FieldsOffset;
-	std::multimap<std::string, HeaderField*> m_FieldNameToFieldMap;
+
+private:
+	// the order in which fields were added to the message, used for telling apart fields with the same name in getFieldByName()
+	uint32_t m_NextInsertionOrder;
+	// a bit mask of the inline field slots currently holding a HeaderField instance
+	uint32_t m_InlineFieldsInUse;
+	union
+	{
+		uint8_t m_InlineFieldStorage[PCPP_TEXT_BASED_PROTOCOL_INLINE_FIELDS * sizeof(HeaderField)];
+		uint64_t m_InlineFieldAlignment;
+		void* m_InlineFieldPtrAlignment;
+	};
 };
 
+PCPP_DECLARE_LAYER_PROTOCOL(TextBasedProtocolMessage, HTTP | SIP | SDP, true);
+
 
 }
 
@@ -66,6 +66,14 @@ namespace pcpp
 		 */
 		uint16_t calculateChecksum(bool writeResultToPacket);
 
+		/**
+		 * Identify the protocol of the layer that follows this UDP layer without creating it. The same checks that parseNextLayer()
+		 * uses are applied, so this method returns the protocol of the layer parseNextLayer() would create
+		 * @return ::DHCP, ::VXLAN, ::DNS, ::SIPRequest, ::SIPResponse, ::Radius, ::GTP or ::GenericPayload. ::UnknownProtocol is
+		 * returned if the layer has no payload
+		 */
+		ProtocolType getNextLayerProtocol() const;
+
 		// implement abstract methods
 
 		/**
@@ -89,6 +97,8 @@ namespace pcpp
 		OsiModelLayer getOsiModelLayer() const { return OsiModelTransportLayer; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(UdpLayer, UDP, true);
+
 } // namespace pcpp
 
 #endif /* PACKETPP_UDP_LAYER */
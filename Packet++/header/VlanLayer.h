@@ -134,6 +134,8 @@ namespace pcpp
 		OsiModelLayer getOsiModelLayer() const { return OsiModelDataLinkLayer; }
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(VlanLayer, VLAN, true);
+
 } // namespace pcpp
 
 #endif /* PACKETPP_VLAN_LAYER */
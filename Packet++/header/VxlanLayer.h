@@ -140,6 +140,8 @@ namespace pcpp
 
 	};
 
+	PCPP_DECLARE_LAYER_PROTOCOL(VxlanLayer, VXLAN, true);
+
 }
 
 #endif // PACKETPP_VXLAN_LAYER
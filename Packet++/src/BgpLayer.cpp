@@ -28,29 +28,40 @@ size_t BgpLayer::getHeaderLen() const
   return (size_t)messageLen;
 }
 
-BgpLayer* BgpLayer::parseBgpLayer(uint8_t* data, size_t dataLen, Layer* prevLayer, Packet* packet)
+bool BgpLayer::isDataValid(const uint8_t* data, size_t dataLen)
 {
   if (dataLen < sizeof(bgp_common_header))
-    return NULL;
-  
-  bgp_common_header* bgpHeader = (bgp_common_header*)data;
+    return false;
+
+  const bgp_common_header* bgpHeader = (const bgp_common_header*)data;
 
   // illegal header data - length is too small
   if (be16toh(bgpHeader->length) < static_cast<uint16_t>(sizeof(bgp_common_header)))
+    return false;
+
+  // known message types are OPEN (1) to ROUTE-REFRESH (5)
+  return bgpHeader->messageType >= 1 && bgpHeader->messageType <= 5;
+}
+
+BgpLayer* BgpLayer::parseBgpLayer(uint8_t* data, size_t dataLen, Layer* prevLayer, Packet* packet)
+{
+  if (!isDataValid(data, dataLen))
     return NULL;
   
+  bgp_common_header* bgpHeader = (bgp_common_header*)data;
+
   switch (bgpHeader->messageType)
   {
   case 1: // OPEN
-    return new BgpOpenMessageLayer(data, dataLen, prevLayer, packet);
+    return new(packet) BgpOpenMessageLayer(data, dataLen, prevLayer, packet);
   case 2: // UPDATE
-    return new BgpUpdateMessageLayer(data, dataLen, prevLayer, packet);
+    return new(packet) BgpUpdateMessageLayer(data, dataLen, prevLayer, packet);
   case 3: // NOTIFICATION
-    return new BgpNotificationMessageLayer(data, dataLen, prevLayer, packet);
+    return new(packet) BgpNotificationMessageLayer(data, dataLen, prevLayer, packet);
   case 4: // KEEPALIVE
-    return new BgpKeepaliveMessageLayer(data, dataLen, prevLayer, packet);
+    return new(packet) BgpKeepaliveMessageLayer(data, dataLen, prevLayer, packet);
   case 5: // ROUTE-REFRESH
-    return new BgpRouteRefreshMessageLayer(data, dataLen, prevLayer, packet);
+    return new(packet) BgpRouteRefreshMessageLayer(data, dataLen, prevLayer, packet);
   default:
     return NULL;
   }
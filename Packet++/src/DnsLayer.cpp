@@ -219,7 +219,8 @@ IDnsResource* DnsLayer::getResourceByName(IDnsResource* startFrom, size_t resour
 		if (startFrom == NULL)
 			return NULL;
 
-		std::string resourceName = startFrom->getName();
+		// compare to the name decoded when the resource was parsed rather than to a copy of it
+		const std::string& resourceName = startFrom->m_DecodedName;
 		if (exactMatch && resourceName == name)
 			return startFrom;
 		else if (!exactMatch && resourceName.find(name) != std::string::npos)
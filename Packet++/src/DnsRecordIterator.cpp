@@ -0,0 +1,299 @@
+#include "DnsRecordIterator.h"
+#include <string.h>
+#include "EndianPortable.h"
+
+namespace pcpp
+{
+
+// the fixed part of a DNS query (type and class) and of other records (type, class, TTL and data length) which follows the record name
+#define DNS_QUERY_FIXED_SIZE (2*sizeof(uint16_t))
+#define DNS_RESOURCE_FIXED_SIZE (3*sizeof(uint16_t) + sizeof(uint32_t))
+
+/**
+ * Move 'offset' past the next label of a name in wire format, following a compression pointer if one is found on the way.
+ * The label found is returned in 'label' and 'labelLen', where a zero length label marks the end of the name.
+ * Returns false if the name exceeds the data or contains an illegal pointer or too many pointers
+ */
+static bool nextNameLabel(const uint8_t* data, size_t dataLen, size_t& offset, int& numOfPointers, const uint8_t*& label, uint8_t& labelLen)
+{
+	while (true)
+	{
+		if (offset >= dataLen)
+			return false;
+
+		uint8_t wordLength = data[offset];
+
+		// a pointer to another place in the data
+		if ((wordLength & 0xc0) == 0xc0)
+		{
+			if (offset + 2 > dataLen || ++numOfPointers > PCPP_DNS_MAX_NAME_POINTERS)
+				return false;
+
+			size_t pointedOffset = (wordLength & 0x3f)*256 + data[offset + 1];
+			if (pointedOffset < sizeof(dnshdr) || pointedOffset >= dataLen)
+				return false;
+
+			offset = pointedOffset;
+			continue;
+		}
+
+		if (offset + wordLength + 1 > dataLen)
+			return false;
+
+		label = data + offset + 1;
+		labelLen = wordLength;
+		offset += wordLength + 1;
+		return true;
+	}
+}
+
+/**
+ * Get the number of bytes a name in wire format takes in its record, not following a compression pointer it ends with.
+ * Returns 0 if the name exceeds the data
+ */
+static size_t getEncodedNameLength(const uint8_t* data, size_t dataLen, size_t offset)
+{
+	size_t curOffset = offset;
+	while (curOffset < dataLen)
+	{
+		uint8_t wordLength = data[curOffset];
+		if (wordLength == 0)
+			return curOffset + 1 - offset;
+
+		if ((wordLength & 0xc0) == 0xc0)
+			return (curOffset + 2 > dataLen ? 0 : curOffset + 2 - offset);
+
+		curOffset += wordLength + 1;
+	}
+
+	return 0;
+}
+
+static inline uint8_t toLowerAscii(uint8_t c)
+{
+	return (c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+}
+
+
+DnsType DnsRecordView::getDnsType() const
+{
+	uint16_t dnsType;
+	memcpy(&dnsType, getFieldsPtr(), sizeof(uint16_t));
+	return (DnsType)be16toh(dnsType);
+}
+
+DnsClass DnsRecordView::getDnsClass() const
+{
+	uint16_t dnsClass;
+	memcpy(&dnsClass, getFieldsPtr() + sizeof(uint16_t), sizeof(uint16_t));
+	return (DnsClass)be16toh(dnsClass);
+}
+
+uint32_t DnsRecordView::getTTL() const
+{
+	if (m_ResourceType == DnsQueryType)
+		return 0;
+
+	uint32_t ttl;
+	memcpy(&ttl, getFieldsPtr() + 2*sizeof(uint16_t), sizeof(uint32_t));
+	return be32toh(ttl);
+}
+
+size_t DnsRecordView::getDataLength() const
+{
+	if (m_ResourceType == DnsQueryType)
+		return 0;
+
+	uint16_t dataLength;
+	memcpy(&dataLength, getFieldsPtr() + 2*sizeof(uint16_t) + sizeof(uint32_t), sizeof(uint16_t));
+	return be16toh(dataLength);
+}
+
+const uint8_t* DnsRecordView::getData() const
+{
+	if (m_ResourceType == DnsQueryType)
+		return NULL;
+
+	return getFieldsPtr() + DNS_RESOURCE_FIXED_SIZE;
+}
+
+size_t DnsRecordView::getDataOffset() const
+{
+	if (m_ResourceType == DnsQueryType)
+		return 0;
+
+	return m_OffsetInLayer + m_NameLength + DNS_RESOURCE_FIXED_SIZE;
+}
+
+size_t DnsRecordView::getSize() const
+{
+	if (m_ResourceType == DnsQueryType)
+		return m_NameLength + DNS_QUERY_FIXED_SIZE;
+
+	return m_NameLength + DNS_RESOURCE_FIXED_SIZE + getDataLength();
+}
+
+bool DnsRecordView::decodeName(char* result, size_t resultLen) const
+{
+	if (m_Data == NULL || result == NULL || resultLen == 0)
+		return false;
+
+	size_t offset = m_OffsetInLayer;
+	int numOfPointers = 0;
+	size_t decodedNameLength = 0;
+	const uint8_t* label = NULL;
+	uint8_t labelLen = 0;
+
+	while (true)
+	{
+		if (!nextNameLabel(m_Data, m_DataLen, offset, numOfPointers, label, labelLen))
+			return false;
+
+		if (labelLen == 0)
+			break;
+
+		// every label except the first is preceded by a '.'
+		size_t separatorLen = (decodedNameLength > 0 ? 1 : 0);
+		if (decodedNameLength + separatorLen + labelLen >= resultLen || decodedNameLength + separatorLen + labelLen >= PCPP_DNS_MAX_DECODED_NAME_LEN)
+			return false;
+
+		if (separatorLen > 0)
+			result[decodedNameLength++] = '.';
+
+		memcpy(result + decodedNameLength, label, labelLen);
+		decodedNameLength += labelLen;
+	}
+
+	result[decodedNameLength] = 0;
+	return true;
+}
+
+bool DnsRecordView::isNameEqual(const char* name, size_t nameLen) const
+{
+	if (m_Data == NULL || name == NULL)
+		return false;
+
+	if (nameLen > 0 && name[nameLen - 1] == '.')
+		nameLen--;
+
+	size_t offset = m_OffsetInLayer;
+	int numOfPointers = 0;
+	size_t posInName = 0;
+	const uint8_t* label = NULL;
+	uint8_t labelLen = 0;
+
+	while (true)
+	{
+		if (!nextNameLabel(m_Data, m_DataLen, offset, numOfPointers, label, labelLen))
+			return false;
+
+		if (labelLen == 0)
+			return posInName == nameLen;
+
+		// every label except the first is preceded by a '.'
+		if (posInName > 0)
+		{
+			if (posInName >= nameLen || name[posInName] != '.')
+				return false;
+			posInName++;
+		}
+
+		if (nameLen - posInName < labelLen)
+			return false;
+
+		for (uint8_t i = 0; i < labelLen; i++)
+		{
+			if (toLowerAscii(label[i]) != toLowerAscii((uint8_t)name[posInName + i]))
+				return false;
+		}
+
+		posInName += labelLen;
+	}
+}
+
+
+DnsRecordIterator::DnsRecordIterator(const uint8_t* data, size_t dataLen, bool hasTcpLengthPrefix) : m_Data(data), m_DataLen(dataLen)
+{
+	// the message starts after the length field, and may be followed by the beginning of the next message in the same segment
+	if (hasTcpLengthPrefix && m_Data != NULL)
+	{
+		if (m_DataLen < sizeof(uint16_t))
+			m_DataLen = 0;
+		else
+		{
+			size_t messageLen = ((size_t)m_Data[0] << 8) | m_Data[1];
+			m_Data += sizeof(uint16_t);
+			m_DataLen -= sizeof(uint16_t);
+			if (messageLen < m_DataLen)
+				m_DataLen = messageLen;
+		}
+	}
+
+	reset();
+}
+
+DnsRecordIterator::DnsRecordIterator(const DnsLayer& dnsLayer) : m_Data(dnsLayer.getData()), m_DataLen(dnsLayer.getDataLen())
+{
+	reset();
+}
+
+void DnsRecordIterator::reset()
+{
+	m_NextOffset = sizeof(dnshdr);
+	m_CurResourceType = DnsQueryType;
+	m_IsMalformed = false;
+
+	if (m_Data == NULL || m_DataLen < sizeof(dnshdr))
+	{
+		m_IsMalformed = true;
+		memset(m_RecordsLeft, 0, sizeof(m_RecordsLeft));
+		return;
+	}
+
+	const dnshdr* dnsHeader = (const dnshdr*)m_Data;
+	m_RecordsLeft[DnsQueryType] = be16toh(dnsHeader->numberOfQuestions);
+	m_RecordsLeft[DnsAnswerType] = be16toh(dnsHeader->numberOfAnswers);
+	m_RecordsLeft[DnsAuthorityType] = be16toh(dnsHeader->numberOfAuthority);
+	m_RecordsLeft[DnsAdditionalType] = be16toh(dnsHeader->numberOfAdditional);
+}
+
+bool DnsRecordIterator::getNextRecord(DnsRecordView& record)
+{
+	if (m_IsMalformed)
+		return false;
+
+	while (m_CurResourceType <= DnsAdditionalType && m_RecordsLeft[m_CurResourceType] == 0)
+		m_CurResourceType++;
+
+	if (m_CurResourceType > DnsAdditionalType)
+		return false;
+
+	DnsResourceType resType = (DnsResourceType)m_CurResourceType;
+
+	size_t nameLength = getEncodedNameLength(m_Data, m_DataLen, m_NextOffset);
+	size_t fixedSize = (resType == DnsQueryType ? DNS_QUERY_FIXED_SIZE : DNS_RESOURCE_FIXED_SIZE);
+	if (nameLength == 0 || m_NextOffset + nameLength + fixedSize > m_DataLen)
+	{
+		m_IsMalformed = true;
+		return false;
+	}
+
+	record.m_Data = m_Data;
+	record.m_DataLen = m_DataLen;
+	record.m_OffsetInLayer = m_NextOffset;
+	record.m_NameLength = nameLength;
+	record.m_ResourceType = resType;
+
+	size_t recordSize = record.getSize();
+	if (m_NextOffset + recordSize > m_DataLen)
+	{
+		m_IsMalformed = true;
+		return false;
+	}
+
+	m_NextOffset += recordSize;
+	m_RecordsLeft[m_CurResourceType]--;
+	return true;
+}
+
+} // namespace pcpp
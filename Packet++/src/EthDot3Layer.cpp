@@ -17,7 +17,7 @@ EthDot3Layer::EthDot3Layer(const MacAddress& sourceMac, const MacAddress& destMa
 	destMac.copyTo(ethHdr->dstMac);
 	sourceMac.copyTo(ethHdr->srcMac);
 	ethHdr->length = be16toh(length);
-	m_Protocol = Ethernet;
+	m_Protocol = EthernetDot3;
 }
 
 void EthDot3Layer::parseNextLayer()
@@ -28,7 +28,7 @@ void EthDot3Layer::parseNextLayer()
 	uint8_t* payload = m_Data + sizeof(ether_dot3_header);
 	size_t payloadLen = m_DataLen - sizeof(ether_dot3_header);
 
-	m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+	m_NextLayer = new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet);
 }
 
 std::string EthDot3Layer::toString() const
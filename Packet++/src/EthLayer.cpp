@@ -42,31 +42,31 @@ void EthLayer::parseNextLayer()
 	{
 	case PCPP_ETHERTYPE_IP:
 		m_NextLayer = IPv4Layer::isDataValid(payload, payloadLen)
-			? static_cast<Layer*>(new IPv4Layer(payload, payloadLen, this, m_Packet))
-			: static_cast<Layer*>(new PayloadLayer(payload, payloadLen, this, m_Packet));
+			? static_cast<Layer*>(new(m_Packet) IPv4Layer(payload, payloadLen, this, m_Packet))
+			: static_cast<Layer*>(new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet));
 		break;
 	case PCPP_ETHERTYPE_IPV6:
 		m_NextLayer = IPv6Layer::isDataValid(payload, payloadLen)
-			? static_cast<Layer*>(new IPv6Layer(payload, payloadLen, this, m_Packet))
-			: static_cast<Layer*>(new PayloadLayer(payload, payloadLen, this, m_Packet));
+			? static_cast<Layer*>(new(m_Packet) IPv6Layer(payload, payloadLen, this, m_Packet))
+			: static_cast<Layer*>(new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet));
 		break;
 	case PCPP_ETHERTYPE_ARP:
-		m_NextLayer = new ArpLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) ArpLayer(payload, payloadLen, this, m_Packet);
 		break;
 	case PCPP_ETHERTYPE_VLAN:
-		m_NextLayer = new VlanLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) VlanLayer(payload, payloadLen, this, m_Packet);
 		break;
 	case PCPP_ETHERTYPE_PPPOES:
-		m_NextLayer = new PPPoESessionLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) PPPoESessionLayer(payload, payloadLen, this, m_Packet);
 		break;
 	case PCPP_ETHERTYPE_PPPOED:
-		m_NextLayer = new PPPoEDiscoveryLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) PPPoEDiscoveryLayer(payload, payloadLen, this, m_Packet);
 		break;
 	case PCPP_ETHERTYPE_MPLS:
-		m_NextLayer = new MplsLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) MplsLayer(payload, payloadLen, this, m_Packet);
 		break;
 	default:
-		m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet);
 	}
 }
 
@@ -0,0 +1,150 @@
+#include "FlowTable.h"
+#include "IPv4Layer.h"
+#include "IPv6Layer.h"
+#include "TcpLayer.h"
+#include "UdpLayer.h"
+#include "IpUtils.h"
+#include "EndianPortable.h"
+#include <string.h>
+
+namespace pcpp
+{
+
+FlowKey::FlowKey() : m_Hash(0), m_IPVersion(0), m_Protocol(0), m_IsReversed(false)
+{
+	memset(m_Addresses, 0, sizeof(m_Addresses));
+	m_Ports[0] = m_Ports[1] = 0;
+}
+
+FlowKey::FlowKey(const IPAddress& srcIP, const IPAddress& dstIP, uint16_t srcPort, uint16_t dstPort, uint8_t protocol)
+{
+	memset(m_Addresses, 0, sizeof(m_Addresses));
+	m_Ports[0] = m_Ports[1] = 0;
+	m_Hash = 0;
+	m_IPVersion = 0;
+	m_Protocol = 0;
+	m_IsReversed = false;
+
+	if (srcIP.getType() != dstIP.getType())
+		return;
+
+	if (protocol != PACKETPP_IPPROTO_TCP && protocol != PACKETPP_IPPROTO_UDP)
+		srcPort = dstPort = 0;
+
+	if (srcIP.isIPv4())
+		init(srcIP.getIPv4().toBytes(), dstIP.getIPv4().toBytes(), 4, srcPort, dstPort, protocol);
+	else
+		init(srcIP.getIPv6().toBytes(), dstIP.getIPv6().toBytes(), 6, srcPort, dstPort, protocol);
+}
+
+bool FlowKey::setFromPacket(Packet* packet)
+{
+	*this = FlowKey();
+
+	// find the innermost IP layer, skipping the IP header of the original packet an ICMP error message carries
+	Layer* ipLayer = packet->getLastLayer();
+	while (ipLayer != NULL)
+	{
+		ProtocolType protocol = ipLayer->getProtocol();
+		if ((protocol == IPv4 || protocol == IPv6) && (ipLayer->getPrevLayer() == NULL || ipLayer->getPrevLayer()->getProtocol() != ICMP))
+			break;
+
+		ipLayer = ipLayer->getPrevLayer();
+	}
+
+	if (ipLayer == NULL)
+		return false;
+
+	uint16_t srcPort = 0;
+	uint16_t dstPort = 0;
+	uint8_t ipProtocol;
+	Layer* transportLayer = ipLayer->getNextLayer();
+	if (transportLayer != NULL && transportLayer->getProtocol() == TCP)
+	{
+		tcphdr* tcpHeader = ((TcpLayer*)transportLayer)->getTcpHeader();
+		srcPort = be16toh(tcpHeader->portSrc);
+		dstPort = be16toh(tcpHeader->portDst);
+		ipProtocol = PACKETPP_IPPROTO_TCP;
+	}
+	else if (transportLayer != NULL && transportLayer->getProtocol() == UDP)
+	{
+		udphdr* udpHeader = ((UdpLayer*)transportLayer)->getUdpHeader();
+		srcPort = be16toh(udpHeader->portSrc);
+		dstPort = be16toh(udpHeader->portDst);
+		ipProtocol = PACKETPP_IPPROTO_UDP;
+	}
+	else if (ipLayer->getProtocol() == IPv4)
+		ipProtocol = ((IPv4Layer*)ipLayer)->getIPv4Header()->protocol;
+	else
+	{
+		// the protocol of the payload is the next header of the last extension header, each extension starts with its next header field
+		IPv6Layer* ipv6Layer = (IPv6Layer*)ipLayer;
+		ipProtocol = ipv6Layer->getIPv6Header()->nextHeader;
+		size_t extOffset = sizeof(ip6_hdr);
+		for (IPv6Extension* ext = ipv6Layer->getExtensionOfType<IPv6Extension>(); ext != NULL; ext = ext->getNextHeader())
+		{
+			ipProtocol = ipv6Layer->getData()[extOffset];
+			extOffset += ext->getExtensionLen();
+		}
+	}
+
+	if (ipLayer->getProtocol() == IPv4)
+	{
+		iphdr* ipHeader = ((IPv4Layer*)ipLayer)->getIPv4Header();
+		init((uint8_t*)&ipHeader->ipSrc, (uint8_t*)&ipHeader->ipDst, 4, srcPort, dstPort, ipProtocol);
+	}
+	else
+	{
+		ip6_hdr* ipHeader = ((IPv6Layer*)ipLayer)->getIPv6Header();
+		init(ipHeader->ipSrc, ipHeader->ipDst, 6, srcPort, dstPort, ipProtocol);
+	}
+
+	return true;
+}
+
+void FlowKey::init(const uint8_t* srcAddr, const uint8_t* dstAddr, uint8_t ipVersion, uint16_t srcPort, uint16_t dstPort, uint8_t protocol)
+{
+	size_t addrLen = (ipVersion == 4 ? 4 : 16);
+
+	// put the endpoint with the lower address (or the lower port if the addresses are equal) first so both directions get the same key
+	int cmp = memcmp(srcAddr, dstAddr, addrLen);
+	m_IsReversed = (cmp > 0 || (cmp == 0 && srcPort > dstPort));
+	memcpy(m_Addresses[0], m_IsReversed ? dstAddr : srcAddr, addrLen);
+	memcpy(m_Addresses[1], m_IsReversed ? srcAddr : dstAddr, addrLen);
+	m_Ports[0] = (m_IsReversed ? dstPort : srcPort);
+	m_Ports[1] = (m_IsReversed ? srcPort : dstPort);
+	m_IPVersion = ipVersion;
+	m_Protocol = protocol;
+
+	uint16_t ports[2] = { m_Ports[0], m_Ports[1] };
+	ScalarBuffer<uint8_t> vec[4];
+	vec[0].buffer = m_Addresses[0];
+	vec[0].len = addrLen;
+	vec[1].buffer = m_Addresses[1];
+	vec[1].len = addrLen;
+	vec[2].buffer = (uint8_t*)ports;
+	vec[2].len = sizeof(ports);
+	vec[3].buffer = &m_Protocol;
+	vec[3].len = 1;
+	m_Hash = fnv_hash(vec, 4);
+}
+
+bool FlowKey::operator==(const FlowKey& other) const
+{
+	if (m_Hash != other.m_Hash || m_IPVersion != other.m_IPVersion || m_Protocol != other.m_Protocol ||
+			m_Ports[0] != other.m_Ports[0] || m_Ports[1] != other.m_Ports[1])
+		return false;
+
+	size_t addrLen = (m_IPVersion == 4 ? 4 : 16);
+	return memcmp(m_Addresses[0], other.m_Addresses[0], addrLen) == 0 && memcmp(m_Addresses[1], other.m_Addresses[1], addrLen) == 0;
+}
+
+IPAddress FlowKey::getIP(int endpoint) const
+{
+	if (m_IPVersion == 6)
+		return IPAddress(IPv6Address(m_Addresses[endpoint]));
+
+	return IPAddress(IPv4Address(m_Addresses[endpoint]));
+}
+
+} // namespace pcpp
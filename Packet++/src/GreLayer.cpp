@@ -202,25 +202,25 @@ void GreLayer::parseNextLayer()
 	{
 	case PCPP_ETHERTYPE_IP:
 		m_NextLayer = IPv4Layer::isDataValid(payload, payloadLen)
-			? static_cast<Layer*>(new IPv4Layer(payload, payloadLen, this, m_Packet))
-			: static_cast<Layer*>(new PayloadLayer(payload, payloadLen, this, m_Packet));
+			? static_cast<Layer*>(new(m_Packet) IPv4Layer(payload, payloadLen, this, m_Packet))
+			: static_cast<Layer*>(new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet));
 		break;
 	case PCPP_ETHERTYPE_IPV6:
 		m_NextLayer = IPv6Layer::isDataValid(payload, payloadLen)
-			? static_cast<Layer*>(new IPv6Layer(payload, payloadLen, this, m_Packet))
-			: static_cast<Layer*>(new PayloadLayer(payload, payloadLen, this, m_Packet));
+			? static_cast<Layer*>(new(m_Packet) IPv6Layer(payload, payloadLen, this, m_Packet))
+			: static_cast<Layer*>(new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet));
 		break;
 	case PCPP_ETHERTYPE_VLAN:
-		m_NextLayer = new VlanLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) VlanLayer(payload, payloadLen, this, m_Packet);
 		break;
 	case PCPP_ETHERTYPE_MPLS:
-		m_NextLayer = new MplsLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) MplsLayer(payload, payloadLen, this, m_Packet);
 		break;
 	case PCPP_ETHERTYPE_PPP:
 		m_NextLayer = new PPP_PPTPLayer(payload, payloadLen, this, m_Packet);
 		break;
 	default:
-		m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet);
 	}
 }
 
@@ -563,16 +563,16 @@ void PPP_PPTPLayer::parseNextLayer()
 	{
 	case PCPP_PPP_IP:
 		m_NextLayer = IPv4Layer::isDataValid(payload, payloadLen)
-			? static_cast<Layer*>(new IPv4Layer(payload, payloadLen, this, m_Packet))
-			: static_cast<Layer*>(new PayloadLayer(payload, payloadLen, this, m_Packet));
+			? static_cast<Layer*>(new(m_Packet) IPv4Layer(payload, payloadLen, this, m_Packet))
+			: static_cast<Layer*>(new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet));
 		break;
 	case PCPP_PPP_IPV6:
 		m_NextLayer = IPv6Layer::isDataValid(payload, payloadLen)
-			? static_cast<Layer*>(new IPv6Layer(payload, payloadLen, this, m_Packet))
-			: static_cast<Layer*>(new PayloadLayer(payload, payloadLen, this, m_Packet));
+			? static_cast<Layer*>(new(m_Packet) IPv6Layer(payload, payloadLen, this, m_Packet))
+			: static_cast<Layer*>(new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet));
 		break;
 	default:
-		m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet);
 		break;
 	}
 }
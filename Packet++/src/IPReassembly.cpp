@@ -8,6 +8,9 @@
 #include <string.h>
 #include "EndianPortable.h"
 
+// the initial number of buckets in the packet hash table. It must be a power of 2
+#define IP_REASSEMBLY_HASH_TABLE_INITIAL_SIZE 64
+
 namespace pcpp
 {
 
@@ -53,7 +56,12 @@ public:
 	virtual uint16_t getFragmentOffset() = 0;
 	virtual uint32_t getFragmentId() = 0;
 	virtual uint32_t hashPacket() = 0;
-	virtual IPReassembly::PacketKey* createPacketKey() = 0;
+	virtual const IPReassembly::PacketKey& getPacketKey() = 0;
+
+	IPReassembly::PacketKey* createPacketKey()
+	{
+		return getPacketKey().clone();
+	}
 
 	virtual uint8_t* getIPLayerPayload() = 0;
 	virtual size_t getIPLayerPayloadSize() = 0;
@@ -114,9 +122,12 @@ public:
 		return pcpp::fnv_hash(vec, 3);
 	}
 
-	IPReassembly::PacketKey* createPacketKey()
+	const IPReassembly::PacketKey& getPacketKey()
 	{
-		return new IPReassembly::IPv4PacketKey(be16toh(m_IPLayer->getIPv4Header()->ipId), m_IPLayer->getSrcIpAddress(), m_IPLayer->getDstIpAddress());
+		m_Key.setIpID(be16toh(m_IPLayer->getIPv4Header()->ipId));
+		m_Key.setSrcIP(m_IPLayer->getSrcIpAddress());
+		m_Key.setDstIP(m_IPLayer->getDstIpAddress());
+		return m_Key;
 	}
 
 	uint8_t* getIPLayerPayload()
@@ -131,6 +142,7 @@ public:
 
 private:
 	IPv4Layer* m_IPLayer;
+	IPReassembly::IPv4PacketKey m_Key;
 
 };
 
@@ -200,9 +212,12 @@ public:
 		return pcpp::fnv_hash(vec, 3);
 	}
 
-	IPReassembly::PacketKey* createPacketKey()
+	const IPReassembly::PacketKey& getPacketKey()
 	{
-		return new IPReassembly::IPv6PacketKey(be32toh(m_FragHeader->getFragHeader()->id), m_IPLayer->getSrcIpAddress(), m_IPLayer->getDstIpAddress());
+		m_Key.setFragmentID(be32toh(m_FragHeader->getFragHeader()->id));
+		m_Key.setSrcIP(m_IPLayer->getSrcIpAddress());
+		m_Key.setDstIP(m_IPLayer->getDstIpAddress());
+		return m_Key;
 	}
 
 	uint8_t* getIPLayerPayload()
@@ -218,6 +233,7 @@ public:
 private:
 	IPv6Layer* m_IPLayer;
 	IPv6FragmentationHeader* m_FragHeader;
+	IPReassembly::IPv6PacketKey m_Key;
 
 };
 
@@ -262,13 +278,39 @@ uint32_t IPReassembly::IPv6PacketKey::getHashValue() const
 
 
 
+static bool isSamePacketKey(const IPReassembly::PacketKey& key1, const IPReassembly::PacketKey& key2)
+{
+	if (key1.getProtocolType() != key2.getProtocolType())
+		return false;
+
+	if (key1.getProtocolType() == IPv4)
+	{
+		const IPReassembly::IPv4PacketKey& ipv4Key1 = static_cast<const IPReassembly::IPv4PacketKey&>(key1);
+		const IPReassembly::IPv4PacketKey& ipv4Key2 = static_cast<const IPReassembly::IPv4PacketKey&>(key2);
+		return ipv4Key1.getIpID() == ipv4Key2.getIpID() && ipv4Key1.getSrcIP() == ipv4Key2.getSrcIP() && ipv4Key1.getDstIP() == ipv4Key2.getDstIP();
+	}
+
+	const IPReassembly::IPv6PacketKey& ipv6Key1 = static_cast<const IPReassembly::IPv6PacketKey&>(key1);
+	const IPReassembly::IPv6PacketKey& ipv6Key2 = static_cast<const IPReassembly::IPv6PacketKey&>(key2);
+	return ipv6Key1.getFragmentID() == ipv6Key2.getFragmentID() && ipv6Key1.getSrcIP() == ipv6Key2.getSrcIP() && ipv6Key1.getDstIP() == ipv6Key2.getDstIP();
+}
+
+
+IPReassembly::IPReassembly(OnFragmentsClean onFragmentsCleanCallback, void *callbackUserCookie, size_t maxPacketsToStore, size_t maxBytesToStore, uint32_t packetTimeout)
+	: m_HashTable(IP_REASSEMBLY_HASH_TABLE_INITIAL_SIZE, (IPFragmentData*)NULL), m_NumOfPackets(0), m_MaxPacketsToStore(maxPacketsToStore),
+	  m_MaxBytesToStore(maxBytesToStore), m_CurrentMemoryUsage(0), m_PacketTimeout(packetTimeout), m_LatestPacketTime(0),
+	  m_NumOfEvictedPackets(0), m_NumOfTimedOutPackets(0), m_OnFragmentsCleanCallback(onFragmentsCleanCallback), m_CallbackUserCookie(callbackUserCookie)
+{
+}
+
 IPReassembly::~IPReassembly()
 {
-	// empty the map - go over all keys, delete all IPFragmentData objects and remove them from the map
-	while (!m_FragmentMap.empty())
+	// delete all IPFragmentData objects. Every one of them is in the creation time list
+	while (m_AgeList.head != NULL)
 	{
-		delete m_FragmentMap.begin()->second;
-		m_FragmentMap.erase(m_FragmentMap.begin());
+		IPFragmentData* fragData = m_AgeList.head;
+		m_AgeList.head = fragData->ageLinks.next;
+		delete fragData;
 	}
 }
 
@@ -287,6 +329,14 @@ Packet* IPReassembly::processPacket(Packet* fragment, ReassemblyStatus& status,
 	// get IPv4 layer
 	//IPv4Layer* ipLayer = fragment->getLayerOfType<IPv4Layer>();
 
+	// packet timestamps aren't always monotonic, the clock never goes backwards
+	time_t packetTime = fragment->getRawPacket()->getPacketTimeStamp().tv_sec;
+	if (packetTime > m_LatestPacketTime)
+		m_LatestPacketTime = packetTime;
+
+	// drop packets that weren't reassembled in time
+	dropTimedOutPackets();
+
 	// create fragment wrapper
 	IPv4FragmentWrapper ipv4Wrapper(fragment);
 	IPv6FragmentWrapper ipv6Wrapper(fragment);
@@ -307,13 +357,11 @@ Packet* IPReassembly::processPacket(Packet* fragment, ReassemblyStatus& status,
 	// create a hash from source IP, destination IP and IP/fragment ID
 	uint32_t hash = fragWrapper->hashPacket();
 
-	IPFragmentData* fragData = NULL;
-
 	// check whether this packet already exists in the map
-	std::map<uint32_t, IPFragmentData*>::iterator iter = m_FragmentMap.find(hash);
+	IPFragmentData* fragData = findPacket(hash, fragWrapper->getPacketKey());
 
 	// this is the first fragment seen for this packet
-	if (iter == m_FragmentMap.end())
+	if (fragData == NULL)
 	{
 		LOG_DEBUG("Got new packet with FragID=0x%X, allocating place in map", fragWrapper->getFragmentId());
 
@@ -321,15 +369,13 @@ Packet* IPReassembly::processPacket(Packet* fragment, ReassemblyStatus& status,
 		fragData = new IPFragmentData(fragWrapper->createPacketKey(), fragWrapper->getFragmentId());
 
 		// add the new fragment to the map
-		addNewFragment(hash, fragData);
+		addNewPacket(hash, fragData);
 	}
 	else // packet was seen before
 	{
-		// get the IPFragmentData object
-		fragData = iter->second;
-
 		// mark this packet as used
-		m_PacketLRU.put(hash, NULL);
+		listRemove(m_LRUList, fragData, &IPFragmentData::lruLinks);
+		listPushBack(m_LRUList, fragData, &IPFragmentData::lruLinks);
 	}
 
 	bool gotLastFragment = false;
@@ -344,6 +390,8 @@ Packet* IPReassembly::processPacket(Packet* fragment, ReassemblyStatus& status,
 			// create the reassembled packet and copy the fragment data to it
 			fragData->data = new RawPacket(*(fragment->getRawPacket()));
 			fragData->currentOffset = fragWrapper->getIPLayerPayloadSize();
+			fragData->memoryUsage += fragData->data->getRawDataLen();
+			m_CurrentMemoryUsage += fragData->data->getRawDataLen();
 			status = FIRST_FRAGMENT;
 
 			// check if the next fragments already arrived out-of-order and waiting in the out-of-order list
@@ -383,6 +431,8 @@ Packet* IPReassembly::processPacket(Packet* fragment, ReassemblyStatus& status,
 
 			// update expected offset
 			fragData->currentOffset += payloadSize;
+			fragData->memoryUsage += payloadSize;
+			m_CurrentMemoryUsage += payloadSize;
 
 			// if this is the last fragment - mark it
 			if (fragWrapper->isLastFragment())
@@ -407,8 +457,13 @@ Packet* IPReassembly::processPacket(Packet* fragment, ReassemblyStatus& status,
 
 			// store the IPFragment in the out-of-order fragment list
 			fragData->outOfOrderFragments.pushBack(newFrag);
+			fragData->memoryUsage += payloadSize;
+			m_CurrentMemoryUsage += payloadSize;
 
 			status = OUT_OF_ORDER_FRAGMENT;
+
+			// this may drop the current packet too, if it alone exceeds the memory limit
+			enforceMemoryLimit();
 			return NULL;
 		}
 		else
@@ -460,9 +515,7 @@ Packet* IPReassembly::processPacket(Packet* fragment, ReassemblyStatus& status,
 		LOG_DEBUG("[FragID=0x%X] Deleting fragment data from map", fragWrapper->getFragmentId());
 
 		// delete the IPFragmentData object and remove it from the map
-		delete fragData;
-		m_FragmentMap.erase(iter);
-		m_PacketLRU.eraseElement(hash);
+		removePacketData(fragData);
 		status = REASSEMBLED;
 		return reassembledPacket;
 	}
@@ -471,6 +524,8 @@ Packet* IPReassembly::processPacket(Packet* fragment, ReassemblyStatus& status,
 	if (status != FIRST_FRAGMENT)
 		status = FRAGMENT;
 
+	// this may drop the current packet too, if it alone exceeds the memory limit
+	enforceMemoryLimit();
 	return NULL;
 }
 
@@ -489,16 +544,14 @@ Packet* IPReassembly::getCurrentPacket(const PacketKey& key)
 	// create a hash out of the packet key
 	uint32_t hash = key.getHashValue();
 
-	// look for this hash value in the map
-	std::map<uint32_t, IPFragmentData*>::iterator iter = m_FragmentMap.find(hash);
+	// look for this packet in the map
+	IPFragmentData* fragData = findPacket(hash, key);
 
-	// hash was found
-	if (iter != m_FragmentMap.end())
+	// packet was found
+	if (fragData != NULL)
 	{
-		IPFragmentData* fragData = iter->second;
-
 		// some data already exists
-		if (fragData != NULL && fragData->data != NULL)
+		if (fragData->data != NULL)
 		{
 			// create a copy of the RawPacket object
 			RawPacket* partialRawPacket = new RawPacket(*(fragData->data));
@@ -545,51 +598,162 @@ void IPReassembly::removePacket(const PacketKey& key)
 	// create a hash out of the packet key
 	uint32_t hash = key.getHashValue();
 
-	// look for this hash value in the map
-	std::map<uint32_t, IPFragmentData*>::iterator iter = m_FragmentMap.find(hash);
+	// look for this packet in the map
+	IPFragmentData* fragData = findPacket(hash, key);
+
+	// packet was found, free all data saved in the map
+	if (fragData != NULL)
+		removePacketData(fragData);
+}
+
+IPReassembly::IPFragmentData* IPReassembly::findPacket(uint32_t hash, const PacketKey& key)
+{
+	// the whole key is compared, so packets with the same hash value are told apart
+	IPFragmentData* fragData = m_HashTable[hash & (m_HashTable.size() - 1)];
+	while (fragData != NULL)
+	{
+		if (fragData->hash == hash && isSamePacketKey(*fragData->packetKey, key))
+			return fragData;
+
+		fragData = fragData->nextInBucket;
+	}
+
+	return NULL;
+}
 
-	// hash was found
-	if (iter != m_FragmentMap.end())
+void IPReassembly::addNewPacket(uint32_t hash, IPFragmentData* fragData)
+{
+	// if reached maximum capacity, remove the least recently used packet
+	if (m_NumOfPackets >= m_MaxPacketsToStore && m_LRUList.head != NULL)
 	{
-		// free all data saved in the map
-		delete iter->second;
-		m_FragmentMap.erase(iter);
+		LOG_DEBUG("Reached maximum packet capacity, removing data for FragID=0x%X", m_LRUList.head->fragmentID);
+		dropPacket(m_LRUList.head, false);
+	}
+
+	// keep the average bucket length at most 1
+	if (m_NumOfPackets >= m_HashTable.size())
+		rehash(m_HashTable.size() * 2);
+
+	fragData->hash = hash;
+	fragData->creationTime = m_LatestPacketTime;
+
+	IPFragmentData*& bucket = m_HashTable[hash & (m_HashTable.size() - 1)];
+	fragData->nextInBucket = bucket;
+	bucket = fragData;
+
+	listPushBack(m_LRUList, fragData, &IPFragmentData::lruLinks);
+	listPushBack(m_AgeList, fragData, &IPFragmentData::ageLinks);
+	m_NumOfPackets++;
+}
+
+void IPReassembly::removePacketData(IPFragmentData* fragData)
+{
+	IPFragmentData** bucketEntry = &m_HashTable[fragData->hash & (m_HashTable.size() - 1)];
+	while (*bucketEntry != fragData)
+		bucketEntry = &((*bucketEntry)->nextInBucket);
+	*bucketEntry = fragData->nextInBucket;
+
+	listRemove(m_LRUList, fragData, &IPFragmentData::lruLinks);
+	listRemove(m_AgeList, fragData, &IPFragmentData::ageLinks);
+	m_NumOfPackets--;
+	m_CurrentMemoryUsage -= fragData->memoryUsage;
 
-		// remove from LRU list
-		m_PacketLRU.eraseElement(hash);
+	delete fragData;
+}
+
+void IPReassembly::dropPacket(IPFragmentData* fragData, bool timedOut)
+{
+	PacketKey* key = NULL;
+	if (m_OnFragmentsCleanCallback != NULL)
+		key = fragData->packetKey->clone();
+
+	if (timedOut)
+		m_NumOfTimedOutPackets++;
+	else
+		m_NumOfEvictedPackets++;
+
+	removePacketData(fragData);
+
+	// fire callback if not null
+	if (m_OnFragmentsCleanCallback != NULL)
+	{
+		m_OnFragmentsCleanCallback(key, m_CallbackUserCookie);
+		delete key;
 	}
 }
 
-void IPReassembly::addNewFragment(uint32_t hash, IPFragmentData* fragData)
+void IPReassembly::dropTimedOutPackets()
 {
-	// put the new frag in the LRU list
-	uint32_t packetRemoved;
+	if (m_PacketTimeout == 0)
+		return;
 
-	if (m_PacketLRU.put(hash, &packetRemoved) == 1) // this means LRU list was full and the least recently used item was removed
+	// packets are created with the current time which never goes backwards, so the creation time list is sorted by time out
+	while (m_AgeList.head != NULL && m_LatestPacketTime > m_AgeList.head->creationTime + (time_t)m_PacketTimeout)
 	{
-		// remove this item from the fragment map
-		std::map<uint32_t, IPFragmentData*>::iterator iter = m_FragmentMap.find(packetRemoved);
-		IPFragmentData* dataRemoved = iter->second;
+		LOG_DEBUG("Packet with FragID=0x%X timed out, removing its data", m_AgeList.head->fragmentID);
+		dropPacket(m_AgeList.head, true);
+	}
+}
 
-		PacketKey* key = NULL;
-		if (m_OnFragmentsCleanCallback != NULL)
-			key = dataRemoved->packetKey->clone();
+void IPReassembly::enforceMemoryLimit()
+{
+	if (m_MaxBytesToStore == 0)
+		return;
 
-		LOG_DEBUG("Reached maximum packet capacity, removing data for FragID=0x%X", dataRemoved->fragmentID);
-		delete dataRemoved;
-		m_FragmentMap.erase(iter);
+	while (m_CurrentMemoryUsage > m_MaxBytesToStore && m_LRUList.head != NULL)
+	{
+		LOG_DEBUG("Reached maximum memory usage, removing data for FragID=0x%X", m_LRUList.head->fragmentID);
+		dropPacket(m_LRUList.head, false);
+	}
+}
+
+void IPReassembly::rehash(size_t newSize)
+{
+	std::vector<IPFragmentData*> newHashTable(newSize, (IPFragmentData*)NULL);
 
-		// fire callback if not null
-		if (m_OnFragmentsCleanCallback != NULL)
+	for (std::vector<IPFragmentData*>::iterator iter = m_HashTable.begin(); iter != m_HashTable.end(); ++iter)
+	{
+		IPFragmentData* fragData = *iter;
+		while (fragData != NULL)
 		{
-			m_OnFragmentsCleanCallback(key, m_CallbackUserCookie);
-			delete key;
+			IPFragmentData* next = fragData->nextInBucket;
+			IPFragmentData*& bucket = newHashTable[fragData->hash & (newSize - 1)];
+			fragData->nextInBucket = bucket;
+			bucket = fragData;
+			fragData = next;
 		}
 	}
 
-	// add the new fragment to the map
-	std::pair<uint32_t, IPFragmentData*> pair(hash, fragData);
-	m_FragmentMap.insert(pair);
+	m_HashTable.swap(newHashTable);
+}
+
+void IPReassembly::listPushBack(FragmentList& list, IPFragmentData* fragData, FragmentListLinks IPFragmentData::* links)
+{
+	(fragData->*links).prev = list.tail;
+	(fragData->*links).next = NULL;
+	if (list.tail != NULL)
+		(list.tail->*links).next = fragData;
+	else
+		list.head = fragData;
+	list.tail = fragData;
+}
+
+void IPReassembly::listRemove(FragmentList& list, IPFragmentData* fragData, FragmentListLinks IPFragmentData::* links)
+{
+	FragmentListLinks& fragLinks = fragData->*links;
+
+	if (fragLinks.prev != NULL)
+		(fragLinks.prev->*links).next = fragLinks.next;
+	else
+		list.head = fragLinks.next;
+
+	if (fragLinks.next != NULL)
+		(fragLinks.next->*links).prev = fragLinks.prev;
+	else
+		list.tail = fragLinks.prev;
+
+	fragLinks.prev = NULL;
+	fragLinks.next = NULL;
 }
 
 bool IPReassembly::matchOutOfOrderFragments(IPFragmentData* fragData)
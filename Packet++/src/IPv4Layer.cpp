@@ -255,7 +255,7 @@ void IPv4Layer::parseNextLayer()
 	// TODO: assuming first fragment contains at least L4 header, what if it's not true?
 	if (isFragment())
 	{
-		m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet);
 		return;
 	}
 
@@ -263,52 +263,52 @@ void IPv4Layer::parseNextLayer()
 	{
 	case PACKETPP_IPPROTO_UDP:
 		if (payloadLen >= sizeof(udphdr))
-			m_NextLayer = new UdpLayer(payload, payloadLen, this, m_Packet);
+			m_NextLayer = new(m_Packet) UdpLayer(payload, payloadLen, this, m_Packet);
 		break;
 	case PACKETPP_IPPROTO_TCP:
 		m_NextLayer = TcpLayer::isDataValid(payload, payloadLen)
-			? static_cast<Layer*>(new TcpLayer(payload, payloadLen, this, m_Packet))
-			: static_cast<Layer*>(new PayloadLayer(payload, payloadLen, this, m_Packet));
+			? static_cast<Layer*>(new(m_Packet) TcpLayer(payload, payloadLen, this, m_Packet))
+			: static_cast<Layer*>(new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet));
 		break;
 	case PACKETPP_IPPROTO_ICMP:
-		m_NextLayer = new IcmpLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) IcmpLayer(payload, payloadLen, this, m_Packet);
 		break;
 	case PACKETPP_IPPROTO_IPIP:
 		ipVersion = *payload >> 4;
 		if (ipVersion == 4)
-			m_NextLayer = new IPv4Layer(payload, payloadLen, this, m_Packet);
+			m_NextLayer = new(m_Packet) IPv4Layer(payload, payloadLen, this, m_Packet);
 		else if (ipVersion == 6)
-			m_NextLayer = new IPv6Layer(payload, payloadLen, this, m_Packet);
+			m_NextLayer = new(m_Packet) IPv6Layer(payload, payloadLen, this, m_Packet);
 		else
-			m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+			m_NextLayer = new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet);
 		break;
 	case PACKETPP_IPPROTO_GRE:
 		greVer = GreLayer::getGREVersion(payload, payloadLen);
 		if (greVer == GREv0)
-			m_NextLayer = new GREv0Layer(payload, payloadLen, this, m_Packet);
+			m_NextLayer = new(m_Packet) GREv0Layer(payload, payloadLen, this, m_Packet);
 		else if (greVer == GREv1)
-			m_NextLayer = new GREv1Layer(payload, payloadLen, this, m_Packet);
+			m_NextLayer = new(m_Packet) GREv1Layer(payload, payloadLen, this, m_Packet);
 		else
-			m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+			m_NextLayer = new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet);
 		break;
 	case PACKETPP_IPPROTO_IGMP:
 		igmpVer = IgmpLayer::getIGMPVerFromData(payload, be16toh(getIPv4Header()->totalLength) - hdrLen, igmpQuery);
 		if (igmpVer == IGMPv1)
-			m_NextLayer = new IgmpV1Layer(payload, payloadLen, this, m_Packet);
+			m_NextLayer = new(m_Packet) IgmpV1Layer(payload, payloadLen, this, m_Packet);
 		else if (igmpVer == IGMPv2)
-			m_NextLayer = new IgmpV2Layer(payload, payloadLen, this, m_Packet);
+			m_NextLayer = new(m_Packet) IgmpV2Layer(payload, payloadLen, this, m_Packet);
 		else if (igmpVer == IGMPv3)
 		{
 			if (igmpQuery)
-				m_NextLayer = new IgmpV3QueryLayer(payload, payloadLen, this, m_Packet);
+				m_NextLayer = new(m_Packet) IgmpV3QueryLayer(payload, payloadLen, this, m_Packet);
 			else
-				m_NextLayer = new IgmpV3ReportLayer(payload, payloadLen, this, m_Packet);
+				m_NextLayer = new(m_Packet) IgmpV3ReportLayer(payload, payloadLen, this, m_Packet);
 		}
 		else
-			m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+			m_NextLayer = new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet);
 		break;
 	default:
-		m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet);
 	}
 }
 
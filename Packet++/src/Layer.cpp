@@ -8,13 +8,75 @@
 namespace pcpp
 {
 
+// Every layer memory block is prefixed with a header holding the usable block size. The header is 16 bytes long so the layer
+// instance that follows it keeps the alignment guaranteed by ::operator new
+#define LAYER_BLOCK_HEADER_SIZE 16
+
+void* Layer::allocateBlock(size_t size)
+{
+	// round the block size up so blocks can be recycled for any layer of the same size class
+	size_t blockSize = ((size + PCPP_LAYER_BLOCK_GRANULARITY - 1) / PCPP_LAYER_BLOCK_GRANULARITY) * PCPP_LAYER_BLOCK_GRANULARITY;
+	uint8_t* block = (uint8_t*)::operator new(blockSize + LAYER_BLOCK_HEADER_SIZE);
+	*(size_t*)block = blockSize;
+	return block + LAYER_BLOCK_HEADER_SIZE;
+}
+
+void Layer::freeBlock(void* ptr)
+{
+	if (ptr != NULL)
+		::operator delete((uint8_t*)ptr - LAYER_BLOCK_HEADER_SIZE);
+}
+
+size_t Layer::getBlockSize(void* ptr)
+{
+	return *(size_t*)((uint8_t*)ptr - LAYER_BLOCK_HEADER_SIZE);
+}
+
+void* Layer::operator new(size_t size)
+{
+	return allocateBlock(size);
+}
+
+void* Layer::operator new(size_t size, Packet* packet)
+{
+	if (packet != NULL)
+	{
+		// take a recycled block of the same size class from the packet if there is one
+		size_t bucket = (size + PCPP_LAYER_BLOCK_GRANULARITY - 1) / PCPP_LAYER_BLOCK_GRANULARITY - 1;
+		if (bucket < PCPP_LAYER_BLOCK_CACHE_BUCKETS && packet->m_LayerBlockCache[bucket] != NULL)
+		{
+			void* block = packet->m_LayerBlockCache[bucket];
+			packet->m_LayerBlockCache[bucket] = *(void**)block;
+			return block;
+		}
+	}
+
+	return allocateBlock(size);
+}
+
+void Layer::operator delete(void* ptr)
+{
+	freeBlock(ptr);
+}
+
+void Layer::operator delete(void* ptr, Packet* packet)
+{
+	freeBlock(ptr);
+}
+
+Layer* Layer::parsePendingNextLayer() const
+{
+	m_Packet->parseRemainingLayers();
+	return m_NextLayer;
+}
+
 Layer::~Layer()
 {
 	if (!isAllocatedToPacket())
 		delete [] m_Data;
 }
 
-Layer::Layer(const Layer& other) : m_Packet(NULL), m_Protocol(other.m_Protocol), m_NextLayer(NULL), m_PrevLayer(NULL), m_IsAllocatedInPacket(false)
+Layer::Layer(const Layer& other) : m_Packet(NULL), m_Protocol(other.m_Protocol), m_NextLayer(NULL), m_PrevLayer(NULL), m_IsAllocatedInPacket(false), m_IsNextLayerPending(false)
 {
 	m_DataLen = other.getHeaderLen();
 	m_Data = new uint8_t[other.m_DataLen];
@@ -36,6 +98,7 @@ Layer& Layer::operator=(const Layer& other)
 	m_PrevLayer = NULL;
 	m_Data = new uint8_t[other.m_DataLen];
 	m_IsAllocatedInPacket = false;
+	m_IsNextLayerPending = false;
 	memcpy(m_Data, other.m_Data, other.m_DataLen);
 
 	return *this;
@@ -7,6 +7,8 @@
 #include "NullLoopbackLayer.h"
 #include "IPv4Layer.h"
 #include "IPv6Layer.h"
+#include "TcpLayer.h"
+#include "UdpLayer.h"
 #include "PayloadLayer.h"
 #include "PacketTrailerLayer.h"
 #include "Logger.h"
@@ -29,8 +31,10 @@ Packet::Packet(size_t maxPacketLen) :
 	m_LastLayer(NULL),
 	m_ProtocolTypes(UnknownProtocol),
 	m_MaxPacketLen(maxPacketLen),
-	m_FreeRawPacket(true)
+	m_FreeRawPacket(true),
+	m_LazyParseLayer(NULL)
 {
+	initLayerBlockCache();
 	timeval time;
 	gettimeofday(&time, NULL);
 	uint8_t* data = new uint8_t[maxPacketLen];
@@ -38,12 +42,13 @@ Packet::Packet(size_t maxPacketLen) :
 	m_RawPacket = new RawPacket(data, 0, time, true, LINKTYPE_ETHERNET);
 }
 
-void Packet::setRawPacket(RawPacket* rawPacket, bool freeRawPacket, ProtocolType parseUntil, OsiModelLayer parseUntilLayer)
+void Packet::setRawPacket(RawPacket* rawPacket, bool freeRawPacket, ProtocolType parseUntil, OsiModelLayer parseUntilLayer, bool lazyParsing)
 {
 	destructPacketData();
 
 	m_FirstLayer = NULL;
 	m_LastLayer = NULL;
+	m_LazyParseLayer = NULL;
 	m_ProtocolTypes = UnknownProtocol;
 	m_MaxPacketLen = rawPacket->getRawDataLen();
 	m_FreeRawPacket = freeRawPacket;
@@ -55,13 +60,18 @@ void Packet::setRawPacket(RawPacket* rawPacket, bool freeRawPacket, ProtocolType
 
 	m_FirstLayer = createFirstLayer(linkType);
 
+	// parsing up to a certain layer already skips the upper layers
+	lazyParsing = lazyParsing && parseUntil == UnknownProtocol && parseUntilLayer == OsiModelLayerUnknown;
+
 	m_LastLayer = m_FirstLayer;
 	Layer* curLayer = m_FirstLayer;
 	while (curLayer != NULL && (curLayer->getProtocol() & parseUntil) == 0 && curLayer->getOsiModelLayer() <= parseUntilLayer)
 	{
 		m_ProtocolTypes |= curLayer->getProtocol();
-		curLayer->parseNextLayer();
 		curLayer->m_IsAllocatedInPacket = true;
+		if (lazyParsing && deferNextLayers(curLayer))
+			return;
+		curLayer->parseNextLayer();
 		curLayer = curLayer->getNextLayer();
 		if (curLayer != NULL)
 			m_LastLayer = curLayer;
@@ -76,41 +86,138 @@ void Packet::setRawPacket(RawPacket* rawPacket, bool freeRawPacket, ProtocolType
 	if (curLayer != NULL &&  curLayer->getOsiModelLayer() > parseUntilLayer)
 	{
 		m_LastLayer = curLayer->getPrevLayer();
-		delete curLayer;
+		recycleLayer(curLayer);
 		m_LastLayer->m_NextLayer = NULL;
 	}
 
-	if (m_LastLayer != NULL && parseUntil == UnknownProtocol && parseUntilLayer == OsiModelLayerUnknown)
+	if (parseUntil == UnknownProtocol && parseUntilLayer == OsiModelLayerUnknown)
+		createPacketTrailerLayer();
+}
+
+int Packet::getPacketTrailerLen() const
+{
+	// find if there is data left in the raw packet that doesn't belong to any layer. In that case it's probably a packet trailer
+	return (int)((m_RawPacket->getRawData() + m_RawPacket->getRawDataLen()) - (m_LastLayer->getData() + m_LastLayer->getDataLen()));
+}
+
+void Packet::createPacketTrailerLayer()
+{
+	if (m_LastLayer == NULL)
+		return;
+
+	// create a PacketTrailerLayer layer and add it at the end of the packet
+	int trailerLen = getPacketTrailerLen();
+	if (trailerLen > 0)
 	{
-		// find if there is data left in the raw packet that doesn't belong to any layer. In that case it's probably a packet trailer.
-		// create a PacketTrailerLayer layer and add it at the end of the packet
-		int trailerLen = (int)((m_RawPacket->getRawData() + m_RawPacket->getRawDataLen()) - (m_LastLayer->getData() + m_LastLayer->getDataLen()));
-		if (trailerLen > 0)
-		{
-			PacketTrailerLayer* trailerLayer = new PacketTrailerLayer(
-					(uint8_t*)(m_LastLayer->getData() + m_LastLayer->getDataLen()),
-					trailerLen,
-					m_LastLayer,
-					this);
-
-			trailerLayer->m_IsAllocatedInPacket = true;
-			m_LastLayer->setNextLayer(trailerLayer);
-			m_LastLayer = trailerLayer;
-			m_ProtocolTypes |= trailerLayer->getProtocol();
-		}
+		PacketTrailerLayer* trailerLayer = new(this) PacketTrailerLayer(
+				(uint8_t*)(m_LastLayer->getData() + m_LastLayer->getDataLen()),
+				trailerLen,
+				m_LastLayer,
+				this);
+
+		trailerLayer->m_IsAllocatedInPacket = true;
+		m_LastLayer->setNextLayer(trailerLayer);
+		m_LastLayer = trailerLayer;
+		m_ProtocolTypes |= trailerLayer->getProtocol();
 	}
 }
 
-Packet::Packet(RawPacket* rawPacket, bool freeRawPacket, ProtocolType parseUntil, OsiModelLayer parseUntilLayer)
+bool Packet::deferNextLayers(Layer* layer)
+{
+	// only the application layers are deferred. Lower layers are cheap to create and most of them are needed to identify
+	// the protocols of the layers above them
+	ProtocolType nextProtocol = UnknownProtocol;
+	if (layer->getProtocol() == TCP)
+		nextProtocol = static_cast<TcpLayer*>(layer)->getNextLayerProtocol();
+	else if (layer->getProtocol() == UDP)
+		nextProtocol = static_cast<UdpLayer*>(layer)->getNextLayerProtocol();
+
+	// tunnels (VXLAN, GTP) are parsed right away because the protocols they carry can't be known without parsing them
+	if (nextProtocol == UnknownProtocol || nextProtocol == VXLAN || nextProtocol == GTP)
+		return false;
+
+	m_ProtocolTypes |= nextProtocol;
+
+	// the layers above this layer end where it ends, so a packet trailer can already be detected
+	if (getPacketTrailerLen() > 0)
+		m_ProtocolTypes |= PacketTrailer;
+
+	layer->m_IsNextLayerPending = true;
+	m_LazyParseLayer = layer;
+	return true;
+}
+
+void Packet::parseRemainingLayers()
+{
+	if (m_LazyParseLayer == NULL)
+		return;
+
+	Layer* curLayer = m_LazyParseLayer;
+	curLayer->m_IsNextLayerPending = false;
+	m_LazyParseLayer = NULL;
+
+	while (curLayer != NULL)
+	{
+		m_ProtocolTypes |= curLayer->getProtocol();
+		curLayer->parseNextLayer();
+		curLayer->m_IsAllocatedInPacket = true;
+		curLayer = curLayer->getNextLayer();
+		if (curLayer != NULL)
+			m_LastLayer = curLayer;
+	}
+
+	createPacketTrailerLayer();
+}
+
+bool Packet::isUnparsedLayerOfType(ProtocolType protocolType) const
+{
+	// the protocol of the first unparsed layer and the packet trailer are already known. The only other protocols
+	// that may follow are the SIP message body (SDP) and the HTTP/SIP message body (generic payload)
+	ProtocolType unparsedProtocols = UnknownProtocol;
+	if (m_ProtocolTypes & SIP)
+		unparsedProtocols = SDP | GenericPayload;
+	else if (m_ProtocolTypes & HTTP)
+		unparsedProtocols = GenericPayload;
+
+	if ((protocolType & unparsedProtocols) == 0)
+		return false;
+
+	const_cast<Packet*>(this)->parseRemainingLayers();
+	return (m_ProtocolTypes & protocolType) != 0;
+}
+
+Layer* Packet::getLastLayerForLookup(ProtocolType protocolType) const
+{
+	// in lazy parsing mode the last parsed layer is the transport layer. The layers above it may only be of the application
+	// protocols identified by TcpLayer/UdpLayer::getNextLayerProtocol(), the protocols these layers carry, or a packet trailer.
+	// Reverse lookups for other protocols can start from the transport layer without parsing the rest of the packet
+	const ProtocolType unparsedProtocols = HTTP | SSL | SIP | SDP | BGP | DHCP | DNS | Radius | GenericPayload | PacketTrailer;
+	if (m_LazyParseLayer != NULL && protocolType != UnknownProtocol && (protocolType & unparsedProtocols) == 0)
+		return m_LastLayer;
+
+	return getLastLayer();
+}
+
+Layer* Packet::getLastLayer() const
+{
+	if (m_LazyParseLayer != NULL)
+		const_cast<Packet*>(this)->parseRemainingLayers();
+
+	return m_LastLayer;
+}
+
+Packet::Packet(RawPacket* rawPacket, bool freeRawPacket, ProtocolType parseUntil, OsiModelLayer parseUntilLayer, bool lazyParsing)
 {
+	initLayerBlockCache();
 	m_FreeRawPacket = false;
 	m_RawPacket = NULL;
 	m_FirstLayer = NULL;
-	setRawPacket(rawPacket, freeRawPacket, parseUntil, parseUntilLayer);
+	setRawPacket(rawPacket, freeRawPacket, parseUntil, parseUntilLayer, lazyParsing);
 }
 
 Packet::Packet(RawPacket* rawPacket, ProtocolType parseUntil)
 {
+	initLayerBlockCache();
 	m_FreeRawPacket = false;
 	m_RawPacket = NULL;
 	m_FirstLayer = NULL;
@@ -119,20 +226,27 @@ Packet::Packet(RawPacket* rawPacket, ProtocolType parseUntil)
 
 Packet::Packet(RawPacket* rawPacket, OsiModelLayer parseUntilLayer)
 {
+	initLayerBlockCache();
 	m_FreeRawPacket = false;
 	m_RawPacket = NULL;
 	m_FirstLayer = NULL;
 	setRawPacket(rawPacket, false, UnknownProtocol, parseUntilLayer);
 }
 
-void Packet::destructPacketData()
+void Packet::destructPacketData(bool recycleLayers)
 {
 	Layer* curLayer = m_FirstLayer;
 	while (curLayer != NULL)
 	{
-		Layer* nextLayer = curLayer->getNextLayer();
+		// don't use getNextLayer() here as it parses the layers that weren't parsed yet in lazy parsing mode
+		Layer* nextLayer = curLayer->m_NextLayer;
 		if (curLayer->m_IsAllocatedInPacket)
-			delete curLayer;
+		{
+			if (recycleLayers)
+				recycleLayer(curLayer);
+			else
+				delete curLayer;
+		}
 		curLayer = nextLayer;
 	}
 
@@ -142,6 +256,44 @@ void Packet::destructPacketData()
 	}
 }
 
+void Packet::initLayerBlockCache()
+{
+	for (int i = 0; i < PCPP_LAYER_BLOCK_CACHE_BUCKETS; i++)
+		m_LayerBlockCache[i] = NULL;
+}
+
+void Packet::clearLayerBlockCache()
+{
+	for (int i = 0; i < PCPP_LAYER_BLOCK_CACHE_BUCKETS; i++)
+	{
+		void* block = m_LayerBlockCache[i];
+		while (block != NULL)
+		{
+			void* nextBlock = *(void**)block;
+			Layer::freeBlock(block);
+			block = nextBlock;
+		}
+
+		m_LayerBlockCache[i] = NULL;
+	}
+}
+
+void Packet::recycleLayer(Layer* layer)
+{
+	layer->~Layer();
+
+	// the block size is always a multiple of PCPP_LAYER_BLOCK_GRANULARITY, see Layer::allocateBlock()
+	size_t bucket = Layer::getBlockSize(layer) / PCPP_LAYER_BLOCK_GRANULARITY - 1;
+	if (bucket < PCPP_LAYER_BLOCK_CACHE_BUCKETS)
+	{
+		// the freed block is used as a link in the bucket's list
+		*(void**)layer = m_LayerBlockCache[bucket];
+		m_LayerBlockCache[bucket] = layer;
+	}
+	else
+		Layer::freeBlock(layer);
+}
+
 Packet& Packet::operator=(const Packet& other)
 {
 	destructPacketData();
@@ -153,6 +305,10 @@ Packet& Packet::operator=(const Packet& other)
 
 void Packet::copyDataFrom(const Packet& other)
 {
+	// copy the protocols of all layers, including those that weren't parsed yet
+	const_cast<Packet&>(other).parseRemainingLayers();
+
+	m_LazyParseLayer = NULL;
 	m_RawPacket = new RawPacket(*(other.m_RawPacket));
 	m_FreeRawPacket = true;
 	m_MaxPacketLen = other.m_MaxPacketLen;
@@ -217,6 +373,8 @@ bool Packet::insertLayer(Layer* prevLayer, Layer* newLayer, bool ownInPacket)
 		return false;
 	}
 
+	parseRemainingLayers();
+
 	size_t newLayerHeaderLen = newLayer->getHeaderLen();
 	if (m_RawPacket->getRawDataLen() + newLayerHeaderLen > m_MaxPacketLen)
 	{
@@ -398,6 +556,8 @@ bool Packet::removeLayer(Layer* layer, bool tryToDelete)
 		return false;
 	}
 
+	parseRemainingLayers();
+
 	// before removing the layer's data, copy it so it can be later assigned as the removed layer's data
 	size_t headerLen = layer->getHeaderLen();
 	size_t layerOldDataSize = headerLen;
@@ -477,7 +637,7 @@ bool Packet::removeLayer(Layer* layer, bool tryToDelete)
 	// if layer was allocated by this packet and tryToDelete flag is set, delete it
 	if (tryToDelete && layer->m_IsAllocatedInPacket)
 	{
-		delete layer;
+		recycleLayer(layer);
 		delete [] layerOldData;
 	}
 	// if layer was not allocated by this packet or the tryToDelete is not set, detach it from the packet so it can be reused
@@ -493,6 +653,10 @@ bool Packet::removeLayer(Layer* layer, bool tryToDelete)
 
 Layer* Packet::getLayerOfType(ProtocolType layerType, int index) const
 {
+	// no need to parse the remaining layers if the packet doesn't contain this protocol
+	if (m_LazyParseLayer != NULL && !isPacketOfType(layerType))
+		return NULL;
+
 	Layer* curLayer = getFirstLayer();
 	int curIndex = 0;
 	while (curLayer != NULL)
@@ -525,6 +689,8 @@ bool Packet::extendLayer(Layer* layer, int offsetInLayer, size_t numOfBytesToExt
 		return false;
 	}
 
+	parseRemainingLayers();
+
 	if (m_RawPacket->getRawDataLen() + numOfBytesToExtend > m_MaxPacketLen)
 	{
 		// reallocate to maximum value of: twice the max size of the packet or max size + new required length
@@ -585,6 +751,8 @@ bool Packet::shortenLayer(Layer* layer, int offsetInLayer, size_t numOfBytesToSh
 		return false;
 	}
 
+	parseRemainingLayers();
+
 	// remove data from raw packet
 	int indexOfDataToRemove = layer->m_Data + offsetInLayer - m_RawPacket->getRawData();
 	if (!m_RawPacket->removeData(indexOfDataToRemove, numOfBytesToShorten))
@@ -625,7 +793,7 @@ void Packet::computeCalculateFields()
 {
 	// calculated fields should be calculated from top layer to bottom layer
 
-	Layer* curLayer = m_LastLayer;
+	Layer* curLayer = getLastLayer();
 	while (curLayer != NULL)
 	{
 		curLayer->computeCalculateFields();
@@ -697,19 +865,19 @@ Layer* Packet::createFirstLayer(LinkLayerType linkType)
 			uint16_t ethTypeOrLength = be16toh(*(uint16_t*)(rawData + 12));
 			if (ethTypeOrLength <= (uint16_t)0x5dc && ethTypeOrLength != 0)
 			{
-				return new EthDot3Layer((uint8_t*)rawData, rawDataLen, this);
+				return new(this) EthDot3Layer((uint8_t*)rawData, rawDataLen, this);
 			}
 		}
 		
-		return new EthLayer((uint8_t*)rawData, rawDataLen, this);
+		return new(this) EthLayer((uint8_t*)rawData, rawDataLen, this);
 	}
 	else if (linkType == LINKTYPE_LINUX_SLL)
 	{
-		return new SllLayer((uint8_t*)rawData, rawDataLen, this);
+		return new(this) SllLayer((uint8_t*)rawData, rawDataLen, this);
 	}
 	else if (linkType == LINKTYPE_NULL)
 	{
-		return new NullLoopbackLayer((uint8_t*)rawData, rawDataLen, this);
+		return new(this) NullLoopbackLayer((uint8_t*)rawData, rawDataLen, this);
 	}
 	else if (linkType == LINKTYPE_RAW || linkType == LINKTYPE_DLT_RAW1 || linkType == LINKTYPE_DLT_RAW2)
 	{
@@ -717,23 +885,23 @@ Layer* Packet::createFirstLayer(LinkLayerType linkType)
 		if (ipVer == 0x40)
 		{
 			return IPv4Layer::isDataValid(rawData, rawDataLen)
-				? static_cast<Layer*>(new IPv4Layer((uint8_t*)rawData, rawDataLen, NULL, this))
-				: static_cast<Layer*>(new PayloadLayer((uint8_t*)rawData, rawDataLen, NULL, this));
+				? static_cast<Layer*>(new(this) IPv4Layer((uint8_t*)rawData, rawDataLen, NULL, this))
+				: static_cast<Layer*>(new(this) PayloadLayer((uint8_t*)rawData, rawDataLen, NULL, this));
 		}
 		else if (ipVer == 0x60)
 		{
 			return IPv6Layer::isDataValid(rawData, rawDataLen)
-				? static_cast<Layer*>(new IPv6Layer((uint8_t*)rawData, rawDataLen, NULL, this))
-				: static_cast<Layer*>(new PayloadLayer((uint8_t*)rawData, rawDataLen, NULL, this));
+				? static_cast<Layer*>(new(this) IPv6Layer((uint8_t*)rawData, rawDataLen, NULL, this))
+				: static_cast<Layer*>(new(this) PayloadLayer((uint8_t*)rawData, rawDataLen, NULL, this));
 		}
 		else
 		{
-			return new PayloadLayer((uint8_t*)rawData, rawDataLen, NULL, this);
+			return new(this) PayloadLayer((uint8_t*)rawData, rawDataLen, NULL, this);
 		}
 	}
 
 	// unknown link type
-	return new EthLayer((uint8_t*)rawData, rawDataLen, this);
+	return new(this) EthLayer((uint8_t*)rawData, rawDataLen, this);
 }
 
 std::string Packet::toString(bool timeAsLocalTime)
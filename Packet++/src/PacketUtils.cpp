@@ -5,6 +5,9 @@
 #include "IPv6Layer.h"
 #include "TcpLayer.h"
 #include "UdpLayer.h"
+#include "EthLayer.h"
+#include "VlanLayer.h"
+#include "PPPoELayer.h"
 
 namespace pcpp
 {
@@ -115,4 +118,276 @@ uint32_t hash2Tuple(Packet* packet)
 	return pcpp::fnv_hash(vec, 2);
 }
 
+// Ethertypes of stacked VLAN tags and multicast MPLS which don't have a definition in EthLayer.h
+#define FAST_HASH_ETHERTYPE_QINQ		0x88a8
+#define FAST_HASH_ETHERTYPE_QINQ_OLD	0x9100
+#define FAST_HASH_ETHERTYPE_MPLS_MC		0x8848
+
+#define FAST_HASH_SLL_HEADER_LEN		16
+#define FAST_HASH_NULL_HEADER_LEN		4
+
+// CRC32C (Castagnoli) lookup table of the reflected polynomial 0x82f63b78
+static const uint32_t Crc32cTable[256] = {
+	0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c,
+	0x26a1e7e8, 0xd4ca64eb, 0x8ad958cf, 0x78b2dbcc, 0x6be22838, 0x9989ab3b,
+	0x4d43cfd0, 0xbf284cd3, 0xac78bf27, 0x5e133c24, 0x105ec76f, 0xe235446c,
+	0xf165b798, 0x030e349b, 0xd7c45070, 0x25afd373, 0x36ff2087, 0xc494a384,
+	0x9a879fa0, 0x68ec1ca3, 0x7bbcef57, 0x89d76c54, 0x5d1d08bf, 0xaf768bbc,
+	0xbc267848, 0x4e4dfb4b, 0x20bd8ede, 0xd2d60ddd, 0xc186fe29, 0x33ed7d2a,
+	0xe72719c1, 0x154c9ac2, 0x061c6936, 0xf477ea35, 0xaa64d611, 0x580f5512,
+	0x4b5fa6e6, 0xb93425e5, 0x6dfe410e, 0x9f95c20d, 0x8cc531f9, 0x7eaeb2fa,
+	0x30e349b1, 0xc288cab2, 0xd1d83946, 0x23b3ba45, 0xf779deae, 0x05125dad,
+	0x1642ae59, 0xe4292d5a, 0xba3a117e, 0x4851927d, 0x5b016189, 0xa96ae28a,
+	0x7da08661, 0x8fcb0562, 0x9c9bf696, 0x6ef07595, 0x417b1dbc, 0xb3109ebf,
+	0xa0406d4b, 0x522bee48, 0x86e18aa3, 0x748a09a0, 0x67dafa54, 0x95b17957,
+	0xcba24573, 0x39c9c670, 0x2a993584, 0xd8f2b687, 0x0c38d26c, 0xfe53516f,
+	0xed03a29b, 0x1f682198, 0x5125dad3, 0xa34e59d0, 0xb01eaa24, 0x42752927,
+	0x96bf4dcc, 0x64d4cecf, 0x77843d3b, 0x85efbe38, 0xdbfc821c, 0x2997011f,
+	0x3ac7f2eb, 0xc8ac71e8, 0x1c661503, 0xee0d9600, 0xfd5d65f4, 0x0f36e6f7,
+	0x61c69362, 0x93ad1061, 0x80fde395, 0x72966096, 0xa65c047d, 0x5437877e,
+	0x4767748a, 0xb50cf789, 0xeb1fcbad, 0x197448ae, 0x0a24bb5a, 0xf84f3859,
+	0x2c855cb2, 0xdeeedfb1, 0xcdbe2c45, 0x3fd5af46, 0x7198540d, 0x83f3d70e,
+	0x90a324fa, 0x62c8a7f9, 0xb602c312, 0x44694011, 0x5739b3e5, 0xa55230e6,
+	0xfb410cc2, 0x092a8fc1, 0x1a7a7c35, 0xe811ff36, 0x3cdb9bdd, 0xceb018de,
+	0xdde0eb2a, 0x2f8b6829, 0x82f63b78, 0x709db87b, 0x63cd4b8f, 0x91a6c88c,
+	0x456cac67, 0xb7072f64, 0xa457dc90, 0x563c5f93, 0x082f63b7, 0xfa44e0b4,
+	0xe9141340, 0x1b7f9043, 0xcfb5f4a8, 0x3dde77ab, 0x2e8e845f, 0xdce5075c,
+	0x92a8fc17, 0x60c37f14, 0x73938ce0, 0x81f80fe3, 0x55326b08, 0xa759e80b,
+	0xb4091bff, 0x466298fc, 0x1871a4d8, 0xea1a27db, 0xf94ad42f, 0x0b21572c,
+	0xdfeb33c7, 0x2d80b0c4, 0x3ed04330, 0xccbbc033, 0xa24bb5a6, 0x502036a5,
+	0x4370c551, 0xb11b4652, 0x65d122b9, 0x97baa1ba, 0x84ea524e, 0x7681d14d,
+	0x2892ed69, 0xdaf96e6a, 0xc9a99d9e, 0x3bc21e9d, 0xef087a76, 0x1d63f975,
+	0x0e330a81, 0xfc588982, 0xb21572c9, 0x407ef1ca, 0x532e023e, 0xa145813d,
+	0x758fe5d6, 0x87e466d5, 0x94b49521, 0x66df1622, 0x38cc2a06, 0xcaa7a905,
+	0xd9f75af1, 0x2b9cd9f2, 0xff56bd19, 0x0d3d3e1a, 0x1e6dcdee, 0xec064eed,
+	0xc38d26c4, 0x31e6a5c7, 0x22b65633, 0xd0ddd530, 0x0417b1db, 0xf67c32d8,
+	0xe52cc12c, 0x1747422f, 0x49547e0b, 0xbb3ffd08, 0xa86f0efc, 0x5a048dff,
+	0x8ecee914, 0x7ca56a17, 0x6ff599e3, 0x9d9e1ae0, 0xd3d3e1ab, 0x21b862a8,
+	0x32e8915c, 0xc083125f, 0x144976b4, 0xe622f5b7, 0xf5720643, 0x07198540,
+	0x590ab964, 0xab613a67, 0xb831c993, 0x4a5a4a90, 0x9e902e7b, 0x6cfbad78,
+	0x7fab5e8c, 0x8dc0dd8f, 0xe330a81a, 0x115b2b19, 0x020bd8ed, 0xf0605bee,
+	0x24aa3f05, 0xd6c1bc06, 0xc5914ff2, 0x37faccf1, 0x69e9f0d5, 0x9b8273d6,
+	0x88d28022, 0x7ab90321, 0xae7367ca, 0x5c18e4c9, 0x4f48173d, 0xbd23943e,
+	0xf36e6f75, 0x0105ec76, 0x12551f82, 0xe03e9c81, 0x34f4f86a, 0xc69f7b69,
+	0xd5cf889d, 0x27a40b9e, 0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e,
+	0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351
+};
+
+static inline uint16_t fastHashReadUint16(const uint8_t* data)
+{
+	return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+static inline uint32_t fastHashCrc32c(uint32_t crc, const uint8_t* data, size_t dataLen)
+{
+	for (size_t i = 0; i < dataLen; i++)
+		crc = Crc32cTable[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+// Hash the addresses, and if l4Data isn't NULL also the ports and protocol, in a canonical order: the endpoint with the lower
+// address (or the lower port if the addresses are equal) goes first. This makes the hash symmetric
+static uint32_t fastHashEndpoints(const uint8_t* srcAddr, const uint8_t* dstAddr, size_t addrLen, const uint8_t* l4Data, uint8_t protocol)
+{
+	const uint8_t* srcPort = l4Data;
+	const uint8_t* dstPort = (l4Data != NULL ? l4Data + 2 : NULL);
+
+	int cmp = memcmp(srcAddr, dstAddr, addrLen);
+	if (cmp == 0 && l4Data != NULL)
+		cmp = memcmp(srcPort, dstPort, 2);
+
+	if (cmp > 0)
+	{
+		const uint8_t* temp = srcAddr;
+		srcAddr = dstAddr;
+		dstAddr = temp;
+		temp = srcPort;
+		srcPort = dstPort;
+		dstPort = temp;
+	}
+
+	uint32_t crc = 0xffffffff;
+	crc = fastHashCrc32c(crc, srcAddr, addrLen);
+	crc = fastHashCrc32c(crc, dstAddr, addrLen);
+	if (l4Data != NULL)
+	{
+		crc = fastHashCrc32c(crc, srcPort, 2);
+		crc = fastHashCrc32c(crc, dstPort, 2);
+		crc = fastHashCrc32c(crc, &protocol, 1);
+	}
+
+	return ~crc;
+}
+
+static uint32_t fastHashIPv4(const uint8_t* data, size_t dataLen)
+{
+	if (dataLen < sizeof(iphdr) || (data[0] >> 4) != 4)
+		return 0;
+
+	size_t headerLen = (data[0] & 0x0f) * 4;
+	if (headerLen < sizeof(iphdr) || headerLen > dataLen)
+		return 0;
+
+	// fragments are hashed by their IP addresses only so all fragments of a packet get the same value
+	uint16_t fragmentOffsetAndFlags = fastHashReadUint16(data + 6);
+	uint8_t protocol = data[9];
+	if ((fragmentOffsetAndFlags & 0x3fff) == 0 && (protocol == PACKETPP_IPPROTO_TCP || protocol == PACKETPP_IPPROTO_UDP) && headerLen + 4 <= dataLen)
+		return fastHashEndpoints(data + 12, data + 16, 4, data + headerLen, protocol);
+
+	return fastHashEndpoints(data + 12, data + 16, 4, NULL, 0);
+}
+
+static uint32_t fastHashIPv6(const uint8_t* data, size_t dataLen)
+{
+	if (dataLen < sizeof(ip6_hdr) || (data[0] >> 4) != 6)
+		return 0;
+
+	uint8_t nextHeader = data[6];
+	size_t offset = sizeof(ip6_hdr);
+	while (true)
+	{
+		switch (nextHeader)
+		{
+		case PACKETPP_IPPROTO_TCP:
+		case PACKETPP_IPPROTO_UDP:
+			if (offset + 4 > dataLen)
+				return fastHashEndpoints(data + 8, data + 24, 16, NULL, 0);
+			return fastHashEndpoints(data + 8, data + 24, 16, data + offset, nextHeader);
+
+		case PACKETPP_IPPROTO_HOPOPTS:
+		case PACKETPP_IPPROTO_ROUTING:
+		case PACKETPP_IPPROTO_DSTOPTS:
+			if (offset + 2 > dataLen)
+				return fastHashEndpoints(data + 8, data + 24, 16, NULL, 0);
+			nextHeader = data[offset];
+			offset += ((size_t)data[offset + 1] + 1) * 8;
+			break;
+
+		case PACKETPP_IPPROTO_AH:
+			if (offset + 2 > dataLen)
+				return fastHashEndpoints(data + 8, data + 24, 16, NULL, 0);
+			nextHeader = data[offset];
+			offset += ((size_t)data[offset + 1] + 2) * 4;
+			break;
+
+		default:
+			// fragments and other protocols are hashed by their IP addresses only
+			return fastHashEndpoints(data + 8, data + 24, 16, NULL, 0);
+		}
+	}
+}
+
+static uint32_t fastHashIP(const uint8_t* data, size_t dataLen)
+{
+	if (dataLen == 0)
+		return 0;
+
+	switch (data[0] >> 4)
+	{
+	case 4:
+		return fastHashIPv4(data, dataLen);
+	case 6:
+		return fastHashIPv6(data, dataLen);
+	default:
+		return 0;
+	}
+}
+
+uint32_t fastHash5Tuple(const uint8_t* data, size_t dataLen, LinkLayerType linkType)
+{
+	if (data == NULL)
+		return 0;
+
+	size_t offset = 0;
+	uint16_t etherType = 0;
+
+	switch (linkType)
+	{
+	case LINKTYPE_ETHERNET:
+		if (dataLen < sizeof(ether_header))
+			return 0;
+		etherType = fastHashReadUint16(data + 12);
+		offset = sizeof(ether_header);
+		break;
+
+	case LINKTYPE_LINUX_SLL:
+		if (dataLen < FAST_HASH_SLL_HEADER_LEN)
+			return 0;
+		etherType = fastHashReadUint16(data + 14);
+		offset = FAST_HASH_SLL_HEADER_LEN;
+		break;
+
+	case LINKTYPE_NULL:
+		if (dataLen < FAST_HASH_NULL_HEADER_LEN)
+			return 0;
+		return fastHashIP(data + FAST_HASH_NULL_HEADER_LEN, dataLen - FAST_HASH_NULL_HEADER_LEN);
+
+	case LINKTYPE_RAW:
+	case LINKTYPE_DLT_RAW1:
+	case LINKTYPE_DLT_RAW2:
+		return fastHashIP(data, dataLen);
+
+	default:
+		return 0;
+	}
+
+	// every iteration either returns or skips a header, so the loop ends at the latest when the data ends
+	while (true)
+	{
+		switch (etherType)
+		{
+		case PCPP_ETHERTYPE_IP:
+			return fastHashIPv4(data + offset, dataLen - offset);
+
+		case PCPP_ETHERTYPE_IPV6:
+			return fastHashIPv6(data + offset, dataLen - offset);
+
+		case PCPP_ETHERTYPE_VLAN:
+		case FAST_HASH_ETHERTYPE_QINQ:
+		case FAST_HASH_ETHERTYPE_QINQ_OLD:
+			if (offset + sizeof(vlan_header) > dataLen)
+				return 0;
+			etherType = fastHashReadUint16(data + offset + 2);
+			offset += sizeof(vlan_header);
+			break;
+
+		case PCPP_ETHERTYPE_MPLS:
+		case FAST_HASH_ETHERTYPE_MPLS_MC:
+			// skip all labels up to the one with the bottom-of-stack bit. MPLS doesn't say what's next, so guess by the IP version
+			do
+			{
+				if (offset + 4 > dataLen)
+					return 0;
+				offset += 4;
+			} while ((data[offset - 2] & 0x01) == 0);
+			return fastHashIP(data + offset, dataLen - offset);
+
+		case PCPP_ETHERTYPE_PPPOES:
+		{
+			if (offset + sizeof(pppoe_header) + sizeof(uint16_t) > dataLen)
+				return 0;
+			uint16_t pppNextProtocol = fastHashReadUint16(data + offset + sizeof(pppoe_header));
+			offset += sizeof(pppoe_header) + sizeof(uint16_t);
+			if (pppNextProtocol == PCPP_PPP_IP)
+				return fastHashIPv4(data + offset, dataLen - offset);
+			if (pppNextProtocol == PCPP_PPP_IPV6)
+				return fastHashIPv6(data + offset, dataLen - offset);
+			return 0;
+		}
+
+		default:
+			return 0;
+		}
+	}
+}
+
+uint32_t fastHash5Tuple(const RawPacket* rawPacket)
+{
+	if (rawPacket == NULL || rawPacket->getRawDataLen() <= 0)
+		return 0;
+
+	return fastHash5Tuple(rawPacket->getRawData(), (size_t)rawPacket->getRawDataLen(), rawPacket->getLinkLayerType());
+}
+
 }  // namespace pcpp
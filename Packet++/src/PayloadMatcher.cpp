@@ -0,0 +1,419 @@
+#define LOG_MODULE PacketLogModulePayloadLayer
+
+#include "PayloadMatcher.h"
+#include "Packet.h"
+#include "TcpLayer.h"
+#include "UdpLayer.h"
+#include "PayloadLayer.h"
+#include "TcpReassembly.h"
+#include "Logger.h"
+#include <string.h>
+#include <queue>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PCPP_PAYLOAD_MATCHER_SSE2
+#elif defined(__i386__) && (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+// SSE2 isn't enabled by the compiler flags, so the SSE2 prefilter is compiled for SSE2 separately and used only if the CPU supports it
+#include <emmintrin.h>
+#define PCPP_PAYLOAD_MATCHER_SSE2
+#define PCPP_PAYLOAD_MATCHER_SSE2_RUNTIME_CHECK
+#endif
+
+namespace pcpp
+{
+
+// marks a transition to a state in which at least one pattern ends
+#define PAYLOAD_MATCHER_OUTPUT_FLAG 0x80000000
+
+// marks a missing transition while the trie is built
+#define PAYLOAD_MATCHER_NO_STATE 0xffffffff
+
+static inline uint8_t toLowerAscii(uint8_t c)
+{
+	return (c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+}
+
+
+// --------------
+// PayloadMatcher
+// --------------
+
+PayloadMatcher::PayloadMatcher(bool caseInsensitive) : m_CaseInsensitive(caseInsensitive), m_IsCompiled(false), m_NumOfClasses(0), m_NumOfStates(0),
+		m_NumOfSimdPrefilterBytes(0)
+{
+	memset(m_ByteClasses, 0, sizeof(m_ByteClasses));
+	memset(m_IsStartByte, 0, sizeof(m_IsStartByte));
+	memset(m_SimdPrefilterBytes, 0, sizeof(m_SimdPrefilterBytes));
+}
+
+int PayloadMatcher::addPattern(const uint8_t* pattern, size_t patternLen)
+{
+	if (m_IsCompiled)
+	{
+		LOG_ERROR("Cannot add a pattern to a matcher which is already compiled");
+		return -1;
+	}
+
+	if (pattern == NULL || patternLen == 0)
+	{
+		LOG_ERROR("Cannot add an empty pattern");
+		return -1;
+	}
+
+	m_PatternOffsets.push_back(m_PatternBytes.size());
+	m_PatternLengths.push_back(patternLen);
+	m_PatternBytes.insert(m_PatternBytes.end(), pattern, pattern + patternLen);
+	return (int)m_PatternLengths.size() - 1;
+}
+
+size_t PayloadMatcher::getPatternLength(int patternId) const
+{
+	if (patternId < 0 || (size_t)patternId >= m_PatternLengths.size())
+		return 0;
+
+	return m_PatternLengths[patternId];
+}
+
+bool PayloadMatcher::compile()
+{
+	if (m_IsCompiled)
+	{
+		LOG_ERROR("Matcher is already compiled");
+		return false;
+	}
+
+	if (m_PatternLengths.empty())
+	{
+		LOG_ERROR("Cannot compile a matcher without patterns");
+		return false;
+	}
+
+	// map each byte that appears in the patterns to its own class. All other bytes are mapped to class 0
+	memset(m_ByteClasses, 0, sizeof(m_ByteClasses));
+	m_NumOfClasses = 1;
+	for (std::vector<uint8_t>::const_iterator iter = m_PatternBytes.begin(); iter != m_PatternBytes.end(); ++iter)
+	{
+		uint8_t byte = (m_CaseInsensitive ? toLowerAscii(*iter) : *iter);
+		if (m_ByteClasses[byte] == 0)
+			m_ByteClasses[byte] = (uint16_t)m_NumOfClasses++;
+	}
+
+	if (m_CaseInsensitive)
+	{
+		for (int c = 'A'; c <= 'Z'; c++)
+			m_ByteClasses[c] = m_ByteClasses[c | 0x20];
+	}
+
+	// build the trie. State 0 is the initial state
+	m_Transitions.assign(m_NumOfClasses, PAYLOAD_MATCHER_NO_STATE);
+	m_NumOfStates = 1;
+	std::vector<std::vector<int> > outputs(1);
+	for (size_t patternId = 0; patternId < m_PatternLengths.size(); patternId++)
+	{
+		const uint8_t* pattern = &m_PatternBytes[m_PatternOffsets[patternId]];
+		size_t state = 0;
+		for (size_t i = 0; i < m_PatternLengths[patternId]; i++)
+		{
+			size_t transitionIndex = state*m_NumOfClasses + m_ByteClasses[pattern[i]];
+			if (m_Transitions[transitionIndex] == PAYLOAD_MATCHER_NO_STATE)
+			{
+				if (m_NumOfStates >= PAYLOAD_MATCHER_OUTPUT_FLAG)
+				{
+					LOG_ERROR("Patterns are too long to compile");
+					m_Transitions.clear();
+					m_NumOfStates = 0;
+					return false;
+				}
+
+				m_Transitions[transitionIndex] = (uint32_t)m_NumOfStates++;
+				m_Transitions.resize(m_NumOfStates*m_NumOfClasses, PAYLOAD_MATCHER_NO_STATE);
+				outputs.resize(m_NumOfStates);
+			}
+
+			state = m_Transitions[transitionIndex];
+		}
+
+		outputs[state].push_back((int)patternId);
+	}
+
+	// turn the trie into a DFA by going over the states in BFS order: a missing transition of a state is the transition of its failure
+	// state (the state of its longest proper suffix), and each state outputs the patterns of its failure state as well. Since a failure
+	// state is always closer to the initial state, it's already complete when it's used
+	std::vector<uint32_t> failure(m_NumOfStates, 0);
+	std::queue<uint32_t> bfsQueue;
+	for (size_t c = 0; c < m_NumOfClasses; c++)
+	{
+		if (m_Transitions[c] == PAYLOAD_MATCHER_NO_STATE)
+			m_Transitions[c] = 0;
+		else
+			bfsQueue.push(m_Transitions[c]);
+	}
+
+	while (!bfsQueue.empty())
+	{
+		uint32_t state = bfsQueue.front();
+		bfsQueue.pop();
+
+		const std::vector<int>& failureOutputs = outputs[failure[state]];
+		outputs[state].insert(outputs[state].end(), failureOutputs.begin(), failureOutputs.end());
+
+		for (size_t c = 0; c < m_NumOfClasses; c++)
+		{
+			uint32_t& nextState = m_Transitions[state*m_NumOfClasses + c];
+			uint32_t failureNextState = m_Transitions[failure[state]*m_NumOfClasses + c];
+			if (nextState == PAYLOAD_MATCHER_NO_STATE)
+				nextState = failureNextState;
+			else
+			{
+				failure[nextState] = failureNextState;
+				bfsQueue.push(nextState);
+			}
+		}
+	}
+
+	// flatten the outputs and flag the transitions to states with outputs
+	m_OutputOffsets.resize(m_NumOfStates + 1);
+	m_OutputPatterns.clear();
+	for (size_t state = 0; state < m_NumOfStates; state++)
+	{
+		m_OutputOffsets[state] = (uint32_t)m_OutputPatterns.size();
+		m_OutputPatterns.insert(m_OutputPatterns.end(), outputs[state].begin(), outputs[state].end());
+	}
+	m_OutputOffsets[m_NumOfStates] = (uint32_t)m_OutputPatterns.size();
+
+	for (std::vector<uint32_t>::iterator iter = m_Transitions.begin(); iter != m_Transitions.end(); ++iter)
+	{
+		if (!outputs[*iter].empty())
+			*iter |= PAYLOAD_MATCHER_OUTPUT_FLAG;
+	}
+
+	// the prefilter
+	m_NumOfSimdPrefilterBytes = 0;
+	size_t numOfStartBytes = 0;
+	for (int byte = 0; byte < 256; byte++)
+	{
+		m_IsStartByte[byte] = (m_Transitions[m_ByteClasses[byte]] != 0);
+		if (!m_IsStartByte[byte])
+			continue;
+
+		if (numOfStartBytes < PCPP_PAYLOAD_MATCHER_MAX_SIMD_PREFILTER_BYTES)
+			m_SimdPrefilterBytes[numOfStartBytes] = (uint8_t)byte;
+		numOfStartBytes++;
+	}
+
+	if (numOfStartBytes <= PCPP_PAYLOAD_MATCHER_MAX_SIMD_PREFILTER_BYTES)
+		m_NumOfSimdPrefilterBytes = numOfStartBytes;
+
+	// the patterns themselves aren't needed anymore, only their lengths
+	std::vector<uint8_t>().swap(m_PatternBytes);
+	std::vector<size_t>().swap(m_PatternOffsets);
+
+	m_IsCompiled = true;
+	return true;
+}
+
+#ifdef PCPP_PAYLOAD_MATCHER_SSE2
+
+#ifdef PCPP_PAYLOAD_MATCHER_SSE2_RUNTIME_CHECK
+__attribute__((target("sse2")))
+#endif
+static size_t skipBlocksWithoutStartBytesSse2(const uint8_t* data, size_t pos, size_t dataLen, const uint8_t* prefilterBytes, size_t numOfPrefilterBytes)
+{
+	__m128i startBytes[PCPP_PAYLOAD_MATCHER_MAX_SIMD_PREFILTER_BYTES];
+	for (size_t i = 0; i < numOfPrefilterBytes; i++)
+		startBytes[i] = _mm_set1_epi8((char)prefilterBytes[i]);
+
+	// skip 16-byte blocks which don't contain any start byte. The exact position in a block that does is found by the caller
+	while (pos + 16 <= dataLen)
+	{
+		__m128i block = _mm_loadu_si128((const __m128i*)(data + pos));
+		__m128i isStartByte = _mm_cmpeq_epi8(block, startBytes[0]);
+		for (size_t i = 1; i < numOfPrefilterBytes; i++)
+			isStartByte = _mm_or_si128(isStartByte, _mm_cmpeq_epi8(block, startBytes[i]));
+
+		if (_mm_movemask_epi8(isStartByte) != 0)
+			break;
+
+		pos += 16;
+	}
+
+	return pos;
+}
+
+#ifdef PCPP_PAYLOAD_MATCHER_SSE2_RUNTIME_CHECK
+// checked on first use. Threads racing on the first use all store the same value
+static int Sse2Supported = -1;
+#endif
+
+static inline bool isSse2Supported()
+{
+#ifdef PCPP_PAYLOAD_MATCHER_SSE2_RUNTIME_CHECK
+	if (Sse2Supported < 0)
+	{
+		__builtin_cpu_init();
+		Sse2Supported = (__builtin_cpu_supports("sse2") ? 1 : 0);
+	}
+	return Sse2Supported == 1;
+#else
+	return true;
+#endif
+}
+
+#endif // PCPP_PAYLOAD_MATCHER_SSE2
+
+size_t PayloadMatcher::findNextStartByte(const uint8_t* data, size_t pos, size_t dataLen) const
+{
+#ifdef PCPP_PAYLOAD_MATCHER_SSE2
+	if (m_NumOfSimdPrefilterBytes > 0 && isSse2Supported())
+		pos = skipBlocksWithoutStartBytesSse2(data, pos, dataLen, m_SimdPrefilterBytes, m_NumOfSimdPrefilterBytes);
+	else
+#endif
+	if (m_NumOfSimdPrefilterBytes == 1)
+	{
+		const uint8_t* startBytePos = (const uint8_t*)memchr(data + pos, m_SimdPrefilterBytes[0], dataLen - pos);
+		return (startBytePos == NULL ? dataLen : (size_t)(startBytePos - data));
+	}
+
+	while (pos < dataLen && !m_IsStartByte[data[pos]])
+		pos++;
+
+	return pos;
+}
+
+size_t PayloadMatcher::search(StreamState& state, const uint8_t* data, size_t dataLen, OnPatternMatch onMatch, void* userCookie, bool stopAtFirst) const
+{
+	if (!m_IsCompiled)
+	{
+		LOG_ERROR("Matcher isn't compiled");
+		return 0;
+	}
+
+	if (data == NULL)
+		return 0;
+
+	const uint32_t* transitions = &m_Transitions[0];
+	size_t curState = state.m_State;
+	size_t numOfMatches = 0;
+	size_t pos = 0;
+	bool stopped = false;
+
+	while (pos < dataLen && !stopped)
+	{
+		if (curState == 0)
+		{
+			pos = findNextStartByte(data, pos, dataLen);
+			if (pos >= dataLen)
+				break;
+		}
+
+		uint32_t nextState = transitions[curState*m_NumOfClasses + m_ByteClasses[data[pos]]];
+		pos++;
+		curState = nextState & ~PAYLOAD_MATCHER_OUTPUT_FLAG;
+
+		if ((nextState & PAYLOAD_MATCHER_OUTPUT_FLAG) == 0)
+			continue;
+
+		for (uint32_t i = m_OutputOffsets[curState]; i < m_OutputOffsets[curState + 1]; i++)
+		{
+			numOfMatches++;
+			if (stopAtFirst || (onMatch != NULL && !onMatch(m_OutputPatterns[i], state.m_Offset + pos, userCookie)))
+			{
+				stopped = true;
+				break;
+			}
+		}
+	}
+
+	state.m_State = (uint32_t)curState;
+	state.m_Offset += (stopped ? pos : dataLen);
+	return numOfMatches;
+}
+
+bool PayloadMatcher::matchAny(const uint8_t* data, size_t dataLen) const
+{
+	StreamState state;
+	return search(state, data, dataLen, NULL, NULL, true) > 0;
+}
+
+size_t PayloadMatcher::findMatches(const uint8_t* data, size_t dataLen, OnPatternMatch onMatch, void* userCookie) const
+{
+	StreamState state;
+	return search(state, data, dataLen, onMatch, userCookie, false);
+}
+
+size_t PayloadMatcher::findMatches(StreamState& state, const uint8_t* data, size_t dataLen, OnPatternMatch onMatch, void* userCookie) const
+{
+	return search(state, data, dataLen, onMatch, userCookie, false);
+}
+
+bool PayloadMatcher::getPacketPayload(Packet& packet, const uint8_t*& payload, size_t& payloadLen)
+{
+	Layer* transportLayer = packet.getLayerOfType<TcpLayer>();
+	if (transportLayer == NULL)
+		transportLayer = packet.getLayerOfType<UdpLayer>();
+
+	if (transportLayer != NULL)
+	{
+		payload = transportLayer->getLayerPayload();
+		payloadLen = transportLayer->getLayerPayloadSize();
+		return true;
+	}
+
+	PayloadLayer* payloadLayer = packet.getLayerOfType<PayloadLayer>();
+	if (payloadLayer != NULL)
+	{
+		payload = payloadLayer->getPayload();
+		payloadLen = payloadLayer->getPayloadLen();
+		return true;
+	}
+
+	return false;
+}
+
+bool PayloadMatcher::matchPacket(Packet& packet) const
+{
+	const uint8_t* payload = NULL;
+	size_t payloadLen = 0;
+	if (!getPacketPayload(packet, payload, payloadLen))
+		return false;
+
+	return matchAny(payload, payloadLen);
+}
+
+size_t PayloadMatcher::findMatches(Packet& packet, OnPatternMatch onMatch, void* userCookie) const
+{
+	const uint8_t* payload = NULL;
+	size_t payloadLen = 0;
+	if (!getPacketPayload(packet, payload, payloadLen))
+		return 0;
+
+	return findMatches(payload, payloadLen, onMatch, userCookie);
+}
+
+
+// ----------------
+// TcpStreamMatcher
+// ----------------
+
+size_t TcpStreamMatcher::findMatches(int side, const TcpStreamData& tcpData, PayloadMatcher::OnPatternMatch onMatch, void* userCookie)
+{
+	if (side != 0 && side != 1)
+		return 0;
+
+	PayloadMatcher::StreamState& state = m_Connections[tcpData.getConnectionData().flowKey].sides[side];
+	const uint8_t* data = tcpData.getData();
+	size_t dataLen = tcpData.getDataLength();
+
+	// the missing data text isn't part of the stream
+	if (tcpData.isBytesMissing())
+	{
+		state.skip(tcpData.getMissingByteCount());
+		size_t missingDataTextLen = (tcpData.getMissingDataTextLength() < dataLen ? tcpData.getMissingDataTextLength() : dataLen);
+		data += missingDataTextLen;
+		dataLen -= missingDataTextLen;
+	}
+
+	return m_Matcher.findMatches(state, data, dataLen, onMatch, userCookie);
+}
+
+} // namespace pcpp
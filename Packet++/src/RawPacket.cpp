@@ -55,7 +55,7 @@ RawPacket& RawPacket::operator=(const RawPacket& other)
 {
 	if (this != &other)
 	{
-		if (m_RawData != NULL)
+		if (m_RawData != NULL && m_DeleteRawDataAtDestructor)
 			delete [] m_RawData;
 
 		m_RawPacketSet = false;
@@ -112,9 +112,20 @@ bool RawPacket::setRawData(const uint8_t* pRawData, int rawDataLen, timespec tim
 	return true;
 }
 
+bool RawPacket::initWithRawData(const uint8_t* pRawData, int rawDataLen, timespec timestamp, bool deleteRawDataAtDestructor, LinkLayerType layerType, int frameLength)
+{
+	// free current data according to the current ownership before taking the new one
+	if (m_RawData != 0 && m_DeleteRawDataAtDestructor)
+		delete[] m_RawData;
+
+	m_RawData = 0;
+	m_DeleteRawDataAtDestructor = deleteRawDataAtDestructor;
+	return setRawData(pRawData, rawDataLen, timestamp, layerType, frameLength);
+}
+
 void RawPacket::clear()
 {
-	if (m_RawData != 0)
+	if (m_RawData != 0 && m_DeleteRawDataAtDestructor)
 		delete[] m_RawData;
 
 	m_RawData = 0;
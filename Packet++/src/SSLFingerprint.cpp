@@ -0,0 +1,382 @@
+#include "SSLFingerprint.h"
+#include "SSLHelloReader.h"
+#include "SSLLayer.h"
+#include "TcpLayer.h"
+#include "Packet.h"
+#include "EndianPortable.h"
+#include <string.h>
+
+namespace pcpp
+{
+
+// GREASE values (RFC 8701) are 0x0a0a, 0x1a1a, ..., 0xfafa
+#define SSL_IS_GREASE_VALUE(value) (((value) & 0x0f0f) == 0x0a0a && ((value) >> 8) == ((value) & 0xff))
+
+// the max number of characters of a 16-bit value in decimal
+#define SSL_FINGERPRINT_MAX_VALUE_LEN 5
+
+static inline uint16_t readUint16(const uint8_t* pos)
+{
+	uint16_t value;
+	memcpy(&value, pos, sizeof(uint16_t));
+	return be16toh(value);
+}
+
+
+// ---------------
+// MD5 (RFC 1321)
+// ---------------
+
+#define MD5_BLOCK_LEN 64
+#define MD5_ROTATE_LEFT(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static const uint32_t MD5SineTable[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const uint8_t MD5ShiftTable[64] = {
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+/**
+ * An incremental MD5 calculation, so the fingerprint string doesn't have to be kept in memory to compute its digest
+ */
+class SSLFingerprintMD5
+{
+public:
+	SSLFingerprintMD5() : m_TotalLen(0), m_BufferLen(0)
+	{
+		m_State[0] = 0x67452301;
+		m_State[1] = 0xefcdab89;
+		m_State[2] = 0x98badcfe;
+		m_State[3] = 0x10325476;
+	}
+
+	void update(const uint8_t* data, size_t dataLen)
+	{
+		m_TotalLen += dataLen;
+
+		while (dataLen > 0)
+		{
+			size_t bytesToCopy = MD5_BLOCK_LEN - m_BufferLen;
+			if (bytesToCopy > dataLen)
+				bytesToCopy = dataLen;
+
+			memcpy(m_Buffer + m_BufferLen, data, bytesToCopy);
+			m_BufferLen += bytesToCopy;
+			data += bytesToCopy;
+			dataLen -= bytesToCopy;
+
+			if (m_BufferLen == MD5_BLOCK_LEN)
+			{
+				processBlock();
+				m_BufferLen = 0;
+			}
+		}
+	}
+
+	void finish(uint8_t digest[PCPP_SSL_FINGERPRINT_DIGEST_LEN])
+	{
+		uint64_t totalBits = (uint64_t)m_TotalLen * 8;
+
+		// pad with 0x80 and zeros up to 8 bytes before the end of a block, then add the length in bits
+		m_Buffer[m_BufferLen++] = 0x80;
+		if (m_BufferLen > MD5_BLOCK_LEN - sizeof(uint64_t))
+		{
+			memset(m_Buffer + m_BufferLen, 0, MD5_BLOCK_LEN - m_BufferLen);
+			processBlock();
+			m_BufferLen = 0;
+		}
+
+		memset(m_Buffer + m_BufferLen, 0, MD5_BLOCK_LEN - sizeof(uint64_t) - m_BufferLen);
+		for (size_t i = 0; i < sizeof(uint64_t); i++)
+			m_Buffer[MD5_BLOCK_LEN - sizeof(uint64_t) + i] = (uint8_t)(totalBits >> (8*i));
+		processBlock();
+
+		for (size_t i = 0; i < PCPP_SSL_FINGERPRINT_DIGEST_LEN; i++)
+			digest[i] = (uint8_t)(m_State[i/4] >> (8*(i%4)));
+	}
+
+private:
+	uint32_t m_State[4];
+	uint64_t m_TotalLen;
+	uint8_t m_Buffer[MD5_BLOCK_LEN];
+	size_t m_BufferLen;
+
+	static inline void step(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d, uint32_t f, uint32_t word, int i)
+	{
+		uint32_t temp = d;
+		d = c;
+		c = b;
+		f += a + MD5SineTable[i] + word;
+		b += MD5_ROTATE_LEFT(f, MD5ShiftTable[i]);
+		a = temp;
+	}
+
+	void processBlock()
+	{
+		uint32_t words[16];
+		for (int i = 0; i < 16; i++)
+			words[i] = (uint32_t)m_Buffer[4*i] | ((uint32_t)m_Buffer[4*i + 1] << 8) | ((uint32_t)m_Buffer[4*i + 2] << 16) | ((uint32_t)m_Buffer[4*i + 3] << 24);
+
+		// each of the 4 rounds is a separate loop so the round function isn't chosen on every step
+		uint32_t a = m_State[0], b = m_State[1], c = m_State[2], d = m_State[3];
+		for (int i = 0; i < 16; i++)
+			step(a, b, c, d, (b & c) | (~b & d), words[i], i);
+		for (int i = 16; i < 32; i++)
+			step(a, b, c, d, (d & b) | (~d & c), words[(5*i + 1) % 16], i);
+		for (int i = 32; i < 48; i++)
+			step(a, b, c, d, b ^ c ^ d, words[(3*i + 5) % 16], i);
+		for (int i = 48; i < 64; i++)
+			step(a, b, c, d, c ^ (b | ~d), words[(7*i) % 16], i);
+
+		m_State[0] += a;
+		m_State[1] += b;
+		m_State[2] += c;
+		m_State[3] += d;
+	}
+};
+
+
+/**
+ * Formats the fingerprint string, feeding it to the MD5 calculation and optionally copying it to a user buffer
+ */
+class SSLFingerprintWriter
+{
+public:
+	SSLFingerprintWriter(char* output, size_t outputLen) : m_Output(output), m_OutputLen(outputLen), m_Length(0) {}
+
+	void write(const char* str, size_t len)
+	{
+		m_MD5.update((const uint8_t*)str, len);
+
+		// leave room for the terminating '\0'
+		if (m_Output != NULL && m_Length + 1 < m_OutputLen)
+		{
+			size_t bytesToCopy = m_OutputLen - 1 - m_Length;
+			if (bytesToCopy > len)
+				bytesToCopy = len;
+			memcpy(m_Output + m_Length, str, bytesToCopy);
+		}
+
+		m_Length += len;
+	}
+
+	void writeValue(uint16_t value)
+	{
+		char digits[SSL_FINGERPRINT_MAX_VALUE_LEN];
+		size_t pos = SSL_FINGERPRINT_MAX_VALUE_LEN;
+		do
+		{
+			digits[--pos] = (char)('0' + value % 10);
+			value /= 10;
+		} while (value > 0);
+
+		write(digits + pos, SSL_FINGERPRINT_MAX_VALUE_LEN - pos);
+	}
+
+	// write a value of a list field: values are separated by '-' and GREASE values are skipped
+	void writeListValue(uint16_t value, bool& isFirstValue)
+	{
+		if (SSL_IS_GREASE_VALUE(value))
+			return;
+
+		if (!isFirstValue)
+			write("-", 1);
+		isFirstValue = false;
+		writeValue(value);
+	}
+
+	void writeFieldSeparator() { write(",", 1); }
+
+	size_t finish(uint8_t digest[PCPP_SSL_FINGERPRINT_DIGEST_LEN])
+	{
+		m_MD5.finish(digest);
+
+		if (m_Output != NULL && m_OutputLen > 0)
+			m_Output[m_Length < m_OutputLen ? m_Length : m_OutputLen - 1] = 0;
+
+		return m_Length;
+	}
+
+private:
+	SSLFingerprintMD5 m_MD5;
+	char* m_Output;
+	size_t m_OutputLen;
+	size_t m_Length;
+};
+
+
+// --------------
+// SSLFingerprint
+// --------------
+
+SSLFingerprint::SSLFingerprint()
+{
+	clear();
+}
+
+void SSLFingerprint::clear()
+{
+	m_HandshakeType = SSL_HANDSHAKE_UNKNOWN;
+	m_StringLength = 0;
+	memset(m_Digest, 0, sizeof(m_Digest));
+}
+
+bool SSLFingerprint::compute(const SSLHelloReader& reader, char* fingerprintStr, size_t fingerprintStrLen)
+{
+	clear();
+
+	if (fingerprintStr != NULL && fingerprintStrLen > 0)
+		fingerprintStr[0] = 0;
+
+	if (!reader.isValid())
+		return false;
+
+	SSLFingerprintWriter writer(fingerprintStr, fingerprintStrLen);
+
+	// SSLVersion
+	writer.writeValue(reader.getHandshakeVersion());
+	writer.writeFieldSeparator();
+
+	// Ciphers (a single cipher-suite in a server-hello)
+	bool isFirstValue = true;
+	for (size_t i = 0; i < reader.getCipherSuiteCount(); i++)
+		writer.writeListValue(reader.getCipherSuiteID(i), isFirstValue);
+	writer.writeFieldSeparator();
+
+	// Extensions. The data of the extensions needed for the rest of the fields is kept while they're walked
+	const uint8_t* ellipticCurvesData = NULL;
+	uint16_t ellipticCurvesDataLen = 0;
+	const uint8_t* pointFormatsData = NULL;
+	uint16_t pointFormatsDataLen = 0;
+
+	size_t pos = 0;
+	uint16_t extType = 0;
+	const uint8_t* extData = NULL;
+	uint16_t extDataLen = 0;
+	isFirstValue = true;
+	while (reader.getNextExtension(pos, extType, extData, extDataLen))
+	{
+		writer.writeListValue(extType, isFirstValue);
+
+		if (extType == SSL_EXT_ELLIPTIC_CURVES && ellipticCurvesData == NULL)
+		{
+			ellipticCurvesData = extData;
+			ellipticCurvesDataLen = extDataLen;
+		}
+		else if (extType == SSL_EXT_EC_POINT_FORMATS && pointFormatsData == NULL)
+		{
+			pointFormatsData = extData;
+			pointFormatsDataLen = extDataLen;
+		}
+	}
+
+	if (reader.getHandshakeType() == SSL_CLIENT_HELLO)
+	{
+		// EllipticCurves: a 2-byte list length followed by 2-byte values
+		writer.writeFieldSeparator();
+		isFirstValue = true;
+		if (ellipticCurvesDataLen >= sizeof(uint16_t))
+		{
+			size_t listEnd = sizeof(uint16_t) + readUint16(ellipticCurvesData);
+			if (listEnd > ellipticCurvesDataLen)
+				listEnd = ellipticCurvesDataLen;
+
+			for (size_t offset = sizeof(uint16_t); offset + sizeof(uint16_t) <= listEnd; offset += sizeof(uint16_t))
+				writer.writeListValue(readUint16(ellipticCurvesData + offset), isFirstValue);
+		}
+
+		// EllipticCurvePointFormats: a 1-byte list length followed by 1-byte values
+		writer.writeFieldSeparator();
+		isFirstValue = true;
+		if (pointFormatsDataLen >= sizeof(uint8_t))
+		{
+			size_t listEnd = sizeof(uint8_t) + pointFormatsData[0];
+			if (listEnd > pointFormatsDataLen)
+				listEnd = pointFormatsDataLen;
+
+			for (size_t offset = sizeof(uint8_t); offset < listEnd; offset++)
+				writer.writeListValue(pointFormatsData[offset], isFirstValue);
+		}
+	}
+
+	m_StringLength = writer.finish(m_Digest);
+	m_HandshakeType = reader.getHandshakeType();
+	return true;
+}
+
+bool SSLFingerprint::computeFromRecord(const uint8_t* data, size_t dataLen, char* fingerprintStr, size_t fingerprintStrLen)
+{
+	clear();
+
+	if (fingerprintStr != NULL && fingerprintStrLen > 0)
+		fingerprintStr[0] = 0;
+
+	if (data == NULL || !SSLLayer::IsSSLMessage(0, 0, const_cast<uint8_t*>(data), dataLen, true))
+		return false;
+
+	SSLHelloReader reader;
+	if (!reader.parseRecord(data, dataLen))
+		return false;
+
+	return compute(reader, fingerprintStr, fingerprintStrLen);
+}
+
+size_t SSLFingerprint::computeBatch(RawPacket* const* rawPackets, size_t count, SSLFingerprint* results)
+{
+	if (rawPackets == NULL || results == NULL)
+		return 0;
+
+	size_t numOfFingerprints = 0;
+	Packet packet;
+	for (size_t i = 0; i < count; i++)
+	{
+		results[i].clear();
+		if (rawPackets[i] == NULL)
+			continue;
+
+		packet.setRawPacket(rawPackets[i], false, TCP);
+		TcpLayer* tcpLayer = packet.getLayerOfType<TcpLayer>();
+		if (tcpLayer == NULL)
+			continue;
+
+		if (results[i].computeFromRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayloadSize()))
+			numOfFingerprints++;
+	}
+
+	return numOfFingerprints;
+}
+
+std::string SSLFingerprint::getDigestString() const
+{
+	if (!isValid())
+		return "";
+
+	static const char hexDigits[] = "0123456789abcdef";
+	char result[2*PCPP_SSL_FINGERPRINT_DIGEST_LEN];
+	for (size_t i = 0; i < PCPP_SSL_FINGERPRINT_DIGEST_LEN; i++)
+	{
+		result[2*i] = hexDigits[m_Digest[i] >> 4];
+		result[2*i + 1] = hexDigits[m_Digest[i] & 0x0f];
+	}
+
+	return std::string(result, sizeof(result));
+}
+
+bool SSLFingerprint::operator==(const SSLFingerprint& other) const
+{
+	return m_HandshakeType == other.m_HandshakeType && memcmp(m_Digest, other.m_Digest, sizeof(m_Digest)) == 0;
+}
+
+} // namespace pcpp
@@ -1075,13 +1075,10 @@ std::string SSLServerNameIndicationExtension::getHostName() const
 	uint8_t* hostNameLengthPos = getData() + sizeof(uint16_t) + sizeof(uint8_t);
 	uint16_t hostNameLength = be16toh(*(uint16_t*)hostNameLengthPos);
 
-	char* hostNameAsCharArr = new char[hostNameLength+1];
-	memset(hostNameAsCharArr, 0, hostNameLength+1);
-	memcpy(hostNameAsCharArr, hostNameLengthPos + sizeof(uint16_t), hostNameLength);
-
-	std::string res = std::string(hostNameAsCharArr);
-	delete[] hostNameAsCharArr;
-	return res;
+	// the host name isn't null-terminated so it ends at the first null char or after hostNameLength chars
+	const char* hostName = (const char*)(hostNameLengthPos + sizeof(uint16_t));
+	const char* hostNameEnd = (const char*)memchr(hostName, 0, hostNameLength);
+	return std::string(hostName, hostNameEnd != NULL ? (size_t)(hostNameEnd - hostName) : (size_t)hostNameLength);
 }
 
 
@@ -1159,26 +1156,18 @@ bool SSLHandshakeMessage::isMessageComplete() const
 }
 
 
-// -----------------------------
-// SSLClientHelloMessage methods
-// -----------------------------
-
-SSLClientHelloMessage::SSLClientHelloMessage(uint8_t* data, size_t dataLen, SSLHandshakeLayer* container)
-	: SSLHandshakeMessage(data, dataLen, container)
+/**
+ * Create the extension objects of a client-hello or server-hello message. Used by both message types once their
+ * extensions are first accessed
+ */
+static void parseHelloExtensions(uint8_t* data, size_t messageLen, size_t extensionLengthOffset, uint16_t extensionLength, PointerVector<SSLExtension>& extensionList)
 {
-	size_t extensionLengthOffset = sizeof(ssl_tls_client_server_hello) + sizeof(uint8_t) + getSessionIDLength() + sizeof(uint16_t) + sizeof(uint16_t)*getCipherSuiteCount() + 2*sizeof(uint8_t);
-	if (extensionLengthOffset + sizeof(uint16_t) > m_DataLen)
-		return;
-
-	uint8_t* extensionLengthPos = m_Data + extensionLengthOffset;
-	uint16_t extensionLength = getExtensionsLenth();
-	uint8_t* extensionPos = extensionLengthPos + sizeof(uint16_t);
+	uint8_t* extensionPos = data + extensionLengthOffset + sizeof(uint16_t);
 	uint8_t* curPos = extensionPos;
-	size_t messageLen = getMessageLength();
 	size_t minSSLExtentionLen = 2*sizeof(uint16_t) + sizeof(uint8_t);
-	while ((curPos - extensionPos) < (int)extensionLength 
-		&& (curPos - m_Data) < (int)messageLen 
-		&& (int)messageLen - (curPos - m_Data) >= (int)minSSLExtentionLen)
+	while ((curPos - extensionPos) < (int)extensionLength
+		&& (curPos - data) < (int)messageLen
+		&& (int)messageLen - (curPos - data) >= (int)minSSLExtentionLen)
 	{
 		SSLExtension* newExt = NULL;
 		uint16_t sslExtType = be16toh(*(uint16_t*)curPos);
@@ -1191,11 +1180,35 @@ SSLClientHelloMessage::SSLClientHelloMessage(uint8_t* data, size_t dataLen, SSLH
 			newExt = new SSLExtension(curPos);
 		}
 
-		m_ExtensionList.pushBack(newExt);
+		extensionList.pushBack(newExt);
 		curPos += newExt->getTotalLength();
 	}
 }
 
+
+// -----------------------------
+// SSLClientHelloMessage methods
+// -----------------------------
+
+SSLClientHelloMessage::SSLClientHelloMessage(uint8_t* data, size_t dataLen, SSLHandshakeLayer* container)
+	: SSLHandshakeMessage(data, dataLen, container), m_ExtensionsParsed(false)
+{
+}
+
+void SSLClientHelloMessage::parseExtensions() const
+{
+	if (m_ExtensionsParsed)
+		return;
+
+	m_ExtensionsParsed = true;
+
+	size_t extensionLengthOffset = sizeof(ssl_tls_client_server_hello) + sizeof(uint8_t) + getSessionIDLength() + sizeof(uint16_t) + sizeof(uint16_t)*getCipherSuiteCount() + 2*sizeof(uint8_t);
+	if (extensionLengthOffset + sizeof(uint16_t) > m_DataLen)
+		return;
+
+	parseHelloExtensions(m_Data, getMessageLength(), extensionLengthOffset, getExtensionsLenth(), m_ExtensionList);
+}
+
 SSLVersion SSLClientHelloMessage::getHandshakeVersion() const
 {
 	uint16_t handshakeVersion = be16toh(getClientHelloHeader()->handshakeVersion);
@@ -1242,6 +1255,20 @@ SSLCipherSuite* SSLClientHelloMessage::getCipherSuite(int index) const
 	return SSLCipherSuite::getCipherSuiteByID(be16toh(*(cipherSuiteStartPos+index)));
 }
 
+uint16_t SSLClientHelloMessage::getCipherSuiteID(int index, bool& isValid) const
+{
+	isValid = false;
+	if (index < 0 || index >= getCipherSuiteCount())
+		return 0;
+
+	size_t cipherSuiteOffset = sizeof(ssl_tls_client_server_hello) + sizeof(uint8_t) + getSessionIDLength() + sizeof(uint16_t) + sizeof(uint16_t)*index;
+	if (cipherSuiteOffset + sizeof(uint16_t) > m_DataLen)
+		return 0;
+
+	isValid = true;
+	return be16toh(*(uint16_t*)(m_Data + cipherSuiteOffset));
+}
+
 uint8_t SSLClientHelloMessage::getCompressionMethodsValue() const
 {
 	size_t offset = sizeof(ssl_tls_client_server_hello) + sizeof(uint8_t) + getSessionIDLength() + sizeof(uint16_t) + sizeof(uint16_t)*getCipherSuiteCount() + sizeof(uint8_t);
@@ -1254,6 +1281,7 @@ uint8_t SSLClientHelloMessage::getCompressionMethodsValue() const
 
 int SSLClientHelloMessage::getExtensionCount() const
 {
+	parseExtensions();
 	return m_ExtensionList.size();
 }
 
@@ -1269,11 +1297,13 @@ uint16_t SSLClientHelloMessage::getExtensionsLenth() const
 
 SSLExtension* SSLClientHelloMessage::getExtension(int index) const
 {
+	parseExtensions();
 	return const_cast<SSLExtension*>(m_ExtensionList.at(index));
 }
 
 SSLExtension* SSLClientHelloMessage::getExtensionOfType(uint16_t type) const
 {
+	parseExtensions();
 	size_t vecSize = m_ExtensionList.size();
 	for (size_t i = 0; i < vecSize; i++)
 	{
@@ -1287,6 +1317,7 @@ SSLExtension* SSLClientHelloMessage::getExtensionOfType(uint16_t type) const
 
 SSLExtension* SSLClientHelloMessage::getExtensionOfType(SSLExtensionType type) const
 {
+	parseExtensions();
 	size_t vecSize = m_ExtensionList.size();
 	for (size_t i = 0; i < vecSize; i++)
 	{
@@ -1309,36 +1340,22 @@ std::string SSLClientHelloMessage::toString() const
 // -----------------------------
 
 SSLServerHelloMessage::SSLServerHelloMessage(uint8_t* data, size_t dataLen, SSLHandshakeLayer* container)
-	: SSLHandshakeMessage(data, dataLen, container)
+	: SSLHandshakeMessage(data, dataLen, container), m_ExtensionsParsed(false)
 {
+}
+
+void SSLServerHelloMessage::parseExtensions() const
+{
+	if (m_ExtensionsParsed)
+		return;
+
+	m_ExtensionsParsed = true;
+
 	size_t extensionLengthOffset = sizeof(ssl_tls_client_server_hello) + sizeof(uint8_t) + getSessionIDLength() + sizeof(uint16_t) + sizeof(uint8_t);
 	if (extensionLengthOffset + sizeof(uint16_t) > m_DataLen)
 		return;
 
-	uint8_t* extensionLengthPos = m_Data + extensionLengthOffset;
-	uint16_t extensionLength = getExtensionsLenth();
-	uint8_t* extensionPos = extensionLengthPos + sizeof(uint16_t);
-	uint8_t* curPos = extensionPos;
-	size_t messageLen = getMessageLength();
-	size_t minSSLExtentionLen = 2*sizeof(uint16_t) + sizeof(uint8_t);
-	while ((curPos - extensionPos) < (int)extensionLength 
-		&& (curPos - m_Data) < (int)messageLen 
-		&& (int)messageLen - (curPos - m_Data) >= (int)minSSLExtentionLen)
-	{
-		SSLExtension* newExt = NULL;
-		uint16_t sslExtType = be16toh(*(uint16_t*)curPos);
-		if (sslExtType == SSL_EXT_SERVER_NAME)
-		{
-			newExt = new SSLServerNameIndicationExtension(curPos);
-		}
-		else
-		{
-			newExt = new SSLExtension(curPos);
-		}
-
-		m_ExtensionList.pushBack(newExt);
-		curPos += newExt->getTotalLength();
-	}
+	parseHelloExtensions(m_Data, getMessageLength(), extensionLengthOffset, getExtensionsLenth(), m_ExtensionList);
 }
 
 SSLVersion SSLServerHelloMessage::getHandshakeVersion() const
@@ -1377,6 +1394,19 @@ SSLCipherSuite* SSLServerHelloMessage::getCipherSuite() const
 	return SSLCipherSuite::getCipherSuiteByID(be16toh(*(cipherSuiteStartPos)));
 }
 
+uint16_t SSLServerHelloMessage::getCipherSuiteID(bool& isValid) const
+{
+	size_t cipherSuiteStartOffset = sizeof(ssl_tls_client_server_hello) + sizeof(uint8_t) + getSessionIDLength();
+	if (cipherSuiteStartOffset + sizeof(uint16_t) > m_DataLen)
+	{
+		isValid = false;
+		return 0;
+	}
+
+	isValid = true;
+	return be16toh(*(uint16_t*)(m_Data + cipherSuiteStartOffset));
+}
+
 uint8_t SSLServerHelloMessage::getCompressionMethodsValue() const
 {
 	size_t offset = sizeof(ssl_tls_client_server_hello) + sizeof(uint8_t) + getSessionIDLength() + sizeof(uint16_t);
@@ -1389,6 +1419,7 @@ uint8_t SSLServerHelloMessage::getCompressionMethodsValue() const
 
 int SSLServerHelloMessage::getExtensionCount() const
 {
+	parseExtensions();
 	return m_ExtensionList.size();
 }
 
@@ -1404,6 +1435,7 @@ uint16_t SSLServerHelloMessage::getExtensionsLenth() const
 
 SSLExtension* SSLServerHelloMessage::getExtension(int index) const
 {
+	parseExtensions();
 	if (index < 0 || index >= (int)m_ExtensionList.size())
 		return NULL;
 
@@ -1412,6 +1444,7 @@ SSLExtension* SSLServerHelloMessage::getExtension(int index) const
 
 SSLExtension* SSLServerHelloMessage::getExtensionOfType(uint16_t type) const
 {
+	parseExtensions();
 	size_t vecSize = m_ExtensionList.size();
 	for (size_t i = 0; i < vecSize; i++)
 	{
@@ -1425,6 +1458,7 @@ SSLExtension* SSLServerHelloMessage::getExtensionOfType(uint16_t type) const
 
 SSLExtension* SSLServerHelloMessage::getExtensionOfType(SSLExtensionType type) const
 {
+	parseExtensions();
 	size_t vecSize = m_ExtensionList.size();
 	for (size_t i = 0; i < vecSize; i++)
 	{
@@ -1447,9 +1481,19 @@ std::string SSLServerHelloMessage::toString() const
 // -----------------------------
 
 SSLCertificateMessage::SSLCertificateMessage(uint8_t* data, size_t dataLen, SSLHandshakeLayer* container)
-	: SSLHandshakeMessage(data, dataLen, container)
+	: SSLHandshakeMessage(data, dataLen, container), m_CertificatesParsed(false)
 {
-	if (dataLen < sizeof(ssl_tls_handshake_layer) +
+}
+
+void SSLCertificateMessage::parseCertificates() const
+{
+	if (m_CertificatesParsed)
+		return;
+
+	m_CertificatesParsed = true;
+
+	uint8_t* data = m_Data;
+	if (m_DataLen < sizeof(ssl_tls_handshake_layer) +
 			sizeof(uint8_t)*3) // certificates length (3B)
 		return;
 
@@ -1502,11 +1546,13 @@ std::string SSLCertificateMessage::toString() const
 
 int SSLCertificateMessage::getNumOfCertificates() const
 {
+	parseCertificates();
 	return m_CertificateList.size();
 }
 
 SSLx509Certificate* SSLCertificateMessage::getCertificate(int index) const
 {
+	parseCertificates();
 	if (index < 0 || index > (int)m_CertificateList.size())
 	{
 		LOG_DEBUG("certificate index out of range: asked for index %d, total size is %d", index, (int)m_CertificateList.size());
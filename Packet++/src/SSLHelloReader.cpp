@@ -0,0 +1,226 @@
+#include "SSLHelloReader.h"
+#include "EndianPortable.h"
+#include <string.h>
+
+namespace pcpp
+{
+
+// the type of the host name entry in the server name indication extension
+#define SSL_SNI_HOST_NAME_TYPE 0
+
+static inline uint16_t readUint16(const uint8_t* pos)
+{
+	uint16_t value;
+	memcpy(&value, pos, sizeof(uint16_t));
+	return be16toh(value);
+}
+
+static inline size_t getHandshakeMessageLength(const uint8_t* data)
+{
+	const ssl_tls_handshake_layer* handshakeHeader = (const ssl_tls_handshake_layer*)data;
+	return sizeof(ssl_tls_handshake_layer) + ((size_t)handshakeHeader->length1 << 16) + readUint16((const uint8_t*)&handshakeHeader->length2);
+}
+
+
+SSLHelloReader::SSLHelloReader()
+{
+	clear();
+}
+
+void SSLHelloReader::clear()
+{
+	m_Data = NULL;
+	m_DataLen = 0;
+	m_HandshakeType = SSL_HANDSHAKE_UNKNOWN;
+	m_CipherSuiteOffset = 0;
+	m_CipherSuiteCount = 0;
+	m_ExtensionsOffset = 0;
+	m_ExtensionsLen = 0;
+}
+
+bool SSLHelloReader::parse(const uint8_t* data, size_t dataLen)
+{
+	clear();
+
+	if (data == NULL || dataLen < sizeof(ssl_tls_client_server_hello))
+		return false;
+
+	uint8_t handshakeType = ((const ssl_tls_handshake_layer*)data)->handshakeType;
+	if (handshakeType != SSL_CLIENT_HELLO && handshakeType != SSL_SERVER_HELLO)
+		return false;
+
+	// don't read beyond the message if the data contains more than this message
+	size_t messageLen = getHandshakeMessageLength(data);
+	if (messageLen < dataLen)
+		dataLen = messageLen;
+
+	// skip the session ID
+	size_t offset = sizeof(ssl_tls_client_server_hello);
+	if (offset + sizeof(uint8_t) > dataLen)
+		return false;
+	offset += sizeof(uint8_t) + data[offset];
+
+	size_t cipherSuiteOffset = 0;
+	size_t cipherSuiteCount = 0;
+	if (handshakeType == SSL_CLIENT_HELLO)
+	{
+		// cipher-suite list and compression methods list, each preceded by its length
+		if (offset + sizeof(uint16_t) > dataLen)
+			return false;
+		size_t cipherSuitesLen = readUint16(data + offset);
+		offset += sizeof(uint16_t);
+		cipherSuiteOffset = offset;
+		cipherSuiteCount = cipherSuitesLen / sizeof(uint16_t);
+		offset += cipherSuitesLen;
+
+		if (offset + sizeof(uint8_t) > dataLen)
+			return false;
+		offset += sizeof(uint8_t) + data[offset];
+	}
+	else
+	{
+		// a single cipher-suite and a single compression method
+		cipherSuiteOffset = offset;
+		cipherSuiteCount = 1;
+		offset += sizeof(uint16_t) + sizeof(uint8_t);
+	}
+
+	if (offset > dataLen)
+		return false;
+
+	// the extensions block is optional. If the message is split over several packets only the extensions in this
+	// packet are read
+	if (offset + sizeof(uint16_t) <= dataLen)
+	{
+		size_t extensionsLen = readUint16(data + offset);
+		offset += sizeof(uint16_t);
+		m_ExtensionsOffset = offset;
+		m_ExtensionsLen = (extensionsLen < dataLen - offset ? extensionsLen : dataLen - offset);
+	}
+
+	m_Data = data;
+	m_DataLen = dataLen;
+	m_HandshakeType = (SSLHandshakeType)handshakeType;
+	m_CipherSuiteOffset = cipherSuiteOffset;
+	m_CipherSuiteCount = cipherSuiteCount;
+	return true;
+}
+
+bool SSLHelloReader::parseRecord(const uint8_t* data, size_t dataLen)
+{
+	clear();
+
+	if (data == NULL || dataLen < sizeof(ssl_tls_record_layer))
+		return false;
+
+	const ssl_tls_record_layer* recordHeader = (const ssl_tls_record_layer*)data;
+	if (recordHeader->recordType != SSL_HANDSHAKE)
+		return false;
+
+	size_t recordLen = sizeof(ssl_tls_record_layer) + readUint16((const uint8_t*)&recordHeader->length);
+	if (recordLen < dataLen)
+		dataLen = recordLen;
+
+	// hello messages are usually the first in their record, but a record may start with other messages
+	size_t offset = sizeof(ssl_tls_record_layer);
+	while (offset + sizeof(ssl_tls_handshake_layer) <= dataLen)
+	{
+		uint8_t handshakeType = ((const ssl_tls_handshake_layer*)(data + offset))->handshakeType;
+		if (handshakeType == SSL_CLIENT_HELLO || handshakeType == SSL_SERVER_HELLO)
+			return parse(data + offset, dataLen - offset);
+
+		offset += getHandshakeMessageLength(data + offset);
+	}
+
+	return false;
+}
+
+uint16_t SSLHelloReader::getHandshakeVersion() const
+{
+	if (m_Data == NULL)
+		return 0;
+
+	return readUint16((const uint8_t*)&((const ssl_tls_client_server_hello*)m_Data)->handshakeVersion);
+}
+
+uint16_t SSLHelloReader::getCipherSuiteID(size_t index) const
+{
+	if (index >= m_CipherSuiteCount)
+		return 0;
+
+	size_t offset = m_CipherSuiteOffset + index*sizeof(uint16_t);
+	if (offset + sizeof(uint16_t) > m_DataLen)
+		return 0;
+
+	return readUint16(m_Data + offset);
+}
+
+bool SSLHelloReader::getNextExtension(size_t& pos, uint16_t& extType, const uint8_t*& extData, uint16_t& extDataLen) const
+{
+	if (m_Data == NULL || pos + 2*sizeof(uint16_t) > m_ExtensionsLen)
+		return false;
+
+	const uint8_t* extPos = m_Data + m_ExtensionsOffset + pos;
+	uint16_t dataLen = readUint16(extPos + sizeof(uint16_t));
+	if (pos + 2*sizeof(uint16_t) + dataLen > m_ExtensionsLen)
+		return false;
+
+	extType = readUint16(extPos);
+	extData = extPos + 2*sizeof(uint16_t);
+	extDataLen = dataLen;
+	pos += 2*sizeof(uint16_t) + dataLen;
+	return true;
+}
+
+const uint8_t* SSLHelloReader::getExtensionOfType(uint16_t extType, uint16_t& extDataLen) const
+{
+	size_t pos = 0;
+	uint16_t curExtType = 0;
+	const uint8_t* curExtData = NULL;
+	uint16_t curExtDataLen = 0;
+	while (getNextExtension(pos, curExtType, curExtData, curExtDataLen))
+	{
+		if (curExtType == extType)
+		{
+			extDataLen = curExtDataLen;
+			return curExtData;
+		}
+	}
+
+	return NULL;
+}
+
+const char* SSLHelloReader::getServerName(size_t& nameLen) const
+{
+	uint16_t extDataLen = 0;
+	const uint8_t* extData = getExtensionOfType(SSL_EXT_SERVER_NAME, extDataLen);
+	if (extData == NULL || extDataLen < sizeof(uint16_t))
+		return NULL;
+
+	// the extension contains a list of server names, each of them is: type (1B), length (2B), name
+	size_t listEnd = sizeof(uint16_t) + readUint16(extData);
+	if (listEnd > extDataLen)
+		listEnd = extDataLen;
+
+	size_t offset = sizeof(uint16_t);
+	while (offset + sizeof(uint8_t) + sizeof(uint16_t) <= listEnd)
+	{
+		uint8_t nameType = extData[offset];
+		size_t curNameLen = readUint16(extData + offset + sizeof(uint8_t));
+		offset += sizeof(uint8_t) + sizeof(uint16_t);
+		if (offset + curNameLen > listEnd)
+			return NULL;
+
+		if (nameType == SSL_SNI_HOST_NAME_TYPE)
+		{
+			nameLen = curNameLen;
+			return (const char*)(extData + offset);
+		}
+
+		offset += curNameLen;
+	}
+
+	return NULL;
+}
+
+} // namespace pcpp
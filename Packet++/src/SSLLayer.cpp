@@ -49,22 +49,22 @@ SSLLayer* SSLLayer::createSSLMessage(uint8_t* data, size_t dataLen, Layer* prevL
 	{
 		case SSL_HANDSHAKE:
 		{
-			return new SSLHandshakeLayer(data, dataLen, prevLayer, packet);
+			return new(packet) SSLHandshakeLayer(data, dataLen, prevLayer, packet);
 		}
 
 		case SSL_ALERT:
 		{
-			return new SSLAlertLayer(data, dataLen, prevLayer, packet);
+			return new(packet) SSLAlertLayer(data, dataLen, prevLayer, packet);
 		}
 
 		case SSL_CHANGE_CIPHER_SPEC:
 		{
-			return new SSLChangeCipherSpecLayer(data, dataLen, prevLayer, packet);
+			return new(packet) SSLChangeCipherSpecLayer(data, dataLen, prevLayer, packet);
 		}
 
 		case SSL_APPLICATION_DATA:
 		{
-			return new SSLApplicationDataLayer(data, dataLen, prevLayer, packet);
+			return new(packet) SSLApplicationDataLayer(data, dataLen, prevLayer, packet);
 		}
 
 		default:
@@ -129,6 +129,7 @@ std::string SSLHandshakeLayer::toString() const
 {
 	std::stringstream result;
 	result << sslVersionToString(getRecordVersion()) << " Layer, Handshake:";
+	parseMessages();
 	for(size_t i = 0; i < m_MessageList.size(); i++)
 	{
 		if (i == 0)
@@ -140,8 +141,18 @@ std::string SSLHandshakeLayer::toString() const
 }
 
 SSLHandshakeLayer::SSLHandshakeLayer(uint8_t* data, size_t dataLen, Layer* prevLayer, Packet* packet)
-	: SSLLayer(data, dataLen, prevLayer, packet)
+	: SSLLayer(data, dataLen, prevLayer, packet), m_MessagesParsed(false)
 {
+}
+
+void SSLHandshakeLayer::parseMessages() const
+{
+	// the messages are created only when first accessed, so a handshake layer nobody looks into costs no allocations
+	if (m_MessagesParsed)
+		return;
+
+	m_MessagesParsed = true;
+
 	uint8_t* curPos = m_Data + sizeof(ssl_tls_record_layer);
 	size_t recordDataLen = be16toh(getRecordLayer()->length);
 	if (recordDataLen > m_DataLen - sizeof(ssl_tls_record_layer))
@@ -150,7 +161,7 @@ SSLHandshakeLayer::SSLHandshakeLayer(uint8_t* data, size_t dataLen, Layer* prevL
 	size_t curPosIndex = 0;
 	while (true)
 	{
-		SSLHandshakeMessage* message = SSLHandshakeMessage::createHandhakeMessage(curPos, recordDataLen-curPosIndex, this);
+		SSLHandshakeMessage* message = SSLHandshakeMessage::createHandhakeMessage(curPos, recordDataLen-curPosIndex, const_cast<SSLHandshakeLayer*>(this));
 		if (message == NULL)
 			break;
 
@@ -162,6 +173,7 @@ SSLHandshakeLayer::SSLHandshakeLayer(uint8_t* data, size_t dataLen, Layer* prevL
 
 SSLHandshakeMessage* SSLHandshakeLayer::getHandshakeMessageAt(int index) const
 {
+	parseMessages();
 	if (index < 0 || index >= (int)(m_MessageList.size()))
 		return NULL;
 
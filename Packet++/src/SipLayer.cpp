@@ -69,11 +69,11 @@ void SipLayer::parseNextLayer()
 	size_t headerLen = getHeaderLen();
 	if (getContentLength() > 0)
 	{
-		m_NextLayer = new SdpLayer(m_Data + headerLen, m_DataLen - headerLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) SdpLayer(m_Data + headerLen, m_DataLen - headerLen, this, m_Packet);
 	}
 	else
 	{
-		m_NextLayer = new PayloadLayer(m_Data + headerLen, m_DataLen - headerLen, this, m_Packet);
+		m_NextLayer = new(m_Packet) PayloadLayer(m_Data + headerLen, m_DataLen - headerLen, this, m_Packet);
 	}
 }
 
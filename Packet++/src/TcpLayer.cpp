@@ -329,11 +329,11 @@ TcpLayer& TcpLayer::operator=(const TcpLayer& other)
 	return *this;
 }
 
-void TcpLayer::parseNextLayer()
+ProtocolType TcpLayer::getNextLayerProtocol() const
 {
 	size_t headerLen = getHeaderLen();
 	if (m_DataLen <= headerLen)
-		return;
+		return UnknownProtocol;
 
 	uint8_t* payload = m_Data + headerLen;
 	size_t payloadLen = m_DataLen - headerLen;
@@ -342,24 +342,59 @@ void TcpLayer::parseNextLayer()
 	uint16_t portSrc = be16toh(tcpHder->portSrc);
 
 	if (HttpMessage::isHttpPort(portDst) && HttpRequestFirstLine::parseMethod((char*)payload, payloadLen) != HttpRequestLayer::HttpMethodUnknown)
-		m_NextLayer = new HttpRequestLayer(payload, payloadLen, this, m_Packet);
+		return HTTPRequest;
 	else if (HttpMessage::isHttpPort(portSrc) && HttpResponseFirstLine::parseStatusCode((char*)payload, payloadLen) != HttpResponseLayer::HttpStatusCodeUnknown)
-		m_NextLayer = new HttpResponseLayer(payload, payloadLen, this, m_Packet);
+		return HTTPResponse;
 	else if (SSLLayer::IsSSLMessage(portSrc, portDst, payload, payloadLen))
-		m_NextLayer = SSLLayer::createSSLMessage(payload, payloadLen, this, m_Packet);
+		return SSL;
 	else if (SipLayer::isSipPort(portDst))
 	{
 		if (SipRequestFirstLine::parseMethod((char*)payload, payloadLen) != SipRequestLayer::SipMethodUnknown)
-			m_NextLayer = new SipRequestLayer(payload, payloadLen, this, m_Packet);
+			return SIPRequest;
 		else if (SipResponseFirstLine::parseStatusCode((char*)payload, payloadLen) != SipResponseLayer::SipStatusCodeUnknown)
-			m_NextLayer = new SipResponseLayer(payload, payloadLen, this, m_Packet);
+			return SIPResponse;
 		else
-			m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+			return GenericPayload;
 	}
 	else if (BgpLayer::isBgpPort(portSrc, portDst))
-		m_NextLayer = BgpLayer::parseBgpLayer(payload, payloadLen, this, m_Packet);
+		return BgpLayer::isDataValid(payload, payloadLen) ? BGP : UnknownProtocol;
 	else
-		m_NextLayer = new PayloadLayer(payload, payloadLen, this, m_Packet);
+		return GenericPayload;
+}
+
+void TcpLayer::parseNextLayer()
+{
+	ProtocolType nextProtocol = getNextLayerProtocol();
+	if (nextProtocol == UnknownProtocol)
+		return;
+
+	size_t headerLen = getHeaderLen();
+	uint8_t* payload = m_Data + headerLen;
+	size_t payloadLen = m_DataLen - headerLen;
+
+	switch (nextProtocol)
+	{
+	case HTTPRequest:
+		m_NextLayer = new(m_Packet) HttpRequestLayer(payload, payloadLen, this, m_Packet);
+		break;
+	case HTTPResponse:
+		m_NextLayer = new(m_Packet) HttpResponseLayer(payload, payloadLen, this, m_Packet);
+		break;
+	case SSL:
+		m_NextLayer = SSLLayer::createSSLMessage(payload, payloadLen, this, m_Packet);
+		break;
+	case SIPRequest:
+		m_NextLayer = new(m_Packet) SipRequestLayer(payload, payloadLen, this, m_Packet);
+		break;
+	case SIPResponse:
+		m_NextLayer = new(m_Packet) SipResponseLayer(payload, payloadLen, this, m_Packet);
+		break;
+	case BGP:
+		m_NextLayer = BgpLayer::parseBgpLayer(payload, payloadLen, this, m_Packet);
+		break;
+	default:
+		m_NextLayer = new(m_Packet) PayloadLayer(payload, payloadLen, this, m_Packet);
+	}
 }
 
 void TcpLayer::computeCalculateFields()
@@ -17,6 +17,21 @@
 
 #define PURGE_FREQ_SECS 1
 
+// the initial number of slots in the connection table. It must be a power of 2
+#define CONNECTION_TABLE_INITIAL_CAPACITY 64
+
+// the wheel horizon when only the maximum number of connections is configured (no idle timeout)
+#define TIMER_WHEEL_DEFAULT_HORIZON_SECS 64
+
+// the maximum number of slots in the timer wheel. Connections expiring beyond the last slot are re-checked when the wheel reaches it
+#define TIMER_WHEEL_MAX_SIZE 4096
+
+// the minimal buffer size of an out-of-order fragment, large enough for a full-sized Ethernet segment so pooled buffers fit most segments
+#define FRAGMENT_MIN_BUFFER_SIZE 2048
+
+// the maximum number of free fragments kept for re-use
+#define FRAGMENT_POOL_MAX_SIZE 1024
+
 #define SEQ_LT(a,b)  ((int32_t)((a)-(b)) < 0)
 #define SEQ_LEQ(a,b) ((int32_t)((a)-(b)) <= 0)
 #define SEQ_GT(a,b)  ((int32_t)((a)-(b)) > 0)
@@ -59,6 +74,174 @@ void ConnectionData::copyData(const ConnectionData& other)
 }
 
 
+TcpReassembly::ConnectionTable::ConnectionTable()
+{
+	m_NumOfOccupied = 0;
+	m_NumOfDeleted = 0;
+	Entry emptyEntry;
+	emptyEntry.flowKey = 0;
+	emptyEntry.hash = 0;
+	emptyEntry.state = EntryEmpty;
+	emptyEntry.data = NULL;
+	emptyEntry.srcPort = 0;
+	emptyEntry.dstPort = 0;
+	m_Entries.resize(CONNECTION_TABLE_INITIAL_CAPACITY, emptyEntry);
+}
+
+size_t TcpReassembly::ConnectionTable::getFirstSlot(uint32_t hash) const
+{
+	// flow hashes are already hashes, but mix them anyway so hashes differing only in high bits don't collide
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3b;
+	hash ^= hash >> 16;
+	return hash & (m_Entries.size() - 1);
+}
+
+TcpReassembly::ConnectionTable::Entry* TcpReassembly::ConnectionTable::find(uint32_t hash, const IPAddress& srcIP, const IPAddress& dstIP, uint16_t srcPort, uint16_t dstPort)
+{
+	// the table always has empty slots so the search always ends
+	size_t mask = m_Entries.size() - 1;
+	for (size_t index = getFirstSlot(hash); ; index = (index + 1) & mask)
+	{
+		Entry& entry = m_Entries[index];
+		if (entry.state == EntryEmpty)
+			return NULL;
+
+		if (entry.state != EntryOccupied || entry.hash != hash)
+			continue;
+
+		if (entry.srcPort == srcPort && entry.dstPort == dstPort && entry.srcIP == srcIP && entry.dstIP == dstIP)
+			return &entry;
+
+		if (entry.srcPort == dstPort && entry.dstPort == srcPort && entry.srcIP == dstIP && entry.dstIP == srcIP)
+			return &entry;
+	}
+}
+
+TcpReassembly::ConnectionTable::Entry* TcpReassembly::ConnectionTable::findByFlowKey(uint32_t flowKey)
+{
+	return const_cast<Entry*>(static_cast<const ConnectionTable*>(this)->findByFlowKey(flowKey));
+}
+
+const TcpReassembly::ConnectionTable::Entry* TcpReassembly::ConnectionTable::findByFlowKey(uint32_t flowKey) const
+{
+	// entries are placed by their hash, which is the flow key unless the key was taken when the entry was inserted
+	uint32_t hash = flowKey;
+	if (!m_CollidingKeys.empty())
+	{
+		std::map<uint32_t, uint32_t>::const_iterator iter = m_CollidingKeys.find(flowKey);
+		if (iter != m_CollidingKeys.end())
+			hash = iter->second;
+	}
+
+	size_t mask = m_Entries.size() - 1;
+	for (size_t index = getFirstSlot(hash); ; index = (index + 1) & mask)
+	{
+		const Entry& entry = m_Entries[index];
+		if (entry.state == EntryEmpty)
+			return NULL;
+
+		if (entry.state == EntryOccupied && entry.flowKey == flowKey)
+			return &entry;
+	}
+}
+
+TcpReassembly::ConnectionTable::Entry& TcpReassembly::ConnectionTable::getFreeSlot(uint32_t hash)
+{
+	size_t mask = m_Entries.size() - 1;
+	size_t index = getFirstSlot(hash);
+	while (m_Entries[index].state == EntryOccupied)
+		index = (index + 1) & mask;
+
+	Entry& entry = m_Entries[index];
+	if (entry.state == EntryDeleted)
+		m_NumOfDeleted--;
+
+	m_NumOfOccupied++;
+	return entry;
+}
+
+TcpReassembly::ConnectionTable::Entry* TcpReassembly::ConnectionTable::insert(uint32_t hash, TcpReassemblyData* data)
+{
+	// keep the table at most 3/4 full (counting deleted slots) so searches stay short
+	if ((m_NumOfOccupied + m_NumOfDeleted + 1) * 4 > m_Entries.size() * 3)
+	{
+		size_t newCapacity = m_Entries.size();
+		while ((m_NumOfOccupied + 1) * 2 > newCapacity)
+			newCapacity *= 2;
+		rehash(newCapacity);
+	}
+
+	// if the hash collides with the key of another connection, give this connection the next unused key
+	uint32_t flowKey = hash;
+	while (findByFlowKey(flowKey) != NULL)
+		flowKey++;
+
+	if (flowKey != hash)
+	{
+		LOG_DEBUG("Flow hash 0x%X is already in use by another connection, using flow key 0x%X", hash, flowKey);
+		m_CollidingKeys[flowKey] = hash;
+	}
+
+	Entry& entry = getFreeSlot(hash);
+	entry.flowKey = flowKey;
+	entry.hash = hash;
+	entry.state = EntryOccupied;
+	entry.data = data;
+	entry.srcIP = data->connData.srcIP;
+	entry.dstIP = data->connData.dstIP;
+	entry.srcPort = data->connData.srcPort;
+	entry.dstPort = data->connData.dstPort;
+	data->connData.flowKey = flowKey;
+	return &entry;
+}
+
+void TcpReassembly::ConnectionTable::erase(Entry* entry)
+{
+	if (entry->flowKey != entry->hash)
+		m_CollidingKeys.erase(entry->flowKey);
+
+	entry->data = NULL;
+	m_NumOfOccupied--;
+
+	// if the next slot is empty no search goes through this slot, so it can be marked as empty instead of deleted
+	size_t index = entry - &m_Entries[0];
+	if (m_Entries[(index + 1) & (m_Entries.size() - 1)].state == EntryEmpty)
+	{
+		entry->state = EntryEmpty;
+	}
+	else
+	{
+		entry->state = EntryDeleted;
+		m_NumOfDeleted++;
+	}
+}
+
+void TcpReassembly::ConnectionTable::rehash(size_t newCapacity)
+{
+	std::vector<Entry> oldEntries;
+	oldEntries.swap(m_Entries);
+
+	Entry emptyEntry;
+	emptyEntry.flowKey = 0;
+	emptyEntry.hash = 0;
+	emptyEntry.state = EntryEmpty;
+	emptyEntry.data = NULL;
+	emptyEntry.srcPort = 0;
+	emptyEntry.dstPort = 0;
+	m_Entries.resize(newCapacity, emptyEntry);
+	m_NumOfOccupied = 0;
+	m_NumOfDeleted = 0;
+
+	// flow keys don't change, so entries are only moved to their new slots
+	for (std::vector<Entry>::iterator iter = oldEntries.begin(); iter != oldEntries.end(); ++iter)
+	{
+		if (iter->state == EntryOccupied)
+			getFreeSlot(iter->hash) = *iter;
+	}
+}
+
+
 TcpReassembly::TcpReassembly(OnTcpMessageReady onMessageReadyCallback, void* userCookie, OnTcpConnectionStart onConnectionStartCallback, OnTcpConnectionEnd onConnectionEndCallback, const TcpReassemblyConfiguration &config)
 {
 	m_OnMessageReadyCallback = onMessageReadyCallback;
@@ -68,31 +251,91 @@ TcpReassembly::TcpReassembly(OnTcpMessageReady onMessageReadyCallback, void* use
 	m_ClosedConnectionDelay = (config.closedConnectionDelay > 0) ? config.closedConnectionDelay : 5;
 	m_RemoveConnInfo = config.removeConnInfo;
 	m_MaxNumToClean = (config.removeConnInfo == true && config.maxNumToClean == 0) ? 30 : config.maxNumToClean;
-	m_PurgeTimepoint = time(NULL) + PURGE_FREQ_SECS;
+	m_UsePacketTimestamps = config.usePacketTimestamps;
+	m_LatestPacketTime = 0;
+	// with packet timestamps there is no current time before the first packet, so the first cleanup is when the first packet arrives
+	m_PurgeTimepoint = (m_UsePacketTimestamps ? 0 : time(NULL) + PURGE_FREQ_SECS);
+	m_ConnectionIdleTimeout = config.connectionIdleTimeout;
+	m_MaxNumOfConnections = config.maxNumOfConnections;
+	m_NumOfOpenConnections = 0;
+	m_MaxOutOfOrderBytesPerConnection = config.maxOutOfOrderBytesPerConnection;
+	m_MaxOutOfOrderBytes = config.maxOutOfOrderBytes;
+	m_NumOfOutOfOrderBytes = 0;
+	m_FragmentPool = NULL;
+	m_FragmentPoolSize = 0;
+
+	m_IdleList.prev = &m_IdleList;
+	m_IdleList.next = &m_IdleList;
+	m_TimerWheelHorizon = 0;
+	m_TimerWheelTime = 0;
+	m_TimerWheelStarted = false;
+
+	if (m_ConnectionIdleTimeout > 0 || m_MaxNumOfConnections > 0)
+	{
+		m_TimerWheelHorizon = (m_ConnectionIdleTimeout > 0 ? m_ConnectionIdleTimeout : TIMER_WHEEL_DEFAULT_HORIZON_SECS);
+
+		// the wheel should have a slot for each second of the horizon, so every connection can be linked to the slot it expires at
+		size_t wheelSize = 1;
+		while (wheelSize <= m_TimerWheelHorizon && wheelSize < TIMER_WHEEL_MAX_SIZE)
+			wheelSize *= 2;
+
+		m_TimerWheel.resize(wheelSize);
+		for (size_t i = 0; i < wheelSize; i++)
+		{
+			m_TimerWheel[i].prev = &m_TimerWheel[i];
+			m_TimerWheel[i].next = &m_TimerWheel[i];
+		}
+	}
 }
 
 TcpReassembly::~TcpReassembly()
 {
-	while (!m_ConnectionList.empty())
+	for (size_t i = 0; i < m_ConnectionTable.getCapacity(); i++)
+	{
+		ConnectionTable::Entry& entry = m_ConnectionTable.getEntryAt(i);
+		if (entry.state != ConnectionTable::EntryOccupied || entry.data == NULL)
+			continue;
+
+		for (int side = 0; side < 2; side++)
+		{
+			while (entry.data->twoSides[side].fragListHead != NULL)
+				removeFragment(entry.data, side, entry.data->twoSides[side].fragListHead);
+		}
+
+		delete entry.data;
+	}
+
+	while (m_FragmentPool != NULL)
 	{
-		if(m_ConnectionList.begin()->second != NULL)
-			delete m_ConnectionList.begin()->second;
-		m_ConnectionList.erase(m_ConnectionList.begin());
+		TcpFragment* fragment = m_FragmentPool;
+		m_FragmentPool = fragment->next;
+		delete fragment;
 	}
 }
 
 TcpReassembly::ReassemblyStatus TcpReassembly::reassemblePacket(Packet& tcpData)
 {
+	time_t packetTime = tcpData.getRawPacket()->getPacketTimeStamp().tv_sec;
+
+	// packet timestamps aren't always monotonic, the clock never goes backwards
+	if (m_UsePacketTimestamps && packetTime > m_LatestPacketTime)
+		m_LatestPacketTime = packetTime;
+
 	// automatic cleanup
 	if (m_RemoveConnInfo == true)
 	{
-		if(time(NULL) >= m_PurgeTimepoint)
+		time_t now = getCurrentTime();
+		if(now >= m_PurgeTimepoint)
 		{
 			purgeClosedConnections();
-			m_PurgeTimepoint = time(NULL) + PURGE_FREQ_SECS;
+			m_PurgeTimepoint = now + PURGE_FREQ_SECS;
 		}
 	}
 
+	// close connections that became idle by the time of this packet
+	if (!m_TimerWheel.empty())
+		advanceTimerWheel(packetTime);
+
 	// get IP layer
 	Layer* ipLayer = NULL;
 	if (tcpData.isPacketOfType(IPv4))
@@ -140,20 +383,6 @@ TcpReassembly::ReassemblyStatus TcpReassembly::reassemblePacket(Packet& tcpData)
 
 	TcpReassemblyData* tcpReassemblyData = NULL;
 
-	// calculate flow key for this packet
-	uint32_t flowKey = hash5Tuple(&tcpData);
-
-	// find the connection in the connection map
-	ConnectionList::iterator iter = m_ConnectionList.find(flowKey);
-
-	// if this packet belongs to a connection that was already closed (for example: data packet that comes after FIN), ignore it.
-	// the connection is already closed when the value of mapped type is NULL
-	if (iter != m_ConnectionList.end() && iter->second == NULL)
-	{
-		LOG_DEBUG("Ignoring packet of already closed flow [0x%X]", flowKey);
-		return Ignore_PacketOfClosedFlow;
-	}
-
 	// calculate packet's source and dest IP address
 	IPAddress srcIP, dstIP;
 
@@ -168,20 +397,46 @@ TcpReassembly::ReassemblyStatus TcpReassembly::reassemblePacket(Packet& tcpData)
 		dstIP = ((IPv6Layer*)ipLayer)->getDstIpAddress();
 	}
 
-	if (iter == m_ConnectionList.end())
+	uint16_t srcPort = be16toh(tcpLayer->getTcpHeader()->portSrc);
+	uint16_t dstPort = be16toh(tcpLayer->getTcpHeader()->portDst);
+
+	// find the connection in the connection table by the hash of the packet's 5-tuple and the 5-tuple itself
+	uint32_t flowHash = hash5Tuple(&tcpData);
+	ConnectionTable::Entry* entry = m_ConnectionTable.find(flowHash, srcIP, dstIP, srcPort, dstPort);
+
+	// if this packet belongs to a connection that was already closed (for example: data packet that comes after FIN), ignore it.
+	// the connection is already closed when its data is NULL
+	if (entry != NULL && entry->data == NULL)
 	{
+		LOG_DEBUG("Ignoring packet of already closed flow [0x%X]", entry->flowKey);
+		return Ignore_PacketOfClosedFlow;
+	}
+
+	uint32_t flowKey;
+
+	if (entry == NULL)
+	{
+		// if the maximum number of open connections is reached, make room for the new one
+		if (m_MaxNumOfConnections > 0 && m_NumOfOpenConnections >= m_MaxNumOfConnections)
+			evictIdlestConnection();
+
 		// if it's a packet of a new connection, create a TcpReassemblyData object and add it to the active connection list
 		tcpReassemblyData = new TcpReassemblyData();
 		tcpReassemblyData->connData.srcIP = srcIP;
 		tcpReassemblyData->connData.dstIP = dstIP;
-		tcpReassemblyData->connData.srcPort = be16toh(tcpLayer->getTcpHeader()->portSrc);
-		tcpReassemblyData->connData.dstPort = be16toh(tcpLayer->getTcpHeader()->portDst);
-		tcpReassemblyData->connData.flowKey = flowKey;
+		tcpReassemblyData->connData.srcPort = srcPort;
+		tcpReassemblyData->connData.dstPort = dstPort;
 		timeval ts = timespec_to_timeval(tcpData.getRawPacket()->getPacketTimeStamp());
 		tcpReassemblyData->connData.setStartTime(ts);
+		tcpReassemblyData->lastActivity = ts.tv_sec;
 
-		m_ConnectionList[flowKey] = tcpReassemblyData;
+		// the connection table sets the connection's flow key
+		m_ConnectionTable.insert(flowHash, tcpReassemblyData);
+		flowKey = tcpReassemblyData->connData.flowKey;
 		m_ConnectionInfo[flowKey] = tcpReassemblyData->connData;
+		m_NumOfOpenConnections++;
+		if (!m_TimerWheel.empty())
+			scheduleConnectionTimer(tcpReassemblyData);
 
 		// fire connection start callback
 		if (m_OnConnStart != NULL)
@@ -189,8 +444,13 @@ TcpReassembly::ReassemblyStatus TcpReassembly::reassemblePacket(Packet& tcpData)
 	}
 	else // connection already exists
 	{
-		tcpReassemblyData = iter->second;
+		tcpReassemblyData = entry->data;
+		flowKey = entry->flowKey;
 		timeval currTime = timespec_to_timeval(tcpData.getRawPacket()->getPacketTimeStamp());
+
+		// the connection stays linked to its current timer wheel slot, its timer is re-scheduled when the wheel reaches that slot
+		if (currTime.tv_sec > tcpReassemblyData->lastActivity)
+			tcpReassemblyData->lastActivity = currTime.tv_sec;
 		if (currTime.tv_sec > tcpReassemblyData->connData.endTime.tv_sec)
 		{
 			tcpReassemblyData->connData.setEndTime(currTime); 
@@ -207,9 +467,6 @@ TcpReassembly::ReassemblyStatus TcpReassembly::reassemblePacket(Packet& tcpData)
 	int sideIndex = -1;
 	bool first = false;
 
-	// calculate packet's source port
-	uint16_t srcPort = tcpLayer->getTcpHeader()->portSrc;
-
 	// if this is a new connection and it's the first packet we see on that connection
 	if (tcpReassemblyData->numOfSides == 0)
 	{
@@ -295,7 +552,7 @@ TcpReassembly::ReassemblyStatus TcpReassembly::reassemblePacket(Packet& tcpData)
 	// I'm aware that there are edge cases where the situation I described above is not true, but at some point we must clean the out-of-order packet list to avoid memory leak.
 	// I decided to do what Wireshark does and clean this list when starting to see a message from the other side
 	if (!first && tcpPayloadSize > 0 && tcpReassemblyData->prevSide != -1 && tcpReassemblyData->prevSide != sideIndex &&
-			tcpReassemblyData->twoSides[tcpReassemblyData->prevSide].tcpFragmentList.size() > 0)
+			tcpReassemblyData->twoSides[tcpReassemblyData->prevSide].fragListHead != NULL)
 	{
 		LOG_DEBUG("Seeing a first data packet from a different side. Previous side was %d, current side is %d", tcpReassemblyData->prevSide, sideIndex);
 		checkOutOfOrderFragments(tcpReassemblyData, tcpReassemblyData->prevSide, true);
@@ -445,15 +702,8 @@ TcpReassembly::ReassemblyStatus TcpReassembly::reassemblePacket(Packet& tcpData)
 			return status;
 		}
 
-		// create a new TcpFragment, copy the TCP data to it and add this packet to the the out-of-order packet list
-		TcpFragment* newTcpFrag = new TcpFragment();
-		newTcpFrag->data = new uint8_t[tcpPayloadSize];
-		newTcpFrag->dataLength = tcpPayloadSize;
-		newTcpFrag->sequence = sequence;
-		memcpy(newTcpFrag->data, tcpLayer->getLayerPayload(), tcpPayloadSize);
-		tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.pushBack(newTcpFrag);
-
-		LOG_DEBUG("Found out-of-order packet and added a new TCP fragment with size %d to the out-of-order list of side %d", (int)tcpPayloadSize, sideIndex);
+		// copy the TCP data to a new fragment in the out-of-order packet list
+		bufferOutOfOrderFragment(tcpReassemblyData, sideIndex, sequence, tcpLayer->getLayerPayload(), tcpPayloadSize);
 		status = OutOfOrderTcpMessageBuffered;
 
 		// handle case where this packet is FIN or RST
@@ -500,176 +750,207 @@ void TcpReassembly::handleFinOrRst(TcpReassemblyData* tcpReassemblyData, int sid
 
 void TcpReassembly::checkOutOfOrderFragments(TcpReassemblyData* tcpReassemblyData, int sideIndex, bool cleanWholeFragList)
 {
-	bool foundSomething = false;
+	TcpOneSideData& sideData = tcpReassemblyData->twoSides[sideIndex];
 
-	do
+	// the fragment list is sorted by sequence, so only its head has to be checked: once the head is beyond the current sequence,
+	// all other fragments are beyond it too
+	while (sideData.fragListHead != NULL)
 	{
-		LOG_DEBUG("Starting first iteration of checkOutOfOrderFragments - looking for fragments that match the current sequence or have smaller sequence");
-
-		int index = 0;
-		foundSomething = false;
+		TcpFragment* curTcpFrag = sideData.fragListHead;
 
-		do
+		// if fragment sequence matches the current sequence
+		if (curTcpFrag->sequence == sideData.sequence)
 		{
-			index = 0;
-			foundSomething = false;
+			LOG_DEBUG("Found an out-of-order packet matching to the current sequence with size %d on side %d. Pulling it out of the list and sending the data to the callback", (int)curTcpFrag->dataLength, sideIndex);
+
+			// update sequence
+			sideData.sequence += curTcpFrag->dataLength;
 
-			// first fragment list iteration - go over the whole fragment list and see if can find fragments that match the current sequence
-			// or have smaller sequence but have big enough payload to get new data
-			while (index < (int)tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.size())
+			// send new data to callback
+			if (m_OnMessageReadyCallback != NULL)
 			{
-				TcpFragment* curTcpFrag = tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.at(index);
+				TcpStreamData streamData(curTcpFrag->data, curTcpFrag->dataLength, tcpReassemblyData->connData);
+				m_OnMessageReadyCallback(sideIndex, streamData, m_UserCookie);
+			}
+		}
 
-				// if fragment sequence matches the current sequence
-				if (curTcpFrag->sequence == tcpReassemblyData->twoSides[sideIndex].sequence)
-				{
-					// update sequence
-					tcpReassemblyData->twoSides[sideIndex].sequence += curTcpFrag->dataLength;
-					if (curTcpFrag->data != NULL)
-					{
-						LOG_DEBUG("Found an out-of-order packet matching to the current sequence with size %d on side %d. Pulling it out of the list and sending the data to the callback", (int)curTcpFrag->dataLength, sideIndex);
+		// if fragment sequence has lower sequence than the current sequence
+		else if (SEQ_LT(curTcpFrag->sequence, sideData.sequence))
+		{
+			// check if it still has new data
+			uint32_t newSequence = curTcpFrag->sequence + curTcpFrag->dataLength;
 
-						// send new data to callback
+			// it has new data
+			if (SEQ_GT(newSequence, sideData.sequence))
+			{
+				// calculate the delta new data size
+				uint32_t newLength = sideData.sequence - curTcpFrag->sequence;
 
-						if (m_OnMessageReadyCallback != NULL)
-						{
-							TcpStreamData streamData(curTcpFrag->data, curTcpFrag->dataLength, tcpReassemblyData->connData);
-							m_OnMessageReadyCallback(sideIndex, streamData, m_UserCookie);
-						}
-					}
+				LOG_DEBUG("Found a fragment in the out-of-order list which its sequence is lower than expected but its payload is long enough to contain new data. "
+					"Calling the callback with the new data. Fragment size is %d on side %d, new data size is %d", (int)curTcpFrag->dataLength, sideIndex, (int)(curTcpFrag->dataLength - newLength));
 
+				// update current sequence with the delta new data size
+				sideData.sequence += curTcpFrag->dataLength - newLength;
+
+				// send only the new data to the callback
+				if (m_OnMessageReadyCallback != NULL)
+				{
+					TcpStreamData streamData(curTcpFrag->data + newLength, curTcpFrag->dataLength - newLength, tcpReassemblyData->connData);
+					m_OnMessageReadyCallback(sideIndex, streamData, m_UserCookie);
+				}
+			}
+			else
+			{
+				LOG_DEBUG("Found a fragment in the out-of-order list which doesn't contain any new data, ignoring it. Fragment size is %d on side %d", (int)curTcpFrag->dataLength, sideIndex);
+			}
+		}
 
-					// remove fragment from list
-					tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.erase(tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.begin() + index);
+		// if got to here it means the fragment has higher sequence than current sequence. This means out-of-order packets or
+		// missing data. If we don't want to clear the frag list yet, assume it's out-of-order and return
+		else if (!cleanWholeFragList)
+		{
+			return;
+		}
 
-					foundSomething = true;
+		// otherwise treat the gap before the fragment as missing data
+		else
+		{
+			// calculate number of missing bytes
+			uint32_t missingDataLen = curTcpFrag->sequence - sideData.sequence;
 
-					continue;
-				}
+			// update sequence
+			sideData.sequence = curTcpFrag->sequence + curTcpFrag->dataLength;
 
-				// if fragment sequence has lower sequence than the current sequence
-				if (SEQ_LT(curTcpFrag->sequence, tcpReassemblyData->twoSides[sideIndex].sequence))
-				{
-					// check if it still has new data
-					uint32_t newSequence = curTcpFrag->sequence + curTcpFrag->dataLength;
-
-					// it has new data
-					if (SEQ_GT(newSequence, tcpReassemblyData->twoSides[sideIndex].sequence))
-					{
-						// calculate the delta new data size
-						uint32_t newLength = tcpReassemblyData->twoSides[sideIndex].sequence - curTcpFrag->sequence;
-
-						LOG_DEBUG("Found a fragment in the out-of-order list which its sequence is lower than expected but its payload is long enough to contain new data. "
-							"Calling the callback with the new data. Fragment size is %d on side %d, new data size is %d", (int)curTcpFrag->dataLength, sideIndex, (int)(curTcpFrag->dataLength - newLength));
-
-						// update current sequence with the delta new data size
-						tcpReassemblyData->twoSides[sideIndex].sequence += curTcpFrag->dataLength - newLength;
-
-						// send only the new data to the callback
-						if (m_OnMessageReadyCallback != NULL)
-						{
-							TcpStreamData streamData(curTcpFrag->data + newLength, curTcpFrag->dataLength - newLength, tcpReassemblyData->connData);
-							m_OnMessageReadyCallback(sideIndex, streamData, m_UserCookie);
-						}
-
-						foundSomething = true;
-					}
-					else
-					{
-						LOG_DEBUG("Found a fragment in the out-of-order list which doesn't contain any new data, ignoring it. Fragment size is %d on side %d", (int)curTcpFrag->dataLength, sideIndex);
-					}
-
-					// delete fragment from list
-					tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.erase(tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.begin() + index);
-
-					continue;
-				}
+			// send new data to callback
+			if (m_OnMessageReadyCallback != NULL)
+			{
+				// prepare missing data text
+				std::string missingDataTextStr = prepareMissingDataMessage(missingDataLen);
+
+				// add missing data text to the data that will be sent to the callback. This means that the data will look something like:
+				// "[xx bytes missing]<original_data>"
+				std::vector<uint8_t> dataWithMissingDataText;
+				dataWithMissingDataText.reserve(missingDataTextStr.length() + curTcpFrag->dataLength);
+				dataWithMissingDataText.insert(dataWithMissingDataText.end(), missingDataTextStr.begin(), missingDataTextStr.end());
+				dataWithMissingDataText.insert(dataWithMissingDataText.end(), curTcpFrag->data, curTcpFrag->data + curTcpFrag->dataLength);
+
+				TcpStreamData streamData(&dataWithMissingDataText[0], dataWithMissingDataText.size(), tcpReassemblyData->connData,
+					missingDataLen, missingDataTextStr.length());
+				m_OnMessageReadyCallback(sideIndex, streamData, m_UserCookie);
 
-				//if got to here it means the fragment has higher sequence than current sequence, increment index and continue
-				index++;
+				LOG_DEBUG("Found missing data on side %d: %d byte are missing. Sending the closest fragment which is in size %d + missing text message which size is %d",
+					sideIndex, missingDataLen, (int)curTcpFrag->dataLength, (int)missingDataTextStr.length());
 			}
+		}
 
-			// if managed to find new segment, do the search all over again
-		} while (foundSomething);
-
+		// remove fragment from list
+		removeFragment(tcpReassemblyData, sideIndex, curTcpFrag);
+	}
+}
 
-		// if got here it means we're left only with fragments that have higher sequence than current sequence. This means out-of-order packets or
-		// missing data. If we don't want to clear the frag list yet, assume it's out-of-order and return
-		if (!cleanWholeFragList)
-			return;
+void TcpReassembly::bufferOutOfOrderFragment(TcpReassemblyData* tcpReassemblyData, int sideIndex, uint32_t sequence, const uint8_t* data, size_t dataLength)
+{
+	TcpOneSideData& sideData = tcpReassemblyData->twoSides[sideIndex];
+
+	TcpFragment* newTcpFrag = allocateFragment(dataLength);
+	newTcpFrag->sequence = sequence;
+	newTcpFrag->dataLength = dataLength;
+	memcpy(newTcpFrag->data, data, dataLength);
+
+	// out-of-order segments usually arrive in increasing sequence order after a gap, so the insertion point is searched from the tail.
+	// A fragment with the same sequence as existing ones is put after them
+	TcpFragment* prevFrag = sideData.fragListTail;
+	while (prevFrag != NULL && SEQ_LT(sequence, prevFrag->sequence))
+		prevFrag = prevFrag->prev;
+
+	newTcpFrag->prev = prevFrag;
+	newTcpFrag->next = (prevFrag != NULL ? prevFrag->next : sideData.fragListHead);
+	if (newTcpFrag->next != NULL)
+		newTcpFrag->next->prev = newTcpFrag;
+	else
+		sideData.fragListTail = newTcpFrag;
+	if (prevFrag != NULL)
+		prevFrag->next = newTcpFrag;
+	else
+		sideData.fragListHead = newTcpFrag;
 
-		LOG_DEBUG("Starting second  iteration of checkOutOfOrderFragments - handle missing data");
+	tcpReassemblyData->outOfOrderBytes += dataLength;
+	m_NumOfOutOfOrderBytes += dataLength;
 
-		// second fragment list iteration - now we're left only with fragments that have higher sequence than current sequence. This means missing data.
-		// Search for the fragment with the closest sequence to the current one
+	LOG_DEBUG("Found out-of-order packet and added a new TCP fragment with size %d to the out-of-order list of side %d", (int)dataLength, sideIndex);
 
-		uint32_t closestSequence = 0xffffffff;
-		bool closestSequenceDefined = false;
-		int closestSequenceFragIndex = -1;
-		index = 0;
+	// if the buffered data exceeds one of the limits, treat the out-of-order data of both sides of the connection as missing data.
+	// Both limits count the two sides together, so flushing only this side might leave the connection above the limit
+	if ((m_MaxOutOfOrderBytesPerConnection > 0 && tcpReassemblyData->outOfOrderBytes > m_MaxOutOfOrderBytesPerConnection) ||
+			(m_MaxOutOfOrderBytes > 0 && m_NumOfOutOfOrderBytes > m_MaxOutOfOrderBytes))
+	{
+		LOG_DEBUG("Out-of-order data limit exceeded on side %d (%d bytes buffered for the connection, %d bytes in total). Flushing both sides as missing data",
+			sideIndex, (int)tcpReassemblyData->outOfOrderBytes, (int)m_NumOfOutOfOrderBytes);
+		checkOutOfOrderFragments(tcpReassemblyData, sideIndex, true);
+		checkOutOfOrderFragments(tcpReassemblyData, 1 - sideIndex, true);
+	}
+}
 
-		while (index < (int)tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.size())
-		{
-			// extract segment at current index
-			TcpFragment* curTcpFrag = tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.at(index);
+void TcpReassembly::removeFragment(TcpReassemblyData* tcpReassemblyData, int sideIndex, TcpFragment* fragment)
+{
+	TcpOneSideData& sideData = tcpReassemblyData->twoSides[sideIndex];
 
-			// check if its sequence is closer than current closest sequence
-			if (!closestSequenceDefined || SEQ_LT(curTcpFrag->sequence, closestSequence))
-			{
-				closestSequence = curTcpFrag->sequence;
-				closestSequenceFragIndex = index;
-				closestSequenceDefined = true;
-			}
+	if (fragment->prev != NULL)
+		fragment->prev->next = fragment->next;
+	else
+		sideData.fragListHead = fragment->next;
 
-			index++;
-		}
+	if (fragment->next != NULL)
+		fragment->next->prev = fragment->prev;
+	else
+		sideData.fragListTail = fragment->prev;
 
-		// this means fragment list is not empty at this stage
-		if (closestSequenceFragIndex > -1)
-		{
-			// get the fragment with the closest sequence
-			TcpFragment* curTcpFrag = tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.at(closestSequenceFragIndex);
+	tcpReassemblyData->outOfOrderBytes -= fragment->dataLength;
+	m_NumOfOutOfOrderBytes -= fragment->dataLength;
 
-			// calculate number of missing bytes
-			uint32_t missingDataLen = curTcpFrag->sequence - tcpReassemblyData->twoSides[sideIndex].sequence;
+	releaseFragment(fragment);
+}
 
-			// update sequence
-			tcpReassemblyData->twoSides[sideIndex].sequence = curTcpFrag->sequence + curTcpFrag->dataLength;
-			if (curTcpFrag->data != NULL)
-			{
-				// send new data to callback
-				if (m_OnMessageReadyCallback != NULL)
-				{
-					// prepare missing data text
-					std::string missingDataTextStr = prepareMissingDataMessage(missingDataLen);
-
-					// add missing data text to the data that will be sent to the callback. This means that the data will look something like:
-					// "[xx bytes missing]<original_data>"
-					std::vector<uint8_t> dataWithMissingDataText;
-					dataWithMissingDataText.reserve(missingDataTextStr.length() + curTcpFrag->dataLength);
-					dataWithMissingDataText.insert(dataWithMissingDataText.end(), missingDataTextStr.begin(), missingDataTextStr.end());
-					dataWithMissingDataText.insert(dataWithMissingDataText.end(), curTcpFrag->data, curTcpFrag->data + curTcpFrag->dataLength);
-
-					//TcpStreamData streamData(curTcpFrag->data, curTcpFrag->dataLength, tcpReassemblyData->connData);
-					TcpStreamData streamData(&dataWithMissingDataText[0], dataWithMissingDataText.size(), tcpReassemblyData->connData);
-					m_OnMessageReadyCallback(sideIndex, streamData, m_UserCookie);
+TcpReassembly::TcpFragment* TcpReassembly::allocateFragment(size_t dataLength)
+{
+	TcpFragment* fragment = m_FragmentPool;
+	if (fragment != NULL)
+	{
+		m_FragmentPool = fragment->next;
+		m_FragmentPoolSize--;
+	}
+	else
+	{
+		fragment = new TcpFragment();
+	}
 
-					LOG_DEBUG("Found missing data on side %d: %d byte are missing. Sending the closest fragment which is in size %d + missing text message which size is %d",
-						sideIndex, missingDataLen, (int)curTcpFrag->dataLength, (int)missingDataTextStr.length());
-				}
-			}
+	// pooled buffers only grow, so after a while they fit most segments and no allocation is needed
+	if (fragment->bufferSize < dataLength)
+	{
+		if (fragment->data != NULL)
+			delete [] fragment->data;
 
-			// remove fragment from list
-			tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.erase(tcpReassemblyData->twoSides[sideIndex].tcpFragmentList.begin() + closestSequenceFragIndex);
+		fragment->bufferSize = (dataLength > FRAGMENT_MIN_BUFFER_SIZE ? dataLength : FRAGMENT_MIN_BUFFER_SIZE);
+		fragment->data = new uint8_t[fragment->bufferSize];
+	}
 
-			LOG_DEBUG("Calling checkOutOfOrderFragments again from the start");
+	fragment->prev = NULL;
+	fragment->next = NULL;
+	return fragment;
+}
 
-			// call the method again from the start to do the whole search again (both iterations). 
-			// the stop condition is when the list is empty (so closestSequenceFragIndex == -1)
-			foundSomething = true;
-		}
+void TcpReassembly::releaseFragment(TcpFragment* fragment)
+{
+	if (m_FragmentPoolSize >= FRAGMENT_POOL_MAX_SIZE)
+	{
+		delete fragment;
+		return;
+	}
 
-	} while (foundSomething);
+	fragment->prev = NULL;
+	fragment->next = m_FragmentPool;
+	m_FragmentPool = fragment;
+	m_FragmentPoolSize++;
 }
 
 void TcpReassembly::closeConnection(uint32_t flowKey)
@@ -680,19 +961,23 @@ void TcpReassembly::closeConnection(uint32_t flowKey)
 void TcpReassembly::closeConnectionInternal(uint32_t flowKey, ConnectionEndReason reason)
 {
 	TcpReassemblyData* tcpReassemblyData = NULL;
-	ConnectionList::iterator iter = m_ConnectionList.find(flowKey);
-	if (iter == m_ConnectionList.end())
+	ConnectionTable::Entry* entry = m_ConnectionTable.findByFlowKey(flowKey);
+	if (entry == NULL)
 	{
 		LOG_ERROR("Cannot close flow with key 0x%X: cannot find flow", flowKey);
 		return;
 	}
 
-	if (iter->second == NULL) // the connection is already closed
+	if (entry->data == NULL) // the connection is already closed
 		return;
 
 	LOG_DEBUG("Closing connection with flow key 0x%X", flowKey);
 
-	tcpReassemblyData = iter->second;
+	tcpReassemblyData = entry->data;
+
+	// stop tracking the connection as an open one
+	unlinkTimerNode(tcpReassemblyData);
+	m_NumOfOpenConnections--;
 
 	LOG_DEBUG("Calling checkOutOfOrderFragments on side 0");
 	checkOutOfOrderFragments(tcpReassemblyData, 0, true);
@@ -704,7 +989,11 @@ void TcpReassembly::closeConnectionInternal(uint32_t flowKey, ConnectionEndReaso
 		m_OnConnEnd(tcpReassemblyData->connData, reason, m_UserCookie);
 
 	delete tcpReassemblyData;
-	iter->second = NULL; // mark the connection as closed
+
+	// mark the connection as closed. The entry is looked up again since the callbacks may have changed the table
+	entry = m_ConnectionTable.findByFlowKey(flowKey);
+	if (entry != NULL)
+		entry->data = NULL;
 	insertIntoCleanupList(flowKey);
 
 	LOG_DEBUG("Connection with flow key 0x%X is closed", flowKey);
@@ -714,39 +1003,22 @@ void TcpReassembly::closeAllConnections()
 {
 	LOG_DEBUG("Closing all flows");
 
-	ConnectionList::iterator iter = m_ConnectionList.begin(), iterEnd = m_ConnectionList.end();
-	for (; iter != iterEnd; ++iter)
+	// closing a connection doesn't add or move entries in the table so it's safe to go over it this way
+	for (size_t i = 0; i < m_ConnectionTable.getCapacity(); i++)
 	{
-		if (iter->second == NULL) // the connection is already closed, skip it
+		ConnectionTable::Entry& entry = m_ConnectionTable.getEntryAt(i);
+		if (entry.state != ConnectionTable::EntryOccupied || entry.data == NULL) // the connection is already closed, skip it
 			continue;
 
-		TcpReassemblyData* tcpReassemblyData = iter->second;
-
-		uint32_t flowKey = tcpReassemblyData->connData.flowKey;
-		LOG_DEBUG("Closing connection with flow key 0x%X", flowKey);
-
-		LOG_DEBUG("Calling checkOutOfOrderFragments on side 0");
-		checkOutOfOrderFragments(tcpReassemblyData, 0, true);
-
-		LOG_DEBUG("Calling checkOutOfOrderFragments on side 1");
-		checkOutOfOrderFragments(tcpReassemblyData, 1, true);
-
-		if (m_OnConnEnd != NULL)
-			m_OnConnEnd(tcpReassemblyData->connData, TcpReassemblyConnectionClosedManually, m_UserCookie);
-
-		delete tcpReassemblyData;
-		iter->second = NULL; // mark the connection as closed
-		insertIntoCleanupList(flowKey);
-
-		LOG_DEBUG("Connection with flow key 0x%X is closed", flowKey);
+		closeConnectionInternal(entry.flowKey, TcpReassemblyConnectionClosedManually);
 	}
 }
 
 int TcpReassembly::isConnectionOpen(const ConnectionData& connection) const
 {
-	ConnectionList::const_iterator iter = m_ConnectionList.find(connection.flowKey);
-	if (iter != m_ConnectionList.end())
-		return iter->second != NULL; // If the value of mapped type is NULL then this connection is closed
+	const ConnectionTable::Entry* entry = m_ConnectionTable.findByFlowKey(connection.flowKey);
+	if (entry != NULL)
+		return entry->data != NULL; // If the connection data is NULL then this connection is closed
 
 	return -1;
 }
@@ -756,7 +1028,7 @@ void TcpReassembly::insertIntoCleanupList(uint32_t flowKey)
 	// m_CleanupList is a map with key of type time_t (expiration time). The mapped type is a list that stores the flow keys to be cleared in certain point of time.
 	// m_CleanupList.insert inserts an empty list if the container does not already contain an element with an equivalent key,
 	// otherwise this method returns an iterator to the element that prevents insertion.
-	std::pair<CleanupList::iterator, bool> pair = m_CleanupList.insert(std::make_pair(time(NULL) + m_ClosedConnectionDelay, CleanupList::mapped_type()));
+	std::pair<CleanupList::iterator, bool> pair = m_CleanupList.insert(std::make_pair(getCurrentTime() + m_ClosedConnectionDelay, CleanupList::mapped_type()));
 
 	// getting the reference to list
 	CleanupList::mapped_type& keysList = pair.first->second;
@@ -770,7 +1042,7 @@ uint32_t TcpReassembly::purgeClosedConnections(uint32_t maxNumToClean)
 	if(maxNumToClean == 0)
 		maxNumToClean = m_MaxNumToClean;
 
-	CleanupList::iterator iterTime = m_CleanupList.begin(), iterTimeEnd = m_CleanupList.upper_bound(time(NULL));
+	CleanupList::iterator iterTime = m_CleanupList.begin(), iterTimeEnd = m_CleanupList.upper_bound(getCurrentTime());
 	while(iterTime != iterTimeEnd && count < maxNumToClean)
 	{
 		CleanupList::mapped_type& keysList = iterTime->second;
@@ -779,7 +1051,9 @@ uint32_t TcpReassembly::purgeClosedConnections(uint32_t maxNumToClean)
 		{
 			const CleanupList::mapped_type::reference key = keysList.front();
 			m_ConnectionInfo.erase(key);
-			m_ConnectionList.erase(key);
+			ConnectionTable::Entry* entry = m_ConnectionTable.findByFlowKey(key);
+			if (entry != NULL)
+				m_ConnectionTable.erase(entry);
 			keysList.pop_front();
 		}
 
@@ -792,4 +1066,139 @@ uint32_t TcpReassembly::purgeClosedConnections(uint32_t maxNumToClean)
 	return count;
 }
 
+void TcpReassembly::linkTimerNode(ConnectionTimerNode* listHead, ConnectionTimerNode* node)
+{
+	node->prev = listHead->prev;
+	node->next = listHead;
+	listHead->prev->next = node;
+	listHead->prev = node;
+}
+
+void TcpReassembly::unlinkTimerNode(ConnectionTimerNode* node)
+{
+	if (node->next == NULL) // the node isn't linked to any list
+		return;
+
+	node->prev->next = node->next;
+	node->next->prev = node->prev;
+	node->prev = NULL;
+	node->next = NULL;
+}
+
+void TcpReassembly::scheduleConnectionTimer(TcpReassemblyData* tcpReassemblyData)
+{
+	// link the connection to the slot of the second it expires at. Connections are only ever linked to slots of the seconds after the
+	// current wheel time, and deadlines beyond the end of the wheel are rounded down to its last slot
+	time_t deadline = tcpReassemblyData->lastActivity + m_TimerWheelHorizon;
+	time_t firstSlotTime = m_TimerWheelTime + 1;
+	time_t lastSlotTime = m_TimerWheelTime + (time_t)m_TimerWheel.size() - 1;
+	if (deadline < firstSlotTime)
+		deadline = firstSlotTime;
+	else if (deadline > lastSlotTime)
+		deadline = lastSlotTime;
+
+	unlinkTimerNode(tcpReassemblyData);
+	linkTimerNode(&m_TimerWheel[deadline & (m_TimerWheel.size() - 1)], tcpReassemblyData);
+}
+
+void TcpReassembly::advanceTimerWheel(time_t now)
+{
+	if (!m_TimerWheelStarted)
+	{
+		m_TimerWheelTime = now;
+		m_TimerWheelStarted = true;
+		return;
+	}
+
+	// packet timestamps aren't always monotonic, the wheel never goes backwards
+	if (now <= m_TimerWheelTime)
+		return;
+
+	size_t wheelSize = m_TimerWheel.size();
+	size_t numOfSlotsToCheck = (now - m_TimerWheelTime >= (time_t)wheelSize ? wheelSize : (size_t)(now - m_TimerWheelTime));
+	time_t prevTime = m_TimerWheelTime;
+	m_TimerWheelTime = now;
+
+	for (size_t i = 1; i <= numOfSlotsToCheck; i++)
+	{
+		ConnectionTimerNode* slot = &m_TimerWheel[(prevTime + i) & (wheelSize - 1)];
+		if (slot->next == slot)
+			continue;
+
+		// move the slot content to a local list so connections re-scheduled to the same slot aren't checked twice
+		ConnectionTimerNode dueList;
+		dueList.next = slot->next;
+		dueList.prev = slot->prev;
+		dueList.next->prev = &dueList;
+		dueList.prev->next = &dueList;
+		slot->next = slot;
+		slot->prev = slot;
+
+		while (dueList.next != &dueList)
+		{
+			TcpReassemblyData* tcpReassemblyData = static_cast<TcpReassemblyData*>(dueList.next);
+			unlinkTimerNode(tcpReassemblyData);
+
+			if (tcpReassemblyData->lastActivity + (time_t)m_TimerWheelHorizon > now)
+			{
+				// the connection saw packets since it was scheduled
+				scheduleConnectionTimer(tcpReassemblyData);
+			}
+			else if (m_ConnectionIdleTimeout > 0)
+			{
+				LOG_DEBUG("Connection with flow key 0x%X is idle for more than %d seconds", tcpReassemblyData->connData.flowKey, (int)m_ConnectionIdleTimeout);
+				closeConnectionInternal(tcpReassemblyData->connData.flowKey, TcpReassemblyConnectionClosedByIdleTimeout);
+			}
+			else
+			{
+				linkTimerNode(&m_IdleList, tcpReassemblyData);
+			}
+		}
+	}
+}
+
+bool TcpReassembly::evictIdlestConnection()
+{
+	TcpReassemblyData* victim = NULL;
+
+	// connections idle for longer than the wheel horizon are the idlest ones, and they're kept in the order they became idle
+	while (victim == NULL && m_IdleList.next != &m_IdleList)
+	{
+		TcpReassemblyData* tcpReassemblyData = static_cast<TcpReassemblyData*>(m_IdleList.next);
+		if (tcpReassemblyData->lastActivity + (time_t)m_TimerWheelHorizon > m_TimerWheelTime)
+			scheduleConnectionTimer(tcpReassemblyData); // the connection saw packets since it became idle
+		else
+			victim = tcpReassemblyData;
+	}
+
+	// otherwise look for the connection that expires first. Connections that saw packets since they were scheduled are linked to earlier
+	// slots than they should be, so move them to their correct slots on the way
+	size_t wheelSize = m_TimerWheel.size();
+	for (size_t i = 1; victim == NULL && i < wheelSize; i++)
+	{
+		time_t slotTime = m_TimerWheelTime + i;
+		ConnectionTimerNode* slot = &m_TimerWheel[slotTime & (wheelSize - 1)];
+		while (slot->next != slot)
+		{
+			TcpReassemblyData* tcpReassemblyData = static_cast<TcpReassemblyData*>(slot->next);
+			time_t deadline = tcpReassemblyData->lastActivity + m_TimerWheelHorizon;
+			if (deadline > slotTime && slotTime < m_TimerWheelTime + (time_t)wheelSize - 1)
+			{
+				scheduleConnectionTimer(tcpReassemblyData);
+				continue;
+			}
+
+			victim = tcpReassemblyData;
+			break;
+		}
+	}
+
+	if (victim == NULL)
+		return false;
+
+	LOG_DEBUG("Maximum number of connections reached, closing connection with flow key 0x%X", victim->connData.flowKey);
+	closeConnectionInternal(victim->connData.flowKey, TcpReassemblyConnectionClosedByMaxConnections);
+	return true;
+}
+
 }
@@ -2,8 +2,9 @@
 #include "Logger.h"
 #include "PayloadLayer.h"
 #include <string.h>
-#include <algorithm>
+#include <ctype.h>
 #include <stdlib.h>
+#include <new>
 
 namespace pcpp
 {
@@ -21,14 +22,18 @@ size_t tbp_my_own_strnlen(const char* s, size_t n)
 	return (size_t) (p - s);
 }
 
+// FNV-1a parameters used for hashing header field names
+#define TBP_NAME_HASH_OFFSET_BASIS 2166136261U
+#define TBP_NAME_HASH_PRIME 16777619U
+
 
 // -------- Class TextBasedProtocolMessage -----------------
 
 
 TextBasedProtocolMessage::TextBasedProtocolMessage(uint8_t* data, size_t dataLen, Layer* prevLayer, Packet* packet) : Layer(data, dataLen, prevLayer, packet),
-						m_FieldList(NULL), m_LastField(NULL), m_FieldsOffset(0) {}
+						m_FieldList(NULL), m_LastField(NULL), m_FieldsOffset(0), m_NextInsertionOrder(0), m_InlineFieldsInUse(0) {}
 
-TextBasedProtocolMessage::TextBasedProtocolMessage(const TextBasedProtocolMessage& other) : Layer(other)
+TextBasedProtocolMessage::TextBasedProtocolMessage(const TextBasedProtocolMessage& other) : Layer(other), m_NextInsertionOrder(0), m_InlineFieldsInUse(0)
 {
 	copyDataFrom(other);
 }
@@ -36,13 +41,8 @@ TextBasedProtocolMessage::TextBasedProtocolMessage(const TextBasedProtocolMessag
 TextBasedProtocolMessage& TextBasedProtocolMessage::operator=(const TextBasedProtocolMessage& other)
 {
 	Layer::operator=(other);
-	HeaderField* curField = m_FieldList;
-	while (curField != NULL)
-	{
-		HeaderField* temp = curField;
-		curField = curField->getNextField();
-		delete temp;
-	}
+	releaseAllFields();
+	m_NextInsertionOrder = 0;
 
 	copyDataFrom(other);
 
@@ -54,14 +54,16 @@ void TextBasedProtocolMessage::copyDataFrom(const TextBasedProtocolMessage& othe
 	// copy field list
 	if (other.m_FieldList != NULL)
 	{
-		m_FieldList = new HeaderField(*(other.m_FieldList));
+		m_FieldList = new(allocateField()) HeaderField(*(other.m_FieldList));
 		HeaderField* curField = m_FieldList;
 		curField->attachToTextBasedProtocolMessage(this, other.m_FieldList->m_NameOffsetInMessage);
+		setFieldInsertionOrder(curField);
 		HeaderField* curOtherField = other.m_FieldList;
 		while (curOtherField->getNextField() != NULL)
 		{
-			HeaderField* newField = new HeaderField(*(curOtherField->getNextField()));
+			HeaderField* newField = new(allocateField()) HeaderField(*(curOtherField->getNextField()));
 			newField->attachToTextBasedProtocolMessage(this, curOtherField->getNextField()->m_NameOffsetInMessage);
+			setFieldInsertionOrder(newField);
 			curField->setNextField(newField);
 			curField = curField->getNextField();
 			curOtherField = curOtherField->getNextField();
@@ -76,12 +78,45 @@ void TextBasedProtocolMessage::copyDataFrom(const TextBasedProtocolMessage& othe
 	}
 
 	m_FieldsOffset = other.m_FieldsOffset;
+}
 
-	// copy map
-	for(HeaderField* field = m_FieldList; field != NULL; field = field->getNextField())
+void* TextBasedProtocolMessage::allocateField()
+{
+	for (int i = 0; i < PCPP_TEXT_BASED_PROTOCOL_INLINE_FIELDS; i++)
 	{
-		m_FieldNameToFieldMap.insert(std::pair<std::string, HeaderField*>(field->getFieldName(), field));
+		uint32_t slotMask = (uint32_t)1 << i;
+		if ((m_InlineFieldsInUse & slotMask) == 0)
+		{
+			m_InlineFieldsInUse |= slotMask;
+			return m_InlineFieldStorage + i * sizeof(HeaderField);
+		}
 	}
+
+	// all inline slots are taken
+	return ::operator new(sizeof(HeaderField));
+}
+
+void TextBasedProtocolMessage::releaseField(HeaderField* field)
+{
+	field->~HeaderField();
+
+	uint8_t* fieldPtr = (uint8_t*)field;
+	if (fieldPtr >= m_InlineFieldStorage && fieldPtr < m_InlineFieldStorage + sizeof(m_InlineFieldStorage))
+		m_InlineFieldsInUse &= ~((uint32_t)1 << ((fieldPtr - m_InlineFieldStorage) / sizeof(HeaderField)));
+	else
+		::operator delete(field);
+}
+
+void TextBasedProtocolMessage::releaseAllFields()
+{
+	while (m_FieldList != NULL)
+	{
+		HeaderField* temp = m_FieldList;
+		m_FieldList = m_FieldList->getNextField();
+		releaseField(temp);
+	}
+
+	m_LastField = NULL;
 }
 
 
@@ -90,19 +125,16 @@ void TextBasedProtocolMessage::parseFields()
 	char nameValueSeperator = getHeaderFieldNameValueSeparator();
 	bool spacesAllowedBetweenNameAndValue = spacesAllowedBetweenHeaderFieldNameAndValue();
 
-	HeaderField* firstField = new HeaderField(this, m_FieldsOffset, nameValueSeperator, spacesAllowedBetweenNameAndValue);
+	HeaderField* firstField = new(allocateField()) HeaderField(this, m_FieldsOffset, nameValueSeperator, spacesAllowedBetweenNameAndValue);
 	LOG_DEBUG("Added new field: name='%s'; offset in packet=%d; length=%d", firstField->getFieldName().c_str(), firstField->m_NameOffsetInMessage, (int)firstField->getFieldSize());
 	LOG_DEBUG("     Field value = %s", firstField->getFieldValue().c_str());
+	setFieldInsertionOrder(firstField);
 
 	if (m_FieldList == NULL)
 		m_FieldList = firstField;
 	else
 		m_FieldList->setNextField(firstField);
 
-	std::string fieldName = firstField->getFieldName();
-	std::transform(fieldName.begin(), fieldName.end(), fieldName.begin(), ::tolower);
-	m_FieldNameToFieldMap.insert(std::pair<std::string, HeaderField*>(fieldName, firstField));
-
 	// Last field will be empty and contain just "\n" or "\r\n". This field will mark the end of the header
 	HeaderField* curField = m_FieldList;
 	int curOffset = m_FieldsOffset;
@@ -112,20 +144,18 @@ void TextBasedProtocolMessage::parseFields()
 	while (!curField->isEndOfHeader() && curOffset + curField->getFieldSize() < m_DataLen)
 	{
 		curOffset += curField->getFieldSize();
-		HeaderField* newField = new HeaderField(this, curOffset, nameValueSeperator, spacesAllowedBetweenNameAndValue);
+		HeaderField* newField = new(allocateField()) HeaderField(this, curOffset, nameValueSeperator, spacesAllowedBetweenNameAndValue);
 		if(newField->getFieldSize() > 0)
 		{
 			LOG_DEBUG("Added new field: name='%s'; offset in packet=%d; length=%d", newField->getFieldName().c_str(), newField->m_NameOffsetInMessage, (int)newField->getFieldSize());
 			LOG_DEBUG("     Field value = %s", newField->getFieldValue().c_str());
+			setFieldInsertionOrder(newField);
 			curField->setNextField(newField);
 			curField = newField;
-			fieldName = newField->getFieldName();
-			std::transform(fieldName.begin(), fieldName.end(), fieldName.begin(), ::tolower);
-			m_FieldNameToFieldMap.insert(std::pair<std::string, HeaderField*>(fieldName, newField));
 		}
 		else
 		{
-			delete newField;
+			releaseField(newField);
 			break;
 		}
 	}
@@ -136,12 +166,7 @@ void TextBasedProtocolMessage::parseFields()
 
 TextBasedProtocolMessage::~TextBasedProtocolMessage()
 {
-	while (m_FieldList != NULL)
-	{
-		HeaderField* temp = m_FieldList;
-		m_FieldList = m_FieldList->getNextField();
-		delete temp;
-	}
+	releaseAllFields();
 }
 
 
@@ -200,7 +225,7 @@ HeaderField* TextBasedProtocolMessage::insertField(HeaderField* prevField, const
 		return NULL;
 	}
 
-	HeaderField* newFieldToAdd = new HeaderField(newField);
+	HeaderField* newFieldToAdd = new(allocateField()) HeaderField(newField);
 
 	int newFieldOffset = m_FieldsOffset;
 	if (prevField != NULL)
@@ -210,7 +235,7 @@ HeaderField* TextBasedProtocolMessage::insertField(HeaderField* prevField, const
 	if (!extendLayer(newFieldOffset, newFieldToAdd->getFieldSize()))
 	{
 		LOG_ERROR("Cannot extend layer to insert the header");
-		delete newFieldToAdd;
+		releaseField(newFieldToAdd);
 		return NULL;
 	}
 
@@ -226,6 +251,7 @@ HeaderField* TextBasedProtocolMessage::insertField(HeaderField* prevField, const
 
 	// attach new field to message
 	newFieldToAdd->attachToTextBasedProtocolMessage(this, newFieldOffset);
+	setFieldInsertionOrder(newFieldToAdd);
 
 	// insert field into fields link list
 	if (prevField == NULL)
@@ -243,33 +269,12 @@ HeaderField* TextBasedProtocolMessage::insertField(HeaderField* prevField, const
 	if (newFieldToAdd->getNextField() == NULL)
 		m_LastField = newFieldToAdd;
 
-	// insert the new field into name to field map
-	std::string fieldName = newFieldToAdd->getFieldName();
-	std::transform(fieldName.begin(), fieldName.end(), fieldName.begin(), ::tolower);
-	m_FieldNameToFieldMap.insert(std::pair<std::string, HeaderField*>(fieldName, newFieldToAdd));
-
 	return newFieldToAdd;
 }
 
 bool TextBasedProtocolMessage::removeField(std::string fieldName, int index)
 {
-	std::transform(fieldName.begin(), fieldName.end(), fieldName.begin(), ::tolower);
-
-	HeaderField* fieldToRemove = NULL;
-
-	std::pair <std::multimap<std::string,HeaderField*>::iterator, std::multimap<std::string,HeaderField*>::iterator> range;
-	range = m_FieldNameToFieldMap.equal_range(fieldName);
-	int i = 0;
-	for (std::multimap<std::string,HeaderField*>::iterator iter = range.first; iter != range.second; ++iter)
-	{
-		if (i == index)
-		{
-			fieldToRemove = iter->second;
-			break;
-		}
-
-		i++;
-	}
+	HeaderField* fieldToRemove = getFieldByName(fieldName, index);
 
 	if (fieldToRemove != NULL)
 		return removeField(fieldToRemove);
@@ -291,8 +296,6 @@ bool TextBasedProtocolMessage::removeField(HeaderField* fieldToRemove)
 		return false;
 	}
 
-	std::string fieldName = fieldToRemove->getFieldName();
-
 	// shorten layer and delete this field
 	if (!shortenLayer(fieldToRemove->m_NameOffsetInMessage, fieldToRemove->getFieldSize()))
 	{
@@ -338,21 +341,8 @@ bool TextBasedProtocolMessage::removeField(HeaderField* fieldToRemove)
 		}
 	}
 
-	// remove the hash entry for this field
-	std::transform(fieldName.begin(), fieldName.end(), fieldName.begin(), ::tolower);
-	std::pair <std::multimap<std::string,HeaderField*>::iterator, std::multimap<std::string,HeaderField*>::iterator> range;
-	range = m_FieldNameToFieldMap.equal_range(fieldName);
-	for (std::multimap<std::string,HeaderField*>::iterator iter = range.first; iter != range.second; ++iter)
-	{
-		if (iter->second == fieldToRemove)
-		{
-			m_FieldNameToFieldMap.erase(iter);
-			break;
-		}
-	}
-
 	// finally - delete this field
-	delete fieldToRemove;
+	releaseField(fieldToRemove);
 
 	return true;
 }
@@ -378,20 +368,30 @@ void TextBasedProtocolMessage::shiftFieldsOffset(HeaderField* fromField, int num
 
 HeaderField* TextBasedProtocolMessage::getFieldByName(std::string fieldName, int index) const
 {
-	std::transform(fieldName.begin(), fieldName.end(), fieldName.begin(), ::tolower);
-
-	std::pair <std::multimap<std::string,HeaderField*>::const_iterator, std::multimap<std::string,HeaderField*>::const_iterator> range;
-	range = m_FieldNameToFieldMap.equal_range(fieldName);
-	int i = 0;
-	for (std::multimap<std::string,HeaderField*>::const_iterator iter = range.first; iter != range.second; ++iter)
+	// fields are few, so walking the field list and comparing the pre-computed name hashes is cheaper than maintaining a lookup table.
+	// Fields with the same name are indexed by the order in which they were added to the message, for parsed fields that's the
+	// order in which they appear on the packet
+	uint32_t nameHash = HeaderField::calcNameHash(fieldName.c_str(), fieldName.length());
+	HeaderField* result = NULL;
+	for (int i = 0; i <= index; i++)
 	{
-		if (i == index)
-			return iter->second;
+		HeaderField* prevResult = result;
+		result = NULL;
+		for (HeaderField* curField = m_FieldList; curField != NULL; curField = curField->getNextField())
+		{
+			if ((prevResult != NULL && curField->m_InsertionOrder <= prevResult->m_InsertionOrder) ||
+					(result != NULL && curField->m_InsertionOrder >= result->m_InsertionOrder))
+				continue;
+
+			if (curField->isNameEqual(fieldName.c_str(), fieldName.length(), nameHash))
+				result = curField;
+		}
 
-		i++;
+		if (result == NULL)
+			return NULL;
 	}
 
-	return NULL;
+	return result;
 }
 
 int TextBasedProtocolMessage::getFieldCount() const
@@ -415,7 +415,7 @@ void TextBasedProtocolMessage::parseNextLayer()
 	if (m_DataLen <= headerLen)
 		return;
 
-	m_NextLayer = new PayloadLayer(m_Data + headerLen, m_DataLen - headerLen, this, m_Packet);
+	m_NextLayer = new(m_Packet) PayloadLayer(m_Data + headerLen, m_DataLen - headerLen, this, m_Packet);
 }
 
 size_t TextBasedProtocolMessage::getHeaderLen() const
@@ -450,6 +450,7 @@ HeaderField::HeaderField(TextBasedProtocolMessage* TextBasedProtocolMessage, int
 	if (m_FieldSize == 0 || (*fieldData) == '\r' || (*fieldData) == '\n')
 	{
 		m_FieldNameSize = -1;
+		m_NameHash = calcNameHash(NULL, 0);
 		m_ValueOffsetInMessage = -1;
 		m_FieldValueSize = -1;
 		m_FieldNameSize = -1;
@@ -459,18 +460,20 @@ HeaderField::HeaderField(TextBasedProtocolMessage* TextBasedProtocolMessage, int
 	else
 		m_IsEndOfHeaderField = false;
 
-//	char* fieldValuePtr = strchr(fieldData, ':');
-	char* fieldValuePtr = (char*)memchr(fieldData, nameValueSeperator, m_TextBasedProtocolMessage->m_DataLen-(size_t)m_NameOffsetInMessage);
+	// the separator is searched only within this field so a field without a separator doesn't swallow the fields after it
+	char* fieldValuePtr = (char*)memchr(fieldData, nameValueSeperator, m_FieldSize);
 	// could not find the position of the separator, meaning field value position is unknown
 	if (fieldValuePtr == NULL)
 	{
 		m_ValueOffsetInMessage = -1;
 		m_FieldValueSize = -1;
 		m_FieldNameSize = m_FieldSize;
+		m_NameHash = calcNameHash(fieldData, m_FieldNameSize);
 	}
 	else
 	{
 		m_FieldNameSize = fieldValuePtr - fieldData;
+		m_NameHash = calcNameHash(fieldData, m_FieldNameSize);
 		// Header field looks like this: <field_name>[separator]<zero or more spaces><field_Value>
 		// So fieldValuePtr give us the position of the separator. Value offset is the first non-space byte forward
 		fieldValuePtr++;
@@ -526,6 +529,7 @@ void HeaderField::initNewField(std::string name, std::string value)
 {
 	m_TextBasedProtocolMessage = NULL;
 	m_NameOffsetInMessage = 0;
+	m_InsertionOrder = 0;
 	m_NextField = NULL;
 
 	// first building the name-value separator
@@ -557,6 +561,7 @@ void HeaderField::initNewField(std::string name, std::string value)
 	else
 		m_ValueOffsetInMessage = 0;
 	m_FieldNameSize = name.length();
+	m_NameHash = calcNameHash(name.c_str(), name.length());
 	m_FieldValueSize = value.length();
 
 	if (name != PCPP_END_OF_TEXT_BASED_PROTOCOL_HEADER)
@@ -670,6 +675,37 @@ bool HeaderField::setFieldValue(std::string newValue)
 	return true;
 }
 
+uint32_t HeaderField::calcNameHash(const char* name, size_t nameLen)
+{
+	// FNV-1a over the name with the ASCII case bit set, so names which differ only in letter case get the same hash.
+	// This also folds a few non-letter characters together, which is fine since isNameEqual() compares the names anyway
+	uint32_t hash = TBP_NAME_HASH_OFFSET_BASIS;
+	for (size_t i = 0; i < nameLen; i++)
+	{
+		hash ^= (uint8_t)(name[i] | 0x20);
+		hash *= TBP_NAME_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+bool HeaderField::isNameEqual(const char* name, size_t nameLen, uint32_t nameHash) const
+{
+	// end-of-header fields have no name, they match an empty name
+	size_t fieldNameSize = (m_FieldNameSize == (size_t)-1 ? 0 : m_FieldNameSize);
+	if (m_NameHash != nameHash || fieldNameSize != nameLen)
+		return false;
+
+	const char* fieldName = getData() + m_NameOffsetInMessage;
+	for (size_t i = 0; i < nameLen; i++)
+	{
+		if (tolower((uint8_t)fieldName[i]) != tolower((uint8_t)name[i]))
+			return false;
+	}
+
+	return true;
+}
+
 void HeaderField::attachToTextBasedProtocolMessage(TextBasedProtocolMessage* message, int fieldOffsetInMessage)
 {
 	if (m_TextBasedProtocolMessage != NULL && m_TextBasedProtocolMessage != message)
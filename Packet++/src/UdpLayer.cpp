@@ -83,10 +83,10 @@ uint16_t UdpLayer::calculateChecksum(bool writeResultToPacket)
 	return checksumRes;
 }
 
-void UdpLayer::parseNextLayer()
+ProtocolType UdpLayer::getNextLayerProtocol() const
 {
 	if (m_DataLen <= sizeof(udphdr))
-		return;
+		return UnknownProtocol;
 
 	udphdr* udpHder = getUdpHeader();
 	uint16_t portDst = be16toh(udpHder->portDst);
@@ -96,27 +96,64 @@ void UdpLayer::parseNextLayer()
 	size_t udpDataLen = m_DataLen - sizeof(udphdr);
 
 	if ((portSrc == 68 && portDst == 67) || (portSrc == 67 && portDst == 68) || (portSrc == 67 && portDst == 67))
-		m_NextLayer = new DhcpLayer(udpData, udpDataLen, this, m_Packet);
+		return DHCP;
 	else if (VxlanLayer::isVxlanPort(portDst))
-		m_NextLayer = new VxlanLayer(udpData, udpDataLen, this, m_Packet);
+		return VXLAN;
 	else if ((udpDataLen >= sizeof(dnshdr)) && (DnsLayer::isDnsPort(portDst) || DnsLayer::isDnsPort(portSrc)))
-		m_NextLayer = new DnsLayer(udpData, udpDataLen, this, m_Packet);
+		return DNS;
 	else if(SipLayer::isSipPort(portDst) || SipLayer::isSipPort(portSrc))
 	{
 		if (SipRequestFirstLine::parseMethod((char*)udpData, udpDataLen) != SipRequestLayer::SipMethodUnknown)
-			m_NextLayer = new SipRequestLayer(udpData, udpDataLen, this, m_Packet);
+			return SIPRequest;
 		else if (SipResponseFirstLine::parseStatusCode((char*)udpData, udpDataLen) != SipResponseLayer::SipStatusCodeUnknown
 						&& SipResponseFirstLine::parseVersion((char*)udpData, udpDataLen) != "")
-			m_NextLayer = new SipResponseLayer(udpData, udpDataLen, this, m_Packet);
+			return SIPResponse;
 		else
-			m_NextLayer = new PayloadLayer(udpData, udpDataLen, this, m_Packet);
+			return GenericPayload;
 	}
 	else if ((RadiusLayer::isRadiusPort(portDst) || RadiusLayer::isRadiusPort(portSrc)) && RadiusLayer::isDataValid(udpData, udpDataLen))
-		m_NextLayer = new RadiusLayer(udpData, udpDataLen, this, m_Packet);
+		return Radius;
 	else if ((GtpV1Layer::isGTPv1Port(portDst) || GtpV1Layer::isGTPv1Port(portSrc)) && GtpV1Layer::isGTPv1(udpData, udpDataLen))
-		m_NextLayer = new GtpV1Layer(udpData, udpDataLen, this, m_Packet);
+		return GTP;
 	else
-		m_NextLayer = new PayloadLayer(udpData, udpDataLen, this, m_Packet);
+		return GenericPayload;
+}
+
+void UdpLayer::parseNextLayer()
+{
+	ProtocolType nextProtocol = getNextLayerProtocol();
+	if (nextProtocol == UnknownProtocol)
+		return;
+
+	uint8_t* udpData = m_Data + sizeof(udphdr);
+	size_t udpDataLen = m_DataLen - sizeof(udphdr);
+
+	switch (nextProtocol)
+	{
+	case DHCP:
+		m_NextLayer = new(m_Packet) DhcpLayer(udpData, udpDataLen, this, m_Packet);
+		break;
+	case VXLAN:
+		m_NextLayer = new(m_Packet) VxlanLayer(udpData, udpDataLen, this, m_Packet);
+		break;
+	case DNS:
+		m_NextLayer = new(m_Packet) DnsLayer(udpData, udpDataLen, this, m_Packet);
+		break;
+	case SIPRequest:
+		m_NextLayer = new(m_Packet) SipRequestLayer(udpData, udpDataLen, this, m_Packet);
+		break;
+	case SIPResponse:
+		m_NextLayer = new(m_Packet) SipResponseLayer(udpData, udpDataLen, this, m_Packet);
+		break;
+	case Radius:
+		m_NextLayer = new(m_Packet) RadiusLayer(udpData, udpDataLen, this, m_Packet);
+		break;
+	case GTP:
+		m_NextLayer = new(m_Packet) GtpV1Layer(udpData, udpDataLen, this, m_Packet);
+		break;
+	default:
+		m_NextLayer = new(m_Packet) PayloadLayer(udpData, udpDataLen, this, m_Packet);
+	}
 }
 
 void UdpLayer::computeCalculateFields()
@@ -0,0 +1,279 @@
+#ifndef PCAPPP_AF_PACKET_DEVICE
+#define PCAPPP_AF_PACKET_DEVICE
+
+#include "Device.h"
+#include "SystemUtils.h"
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+/// @file
+
+/**
+ * The default size in bytes of each block in the ring. Must be a multiple of the page size
+ */
+#define PCPP_AF_PACKET_DEFAULT_BLOCK_SIZE (1 << 18)
+
+/**
+ * The default number of blocks in each ring
+ */
+#define PCPP_AF_PACKET_DEFAULT_NUM_OF_BLOCKS 64
+
+/**
+ * The default time in milliseconds after which the kernel hands a block that isn't full to user space
+ */
+#define PCPP_AF_PACKET_DEFAULT_BLOCK_TIMEOUT 10
+
+/**
+ * The maximum number of rings (and capture threads) a device can open
+ */
+#define PCPP_AF_PACKET_MAX_NUM_OF_RINGS 64
+
+/**
+* \namespace pcpp
+* \brief The main namespace for the PcapPlusPlus lib
+*/
+namespace pcpp
+{
+
+	class AfPacketDevice;
+
+	/**
+	 * A callback invoked for every block of packets received on a ring
+	 * @param[in] packets An array of the packets in the block. The packets point directly into the ring memory (zero-copy) and are valid
+	 * only until the callback returns, after which the block is returned to the kernel
+	 * @param[in] numOfPackets The number of packets in the array
+	 * @param[in] ringId The index of the ring the block was received on
+	 * @param[in] device The device the packets were received on
+	 * @param[in] userCookie The pointer set by the user when capture started
+	 */
+	typedef void (*OnAfPacketPacketsArriveCallback)(RawPacket* packets, uint32_t numOfPackets, uint8_t ringId, AfPacketDevice* device, void* userCookie);
+
+	/**
+	 * @class AfPacketDevice
+	 * A Linux capture device that receives packets from a network interface through AF_PACKET sockets with a TPACKET_V3 memory-mapped ring.
+	 * The kernel writes packets into blocks of the ring which is shared with user space, and hands a block to user space when it's full or
+	 * when a timeout expires. Each block is delivered to the user callback as a batch of RawPacket objects pointing directly into the ring,
+	 * so no system call or copy is needed per packet.<BR>
+	 * The device can open several rings, each with its own socket, that join a PACKET_FANOUT group so the kernel spreads the packets of the
+	 * interface between them (for example by flow hash). Capture then runs one thread per ring, optionally pinned to a core, which makes it
+	 * possible to process packets on several cores without any locking between the threads.<BR>
+	 * Opening the device requires the CAP_NET_RAW capability (usually root). This device is supported on Linux only
+	 */
+	class AfPacketDevice : public IDevice, public IFilterableDevice
+	{
+	public:
+		/**
+		 * The way the kernel distributes packets between the rings when more than one ring is opened
+		 */
+		enum FanoutMode
+		{
+			/** By a hash of the packet flow, so all packets of a flow go to the same ring */
+			FanoutHash,
+			/** Round-robin */
+			FanoutLoadBalance,
+			/** By the CPU the packet arrived on */
+			FanoutCpu,
+			/** By the receive queue of the NIC the packet arrived on */
+			FanoutQueueMapping
+		};
+
+		/**
+		 * @struct AfPacketConfig
+		 * The configuration of the rings of an AfPacketDevice
+		 */
+		struct AfPacketConfig
+		{
+			/** The size in bytes of each block in the ring. Must be a multiple of the page size and large enough for the largest packet */
+			uint32_t blockSize;
+			/** The number of blocks in each ring */
+			uint32_t numOfBlocks;
+			/** The time in milliseconds after which the kernel hands a block that isn't full to user space */
+			uint32_t blockTimeout;
+			/** The number of rings (and capture threads) to open, between 1 and PCPP_AF_PACKET_MAX_NUM_OF_RINGS */
+			uint8_t numOfRings;
+			/** The way packets are distributed between rings. Relevant only if numOfRings is larger than 1 */
+			FanoutMode fanoutMode;
+			/**
+			 * The fanout group ID. Rings of all devices (also in other processes) with the same group ID on the same interface share the
+			 * interface packets. A value of 0 means a group ID is chosen by the process ID, so the rings of each device share packets
+			 * only between themselves
+			 */
+			uint16_t fanoutGroupId;
+			/** Whether to put the interface in promiscuous mode */
+			bool promiscuous;
+
+			/**
+			 * A c'tor for this struct that sets the default values
+			 */
+			AfPacketConfig();
+		};
+
+		/**
+		 * @struct AfPacketStats
+		 * Statistics of a ring, or of all rings of a device
+		 */
+		struct AfPacketStats
+		{
+			/** The number of packets the kernel received on the socket, including packets dropped because the ring was full */
+			uint64_t packetsReceived;
+			/** The number of packets dropped because the ring was full */
+			uint64_t packetsDropped;
+			/** The number of times the ring was full and the kernel had to freeze the queue */
+			uint64_t freezeQueueCount;
+			/** The number of packets delivered to the user callback */
+			uint64_t packetsDelivered;
+			/** The number of bytes of the packets delivered to the user callback */
+			uint64_t bytesDelivered;
+			/** The number of blocks delivered to the user callback */
+			uint64_t blocksDelivered;
+		};
+
+		/**
+		 * A c'tor for this class. The device isn't opened until open() is called
+		 * @param[in] interfaceName The name of the network interface to capture from, for example "eth0" or "lo"
+		 * @param[in] config The ring configuration. If not set the default configuration is used
+		 */
+		AfPacketDevice(const std::string& interfaceName, const AfPacketConfig& config = AfPacketConfig());
+
+		/**
+		 * A d'tor for this class. Stops the capture and closes the device if it's still open
+		 */
+		~AfPacketDevice();
+
+		/**
+		 * @return The name of the network interface
+		 */
+		const std::string& getInterfaceName() const { return m_InterfaceName; }
+
+		/**
+		 * @return The ring configuration
+		 */
+		const AfPacketConfig& getConfig() const { return m_Config; }
+
+		/**
+		 * @return The number of opened rings, or 0 if the device isn't opened
+		 */
+		uint8_t getNumOfRings() const { return (uint8_t)m_Rings.size(); }
+
+		/**
+		 * @return The link layer type of the received packets. Valid only after the device is opened
+		 */
+		LinkLayerType getLinkLayerType() const { return m_LinkType; }
+
+		/**
+		 * Start capturing packets with one thread per ring. The callback is invoked from the capture threads, concurrently for
+		 * different rings
+		 * @param[in] onPacketsArrive The callback to invoke for every block of packets
+		 * @param[in] onPacketsArriveUserCookie A pointer passed to the callback
+		 * @param[in] coreSet If not empty, the thread of ring i is pinned to the i-th core in the set (wrapping around if there are more rings
+		 * than cores). A CoreMask can be passed too. The default is an empty set, meaning threads aren't pinned
+		 * @return True if capture started successfully, false if the device isn't opened, capture is already running or a thread couldn't
+		 * be created
+		 */
+		bool startCapture(OnAfPacketPacketsArriveCallback onPacketsArrive, void* onPacketsArriveUserCookie, const CoreSet& coreSet = CoreSet());
+
+		/**
+		 * Stop capturing packets and wait for the capture threads to finish
+		 */
+		void stopCapture();
+
+		/**
+		 * @return True if the capture threads are running, false otherwise
+		 */
+		bool captureActive() const { return !m_CaptureThreads.empty(); }
+
+		/**
+		 * Receive packets from a ring in the calling thread, for applications that run their own threads. Delivers at most one block
+		 * to the callback. Must not be called for a ring while capture threads are running
+		 * @param[in] ringId The ring to receive from
+		 * @param[in] onPacketsArrive The callback to invoke if a block is available. Must not be NULL
+		 * @param[in] userCookie A pointer passed to the callback
+		 * @param[in] timeout The time in milliseconds to wait for a block. 0 means not waiting, a negative value means waiting forever
+		 * @return The number of packets delivered, 0 if no block was available before the timeout expired or -1 on error
+		 */
+		int receivePackets(uint8_t ringId, OnAfPacketPacketsArriveCallback onPacketsArrive, void* userCookie, int timeout);
+
+		/**
+		 * Get the statistics of a single ring. The kernel counters are accumulated since the device was opened. Can be called from any
+		 * thread while capturing
+		 * @param[in] ringId The ring index
+		 * @param[out] stats The ring statistics
+		 */
+		void getRingStatistics(uint8_t ringId, AfPacketStats& stats);
+
+		/**
+		 * Get the statistics of all rings summed together. Can be called from any thread while capturing
+		 * @param[out] stats The device statistics
+		 */
+		void getStatistics(AfPacketStats& stats);
+
+		// implement abstract methods
+
+		/**
+		 * Open the rings and bind them to the interface
+		 * @return True if the device was opened successfully, false otherwise (an error log will be printed)
+		 */
+		bool open();
+
+		/**
+		 * Stop the capture if it's running and close the rings
+		 */
+		void close();
+
+		using IFilterableDevice::setFilter;
+
+		/**
+		 * Set a BPF filter on all rings. The filter runs in the kernel, so packets that don't match it aren't written to the rings
+		 * @param[in] filterAsString The filter in Berkeley Packet Filter (BPF) syntax (http://biot.com/capstats/bpf.html)
+		 * @return True if the filter was set on all rings, false otherwise
+		 */
+		bool setFilter(std::string filterAsString);
+
+		/**
+		 * Remove the filter from all rings
+		 * @return True if the filter was removed successfully or if no filter was set, false otherwise
+		 */
+		bool clearFilter();
+
+	private:
+		struct Ring
+		{
+			int fd;
+			uint8_t* memory;
+			size_t memorySize;
+			uint32_t currentBlock;
+			RawPacket* packets;
+			uint32_t maxPacketsPerBlock;
+			AfPacketStats stats;
+		};
+
+		struct CaptureThreadContext
+		{
+			AfPacketDevice* device;
+			uint8_t ringId;
+		};
+
+		std::string m_InterfaceName;
+		AfPacketConfig m_Config;
+		LinkLayerType m_LinkType;
+		std::vector<Ring> m_Rings;
+		std::vector<pthread_t> m_CaptureThreads;
+		std::vector<CaptureThreadContext> m_CaptureThreadContexts;
+		volatile bool m_StopThreads;
+		OnAfPacketPacketsArriveCallback m_OnPacketsArrive;
+		void* m_OnPacketsArriveUserCookie;
+
+		// private copy c'tor and assignment operator
+		AfPacketDevice(const AfPacketDevice& other);
+		AfPacketDevice& operator=(const AfPacketDevice& other);
+
+		bool openRing(Ring& ring, int interfaceIndex, uint16_t fanoutGroupId);
+		void closeRing(Ring& ring);
+		void updateKernelStatistics(Ring& ring);
+		static void* captureThreadMain(void* context);
+	};
+
+} // namespace pcpp
+
+#endif // PCAPPP_AF_PACKET_DEVICE
@@ -0,0 +1,165 @@
+#ifndef PCAPPP_COMPILED_FILTER
+#define PCAPPP_COMPILED_FILTER
+
+#include "PcapFilter.h"
+#include "NativeFilterProgram.h"
+#include "RawPacket.h"
+#include <string>
+
+/// @file
+
+/**
+* \namespace pcpp
+* \brief The main namespace for the PcapPlusPlus lib
+*/
+namespace pcpp
+{
+
+	/**
+	 * @class CompiledFilter
+	 * A filter which is compiled once when constructed and can't be changed afterwards. Matching packets with it doesn't modify it, so a
+	 * single instance can be shared by several threads without locking, for example by the capture threads of PfRingDevice, AfPacketDevice
+	 * or DpdkDevice, by worker threads that receive packet bursts with DpdkDevice#receivePackets(), or by threads that read files. The batch
+	 * match() methods match a whole burst in one call, whether it's a contiguous array of packets (like the arrays passed to the
+	 * packets-arrive callbacks of these devices) or an array of pointers to packets (like the arrays filled by
+	 * DpdkDevice#receivePackets()).<BR>
+	 * A CompiledFilter can be built from a BPF string or from a filter tree (see PcapFilter.h). Filter trees that can be matched natively
+	 * (see NativeFilterProgram) are compiled into a native program when the link type is Ethernet, all other filters are compiled into a
+	 * BPF program. The filter tree is copied into the compiled program, so modifying or destroying it later doesn't affect the
+	 * CompiledFilter.<BR>
+	 * Compiling a BPF string isn't thread-safe in all libpcap versions, so constructors compile it with compileBpfFilter(), which serializes
+	 * it with all other BPF compilation in PcapPlusPlus. As in libpcap, an empty BPF string matches all packets
+	 */
+	class CompiledFilter
+	{
+	private:
+		NativeFilterProgram m_NativeProgram;
+		bpf_program* m_BpfProgram;
+		std::string m_FilterAsString;
+		LinkLayerType m_LinkType;
+		bool m_IsValid;
+
+		void compileBpf(int snapshotLength);
+
+		// private copy c'tor and assignment operator, a CompiledFilter is shared by reference or pointer
+		CompiledFilter(const CompiledFilter& other);
+		CompiledFilter& operator=(const CompiledFilter& other);
+
+	public:
+		/**
+		 * A c'tor that compiles a BPF string
+		 * @param[in] filterAsString The filter in Berkeley Packet Filter (BPF) syntax (http://biot.com/capstats/bpf.html)
+		 * @param[in] linkType The link type of the packets the filter will be matched with. The default is Ethernet
+		 * @param[in] snapshotLength The snapshot length used for compiling the BPF program. The default is 9000
+		 */
+		CompiledFilter(const std::string& filterAsString, LinkLayerType linkType = LINKTYPE_ETHERNET, int snapshotLength = 9000);
+
+		/**
+		 * A c'tor that compiles a filter tree
+		 * @param[in] filter The root of the filter tree
+		 * @param[in] linkType The link type of the packets the filter will be matched with. The default is Ethernet
+		 * @param[in] snapshotLength The snapshot length used if the filter is compiled into a BPF program. The default is 9000
+		 */
+		CompiledFilter(GeneralFilter& filter, LinkLayerType linkType = LINKTYPE_ETHERNET, int snapshotLength = 9000);
+
+		/**
+		 * A d'tor for this class, frees the compiled program
+		 */
+		~CompiledFilter();
+
+		/**
+		 * @return True if the filter was compiled successfully, false otherwise. An invalid filter doesn't match any packet
+		 */
+		bool isValid() const { return m_IsValid; }
+
+		/**
+		 * @return True if the filter is matched natively, false if it's matched with a BPF program
+		 */
+		bool isNative() const { return m_NativeProgram.isCompiled(); }
+
+		/**
+		 * @return The BPF string of the filter
+		 */
+		const std::string& getFilterAsString() const { return m_FilterAsString; }
+
+		/**
+		 * @return The link type the filter was compiled for
+		 */
+		LinkLayerType getLinkLayerType() const { return m_LinkType; }
+
+		/**
+		 * Match packet data with the filter
+		 * @param[in] data A pointer to the packet data, starting with the link layer header of the type the filter was compiled for
+		 * @param[in] capturedLen The number of bytes in data
+		 * @param[in] frameLen The length of the packet on the wire, which may be larger than the captured length
+		 * @return True if the packet matches the filter, false otherwise or if the filter isn't valid
+		 */
+		bool match(const uint8_t* data, size_t capturedLen, size_t frameLen) const;
+
+		/**
+		 * Match a raw packet with the filter
+		 * @param[in] rawPacket A pointer to the raw packet
+		 * @return True if the packet matches the filter, false otherwise or if the filter isn't valid
+		 */
+		bool match(const RawPacket* rawPacket) const;
+
+		/**
+		 * Match a contiguous array of raw packets with the filter, such as the arrays PfRingDevice, AfPacketDevice and DpdkDevice pass to
+		 * their packets-arrive callbacks. The array is indexed by its element type, so it can be an array of RawPacket or of a class derived
+		 * from it, like MBufRawPacket
+		 * @param[in] packets An array of raw packets
+		 * @param[in] numOfPackets The number of packets in the array
+		 * @param[out] results An array of at least numOfPackets elements, where results[i] is set to true if packets[i] matches the filter
+		 * or to false otherwise
+		 * @return The number of packets that matched the filter
+		 */
+		template<class TRawPacket>
+		size_t match(const TRawPacket* packets, size_t numOfPackets, bool* results) const;
+
+		/**
+		 * Match an array of pointers to raw packets with the filter, such as the MBufRawPacket arrays filled by
+		 * DpdkDevice#receivePackets(), or the RawPacket pointers of a RawPacketVector
+		 * @param[in] rawPackets An array of pointers to raw packets of RawPacket or of a class derived from it. NULL pointers don't match
+		 * @param[in] numOfPackets The number of packets in the array
+		 * @param[out] results An array of at least numOfPackets elements, where results[i] is set to true if rawPackets[i] matches the filter
+		 * or to false otherwise
+		 * @return The number of packets that matched the filter
+		 */
+		template<class TRawPacket>
+		size_t match(TRawPacket* const* rawPackets, size_t numOfPackets, bool* results) const;
+	};
+
+
+	// implementation of template methods
+
+	template<class TRawPacket>
+	size_t CompiledFilter::match(const TRawPacket* packets, size_t numOfPackets, bool* results) const
+	{
+		size_t numOfMatches = 0;
+		for (size_t i = 0; i < numOfPackets; i++)
+		{
+			results[i] = match(static_cast<const RawPacket*>(&packets[i]));
+			if (results[i])
+				numOfMatches++;
+		}
+
+		return numOfMatches;
+	}
+
+	template<class TRawPacket>
+	size_t CompiledFilter::match(TRawPacket* const* rawPackets, size_t numOfPackets, bool* results) const
+	{
+		size_t numOfMatches = 0;
+		for (size_t i = 0; i < numOfPackets; i++)
+		{
+			results[i] = match(static_cast<const RawPacket*>(rawPackets[i]));
+			if (results[i])
+				numOfMatches++;
+		}
+
+		return numOfMatches;
+	}
+
+} // namespace pcpp
+
+#endif // PCAPPP_COMPILED_FILTER
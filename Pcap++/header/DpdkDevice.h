@@ -388,6 +388,12 @@ namespace pcpp
 		 */
 		std::string getPciAddress() const { return m_PciAddress; }
 
+		/**
+		 * @return The NUMA node the device is attached to, or -1 if it's unknown. Capture and worker threads perform best on cores of
+		 * this node, which can be retrieved with getCoreSetForNumaNode()
+		 */
+		int getNumaNode() const;
+
 		/**
 		 * @return The device's maximum transmission unit (MTU) in bytes
 		 */
@@ -644,20 +650,20 @@ namespace pcpp
 
 		/**
 		 * This method does exactly what startCaptureSingleThread() does, but with more than one RX queue / capturing thread. It's called
-		 * with a core mask as a parameter and creates a packet capture thread on every core. Each capturing thread is assigned with a specific
-		 * RX queue. This method assumes all cores in the core-mask are available and there are enough opened RX queues to match for each thread.
+		 * with a core set as a parameter and creates a packet capture thread on every core. Each capturing thread is assigned with a specific
+		 * RX queue. This method assumes all cores in the core set are available and there are enough opened RX queues to match for each thread.
 		 * If these assumptions are not true an error is returned. After invoking all threads, all of them run in an endless loop
 		 * and try to capture packets from their designated RX queues. Each time a burst of packets is captured the callback is invoked with the user
 		 * cookie and the thread ID that captured the packets
 		 * @param[in] onPacketsArrive The user callback which will be invoked each time a burst of packets is captured by the device
 		 * @param[in] onPacketsArriveUserCookie The user callback is invoked with this cookie as a parameter. It can be used to pass
 		 * information from the user application to the callback
-		 * @param coreMask The core-mask for creating the cpature threads
-		 * @return True if all capture threads started successfully or false if device is already in capture mode, not all cores in the core-mask are
-		 * available to DPDK, there are not enough opened RX queues to match all cores in the core-mask, or if thread invocation failed. In
+		 * @param coreSet The cores for creating the capture threads. A CoreMask can be passed too, but it can only represent cores 0-31
+		 * @return True if all capture threads started successfully or false if device is already in capture mode, not all cores in the core set are
+		 * available to DPDK, there are not enough opened RX queues to match all cores in the core set, or if thread invocation failed. In
 		 * all of these cases an appropriate error message will be printed
 		 */
-		bool startCaptureMultiThreads(OnDpdkPacketsArriveCallback onPacketsArrive, void* onPacketsArriveUserCookie, CoreMask coreMask);
+		bool startCaptureMultiThreads(OnDpdkPacketsArriveCallback onPacketsArrive, void* onPacketsArriveUserCookie, const CoreSet& coreSet);
 
 		/**
 		 * If device is in capture mode started by invoking startCaptureSingleThread() or startCaptureMultiThreads(), this method
@@ -759,7 +765,7 @@ namespace pcpp
 		static int dpdkCaptureThreadMain(void* ptr);
 
 		void clearCoreConfiguration();
-		bool initCoreConfigurationByCoreMask(CoreMask coreMask);
+		bool initCoreConfigurationByCoreSet(const CoreSet& coreSet);
 		int getCoresInUseCount() const;
 
 		void setDeviceInfo();
@@ -784,7 +790,7 @@ namespace pcpp
 		struct rte_eth_dev_tx_buffer** m_TxBuffers;
 		uint64_t m_TxBufferDrainTsc;
 		uint64_t* m_TxBufferLastDrainTsc;
-		DpdkCoreConfiguration m_CoreConfiguration[MAX_NUM_OF_CORES];
+		DpdkCoreConfiguration m_CoreConfiguration[MAX_NUM_OF_CORES_IN_CORE_SET];
 		uint16_t m_TotalAvailableRxQueues;
 		uint16_t m_TotalAvailableTxQueues;
 		uint16_t m_NumOfRxQueuesOpened;
@@ -75,7 +75,7 @@ namespace pcpp
 		bool m_IsInitialized;
 		static bool m_IsDpdkInitialized;
 		static uint32_t m_MBufPoolSizePerDevice;
-		static CoreMask m_CoreMask;
+		static CoreSet m_CoreSet;
 		std::vector<DpdkDevice*> m_DpdkDeviceList;
 		std::vector<DpdkWorkerThread*> m_WorkerThreads;
 
@@ -111,20 +111,20 @@ namespace pcpp
 		 *    - initializes the DPDK infrastructure
 		 *    - creates DpdkDevice instances for all ports available for DPDK
 		 * 
-		 * @param[in] coreMask The cores to initialize DPDK with. After initialization, DPDK will only be able to use these cores
-		 * for its work. The core mask should have a bit set for every core to use. For example: if the user want to use cores 1,2
-		 * the core mask should be 6 (binary: 110)
+		 * @param[in] coreSet The cores to initialize DPDK with. After initialization, DPDK will only be able to use these cores
+		 * for its work. A CoreMask can be passed too, in which case it should have a bit set for every core to use. For example: if the
+		 * user want to use cores 1,2 the core mask should be 6 (binary: 110). Cores above 31 can only be set with a CoreSet
 		 * @param[in] mBufPoolSizePerDevice The mbuf pool size each DpdkDevice will have. This has to be a number which is a power of 2
 		 * minus 1, for example: 1023 (= 2^10-1) or 4,294,967,295 (= 2^32-1), etc. This is a DPDK limitation, not PcapPlusPlus.
 		 * The size of the mbuf pool size dictates how many packets can be handled by the application at the same time. For example: if
 		 * pool size is 1023 it means that no more than 1023 packets can be handled or stored in application memory at every point in time
 		 * @param[in] masterCore The core DPDK will use as master to control all worker thread. The default, unless set otherwise, is 0
-		 * @return True if initialization succeeded or false if huge-pages or DPDK kernel driver are not loaded, if mBufPoolSizePerDevice
+		 * @return True if initialization succeeded or false if the core set is empty, huge-pages or DPDK kernel driver are not loaded, if mBufPoolSizePerDevice
 		 * isn't power of 2 minus 1, if DPDK infra initialization failed or if DpdkDevice initialization failed. Anyway, if this method
 		 * returned false it's impossible to use DPDK with PcapPlusPlus. You can get some more details about mbufs and pools in 
 		 * DpdkDevice.h file description or in DPDK web site
 		 */
-		static bool initDpdk(CoreMask coreMask, uint32_t mBufPoolSizePerDevice, uint8_t masterCore = 0);
+		static bool initDpdk(const CoreSet& coreSet, uint32_t mBufPoolSizePerDevice, uint8_t masterCore = 0);
 
 		/**
 		 * Get a DpdkDevice by port ID
@@ -173,21 +173,21 @@ namespace pcpp
 		 * There are two ways to capture packets using DpdkDevice: one of them is using worker threads and the other way is setting
 		 * a callback which is invoked each time a burst of packets is captured (see DpdkDevice#startCaptureSingleThread() ). This
 		 * method implements the first way. See a detailed description of workers in DpdkWorkerThread class description. This method
-		 * gets a vector of workers (classes that implement the DpdkWorkerThread interface) and a core mask and starts a worker thread 
+		 * gets a vector of workers (classes that implement the DpdkWorkerThread interface) and a core set and starts a worker thread 
 		 * on each core (meaning - call the worker's DpdkWorkerThread#run() method). Workers usually run in an endless loop and will 
 		 * be ordered to stop by calling stopDpdkWorkerThreads().<BR>
-		 * Note that number of cores in the core mask must be equal to the number of workers. In addition it's impossible to run a
-		 * worker thread on DPDK master core, so the core mask shouldn't include the master core (you can find the master core by
-		 * calling getDpdkMasterCore() ).
-		 * @param[in] coreMask The bitmask of cores to run worker threads on. This list shouldn't include DPDK master core
+		 * Note that number of cores in the core set must be equal to the number of workers. Workers are assigned to cores in ascending
+		 * core ID order. In addition it's impossible to run a worker thread on DPDK master core, so the core set shouldn't include the
+		 * master core (you can find the master core by calling getDpdkMasterCore() ).
+		 * @param[in] coreSet The cores to run worker threads on. A CoreMask can be passed too. This list shouldn't include DPDK master core
 		 * @param[in] workerThreadsVec A vector of worker instances to run (classes who implement the DpdkWorkerThread interface). 
-		 * Number of workers in this vector must be equal to the number of cores in the core mask. Notice that the instances of 
+		 * Number of workers in this vector must be equal to the number of cores in the core set. Notice that the instances of 
 		 * DpdkWorkerThread shouldn't be freed until calling stopDpdkWorkerThreads() as these instances are running
 		 * @return True if all worker threads started successfully or false if: DPDK isn't initialized (initDpdk() wasn't called or
-		 * returned false), number of cores differs from number of workers, core mask includes DPDK master core or if one of the 
+		 * returned false), number of cores differs from number of workers, core set includes DPDK master core or if one of the 
 		 * worker threads couldn't be run
 		 */
-		bool startDpdkWorkerThreads(CoreMask coreMask, std::vector<DpdkWorkerThread*>& workerThreadsVec);
+		bool startDpdkWorkerThreads(const CoreSet& coreSet, std::vector<DpdkWorkerThread*>& workerThreadsVec);
 
 		/**
 		 * Assuming worker threads are running, this method orders them to stop by calling DpdkWorkerThread#stop(). Then it waits until
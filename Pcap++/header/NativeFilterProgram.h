@@ -0,0 +1,211 @@
+#ifndef PCAPPP_NATIVE_FILTER_PROGRAM
+#define PCAPPP_NATIVE_FILTER_PROGRAM
+
+#include "PcapFilter.h"
+#include <stdint.h>
+#include <vector>
+
+/// @file
+
+/**
+* \namespace pcpp
+* \brief The main namespace for the PcapPlusPlus lib
+*/
+namespace pcpp
+{
+
+	/**
+	 * @class NativeFilterProgram
+	 * A filter tree (see PcapFilter.h) compiled into a flat array of nodes that is evaluated directly on the packet raw data, without building
+	 * a BPF string and without running libpcap's BPF interpreter. Each node is either a logical operation (and, or, not) followed by its
+	 * operands, or a check of one packet field at a fixed location, just like the code libpcap generates for the same filter. The result of
+	 * matching a packet is identical to matching it with the BPF string of the filter on Ethernet link type, including the case where a
+	 * field lies beyond the end of the packet, which fails the whole filter<BR>
+	 * The program remembers the version of every filter it was compiled from, and isUpToDate() tells whether any of them was modified since.
+	 * Filters that can't be expressed natively (such as VlanFilter and BPFStringFilter) make compile() fail, in which case the caller
+	 * should fall back to BPF. GeneralFilter#matchPacketWithFilter() does all of this automatically
+	 */
+	class NativeFilterProgram
+	{
+	public:
+		/**
+		 * The type of a node in the program
+		 */
+		enum NodeType
+		{
+			/** Matches if all operands match */
+			NodeAnd,
+			/** Matches if at least one operand matches */
+			NodeOr,
+			/** Matches if its single operand doesn't match */
+			NodeNot,
+			/** Matches a specific EtherType */
+			NodeEtherType,
+			/** Matches a source and/or destination MAC address */
+			NodeMacAddress,
+			/** Compares a field of the network layer (after the Ethernet header) of a certain EtherType */
+			NodeNetworkField,
+			/** Matches an IPv4 protocol, and optionally an IPv6 next header including one following a fragment header */
+			NodeIPProtocol,
+			/** Matches a source and/or destination TCP, UDP or SCTP port range over IPv4 or IPv6 */
+			NodePortRange,
+			/** Compares a field of a TCP or UDP header over non-fragmented IPv4 */
+			NodeTransportField
+		};
+
+	private:
+		struct Node
+		{
+			NodeType type;
+			// the index of the node following this node and all of its operands
+			uint32_t end;
+			uint16_t etherType;
+			uint16_t offset;
+			uint8_t fieldSize;
+			uint8_t protocol;
+			bool includeIPv6;
+			FilterOperator op;
+			Direction dir;
+			uint32_t mask;
+			uint32_t value;
+			uint32_t value2;
+			uint8_t macAddress[6];
+		};
+
+		struct Dependency
+		{
+			const GeneralFilter* filter;
+			uint32_t version;
+		};
+
+		std::vector<Node> m_Nodes;
+		std::vector<Dependency> m_Dependencies;
+		std::vector<size_t> m_OpenOperations;
+		bool m_IsCompiled;
+
+		Node& addNode(NodeType type);
+		int evaluate(size_t& nodeIndex, const uint8_t* data, size_t dataLen) const;
+		int evaluateField(const Node& node, const uint8_t* data, size_t dataLen) const;
+
+	public:
+		/**
+		 * A c'tor for this class that creates an empty program
+		 */
+		NativeFilterProgram();
+
+		/**
+		 * Clear the program and compile a filter tree into it
+		 * @param[in] filter The root of the filter tree
+		 * @return True if the whole tree was compiled, false if some filter in it can't be compiled natively. In this case the program
+		 * can't be used for matching, but isUpToDate() still tells if the tree was modified since, so the caller knows when to try again
+		 */
+		bool compile(GeneralFilter& filter);
+
+		/**
+		 * Clear the program
+		 */
+		void clear();
+
+		/**
+		 * @return True if the last call to compile() succeeded, meaning the program can be used for matching packets
+		 */
+		bool isCompiled() const { return m_IsCompiled; }
+
+		/**
+		 * @return True if compile() was called and none of the filters the program was compiled from was modified since, false otherwise
+		 */
+		bool isUpToDate() const;
+
+		/**
+		 * Match packet data with the program. The data is assumed to start with an Ethernet header
+		 * @param[in] data A pointer to the packet data
+		 * @param[in] dataLen The packet data length in bytes
+		 * @return True if the program is compiled and the packet matches it, false otherwise
+		 */
+		bool matchPacket(const uint8_t* data, size_t dataLen) const;
+
+		/**
+		 * Match a raw packet with the program
+		 * @param[in] rawPacket A pointer to the raw packet
+		 * @return True if the program is compiled and the packet matches it, false otherwise
+		 */
+		bool matchPacket(RawPacket* rawPacket) const;
+
+		// The following methods are used by filters to compile themselves into the program (see GeneralFilter#compileNativeNodes())
+
+		/**
+		 * Register a filter the program depends on, so modifying it makes isUpToDate() return false. It's called by
+		 * GeneralFilter#compileToNative() for every filter in the tree
+		 * @param[in] filter The filter
+		 * @param[in] version The current version of the filter
+		 */
+		void addDependency(const GeneralFilter* filter, uint32_t version);
+
+		/**
+		 * Start a logical operation. The nodes added until the matching endOperation() call are its operands
+		 * @param[in] type The operation type: NodeAnd, NodeOr or NodeNot
+		 */
+		void beginOperation(NodeType type);
+
+		/**
+		 * End the logical operation started by the last beginOperation() call
+		 * @return False if there is no open operation, if it has no operands or if it's a NodeNot with more than one operand
+		 */
+		bool endOperation();
+
+		/**
+		 * Add a node that matches packets with a certain EtherType. Equivalent to "ether proto <etherType>" for EtherType values larger
+		 * than 1500 which aren't AppleTalk related
+		 * @param[in] etherType The EtherType value
+		 */
+		void addEtherTypeMatch(uint16_t etherType);
+
+		/**
+		 * Add a node that matches a MAC address. Equivalent to "ether src|dst|host <macAddress>"
+		 * @param[in] macAddress The MAC address
+		 * @param[in] dir Whether to match the source address, the destination address or any of them
+		 */
+		void addMacAddressMatch(const MacAddress& macAddress, Direction dir);
+
+		/**
+		 * Add a node that compares a field in the network layer of packets with a certain EtherType, for example "ip[4:2] > 100" or
+		 * "arp[7] = 1"
+		 * @param[in] etherType The EtherType packets must have
+		 * @param[in] offset The field offset from the end of the Ethernet header
+		 * @param[in] fieldSize The field size: 1, 2 or 4 bytes. The field is read in network byte order
+		 * @param[in] mask A mask applied to the field before comparing it
+		 * @param[in] op The comparison operator
+		 * @param[in] value The value to compare the masked field with
+		 */
+		void addNetworkFieldMatch(uint16_t etherType, uint16_t offset, uint8_t fieldSize, uint32_t mask, FilterOperator op, uint32_t value);
+
+		/**
+		 * Add a node that matches an IP protocol, for example "tcp", "icmp" or "proto 47"
+		 * @param[in] protocol The IPv4 protocol / IPv6 next header value
+		 * @param[in] includeIPv6 If set to false only IPv4 packets can match
+		 */
+		void addIPProtocolMatch(uint8_t protocol, bool includeIPv6);
+
+		/**
+		 * Add a node that matches a TCP, UDP or SCTP port range, for example "src portrange 1000-2000" or "dst port 80"
+		 * @param[in] fromPort The lower end of the range
+		 * @param[in] toPort The higher end of the range
+		 * @param[in] dir Whether to match the source port, the destination port or any of them
+		 */
+		void addPortRangeMatch(uint16_t fromPort, uint16_t toPort, Direction dir);
+
+		/**
+		 * Add a node that compares a field in the TCP or UDP header of non-fragmented IPv4 packets, for example "tcp[14:2] != 100"
+		 * @param[in] protocol The transport protocol: PACKETPP_IPPROTO_TCP or PACKETPP_IPPROTO_UDP
+		 * @param[in] offset The field offset from the start of the transport header
+		 * @param[in] fieldSize The field size: 1, 2 or 4 bytes. The field is read in network byte order
+		 * @param[in] mask A mask applied to the field before comparing it
+		 * @param[in] op The comparison operator
+		 * @param[in] value The value to compare the masked field with
+		 */
+		void addTransportFieldMatch(uint8_t protocol, uint16_t offset, uint8_t fieldSize, uint32_t mask, FilterOperator op, uint32_t value);
+	};
+
+} // namespace pcpp
+
+#endif // PCAPPP_NATIVE_FILTER_PROGRAM
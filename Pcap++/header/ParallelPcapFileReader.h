@@ -0,0 +1,220 @@
+#ifndef PCAPPP_PARALLEL_PCAP_FILE_READER
+#define PCAPPP_PARALLEL_PCAP_FILE_READER
+
+#include "PcapFileIndex.h"
+#include "PcapFileDevice.h"
+#include "Packet.h"
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+/// @file
+
+/**
+ * The number of parsed packets each worker can hold for the merging thread when processing packets in order
+ */
+#define PCPP_PARALLEL_READER_QUEUE_SIZE 1024
+
+/**
+* \namespace pcpp
+* \brief The main namespace for the PcapPlusPlus lib
+*/
+namespace pcpp
+{
+
+	class GeneralFilter;
+	class CompiledFilter;
+
+	/**
+	 * @class ParallelPcapFileReader
+	 * A reader that processes a classic pcap file with several threads. The file is indexed (see PcapFileIndex), split into one chunk
+	 * per worker thread, and each worker reads its chunk through its own MmapPcapFileReaderDevice and parses the packets into its own
+	 * RawPacket and Packet objects. Packets can be handed to the user in two ways:
+	 * - processPackets() - each worker calls a user callback for every packet of its chunk. Callbacks are invoked concurrently from
+	 *   different threads, in no particular order between workers
+	 * - processPacketsOrdered() - workers parse packets (and optionally run a user callback on them) concurrently, and the calling
+	 *   thread merges their output and calls another user callback in file order or in timestamp order (see PacketOrder). This is useful
+	 *   for callers that need packets in order, for example to write them to a file, but still want filtering and parsing to run in parallel
+	 *
+	 * A filter can be set with setFilter(), in which case workers skip packets that don't match it. The filter is compiled once into a
+	 * CompiledFilter shared by all workers.<BR>
+	 * Packets handed to callbacks point into the memory-mapped file and are valid only during the callback. This reader requires
+	 * memory-mapped file support (see MmapPcapFileReaderDevice#isSupported())
+	 */
+	class ParallelPcapFileReader
+	{
+	public:
+		/**
+		 * A callback invoked by worker threads for each packet. The packet object is owned by the worker and is re-used for the next
+		 * packet, so it shouldn't be kept after the callback returns
+		 * @param[in] packet The parsed packet
+		 * @param[in] workerId The index of the worker calling the callback, between 0 and the number of workers minus 1. Can be used to access
+		 * per-worker state without locking
+		 * @param[in] userCookie A pointer to the object set by the user when processing started
+		 * @return In processPacketsOrdered(), true if the packet should be passed to the ordered callback or false if it should be dropped.
+		 * The return value is ignored by processPackets()
+		 */
+		typedef bool (*OnPacketCallback)(Packet& packet, int workerId, void* userCookie);
+
+		/**
+		 * @enum PacketOrder
+		 * The order in which processPacketsOrdered() hands packets to the calling thread
+		 */
+		enum PacketOrder
+		{
+			/** Packets are handed in the order they appear in the file, regardless of their timestamps */
+			FileOrder,
+			/** The workers' chunks are merged by packet timestamp: the packet handed next is the earliest among the next packets of all
+			 * chunks, and packets with identical timestamps are handed in file order. If each chunk is sorted by timestamp the packets are
+			 * handed sorted by timestamp, and if the whole file is sorted they're handed in file order */
+			TimestampOrder
+		};
+
+		/**
+		 * A callback invoked by the thread that called processPacketsOrdered() for each packet, in the requested order
+		 * @param[in] packet The parsed packet. It's valid only until the callback returns
+		 * @param[in] userCookie A pointer to the object set by the user when processing started
+		 */
+		typedef void (*OnOrderedPacketCallback)(Packet& packet, void* userCookie);
+
+	private:
+		struct WorkerQueueSlot
+		{
+			RawPacket rawPacket;
+			Packet packet;
+		};
+
+		struct WorkerContext
+		{
+			ParallelPcapFileReader* reader;
+			int workerId;
+			PcapFileChunk chunk;
+			bool ordered;
+			bool success;
+			uint64_t numOfPacketsProcessed;
+			WorkerQueueSlot* queue;
+			// queue positions are ever-increasing counters, the slot of a position is position % PCPP_PARALLEL_READER_QUEUE_SIZE.
+			// Both are protected by m_QueueMutex
+			uint64_t queueHead;
+			uint64_t queueTail;
+			bool finished;
+			pthread_cond_t queueNotFull;
+		};
+
+		std::string m_FileName;
+		int m_NumOfWorkers;
+		PcapFileIndex m_Index;
+		LinkLayerType m_LinkLayerType;
+		CompiledFilter* m_Filter;
+		uint64_t m_NumOfPacketsProcessed;
+
+		OnPacketCallback m_OnPacket;
+		void* m_OnPacketCookie;
+
+		pthread_mutex_t m_QueueMutex;
+		pthread_cond_t m_QueueNotEmpty;
+
+		// private copy c'tor
+		ParallelPcapFileReader(const ParallelPcapFileReader& other);
+		ParallelPcapFileReader& operator=(const ParallelPcapFileReader& other);
+
+		bool runWorkers(std::vector<WorkerContext>& workers, bool ordered, PacketOrder order, OnOrderedPacketCallback onOrderedPacket, void* orderedCookie);
+		void mergeInFileOrder(std::vector<WorkerContext>& workers, OnOrderedPacketCallback onOrderedPacket, void* orderedCookie);
+		void mergeInTimestampOrder(std::vector<WorkerContext>& workers, OnOrderedPacketCallback onOrderedPacket, void* orderedCookie);
+		bool readPacket(MmapPcapFileReaderDevice& device, RawPacket& rawPacket, uint64_t& numOfPacketsLeft);
+		static void* workerMain(void* context);
+
+	public:
+		/**
+		 * A c'tor for this class. Notice that after calling this constructor the file isn't opened yet, please call open()
+		 * @param[in] fileName The pcap file to read
+		 * @param[in] numOfWorkers The number of worker threads. Values smaller than 1 are treated as 1
+		 */
+		ParallelPcapFileReader(const std::string& fileName, int numOfWorkers);
+
+		/**
+		 * A d'tor for this class
+		 */
+		~ParallelPcapFileReader();
+
+		/**
+		 * Open the file and prepare its index. If a valid index sidecar file exists it's loaded, otherwise the file is indexed
+		 * @param[in] saveIndex If set to true and the file had to be indexed, the index is saved to a sidecar file so next opens are faster
+		 * (see PcapFileIndex#loadOrBuild()). The default value is false
+		 * @return True if the file was opened and indexed successfully, false otherwise (an error log will be printed)
+		 */
+		bool open(bool saveIndex = false);
+
+		/**
+		 * Close the file and clear the index and the filter
+		 */
+		void close();
+
+		/**
+		 * @return True if the file is opened, false otherwise
+		 */
+		bool isOpened() const { return m_Index.isValid(); }
+
+		/**
+		 * @return The file index. Valid only after the file was opened
+		 */
+		const PcapFileIndex& getIndex() const { return m_Index; }
+
+		/**
+		 * @return The number of worker threads
+		 */
+		int getNumOfWorkers() const { return m_NumOfWorkers; }
+
+		/**
+		 * @return The link layer type of the file. Valid only after the file was opened
+		 */
+		LinkLayerType getLinkLayerType() const { return m_LinkLayerType; }
+
+		/**
+		 * Set a BPF filter. Workers skip packets that don't match it. The file must be opened, and the filter is cleared when it's closed
+		 * @param[in] filterAsString The filter in Berkeley Packet Filter (BPF) syntax (http://biot.com/capstats/bpf.html). An empty string
+		 * clears the filter
+		 * @return True if the filter was set successfully, false otherwise
+		 */
+		bool setFilter(std::string filterAsString);
+
+		/**
+		 * Set a filter. If the file's link type is Ethernet and the filter can be matched natively (see NativeFilterProgram) workers match
+		 * it natively, otherwise it's compiled into a BPF program. See setFilter(std::string) for more details
+		 * @param[in] filter The filter to set
+		 * @return True if the filter was set successfully, false otherwise
+		 */
+		bool setFilter(GeneralFilter& filter);
+
+		/**
+		 * Process all packets of the file with the worker threads. Returns after all workers are done
+		 * @param[in] onPacket A callback invoked by the workers for each packet that matches the filter
+		 * @param[in] userCookie A pointer passed to the callback
+		 * @return True if all packets were processed, false if the file isn't opened or a worker failed reading its chunk
+		 */
+		bool processPackets(OnPacketCallback onPacket, void* userCookie);
+
+		/**
+		 * Process all packets of the file with the worker threads and hand them to the calling thread in order. In file order the calling
+		 * thread drains the workers' queues one after the other while workers further in the file keep reading ahead until their queues
+		 * are full. In timestamp order it merges the heads of all queues. Returns after all packets were handed
+		 * @param[in] onPacket An optional callback invoked by the workers for each packet that matches the filter. If it returns false the
+		 * packet isn't passed to onOrderedPacket. Can be NULL, in which case all packets matching the filter are passed
+		 * @param[in] onPacketCookie A pointer passed to onPacket
+		 * @param[in] onOrderedPacket A callback invoked by the calling thread for each packet, in the requested order
+		 * @param[in] onOrderedPacketCookie A pointer passed to onOrderedPacket
+		 * @param[in] order The order in which packets are handed to onOrderedPacket. The default is FileOrder
+		 * @return True if all packets were processed, false if the file isn't opened or a worker failed reading its chunk
+		 */
+		bool processPacketsOrdered(OnPacketCallback onPacket, void* onPacketCookie, OnOrderedPacketCallback onOrderedPacket, void* onOrderedPacketCookie,
+				PacketOrder order = FileOrder);
+
+		/**
+		 * @return The number of packets that matched the filter and were handed to the worker callbacks in the last processing run
+		 */
+		uint64_t getNumOfPacketsProcessed() const { return m_NumOfPacketsProcessed; }
+	};
+
+} // namespace pcpp
+
+#endif // PCAPPP_PARALLEL_PCAP_FILE_READER
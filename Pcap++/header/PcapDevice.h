@@ -71,7 +71,9 @@ namespace pcpp
 
 		/**
 		 * Match a raw packet with a given BPF filter. Notice this method is static which means you don't need any device instance
-		 * in order to perform this match
+		 * in order to perform this match. Each thread keeps the last filter it compiled, so matching many packets with the same filter
+		 * compiles it only once per thread. When alternating between filters or matching from several threads prefer building a
+		 * CompiledFilter once and sharing it
 		 * @param[in] filterAsString The BPF filter
 		 * @param[in] rawPacket A pointer to the raw packet to match the BPF filter with
 		 * @return True if raw packet matches the BPF filter or false otherwise
@@ -3,6 +3,7 @@
 
 #include "PcapDevice.h"
 #include "RawPacket.h"
+#include <vector>
 
 /// @file
 
@@ -51,6 +52,13 @@ namespace pcpp
 	protected:
 		uint32_t m_NumOfPacketsRead;
 		uint32_t m_NumOfPacketsNotParsed;
+		bool m_ZeroCopy;
+
+		// a buffer re-used across getNextPackets() calls in zero-copy mode. Buffers that were replaced by a larger one in the middle
+		// of a batch are kept until the next batch because packets of the current batch still point into them
+		uint8_t* m_BatchBuffer;
+		size_t m_BatchBufferSize;
+		std::vector<uint8_t*> m_RetiredBatchBuffers;
 
 		/**
 		 * A constructor for this class that gets the pcap full path file name to open. Notice that after calling this constructor the file
@@ -64,7 +72,7 @@ namespace pcpp
 		/**
 		 * A destructor for this class
 		 */
-		virtual ~IFileReaderDevice() {}
+		virtual ~IFileReaderDevice();
 
 		/**
 		* @return The file size in bytes
@@ -83,12 +91,41 @@ namespace pcpp
 		int getNextPackets(RawPacketVector& packetVec, int numOfPacketsToRead = -1);
 
 		/**
-		 * A static method that creates an instance of the reader best fit to read the file. It decides by the file extension: for .pcapng
-		 * files it returns an instance of PcapNgFileReaderDevice and for all other extensions it returns an instance of PcapFileReaderDevice
+		 * Read the next N packets into a caller-owned array of raw packets. The RawPacket instances are re-used, so reading a file in batches
+		 * into the same array doesn't require allocating RawPacket objects. In zero-copy mode (see setZeroCopyMode()) the packets data
+		 * is placed in a buffer owned by the reader and re-used across calls, meaning no memory is allocated per packet. In that case the
+		 * packets data is valid only until the next call to this method or to getNextPacket(), and it must not be freed by the user
+		 * @param[in] rawPacketsArr A pointer to an array of raw packets to read packets into
+		 * @param[in] arrLength The length of the array, which is the maximum number of packets to read
+		 * @return The number of packets actually read. A value smaller than arrLength means end-of-file was reached or an error occurred
+		 */
+		virtual int getNextPackets(RawPacket* rawPacketsArr, int arrLength);
+
+		/**
+		 * Set the zero-copy mode of the reader. In this mode getNextPacket() doesn't copy the packet data into a newly allocated buffer, but
+		 * rather sets the raw packet to point to the reader's internal read buffer (deleteRawDataAtDestructor is set to 'false').
+		 * This saves a memory allocation and a copy per packet, but the packet data is valid only until the next packet is read. Packets that
+		 * need to outlive the next read should be copied (for example using the RawPacket copy constructor). Zero-copy mode is disabled by default
+		 * @param[in] zeroCopy True to enable zero-copy mode, false to disable it
+		 */
+		void setZeroCopyMode(bool zeroCopy) { m_ZeroCopy = zeroCopy; }
+
+		/**
+		 * @return True if zero-copy mode is enabled, false otherwise. See setZeroCopyMode() for more details
+		 */
+		bool isZeroCopyMode() const { return m_ZeroCopy; }
+
+		/**
+		 * A static method that creates an instance of the reader best fit to read the file. It decides by the file extension and by the
+		 * magic number at the beginning of the file: for .pcapng files or files starting with a pcap-ng section header it returns an instance
+		 * of PcapNgFileReaderDevice. For classic pcap files it returns an instance of PcapFileReaderDevice, or an instance of
+		 * MmapPcapFileReaderDevice if requested and supported on the current platform (see MmapPcapFileReaderDevice#isSupported())
 		 * @param[in] fileName The file name to open
+		 * @param[in] useMmapReader If set to true classic pcap files are read with MmapPcapFileReaderDevice. If the platform doesn't support
+		 * it, PcapFileReaderDevice is used instead. The default is false
 		 * @return An instance of the reader to read the file. Notice you should free this instance when done using it
 		 */
-		static IFileReaderDevice* getReader(const char* fileName);
+		static IFileReaderDevice* getReader(const char* fileName, bool useMmapReader = false);
 	};
 
 
@@ -98,9 +135,10 @@ namespace pcpp
 	 */
 	class PcapFileReaderDevice : public IFileReaderDevice
 	{
-	private:
+	protected:
 		LinkLayerType m_PcapLinkLayerType;
 
+	private:
 		// private copy c'tor
 		PcapFileReaderDevice(const PcapFileReaderDevice& other);
 		PcapFileReaderDevice& operator=(const PcapFileReaderDevice& other);
@@ -149,6 +187,127 @@ namespace pcpp
 	};
 
 
+	/**
+	 * @class MmapPcapFileReaderDevice
+	 * A reader for classic pcap files which memory-maps the file and walks the packet record headers directly instead of reading it
+	 * through libpcap. This saves libpcap's buffered file reads and the per-packet copy, and lets the OS prefetch the file sequentially.
+	 * Files with microsecond and nanosecond timestamp precision written in either byte order are supported. pcap-ng files are not supported,
+	 * please use PcapNgFileReaderDevice for those.<BR>
+	 * When zero-copy mode is enabled (see IFileReaderDevice#setZeroCopyMode()) the raw packets point directly into the mapped file, so their
+	 * data stays valid until the file is closed. Otherwise each packet is copied to a buffer owned by the raw packet, like in
+	 * PcapFileReaderDevice.<BR>
+	 * Since the whole file is mapped into the address space of the process, very large files may not be readable on 32-bit platforms.
+	 * This reader isn't supported on Windows, where open() always fails
+	 */
+	class MmapPcapFileReaderDevice : public PcapFileReaderDevice
+	{
+	private:
+		uint8_t* m_MappedFile;
+		size_t m_MappedFileSize;
+		size_t m_ReadOffset;
+		bool m_SwapBytes;
+		bool m_NanoSecPrecision;
+		uint32_t m_SnapshotLength;
+		struct bpf_program m_Bpf;
+		bool m_BpfInitialized;
+
+		// private copy c'tor
+		MmapPcapFileReaderDevice(const MmapPcapFileReaderDevice& other);
+		MmapPcapFileReaderDevice& operator=(const MmapPcapFileReaderDevice& other);
+
+		uint32_t readUint32(size_t offset) const;
+		static uint32_t linkTypeToDlt(uint32_t linkType);
+
+	public:
+		/**
+		 * A constructor for this class that gets the pcap full path file name to open. Notice that after calling this constructor the file
+		 * isn't opened yet, so reading packets will fail. For opening the file call open()
+		 * @param[in] fileName The full path of the file to read
+		 */
+		MmapPcapFileReaderDevice(const char* fileName);
+
+		/**
+		 * A destructor for this class. Unmaps the file if it's still mapped
+		 */
+		virtual ~MmapPcapFileReaderDevice();
+
+		/**
+		 * @return True if the file timestamps are in nanosecond precision, false if they're in microsecond precision. The value is
+		 * relevant only after the file was opened
+		 */
+		bool isNanoSecondPrecision() const { return m_NanoSecPrecision; }
+
+		/**
+		 * @return The snapshot length written in the file header, or 0 if the file isn't opened. Packet records with a larger capture
+		 * length are truncated to this length when read, like in libpcap
+		 */
+		uint32_t getSnapshotLength() const { return m_SnapshotLength; }
+
+		/**
+		 * @return The offset in the file of the next packet record to be read, or 0 if the file isn't opened
+		 */
+		uint64_t getReadOffset() const { return m_ReadOffset; }
+
+		/**
+		 * Move the read position to a certain offset in the file. The offset must be the beginning of a packet record, for example an offset
+		 * returned by getReadOffset() or stored in a PcapFileIndex. The next call to getNextPacket() reads the record at this offset
+		 * @param[in] offset The offset to move to
+		 * @return True if the read position was moved, false if the file isn't opened or if the offset is outside the packet records area
+		 * of the file (an error log will be printed in both cases)
+		 */
+		bool setReadOffset(uint64_t offset);
+
+		/**
+		 * @return True if memory-mapped file reading is supported on the current platform, false otherwise
+		 */
+		static bool isSupported();
+
+
+		//overridden methods
+
+		/**
+		 * Read the next packet from the file. Before using this method please verify the file is opened using open()
+		 * @param[out] rawPacket A reference for an empty RawPacket where the packet will be written
+		 * @return True if a packet was read successfully. False will be returned if the file isn't opened (also, an error log will be printed),
+		 * if reached end-of-file or if the last packet record is truncated
+		 */
+		bool getNextPacket(RawPacket& rawPacket);
+
+		using IFileReaderDevice::getNextPackets;
+
+		/**
+		 * Read the next N packets into a caller-owned array of raw packets. In zero-copy mode the packets point into the mapped file,
+		 * so unlike in IFileReaderDevice#getNextPackets() they stay valid until the file is closed
+		 * @param[in] rawPacketsArr A pointer to an array of raw packets to read packets into
+		 * @param[in] arrLength The length of the array, which is the maximum number of packets to read
+		 * @return The number of packets actually read. A value smaller than arrLength means end-of-file was reached or an error occurred
+		 */
+		int getNextPackets(RawPacket* rawPacketsArr, int arrLength);
+
+		/**
+		 * Map the file which path was specified in the constructor and verify its header
+		 * @return True if file was opened successfully or if file is already opened. False if opening the file failed for some reason (for example:
+		 * file path does not exist, the file isn't a classic pcap file or the platform doesn't support memory-mapped files)
+		 */
+		bool open();
+
+		/**
+		 * Unmap the file. Raw packets read in zero-copy mode are no longer valid after calling this method
+		 */
+		void close();
+
+		using IPcapDevice::setFilter;
+
+		/**
+		 * Set a filter for the reader device. Only packets that match the filter will be received. The device must be opened, and the filter
+		 * is reset when the device is closed
+		 * @param[in] filterAsString The filter to be set in Berkeley Packet Filter (BPF) syntax (http://biot.com/capstats/bpf.html)
+		 * @return True if filter set successfully, false otherwise
+		 */
+		bool setFilter(std::string filterAsString);
+	};
+
+
 	/**
 	 * @class PcapNgFileReaderDevice
 	 * A class for opening a pcap-ng file in read-only mode. This class enable to open the file and read all packets, packet-by-packet
@@ -0,0 +1,171 @@
+#ifndef PCAPPP_PCAP_FILE_INDEX
+#define PCAPPP_PCAP_FILE_INDEX
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/// @file
+
+/**
+ * The default number of packets between two consecutive entries of a PcapFileIndex
+ */
+#define PCPP_PCAP_FILE_INDEX_DEFAULT_PACKETS_PER_ENTRY 4096
+
+/**
+ * The extension added to a pcap file name to get the name of its index sidecar file
+ */
+#define PCPP_PCAP_FILE_INDEX_EXTENSION ".pcppidx"
+
+/**
+* \namespace pcpp
+* \brief The main namespace for the PcapPlusPlus lib
+*/
+namespace pcpp
+{
+
+	/**
+	 * @struct PcapFileChunk
+	 * Describes a contiguous range of packet records in a pcap file, as returned by PcapFileIndex#getChunks()
+	 */
+	struct PcapFileChunk
+	{
+		/** The offset in the file of the first packet record in the chunk */
+		uint64_t startOffset;
+		/** The offset in the file right after the last packet record in the chunk */
+		uint64_t endOffset;
+		/** The index in the file of the first packet in the chunk (the first packet in the file is 0) */
+		uint64_t firstPacketIndex;
+		/** The number of packets in the chunk */
+		uint64_t numOfPackets;
+	};
+
+
+	/**
+	 * @class PcapFileIndex
+	 * An index of packet record boundaries in a classic pcap file. Pcap files have no index, so the only way to find where a certain
+	 * packet starts is to walk all the record headers before it. This class walks the file once and stores the offset of every
+	 * N-th packet record (N is set by the user, see build()), which allows splitting the file into chunks that can be read
+	 * independently, for example by several threads (see ParallelPcapFileReader).<BR>
+	 * Building an index requires reading all record headers of the file, so the index can be saved to a sidecar file
+	 * (by default the pcap file name with a ".pcppidx" extension) and loaded later instead of being rebuilt. The sidecar file is
+	 * written in the byte order of the machine that created it and is tied to the size and modification time of the pcap file it was built
+	 * for. The offsets it holds are checked for consistency before they're used.<BR>
+	 * Indexing requires memory-mapped file support (see MmapPcapFileReaderDevice#isSupported())
+	 */
+	class PcapFileIndex
+	{
+	private:
+		uint32_t m_PacketsPerEntry;
+		uint64_t m_NumOfPackets;
+		uint64_t m_PcapFileSize;
+		uint64_t m_PcapFileModificationTime;
+		uint64_t m_DataEndOffset;
+		std::vector<uint64_t> m_EntryOffsets;
+
+		static bool getFileInfo(const std::string& fileName, uint64_t& fileSize, uint64_t& modificationTime);
+
+	public:
+		/**
+		 * A c'tor for this class that creates an empty index. Use build() or load() to fill it
+		 */
+		PcapFileIndex();
+
+		/**
+		 * Build the index by reading all packet record headers of a pcap file. Any previous content of the index is discarded
+		 * @param[in] pcapFileName The pcap file to index
+		 * @param[in] packetsPerEntry The number of packets between two consecutive entries of the index. Smaller values enable finer
+		 * chunks at the cost of a larger index. The default value is ::PCPP_PCAP_FILE_INDEX_DEFAULT_PACKETS_PER_ENTRY
+		 * @return True if the index was built successfully, false if the file couldn't be opened or isn't a classic pcap file (an error
+		 * log will be printed)
+		 */
+		bool build(const std::string& pcapFileName, uint32_t packetsPerEntry = PCPP_PCAP_FILE_INDEX_DEFAULT_PACKETS_PER_ENTRY);
+
+		/**
+		 * Load an index previously saved by save(). Any previous content of the index is discarded
+		 * @param[in] pcapFileName The pcap file the index was built for. It's used to verify the index still matches the file
+		 * @param[in] indexFileName The index file to load
+		 * @return True if the index was loaded successfully, false if the index file doesn't exist, is corrupted or doesn't match the pcap
+		 * file (its size or modification time changed after the index was built)
+		 */
+		bool load(const std::string& pcapFileName, const std::string& indexFileName);
+
+		/**
+		 * Save the index to a file so it can be loaded later with load()
+		 * @param[in] indexFileName The file to write the index to. If the file exists it's overwritten
+		 * @return True if the index was saved successfully, false otherwise (an error log will be printed)
+		 */
+		bool save(const std::string& indexFileName) const;
+
+		/**
+		 * Load the index from the sidecar file of a pcap file (see getSidecarFileName()). If the sidecar file doesn't exist or doesn't
+		 * match the pcap file, build the index and optionally save it to the sidecar file
+		 * @param[in] pcapFileName The pcap file to index
+		 * @param[in] saveSidecar If set to true and the index had to be built, it's saved to the sidecar file. Failing to save the sidecar
+		 * file isn't considered an error. The default value is false
+		 * @param[in] packetsPerEntry The number of packets between two consecutive entries, used only if the index has to be built
+		 * @return True if the index was loaded or built successfully, false otherwise
+		 */
+		bool loadOrBuild(const std::string& pcapFileName, bool saveSidecar = false, uint32_t packetsPerEntry = PCPP_PCAP_FILE_INDEX_DEFAULT_PACKETS_PER_ENTRY);
+
+		/**
+		 * Clear the index
+		 */
+		void clear();
+
+		/**
+		 * @return True if the index was built or loaded, false otherwise
+		 */
+		bool isValid() const { return m_PacketsPerEntry > 0; }
+
+		/**
+		 * @return The number of packets in the indexed file
+		 */
+		uint64_t getNumOfPackets() const { return m_NumOfPackets; }
+
+		/**
+		 * @return The number of packets between two consecutive entries of the index
+		 */
+		uint32_t getPacketsPerEntry() const { return m_PacketsPerEntry; }
+
+		/**
+		 * @return The number of entries in the index
+		 */
+		size_t getNumOfEntries() const { return m_EntryOffsets.size(); }
+
+		/**
+		 * Get the offset of the packet record an entry points to. Entry i points to packet number i*getPacketsPerEntry()
+		 * @param[in] entryIndex The entry index
+		 * @return The offset in the file of the packet record, or 0 if entryIndex is out of range
+		 */
+		uint64_t getEntryOffset(size_t entryIndex) const { return (entryIndex < m_EntryOffsets.size() ? m_EntryOffsets[entryIndex] : 0); }
+
+		/**
+		 * @return The size of the pcap file this index was built for
+		 */
+		uint64_t getPcapFileSize() const { return m_PcapFileSize; }
+
+		/**
+		 * @return The modification time (in seconds since the epoch) of the pcap file this index was built for
+		 */
+		uint64_t getPcapFileModificationTime() const { return m_PcapFileModificationTime; }
+
+		/**
+		 * Split the packets of the file into chunks of roughly equal number of packets. Chunk boundaries are always on index entries
+		 * so fewer chunks than requested may be returned for small files
+		 * @param[in] numOfChunks The requested number of chunks
+		 * @param[out] chunks A vector the chunks are written to. Any previous content of the vector is discarded
+		 * @return The number of chunks written to the vector
+		 */
+		size_t getChunks(size_t numOfChunks, std::vector<PcapFileChunk>& chunks) const;
+
+		/**
+		 * @param[in] pcapFileName A pcap file name
+		 * @return The name of the sidecar index file of this pcap file, which is the pcap file name followed by ::PCPP_PCAP_FILE_INDEX_EXTENSION
+		 */
+		static std::string getSidecarFileName(const std::string& pcapFileName) { return pcapFileName + PCPP_PCAP_FILE_INDEX_EXTENSION; }
+	};
+
+} // namespace pcpp
+
+#endif // PCAPPP_PCAP_FILE_INDEX
@@ -10,6 +10,8 @@
 
 //Forward Declaration - used in GeneralFilter
 struct bpf_program;
+//Forward Declaration - used in compileBpfFilter
+struct pcap;
 
 /**
  * @file
@@ -35,6 +37,7 @@ namespace pcpp
 {
 	//Forward Declartation - used in GeneralFilter
 	class RawPacket;
+	class NativeFilterProgram;
 
 	/**
 	 * An enum that contains direction (source or destination)
@@ -70,9 +73,26 @@ namespace pcpp
 	} FilterOperator;
 
 
+	/**
+	 * Compile a BPF string into a BPF program. Older libpcap versions keep the state of the filter compiler in global variables, so all
+	 * BPF compilation in PcapPlusPlus goes through this function, which serializes it with a global lock
+	 * @param[in] filterAsString The filter in Berkeley Packet Filter (BPF) syntax. An empty string compiles into a program that matches
+	 * all packets
+	 * @param[in] linkType The link type of the packets the program will run on
+	 * @param[in] snapshotLength The snapshot length of the packets the program will run on
+	 * @param[out] program The compiled program. Should be freed with pcap_freecode() if compilation succeeded
+	 * @param[in] pcapDescriptor An optional pcap handle to compile the filter for. If set, its link type and snapshot length are used
+	 * instead of linkType and snapshotLength, and the compilation error can be retrieved with pcap_geterr()
+	 * @return True if the filter was compiled successfully, false otherwise
+	 */
+	bool compileBpfFilter(const std::string& filterAsString, int linkType, int snapshotLength, bpf_program* program, pcap* pcapDescriptor = NULL);
+
+
 	/**
 	 * @class GeneralFilter
 	 * The base class for all filter classes. This class is virtual and abstract, hence cannot be instantiated.<BR>
+	 * Filters which can be expressed natively are matched with a NativeFilterProgram, which is compiled once and rebuilt only when a filter
+	 * in the tree is modified. Other filters are matched by compiling their BPF string with libpcap.<BR>
 	 * For deeper understanding of the filter concept please refer to PcapFilter.h
 	 */
 	class GeneralFilter
@@ -80,12 +100,28 @@ namespace pcpp
 	protected:
 		bpf_program* m_program;
 		std::string m_lastProgramString;
+		NativeFilterProgram* m_NativeProgram;
+		uint32_t m_Version;
 
 		/**
 		* Free the held program and any resources allocated for it.
 		*/
 		void freeProgram();
 
+		/**
+		 * Mark the filter as modified. Every method that changes the filter must call it, so native programs compiled from this filter
+		 * (or from a filter containing it) are rebuilt
+		 */
+		void invalidate() { m_Version++; }
+
+		/**
+		 * Add the nodes that represent this filter to a native filter program. Filters that can be matched natively override this method
+		 * @param[in] program The program to add the nodes to
+		 * @return True if the filter was added to the program, false if it can't be matched natively. The default implementation
+		 * returns false
+		 */
+		virtual bool compileNativeNodes(NativeFilterProgram& program) { return false; }
+
 	public:
 		/**
 		 * A method that parses the class instance into BPF string format
@@ -100,12 +136,38 @@ namespace pcpp
 		*/
 		bool matchPacketWithFilter(RawPacket* rawPacket);
 
-		GeneralFilter() : m_program(NULL) {}
+		/**
+		 * Compile this filter into a native filter program: register it as a dependency of the program and add the nodes that
+		 * represent it
+		 * @param[in] program The program to compile the filter into
+		 * @return True if the filter was compiled, false if it can't be matched natively
+		 */
+		bool compileToNative(NativeFilterProgram& program);
+
+		/**
+		 * @return The version of the filter, which changes every time the filter is modified
+		 */
+		uint32_t getVersion() const { return m_Version; }
+
+		GeneralFilter() : m_program(NULL), m_NativeProgram(NULL), m_Version(0) {}
+
+		/**
+		 * A copy c'tor for this class. The compiled programs aren't copied, the copy compiles its own ones when needed
+		 * @param[in] other The filter to copy from
+		 */
+		GeneralFilter(const GeneralFilter& other);
 
 		/**
-		 * Virtual destructor, frees the bpf program
+		 * Assignment operator. The compiled programs of this filter are freed and aren't copied from the other filter
+		 * @param[in] other The filter to copy from
+		 * @return A reference to this filter
 		 */
-		virtual ~GeneralFilter() { freeProgram(); }
+		GeneralFilter& operator=(const GeneralFilter& other);
+
+		/**
+		 * Virtual destructor, frees the bpf program and the native program
+		 */
+		virtual ~GeneralFilter();
 	};
 
 	/**
@@ -155,7 +217,7 @@ namespace pcpp
 		 * Set the direction for the filter (source or destination)
 		 * @param[in] dir The direction
 		 */
-		void setDirection(Direction dir) { m_Dir = dir; }
+		void setDirection(Direction dir) { m_Dir = dir; invalidate(); }
 	};
 
 
@@ -178,7 +240,7 @@ namespace pcpp
 		 * Set the operator for the filter
 		 * @param[in] op The operator to set
 		 */
-		void setOperator(FilterOperator op) { m_Operator = op; }
+		void setOperator(FilterOperator op) { m_Operator = op; invalidate(); }
 	};
 
 
@@ -197,6 +259,8 @@ namespace pcpp
 		int m_Len;
 		void convertToIPAddressWithMask(std::string& ipAddrmodified, std::string& mask) const;
 		void convertToIPAddressWithLen(std::string& ipAddrmodified) const;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * The basic constructor that creates the filter from an IPv4 address and direction (source or destination)
@@ -235,19 +299,19 @@ namespace pcpp
 		 * @param[in] ipAddress The IPv4 address to build the filter with. If this address is not a valid IPv4 address an error will be
 		 * written to log and parsing this filter will fail
 		 */
-		void setAddr(const std::string& ipAddress) { m_Address = ipAddress; }
+		void setAddr(const std::string& ipAddress) { m_Address = ipAddress; invalidate(); }
 
 		/**
 		 * Set the IPv4 mask
 		 * @param[in] ipv4Mask The mask to use. Mask should also be in a valid IPv4 format (i.e x.x.x.x), otherwise parsing this filter will fail
 		 */
-		void setMask(const std::string& ipv4Mask) { m_IPv4Mask = ipv4Mask; m_Len = 0; }
+		void setMask(const std::string& ipv4Mask) { m_IPv4Mask = ipv4Mask; m_Len = 0; invalidate(); }
 
 		/**
 		 * Set the subnet
 		 * @param[in] len The subnet to use (e.g "/24")
 		 */
-		void setLen(int len) { m_IPv4Mask = ""; m_Len = len; }
+		void setLen(int len) { m_IPv4Mask = ""; m_Len = len; invalidate(); }
 	};
 
 
@@ -262,6 +326,8 @@ namespace pcpp
 	{
 	private:
 		uint16_t m_IpID;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that gets the IP ID to filter and the operator and creates the filter out of them
@@ -276,7 +342,7 @@ namespace pcpp
 		 * Set the IP ID to filter
 		 * @param[in] ipID The IP ID to filter
 		 */
-		void setIpID(uint16_t ipID) { m_IpID = ipID; }
+		void setIpID(uint16_t ipID) { m_IpID = ipID; invalidate(); }
 	};
 
 
@@ -291,6 +357,8 @@ namespace pcpp
 	{
 	private:
 		uint16_t m_TotalLength;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that gets the total length to filter and the operator and creates the filter out of them
@@ -305,7 +373,7 @@ namespace pcpp
 		 * Set the total length value
 		 * @param[in] totalLength The total length value to filter
 		 */
-		void setTotalLength(uint16_t totalLength) { m_TotalLength = totalLength; }
+		void setTotalLength(uint16_t totalLength) { m_TotalLength = totalLength; invalidate(); }
 	};
 
 
@@ -320,6 +388,8 @@ namespace pcpp
 	private:
 		std::string m_Port;
 		void portToString(uint16_t portAsInt);
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that gets the port and the direction and creates the filter
@@ -334,7 +404,7 @@ namespace pcpp
 		 * Set the port
 		 * @param[in] port The port to create the filter with
 		 */
-		void setPort(uint16_t port) { portToString(port); }
+		void setPort(uint16_t port) { portToString(port); invalidate(); }
 	};
 
 
@@ -350,6 +420,8 @@ namespace pcpp
 	private:
 		uint16_t m_FromPort;
 		uint16_t m_ToPort;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that gets the port range the the direction and creates the filter with them
@@ -365,13 +437,13 @@ namespace pcpp
 		 * Set the lower end of the port range
 		 * @param[in] fromPort The lower end of the port range
 		 */
-		void setFromPort(uint16_t fromPort) { m_FromPort = fromPort; }
+		void setFromPort(uint16_t fromPort) { m_FromPort = fromPort; invalidate(); }
 
 		/**
 		 * Set the higher end of the port range
 		 * @param[in] toPort The higher end of the port range
 		 */
-		void setToPort(uint16_t toPort) { m_ToPort = toPort; }
+		void setToPort(uint16_t toPort) { m_ToPort = toPort; invalidate(); }
 	};
 
 
@@ -385,6 +457,8 @@ namespace pcpp
 	{
 	private:
 		MacAddress m_MacAddress;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that gets the MAC address and the direction and creates the filter with them
@@ -399,7 +473,7 @@ namespace pcpp
 		 * Set the MAC address
 		 * @param[in] address The MAC address to use for filtering
 		 */
-		void setMacAddress(MacAddress address) { m_MacAddress = address; }
+		void setMacAddress(MacAddress address) { m_MacAddress = address; invalidate(); }
 	};
 
 
@@ -414,6 +488,8 @@ namespace pcpp
 	{
 	private:
 		uint16_t m_EtherType;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that gets the EtherType and creates the filter with it
@@ -427,7 +503,7 @@ namespace pcpp
 		 * Set the EtherType value
 		 * @param[in] etherType The EtherType value to create the filter with
 		 */
-		void setEtherType(uint16_t etherType) { m_EtherType = etherType; }
+		void setEtherType(uint16_t etherType) { m_EtherType = etherType; invalidate(); }
 	};
 
 
@@ -444,6 +520,8 @@ namespace pcpp
 	{
 	private:
 		std::vector<GeneralFilter*> m_FilterList;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 
 		/**
@@ -461,7 +539,7 @@ namespace pcpp
 		 * Add filter to the and condition
 		 * @param[in] filter The filter to add
 		 */
-		void addFilter(GeneralFilter* filter) { m_FilterList.push_back(filter); }
+		void addFilter(GeneralFilter* filter) { m_FilterList.push_back(filter); invalidate(); }
 
 		/**
 		 * Remove the current filters and set new ones
@@ -486,6 +564,8 @@ namespace pcpp
 	{
 	private:
 		std::vector<GeneralFilter*> m_FilterList;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 
 		/**
@@ -503,7 +583,7 @@ namespace pcpp
 		 * Add filter to the or condition
 		 * @param[in] filter The filter to add
 		 */
-		void addFilter(GeneralFilter* filter) { m_FilterList.push_back(filter); }
+		void addFilter(GeneralFilter* filter) { m_FilterList.push_back(filter); invalidate(); }
 
 		void parseToString(std::string& result);
 	};
@@ -519,6 +599,8 @@ namespace pcpp
 	{
 	private:
 		GeneralFilter* m_FilterToInverse;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that gets a pointer to a filter and create the inverse version of it
@@ -532,7 +614,7 @@ namespace pcpp
 		 * Set a filter to create an inverse filter from
 		 * @param[in] filterToInverse A pointer to filter which the created filter be the inverse of
 		 */
-		void setFilter(GeneralFilter* filterToInverse) { m_FilterToInverse = filterToInverse; }
+		void setFilter(GeneralFilter* filterToInverse) { m_FilterToInverse = filterToInverse; invalidate(); }
 	};
 
 
@@ -548,6 +630,8 @@ namespace pcpp
 	{
 	private:
 		ProtocolType m_Proto;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that gets the protocol and creates the filter
@@ -563,7 +647,7 @@ namespace pcpp
 		 * @param[in] proto The protocol to filter, only packets matching this protocol will be received. Please note not all protocols are
 		 * supported. List of supported protocols is found in the class description
 		 */
-		void setProto(ProtocolType proto) { m_Proto = proto; }
+		void setProto(ProtocolType proto) { m_Proto = proto; invalidate(); }
 	};
 
 
@@ -578,6 +662,8 @@ namespace pcpp
 	{
 	private:
 		ArpOpcode m_OpCode;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that get the ARP opcode and creates the filter
@@ -591,7 +677,7 @@ namespace pcpp
 		 * Set the ARP opcode
 		 * @param[in] opCode The ARP opcode: ::ARP_REQUEST or ::ARP_REPLY
 		 */
-		void setOpCode(ArpOpcode opCode) { m_OpCode = opCode; }
+		void setOpCode(ArpOpcode opCode) { m_OpCode = opCode; invalidate(); }
 	};
 
 
@@ -619,7 +705,7 @@ namespace pcpp
 		 * Set the VLAN ID of the filter
 		 * @param[in] vlanId The VLAN ID to use for the filter
 		 */
-		void setVlanID(uint16_t vlanId) { m_VlanID = vlanId; }
+		void setVlanID(uint16_t vlanId) { m_VlanID = vlanId; invalidate(); }
 	};
 
 
@@ -665,6 +751,8 @@ namespace pcpp
 	private:
 		uint8_t m_TcpFlagsBitMask;
 		MatchOptions m_MatchOption;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that gets a 1-byte bitmask containing all TCP flags participating in the filter and the match option, and
@@ -681,7 +769,7 @@ namespace pcpp
 		 * following value for example: TcpFlagsFilter::tcpSyn | TcpFlagsFilter::tcpAck | TcpFlagsFilter::tcpUrg
 		 * @param[in] matchOption The match option: TcpFlagsFilter::MatchAll or TcpFlagsFilter::MatchOneAtLeast
 		 */
-		void setTcpFlagsBitMask(uint8_t tcpFlagBitMask, MatchOptions matchOption) { m_TcpFlagsBitMask = tcpFlagBitMask; m_MatchOption = matchOption; }
+		void setTcpFlagsBitMask(uint8_t tcpFlagBitMask, MatchOptions matchOption) { m_TcpFlagsBitMask = tcpFlagBitMask; m_MatchOption = matchOption; invalidate(); }
 
 		void parseToString(std::string& result);
 	};
@@ -697,6 +785,8 @@ namespace pcpp
 	{
 	private:
 		uint16_t m_WindowSize;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that get the window-size and operator and creates the filter. For example: "filter all TCP packets with window-size
@@ -712,7 +802,7 @@ namespace pcpp
 		 * Set window-size value
 		 * @param[in] windowSize The window-size value that will be used in the filter
 		 */
-		void setWindowSize(uint16_t windowSize) { m_WindowSize = windowSize; }
+		void setWindowSize(uint16_t windowSize) { m_WindowSize = windowSize; invalidate(); }
 	};
 
 
@@ -726,6 +816,8 @@ namespace pcpp
 	{
 	private:
 		uint16_t m_Length;
+	protected:
+		bool compileNativeNodes(NativeFilterProgram& program);
 	public:
 		/**
 		 * A constructor that get the UDP length and operator and creates the filter. For example: "filter all UDP packets with length
@@ -741,7 +833,7 @@ namespace pcpp
 		 * Set legnth value
 		 * @param[in] legnth The legnth value that will be used in the filter
 		 */
-		void setLength(uint16_t legnth) { m_Length = legnth; }
+		void setLength(uint16_t legnth) { m_Length = legnth; invalidate(); }
 	};
 
 } // namespace pcpp
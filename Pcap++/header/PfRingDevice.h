@@ -51,7 +51,7 @@ namespace pcpp
 		int m_InterfaceIndex;
 		MacAddress m_MacAddress;
 		int m_DeviceMTU;
-		CoreConfiguration m_CoreConfiguration[MAX_NUM_OF_CORES];
+		CoreConfiguration m_CoreConfiguration[MAX_NUM_OF_CORES_IN_CORE_SET];
 		bool m_StopThread;
 		OnPfRingPacketsArriveCallback m_OnPacketsArriveCallback;
 		void* m_OnPacketsArriveUserCookie;
@@ -61,7 +61,7 @@ namespace pcpp
 
 		PfRingDevice(const char* deviceName);
 
-		bool initCoreConfigurationByCoreMask(CoreMask coreMask);
+		bool initCoreConfigurationByCoreSet(const CoreSet& coreSet);
 		static void* captureThreadMain(void *ptr);
 
 		int openSingleRxChannel(const char* deviceName, pfring** ring);
@@ -155,10 +155,10 @@ namespace pcpp
 		 * requested
 		 * @param[in] onPacketsArrive A callback to call whenever a packet arrives
 		 * @param[in] onPacketsArriveUserCookie A cookie that will be delivered to onPacketsArrive callback on every packet
-		 * @param[in] coreMask The cores to be used as mask. For example:
+		 * @param[in] coreSet The cores to run the capture threads on. A CoreMask can be passed too, but it can only represent cores 0-31
 		 * @return True if this action succeeds, false otherwise
 		 */
-		bool startCaptureMultiThread(OnPfRingPacketsArriveCallback onPacketsArrive, void* onPacketsArriveUserCookie, CoreMask coreMask);
+		bool startCaptureMultiThread(OnPfRingPacketsArriveCallback onPacketsArrive, void* onPacketsArriveUserCookie, const CoreSet& coreSet);
 
 		/**
 		 * Stops capturing packets (works will all type of startCapture*)
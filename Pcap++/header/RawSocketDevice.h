@@ -6,6 +6,11 @@
 #include "IpAddress.h"
 #include "Device.h"
 
+/**
+ * The maximum number of packets received or sent by RawSocketDevice with a single system call
+ */
+#define PCPP_RAW_SOCKET_MAX_BATCH_SIZE 32
+
 /**
 * \namespace pcpp
 * \brief The main namespace for the PcapPlusPlus lib
@@ -98,9 +103,10 @@ namespace pcpp
 		RecvPacketResult receivePacket(RawPacket& rawPacket, bool blocking = true, int timeout = -1);
 
 		/**
-		 * Receive packets into a packet vector for a certain amount of time. This method starts a timer and invokes the
-		 * receivePacket() method in blocking mode repeatedly until the timeout expires. All packets received successfully are
-		 * put into a packet vector
+		 * Receive packets into a packet vector for a certain amount of time. This method starts a timer and receives packets
+		 * repeatedly until the timeout expires. All packets received successfully are put into a packet vector. On Linux packets
+		 * are received in batches (see receivePackets(RawPacket*, int, bool, int)) and copied into the vector, on other platforms
+		 * receivePacket() is invoked in blocking mode repeatedly
 		 * @param[out] packetVec The packet vector to add the received packet to
 		 * @param[in] timeout Timeout in seconds to receive packets on the raw socket
 		 * @param[out] failedRecv Number of receive attempts that failed
@@ -108,6 +114,23 @@ namespace pcpp
 		 */
 		int receivePackets(RawPacketVector& packetVec, int timeout, int& failedRecv);
 
+		/**
+		 * Receive a batch of packets into an array of RawPacket objects. On Linux all packets waiting on the socket (up to the array
+		 * length) are received with a single recvmmsg() system call into a buffer pool that is allocated once per device. The RawPacket
+		 * objects point directly into the pool, so no memory is allocated or copied per packet, but their data is valid only until the
+		 * next call to this method or until the device is closed. On Windows packets are received one at a time with receivePacket()
+		 * and each RawPacket object owns its data
+		 * @param[out] rawPacketsArr An array of RawPacket objects to write the received packets to
+		 * @param[in] rawPacketArrLength The length of the array. At most PCPP_RAW_SOCKET_MAX_BATCH_SIZE packets are received in
+		 * one call
+		 * @param[in] blocking Indicates whether to wait for packets if none are waiting on the socket. Default value is blocking
+		 * @param[in] timeout When in blocking mode, specifies the timeout [in seconds] to wait for the first packet. Zero or
+		 * negative values mean no timeout. The default value is no timeout
+		 * @return The number of packets received, 0 if the timeout expired or if in non-blocking mode and no packets were waiting,
+		 * or -1 if an error occurred such as device is not opened. A log message will be followed specifying the error
+		 */
+		int receivePackets(RawPacket* rawPacketsArr, int rawPacketArrLength, bool blocking = true, int timeout = -1);
+
 		/**
 		 * Send an Ethernet packet to the network. L2 protocols other than Ethernet are not supported in raw sockets.
 		 * The entire packet is sent as is, including the original Ethernet and IP data.
@@ -123,7 +146,8 @@ namespace pcpp
 		 * Send a set of Ethernet packets to the network. L2 protocols other than Ethernet are not supported by raw sockets.
 		 * The entire packet is sent as is, including the original Ethernet and IP data.
 		 * This method is only supported in Linux as Windows doesn't allow sending packets from raw sockets. Using it from
-		 * other platforms will return "false" with an appropriate error log message
+		 * other platforms will return "false" with an appropriate error log message. On Linux packets are sent in batches of up to
+		 * PCPP_RAW_SOCKET_MAX_BATCH_SIZE with a single sendmmsg() system call
 		 * @param[in] packetVec The set of packets to send
 		 * @return The number of packets sent successfully. For packets that weren't sent successfully there will be a
 		 * corresponding error message printed to log
@@ -157,6 +181,7 @@ namespace pcpp
 		IPAddress m_InterfaceIP;
 
 		RecvPacketResult getError(int& errorCode) const;
+		int receivePacketBatch(int maxPackets, int timeoutMs, timespec& timestamp);
 
 	};
 }
@@ -0,0 +1,551 @@
+#ifdef LINUX
+
+#define LOG_MODULE PcapLogModuleAfPacketDevice
+
+#include "AfPacketDevice.h"
+#include "LinuxNicInformationSocket.h"
+#include "PcapFilter.h"
+#include "Logger.h"
+#include <pcap.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#define AF_PACKET_FRAME_SIZE 2048
+// how long capture threads wait for a block before checking if capture was stopped
+#define AF_PACKET_THREAD_POLL_TIMEOUT 100
+
+namespace pcpp
+{
+
+// used for choosing a different fanout group for every device in the process
+static volatile uint32_t FanoutGroupCounter = 0;
+
+// ring statistics are updated by the capture threads and read by any thread calling getStatistics(), so they're accessed atomically
+static inline void addToCounter(uint64_t& counter, uint64_t value)
+{
+	__sync_fetch_and_add(&counter, value);
+}
+
+static inline uint64_t readCounter(uint64_t& counter)
+{
+	return __sync_fetch_and_add(&counter, 0);
+}
+
+AfPacketDevice::AfPacketConfig::AfPacketConfig()
+{
+	blockSize = PCPP_AF_PACKET_DEFAULT_BLOCK_SIZE;
+	numOfBlocks = PCPP_AF_PACKET_DEFAULT_NUM_OF_BLOCKS;
+	blockTimeout = PCPP_AF_PACKET_DEFAULT_BLOCK_TIMEOUT;
+	numOfRings = 1;
+	fanoutMode = FanoutHash;
+	fanoutGroupId = 0;
+	promiscuous = true;
+}
+
+AfPacketDevice::AfPacketDevice(const std::string& interfaceName, const AfPacketConfig& config) :
+	m_InterfaceName(interfaceName), m_Config(config), m_LinkType(LINKTYPE_ETHERNET), m_StopThreads(false),
+	m_OnPacketsArrive(NULL), m_OnPacketsArriveUserCookie(NULL)
+{
+}
+
+AfPacketDevice::~AfPacketDevice()
+{
+	close();
+}
+
+bool AfPacketDevice::open()
+{
+	if (m_DeviceOpened)
+	{
+		LOG_ERROR("Device '%s' is already opened", m_InterfaceName.c_str());
+		return false;
+	}
+
+	if (m_Config.numOfRings == 0 || m_Config.numOfRings > PCPP_AF_PACKET_MAX_NUM_OF_RINGS)
+	{
+		LOG_ERROR("Number of rings must be between 1 and %d", PCPP_AF_PACKET_MAX_NUM_OF_RINGS);
+		return false;
+	}
+
+	if (m_Config.numOfBlocks == 0 || m_Config.blockSize == 0 || m_Config.blockSize % getpagesize() != 0)
+	{
+		LOG_ERROR("Block size must be a multiple of the page size (%d) and the number of blocks must be positive", getpagesize());
+		return false;
+	}
+
+	int interfaceIndex = if_nametoindex(m_InterfaceName.c_str());
+	if (interfaceIndex == 0)
+	{
+		LOG_ERROR("Cannot find interface '%s'", m_InterfaceName.c_str());
+		return false;
+	}
+
+	// the link type is determined by the hardware type of the interface
+	LinuxNicInformationSocket nicSocket;
+	struct ifreq ifr;
+	memset(&ifr, 0, sizeof(ifr));
+	if (!nicSocket.makeRequest(m_InterfaceName.c_str(), SIOCGIFHWADDR, &ifr))
+	{
+		LOG_ERROR("Cannot get the hardware type of interface '%s'", m_InterfaceName.c_str());
+		return false;
+	}
+
+	switch (ifr.ifr_hwaddr.sa_family)
+	{
+	case ARPHRD_ETHER:
+	case ARPHRD_LOOPBACK:
+		m_LinkType = LINKTYPE_ETHERNET;
+		break;
+	case ARPHRD_NONE:
+		m_LinkType = LINKTYPE_RAW;
+		break;
+	default:
+		LOG_ERROR("Hardware type %d of interface '%s' isn't supported", (int)ifr.ifr_hwaddr.sa_family, m_InterfaceName.c_str());
+		return false;
+	}
+
+	uint16_t fanoutGroupId = m_Config.fanoutGroupId;
+	if (fanoutGroupId == 0)
+		fanoutGroupId = (uint16_t)((getpid() + __sync_fetch_and_add(&FanoutGroupCounter, 1)) & 0xffff);
+
+	m_Rings.resize(m_Config.numOfRings);
+	for (size_t i = 0; i < m_Rings.size(); i++)
+	{
+		if (!openRing(m_Rings[i], interfaceIndex, fanoutGroupId))
+		{
+			for (size_t j = 0; j < i; j++)
+				closeRing(m_Rings[j]);
+			m_Rings.clear();
+			return false;
+		}
+	}
+
+	LOG_DEBUG("Opened %d rings on interface '%s'", (int)m_Rings.size(), m_InterfaceName.c_str());
+	m_DeviceOpened = true;
+	return true;
+}
+
+bool AfPacketDevice::openRing(Ring& ring, int interfaceIndex, uint16_t fanoutGroupId)
+{
+	memset(&ring, 0, sizeof(ring));
+
+	ring.fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+	if (ring.fd < 0)
+	{
+		LOG_ERROR("Failed to create AF_PACKET socket: '%s'. Capturing requires the CAP_NET_RAW capability", strerror(errno));
+		return false;
+	}
+
+	int version = TPACKET_V3;
+	if (setsockopt(ring.fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+	{
+		LOG_ERROR("Failed to set TPACKET_V3: '%s'", strerror(errno));
+		::close(ring.fd);
+		return false;
+	}
+
+	struct tpacket_req3 req;
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = m_Config.blockSize;
+	req.tp_block_nr = m_Config.numOfBlocks;
+	req.tp_frame_size = AF_PACKET_FRAME_SIZE;
+	req.tp_frame_nr = (m_Config.blockSize / AF_PACKET_FRAME_SIZE) * m_Config.numOfBlocks;
+	req.tp_retire_blk_tov = m_Config.blockTimeout;
+	req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+	if (setsockopt(ring.fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+	{
+		LOG_ERROR("Failed to create the RX ring: '%s'", strerror(errno));
+		::close(ring.fd);
+		return false;
+	}
+
+	ring.memorySize = (size_t)m_Config.blockSize * m_Config.numOfBlocks;
+	void* memory = mmap(NULL, ring.memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, ring.fd, 0);
+	if (memory == MAP_FAILED)
+	{
+		LOG_ERROR("Failed to map the RX ring: '%s'", strerror(errno));
+		::close(ring.fd);
+		return false;
+	}
+	ring.memory = (uint8_t*)memory;
+
+	struct sockaddr_ll addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sll_family = AF_PACKET;
+	addr.sll_protocol = htons(ETH_P_ALL);
+	addr.sll_ifindex = interfaceIndex;
+	if (bind(ring.fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+	{
+		LOG_ERROR("Failed to bind to interface '%s': '%s'", m_InterfaceName.c_str(), strerror(errno));
+		closeRing(ring);
+		return false;
+	}
+
+	if (m_Config.promiscuous)
+	{
+		struct packet_mreq mreq;
+		memset(&mreq, 0, sizeof(mreq));
+		mreq.mr_ifindex = interfaceIndex;
+		mreq.mr_type = PACKET_MR_PROMISC;
+		if (setsockopt(ring.fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+		{
+			LOG_ERROR("Failed to set promiscuous mode: '%s'", strerror(errno));
+			closeRing(ring);
+			return false;
+		}
+	}
+
+	// a single ring joins a fanout group only if the user asked for a specific group, for sharing packets with other devices
+	if (m_Config.numOfRings > 1 || m_Config.fanoutGroupId != 0)
+	{
+		int fanoutMode;
+		switch (m_Config.fanoutMode)
+		{
+		case FanoutLoadBalance:
+			fanoutMode = PACKET_FANOUT_LB;
+			break;
+		case FanoutCpu:
+			fanoutMode = PACKET_FANOUT_CPU;
+			break;
+		case FanoutQueueMapping:
+			fanoutMode = PACKET_FANOUT_QM;
+			break;
+		default:
+			// defragment so all fragments of a packet are hashed to the same ring
+			fanoutMode = PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+			break;
+		}
+
+		int fanoutArg = fanoutGroupId | (fanoutMode << 16);
+		if (setsockopt(ring.fd, SOL_PACKET, PACKET_FANOUT, &fanoutArg, sizeof(fanoutArg)) < 0)
+		{
+			LOG_ERROR("Failed to join fanout group %d: '%s'", (int)fanoutGroupId, strerror(errno));
+			closeRing(ring);
+			return false;
+		}
+	}
+
+	// every packet in a block takes at least an aligned packet header
+	ring.maxPacketsPerBlock = m_Config.blockSize / TPACKET_ALIGN(sizeof(struct tpacket3_hdr));
+	ring.packets = new RawPacket[ring.maxPacketsPerBlock];
+
+	return true;
+}
+
+void AfPacketDevice::closeRing(Ring& ring)
+{
+	if (ring.memory != NULL)
+		munmap(ring.memory, ring.memorySize);
+	if (ring.fd >= 0)
+		::close(ring.fd);
+	delete [] ring.packets;
+
+	ring.memory = NULL;
+	ring.fd = -1;
+	ring.packets = NULL;
+}
+
+void AfPacketDevice::close()
+{
+	if (!m_DeviceOpened)
+		return;
+
+	stopCapture();
+
+	for (std::vector<Ring>::iterator iter = m_Rings.begin(); iter != m_Rings.end(); ++iter)
+		closeRing(*iter);
+
+	m_Rings.clear();
+	m_DeviceOpened = false;
+	LOG_DEBUG("Device '%s' closed", m_InterfaceName.c_str());
+}
+
+int AfPacketDevice::receivePackets(uint8_t ringId, OnAfPacketPacketsArriveCallback onPacketsArrive, void* userCookie, int timeout)
+{
+	if (!m_DeviceOpened)
+	{
+		LOG_ERROR("Device '%s' isn't opened", m_InterfaceName.c_str());
+		return -1;
+	}
+
+	if (ringId >= m_Rings.size())
+	{
+		LOG_ERROR("Ring %d doesn't exist", (int)ringId);
+		return -1;
+	}
+
+	if (onPacketsArrive == NULL)
+	{
+		LOG_ERROR("Callback is NULL");
+		return -1;
+	}
+
+	Ring& ring = m_Rings[ringId];
+	struct tpacket_block_desc* block = (struct tpacket_block_desc*)(ring.memory + (size_t)ring.currentBlock * m_Config.blockSize);
+
+	if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+	{
+		if (timeout == 0)
+			return 0;
+
+		struct pollfd pfd;
+		pfd.fd = ring.fd;
+		pfd.events = POLLIN | POLLERR;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, timeout) < 0 && errno != EINTR)
+		{
+			LOG_ERROR("Polling ring %d failed: '%s'", (int)ringId, strerror(errno));
+			return -1;
+		}
+
+		if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+			return 0;
+	}
+
+	// make sure the block content is read only after its status
+	__sync_synchronize();
+
+	uint32_t numOfPackets = block->hdr.bh1.num_pkts;
+	if (numOfPackets > ring.maxPacketsPerBlock)
+		numOfPackets = ring.maxPacketsPerBlock;
+
+	uint64_t numOfBytes = 0;
+	uint8_t* packetHeader = (uint8_t*)block + block->hdr.bh1.offset_to_first_pkt;
+	for (uint32_t i = 0; i < numOfPackets; i++)
+	{
+		struct tpacket3_hdr* header = (struct tpacket3_hdr*)packetHeader;
+		timespec ts;
+		ts.tv_sec = header->tp_sec;
+		ts.tv_nsec = header->tp_nsec;
+		ring.packets[i].initWithRawData(packetHeader + header->tp_mac, header->tp_snaplen, ts, false, m_LinkType, header->tp_len);
+		numOfBytes += header->tp_snaplen;
+		packetHeader += header->tp_next_offset;
+	}
+
+	if (numOfPackets > 0)
+		onPacketsArrive(ring.packets, numOfPackets, ringId, this, userCookie);
+
+	addToCounter(ring.stats.packetsDelivered, numOfPackets);
+	addToCounter(ring.stats.bytesDelivered, numOfBytes);
+	addToCounter(ring.stats.blocksDelivered, 1);
+
+	// hand the block back to the kernel only after the callback is done with its packets
+	__sync_synchronize();
+	block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	ring.currentBlock = (ring.currentBlock + 1) % m_Config.numOfBlocks;
+
+	return (int)numOfPackets;
+}
+
+void* AfPacketDevice::captureThreadMain(void* context)
+{
+	CaptureThreadContext* threadContext = (CaptureThreadContext*)context;
+	AfPacketDevice* device = threadContext->device;
+	uint8_t ringId = threadContext->ringId;
+
+	LOG_DEBUG("Starting capture thread for ring %d", (int)ringId);
+
+	while (!device->m_StopThreads)
+	{
+		if (device->receivePackets(ringId, device->m_OnPacketsArrive, device->m_OnPacketsArriveUserCookie, AF_PACKET_THREAD_POLL_TIMEOUT) < 0)
+		{
+			LOG_ERROR("Receiving packets failed, exiting capture thread of ring %d", (int)ringId);
+			break;
+		}
+	}
+
+	LOG_DEBUG("Exiting capture thread of ring %d", (int)ringId);
+	return NULL;
+}
+
+bool AfPacketDevice::startCapture(OnAfPacketPacketsArriveCallback onPacketsArrive, void* onPacketsArriveUserCookie, const CoreSet& coreSet)
+{
+	if (!m_DeviceOpened)
+	{
+		LOG_ERROR("Device '%s' isn't opened", m_InterfaceName.c_str());
+		return false;
+	}
+
+	if (captureActive())
+	{
+		LOG_ERROR("Capture is already running on device '%s'", m_InterfaceName.c_str());
+		return false;
+	}
+
+	if (onPacketsArrive == NULL)
+	{
+		LOG_ERROR("Callback is NULL");
+		return false;
+	}
+
+	m_OnPacketsArrive = onPacketsArrive;
+	m_OnPacketsArriveUserCookie = onPacketsArriveUserCookie;
+	m_StopThreads = false;
+
+	std::vector<int> cores;
+	coreSet.getCoreIds(cores);
+
+	// the contexts must not move after threads start using them
+	m_CaptureThreadContexts.resize(m_Rings.size());
+	for (size_t i = 0; i < m_Rings.size(); i++)
+	{
+		m_CaptureThreadContexts[i].device = this;
+		m_CaptureThreadContexts[i].ringId = (uint8_t)i;
+
+		pthread_t thread;
+		int err = pthread_create(&thread, NULL, captureThreadMain, &m_CaptureThreadContexts[i]);
+		if (err != 0)
+		{
+			LOG_ERROR("Cannot create capture thread for ring %d. Error was: %d", (int)i, err);
+			stopCapture();
+			return false;
+		}
+		m_CaptureThreads.push_back(thread);
+
+		if (!cores.empty())
+		{
+			int coreId = cores[i % cores.size()];
+			cpu_set_t cpuset;
+			CPU_ZERO(&cpuset);
+			CPU_SET(coreId, &cpuset);
+			if ((err = pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset)) != 0)
+				LOG_ERROR("Cannot pin the capture thread of ring %d to core %d. Error was: %d", (int)i, coreId, err);
+		}
+	}
+
+	LOG_DEBUG("Capture started on device '%s' with %d threads", m_InterfaceName.c_str(), (int)m_CaptureThreads.size());
+	return true;
+}
+
+void AfPacketDevice::stopCapture()
+{
+	if (!captureActive())
+		return;
+
+	m_StopThreads = true;
+	for (std::vector<pthread_t>::iterator iter = m_CaptureThreads.begin(); iter != m_CaptureThreads.end(); ++iter)
+		pthread_join(*iter, NULL);
+
+	m_CaptureThreads.clear();
+	m_CaptureThreadContexts.clear();
+	LOG_DEBUG("Capture stopped on device '%s'", m_InterfaceName.c_str());
+}
+
+void AfPacketDevice::updateKernelStatistics(Ring& ring)
+{
+	// the kernel resets its counters every time they're read, so they're accumulated here
+	struct tpacket_stats_v3 kernelStats;
+	socklen_t len = sizeof(kernelStats);
+	if (getsockopt(ring.fd, SOL_PACKET, PACKET_STATISTICS, &kernelStats, &len) < 0)
+	{
+		LOG_ERROR("Cannot get ring statistics: '%s'", strerror(errno));
+		return;
+	}
+
+	addToCounter(ring.stats.packetsReceived, kernelStats.tp_packets);
+	addToCounter(ring.stats.packetsDropped, kernelStats.tp_drops);
+	addToCounter(ring.stats.freezeQueueCount, kernelStats.tp_freeze_q_cnt);
+}
+
+void AfPacketDevice::getRingStatistics(uint8_t ringId, AfPacketStats& stats)
+{
+	memset(&stats, 0, sizeof(stats));
+
+	if (ringId >= m_Rings.size())
+	{
+		LOG_ERROR("Ring %d doesn't exist", (int)ringId);
+		return;
+	}
+
+	Ring& ring = m_Rings[ringId];
+	updateKernelStatistics(ring);
+	stats.packetsReceived = readCounter(ring.stats.packetsReceived);
+	stats.packetsDropped = readCounter(ring.stats.packetsDropped);
+	stats.freezeQueueCount = readCounter(ring.stats.freezeQueueCount);
+	stats.packetsDelivered = readCounter(ring.stats.packetsDelivered);
+	stats.bytesDelivered = readCounter(ring.stats.bytesDelivered);
+	stats.blocksDelivered = readCounter(ring.stats.blocksDelivered);
+}
+
+void AfPacketDevice::getStatistics(AfPacketStats& stats)
+{
+	memset(&stats, 0, sizeof(stats));
+
+	for (size_t i = 0; i < m_Rings.size(); i++)
+	{
+		AfPacketStats ringStats;
+		getRingStatistics((uint8_t)i, ringStats);
+		stats.packetsReceived += ringStats.packetsReceived;
+		stats.packetsDropped += ringStats.packetsDropped;
+		stats.freezeQueueCount += ringStats.freezeQueueCount;
+		stats.packetsDelivered += ringStats.packetsDelivered;
+		stats.bytesDelivered += ringStats.bytesDelivered;
+		stats.blocksDelivered += ringStats.blocksDelivered;
+	}
+}
+
+bool AfPacketDevice::setFilter(std::string filterAsString)
+{
+	if (!m_DeviceOpened)
+	{
+		LOG_ERROR("Device '%s' isn't opened, cannot set filter", m_InterfaceName.c_str());
+		return false;
+	}
+
+	struct bpf_program prog;
+	LOG_DEBUG("Compiling the filter '%s'", filterAsString.c_str());
+	if (!compileBpfFilter(filterAsString, m_LinkType, 65535, &prog))
+	{
+		LOG_ERROR("Error compiling filter '%s'", filterAsString.c_str());
+		return false;
+	}
+
+	// the kernel socket filter uses the same instruction format as libpcap
+	struct sock_fprog socketFilter;
+	socketFilter.len = (unsigned short)prog.bf_len;
+	socketFilter.filter = (struct sock_filter*)prog.bf_insns;
+
+	bool result = true;
+	for (std::vector<Ring>::iterator iter = m_Rings.begin(); iter != m_Rings.end(); ++iter)
+	{
+		if (setsockopt(iter->fd, SOL_SOCKET, SO_ATTACH_FILTER, &socketFilter, sizeof(socketFilter)) < 0)
+		{
+			LOG_ERROR("Failed to attach the filter to a ring: '%s'", strerror(errno));
+			result = false;
+		}
+	}
+
+	pcap_freecode(&prog);
+	return result;
+}
+
+bool AfPacketDevice::clearFilter()
+{
+	bool result = true;
+	for (std::vector<Ring>::iterator iter = m_Rings.begin(); iter != m_Rings.end(); ++iter)
+	{
+		int dummy = 0;
+		if (setsockopt(iter->fd, SOL_SOCKET, SO_DETACH_FILTER, &dummy, sizeof(dummy)) < 0 && errno != ENOENT)
+		{
+			LOG_ERROR("Failed to detach the filter from a ring: '%s'", strerror(errno));
+			result = false;
+		}
+	}
+
+	return result;
+}
+
+} // namespace pcpp
+
+#endif // LINUX
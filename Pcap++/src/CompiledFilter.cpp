@@ -0,0 +1,95 @@
+#define LOG_MODULE PcapLogModuleLiveDevice
+
+#include "CompiledFilter.h"
+#include "Logger.h"
+#if defined(WINx64)
+#include <winsock2.h>
+#endif
+#include <pcap.h>
+
+namespace pcpp
+{
+
+CompiledFilter::CompiledFilter(const std::string& filterAsString, LinkLayerType linkType, int snapshotLength) :
+	m_BpfProgram(NULL), m_FilterAsString(filterAsString), m_LinkType(linkType), m_IsValid(false)
+{
+	compileBpf(snapshotLength);
+}
+
+CompiledFilter::CompiledFilter(GeneralFilter& filter, LinkLayerType linkType, int snapshotLength) :
+	m_BpfProgram(NULL), m_LinkType(linkType), m_IsValid(false)
+{
+	filter.parseToString(m_FilterAsString);
+
+	// native programs assume an Ethernet header
+	if (linkType == LINKTYPE_ETHERNET && m_NativeProgram.compile(filter))
+	{
+		m_IsValid = true;
+		return;
+	}
+
+	compileBpf(snapshotLength);
+}
+
+CompiledFilter::~CompiledFilter()
+{
+	if (m_BpfProgram != NULL)
+	{
+		pcap_freecode(m_BpfProgram);
+		delete m_BpfProgram;
+	}
+}
+
+void CompiledFilter::compileBpf(int snapshotLength)
+{
+	// as in libpcap, an empty filter matches all packets
+	if (m_FilterAsString.empty())
+	{
+		m_IsValid = true;
+		return;
+	}
+
+	m_BpfProgram = new bpf_program();
+
+	LOG_DEBUG("Compiling the filter '%s'", m_FilterAsString.c_str());
+	if (!compileBpfFilter(m_FilterAsString, m_LinkType, snapshotLength, m_BpfProgram))
+	{
+		LOG_ERROR("Error compiling filter '%s'", m_FilterAsString.c_str());
+		delete m_BpfProgram;
+		m_BpfProgram = NULL;
+		return;
+	}
+
+	m_IsValid = true;
+}
+
+bool CompiledFilter::match(const uint8_t* data, size_t capturedLen, size_t frameLen) const
+{
+	if (!m_IsValid || data == NULL)
+		return false;
+
+	if (m_NativeProgram.isCompiled())
+		return m_NativeProgram.matchPacket(data, capturedLen);
+
+	// an empty filter
+	if (m_BpfProgram == NULL)
+		return true;
+
+	// bpf_filter() keeps its state on the stack, so the same program can be run by several threads at once
+	struct pcap_pkthdr pktHdr;
+	pktHdr.caplen = (bpf_u_int32)capturedLen;
+	pktHdr.len = (bpf_u_int32)(frameLen < capturedLen ? capturedLen : frameLen);
+	pktHdr.ts.tv_sec = 0;
+	pktHdr.ts.tv_usec = 0;
+	return (pcap_offline_filter(m_BpfProgram, &pktHdr, data) != 0);
+}
+
+bool CompiledFilter::match(const RawPacket* rawPacket) const
+{
+	if (rawPacket == NULL || rawPacket->getRawDataLen() < 0)
+		return false;
+
+	return match(rawPacket->getRawData(), (size_t)rawPacket->getRawDataLen(), (size_t)rawPacket->getFrameLength());
+}
+
+} // namespace pcpp
@@ -106,6 +106,11 @@ uint32_t DpdkDevice::getCurrentCoreId() const
 	return rte_lcore_id();
 }
 
+int DpdkDevice::getNumaNode() const
+{
+	return rte_eth_dev_socket_id(m_Id);
+}
+
 bool DpdkDevice::setMtu(uint16_t newMtu)
 {
 	int res = rte_eth_dev_set_mtu(m_Id, newMtu);
@@ -389,7 +394,7 @@ bool DpdkDevice::startDevice()
 
 void DpdkDevice::clearCoreConfiguration()
 {
-	for (int i = 0; i < MAX_NUM_OF_CORES; i++)
+	for (int i = 0; i < MAX_NUM_OF_CORES_IN_CORE_SET; i++)
 	{
 		m_CoreConfiguration[i].IsCoreInUse = false;
 	}
@@ -398,7 +403,7 @@ void DpdkDevice::clearCoreConfiguration()
 int DpdkDevice::getCoresInUseCount() const
 {
 	int res = 0;
-	for (int i = 0; i < MAX_NUM_OF_CORES; i++)
+	for (int i = 0; i < MAX_NUM_OF_CORES_IN_CORE_SET; i++)
 		if (m_CoreConfiguration[i].IsCoreInUse)
 			res++;
 
@@ -497,40 +502,27 @@ void DpdkDevice::getLinkStatus(LinkStatus& linkStatus) const
 }
 
 
-bool DpdkDevice::initCoreConfigurationByCoreMask(CoreMask coreMask)
+bool DpdkDevice::initCoreConfigurationByCoreSet(const CoreSet& coreSet)
 {
-	int i = 0;
-	int numOfCores = getNumOfCores();
+	int masterCore = DpdkDeviceList::getInstance().getDpdkMasterCore().Id;
 	clearCoreConfiguration();
-	while ((coreMask != 0) && (i < numOfCores))
+	for (int coreId = coreSet.getFirstCore(); coreId >= 0; coreId = coreSet.getNextCore(coreId))
 	{
-		if (coreMask & 1)
+		if (coreId == masterCore)
 		{
-			if (i == DpdkDeviceList::getInstance().getDpdkMasterCore().Id)
-			{
-				LOG_ERROR("Core %d is the master core, you can't use it for capturing threads", i);
-				clearCoreConfiguration();
-				return false;
-			}
-
-			if (!rte_lcore_is_enabled(i))
-			{
-				LOG_ERROR("Trying to use core #%d which isn't initialized by DPDK", i);
-				clearCoreConfiguration();
-				return false;
-			}
-			m_CoreConfiguration[i].IsCoreInUse = true;
+			LOG_ERROR("Core %d is the master core, you can't use it for capturing threads", coreId);
+			clearCoreConfiguration();
+			return false;
 		}
 
-		coreMask = coreMask >> 1;
-		i++;
-	}
-
-	if (coreMask != 0) // this mean coreMask contains a core that doesn't exist
-	{
-		LOG_ERROR("Trying to use a core [%d] that doesn't exist while machine has %d cores", i, numOfCores);
-		clearCoreConfiguration();
-		return false;
+		// this also fails for cores that don't exist
+		if (!rte_lcore_is_enabled(coreId))
+		{
+			LOG_ERROR("Trying to use core #%d which isn't initialized by DPDK", coreId);
+			clearCoreConfiguration();
+			return false;
+		}
+		m_CoreConfiguration[coreId].IsCoreInUse = true;
 	}
 
 	return true;
@@ -560,7 +552,7 @@ bool DpdkDevice::startCaptureSingleThread(OnDpdkPacketsArriveCallback onPacketsA
 
 	m_StopThread = false;
 
-	for (int coreId = 0; coreId < MAX_NUM_OF_CORES; coreId++)
+	for (int coreId = 0; coreId < MAX_NUM_OF_CORES_IN_CORE_SET; coreId++)
 	{
 		if (coreId == (int)rte_get_master_lcore() || !rte_lcore_is_enabled(coreId))
 			continue;
@@ -585,7 +577,7 @@ bool DpdkDevice::startCaptureSingleThread(OnDpdkPacketsArriveCallback onPacketsA
 	return false;
 }
 
-bool DpdkDevice::startCaptureMultiThreads(OnDpdkPacketsArriveCallback onPacketsArrive, void* onPacketsArriveUserCookie, CoreMask coreMask)
+bool DpdkDevice::startCaptureMultiThreads(OnDpdkPacketsArriveCallback onPacketsArrive, void* onPacketsArriveUserCookie, const CoreSet& coreSet)
 {
 	if (!m_DeviceOpened)
 	{
@@ -593,19 +585,19 @@ bool DpdkDevice::startCaptureMultiThreads(OnDpdkPacketsArriveCallback onPacketsA
 		return false;
 	}
 
-	if (!initCoreConfigurationByCoreMask(coreMask))
+	if (!initCoreConfigurationByCoreSet(coreSet))
 		return false;
 
 	if (m_NumOfRxQueuesOpened != getCoresInUseCount())
 	{
-		LOG_ERROR("Cannot use a different number of queues and cores. Opened %d queues but set %d cores in core mask", m_NumOfRxQueuesOpened, getCoresInUseCount());
+		LOG_ERROR("Cannot use a different number of queues and cores. Opened %d queues but set %d cores in core set", m_NumOfRxQueuesOpened, getCoresInUseCount());
 		clearCoreConfiguration();
 		return false;
 	}
 
 	m_StopThread = false;
 	int rxQueue = 0;
-	for (int coreId = 0; coreId < MAX_NUM_OF_CORES; coreId++)
+	for (int coreId = 0; coreId < MAX_NUM_OF_CORES_IN_CORE_SET; coreId++)
 	{
 		if (!m_CoreConfiguration[coreId].IsCoreInUse)
 			continue;
@@ -631,7 +623,7 @@ void DpdkDevice::stopCapture()
 {
 	LOG_DEBUG("Trying to stop capturing on device [%s]", m_DeviceName);
 	m_StopThread = true;
-	for (int coreId = 0; coreId < MAX_NUM_OF_CORES; coreId++)
+	for (int coreId = 0; coreId < MAX_NUM_OF_CORES_IN_CORE_SET; coreId++)
 	{
 		if (!m_CoreConfiguration[coreId].IsCoreInUse)
 			continue;
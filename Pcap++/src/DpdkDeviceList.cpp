@@ -44,7 +44,7 @@ namespace pcpp
 {
 
 bool DpdkDeviceList::m_IsDpdkInitialized = false;
-CoreMask DpdkDeviceList::m_CoreMask = 0;
+CoreSet DpdkDeviceList::m_CoreSet;
 uint32_t DpdkDeviceList::m_MBufPoolSizePerDevice = 0;
 
 DpdkDeviceList::DpdkDeviceList()
@@ -63,22 +63,27 @@ DpdkDeviceList::~DpdkDeviceList()
 }
 
 const uint32_t initDpdkArgc = 7;
-const uint32_t maxArgLen = 20;
 char** initDpdkArgv;
 
-bool DpdkDeviceList::initDpdk(CoreMask coreMask, uint32_t mBufPoolSizePerDevice, uint8_t masterCore)
+bool DpdkDeviceList::initDpdk(const CoreSet& coreSet, uint32_t mBufPoolSizePerDevice, uint8_t masterCore)
 {
 	if (m_IsDpdkInitialized)
 	{
-		if (coreMask == m_CoreMask)
+		if (coreSet == m_CoreSet)
 			return true;
 		else
 		{
-			LOG_ERROR("Trying to re-initialize DPDK with a different core mask");
+			LOG_ERROR("Trying to re-initialize DPDK with a different core set");
 			return false;
 		}
 	}
 
+	if (coreSet.isEmpty())
+	{
+		LOG_ERROR("Cannot initialize DPDK with an empty core set");
+		return false;
+	}
+
 	if (!verifyHugePagesAndDpdkDriver())
 	{
 		return false;
@@ -97,8 +102,9 @@ bool DpdkDeviceList::initDpdk(CoreMask coreMask, uint32_t mBufPoolSizePerDevice,
 	dpdkParamsStream << "pcapplusplusapp ";
 	dpdkParamsStream << "-n ";
 	dpdkParamsStream << "2 ";
-	dpdkParamsStream << "-c ";
-	dpdkParamsStream << "0x" << std::hex << std::setw(2) << std::setfill('0') << coreMask << " ";
+	// a core list (e.g "1-3,40") rather than a hex core mask, so cores above 63 can be used too
+	dpdkParamsStream << "-l ";
+	dpdkParamsStream << coreSet.toString() << " ";
 	dpdkParamsStream << "--master-lcore ";
 	dpdkParamsStream << (int)masterCore;
 
@@ -107,7 +113,7 @@ bool DpdkDeviceList::initDpdk(CoreMask coreMask, uint32_t mBufPoolSizePerDevice,
 	uint32_t i = 0;
     while (dpdkParamsStream.good() && i < initDpdkArgc){
     	dpdkParamsStream >> dpdkParamsArray[i];
-    	initDpdkArgv[i] = new char[maxArgLen];
+    	initDpdkArgv[i] = new char[dpdkParamsArray[i].length() + 1];
     	strcpy(initDpdkArgv[i], dpdkParamsArray[i].c_str());
         i++;
     }
@@ -135,7 +141,7 @@ bool DpdkDeviceList::initDpdk(CoreMask coreMask, uint32_t mBufPoolSizePerDevice,
 
 	delete [] initDpdkArgv;
 
-	m_CoreMask = coreMask;
+	m_CoreSet = coreSet;
 	m_IsDpdkInitialized = true;
 
 	m_MBufPoolSizePerDevice = mBufPoolSizePerDevice;
@@ -251,7 +257,7 @@ bool DpdkDeviceList::verifyHugePagesAndDpdkDriver()
 
 SystemCore DpdkDeviceList::getDpdkMasterCore() const
 {
-	return SystemCores::IdToSystemCore[rte_get_master_lcore()];
+	return getSystemCoreById(rte_get_master_lcore());
 }
 
 void DpdkDeviceList::setDpdkLogLevel(LoggerPP::LogLevel logLevel)
@@ -293,7 +299,7 @@ int DpdkDeviceList::dpdkWorkerThreadStart(void *ptr)
 	return 0;
 }
 
-bool DpdkDeviceList::startDpdkWorkerThreads(CoreMask coreMask, std::vector<DpdkWorkerThread*>& workerThreadsVec)
+bool DpdkDeviceList::startDpdkWorkerThreads(const CoreSet& coreSet, std::vector<DpdkWorkerThread*>& workerThreadsVec)
 {
 	if (!isInitialized())
 	{
@@ -301,70 +307,54 @@ bool DpdkDeviceList::startDpdkWorkerThreads(CoreMask coreMask, std::vector<DpdkW
 		return false;
 	}
 
-	CoreMask tempCoreMask = coreMask;
-	size_t numOfCoresInMask = 0;
-	int coreNum = 0;
-	while (tempCoreMask > 0)
+	for (int coreId = coreSet.getFirstCore(); coreId >= 0; coreId = coreSet.getNextCore(coreId))
 	{
-		if (tempCoreMask & 1)
+		if (!rte_lcore_is_enabled(coreId))
 		{
-			if (!rte_lcore_is_enabled(coreNum))
-			{
-				LOG_ERROR("Trying to use core #%d which isn't initialized by DPDK", coreNum);
-				return false;
-			}
-
-			numOfCoresInMask++;
+			LOG_ERROR("Trying to use core #%d which isn't initialized by DPDK", coreId);
+			return false;
 		}
-		tempCoreMask = tempCoreMask >> 1;
-		coreNum++;
 	}
 
-	if (numOfCoresInMask == 0)
+	size_t numOfCoresInSet = coreSet.getCoreCount();
+	if (numOfCoresInSet == 0)
 	{
-		LOG_ERROR("Number of cores in mask is 0");
+		LOG_ERROR("Number of cores in core set is 0");
 		return false;
 	}
 
-	if (numOfCoresInMask != workerThreadsVec.size())
+	if (numOfCoresInSet != workerThreadsVec.size())
 	{
-		LOG_ERROR("Number of cores in core mask different from workerThreadsVec size");
+		LOG_ERROR("Number of cores in core set different from workerThreadsVec size");
 		return false;
 	}
 
-	if (coreMask & getDpdkMasterCore().Mask)
+	if (coreSet.containsCore(getDpdkMasterCore().Id))
 	{
 		LOG_ERROR("Cannot run worker thread on DPDK master core");
 		return false;
 	}
 
 	m_WorkerThreads.clear();
-	uint32_t index = 0;
+	int coreId = coreSet.getFirstCore();
 	std::vector<DpdkWorkerThread*>::iterator iter = workerThreadsVec.begin();
 	while (iter != workerThreadsVec.end())
 	{
-		SystemCore core = SystemCores::IdToSystemCore[index];
-		if (!(coreMask & core.Mask))
-		{
-			index++;
-			continue;
-		}
-
-		int err = rte_eal_remote_launch(dpdkWorkerThreadStart, *iter, core.Id);
+		int err = rte_eal_remote_launch(dpdkWorkerThreadStart, *iter, coreId);
 		if (err != 0)
 		{
 			for (std::vector<DpdkWorkerThread*>::iterator iter2 = workerThreadsVec.begin(); iter2 != iter; iter2++)
 			{
-				(*iter)->stop();
-				rte_eal_wait_lcore((*iter)->getCoreId());
-				LOG_DEBUG("Thread on core [%d] stopped", (*iter)->getCoreId());
+				(*iter2)->stop();
+				rte_eal_wait_lcore((*iter2)->getCoreId());
+				LOG_DEBUG("Thread on core [%d] stopped", (*iter2)->getCoreId());
 			}
-			LOG_ERROR("Cannot create worker thread #%d. Error was: [%s]", core.Id, strerror(err));
+			LOG_ERROR("Cannot create worker thread #%d. Error was: [%s]", coreId, strerror(err));
 			return false;
 		}
 		m_WorkerThreads.push_back(*iter);
 
-		index++;
+		coreId = coreSet.getNextCore(coreId);
 		iter++;
 	}
 
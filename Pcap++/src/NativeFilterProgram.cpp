@@ -0,0 +1,402 @@
+#define LOG_MODULE PcapLogModuleLiveDevice
+
+#include "NativeFilterProgram.h"
+#include "RawPacket.h"
+#include "IPv4Layer.h"
+#include "EthLayer.h"
+#include "Logger.h"
+#include <string.h>
+
+#define NATIVE_FILTER_ETHERTYPE_OFFSET		12
+#define NATIVE_FILTER_NETWORK_OFFSET		14
+// IPv4 and IPv6 header fields, relative to the start of the packet
+#define NATIVE_FILTER_IPV4_FRAG_OFFSET		(NATIVE_FILTER_NETWORK_OFFSET + 6)
+#define NATIVE_FILTER_IPV4_PROTOCOL_OFFSET	(NATIVE_FILTER_NETWORK_OFFSET + 9)
+#define NATIVE_FILTER_IPV6_NEXT_HDR_OFFSET	(NATIVE_FILTER_NETWORK_OFFSET + 6)
+#define NATIVE_FILTER_IPV6_PAYLOAD_OFFSET	(NATIVE_FILTER_NETWORK_OFFSET + 40)
+#define NATIVE_FILTER_IPPROTO_SCTP			132
+
+// read a field of the packet or fail the whole filter if it's beyond the end of the packet, the same as libpcap's BPF interpreter does
+#define NATIVE_FILTER_LOAD(offset, size, result) \
+	if (!loadField(data, dataLen, (offset), (size), (result))) \
+		return ResultAbort
+
+namespace pcpp
+{
+
+enum NativeFilterResult
+{
+	ResultNoMatch,
+	ResultMatch,
+	// a field was beyond the end of the packet
+	ResultAbort
+};
+
+static inline bool loadField(const uint8_t* data, size_t dataLen, size_t offset, uint8_t size, uint32_t& result)
+{
+	if (offset + size > dataLen)
+		return false;
+
+	result = 0;
+	for (uint8_t i = 0; i < size; i++)
+		result = (result << 8) | data[offset + i];
+
+	return true;
+}
+
+static inline int compareField(uint32_t field, FilterOperator op, uint32_t value)
+{
+	bool result;
+	switch (op)
+	{
+	case EQUALS:
+		result = (field == value);
+		break;
+	case NOT_EQUALS:
+		result = (field != value);
+		break;
+	case GREATER_THAN:
+		result = (field > value);
+		break;
+	case GREATER_OR_EQUAL:
+		result = (field >= value);
+		break;
+	case LESS_THAN:
+		result = (field < value);
+		break;
+	default: // LESS_OR_EQUAL
+		result = (field <= value);
+		break;
+	}
+
+	return (result ? ResultMatch : ResultNoMatch);
+}
+
+static int matchPorts(const uint8_t* data, size_t dataLen, size_t transportOffset, Direction dir, uint32_t fromPort, uint32_t toPort)
+{
+	uint32_t port;
+	if (dir != DST)
+	{
+		NATIVE_FILTER_LOAD(transportOffset, 2, port);
+		if (port >= fromPort && port <= toPort)
+			return ResultMatch;
+		if (dir == SRC)
+			return ResultNoMatch;
+	}
+
+	NATIVE_FILTER_LOAD(transportOffset + 2, 2, port);
+	return (port >= fromPort && port <= toPort ? ResultMatch : ResultNoMatch);
+}
+
+static inline bool isPortProtocol(uint32_t protocol)
+{
+	return protocol == PACKETPP_IPPROTO_TCP || protocol == PACKETPP_IPPROTO_UDP || protocol == NATIVE_FILTER_IPPROTO_SCTP;
+}
+
+NativeFilterProgram::NativeFilterProgram() : m_IsCompiled(false)
+{
+}
+
+void NativeFilterProgram::clear()
+{
+	m_Nodes.clear();
+	m_Dependencies.clear();
+	m_OpenOperations.clear();
+	m_IsCompiled = false;
+}
+
+bool NativeFilterProgram::compile(GeneralFilter& filter)
+{
+	clear();
+
+	m_IsCompiled = filter.compileToNative(*this) && m_OpenOperations.empty() && !m_Nodes.empty();
+	if (!m_IsCompiled)
+	{
+		LOG_DEBUG("Filter can't be compiled natively");
+		m_Nodes.clear();
+		m_OpenOperations.clear();
+	}
+
+	return m_IsCompiled;
+}
+
+bool NativeFilterProgram::isUpToDate() const
+{
+	if (m_Dependencies.empty())
+		return false;
+
+	for (std::vector<Dependency>::const_iterator iter = m_Dependencies.begin(); iter != m_Dependencies.end(); ++iter)
+	{
+		if (iter->filter->getVersion() != iter->version)
+			return false;
+	}
+
+	return true;
+}
+
+void NativeFilterProgram::addDependency(const GeneralFilter* filter, uint32_t version)
+{
+	Dependency dependency;
+	dependency.filter = filter;
+	dependency.version = version;
+	m_Dependencies.push_back(dependency);
+}
+
+NativeFilterProgram::Node& NativeFilterProgram::addNode(NodeType type)
+{
+	Node node;
+	memset(&node, 0, sizeof(node));
+	node.type = type;
+	node.end = (uint32_t)m_Nodes.size() + 1;
+	m_Nodes.push_back(node);
+	return m_Nodes.back();
+}
+
+void NativeFilterProgram::beginOperation(NodeType type)
+{
+	m_OpenOperations.push_back(m_Nodes.size());
+	addNode(type);
+}
+
+bool NativeFilterProgram::endOperation()
+{
+	if (m_OpenOperations.empty())
+		return false;
+
+	size_t operationIndex = m_OpenOperations.back();
+	m_OpenOperations.pop_back();
+
+	// all operands are closed at this point, so the operand count can be found by skipping from one to the next
+	size_t numOfOperands = 0;
+	for (size_t operandIndex = operationIndex + 1; operandIndex < m_Nodes.size(); operandIndex = m_Nodes[operandIndex].end)
+		numOfOperands++;
+
+	Node& operation = m_Nodes[operationIndex];
+	operation.end = (uint32_t)m_Nodes.size();
+
+	if (numOfOperands == 0 || (operation.type == NodeNot && numOfOperands != 1))
+		return false;
+
+	return true;
+}
+
+void NativeFilterProgram::addEtherTypeMatch(uint16_t etherType)
+{
+	Node& node = addNode(NodeEtherType);
+	node.etherType = etherType;
+}
+
+void NativeFilterProgram::addMacAddressMatch(const MacAddress& macAddress, Direction dir)
+{
+	Node& node = addNode(NodeMacAddress);
+	macAddress.copyTo(node.macAddress);
+	node.dir = dir;
+}
+
+void NativeFilterProgram::addNetworkFieldMatch(uint16_t etherType, uint16_t offset, uint8_t fieldSize, uint32_t mask, FilterOperator op, uint32_t value)
+{
+	Node& node = addNode(NodeNetworkField);
+	node.etherType = etherType;
+	node.offset = offset;
+	node.fieldSize = fieldSize;
+	node.mask = mask;
+	node.op = op;
+	node.value = value;
+}
+
+void NativeFilterProgram::addIPProtocolMatch(uint8_t protocol, bool includeIPv6)
+{
+	Node& node = addNode(NodeIPProtocol);
+	node.protocol = protocol;
+	node.includeIPv6 = includeIPv6;
+}
+
+void NativeFilterProgram::addPortRangeMatch(uint16_t fromPort, uint16_t toPort, Direction dir)
+{
+	Node& node = addNode(NodePortRange);
+	node.value = fromPort;
+	node.value2 = toPort;
+	node.dir = dir;
+}
+
+void NativeFilterProgram::addTransportFieldMatch(uint8_t protocol, uint16_t offset, uint8_t fieldSize, uint32_t mask, FilterOperator op, uint32_t value)
+{
+	Node& node = addNode(NodeTransportField);
+	node.protocol = protocol;
+	node.offset = offset;
+	node.fieldSize = fieldSize;
+	node.mask = mask;
+	node.op = op;
+	node.value = value;
+}
+
+bool NativeFilterProgram::matchPacket(const uint8_t* data, size_t dataLen) const
+{
+	if (!m_IsCompiled || data == NULL)
+		return false;
+
+	size_t nodeIndex = 0;
+	return evaluate(nodeIndex, data, dataLen) == ResultMatch;
+}
+
+bool NativeFilterProgram::matchPacket(RawPacket* rawPacket) const
+{
+	if (rawPacket == NULL || rawPacket->getRawDataLen() < 0)
+		return false;
+
+	return matchPacket(rawPacket->getRawData(), (size_t)rawPacket->getRawDataLen());
+}
+
+int NativeFilterProgram::evaluate(size_t& nodeIndex, const uint8_t* data, size_t dataLen) const
+{
+	const Node& node = m_Nodes[nodeIndex];
+	switch (node.type)
+	{
+	case NodeAnd:
+	case NodeOr:
+	{
+		// operands are evaluated in order and the evaluation stops at the first operand that decides the result
+		size_t operandIndex = nodeIndex + 1;
+		while (operandIndex < node.end)
+		{
+			int result = evaluate(operandIndex, data, dataLen);
+			if (result == ResultAbort)
+				return ResultAbort;
+
+			if ((node.type == NodeAnd) != (result == ResultMatch))
+			{
+				nodeIndex = node.end;
+				return result;
+			}
+		}
+
+		nodeIndex = node.end;
+		return (node.type == NodeAnd ? ResultMatch : ResultNoMatch);
+	}
+
+	case NodeNot:
+	{
+		size_t operandIndex = nodeIndex + 1;
+		int result = evaluate(operandIndex, data, dataLen);
+		nodeIndex = node.end;
+		if (result == ResultAbort)
+			return ResultAbort;
+
+		return (result == ResultMatch ? ResultNoMatch : ResultMatch);
+	}
+
+	default:
+		nodeIndex = node.end;
+		return evaluateField(node, data, dataLen);
+	}
+}
+
+int NativeFilterProgram::evaluateField(const Node& node, const uint8_t* data, size_t dataLen) const
+{
+	uint32_t etherType;
+	uint32_t field;
+
+	switch (node.type)
+	{
+	case NodeEtherType:
+		NATIVE_FILTER_LOAD(NATIVE_FILTER_ETHERTYPE_OFFSET, 2, etherType);
+		return (etherType == node.etherType ? ResultMatch : ResultNoMatch);
+
+	case NodeMacAddress:
+		if (node.dir != DST)
+		{
+			if (dataLen < 2 * sizeof(node.macAddress))
+				return ResultAbort;
+			if (memcmp(data + sizeof(node.macAddress), node.macAddress, sizeof(node.macAddress)) == 0)
+				return ResultMatch;
+			if (node.dir == SRC)
+				return ResultNoMatch;
+		}
+
+		if (dataLen < sizeof(node.macAddress))
+			return ResultAbort;
+		return (memcmp(data, node.macAddress, sizeof(node.macAddress)) == 0 ? ResultMatch : ResultNoMatch);
+
+	case NodeNetworkField:
+		NATIVE_FILTER_LOAD(NATIVE_FILTER_ETHERTYPE_OFFSET, 2, etherType);
+		if (etherType != node.etherType)
+			return ResultNoMatch;
+		NATIVE_FILTER_LOAD(NATIVE_FILTER_NETWORK_OFFSET + node.offset, node.fieldSize, field);
+		return compareField(field & node.mask, node.op, node.value);
+
+	case NodeIPProtocol:
+		NATIVE_FILTER_LOAD(NATIVE_FILTER_ETHERTYPE_OFFSET, 2, etherType);
+		if (etherType == PCPP_ETHERTYPE_IP)
+		{
+			NATIVE_FILTER_LOAD(NATIVE_FILTER_IPV4_PROTOCOL_OFFSET, 1, field);
+			return (field == node.protocol ? ResultMatch : ResultNoMatch);
+		}
+
+		if (etherType == PCPP_ETHERTYPE_IPV6 && node.includeIPv6)
+		{
+			NATIVE_FILTER_LOAD(NATIVE_FILTER_IPV6_NEXT_HDR_OFFSET, 1, field);
+			if (field == node.protocol)
+				return ResultMatch;
+
+			// libpcap also looks at the next header of a fragment header which directly follows the IPv6 header
+			if (field != PACKETPP_IPPROTO_FRAGMENT)
+				return ResultNoMatch;
+
+			NATIVE_FILTER_LOAD(NATIVE_FILTER_IPV6_PAYLOAD_OFFSET, 1, field);
+			return (field == node.protocol ? ResultMatch : ResultNoMatch);
+		}
+
+		return ResultNoMatch;
+
+	case NodePortRange:
+		NATIVE_FILTER_LOAD(NATIVE_FILTER_ETHERTYPE_OFFSET, 2, etherType);
+		if (etherType == PCPP_ETHERTYPE_IP)
+		{
+			NATIVE_FILTER_LOAD(NATIVE_FILTER_IPV4_PROTOCOL_OFFSET, 1, field);
+			if (!isPortProtocol(field))
+				return ResultNoMatch;
+
+			// only the first fragment contains the ports
+			NATIVE_FILTER_LOAD(NATIVE_FILTER_IPV4_FRAG_OFFSET, 2, field);
+			if ((field & 0x1fff) != 0)
+				return ResultNoMatch;
+
+			NATIVE_FILTER_LOAD(NATIVE_FILTER_NETWORK_OFFSET, 1, field);
+			return matchPorts(data, dataLen, NATIVE_FILTER_NETWORK_OFFSET + (field & 0x0f) * 4, node.dir, node.value, node.value2);
+		}
+
+		if (etherType == PCPP_ETHERTYPE_IPV6)
+		{
+			// IPv6 extension headers aren't skipped, the same as in libpcap
+			NATIVE_FILTER_LOAD(NATIVE_FILTER_IPV6_NEXT_HDR_OFFSET, 1, field);
+			if (!isPortProtocol(field))
+				return ResultNoMatch;
+
+			return matchPorts(data, dataLen, NATIVE_FILTER_IPV6_PAYLOAD_OFFSET, node.dir, node.value, node.value2);
+		}
+
+		return ResultNoMatch;
+
+	case NodeTransportField:
+		NATIVE_FILTER_LOAD(NATIVE_FILTER_ETHERTYPE_OFFSET, 2, etherType);
+		if (etherType != PCPP_ETHERTYPE_IP)
+			return ResultNoMatch;
+
+		NATIVE_FILTER_LOAD(NATIVE_FILTER_IPV4_PROTOCOL_OFFSET, 1, field);
+		if (field != node.protocol)
+			return ResultNoMatch;
+
+		NATIVE_FILTER_LOAD(NATIVE_FILTER_IPV4_FRAG_OFFSET, 2, field);
+		if ((field & 0x1fff) != 0)
+			return ResultNoMatch;
+
+		NATIVE_FILTER_LOAD(NATIVE_FILTER_NETWORK_OFFSET, 1, field);
+		NATIVE_FILTER_LOAD(NATIVE_FILTER_NETWORK_OFFSET + (field & 0x0f) * 4 + node.offset, node.fieldSize, field);
+		return compareField(field & node.mask, node.op, node.value);
+
+	default:
+		return ResultNoMatch;
+	}
+}
+
+} // namespace pcpp
@@ -0,0 +1,479 @@
+#define LOG_MODULE PcapLogModuleFileDevice
+
+#include "ParallelPcapFileReader.h"
+#include "CompiledFilter.h"
+#include "Logger.h"
+
+// the number of packets a worker adds to its queue (or the merging thread removes from it) before synchronizing with the other side
+#define QUEUE_SYNC_BATCH_SIZE 64
+
+namespace pcpp
+{
+
+static inline bool isTimestampEarlier(const timespec& first, const timespec& second)
+{
+	return (first.tv_sec < second.tv_sec || (first.tv_sec == second.tv_sec && first.tv_nsec < second.tv_nsec));
+}
+
+ParallelPcapFileReader::ParallelPcapFileReader(const std::string& fileName, int numOfWorkers) : m_FileName(fileName)
+{
+	m_NumOfWorkers = (numOfWorkers < 1 ? 1 : numOfWorkers);
+	m_LinkLayerType = LINKTYPE_ETHERNET;
+	m_Filter = NULL;
+	m_NumOfPacketsProcessed = 0;
+	m_OnPacket = NULL;
+	m_OnPacketCookie = NULL;
+	pthread_mutex_init(&m_QueueMutex, NULL);
+	pthread_cond_init(&m_QueueNotEmpty, NULL);
+}
+
+ParallelPcapFileReader::~ParallelPcapFileReader()
+{
+	close();
+	pthread_cond_destroy(&m_QueueNotEmpty);
+	pthread_mutex_destroy(&m_QueueMutex);
+}
+
+bool ParallelPcapFileReader::open(bool saveIndex)
+{
+	if (isOpened())
+	{
+		LOG_DEBUG("File already opened. Nothing to do");
+		return true;
+	}
+
+	// workers open their own devices, this one is used only to verify the file and get its link type
+	MmapPcapFileReaderDevice reader(m_FileName.c_str());
+	if (!reader.open())
+	{
+		LOG_ERROR("Cannot open file '%s' for parallel reading", m_FileName.c_str());
+		return false;
+	}
+
+	m_LinkLayerType = reader.getLinkLayerType();
+	reader.close();
+
+	if (!m_Index.loadOrBuild(m_FileName, saveIndex))
+	{
+		LOG_ERROR("Cannot index file '%s'", m_FileName.c_str());
+		return false;
+	}
+
+	LOG_DEBUG("Opened file '%s' for parallel reading with %d workers", m_FileName.c_str(), m_NumOfWorkers);
+	return true;
+}
+
+void ParallelPcapFileReader::close()
+{
+	delete m_Filter;
+	m_Filter = NULL;
+
+	m_Index.clear();
+}
+
+bool ParallelPcapFileReader::setFilter(std::string filterAsString)
+{
+	if (!isOpened())
+	{
+		LOG_ERROR("File not opened, cannot set filter");
+		return false;
+	}
+
+	delete m_Filter;
+	m_Filter = NULL;
+
+	if (filterAsString == "")
+		return true;
+
+	// the filter is compiled once and shared by all workers
+	m_Filter = new CompiledFilter(filterAsString, m_LinkLayerType);
+	if (!m_Filter->isValid())
+	{
+		delete m_Filter;
+		m_Filter = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+bool ParallelPcapFileReader::setFilter(GeneralFilter& filter)
+{
+	if (!isOpened())
+	{
+		LOG_ERROR("File not opened, cannot set filter");
+		return false;
+	}
+
+	delete m_Filter;
+	m_Filter = new CompiledFilter(filter, m_LinkLayerType);
+	if (!m_Filter->isValid())
+	{
+		delete m_Filter;
+		m_Filter = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+bool ParallelPcapFileReader::readPacket(MmapPcapFileReaderDevice& device, RawPacket& rawPacket, uint64_t& numOfPacketsLeft)
+{
+	while (numOfPacketsLeft > 0)
+	{
+		if (!device.getNextPacket(rawPacket))
+			return false;
+
+		numOfPacketsLeft--;
+
+		if (m_Filter == NULL || m_Filter->match(&rawPacket))
+			return true;
+	}
+
+	return false;
+}
+
+void* ParallelPcapFileReader::workerMain(void* context)
+{
+	WorkerContext* worker = (WorkerContext*)context;
+	ParallelPcapFileReader* reader = worker->reader;
+	uint64_t numOfPacketsLeft = worker->chunk.numOfPackets;
+	uint64_t queueTail = 0;
+
+	MmapPcapFileReaderDevice device(reader->m_FileName.c_str());
+	if (device.open() && device.setReadOffset(worker->chunk.startOffset))
+	{
+		// packets stay valid until the device is closed, so they can be handed to the merging thread without copying
+		device.setZeroCopyMode(true);
+
+		if (!worker->ordered)
+		{
+			RawPacket rawPacket;
+			Packet packet;
+			while (reader->readPacket(device, rawPacket, numOfPacketsLeft))
+			{
+				packet.setRawPacket(&rawPacket, false);
+				worker->numOfPacketsProcessed++;
+				reader->m_OnPacket(packet, worker->workerId, reader->m_OnPacketCookie);
+			}
+		}
+		else
+		{
+			uint64_t queueHead = 0;
+			uint64_t publishedTail = 0;
+			while (true)
+			{
+				if (queueTail - queueHead == PCPP_PARALLEL_READER_QUEUE_SIZE)
+				{
+					// the queue looks full: publish what's pending and wait for the merging thread to free some slots
+					pthread_mutex_lock(&reader->m_QueueMutex);
+					worker->queueTail = queueTail;
+					pthread_cond_signal(&reader->m_QueueNotEmpty);
+					while (queueTail - worker->queueHead == PCPP_PARALLEL_READER_QUEUE_SIZE)
+						pthread_cond_wait(&worker->queueNotFull, &reader->m_QueueMutex);
+					queueHead = worker->queueHead;
+					pthread_mutex_unlock(&reader->m_QueueMutex);
+					publishedTail = queueTail;
+				}
+
+				WorkerQueueSlot& slot = worker->queue[queueTail % PCPP_PARALLEL_READER_QUEUE_SIZE];
+				if (!reader->readPacket(device, slot.rawPacket, numOfPacketsLeft))
+					break;
+
+				slot.packet.setRawPacket(&slot.rawPacket, false);
+				worker->numOfPacketsProcessed++;
+				if (reader->m_OnPacket != NULL && !reader->m_OnPacket(slot.packet, worker->workerId, reader->m_OnPacketCookie))
+					continue;
+
+				queueTail++;
+				if (queueTail - publishedTail >= QUEUE_SYNC_BATCH_SIZE)
+				{
+					pthread_mutex_lock(&reader->m_QueueMutex);
+					worker->queueTail = queueTail;
+					queueHead = worker->queueHead;
+					pthread_cond_signal(&reader->m_QueueNotEmpty);
+					pthread_mutex_unlock(&reader->m_QueueMutex);
+					publishedTail = queueTail;
+				}
+			}
+		}
+
+		worker->success = (numOfPacketsLeft == 0);
+	}
+
+	if (!worker->success)
+		LOG_ERROR("Worker %d failed reading packets from offset %llu of file '%s'", worker->workerId, (unsigned long long)worker->chunk.startOffset, reader->m_FileName.c_str());
+
+	pthread_mutex_lock(&reader->m_QueueMutex);
+	worker->queueTail = queueTail;
+	worker->finished = true;
+	pthread_cond_signal(&reader->m_QueueNotEmpty);
+	pthread_mutex_unlock(&reader->m_QueueMutex);
+
+	// the device must stay open until the merging thread is done with the packets that point into it
+	if (worker->ordered)
+	{
+		pthread_mutex_lock(&reader->m_QueueMutex);
+		while (worker->queueHead != worker->queueTail)
+			pthread_cond_wait(&worker->queueNotFull, &reader->m_QueueMutex);
+		pthread_mutex_unlock(&reader->m_QueueMutex);
+	}
+
+	return NULL;
+}
+
+void ParallelPcapFileReader::mergeInFileOrder(std::vector<WorkerContext>& workers, OnOrderedPacketCallback onOrderedPacket, void* orderedCookie)
+{
+	// each worker reads a contiguous chunk of the file and the chunks are ordered by worker index, so draining the queues one worker
+	// after the other reproduces the file order. Workers that are further in the file keep reading until their queues are full
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		WorkerContext& worker = workers[i];
+
+		// a local copy of the queue head, synchronized with the worker every QUEUE_SYNC_BATCH_SIZE packets
+		uint64_t queueHead = 0;
+
+		while (true)
+		{
+			pthread_mutex_lock(&m_QueueMutex);
+
+			// release the slots consumed since the last synchronization
+			if (worker.queueHead != queueHead)
+			{
+				worker.queueHead = queueHead;
+				pthread_cond_signal(&worker.queueNotFull);
+			}
+
+			while (worker.queueTail == queueHead && !worker.finished)
+				pthread_cond_wait(&m_QueueNotEmpty, &m_QueueMutex);
+
+			uint64_t queueTail = worker.queueTail;
+
+			pthread_mutex_unlock(&m_QueueMutex);
+
+			// the worker is done and all of its packets were handed
+			if (queueTail == queueHead)
+				break;
+
+			for (int numOfPacketsMerged = 0; numOfPacketsMerged < QUEUE_SYNC_BATCH_SIZE && queueHead != queueTail; numOfPacketsMerged++)
+			{
+				onOrderedPacket(worker.queue[queueHead % PCPP_PARALLEL_READER_QUEUE_SIZE].packet, orderedCookie);
+				queueHead++;
+			}
+		}
+
+		// let the worker, which waits for its queue to drain before closing its device, know it's empty
+		pthread_mutex_lock(&m_QueueMutex);
+		worker.queueHead = queueHead;
+		pthread_cond_signal(&worker.queueNotFull);
+		pthread_mutex_unlock(&m_QueueMutex);
+	}
+}
+
+void ParallelPcapFileReader::mergeInTimestampOrder(std::vector<WorkerContext>& workers, OnOrderedPacketCallback onOrderedPacket, void* orderedCookie)
+{
+	size_t numOfWorkers = workers.size();
+
+	// local copies of the queue positions, synchronized with the workers every QUEUE_SYNC_BATCH_SIZE packets
+	std::vector<uint64_t> queueHeads(numOfWorkers, 0);
+	std::vector<uint64_t> queueTails(numOfWorkers, 0);
+	std::vector<bool> finished(numOfWorkers, false);
+
+	while (true)
+	{
+		bool allDone;
+
+		pthread_mutex_lock(&m_QueueMutex);
+
+		// release the slots consumed since the last synchronization
+		for (size_t i = 0; i < numOfWorkers; i++)
+		{
+			if (workers[i].queueHead != queueHeads[i])
+			{
+				workers[i].queueHead = queueHeads[i];
+				pthread_cond_signal(&workers[i].queueNotFull);
+			}
+		}
+
+		// the next packet can be chosen only when every worker that isn't done has at least one packet in its queue
+		while (true)
+		{
+			bool mustWait = false;
+			allDone = true;
+			for (size_t i = 0; i < numOfWorkers; i++)
+			{
+				queueTails[i] = workers[i].queueTail;
+				finished[i] = workers[i].finished;
+				if (queueHeads[i] != queueTails[i])
+					allDone = false;
+				else if (!finished[i])
+				{
+					allDone = false;
+					mustWait = true;
+				}
+			}
+
+			if (!mustWait)
+				break;
+
+			pthread_cond_wait(&m_QueueNotEmpty, &m_QueueMutex);
+		}
+
+		pthread_mutex_unlock(&m_QueueMutex);
+
+		if (allDone)
+			break;
+
+		for (int numOfPacketsMerged = 0; numOfPacketsMerged < QUEUE_SYNC_BATCH_SIZE; numOfPacketsMerged++)
+		{
+			// choose the earliest packet among the queue heads. Ties go to the lower worker which holds the earlier part of the file
+			int earliestWorker = -1;
+			bool mustSync = false;
+			for (size_t i = 0; i < numOfWorkers; i++)
+			{
+				if (queueHeads[i] == queueTails[i])
+				{
+					if (!finished[i])
+					{
+						mustSync = true;
+						break;
+					}
+
+					continue;
+				}
+
+				if (earliestWorker < 0 ||
+						isTimestampEarlier(workers[i].queue[queueHeads[i] % PCPP_PARALLEL_READER_QUEUE_SIZE].rawPacket.getPacketTimeStamp(),
+								workers[earliestWorker].queue[queueHeads[earliestWorker] % PCPP_PARALLEL_READER_QUEUE_SIZE].rawPacket.getPacketTimeStamp()))
+					earliestWorker = (int)i;
+			}
+
+			if (mustSync || earliestWorker < 0)
+				break;
+
+			onOrderedPacket(workers[earliestWorker].queue[queueHeads[earliestWorker] % PCPP_PARALLEL_READER_QUEUE_SIZE].packet, orderedCookie);
+			queueHeads[earliestWorker]++;
+		}
+	}
+
+	// let workers waiting for their queues to drain know they're empty
+	pthread_mutex_lock(&m_QueueMutex);
+	for (size_t i = 0; i < numOfWorkers; i++)
+	{
+		workers[i].queueHead = queueHeads[i];
+		pthread_cond_signal(&workers[i].queueNotFull);
+	}
+	pthread_mutex_unlock(&m_QueueMutex);
+}
+
+bool ParallelPcapFileReader::runWorkers(std::vector<WorkerContext>& workers, bool ordered, PacketOrder order, OnOrderedPacketCallback onOrderedPacket, void* orderedCookie)
+{
+	std::vector<PcapFileChunk> chunks;
+	m_Index.getChunks(m_NumOfWorkers, chunks);
+
+	m_NumOfPacketsProcessed = 0;
+
+	// the vector must not be resized after this point since the condition variables and the threads hold pointers into it
+	workers.resize(chunks.size());
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		WorkerContext& worker = workers[i];
+		worker.reader = this;
+		worker.workerId = (int)i;
+		worker.chunk = chunks[i];
+		worker.ordered = ordered;
+		worker.success = false;
+		worker.numOfPacketsProcessed = 0;
+		worker.queue = (ordered ? new WorkerQueueSlot[PCPP_PARALLEL_READER_QUEUE_SIZE] : NULL);
+		worker.queueHead = 0;
+		worker.queueTail = 0;
+		worker.finished = false;
+		pthread_cond_init(&worker.queueNotFull, NULL);
+	}
+
+	std::vector<pthread_t> threads(workers.size());
+	std::vector<bool> threadCreated(workers.size(), false);
+	bool success = true;
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		if (pthread_create(&threads[i], NULL, workerMain, &workers[i]) != 0)
+		{
+			// mark the worker as finished so the merge doesn't wait for it
+			LOG_ERROR("Cannot create worker thread %d", (int)i);
+			pthread_mutex_lock(&m_QueueMutex);
+			workers[i].finished = true;
+			pthread_mutex_unlock(&m_QueueMutex);
+			success = false;
+			continue;
+		}
+
+		threadCreated[i] = true;
+	}
+
+	if (ordered && order == TimestampOrder)
+		mergeInTimestampOrder(workers, onOrderedPacket, orderedCookie);
+	else if (ordered)
+		mergeInFileOrder(workers, onOrderedPacket, orderedCookie);
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		if (threadCreated[i])
+			pthread_join(threads[i], NULL);
+	}
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		success = success && workers[i].success;
+		m_NumOfPacketsProcessed += workers[i].numOfPacketsProcessed;
+		pthread_cond_destroy(&workers[i].queueNotFull);
+		if (workers[i].queue != NULL)
+			delete [] workers[i].queue;
+	}
+
+	return success;
+}
+
+bool ParallelPcapFileReader::processPackets(OnPacketCallback onPacket, void* userCookie)
+{
+	if (!isOpened())
+	{
+		LOG_ERROR("File '%s' not opened", m_FileName.c_str());
+		return false;
+	}
+
+	if (onPacket == NULL)
+	{
+		LOG_ERROR("Packet callback must be set");
+		return false;
+	}
+
+	m_OnPacket = onPacket;
+	m_OnPacketCookie = userCookie;
+
+	std::vector<WorkerContext> workers;
+	return runWorkers(workers, false, FileOrder, NULL, NULL);
+}
+
+bool ParallelPcapFileReader::processPacketsOrdered(OnPacketCallback onPacket, void* onPacketCookie, OnOrderedPacketCallback onOrderedPacket, void* onOrderedPacketCookie,
+		PacketOrder order)
+{
+	if (!isOpened())
+	{
+		LOG_ERROR("File '%s' not opened", m_FileName.c_str());
+		return false;
+	}
+
+	if (onOrderedPacket == NULL)
+	{
+		LOG_ERROR("Ordered packet callback must be set");
+		return false;
+	}
+
+	m_OnPacket = onPacket;
+	m_OnPacketCookie = onPacketCookie;
+
+	std::vector<WorkerContext> workers;
+	return runWorkers(workers, true, order, onOrderedPacket, onOrderedPacketCookie);
+}
+
+} // namespace pcpp
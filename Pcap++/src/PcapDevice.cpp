@@ -1,12 +1,27 @@
 #include "PcapDevice.h"
 #include "PcapFilter.h"
+#include "CompiledFilter.h"
 #include "Logger.h"
-#include "TimespecTimeval.h"
 #include <pcap.h>
+#include <pthread.h>
 
 namespace pcpp
 {
 
+// every thread keeps the last filter it matched with matchPacketWithFilter(std::string, RawPacket*) so threads don't share state
+static pthread_key_t LastFilterKey;
+static pthread_once_t LastFilterKeyOnce = PTHREAD_ONCE_INIT;
+
+static void deleteLastFilter(void* lastFilter)
+{
+	delete (CompiledFilter*)lastFilter;
+}
+
+static void createLastFilterKey()
+{
+	pthread_key_create(&LastFilterKey, deleteLastFilter);
+}
+
 IPcapDevice::~IPcapDevice()
 {
 }
@@ -22,7 +37,7 @@ bool IPcapDevice::setFilter(std::string filterAsString)
 
 	struct bpf_program prog;
 	LOG_DEBUG("Compiling the filter '%s'", filterAsString.c_str());
-	if (pcap_compile(m_PcapDescriptor, &prog, filterAsString.c_str(), 1, 0) < 0)
+	if (!compileBpfFilter(filterAsString, pcpp::LINKTYPE_ETHERNET, 9000, &prog, m_PcapDescriptor))
 	{
 		/*
 		* Print out appropriate text, followed by the error message
@@ -62,7 +77,7 @@ bool IPcapDevice::verifyFilter(std::string filterAsString)
 {
 	struct bpf_program prog;
 	LOG_DEBUG("Compiling the filter '%s'", filterAsString.c_str());
-	if (pcap_compile_nopcap(9000, pcpp::LINKTYPE_ETHERNET, &prog, filterAsString.c_str(), 1, 0) < 0)
+	if (!compileBpfFilter(filterAsString, pcpp::LINKTYPE_ETHERNET, 9000, &prog))
 	{
 		return false;
 	}
@@ -72,27 +87,17 @@ bool IPcapDevice::verifyFilter(std::string filterAsString)
 
 bool IPcapDevice::matchPacketWithFilter(std::string filterAsString, RawPacket* rawPacket)
 {
-	static std::string curFilter = "";
-	static struct bpf_program prog;
-	if (curFilter != filterAsString)
-	{
-		LOG_DEBUG("Compiling the filter '%s'", filterAsString.c_str());
-		pcap_freecode(&prog);
-		if (pcap_compile_nopcap(9000, pcpp::LINKTYPE_ETHERNET, &prog, filterAsString.c_str(), 1, 0) < 0)
-		{
-			return false;
-		}
+	pthread_once(&LastFilterKeyOnce, createLastFilterKey);
 
-		curFilter = filterAsString;
+	CompiledFilter* lastFilter = (CompiledFilter*)pthread_getspecific(LastFilterKey);
+	if (lastFilter == NULL || lastFilter->getFilterAsString() != filterAsString)
+	{
+		delete lastFilter;
+		lastFilter = new CompiledFilter(filterAsString);
+		pthread_setspecific(LastFilterKey, lastFilter);
 	}
 
-	struct pcap_pkthdr pktHdr;
-	pktHdr.caplen = rawPacket->getRawDataLen();
-	pktHdr.len = rawPacket->getRawDataLen();
-	timespec ts = rawPacket->getPacketTimeStamp();
-	TIMESPEC_TO_TIMEVAL(&pktHdr.ts, &ts);
-
-	return (pcap_offline_filter(&prog, &pktHdr, rawPacket->getRawData()) != 0);
+	return lastFilter->match(rawPacket);
 }
 
 bool IPcapDevice::matchPacketWithFilter(GeneralFilter& filter, RawPacket* rawPacket)
@@ -3,15 +3,35 @@
 #include <stdio.h>
 #include <cerrno>
 #include "PcapFileDevice.h"
+#include "PcapFilter.h"
 #include "light_pcapng_ext.h"
 #include "Logger.h"
 #include "TimespecTimeval.h"
 #include <string.h>
 #include <fstream>
+#if !defined(WIN32) && !defined(WINx64) && !defined(PCAPPP_MINGW_ENV)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace pcpp
 {
 
+// the minimum size of the buffer packets are copied into by IFileReaderDevice::getNextPackets() in zero-copy mode
+#define BATCH_BUFFER_MIN_SIZE (256*1024)
+
+// classic pcap magic numbers as they appear when the file was written in the reader's byte order
+#define PCAP_MAGIC_USEC 0xa1b2c3d4
+#define PCAP_MAGIC_NSEC 0xa1b23c4d
+#define PCAP_MAGIC_USEC_SWAPPED 0xd4c3b2a1
+#define PCAP_MAGIC_NSEC_SWAPPED 0x4d3cb2a1
+// pcap-ng section header block type, which is a palindrome so it's byte-order independent
+#define PCAPNG_SECTION_HEADER_MAGIC 0x0a0d0d0a
+// the largest packet capture length libpcap accepts in a file (MAXIMUM_SNAPLEN in libpcap)
+#define PCAP_MAX_SNAPSHOT_LENGTH 262144
+
 struct pcap_file_header
 {
 	uint32_t magic;
@@ -73,15 +93,39 @@ IFileReaderDevice::IFileReaderDevice(const char* fileName) : IFileDevice(fileNam
 {
 	m_NumOfPacketsNotParsed = 0;
 	m_NumOfPacketsRead = 0;
+	m_ZeroCopy = false;
+	m_BatchBuffer = NULL;
+	m_BatchBufferSize = 0;
+}
+
+IFileReaderDevice::~IFileReaderDevice()
+{
+	for (std::vector<uint8_t*>::iterator iter = m_RetiredBatchBuffers.begin(); iter != m_RetiredBatchBuffers.end(); iter++)
+		delete [] *iter;
+
+	if (m_BatchBuffer != NULL)
+		delete [] m_BatchBuffer;
 }
 
-IFileReaderDevice* IFileReaderDevice::getReader(const char* fileName)
+IFileReaderDevice* IFileReaderDevice::getReader(const char* fileName, bool useMmapReader)
 {
 	const char* fileExtension = strrchr(fileName, '.');
 
 	if (fileExtension != NULL && strcmp(fileExtension, ".pcapng") == 0)
 		return new PcapNgFileReaderDevice(fileName);
 
+	uint32_t magic = 0;
+	std::ifstream fileStream(fileName, std::ifstream::binary);
+	if (!fileStream.read((char*)&magic, sizeof(magic)))
+		magic = 0;
+
+	if (magic == PCAPNG_SECTION_HEADER_MAGIC)
+		return new PcapNgFileReaderDevice(fileName);
+
+	if (useMmapReader && MmapPcapFileReaderDevice::isSupported() &&
+			(magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC || magic == PCAP_MAGIC_USEC_SWAPPED || magic == PCAP_MAGIC_NSEC_SWAPPED))
+		return new MmapPcapFileReaderDevice(fileName);
+
 	return new PcapFileReaderDevice(fileName);
 }
 
@@ -95,6 +139,10 @@ int IFileReaderDevice::getNextPackets(RawPacketVector& packetVec, int numOfPacke
 {
 	int numOfPacketsRead = 0;
 
+	// packets in the vector outlive the next read so they must own their data regardless of zero-copy mode
+	bool zeroCopy = m_ZeroCopy;
+	m_ZeroCopy = false;
+
 	for (; numOfPacketsToRead < 0 || numOfPacketsRead < numOfPacketsToRead; numOfPacketsRead++)
 	{
 		RawPacket* newPacket = new RawPacket();
@@ -110,6 +158,62 @@ int IFileReaderDevice::getNextPackets(RawPacketVector& packetVec, int numOfPacke
 		}
 	}
 
+	m_ZeroCopy = zeroCopy;
+
+	return numOfPacketsRead;
+}
+
+int IFileReaderDevice::getNextPackets(RawPacket* rawPacketsArr, int arrLength)
+{
+	int numOfPacketsRead = 0;
+
+	if (!m_ZeroCopy)
+	{
+		while (numOfPacketsRead < arrLength && getNextPacket(rawPacketsArr[numOfPacketsRead]))
+			numOfPacketsRead++;
+
+		return numOfPacketsRead;
+	}
+
+	// packets of the previous batch are no longer valid, so buffers they may have pointed to can be freed
+	for (std::vector<uint8_t*>::iterator iter = m_RetiredBatchBuffers.begin(); iter != m_RetiredBatchBuffers.end(); iter++)
+		delete [] *iter;
+	m_RetiredBatchBuffers.clear();
+
+	size_t offset = 0;
+	for (; numOfPacketsRead < arrLength; numOfPacketsRead++)
+	{
+		RawPacket& rawPacket = rawPacketsArr[numOfPacketsRead];
+
+		// in zero-copy mode the packet points to the read buffer which is overwritten by the next read,
+		// so copy it to the batch buffer
+		if (!getNextPacket(rawPacket))
+			break;
+
+		size_t packetLen = (size_t)rawPacket.getRawDataLen();
+		if (offset + packetLen > m_BatchBufferSize)
+		{
+			size_t newSize = 2*m_BatchBufferSize;
+			if (newSize < BATCH_BUFFER_MIN_SIZE)
+				newSize = BATCH_BUFFER_MIN_SIZE;
+			if (newSize < offset + packetLen)
+				newSize = offset + packetLen;
+
+			// earlier packets in this batch still point to the current buffer, so keep it until the next batch
+			if (m_BatchBuffer != NULL)
+				m_RetiredBatchBuffers.push_back(m_BatchBuffer);
+
+			m_BatchBuffer = new uint8_t[newSize];
+			m_BatchBufferSize = newSize;
+			offset = 0;
+		}
+
+		uint8_t* packetData = m_BatchBuffer + offset;
+		memcpy(packetData, rawPacket.getRawData(), packetLen);
+		rawPacket.initWithRawData(packetData, (int)packetLen, rawPacket.getPacketTimeStamp(), false, rawPacket.getLinkLayerType(), rawPacket.getFrameLength());
+		offset += packetLen;
+	}
+
 	return numOfPacketsRead;
 }
 
@@ -180,9 +284,23 @@ bool PcapFileReaderDevice::getNextPacket(RawPacket& rawPacket)
 		return false;
 	}
 
-	uint8_t* pMyPacketData = new uint8_t[pkthdr.caplen];
-	memcpy(pMyPacketData, pPacketData, pkthdr.caplen);
-	if (!rawPacket.setRawData(pMyPacketData, pkthdr.caplen, pkthdr.ts, static_cast<LinkLayerType>(m_PcapLinkLayerType), pkthdr.len))
+	timespec ts;
+	TIMEVAL_TO_TIMESPEC(&pkthdr.ts, &ts);
+
+	bool dataSet;
+	if (m_ZeroCopy)
+	{
+		// point directly to libpcap's read buffer, which is valid until the next packet is read
+		dataSet = rawPacket.initWithRawData(pPacketData, pkthdr.caplen, ts, false, static_cast<LinkLayerType>(m_PcapLinkLayerType), pkthdr.len);
+	}
+	else
+	{
+		uint8_t* pMyPacketData = new uint8_t[pkthdr.caplen];
+		memcpy(pMyPacketData, pPacketData, pkthdr.caplen);
+		dataSet = rawPacket.initWithRawData(pMyPacketData, pkthdr.caplen, ts, true, static_cast<LinkLayerType>(m_PcapLinkLayerType), pkthdr.len);
+	}
+
+	if (!dataSet)
 	{
 		LOG_ERROR("Couldn't set data to raw packet");
 		return false;
@@ -192,6 +310,341 @@ bool PcapFileReaderDevice::getNextPacket(RawPacket& rawPacket)
 }
 
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MmapPcapFileReaderDevice members
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+MmapPcapFileReaderDevice::MmapPcapFileReaderDevice(const char* fileName) : PcapFileReaderDevice(fileName)
+{
+	m_MappedFile = NULL;
+	m_MappedFileSize = 0;
+	m_ReadOffset = 0;
+	m_SwapBytes = false;
+	m_NanoSecPrecision = false;
+	m_SnapshotLength = 0;
+	m_BpfInitialized = false;
+}
+
+MmapPcapFileReaderDevice::~MmapPcapFileReaderDevice()
+{
+	MmapPcapFileReaderDevice::close();
+}
+
+bool MmapPcapFileReaderDevice::isSupported()
+{
+#if defined(WIN32) || defined(WINx64) || defined(PCAPPP_MINGW_ENV)
+	return false;
+#else
+	return true;
+#endif
+}
+
+uint32_t MmapPcapFileReaderDevice::linkTypeToDlt(uint32_t linkType)
+{
+	// the same translation libpcap does when it opens a file (linktype_to_dlt()). Most LINKTYPE_ values are equal to their DLT_ values,
+	// but some of the DLT_ values differ between platforms so a different LINKTYPE_ value was assigned to them in files
+	switch (linkType)
+	{
+#ifdef DLT_ATM_RFC1483
+	case LINKTYPE_ATM_RFC1483:
+		return DLT_ATM_RFC1483;
+#endif
+#ifdef DLT_RAW
+	case LINKTYPE_RAW:
+		return DLT_RAW;
+#endif
+#ifdef DLT_SLIP_BSDOS
+	case 102: // LINKTYPE_SLIP_BSDOS
+		return DLT_SLIP_BSDOS;
+#endif
+#ifdef DLT_PPP_BSDOS
+	case 103: // LINKTYPE_PPP_BSDOS
+		return DLT_PPP_BSDOS;
+#endif
+#ifdef DLT_ATM_CLIP
+	case 106: // LINKTYPE_ATM_CLIP
+		return DLT_ATM_CLIP;
+#endif
+#ifdef DLT_PFSYNC
+	case 246: // LINKTYPE_PFSYNC
+		return DLT_PFSYNC;
+#endif
+#ifdef DLT_PKTAP
+	case 258: // LINKTYPE_PKTAP
+		return DLT_PKTAP;
+#endif
+	default:
+		return linkType;
+	}
+}
+
+uint32_t MmapPcapFileReaderDevice::readUint32(size_t offset) const
+{
+	// records aren't necessarily aligned so read the value byte-by-byte
+	uint32_t value;
+	memcpy(&value, m_MappedFile + offset, sizeof(value));
+	if (m_SwapBytes)
+		value = ((value & 0xff) << 24) | ((value & 0xff00) << 8) | ((value & 0xff0000) >> 8) | (value >> 24);
+	return value;
+}
+
+bool MmapPcapFileReaderDevice::open()
+{
+	m_NumOfPacketsRead = 0;
+	m_NumOfPacketsNotParsed = 0;
+
+	if (m_MappedFile != NULL)
+	{
+		LOG_DEBUG("File already mapped. Nothing to do");
+		return true;
+	}
+
+#if defined(WIN32) || defined(WINx64) || defined(PCAPPP_MINGW_ENV)
+	LOG_ERROR("Memory-mapped pcap reader isn't supported on this platform");
+	return false;
+#else
+	int fd = ::open(m_FileName, O_RDONLY);
+	if (fd < 0)
+	{
+		LOG_ERROR("Cannot open file reader device for filename '%s': %s", m_FileName, strerror(errno));
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) < 0 || (size_t)fileStat.st_size < sizeof(pcap_file_header))
+	{
+		LOG_ERROR("File '%s' is too short to be a pcap file", m_FileName);
+		::close(fd);
+		return false;
+	}
+
+	size_t fileSize = (size_t)fileStat.st_size;
+	void* mappedFile = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping holds its own reference to the file
+	::close(fd);
+	if (mappedFile == MAP_FAILED)
+	{
+		LOG_ERROR("Cannot map file '%s' to memory: %s", m_FileName, strerror(errno));
+		return false;
+	}
+
+	// packets are read front to back, so let the kernel read ahead aggressively and drop pages behind
+	madvise(mappedFile, fileSize, MADV_SEQUENTIAL);
+
+	uint32_t magic;
+	memcpy(&magic, mappedFile, sizeof(magic));
+	switch (magic)
+	{
+	case PCAP_MAGIC_USEC:
+		m_SwapBytes = false;
+		m_NanoSecPrecision = false;
+		break;
+	case PCAP_MAGIC_NSEC:
+		m_SwapBytes = false;
+		m_NanoSecPrecision = true;
+		break;
+	case PCAP_MAGIC_USEC_SWAPPED:
+		m_SwapBytes = true;
+		m_NanoSecPrecision = false;
+		break;
+	case PCAP_MAGIC_NSEC_SWAPPED:
+		m_SwapBytes = true;
+		m_NanoSecPrecision = true;
+		break;
+	default:
+		LOG_ERROR("File '%s' isn't a pcap file (magic number is 0x%X)", m_FileName, magic);
+		munmap(mappedFile, fileSize);
+		return false;
+	}
+
+	m_MappedFile = (uint8_t*)mappedFile;
+	m_MappedFileSize = fileSize;
+
+	// the upper bits of the link type field may hold FCS information
+	uint32_t linkLayer = readUint32(offsetof(pcap_file_header, linktype)) & 0x0FFFFFFF;
+	// libpcap reports the link type as a DLT_ value, keep the same behavior as PcapFileReaderDevice
+	linkLayer = linkTypeToDlt(linkLayer);
+
+	if (!RawPacket::isLinkTypeValid((int)linkLayer))
+	{
+		LOG_ERROR("Invalid link layer (%d) for reader device filename '%s'", (int)linkLayer, m_FileName);
+		close();
+		return false;
+	}
+
+	m_PcapLinkLayerType = static_cast<LinkLayerType>(linkLayer);
+	m_SnapshotLength = readUint32(offsetof(pcap_file_header, snaplen));
+	m_ReadOffset = sizeof(pcap_file_header);
+
+	LOG_DEBUG("Successfully mapped file reader device for filename '%s'", m_FileName);
+	m_DeviceOpened = true;
+	return true;
+#endif
+}
+
+void MmapPcapFileReaderDevice::close()
+{
+	if (m_BpfInitialized)
+	{
+		pcap_freecode(&m_Bpf);
+		m_BpfInitialized = false;
+	}
+
+#if !defined(WIN32) && !defined(WINx64) && !defined(PCAPPP_MINGW_ENV)
+	if (m_MappedFile != NULL)
+	{
+		munmap(m_MappedFile, m_MappedFileSize);
+		LOG_DEBUG("Successfully unmapped file reader device for filename '%s'", m_FileName);
+	}
+#endif
+
+	m_MappedFile = NULL;
+	m_MappedFileSize = 0;
+	m_ReadOffset = 0;
+	m_SnapshotLength = 0;
+	m_DeviceOpened = false;
+}
+
+bool MmapPcapFileReaderDevice::getNextPacket(RawPacket& rawPacket)
+{
+	rawPacket.clear();
+	if (m_MappedFile == NULL)
+	{
+		LOG_ERROR("File device '%s' not opened", m_FileName);
+		return false;
+	}
+
+	while (true)
+	{
+		if (m_ReadOffset + sizeof(packet_header) > m_MappedFileSize)
+		{
+			LOG_DEBUG("Packet could not be read. Probably end-of-file");
+			return false;
+		}
+
+		pcap_pkthdr pktHdr;
+		uint32_t tsSec = readUint32(m_ReadOffset + offsetof(packet_header, tv_sec));
+		uint32_t tsFraction = readUint32(m_ReadOffset + offsetof(packet_header, tv_usec));
+		pktHdr.caplen = readUint32(m_ReadOffset + offsetof(packet_header, caplen));
+		pktHdr.len = readUint32(m_ReadOffset + offsetof(packet_header, len));
+
+		size_t packetDataOffset = m_ReadOffset + sizeof(packet_header);
+		if (pktHdr.caplen > m_MappedFileSize - packetDataOffset)
+		{
+			LOG_ERROR("Packet record at offset %d of file '%s' is truncated", (int)m_ReadOffset, m_FileName);
+			m_ReadOffset = m_MappedFileSize;
+			return false;
+		}
+
+		if (pktHdr.caplen > PCAP_MAX_SNAPSHOT_LENGTH)
+		{
+			LOG_ERROR("Packet record at offset %d of file '%s' has an invalid capture length %u", (int)m_ReadOffset, m_FileName, pktHdr.caplen);
+			m_ReadOffset = m_MappedFileSize;
+			return false;
+		}
+
+		m_ReadOffset = packetDataOffset + pktHdr.caplen;
+		const uint8_t* packetData = m_MappedFile + packetDataOffset;
+
+		// like libpcap, a record longer than the snapshot length of the file is cut to the snapshot length and the rest of it is skipped
+		if (m_SnapshotLength > 0 && pktHdr.caplen > m_SnapshotLength)
+		{
+			LOG_DEBUG("Capture length %u of packet record is larger than the snapshot length %u, truncating it", pktHdr.caplen, m_SnapshotLength);
+			pktHdr.caplen = m_SnapshotLength;
+		}
+
+		timespec ts;
+		ts.tv_sec = tsSec;
+		ts.tv_nsec = m_NanoSecPrecision ? tsFraction : tsFraction * 1000;
+
+		if (m_BpfInitialized)
+		{
+			TIMESPEC_TO_TIMEVAL(&pktHdr.ts, &ts);
+			if (pcap_offline_filter(&m_Bpf, &pktHdr, packetData) == 0)
+				continue;
+		}
+
+		bool dataSet;
+		if (m_ZeroCopy)
+		{
+			dataSet = rawPacket.initWithRawData(packetData, pktHdr.caplen, ts, false, m_PcapLinkLayerType, pktHdr.len);
+		}
+		else
+		{
+			uint8_t* myPacketData = new uint8_t[pktHdr.caplen];
+			memcpy(myPacketData, packetData, pktHdr.caplen);
+			dataSet = rawPacket.initWithRawData(myPacketData, pktHdr.caplen, ts, true, m_PcapLinkLayerType, pktHdr.len);
+		}
+
+		if (!dataSet)
+		{
+			LOG_ERROR("Couldn't set data to raw packet");
+			return false;
+		}
+
+		m_NumOfPacketsRead++;
+		return true;
+	}
+}
+
+bool MmapPcapFileReaderDevice::setReadOffset(uint64_t offset)
+{
+	if (m_MappedFile == NULL)
+	{
+		LOG_ERROR("File device '%s' not opened", m_FileName);
+		return false;
+	}
+
+	if (offset < sizeof(pcap_file_header) || offset > m_MappedFileSize)
+	{
+		LOG_ERROR("Offset %llu is outside the packet records of file '%s'", (unsigned long long)offset, m_FileName);
+		return false;
+	}
+
+	m_ReadOffset = (size_t)offset;
+	return true;
+}
+
+int MmapPcapFileReaderDevice::getNextPackets(RawPacket* rawPacketsArr, int arrLength)
+{
+	// packets point into the mapped file which stays valid until the file is closed, so there is no need to copy them
+	int numOfPacketsRead = 0;
+	while (numOfPacketsRead < arrLength && getNextPacket(rawPacketsArr[numOfPacketsRead]))
+		numOfPacketsRead++;
+
+	return numOfPacketsRead;
+}
+
+bool MmapPcapFileReaderDevice::setFilter(std::string filterAsString)
+{
+	LOG_DEBUG("Filter to be set: '%s'", filterAsString.c_str());
+	if (!m_DeviceOpened)
+	{
+		LOG_ERROR("Device not Opened!! cannot set filter");
+		return false;
+	}
+
+	if (m_BpfInitialized)
+	{
+		pcap_freecode(&m_Bpf);
+		m_BpfInitialized = false;
+	}
+
+	if (filterAsString == "")
+		return true;
+
+	if (!compileBpfFilter(filterAsString, m_PcapLinkLayerType, m_SnapshotLength > 0 ? m_SnapshotLength : 9000, &m_Bpf))
+	{
+		LOG_ERROR("Error compiling filter '%s'", filterAsString.c_str());
+		return false;
+	}
+
+	m_BpfInitialized = true;
+	LOG_DEBUG("Filter set successfully");
+	return true;
+}
+
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // PcapNgFileReaderDevice members
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -216,7 +669,7 @@ bool PcapNgFileReaderDevice::matchPacketWithFilter(const uint8_t* packetData, si
 		LOG_DEBUG("Compiling the filter '%s' for link type %d", m_CurFilter.c_str(), linkTypeAsInt);
 		if (m_BpfInitialized)
 			pcap_freecode(&m_Bpf);
-		if (pcap_compile_nopcap(9000, linkTypeAsInt, &m_Bpf, m_CurFilter.c_str(), 1, 0) < 0)
+		if (!compileBpfFilter(m_CurFilter, linkTypeAsInt, 9000, &m_Bpf))
 		{
 			m_BpfInitialized = false;
 			return false;
@@ -286,9 +739,20 @@ bool PcapNgFileReaderDevice::getNextPacket(RawPacket& rawPacket, std::string& pa
 		}
 	}
 
-	uint8_t* myPacketData = new uint8_t[pktHeader.captured_length];
-	memcpy(myPacketData, pktData, pktHeader.captured_length);
-	if (!rawPacket.setRawData(myPacketData, pktHeader.captured_length, pktHeader.timestamp, static_cast<LinkLayerType>(pktHeader.data_link), pktHeader.original_length))
+	bool dataSet;
+	if (m_ZeroCopy)
+	{
+		// point directly to light_pcapng's read buffer, which is valid until the next packet is read
+		dataSet = rawPacket.initWithRawData(pktData, pktHeader.captured_length, pktHeader.timestamp, false, static_cast<LinkLayerType>(pktHeader.data_link), pktHeader.original_length);
+	}
+	else
+	{
+		uint8_t* myPacketData = new uint8_t[pktHeader.captured_length];
+		memcpy(myPacketData, pktData, pktHeader.captured_length);
+		dataSet = rawPacket.initWithRawData(myPacketData, pktHeader.captured_length, pktHeader.timestamp, true, static_cast<LinkLayerType>(pktHeader.data_link), pktHeader.original_length);
+	}
+
+	if (!dataSet)
 	{
 		LOG_ERROR("Couldn't set data to raw packet");
 		return false;
@@ -318,7 +782,7 @@ void PcapNgFileReaderDevice::getStatistics(pcap_stat& stats) const
 bool PcapNgFileReaderDevice::setFilter(std::string filterAsString)
 {
 	struct bpf_program prog;
-	if (pcap_compile_nopcap(9000, 1, &prog, filterAsString.c_str(), 1, 0) < 0)
+	if (!compileBpfFilter(filterAsString, 1, 9000, &prog))
 	{
 		return false;
 	}
@@ -676,7 +1140,7 @@ bool PcapNgFileWriterDevice::matchPacketWithFilter(const uint8_t* packetData, si
 		LOG_DEBUG("Compiling the filter '%s' for link type %d", m_CurFilter.c_str(), linkTypeAsInt);
 		if (m_BpfInitialized)
 			pcap_freecode(&m_Bpf);
-		if (pcap_compile_nopcap(9000, linkTypeAsInt, &m_Bpf, m_CurFilter.c_str(), 1, 0) < 0)
+		if (!compileBpfFilter(m_CurFilter, linkTypeAsInt, 9000, &m_Bpf))
 		{
 			m_BpfInitialized = false;
 			return false;
@@ -848,7 +1312,7 @@ void PcapNgFileWriterDevice::getStatistics(pcap_stat& stats) const
 bool PcapNgFileWriterDevice::setFilter(std::string filterAsString)
 {
 	struct bpf_program prog;
-	if (pcap_compile_nopcap(9000, 1, &prog, filterAsString.c_str(), 1, 0) < 0)
+	if (!compileBpfFilter(filterAsString, 1, 9000, &prog))
 	{
 		return false;
 	}
@@ -0,0 +1,262 @@
+#define LOG_MODULE PcapLogModuleFileDevice
+
+#include "PcapFileIndex.h"
+#include "PcapFileDevice.h"
+#include "Logger.h"
+#include <string.h>
+#include <fstream>
+#include <sys/stat.h>
+
+#define PCAP_INDEX_FILE_MAGIC "PCPPIDX"
+#define PCAP_INDEX_FILE_VERSION 2
+
+namespace pcpp
+{
+
+// the header of an index sidecar file. It's followed by numOfEntries 64-bit offsets
+struct pcap_index_file_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t packetsPerEntry;
+	uint64_t pcapFileSize;
+	uint64_t pcapFileModificationTime;
+	uint64_t numOfPackets;
+	uint64_t dataEndOffset;
+	uint64_t numOfEntries;
+};
+
+PcapFileIndex::PcapFileIndex()
+{
+	clear();
+}
+
+void PcapFileIndex::clear()
+{
+	m_PacketsPerEntry = 0;
+	m_NumOfPackets = 0;
+	m_PcapFileSize = 0;
+	m_PcapFileModificationTime = 0;
+	m_DataEndOffset = 0;
+	m_EntryOffsets.clear();
+}
+
+bool PcapFileIndex::getFileInfo(const std::string& fileName, uint64_t& fileSize, uint64_t& modificationTime)
+{
+	struct stat fileStat;
+	if (stat(fileName.c_str(), &fileStat) != 0)
+		return false;
+
+	fileSize = (uint64_t)fileStat.st_size;
+	modificationTime = (uint64_t)fileStat.st_mtime;
+	return true;
+}
+
+bool PcapFileIndex::build(const std::string& pcapFileName, uint32_t packetsPerEntry)
+{
+	clear();
+
+	if (packetsPerEntry == 0)
+	{
+		LOG_ERROR("Number of packets per index entry must be larger than 0");
+		return false;
+	}
+
+	MmapPcapFileReaderDevice reader(pcapFileName.c_str());
+	if (!reader.open())
+	{
+		LOG_ERROR("Cannot index file '%s'", pcapFileName.c_str());
+		return false;
+	}
+
+	// packets aren't used beyond reading their length, so there is no need to copy them
+	reader.setZeroCopyMode(true);
+
+	uint64_t packetCount = 0;
+	uint64_t recordOffset = reader.getReadOffset();
+	RawPacket rawPacket;
+	while (reader.getNextPacket(rawPacket))
+	{
+		if (packetCount % packetsPerEntry == 0)
+			m_EntryOffsets.push_back(recordOffset);
+
+		packetCount++;
+		recordOffset = reader.getReadOffset();
+	}
+
+	reader.close();
+
+	if (!getFileInfo(pcapFileName, m_PcapFileSize, m_PcapFileModificationTime))
+	{
+		LOG_ERROR("Cannot get the size of file '%s'", pcapFileName.c_str());
+		clear();
+		return false;
+	}
+
+	m_PacketsPerEntry = packetsPerEntry;
+	m_NumOfPackets = packetCount;
+	m_DataEndOffset = recordOffset;
+
+	LOG_DEBUG("Indexed %llu packets in file '%s' using %d entries", (unsigned long long)packetCount, pcapFileName.c_str(), (int)m_EntryOffsets.size());
+	return true;
+}
+
+bool PcapFileIndex::load(const std::string& pcapFileName, const std::string& indexFileName)
+{
+	clear();
+
+	std::ifstream indexFile(indexFileName.c_str(), std::ifstream::binary);
+	if (!indexFile.is_open())
+	{
+		LOG_DEBUG("Index file '%s' doesn't exist", indexFileName.c_str());
+		return false;
+	}
+
+	pcap_index_file_header header;
+	if (!indexFile.read((char*)&header, sizeof(header)) ||
+			strncmp(header.magic, PCAP_INDEX_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+			header.version != PCAP_INDEX_FILE_VERSION ||
+			header.packetsPerEntry == 0)
+	{
+		LOG_ERROR("File '%s' isn't a valid pcap index file", indexFileName.c_str());
+		return false;
+	}
+
+	uint64_t pcapFileSize = 0;
+	uint64_t pcapFileModificationTime = 0;
+	if (!getFileInfo(pcapFileName, pcapFileSize, pcapFileModificationTime) || pcapFileSize != header.pcapFileSize ||
+			pcapFileModificationTime != header.pcapFileModificationTime)
+	{
+		LOG_DEBUG("Index file '%s' doesn't match pcap file '%s'", indexFileName.c_str(), pcapFileName.c_str());
+		return false;
+	}
+
+	uint64_t expectedNumOfEntries = (header.numOfPackets + header.packetsPerEntry - 1) / header.packetsPerEntry;
+	if (header.numOfEntries != expectedNumOfEntries || header.dataEndOffset < sizeof(pcap_file_header) || header.dataEndOffset > pcapFileSize)
+	{
+		LOG_ERROR("Index file '%s' is corrupted", indexFileName.c_str());
+		return false;
+	}
+
+	m_EntryOffsets.resize((size_t)header.numOfEntries);
+	if (header.numOfEntries > 0 && !indexFile.read((char*)&m_EntryOffsets[0], header.numOfEntries * sizeof(uint64_t)))
+	{
+		LOG_ERROR("Index file '%s' is truncated", indexFileName.c_str());
+		clear();
+		return false;
+	}
+
+	// each entry points to a packet record after the pcap file header and before the end of the data, and entries are in file order
+	uint64_t prevOffset = 0;
+	for (std::vector<uint64_t>::iterator iter = m_EntryOffsets.begin(); iter != m_EntryOffsets.end(); ++iter)
+	{
+		if (*iter < sizeof(pcap_file_header) || *iter >= header.dataEndOffset || *iter <= prevOffset)
+		{
+			LOG_ERROR("Index file '%s' is corrupted", indexFileName.c_str());
+			clear();
+			return false;
+		}
+
+		prevOffset = *iter;
+	}
+
+	m_PacketsPerEntry = header.packetsPerEntry;
+	m_NumOfPackets = header.numOfPackets;
+	m_PcapFileSize = header.pcapFileSize;
+	m_PcapFileModificationTime = header.pcapFileModificationTime;
+	m_DataEndOffset = header.dataEndOffset;
+	return true;
+}
+
+bool PcapFileIndex::save(const std::string& indexFileName) const
+{
+	if (!isValid())
+	{
+		LOG_ERROR("Cannot save an empty index");
+		return false;
+	}
+
+	std::ofstream indexFile(indexFileName.c_str(), std::ofstream::binary | std::ofstream::trunc);
+	if (!indexFile.is_open())
+	{
+		LOG_ERROR("Cannot open index file '%s' for writing", indexFileName.c_str());
+		return false;
+	}
+
+	pcap_index_file_header header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, PCAP_INDEX_FILE_MAGIC, sizeof(header.magic));
+	header.version = PCAP_INDEX_FILE_VERSION;
+	header.packetsPerEntry = m_PacketsPerEntry;
+	header.pcapFileSize = m_PcapFileSize;
+	header.pcapFileModificationTime = m_PcapFileModificationTime;
+	header.numOfPackets = m_NumOfPackets;
+	header.dataEndOffset = m_DataEndOffset;
+	header.numOfEntries = m_EntryOffsets.size();
+
+	indexFile.write((const char*)&header, sizeof(header));
+	if (!m_EntryOffsets.empty())
+		indexFile.write((const char*)&m_EntryOffsets[0], m_EntryOffsets.size() * sizeof(uint64_t));
+
+	indexFile.close();
+	if (indexFile.fail())
+	{
+		LOG_ERROR("Failed writing index file '%s'", indexFileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool PcapFileIndex::loadOrBuild(const std::string& pcapFileName, bool saveSidecar, uint32_t packetsPerEntry)
+{
+	std::string sidecarFileName = getSidecarFileName(pcapFileName);
+
+	if (load(pcapFileName, sidecarFileName))
+		return true;
+
+	if (!build(pcapFileName, packetsPerEntry))
+		return false;
+
+	if (saveSidecar && !save(sidecarFileName))
+		LOG_DEBUG("Couldn't save index sidecar file '%s'", sidecarFileName.c_str());
+
+	return true;
+}
+
+size_t PcapFileIndex::getChunks(size_t numOfChunks, std::vector<PcapFileChunk>& chunks) const
+{
+	chunks.clear();
+
+	size_t numOfEntries = m_EntryOffsets.size();
+	if (numOfChunks == 0 || numOfEntries == 0)
+		return 0;
+
+	if (numOfChunks > numOfEntries)
+		numOfChunks = numOfEntries;
+
+	// spread the entries as evenly as possible: the first (numOfEntries % numOfChunks) chunks get one more entry
+	size_t entriesPerChunk = numOfEntries / numOfChunks;
+	size_t remainder = numOfEntries % numOfChunks;
+	size_t startEntry = 0;
+	for (size_t i = 0; i < numOfChunks; i++)
+	{
+		size_t endEntry = startEntry + entriesPerChunk + (i < remainder ? 1 : 0);
+
+		PcapFileChunk chunk;
+		chunk.startOffset = m_EntryOffsets[startEntry];
+		chunk.endOffset = (endEntry < numOfEntries ? m_EntryOffsets[endEntry] : m_DataEndOffset);
+		chunk.firstPacketIndex = (uint64_t)startEntry * m_PacketsPerEntry;
+		uint64_t endPacketIndex = (uint64_t)endEntry * m_PacketsPerEntry;
+		if (endPacketIndex > m_NumOfPackets)
+			endPacketIndex = m_NumOfPackets;
+		chunk.numOfPackets = endPacketIndex - chunk.firstPacketIndex;
+		chunks.push_back(chunk);
+
+		startEntry = endEntry;
+	}
+
+	return chunks.size();
+}
+
+} // namespace pcpp
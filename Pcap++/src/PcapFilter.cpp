@@ -1,21 +1,82 @@
 #define LOG_MODULE PcapLogModuleLiveDevice
 
 #include "PcapFilter.h"
+#include "NativeFilterProgram.h"
 #include "Logger.h"
 #include "IPv4Layer.h"
+#include "EthLayer.h"
+#include "EndianPortable.h"
+#include <stdlib.h>
 #include <sstream>
 #if defined(WINx64)
 #include <winsock2.h>
 #endif
 #include <pcap.h>
+#include <pthread.h>
 #include "RawPacket.h"
 #include "TimespecTimeval.h"
 
 namespace pcpp
 {
 
+// serializes BPF compilation, which uses global state in older libpcap versions
+static pthread_mutex_t BpfCompileMutex = PTHREAD_MUTEX_INITIALIZER;
+
+bool compileBpfFilter(const std::string& filterAsString, int linkType, int snapshotLength, bpf_program* program, pcap* pcapDescriptor)
+{
+	pthread_mutex_lock(&BpfCompileMutex);
+	int result;
+	if (pcapDescriptor != NULL)
+		result = pcap_compile(pcapDescriptor, program, filterAsString.c_str(), 1, 0);
+	else
+		result = pcap_compile_nopcap(snapshotLength, linkType, program, filterAsString.c_str(), 1, 0);
+	pthread_mutex_unlock(&BpfCompileMutex);
+
+	return (result >= 0);
+}
+
+GeneralFilter::GeneralFilter(const GeneralFilter& other) : m_program(NULL), m_NativeProgram(NULL), m_Version(other.m_Version)
+{
+}
+
+GeneralFilter& GeneralFilter::operator=(const GeneralFilter& other)
+{
+	if (this != &other)
+	{
+		freeProgram();
+		delete m_NativeProgram;
+		m_NativeProgram = NULL;
+		invalidate();
+	}
+
+	return *this;
+}
+
+GeneralFilter::~GeneralFilter()
+{
+	freeProgram();
+	delete m_NativeProgram;
+}
+
+bool GeneralFilter::compileToNative(NativeFilterProgram& program)
+{
+	program.addDependency(this, m_Version);
+	return compileNativeNodes(program);
+}
+
 bool GeneralFilter::matchPacketWithFilter(RawPacket* rawPacket)
 {
+	// try the native program first. It's recompiled only if a filter in the tree was modified since it was last compiled
+	if (m_NativeProgram == NULL)
+		m_NativeProgram = new NativeFilterProgram();
+
+	if (!m_NativeProgram->isUpToDate())
+		m_NativeProgram->compile(*this);
+
+	if (m_NativeProgram->isCompiled())
+		return m_NativeProgram->matchPacket(rawPacket);
+
+	// the filter can't be matched natively, use libpcap's BPF instead
 	std::string filterStr;
 	parseToString(filterStr);
 
@@ -26,7 +87,7 @@ bool GeneralFilter::matchPacketWithFilter(RawPacket* rawPacket)
 		m_program = new bpf_program();
 
 		LOG_DEBUG("Compiling the filter '%s'", filterStr.c_str());
-		if (pcap_compile_nopcap(9000, pcpp::LINKTYPE_ETHERNET, m_program, filterStr.c_str(), 1, 0) < 0)
+		if (!compileBpfFilter(filterStr, pcpp::LINKTYPE_ETHERNET, 9000, m_program))
 		{
 			//Filter not valid so delete member
 			freeProgram();
@@ -72,7 +133,7 @@ bool BPFStringFilter::verifyFilter()
 
 	m_program = new bpf_program();
 	LOG_DEBUG("Compiling the filter '%s'", m_filterStr.c_str());
-	if (m_filterStr.empty() || pcap_compile_nopcap(9000, pcpp::LINKTYPE_ETHERNET, m_program, m_filterStr.c_str(), 1, 0) < 0)
+	if (m_filterStr.empty() || !compileBpfFilter(m_filterStr, pcpp::LINKTYPE_ETHERNET, 9000, m_program))
 	{
 		//Filter not valid so delete member
 		freeProgram();
@@ -178,6 +239,41 @@ void IPFilter::convertToIPAddressWithLen(std::string& ipAddrmodified) const
 	}
 }
 
+bool IPFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	// only cases where the BPF string is valid are compiled natively: an IPv4 address with a valid mask or a length of up to 32 bits
+	IPv4Address ipAddr(m_Address);
+	if (!ipAddr.isValid())
+		return false;
+
+	uint32_t mask = 0xffffffff;
+	if (!m_IPv4Mask.empty())
+	{
+		IPv4Address maskAsAddr(m_IPv4Mask);
+		if (!maskAsAddr.isValid())
+			return false;
+		mask = be32toh(maskAsAddr.toInt());
+	}
+	else if (m_Len < 0 || m_Len > 32)
+		return false;
+	else if (m_Len > 0)
+		mask = (m_Len == 32 ? 0xffffffff : ~(0xffffffff >> m_Len));
+
+	uint32_t net = be32toh(ipAddr.toInt()) & mask;
+
+	// the source and destination addresses are at offsets 12 and 16 of the IPv4 header
+	if (getDir() == SRC_OR_DST)
+		program.beginOperation(NativeFilterProgram::NodeOr);
+	if (getDir() != DST)
+		program.addNetworkFieldMatch(PCPP_ETHERTYPE_IP, 12, 4, mask, EQUALS, net);
+	if (getDir() != SRC)
+		program.addNetworkFieldMatch(PCPP_ETHERTYPE_IP, 16, 4, mask, EQUALS, net);
+	if (getDir() == SRC_OR_DST)
+		return program.endOperation();
+
+	return true;
+}
+
 void IPFilter::parseToString(std::string& result)
 {
 	std::string dir;
@@ -205,6 +301,12 @@ void IPv4IDFilter::parseToString(std::string& result)
 	result = "ip[4:2] " + op + ' ' + stream.str();
 }
 
+bool IPv4IDFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	program.addNetworkFieldMatch(PCPP_ETHERTYPE_IP, 4, 2, 0xffff, getOperator(), m_IpID);
+	return true;
+}
+
 void IPv4TotalLengthFilter::parseToString(std::string& result)
 {
 	std::string op = parseOperator();
@@ -213,6 +315,12 @@ void IPv4TotalLengthFilter::parseToString(std::string& result)
 	result = "ip[2:2] " + op + ' ' + stream.str();
 }
 
+bool IPv4TotalLengthFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	program.addNetworkFieldMatch(PCPP_ETHERTYPE_IP, 2, 2, 0xffff, getOperator(), m_TotalLength);
+	return true;
+}
+
 void PortFilter::portToString(uint16_t portAsInt)
 {
 	std::ostringstream stream;
@@ -232,6 +340,13 @@ void PortFilter::parseToString(std::string& result)
 	result = dir + " port " + m_Port;
 }
 
+bool PortFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	uint16_t port = (uint16_t)atoi(m_Port.c_str());
+	program.addPortRangeMatch(port, port, getDir());
+	return true;
+}
+
 void PortRangeFilter::parseToString(std::string& result)
 {
 	std::string dir;
@@ -245,6 +360,16 @@ void PortRangeFilter::parseToString(std::string& result)
 	result = dir + " portrange " + fromPortStream.str() + '-' + toPortStream.str();
 }
 
+bool PortRangeFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	// libpcap accepts the range edges in any order
+	if (m_FromPort <= m_ToPort)
+		program.addPortRangeMatch(m_FromPort, m_ToPort, getDir());
+	else
+		program.addPortRangeMatch(m_ToPort, m_FromPort, getDir());
+	return true;
+}
+
 void MacAddressFilter::parseToString(std::string& result)
 {
 	if (getDir() != SRC_OR_DST)
@@ -257,6 +382,15 @@ void MacAddressFilter::parseToString(std::string& result)
 		result = "ether host " + m_MacAddress.toString();
 }
 
+bool MacAddressFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	if (!m_MacAddress.isValid())
+		return false;
+
+	program.addMacAddressMatch(m_MacAddress, getDir());
+	return true;
+}
+
 void EtherTypeFilter::parseToString(std::string& result)
 {
 	std::ostringstream stream;
@@ -264,6 +398,32 @@ void EtherTypeFilter::parseToString(std::string& result)
 	result = "ether proto " + stream.str();
 }
 
+bool EtherTypeFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	// for values which are 802.3 lengths or AppleTalk EtherTypes libpcap generates LLC/SNAP checks which aren't implemented natively
+	if (m_EtherType <= 1500 || m_EtherType == 0x809B || m_EtherType == 0x80F3)
+		return false;
+
+	program.addEtherTypeMatch(m_EtherType);
+	return true;
+}
+
+// compile a list of filters as the operands of a logical operation
+static bool compileNativeOperation(NativeFilterProgram& program, NativeFilterProgram::NodeType type, std::vector<GeneralFilter*>& filters)
+{
+	if (filters.empty())
+		return false;
+
+	program.beginOperation(type);
+	for(std::vector<GeneralFilter*>::iterator it = filters.begin(); it != filters.end(); ++it)
+	{
+		if (*it == NULL || !(*it)->compileToNative(program))
+			return false;
+	}
+
+	return program.endOperation();
+}
+
 AndFilter::AndFilter(std::vector<GeneralFilter*>& filters)
 {
 	for(std::vector<GeneralFilter*>::iterator it = filters.begin(); it != filters.end(); ++it)
@@ -275,6 +435,7 @@ AndFilter::AndFilter(std::vector<GeneralFilter*>& filters)
 void AndFilter::setFilters(std::vector<GeneralFilter*>& filters)
 {
 	m_FilterList.clear();
+	invalidate();
 
 	for(std::vector<GeneralFilter*>::iterator it = filters.begin(); it != filters.end(); ++it)
 	{
@@ -297,6 +458,11 @@ void AndFilter::parseToString(std::string& result)
 	}
 }
 
+bool AndFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	return compileNativeOperation(program, NativeFilterProgram::NodeAnd, m_FilterList);
+}
+
 OrFilter::OrFilter(std::vector<GeneralFilter*>& filters)
 {
 	for(std::vector<GeneralFilter*>::iterator it = filters.begin(); it != filters.end(); ++it)
@@ -320,6 +486,11 @@ void OrFilter::parseToString(std::string& result)
 	}
 }
 
+bool OrFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	return compileNativeOperation(program, NativeFilterProgram::NodeOr, m_FilterList);
+}
+
 void NotFilter::parseToString(std::string& result)
 {
 	std::string innerFilterAsString;
@@ -327,6 +498,18 @@ void NotFilter::parseToString(std::string& result)
 	result = "not (" + innerFilterAsString + ')';
 }
 
+bool NotFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	if (m_FilterToInverse == NULL)
+		return false;
+
+	program.beginOperation(NativeFilterProgram::NodeNot);
+	if (!m_FilterToInverse->compileToNative(program))
+		return false;
+
+	return program.endOperation();
+}
+
 void ProtoFilter::parseToString(std::string& result)
 {
 	std::ostringstream stream;
@@ -370,6 +553,41 @@ void ProtoFilter::parseToString(std::string& result)
 	}
 }
 
+bool ProtoFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	// "tcp", "udp", "proto 47" and "proto 2" match IPv4 and IPv6 packets while "icmp" matches only IPv4 packets
+	switch (m_Proto)
+	{
+	case TCP:
+		program.addIPProtocolMatch(PACKETPP_IPPROTO_TCP, true);
+		return true;
+	case UDP:
+		program.addIPProtocolMatch(PACKETPP_IPPROTO_UDP, true);
+		return true;
+	case ICMP:
+		program.addIPProtocolMatch(PACKETPP_IPPROTO_ICMP, false);
+		return true;
+	case GRE:
+		program.addIPProtocolMatch(PACKETPP_IPPROTO_GRE, true);
+		return true;
+	case IGMP:
+		program.addIPProtocolMatch(PACKETPP_IPPROTO_IGMP, true);
+		return true;
+	case IPv4:
+		program.addEtherTypeMatch(PCPP_ETHERTYPE_IP);
+		return true;
+	case IPv6:
+		program.addEtherTypeMatch(PCPP_ETHERTYPE_IPV6);
+		return true;
+	case ARP:
+		program.addEtherTypeMatch(PCPP_ETHERTYPE_ARP);
+		return true;
+	default:
+		// "vlan" looks for stacked tags and "ether" isn't a valid filter, both are left to BPF
+		return false;
+	}
+}
+
 void ArpFilter::parseToString(std::string& result)
 {
 	std::ostringstream sstream;
@@ -377,6 +595,13 @@ void ArpFilter::parseToString(std::string& result)
 	result += sstream.str();
 }
 
+bool ArpFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	// the low byte of the opcode is at offset 7 of the ARP header
+	program.addNetworkFieldMatch(PCPP_ETHERTYPE_ARP, 7, 1, 0xff, EQUALS, (uint32_t)m_OpCode);
+	return true;
+}
+
 void VlanFilter::parseToString(std::string& result)
 {
 	std::ostringstream stream;
@@ -419,6 +644,19 @@ void TcpFlagsFilter::parseToString(std::string& result)
 	}
 }
 
+bool TcpFlagsFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	if (m_TcpFlagsBitMask == 0)
+		return false;
+
+	// the flags are at offset 13 of the TCP header
+	if (m_MatchOption == MatchOneAtLeast)
+		program.addTransportFieldMatch(PACKETPP_IPPROTO_TCP, 13, 1, m_TcpFlagsBitMask, NOT_EQUALS, 0);
+	else
+		program.addTransportFieldMatch(PACKETPP_IPPROTO_TCP, 13, 1, m_TcpFlagsBitMask, EQUALS, m_TcpFlagsBitMask);
+	return true;
+}
+
 void TcpWindowSizeFilter::parseToString(std::string& result)
 {
 	std::ostringstream stream;
@@ -426,6 +664,12 @@ void TcpWindowSizeFilter::parseToString(std::string& result)
 	result = "tcp[14:2] " + parseOperator() + ' ' + stream.str();
 }
 
+bool TcpWindowSizeFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	program.addTransportFieldMatch(PACKETPP_IPPROTO_TCP, 14, 2, 0xffff, getOperator(), m_WindowSize);
+	return true;
+}
+
 void UdpLengthFilter::parseToString(std::string& result)
 {
 	std::ostringstream stream;
@@ -433,4 +677,10 @@ void UdpLengthFilter::parseToString(std::string& result)
 	result = "udp[4:2] " + parseOperator() + ' ' + stream.str();
 }
 
+bool UdpLengthFilter::compileNativeNodes(NativeFilterProgram& program)
+{
+	program.addTransportFieldMatch(PACKETPP_IPPROTO_UDP, 4, 2, 0xffff, getOperator(), m_Length);
+	return true;
+}
+
 } // namespace pcpp
@@ -326,7 +326,7 @@ uint8_t PfRingDevice::getTotalNumOfRxChannels() const
 
 SystemCore PfRingDevice::getCurrentCoreId() const
 {
-	return SystemCores::IdToSystemCore[sched_getcpu()];
+	return getSystemCoreById(sched_getcpu());
 }
 
 
@@ -397,33 +397,26 @@ void PfRingDevice::close()
 	LOG_DEBUG("Device [%s] closed", m_DeviceName);
 }
 
-bool PfRingDevice::initCoreConfigurationByCoreMask(CoreMask coreMask)
+bool PfRingDevice::initCoreConfigurationByCoreSet(const CoreSet& coreSet)
 {
-	int i = 0;
 	int numOfCores = getNumOfCores();
 	clearCoreConfiguration();
-	while ((coreMask != 0) && (i < numOfCores))
+	for (int coreId = coreSet.getFirstCore(); coreId >= 0; coreId = coreSet.getNextCore(coreId))
 	{
-		if (coreMask & 1)
+		if (coreId >= numOfCores)
 		{
-			m_CoreConfiguration[i].IsInUse = true;
+			LOG_ERROR("Trying to use a core [%d] that doesn't exist while machine has %d cores", coreId, numOfCores);
+			clearCoreConfiguration();
+			return false;
 		}
 
-		coreMask = coreMask >> 1;
-		i++;
-	}
-
-	if (coreMask != 0) // this mean coreMask contains a core that doesn't exist
-	{
-		LOG_ERROR("Trying to use a core [%d] that doesn't exist while machine has %d cores", i, numOfCores);
-		clearCoreConfiguration();
-		return false;
+		m_CoreConfiguration[coreId].IsInUse = true;
 	}
 
 	return true;
 }
 
-bool PfRingDevice::startCaptureMultiThread(OnPfRingPacketsArriveCallback onPacketsArrive, void* onPacketsArriveUserCookie, CoreMask coreMask)
+bool PfRingDevice::startCaptureMultiThread(OnPfRingPacketsArriveCallback onPacketsArrive, void* onPacketsArriveUserCookie, const CoreSet& coreSet)
 {
 	if (!m_StopThread)
 	{
@@ -431,19 +424,19 @@ bool PfRingDevice::startCaptureMultiThread(OnPfRingPacketsArriveCallback onPacke
 		return false;
 	}
 
-	if (!initCoreConfigurationByCoreMask(coreMask))
+	if (!initCoreConfigurationByCoreSet(coreSet))
 		return false;
 
 	if (m_NumOfOpenedRxChannels != getCoresInUseCount())
 	{
-		LOG_ERROR("Cannot use a different number of channels and cores. Opened %d channels but set %d cores in core mask", m_NumOfOpenedRxChannels, getCoresInUseCount());
+		LOG_ERROR("Cannot use a different number of channels and cores. Opened %d channels but set %d cores in core set", m_NumOfOpenedRxChannels, getCoresInUseCount());
 		clearCoreConfiguration();
 		return false;
 	}
 
 	m_StopThread = false;
 	int rxChannel = 0;
-	for (int coreId = 0; coreId < MAX_NUM_OF_CORES; coreId++)
+	for (int coreId = 0; coreId < MAX_NUM_OF_CORES_IN_CORE_SET; coreId++)
 	{
 		if (!m_CoreConfiguration[coreId].IsInUse)
 			continue;
@@ -534,7 +527,7 @@ void PfRingDevice::stopCapture()
 {
 	LOG_DEBUG("Trying to stop capturing on device [%s]", m_DeviceName);
 	m_StopThread = true;
-	for (int coreId = 0; coreId < MAX_NUM_OF_CORES; coreId++)
+	for (int coreId = 0; coreId < MAX_NUM_OF_CORES_IN_CORE_SET; coreId++)
 	{
 		if (!m_CoreConfiguration[coreId].IsInUse)
 			continue;
@@ -604,7 +597,7 @@ void* PfRingDevice::captureThreadMain(void* ptr)
 void PfRingDevice::getThreadStatistics(SystemCore core, PfRingStats& stats) const
 {
 	pfring* ring = NULL;
-	uint8_t coreId = core.Id;
+	int coreId = core.Id;
 
 	ring = m_CoreConfiguration[coreId].Channel;
 
@@ -635,13 +628,13 @@ void PfRingDevice::getStatistics(PfRingStats& stats) const
 	stats.drop = 0;
 	stats.recv = 0;
 
-	for (int coreId = 0; coreId < MAX_NUM_OF_CORES; coreId++)
+	for (int coreId = 0; coreId < MAX_NUM_OF_CORES_IN_CORE_SET; coreId++)
 	{
 		if (!m_CoreConfiguration[coreId].IsInUse)
 			continue;
 
 		PfRingStats tempStat;
-		getThreadStatistics(SystemCores::IdToSystemCore[coreId], tempStat);
+		getThreadStatistics(getSystemCoreById(coreId), tempStat);
 		stats.drop += tempStat.drop;
 		stats.recv += tempStat.recv;
 
@@ -652,14 +645,14 @@ void PfRingDevice::getStatistics(PfRingStats& stats) const
 
 void PfRingDevice::clearCoreConfiguration()
 {
-	for (int i = 0; i < MAX_NUM_OF_CORES; i++)
+	for (int i = 0; i < MAX_NUM_OF_CORES_IN_CORE_SET; i++)
 		m_CoreConfiguration[i].clear();
 }
 
 int PfRingDevice::getCoresInUseCount() const
 {
 	int res = 0;
-	for (int i = 0; i < MAX_NUM_OF_CORES; i++)
+	for (int i = 0; i < MAX_NUM_OF_CORES_IN_CORE_SET; i++)
 		if (m_CoreConfiguration[i].IsInUse)
 			res++;
 
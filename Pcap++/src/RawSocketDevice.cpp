@@ -4,6 +4,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <unistd.h>
+#include <poll.h>
 #include <linux/if_ether.h>
 #include <netpacket/packet.h>
 #include <ifaddrs.h>
@@ -66,6 +67,13 @@ struct SocketContainer
 	int fd;
 	int interfaceIndex;
 	std::string interfaceName;
+	// the blocking mode and timeout last set on the socket, so receivePacket() changes them only when needed
+	int blockingMode;
+	int timeout;
+	// the buffer pool and message headers for recvmmsg(), allocated on first use
+	uint8_t* rxBuffers;
+	struct mmsghdr rxMsgs[PCPP_RAW_SOCKET_MAX_BATCH_SIZE];
+	struct iovec rxIovecs[PCPP_RAW_SOCKET_MAX_BATCH_SIZE];
 #endif
 };
 
@@ -153,34 +161,42 @@ RawSocketDevice::RecvPacketResult RawSocketDevice::receivePacket(RawPacket& rawP
 		return RecvError;
 	}
 
-	int fd = ((SocketContainer*)m_Socket)->fd;
-	char* buffer = new char[RAW_SOCKET_BUFFER_LEN];
-	memset(buffer, 0, RAW_SOCKET_BUFFER_LEN);
+	SocketContainer* sockContainer = (SocketContainer*)m_Socket;
+	int fd = sockContainer->fd;
 
 	// value of 0 timeout means disabling timeout
 	if (timeout < 0)
 		timeout = 0;
 
 	// set blocking or non-blocking flag
-	int flags = fcntl(fd, F_GETFL, 0);
-	if (flags == -1)
+	if (sockContainer->blockingMode != (int)blocking)
 	{
-		LOG_ERROR("Cannot get socket flags");
-		return RecvError;
-	} 
-	flags = (blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
-	if (fcntl(fd, F_SETFL, flags) != 0)
-	{
-		LOG_ERROR("Cannot set socket non-blocking flag");
-		return RecvError;
+		int flags = fcntl(fd, F_GETFL, 0);
+		if (flags == -1)
+		{
+			LOG_ERROR("Cannot get socket flags");
+			return RecvError;
+		}
+		flags = (blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+		if (fcntl(fd, F_SETFL, flags) != 0)
+		{
+			LOG_ERROR("Cannot set socket non-blocking flag");
+			return RecvError;
+		}
+		sockContainer->blockingMode = (int)blocking;
 	}
 
 	// set timeout on socket
-	struct timeval timeoutVal;
-	timeoutVal.tv_sec = timeout;
-	timeoutVal.tv_usec = 0;
-	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeoutVal, sizeof(timeoutVal));
+	if (sockContainer->timeout != timeout)
+	{
+		struct timeval timeoutVal;
+		timeoutVal.tv_sec = timeout;
+		timeoutVal.tv_usec = 0;
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeoutVal, sizeof(timeoutVal));
+		sockContainer->timeout = timeout;
+	}
 
+	char* buffer = new char[RAW_SOCKET_BUFFER_LEN];
 	int bufferLen = recv(fd, buffer, RAW_SOCKET_BUFFER_LEN, 0);
 	if (bufferLen < 0)
 	{
@@ -228,6 +244,41 @@ int RawSocketDevice::receivePackets(RawPacketVector& packetVec, int timeout, int
 	int packetCount = 0;
 	failedRecv = 0;
 
+#ifdef LINUX
+
+	// receive in batches and copy the packets out of the buffer pool, since the vector owns its packets
+	SocketContainer* sockContainer = (SocketContainer*)m_Socket;
+	long curMsec = curSec * 1000 + curNsec / 1000000;
+	long timeoutMsec = curMsec + (long)timeout * 1000;
+
+	while (curMsec < timeoutMsec)
+	{
+		timespec timestamp;
+		int numOfPackets = receivePacketBatch(PCPP_RAW_SOCKET_MAX_BATCH_SIZE, (int)(timeoutMsec - curMsec), timestamp);
+		if (numOfPackets < 0)
+		{
+			failedRecv++;
+			break;
+		}
+
+		if (numOfPackets == 0)
+			failedRecv++;
+
+		for (int i = 0; i < numOfPackets; i++)
+		{
+			int packetLen = (int)sockContainer->rxMsgs[i].msg_len;
+			uint8_t* packetData = new uint8_t[packetLen];
+			memcpy(packetData, sockContainer->rxBuffers + i * RAW_SOCKET_BUFFER_LEN, packetLen);
+			packetVec.pushBack(new RawPacket(packetData, packetLen, timestamp, true, LINKTYPE_ETHERNET));
+			packetCount++;
+		}
+
+		clockGetTime(curSec, curNsec);
+		curMsec = curSec * 1000 + curNsec / 1000000;
+	}
+
+#else
+
 	long timeoutSec = curSec + timeout;
 
 	while (curSec < timeoutSec)
@@ -247,9 +298,131 @@ int RawSocketDevice::receivePackets(RawPacketVector& packetVec, int timeout, int
 		clockGetTime(curSec, curNsec);
 	}
 
+#endif
+
+	return packetCount;
+}
+
+int RawSocketDevice::receivePackets(RawPacket* rawPacketsArr, int rawPacketArrLength, bool blocking, int timeout)
+{
+	if (!isOpened())
+	{
+		LOG_ERROR("Device is not open");
+		return -1;
+	}
+
+	if (rawPacketsArr == NULL || rawPacketArrLength <= 0)
+	{
+		LOG_ERROR("Raw packet array is NULL or empty");
+		return -1;
+	}
+
+	if (rawPacketArrLength > PCPP_RAW_SOCKET_MAX_BATCH_SIZE)
+		rawPacketArrLength = PCPP_RAW_SOCKET_MAX_BATCH_SIZE;
+
+#if defined(WIN32) || defined(WINx64) || defined(PCAPPP_MINGW_ENV)
+
+	// wait for the first packet, then take the rest of the packets already waiting on the socket
+	int packetCount = 0;
+	RecvPacketResult result = receivePacket(rawPacketsArr[0], blocking, timeout);
+	while (result == RecvSuccess)
+	{
+		packetCount++;
+		if (packetCount == rawPacketArrLength)
+			break;
+		result = receivePacket(rawPacketsArr[packetCount], false);
+	}
+
+	if (packetCount == 0 && result == RecvError)
+		return -1;
+
 	return packetCount;
+
+#elif LINUX
+
+	int timeoutMs = -1;
+	if (!blocking)
+		timeoutMs = 0;
+	else if (timeout > 0)
+		timeoutMs = timeout * 1000;
+
+	timespec timestamp;
+	int numOfPackets = receivePacketBatch(rawPacketArrLength, timeoutMs, timestamp);
+
+	SocketContainer* sockContainer = (SocketContainer*)m_Socket;
+	for (int i = 0; i < numOfPackets; i++)
+	{
+		rawPacketsArr[i].initWithRawData(sockContainer->rxBuffers + i * RAW_SOCKET_BUFFER_LEN, (int)sockContainer->rxMsgs[i].msg_len,
+				timestamp, false, LINKTYPE_ETHERNET);
+	}
+
+	return numOfPackets;
+
+#else
+
+	LOG_ERROR("Raw socket are not supported on this platform");
+	return -1;
+
+#endif
+}
+
+#ifdef LINUX
+
+int RawSocketDevice::receivePacketBatch(int maxPackets, int timeoutMs, timespec& timestamp)
+{
+	SocketContainer* sockContainer = (SocketContainer*)m_Socket;
+
+	if (sockContainer->rxBuffers == NULL)
+	{
+		sockContainer->rxBuffers = new uint8_t[PCPP_RAW_SOCKET_MAX_BATCH_SIZE * RAW_SOCKET_BUFFER_LEN];
+		memset(sockContainer->rxMsgs, 0, sizeof(sockContainer->rxMsgs));
+		for (int i = 0; i < PCPP_RAW_SOCKET_MAX_BATCH_SIZE; i++)
+		{
+			sockContainer->rxIovecs[i].iov_base = sockContainer->rxBuffers + i * RAW_SOCKET_BUFFER_LEN;
+			sockContainer->rxIovecs[i].iov_len = RAW_SOCKET_BUFFER_LEN;
+			sockContainer->rxMsgs[i].msg_hdr.msg_iov = &sockContainer->rxIovecs[i];
+			sockContainer->rxMsgs[i].msg_hdr.msg_iovlen = 1;
+		}
+	}
+
+	// wait with poll() rather than SO_RCVTIMEO so the socket options don't have to be changed on every call
+	if (timeoutMs != 0)
+	{
+		struct pollfd pollFd;
+		pollFd.fd = sockContainer->fd;
+		pollFd.events = POLLIN;
+		pollFd.revents = 0;
+		int res = poll(&pollFd, 1, timeoutMs);
+		if (res < 0 && errno != EINTR)
+		{
+			LOG_ERROR("Error polling the raw socket. Error code is %d", errno);
+			return -1;
+		}
+
+		if (res <= 0)
+			return 0;
+	}
+
+	int numOfPackets = recvmmsg(sockContainer->fd, sockContainer->rxMsgs, maxPackets, MSG_DONTWAIT, NULL);
+	if (numOfPackets < 0)
+	{
+		int errorCode = errno;
+		if (errorCode == EINTR || getError(errorCode) == RecvWouldBlock)
+			return 0;
+
+		LOG_ERROR("Error reading from recvmmsg. Error code is %d", errorCode);
+		return -1;
+	}
+
+	long sec, nsec;
+	clockGetTime(sec, nsec);
+	timestamp.tv_sec = sec;
+	timestamp.tv_nsec = nsec;
+	return numOfPackets;
 }
 
+#endif
+
 bool RawSocketDevice::sendPacket(const RawPacket* rawPacket)
 {
 #if defined(WIN32) || defined(WINx64) || defined(PCAPPP_MINGW_ENV)
@@ -325,28 +498,59 @@ int RawSocketDevice::sendPackets(const RawPacketVector& packetVec)
 	addr.sll_halen = 6;
 	addr.sll_ifindex = ((SocketContainer*)m_Socket)->interfaceIndex;
 
+	sockaddr_ll addrs[PCPP_RAW_SOCKET_MAX_BATCH_SIZE];
+	struct iovec iovecs[PCPP_RAW_SOCKET_MAX_BATCH_SIZE];
+	struct mmsghdr msgs[PCPP_RAW_SOCKET_MAX_BATCH_SIZE];
+	memset(msgs, 0, sizeof(msgs));
+
 	int sendCount = 0;
 
-	for (RawPacketVector::ConstVectorIterator iter = packetVec.begin(); iter != packetVec.end(); iter++)
+	RawPacketVector::ConstVectorIterator iter = packetVec.begin();
+	while (iter != packetVec.end())
 	{
-		Packet packet(*iter, OsiModelDataLinkLayer);
-		if (!packet.isPacketOfType(pcpp::Ethernet))
+		// prepare a batch of packets, each with its own destination address
+		int batchSize = 0;
+		for (; iter != packetVec.end() && batchSize < PCPP_RAW_SOCKET_MAX_BATCH_SIZE; iter++)
 		{
-			LOG_DEBUG("Can't send non-Ethernet packets");
-			continue;
-		}
+			Packet packet(*iter, OsiModelDataLinkLayer);
+			if (!packet.isPacketOfType(pcpp::Ethernet))
+			{
+				LOG_DEBUG("Can't send non-Ethernet packets");
+				continue;
+			}
 
-		EthLayer* ethLayer = packet.getLayerOfType<EthLayer>();
-		MacAddress dstMac = ethLayer->getDestMac();
-		dstMac.copyTo((uint8_t*)&(addr.sll_addr));
+			addrs[batchSize] = addr;
+			EthLayer* ethLayer = packet.getLayerOfType<EthLayer>();
+			MacAddress dstMac = ethLayer->getDestMac();
+			dstMac.copyTo((uint8_t*)&(addrs[batchSize].sll_addr));
+
+			iovecs[batchSize].iov_base = (void*)(*iter)->getRawData();
+			iovecs[batchSize].iov_len = (*iter)->getRawDataLen();
+			msgs[batchSize].msg_hdr.msg_name = &addrs[batchSize];
+			msgs[batchSize].msg_hdr.msg_namelen = sizeof(sockaddr_ll);
+			msgs[batchSize].msg_hdr.msg_iov = &iovecs[batchSize];
+			msgs[batchSize].msg_hdr.msg_iovlen = 1;
+			batchSize++;
+		}
 
-		if (::sendto(fd, (*iter)->getRawData(), (*iter)->getRawDataLen(), 0, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+		// sendmmsg() stops at the first packet that fails, so skip it and send the rest of the batch
+		int batchOffset = 0;
+		while (batchOffset < batchSize)
 		{
-			LOG_DEBUG("Failed to send packet. Error was: '%s'", strerror(errno));
-			continue;
-		}
+			int res = sendmmsg(fd, msgs + batchOffset, batchSize - batchOffset, 0);
+			if (res < 0)
+			{
+				if (errno == EINTR)
+					continue;
 
-		sendCount++;
+				LOG_DEBUG("Failed to send packet. Error was: '%s'", strerror(errno));
+				batchOffset++;
+				continue;
+			}
+
+			sendCount += res;
+			batchOffset += res;
+		}
 	}
 
 	return sendCount;
@@ -513,6 +717,9 @@ bool RawSocketDevice::open()
 	((SocketContainer*)m_Socket)->fd = fd;
 	((SocketContainer*)m_Socket)->interfaceIndex = ifaceIndex;
 	((SocketContainer*)m_Socket)->interfaceName = ifaceName;
+	((SocketContainer*)m_Socket)->blockingMode = -1;
+	((SocketContainer*)m_Socket)->timeout = -1;
+	((SocketContainer*)m_Socket)->rxBuffers = NULL;
 
 	m_DeviceOpened = true;
 
@@ -535,6 +742,7 @@ void RawSocketDevice::close()
 		closesocket(sockContainer->fd);
 #elif LINUX
 		::close(sockContainer->fd);
+		delete [] sockContainer->rxBuffers;
 #endif
 		delete sockContainer;
 		m_Socket = NULL;
@@ -22,6 +22,7 @@ PTF_TEST_CASE(IPv4FragmentationTest);
 PTF_TEST_CASE(IPv4OptionsParsingTest);
 PTF_TEST_CASE(IPv4OptionsEditTest);
 PTF_TEST_CASE(IPv4UdpChecksum);
+PTF_TEST_CASE(ChecksumComputeAndUpdateTest);
 
 // Implemented in IPv6Tests.cpp
 PTF_TEST_CASE(IPv6UdpPacketParseAndCreate);
@@ -42,15 +43,23 @@ PTF_TEST_CASE(InsertVlanToPacket);
 PTF_TEST_CASE(RemoveLayerTest);
 PTF_TEST_CASE(CopyLayerAndPacketTest);
 PTF_TEST_CASE(PacketLayerLookupTest);
+PTF_TEST_CASE(LayerLookupBenchmarkTest);
 PTF_TEST_CASE(RawPacketTimeStampSetterTest);
 PTF_TEST_CASE(ParsePartialPacketTest);
 PTF_TEST_CASE(PacketTrailerTest);
 PTF_TEST_CASE(ResizeLayerTest);
+PTF_TEST_CASE(ReuseParsedPacketTest);
+PTF_TEST_CASE(LazyPacketParsingTest);
+PTF_TEST_CASE(FastHash5TupleTest);
+PTF_TEST_CASE(FlowTableTest);
+PTF_TEST_CASE(ConcurrentFlowTableTest);
+PTF_TEST_CASE(PayloadMatcherTest);
 
 // Implemented in HttpTests.cpp
 PTF_TEST_CASE(HttpRequestLayerParsingTest);
 PTF_TEST_CASE(HttpRequestLayerCreationTest);
 PTF_TEST_CASE(HttpRequestLayerEditTest);
+PTF_TEST_CASE(HttpMessageFieldLookupTest);
 PTF_TEST_CASE(HttpResponseLayerParsingTest);
 PTF_TEST_CASE(HttpResponseLayerCreationTest);
 PTF_TEST_CASE(HttpResponseLayerEditTest);
@@ -67,6 +76,7 @@ PTF_TEST_CASE(DnsLayerQueryCreationTest);
 PTF_TEST_CASE(DnsLayerResourceCreationTest);
 PTF_TEST_CASE(DnsLayerEditTest);
 PTF_TEST_CASE(DnsLayerRemoveResourceTest);
+PTF_TEST_CASE(DnsRecordIteratorTest);
 
 // Implemented in IcmpTests.cpp
 PTF_TEST_CASE(IcmpParsingTest);
@@ -98,6 +108,8 @@ PTF_TEST_CASE(SSLMultipleRecordParsing3Test);
 PTF_TEST_CASE(SSLMultipleRecordParsing4Test);
 PTF_TEST_CASE(SSLPartialCertificateParseTest);
 PTF_TEST_CASE(SSLNewSessionTicketParseTest);
+PTF_TEST_CASE(SSLHelloReaderTest);
+PTF_TEST_CASE(SSLFingerprintTest);
 
 // Implemented in IgmpTests.cpp
 PTF_TEST_CASE(IgmpParsingTest);
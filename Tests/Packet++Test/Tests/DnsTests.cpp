@@ -1,6 +1,7 @@
 #include "../TestDefinition.h"
 #include "../Utils/TestUtils.h"
 #include <sstream>
+#include <vector>
 #include "EndianPortable.h"
 #include "Logger.h"
 #include "Packet.h"
@@ -9,6 +10,7 @@
 #include "IPv6Layer.h"
 #include "UdpLayer.h"
 #include "DnsLayer.h"
+#include "DnsRecordIterator.h"
 #include "SystemUtils.h"
 
 
@@ -629,3 +631,144 @@ PTF_TEST_CASE(DnsLayerRemoveResourceTest)
 	PTF_ASSERT_FALSE(dnsLayer4->removeAdditionalRecord("blabla", false));
 	PTF_ASSERT_EQUAL(dnsLayer4->getHeaderLen(), sizeof(pcpp::dnshdr), size);
 } // DnsLayerRemoveResourceTest
+
+
+
+PTF_TEST_CASE(DnsRecordIteratorTest)
+{
+	timeval time;
+	gettimeofday(&time, NULL);
+
+	READ_FILE_AND_CREATE_PACKET(1, "PacketExamples/Dns1.dat");
+	READ_FILE_AND_CREATE_PACKET(2, "PacketExamples/Dns2.dat");
+	READ_FILE_AND_CREATE_PACKET(3, "PacketExamples/Dns3.dat");
+	READ_FILE_AND_CREATE_PACKET(4, "PacketExamples/Dns4.dat");
+
+	pcpp::RawPacket* rawPackets[4] = { &rawPacket1, &rawPacket2, &rawPacket3, &rawPacket4 };
+
+	// the views the iterator fills must match the records DnsLayer parses
+	for (int i = 0; i < 4; i++)
+	{
+		pcpp::Packet dnsPacket(rawPackets[i]);
+		pcpp::DnsLayer* dnsLayer = dnsPacket.getLayerOfType<pcpp::DnsLayer>();
+		PTF_ASSERT_NOT_NULL(dnsLayer);
+
+		std::vector<pcpp::IDnsResource*> resources;
+		for (pcpp::DnsQuery* query = dnsLayer->getFirstQuery(); query != NULL; query = dnsLayer->getNextQuery(query))
+			resources.push_back(query);
+		for (pcpp::DnsResource* answer = dnsLayer->getFirstAnswer(); answer != NULL; answer = dnsLayer->getNextAnswer(answer))
+			resources.push_back(answer);
+		for (pcpp::DnsResource* authority = dnsLayer->getFirstAuthority(); authority != NULL; authority = dnsLayer->getNextAuthority(authority))
+			resources.push_back(authority);
+		for (pcpp::DnsResource* additional = dnsLayer->getFirstAdditionalRecord(); additional != NULL; additional = dnsLayer->getNextAdditionalRecord(additional))
+			resources.push_back(additional);
+
+		pcpp::DnsRecordIterator iter(*dnsLayer);
+		pcpp::DnsRecordView record;
+		char name[PCPP_DNS_MAX_DECODED_NAME_LEN];
+		size_t numOfRecords = 0;
+		while (iter.getNextRecord(record))
+		{
+			PTF_ASSERT_LOWER_THAN(numOfRecords, resources.size(), size);
+			pcpp::IDnsResource* resource = resources[numOfRecords++];
+			PTF_ASSERT_EQUAL(record.getType(), resource->getType(), enum);
+			PTF_ASSERT_EQUAL(record.getOffsetInLayer(), resource->getNameOffset(), size);
+			PTF_ASSERT_EQUAL(record.getDnsType(), resource->getDnsType(), enum);
+			PTF_ASSERT_EQUAL(record.getSize(), resource->getSize(), size);
+			PTF_ASSERT_TRUE(record.decodeName(name, sizeof(name)));
+			PTF_ASSERT_EQUAL(std::string(name), resource->getName(), string);
+			PTF_ASSERT_TRUE(record.isNameEqual(resource->getName()));
+
+			if (record.getType() == pcpp::DnsQueryType)
+			{
+				PTF_ASSERT_EQUAL(record.getDnsClass(), resource->getDnsClass(), enum);
+				PTF_ASSERT_NULL(record.getData());
+				PTF_ASSERT_EQUAL(record.getDataLength(), 0, size);
+				continue;
+			}
+
+			pcpp::DnsResource* dnsResource = (pcpp::DnsResource*)resource;
+			PTF_ASSERT_EQUAL(record.getTTL(), dnsResource->getTTL(), u32);
+			PTF_ASSERT_EQUAL(record.getDataLength(), dnsResource->getDataLength(), size);
+			PTF_ASSERT_EQUAL(record.getDataOffset(), dnsResource->getDataOffset(), size);
+			PTF_ASSERT_TRUE(record.getData() == dnsLayer->getData() + dnsResource->getDataOffset());
+		}
+
+		PTF_ASSERT_FALSE(iter.isMalformed());
+		PTF_ASSERT_EQUAL(numOfRecords, resources.size(), size);
+
+		// iterating over the UDP payload gives the same records
+		pcpp::UdpLayer* udpLayer = dnsPacket.getLayerOfType<pcpp::UdpLayer>();
+		PTF_ASSERT_NOT_NULL(udpLayer);
+		pcpp::DnsRecordIterator payloadIter(udpLayer->getLayerPayload(), udpLayer->getLayerPayloadSize());
+		numOfRecords = 0;
+		while (payloadIter.getNextRecord(record))
+			numOfRecords++;
+		PTF_ASSERT_EQUAL(numOfRecords, resources.size(), size);
+
+		// so does the same message over TCP, with its length field and followed by the beginning of another message
+		std::vector<uint8_t> tcpPayload;
+		tcpPayload.push_back((uint8_t)(udpLayer->getLayerPayloadSize() >> 8));
+		tcpPayload.push_back((uint8_t)udpLayer->getLayerPayloadSize());
+		tcpPayload.insert(tcpPayload.end(), udpLayer->getLayerPayload(), udpLayer->getLayerPayload() + udpLayer->getLayerPayloadSize());
+		tcpPayload.insert(tcpPayload.end(), 20, 0xff);
+		pcpp::DnsRecordIterator tcpIter(&tcpPayload[0], tcpPayload.size(), true);
+		numOfRecords = 0;
+		while (tcpIter.getNextRecord(record))
+		{
+			PTF_ASSERT_EQUAL(record.getOffsetInLayer(), resources[numOfRecords]->getNameOffset(), size);
+			PTF_ASSERT_TRUE(record.decodeName(name, sizeof(name)));
+			PTF_ASSERT_EQUAL(std::string(name), resources[numOfRecords]->getName(), string);
+			numOfRecords++;
+		}
+		PTF_ASSERT_FALSE(tcpIter.isMalformed());
+		PTF_ASSERT_EQUAL(numOfRecords, resources.size(), size);
+
+		iter.reset();
+		PTF_ASSERT_TRUE(iter.getNextRecord(record));
+		PTF_ASSERT_EQUAL(record.getOffsetInLayer(), sizeof(pcpp::dnshdr), size);
+	}
+
+	// wire format name compare is case-insensitive, ignores a trailing '.' and follows compression pointers
+	pcpp::Packet dnsPacket3(&rawPacket3);
+	pcpp::DnsRecordIterator iter3(*dnsPacket3.getLayerOfType<pcpp::DnsLayer>());
+	pcpp::DnsRecordView record;
+	PTF_ASSERT_TRUE(iter3.getNextRecord(record));
+	PTF_ASSERT_TRUE(record.isNameEqual("Yaels-iPhone.local"));
+	PTF_ASSERT_TRUE(record.isNameEqual("yaels-iphone.LOCAL."));
+	PTF_ASSERT_FALSE(record.isNameEqual("Yaels-iPhone"));
+	PTF_ASSERT_FALSE(record.isNameEqual("Yaels-iPhone.local.com"));
+	PTF_ASSERT_FALSE(record.isNameEqual("Yaels-iPhone-local"));
+	PTF_ASSERT_FALSE(record.isNameEqual(""));
+	char shortName[10];
+	PTF_ASSERT_FALSE(record.decodeName(shortName, sizeof(shortName)));
+
+	// a name pointing to itself, the record is found but its name can't be decoded
+	uint8_t pointerLoop[] = { 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0xc0, 0x0c, 0, 1, 0, 1 };
+	pcpp::DnsRecordIterator loopIter(pointerLoop, sizeof(pointerLoop));
+	PTF_ASSERT_TRUE(loopIter.getNextRecord(record));
+	PTF_ASSERT_EQUAL(record.getNameLength(), 2, size);
+	PTF_ASSERT_EQUAL(record.getDnsType(), pcpp::DNS_TYPE_A, enum);
+	char name[PCPP_DNS_MAX_DECODED_NAME_LEN];
+	PTF_ASSERT_FALSE(record.decodeName(name, sizeof(name)));
+	PTF_ASSERT_FALSE(record.isNameEqual(""));
+	PTF_ASSERT_FALSE(loopIter.getNextRecord(record));
+	PTF_ASSERT_FALSE(loopIter.isMalformed());
+
+	// record counts which exceed the data stop the iteration
+	READ_FILE_AND_CREATE_PACKET(5, "PacketExamples/DnsTooManyResources.dat");
+	pcpp::LoggerPP::getInstance().supressErrors();
+	pcpp::Packet dnsPacket5(&rawPacket5);
+	pcpp::LoggerPP::getInstance().enableErrors();
+	pcpp::DnsRecordIterator tooManyIter(*dnsPacket5.getLayerOfType<pcpp::DnsLayer>());
+	while (tooManyIter.getNextRecord(record)) {}
+	PTF_ASSERT_TRUE(tooManyIter.isMalformed());
+
+	pcpp::DnsRecordIterator shortIter(pointerLoop, sizeof(pcpp::dnshdr) - 1);
+	PTF_ASSERT_FALSE(shortIter.getNextRecord(record));
+	PTF_ASSERT_TRUE(shortIter.isMalformed());
+
+	pcpp::DnsRecordIterator shortTcpIter(pointerLoop, 1, true);
+	PTF_ASSERT_FALSE(shortTcpIter.getNextRecord(record));
+	PTF_ASSERT_TRUE(shortTcpIter.isMalformed());
+} // DnsRecordIteratorTest
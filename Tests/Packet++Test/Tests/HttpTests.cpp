@@ -9,6 +9,7 @@
 #include "HttpLayer.h"
 #include "PayloadLayer.h"
 #include "SystemUtils.h"
+#include <sstream>
 
 PTF_TEST_CASE(HttpRequestLayerParsingTest)
 {
@@ -169,6 +170,87 @@ PTF_TEST_CASE(HttpRequestLayerEditTest)
 
 
 
+PTF_TEST_CASE(HttpMessageFieldLookupTest)
+{
+	timeval time;
+	gettimeofday(&time, NULL);
+
+	READ_FILE_AND_CREATE_PACKET(1, "PacketExamples/TwoHttpRequests1.dat");
+
+	pcpp::Packet httpRequest(&rawPacket1);
+	pcpp::HttpRequestLayer* httpReqLayer = httpRequest.getLayerOfType<pcpp::HttpRequestLayer>();
+	PTF_ASSERT_NOT_NULL(httpReqLayer);
+
+	// lookup is case insensitive and matches whole names only
+	pcpp::HeaderField* hostField = httpReqLayer->getFieldByName(PCPP_HTTP_HOST_FIELD);
+	PTF_ASSERT_NOT_NULL(hostField);
+	PTF_ASSERT_EQUAL(httpReqLayer->getFieldByName("HOST"), hostField, object);
+	PTF_ASSERT_EQUAL(httpReqLayer->getFieldByName("hOsT"), hostField, object);
+	PTF_ASSERT_NULL(httpReqLayer->getFieldByName("Hos"));
+	PTF_ASSERT_NULL(httpReqLayer->getFieldByName("Hostx"));
+	PTF_ASSERT_NULL(httpReqLayer->getFieldByName(PCPP_HTTP_HOST_FIELD, 1));
+	PTF_ASSERT_EQUAL(httpReqLayer->getFieldByName("user-AGENT"), httpReqLayer->getFieldByName(PCPP_HTTP_USER_AGENT_FIELD), object);
+	PTF_ASSERT_TRUE(httpReqLayer->getFieldByName(PCPP_END_OF_TEXT_BASED_PROTOCOL_HEADER)->isEndOfHeader());
+
+	// create a message with more fields than are stored inline
+	pcpp::HttpRequestLayer newReqLayer(pcpp::HttpRequestLayer::HttpGET, "/", pcpp::OneDotOne);
+	for (int i = 0; i < 2 * PCPP_TEXT_BASED_PROTOCOL_INLINE_FIELDS; i++)
+	{
+		std::stringstream fieldName;
+		fieldName << "X-Field-" << i;
+		PTF_ASSERT_NOT_NULL(newReqLayer.addField(fieldName.str(), fieldName.str()));
+	}
+	PTF_ASSERT_NOT_NULL(newReqLayer.addEndOfHeader());
+	PTF_ASSERT_EQUAL(newReqLayer.getFieldCount(), 2 * PCPP_TEXT_BASED_PROTOCOL_INLINE_FIELDS, int);
+	PTF_ASSERT_EQUAL(newReqLayer.getFieldByName("x-field-0")->getFieldValue(), "X-Field-0", string);
+	PTF_ASSERT_EQUAL(newReqLayer.getFieldByName("X-FIELD-20")->getFieldValue(), "X-Field-20", string);
+	PTF_ASSERT_NULL(newReqLayer.getFieldByName("X-Field-2", 1));
+
+	// remove fields and make sure the freed fields can be re-used
+	PTF_ASSERT_TRUE(newReqLayer.removeField("X-FIELD-0"));
+	PTF_ASSERT_TRUE(newReqLayer.removeField("x-field-20"));
+	PTF_ASSERT_NULL(newReqLayer.getFieldByName("X-Field-0"));
+	PTF_ASSERT_NULL(newReqLayer.getFieldByName("X-Field-20"));
+	PTF_ASSERT_NOT_NULL(newReqLayer.insertField(newReqLayer.getFieldByName("X-Field-1"), "X-Field-0", "new value"));
+	PTF_ASSERT_EQUAL(newReqLayer.getFieldByName("X-Field-0")->getFieldValue(), "new value", string);
+	PTF_ASSERT_EQUAL(newReqLayer.getNextField(newReqLayer.getFieldByName("X-Field-1")), newReqLayer.getFieldByName("X-Field-0"), object);
+	PTF_ASSERT_EQUAL(newReqLayer.getFieldCount(), 2 * PCPP_TEXT_BASED_PROTOCOL_INLINE_FIELDS - 1, int);
+
+	// a copied message has its own fields which are found the same way
+	pcpp::HttpRequestLayer copiedReqLayer(newReqLayer);
+	PTF_ASSERT_EQUAL(copiedReqLayer.getFieldCount(), newReqLayer.getFieldCount(), int);
+	PTF_ASSERT_NOT_EQUAL(copiedReqLayer.getFieldByName("x-field-0"), newReqLayer.getFieldByName("x-field-0"), object);
+	PTF_ASSERT_EQUAL(copiedReqLayer.getFieldByName("x-field-0")->getFieldValue(), "new value", string);
+	PTF_ASSERT_EQUAL(copiedReqLayer.getFieldByName("X-Field-23")->getFieldValue(), "X-Field-23", string);
+	PTF_ASSERT_EQUAL(copiedReqLayer.getHeaderLen(), newReqLayer.getHeaderLen(), size);
+	PTF_ASSERT_BUF_COMPARE(copiedReqLayer.getData(), newReqLayer.getData(), newReqLayer.getHeaderLen());
+
+	// a line without a name-value separator doesn't swallow the fields after it
+	pcpp::Packet malformedPacket(100);
+	pcpp::EthLayer ethLayer(pcpp::MacAddress("00:50:43:11:22:33"), pcpp::MacAddress("aa:bb:cc:dd:ee:ff"));
+	pcpp::IPv4Layer ip4Layer(pcpp::IPv4Address(std::string("10.0.0.1")), pcpp::IPv4Address(std::string("10.0.0.2")));
+	pcpp::TcpLayer tcpLayer(12345, 80);
+	const char* malformedHttp = "GET / HTTP/1.1\r\nNoSeparator\r\nHost: www.example.com\r\n\r\n";
+	pcpp::PayloadLayer payloadLayer((const uint8_t*)malformedHttp, strlen(malformedHttp), false);
+	PTF_ASSERT_TRUE(malformedPacket.addLayer(&ethLayer));
+	PTF_ASSERT_TRUE(malformedPacket.addLayer(&ip4Layer));
+	PTF_ASSERT_TRUE(malformedPacket.addLayer(&tcpLayer));
+	PTF_ASSERT_TRUE(malformedPacket.addLayer(&payloadLayer));
+	malformedPacket.computeCalculateFields();
+
+	pcpp::Packet parsedMalformedPacket(malformedPacket.getRawPacket());
+	httpReqLayer = parsedMalformedPacket.getLayerOfType<pcpp::HttpRequestLayer>();
+	PTF_ASSERT_NOT_NULL(httpReqLayer);
+	PTF_ASSERT_EQUAL(httpReqLayer->getFieldCount(), 2, int);
+	PTF_ASSERT_EQUAL(httpReqLayer->getFirstField()->getFieldSize(), 13, size);
+	PTF_ASSERT_EQUAL(httpReqLayer->getFirstField()->getFieldValue(), "", string);
+	PTF_ASSERT_NOT_NULL(httpReqLayer->getFieldByName(PCPP_HTTP_HOST_FIELD));
+	PTF_ASSERT_EQUAL(httpReqLayer->getFieldByName(PCPP_HTTP_HOST_FIELD)->getFieldValue(), "www.example.com", string);
+	PTF_ASSERT_TRUE(httpReqLayer->isHeaderComplete());
+} // HttpMessageFieldLookupTest
+
+
+
 PTF_TEST_CASE(HttpResponseLayerParsingTest)
 {
 	// This is a basic parsing test
@@ -8,8 +8,24 @@
 #include "EthLayer.h"
 #include "IPv4Layer.h"
 #include "UdpLayer.h"
+#include "TcpLayer.h"
+#include "IPv6Layer.h"
 #include "PayloadLayer.h"
 #include "SystemUtils.h"
+#include "IpUtils.h"
+
+// a straightforward RFC 1071 checksum over network byte order words, to compare the optimized implementation with
+static uint16_t referenceChecksum(const uint8_t* buffer, size_t len)
+{
+	uint64_t sum = 0;
+	for (size_t i = 0; i + 1 < len; i += 2)
+		sum += (buffer[i] << 8) | buffer[i + 1];
+	if (len % 2 == 1)
+		sum += buffer[len - 1] << 8;
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return (uint16_t)~sum;
+}
 
 PTF_TEST_CASE(IPv4PacketCreation)
 {
@@ -514,4 +530,80 @@ PTF_TEST_CASE(IPv4UdpChecksum)
 		udpLayer->computeCalculateFields();
 		PTF_ASSERT_EQUAL(udpLayer->getUdpHeader()->headerChecksum, packetChecksum, hex);
 	}
-} // Ipv4UdpChecksum
\ No newline at end of file
+} // Ipv4UdpChecksum
+
+
+
+PTF_TEST_CASE(ChecksumComputeAndUpdateTest)
+{
+	// compare with the reference implementation on all lengths and alignments of the vectorized loops and their tails
+	const size_t bufferLen = 200000;
+	uint8_t* buffer = new uint8_t[bufferLen + 4];
+	srand(1);
+	for (size_t i = 0; i < bufferLen + 4; i++)
+		buffer[i] = (uint8_t)rand();
+
+	for (size_t offset = 0; offset < 4; offset++)
+	{
+		for (size_t len = 0; len < 200; len++)
+		{
+			pcpp::ScalarBuffer<uint16_t> vec;
+			vec.buffer = (uint16_t*)(buffer + offset);
+			vec.len = len;
+			PTF_ASSERT_EQUAL(pcpp::compute_checksum(&vec, 1), referenceChecksum(buffer + offset, len), hex);
+		}
+	}
+
+	// a large buffer, and a buffer of all ones which is the worst case for overflowing the sums
+	pcpp::ScalarBuffer<uint16_t> vec;
+	vec.buffer = (uint16_t*)(buffer + 1);
+	vec.len = bufferLen - 1;
+	PTF_ASSERT_EQUAL(pcpp::compute_checksum(&vec, 1), referenceChecksum(buffer + 1, bufferLen - 1), hex);
+	memset(buffer, 0xff, bufferLen);
+	vec.buffer = (uint16_t*)buffer;
+	vec.len = bufferLen;
+	PTF_ASSERT_EQUAL(pcpp::compute_checksum(&vec, 1), referenceChecksum(buffer, bufferLen), hex);
+	delete [] buffer;
+
+	// rewrite an IPv4 address and a TCP port, updating the checksums incrementally
+	timeval time;
+	gettimeofday(&time, NULL);
+
+	READ_FILE_AND_CREATE_PACKET(1, "PacketExamples/TcpPacketNoOptions.dat");
+	pcpp::Packet tcpPacket(&rawPacket1);
+	tcpPacket.computeCalculateFields();
+	pcpp::iphdr* ipHdr = tcpPacket.getLayerOfType<pcpp::IPv4Layer>()->getIPv4Header();
+	pcpp::tcphdr* tcpHdr = tcpPacket.getLayerOfType<pcpp::TcpLayer>()->getTcpHeader();
+
+	uint32_t oldIP = ipHdr->ipSrc;
+	uint32_t newIP = pcpp::IPv4Address("10.20.30.40").toInt();
+	ipHdr->ipSrc = newIP;
+	ipHdr->headerChecksum = pcpp::update_checksum32(ipHdr->headerChecksum, oldIP, newIP);
+	tcpHdr->headerChecksum = pcpp::update_checksum32(tcpHdr->headerChecksum, oldIP, newIP);
+	uint16_t oldPort = tcpHdr->portDst;
+	uint16_t newPort = htobe16(40000);
+	tcpHdr->portDst = newPort;
+	tcpHdr->headerChecksum = pcpp::update_checksum16(tcpHdr->headerChecksum, oldPort, newPort);
+
+	uint16_t ipChecksum = ipHdr->headerChecksum;
+	uint16_t tcpChecksum = tcpHdr->headerChecksum;
+	tcpPacket.computeCalculateFields();
+	PTF_ASSERT_EQUAL(ipHdr->headerChecksum, ipChecksum, hex);
+	PTF_ASSERT_EQUAL(tcpHdr->headerChecksum, tcpChecksum, hex);
+
+	// rewrite an IPv6 address, updating the UDP checksum incrementally
+	READ_FILE_AND_CREATE_PACKET(2, "PacketExamples/IPv6UdpPacket.dat");
+	pcpp::Packet udpPacket(&rawPacket2);
+	udpPacket.computeCalculateFields();
+	pcpp::ip6_hdr* ip6Hdr = udpPacket.getLayerOfType<pcpp::IPv6Layer>()->getIPv6Header();
+	pcpp::udphdr* udpHdr = udpPacket.getLayerOfType<pcpp::UdpLayer>()->getUdpHeader();
+
+	uint8_t oldIPv6[16];
+	memcpy(oldIPv6, ip6Hdr->ipDst, 16);
+	pcpp::IPv6Address("2001:db8::1234").copyTo(ip6Hdr->ipDst);
+	udpHdr->headerChecksum = pcpp::update_checksum(udpHdr->headerChecksum, oldIPv6, ip6Hdr->ipDst, 16);
+
+	uint16_t udpChecksum = udpHdr->headerChecksum;
+	udpPacket.computeCalculateFields();
+	PTF_ASSERT_EQUAL(udpHdr->headerChecksum, udpChecksum, hex);
+} // ChecksumComputeAndUpdateTest
@@ -8,16 +8,23 @@
 #include "IPv6Layer.h"
 #include "PPPoELayer.h"
 #include "VlanLayer.h"
+#include "MplsLayer.h"
+#include "GreLayer.h"
 #include "IcmpLayer.h"
 #include "TcpLayer.h"
 #include "UdpLayer.h"
 #include "IgmpLayer.h"
 #include "DnsLayer.h"
 #include "HttpLayer.h"
+#include "SipLayer.h"
+#include "SdpLayer.h"
 #include "SSLLayer.h"
 #include "RadiusLayer.h"
 #include "PacketTrailerLayer.h"
 #include "PayloadLayer.h"
+#include "PacketUtils.h"
+#include "FlowTable.h"
+#include "PayloadMatcher.h"
 #include "SystemUtils.h"
 
 PTF_TEST_CASE(InsertDataToPacket)
@@ -553,9 +560,137 @@ PTF_TEST_CASE(PacketLayerLookupTest)
 		// try to get nonexistent layer
 		PTF_ASSERT_NULL(vxlanPacket.getLayerOfType<pcpp::RadiusLayer>(true));
 	}
+
+	{
+		// layer classes that share the same protocol
+		READ_FILE_AND_CREATE_PACKET(3, "PacketExamples/SSL-ClientHello1.dat");
+		READ_FILE_AND_CREATE_PACKET(4, "PacketExamples/igmpv3_query.dat");
+		pcpp::Packet sslPacket(&rawPacket3);
+		pcpp::Packet igmpPacket(&rawPacket4);
+
+		pcpp::SSLHandshakeLayer* handshakeLayer = sslPacket.getLayerOfType<pcpp::SSLHandshakeLayer>();
+		PTF_ASSERT_NOT_NULL(handshakeLayer);
+		PTF_ASSERT_EQUAL(sslPacket.getLayerOfType<pcpp::SSLLayer>(), handshakeLayer, object);
+		PTF_ASSERT_NULL(sslPacket.getLayerOfType<pcpp::SSLAlertLayer>());
+		PTF_ASSERT_NULL(sslPacket.getLayerOfType<pcpp::SSLApplicationDataLayer>(true));
+
+		pcpp::IgmpV3QueryLayer* queryLayer = igmpPacket.getLayerOfType<pcpp::IgmpV3QueryLayer>();
+		PTF_ASSERT_NOT_NULL(queryLayer);
+		PTF_ASSERT_EQUAL(igmpPacket.getLayerOfType<pcpp::IgmpLayer>(), queryLayer, object);
+		PTF_ASSERT_NULL(igmpPacket.getLayerOfType<pcpp::IgmpV3ReportLayer>());
+		PTF_ASSERT_NULL(igmpPacket.getLayerOfType<pcpp::IgmpV2Layer>());
+
+		// layer classes that aren't mapped to protocols are looked up using dynamic_cast
+		PTF_ASSERT_EQUAL(sslPacket.getLayerOfType<pcpp::Layer>(), sslPacket.getFirstLayer(), object);
+		PTF_ASSERT_EQUAL(sslPacket.getLayerOfType<pcpp::Layer>(true), sslPacket.getLastLayer(), object);
+	}
 } // PacketLayerLookupTest
 
 
+
+// a layer lookup that checks every layer using dynamic_cast
+template<class TLayer>
+static TLayer* dynamicCastLayerLookup(pcpp::Packet& packet)
+{
+	for (pcpp::Layer* curLayer = packet.getFirstLayer(); curLayer != NULL; curLayer = curLayer->getNextLayer())
+	{
+		TLayer* layer = dynamic_cast<TLayer*>(curLayer);
+		if (layer != NULL)
+			return layer;
+	}
+
+	return NULL;
+}
+
+static double getElapsedNanoSec(const timeval& start, const timeval& end, int numOfLookups)
+{
+	double elapsedUsec = (end.tv_sec - start.tv_sec) * 1000000.0 + (end.tv_usec - start.tv_usec);
+	return elapsedUsec * 1000.0 / numOfLookups;
+}
+
+PTF_TEST_CASE(LayerLookupBenchmarkTest)
+{
+	// build a deep packet: Eth -> VLAN -> VLAN -> MPLS -> MPLS -> IPv4 -> GREv0 -> IPv6 -> UDP -> Payload
+	pcpp::EthLayer ethLayer(pcpp::MacAddress("00:11:22:33:44:55"), pcpp::MacAddress("66:77:88:99:aa:bb"), PCPP_ETHERTYPE_VLAN);
+	pcpp::VlanLayer outerVlanLayer(100, false, 0, PCPP_ETHERTYPE_VLAN);
+	pcpp::VlanLayer innerVlanLayer(200, false, 0, PCPP_ETHERTYPE_MPLS);
+	pcpp::MplsLayer outerMplsLayer(1000, 64, 0, false);
+	pcpp::MplsLayer innerMplsLayer(2000, 64, 0, true);
+	pcpp::IPv4Layer ipv4Layer(pcpp::IPv4Address("10.0.0.1"), pcpp::IPv4Address("10.0.0.2"));
+	ipv4Layer.getIPv4Header()->timeToLive = 64;
+	pcpp::GREv0Layer greLayer;
+	pcpp::IPv6Layer ipv6Layer(pcpp::IPv6Address("2001:db8::1"), pcpp::IPv6Address("2001:db8::2"));
+	pcpp::UdpLayer udpLayer(1234, 5678);
+	uint8_t payload[32] = { 0 };
+	pcpp::PayloadLayer payloadLayer(payload, sizeof(payload), false);
+
+	pcpp::Packet newPacket(200);
+	PTF_ASSERT_TRUE(newPacket.addLayer(&ethLayer));
+	PTF_ASSERT_TRUE(newPacket.addLayer(&outerVlanLayer));
+	PTF_ASSERT_TRUE(newPacket.addLayer(&innerVlanLayer));
+	PTF_ASSERT_TRUE(newPacket.addLayer(&outerMplsLayer));
+	PTF_ASSERT_TRUE(newPacket.addLayer(&innerMplsLayer));
+	PTF_ASSERT_TRUE(newPacket.addLayer(&ipv4Layer));
+	PTF_ASSERT_TRUE(newPacket.addLayer(&greLayer));
+	PTF_ASSERT_TRUE(newPacket.addLayer(&ipv6Layer));
+	PTF_ASSERT_TRUE(newPacket.addLayer(&udpLayer));
+	PTF_ASSERT_TRUE(newPacket.addLayer(&payloadLayer));
+	newPacket.computeCalculateFields();
+	outerMplsLayer.setBottomOfStack(false);
+	innerMplsLayer.setBottomOfStack(true);
+
+	pcpp::Packet deepPacket(newPacket.getRawPacket());
+	PTF_ASSERT_EQUAL(deepPacket.getLastLayer()->getProtocol(), pcpp::GenericPayload, u64);
+	PTF_ASSERT_TRUE(deepPacket.isPacketOfType(pcpp::MPLS));
+	PTF_ASSERT_TRUE(deepPacket.isPacketOfType(pcpp::GREv0));
+	PTF_ASSERT_TRUE(deepPacket.isPacketOfType(pcpp::IPv6));
+
+	// lookups return the same layers as a dynamic_cast lookup
+	pcpp::UdpLayer* deepUdpLayer = deepPacket.getLayerOfType<pcpp::UdpLayer>();
+	PTF_ASSERT_NOT_NULL(deepUdpLayer);
+	PTF_ASSERT_EQUAL(deepUdpLayer, dynamicCastLayerLookup<pcpp::UdpLayer>(deepPacket), object);
+	PTF_ASSERT_EQUAL(deepPacket.getLayerOfType<pcpp::UdpLayer>(true), deepUdpLayer, object);
+	PTF_ASSERT_EQUAL(deepPacket.getLayerOfType<pcpp::GreLayer>(), dynamicCastLayerLookup<pcpp::GREv0Layer>(deepPacket), object);
+	PTF_ASSERT_EQUAL(deepPacket.getLayerOfType<pcpp::IPv6Layer>(), dynamicCastLayerLookup<pcpp::IPv6Layer>(deepPacket), object);
+	PTF_ASSERT_NULL(deepPacket.getLayerOfType<pcpp::GREv1Layer>());
+	PTF_ASSERT_NULL(deepPacket.getLayerOfType<pcpp::TcpLayer>(true));
+	pcpp::VlanLayer* deepVlanLayer = deepPacket.getLayerOfType<pcpp::VlanLayer>();
+	PTF_ASSERT_NOT_NULL(deepVlanLayer);
+	PTF_ASSERT_EQUAL(deepPacket.getNextLayerOfType<pcpp::VlanLayer>(deepVlanLayer), deepVlanLayer->getNextLayer(), object);
+	pcpp::IPv4Layer* deepIPv4Layer = deepPacket.getLayerOfType<pcpp::IPv4Layer>();
+	PTF_ASSERT_NOT_NULL(deepIPv4Layer);
+	PTF_ASSERT_EQUAL(deepPacket.getPrevLayerOfType<pcpp::MplsLayer>(deepIPv4Layer), deepIPv4Layer->getPrevLayer(), object);
+
+	// compare the lookup cost with a dynamic_cast lookup. The results are printed in verbose mode
+	const int numOfLookups = 100000;
+	int numOfLayersFound = 0;
+	timeval start, end;
+
+	gettimeofday(&start, NULL);
+	for (int i = 0; i < numOfLookups; i++)
+		numOfLayersFound += (dynamicCastLayerLookup<pcpp::UdpLayer>(deepPacket) != NULL);
+	gettimeofday(&end, NULL);
+	double dynamicCastNanoSec = getElapsedNanoSec(start, end, numOfLookups);
+
+	gettimeofday(&start, NULL);
+	for (int i = 0; i < numOfLookups; i++)
+		numOfLayersFound += (deepPacket.getLayerOfType<pcpp::UdpLayer>() != NULL);
+	gettimeofday(&end, NULL);
+	double protocolLookupNanoSec = getElapsedNanoSec(start, end, numOfLookups);
+
+	gettimeofday(&start, NULL);
+	for (int i = 0; i < numOfLookups; i++)
+		numOfLayersFound += (deepPacket.getLayerOfType<pcpp::TcpLayer>() != NULL);
+	gettimeofday(&end, NULL);
+	double missingLayerNanoSec = getElapsedNanoSec(start, end, numOfLookups);
+
+	PTF_ASSERT_EQUAL(numOfLayersFound, 2 * numOfLookups, int);
+
+	PTF_PRINT_VERBOSE("UDP layer lookup in a %d layer packet: dynamic_cast: %.1f ns, protocol: %.1f ns", 10, dynamicCastNanoSec, protocolLookupNanoSec);
+	PTF_PRINT_VERBOSE("Lookup of a layer the packet doesn't contain: %.1f ns", missingLayerNanoSec);
+} // LayerLookupBenchmarkTest
+
+
 PTF_TEST_CASE(RawPacketTimeStampSetterTest)
 {
 	timeval time;
@@ -915,4 +1050,805 @@ PTF_TEST_CASE(ResizeLayerTest)
 	PTF_ASSERT_EQUAL(rawData2[5], 0xAD, u8);
 	PTF_ASSERT_EQUAL(rawData2[6], 0xBE, u8);
 	PTF_ASSERT_EQUAL(rawData2[7], 0xEF, u8);
-} // ResizeLayerTest
\ No newline at end of file
+} // ResizeLayerTest
+
+
+PTF_TEST_CASE(ReuseParsedPacketTest)
+{
+	timeval time;
+	gettimeofday(&time, NULL);
+
+	READ_FILE_AND_CREATE_PACKET(1, "PacketExamples/TwoHttpRequests1.dat");
+	READ_FILE_AND_CREATE_PACKET(2, "PacketExamples/Dns1.dat");
+
+	pcpp::Packet packet(&rawPacket1);
+	PTF_ASSERT_TRUE(packet.isPacketOfType(pcpp::HTTPRequest));
+	pcpp::Layer* ethLayer = packet.getFirstLayer();
+	pcpp::Layer* httpLayer = packet.getLayerOfType<pcpp::HttpRequestLayer>();
+	PTF_ASSERT_NOT_NULL(httpLayer);
+
+	// re-parsing the same packet should re-use the memory of the layers previously created
+	packet.setRawPacket(&rawPacket1, false);
+	PTF_ASSERT_TRUE(packet.isPacketOfType(pcpp::HTTPRequest));
+	PTF_ASSERT_EQUAL(packet.getFirstLayer(), ethLayer, object);
+	PTF_ASSERT_EQUAL(packet.getLayerOfType<pcpp::HttpRequestLayer>(), httpLayer, object);
+	PTF_ASSERT_EQUAL(packet.getLayerOfType<pcpp::HttpRequestLayer>()->getFirstLine()->getUri(), "/home/0,7340,L-8,00.html", string);
+
+	// parse a packet with a different structure and go back to the original one
+	packet.setRawPacket(&rawPacket2, false);
+	PTF_ASSERT_TRUE(packet.isPacketOfType(pcpp::DNS));
+	PTF_ASSERT_FALSE(packet.isPacketOfType(pcpp::TCP));
+	PTF_ASSERT_NOT_NULL(packet.getLayerOfType<pcpp::DnsLayer>());
+	PTF_ASSERT_NOT_NULL(packet.getLayerOfType<pcpp::DnsLayer>()->getFirstQuery());
+
+	packet.setRawPacket(&rawPacket1, false, pcpp::TCP);
+	PTF_ASSERT_TRUE(packet.isPacketOfType(pcpp::TCP));
+	PTF_ASSERT_NULL(packet.getLayerOfType<pcpp::HttpRequestLayer>());
+	PTF_ASSERT_NULL(packet.getLayerOfType<pcpp::TcpLayer>()->getNextLayer());
+
+	// layers detached from a reused packet are owned by the user and freed with delete
+	packet.setRawPacket(&rawPacket1, false);
+	pcpp::Layer* detachedLayer = packet.detachLayer(pcpp::HTTPRequest);
+	PTF_ASSERT_NOT_NULL(detachedLayer);
+	PTF_ASSERT_FALSE(packet.isPacketOfType(pcpp::HTTPRequest));
+	packet.setRawPacket(&rawPacket2, false);
+	PTF_ASSERT_TRUE(packet.isPacketOfType(pcpp::DNS));
+	PTF_ASSERT_FALSE(detachedLayer->isAllocatedToPacket());
+	delete detachedLayer;
+} // ReuseParsedPacketTest
+
+
+
+PTF_TEST_CASE(LazyPacketParsingTest)
+{
+	timeval time;
+	gettimeofday(&time, NULL);
+
+	READ_FILE_AND_CREATE_PACKET(1, "PacketExamples/TwoHttpRequests1.dat");
+	READ_FILE_AND_CREATE_PACKET(2, "PacketExamples/Dns1.dat");
+	READ_FILE_AND_CREATE_PACKET(3, "PacketExamples/sip_req1.dat");
+	READ_FILE_AND_CREATE_PACKET(4, "PacketExamples/packet_trailer_ipv6.dat");
+
+	// protocols are known right away, the layers above TCP are created on first access
+	pcpp::Packet httpPacket(&rawPacket1, false, pcpp::UnknownProtocol, pcpp::OsiModelLayerUnknown, true);
+	PTF_ASSERT_FALSE(httpPacket.areAllLayersParsed());
+	PTF_ASSERT_TRUE(httpPacket.isPacketOfType(pcpp::HTTPRequest));
+	PTF_ASSERT_TRUE(httpPacket.isPacketOfType(pcpp::TCP));
+	PTF_ASSERT_FALSE(httpPacket.isPacketOfType(pcpp::UDP));
+	PTF_ASSERT_FALSE(httpPacket.isPacketOfType(pcpp::SSL));
+	PTF_ASSERT_NULL(httpPacket.getLayerOfType(pcpp::DNS));
+	pcpp::TcpLayer* tcpLayer = httpPacket.getLayerOfType<pcpp::TcpLayer>();
+	PTF_ASSERT_NOT_NULL(tcpLayer);
+	PTF_ASSERT_EQUAL(be16toh(tcpLayer->getTcpHeader()->portDst), 80, u16);
+	PTF_ASSERT_FALSE(httpPacket.areAllLayersParsed());
+	pcpp::HttpRequestLayer* httpLayer = dynamic_cast<pcpp::HttpRequestLayer*>(tcpLayer->getNextLayer());
+	PTF_ASSERT_TRUE(httpPacket.areAllLayersParsed());
+	PTF_ASSERT_NOT_NULL(httpLayer);
+	PTF_ASSERT_EQUAL(httpLayer->getFirstLine()->getUri(), "/home/0,7340,L-8,00.html", string);
+	PTF_ASSERT_EQUAL(httpPacket.getLastLayer(), httpLayer, object);
+
+	// the packet looks the same as a packet parsed in one go
+	pcpp::Packet eagerHttpPacket(&rawPacket1);
+	pcpp::Packet lazyHttpPacket(&rawPacket1, false, pcpp::UnknownProtocol, pcpp::OsiModelLayerUnknown, true);
+	PTF_ASSERT_EQUAL(lazyHttpPacket.toString(), eagerHttpPacket.toString(), string);
+	PTF_ASSERT_TRUE(lazyHttpPacket.areAllLayersParsed());
+
+	// looking for a protocol the packet doesn't contain doesn't create the remaining layers
+	pcpp::Packet dnsPacket(&rawPacket2, false, pcpp::UnknownProtocol, pcpp::OsiModelLayerUnknown, true);
+	PTF_ASSERT_TRUE(dnsPacket.isPacketOfType(pcpp::DNS));
+	PTF_ASSERT_FALSE(dnsPacket.isPacketOfType(pcpp::TCP));
+	PTF_ASSERT_FALSE(dnsPacket.isPacketOfType(pcpp::GenericPayload));
+	PTF_ASSERT_FALSE(dnsPacket.isPacketOfType(pcpp::PacketTrailer));
+	PTF_ASSERT_NULL(dnsPacket.getLayerOfType(pcpp::TCP));
+	PTF_ASSERT_NULL(dnsPacket.getLayerOfType<pcpp::TcpLayer>());
+	PTF_ASSERT_NOT_NULL(dnsPacket.getLayerOfType<pcpp::UdpLayer>(true));
+	PTF_ASSERT_NOT_NULL(dnsPacket.getLayerOfType<pcpp::IPv4Layer>(true));
+	PTF_ASSERT_FALSE(dnsPacket.areAllLayersParsed());
+	PTF_ASSERT_NOT_NULL(dnsPacket.getLayerOfType(pcpp::DNS));
+	PTF_ASSERT_TRUE(dnsPacket.areAllLayersParsed());
+
+	// the SIP message body can only be identified by creating the SIP layer
+	pcpp::Packet sdpPacket(&rawPacket3, false, pcpp::UnknownProtocol, pcpp::OsiModelLayerUnknown, true);
+	PTF_ASSERT_TRUE(sdpPacket.isPacketOfType(pcpp::SIPRequest));
+	PTF_ASSERT_FALSE(sdpPacket.isPacketOfType(pcpp::DNS));
+	PTF_ASSERT_FALSE(sdpPacket.areAllLayersParsed());
+	PTF_ASSERT_TRUE(sdpPacket.isPacketOfType(pcpp::SDP));
+	PTF_ASSERT_TRUE(sdpPacket.areAllLayersParsed());
+	PTF_ASSERT_NOT_NULL(sdpPacket.getLayerOfType<pcpp::SdpLayer>());
+
+	// a packet trailer is detected without creating the remaining layers
+	pcpp::Packet trailerPacket(&rawPacket4, false, pcpp::UnknownProtocol, pcpp::OsiModelLayerUnknown, true);
+	PTF_ASSERT_TRUE(trailerPacket.isPacketOfType(pcpp::DNS));
+	PTF_ASSERT_TRUE(trailerPacket.isPacketOfType(pcpp::PacketTrailer));
+	PTF_ASSERT_FALSE(trailerPacket.areAllLayersParsed());
+	PTF_ASSERT_NOT_NULL(trailerPacket.getLastLayer());
+	PTF_ASSERT_TRUE(trailerPacket.areAllLayersParsed());
+	PTF_ASSERT_EQUAL(trailerPacket.getLastLayer()->getProtocol(), pcpp::PacketTrailer, u64);
+	PTF_ASSERT_EQUAL(trailerPacket.getLayerOfType<pcpp::DnsLayer>()->getDataLen(), 398, size);
+
+	// editing a packet creates the remaining layers first
+	pcpp::Packet editedPacket(&rawPacket1, false, pcpp::UnknownProtocol, pcpp::OsiModelLayerUnknown, true);
+	pcpp::PayloadLayer newPayload((uint8_t*)"abcd", 4, false);
+	PTF_ASSERT_TRUE(editedPacket.addLayer(&newPayload));
+	PTF_ASSERT_TRUE(editedPacket.areAllLayersParsed());
+	PTF_ASSERT_EQUAL(editedPacket.getLastLayer(), &newPayload, object);
+	PTF_ASSERT_EQUAL(newPayload.getPrevLayer()->getProtocol(), pcpp::HTTPRequest, u64);
+	PTF_ASSERT_TRUE(editedPacket.removeLayer(pcpp::GenericPayload));
+
+	// copying a packet copies all of its layers
+	pcpp::Packet lazySdpPacket(&rawPacket3, false, pcpp::UnknownProtocol, pcpp::OsiModelLayerUnknown, true);
+	pcpp::Packet copiedPacket(lazySdpPacket);
+	PTF_ASSERT_TRUE(copiedPacket.areAllLayersParsed());
+	PTF_ASSERT_NOT_NULL(copiedPacket.getLayerOfType<pcpp::SdpLayer>());
+
+	// a reused packet can switch between lazy and full parsing
+	pcpp::Packet reusedPacket(&rawPacket2, false, pcpp::UnknownProtocol, pcpp::OsiModelLayerUnknown, true);
+	reusedPacket.setRawPacket(&rawPacket1, false, pcpp::UnknownProtocol, pcpp::OsiModelLayerUnknown, true);
+	PTF_ASSERT_TRUE(reusedPacket.isPacketOfType(pcpp::HTTPRequest));
+	PTF_ASSERT_FALSE(reusedPacket.isPacketOfType(pcpp::DNS));
+	PTF_ASSERT_FALSE(reusedPacket.areAllLayersParsed());
+	reusedPacket.setRawPacket(&rawPacket2, false);
+	PTF_ASSERT_TRUE(reusedPacket.areAllLayersParsed());
+	PTF_ASSERT_NOT_NULL(reusedPacket.getLayerOfType<pcpp::DnsLayer>());
+
+	// parsing up to a certain layer ignores lazy parsing
+	reusedPacket.setRawPacket(&rawPacket1, false, pcpp::TCP, pcpp::OsiModelLayerUnknown, true);
+	PTF_ASSERT_TRUE(reusedPacket.areAllLayersParsed());
+	PTF_ASSERT_FALSE(reusedPacket.isPacketOfType(pcpp::HTTPRequest));
+} // LazyPacketParsingTest
+
+
+// a straightforward implementation of fastHash5Tuple() on top of a parsed packet, with a bit-by-bit CRC32C
+static uint32_t fastHash5TupleReference(pcpp::Packet& packet)
+{
+	const uint8_t* srcAddr = NULL;
+	const uint8_t* dstAddr = NULL;
+	size_t addrLen = 0;
+	bool isFragment = false;
+	pcpp::IPv4Layer* ipv4Layer = packet.getLayerOfType<pcpp::IPv4Layer>();
+	pcpp::IPv6Layer* ipv6Layer = packet.getLayerOfType<pcpp::IPv6Layer>();
+	if (ipv4Layer != NULL)
+	{
+		srcAddr = (const uint8_t*)&ipv4Layer->getIPv4Header()->ipSrc;
+		dstAddr = (const uint8_t*)&ipv4Layer->getIPv4Header()->ipDst;
+		addrLen = 4;
+		isFragment = ipv4Layer->isFragment();
+	}
+	else if (ipv6Layer != NULL)
+	{
+		srcAddr = ipv6Layer->getIPv6Header()->ipSrc;
+		dstAddr = ipv6Layer->getIPv6Header()->ipDst;
+		addrLen = 16;
+		isFragment = ipv6Layer->isFragment();
+	}
+	else
+		return 0;
+
+	uint8_t protocol = 0;
+	const uint8_t* ports = NULL;
+	pcpp::TcpLayer* tcpLayer = packet.getLayerOfType<pcpp::TcpLayer>();
+	pcpp::UdpLayer* udpLayer = packet.getLayerOfType<pcpp::UdpLayer>();
+	if (!isFragment && tcpLayer != NULL)
+	{
+		ports = tcpLayer->getData();
+		protocol = pcpp::PACKETPP_IPPROTO_TCP;
+	}
+	else if (!isFragment && udpLayer != NULL)
+	{
+		ports = udpLayer->getData();
+		protocol = pcpp::PACKETPP_IPPROTO_UDP;
+	}
+
+	uint8_t input[37];
+	size_t inputLen = 0;
+	bool swap = memcmp(srcAddr, dstAddr, addrLen) > 0 || (memcmp(srcAddr, dstAddr, addrLen) == 0 && ports != NULL && memcmp(ports, ports + 2, 2) > 0);
+	memcpy(input, swap ? dstAddr : srcAddr, addrLen);
+	memcpy(input + addrLen, swap ? srcAddr : dstAddr, addrLen);
+	inputLen = 2 * addrLen;
+	if (ports != NULL)
+	{
+		memcpy(input + inputLen, swap ? ports + 2 : ports, 2);
+		memcpy(input + inputLen + 2, swap ? ports : ports + 2, 2);
+		input[inputLen + 4] = protocol;
+		inputLen += 5;
+	}
+
+	uint32_t crc = 0xffffffff;
+	for (size_t i = 0; i < inputLen; i++)
+	{
+		crc ^= input[i];
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0x82f63b78 : (crc >> 1);
+	}
+
+	return ~crc;
+}
+
+
+
+PTF_TEST_CASE(FastHash5TupleTest)
+{
+	timeval time;
+	gettimeofday(&time, NULL);
+
+	// packets of different link types and encapsulations should hash the same as the reference implementation
+
+	const char* ethPacketFiles[] = {
+		"PacketExamples/TcpPacketWithOptions.dat",
+		"PacketExamples/UdpPacket.dat",
+		"PacketExamples/IPv6UdpPacket.dat",
+		"PacketExamples/MplsPackets1.dat",
+		"PacketExamples/IcmpEchoRequest.dat",
+		"PacketExamples/ipv6_options_multi.dat",
+		"PacketExamples/ipv6_options_ah.dat",
+		"PacketExamples/IPv4Frag1.dat",
+		"PacketExamples/IPv4Frag2.dat",
+		"PacketExamples/IPv6Frag1.dat",
+		"PacketExamples/IPv6Frag2.dat"
+	};
+
+	for (size_t i = 0; i < sizeof(ethPacketFiles) / sizeof(ethPacketFiles[0]); i++)
+	{
+		READ_FILE_AND_CREATE_PACKET(1, ethPacketFiles[i]);
+		pcpp::Packet packet(&rawPacket1);
+		PTF_ASSERT_EQUAL(pcpp::fastHash5Tuple(&rawPacket1), fastHash5TupleReference(packet), u32);
+		PTF_ASSERT_NOT_EQUAL(pcpp::fastHash5Tuple(&rawPacket1), 0, u32);
+	}
+
+	READ_FILE_AND_CREATE_PACKET_LINKTYPE(1, "PacketExamples/SllPacket2.dat", pcpp::LINKTYPE_LINUX_SLL);
+	pcpp::Packet sllPacket(&rawPacket1);
+	PTF_ASSERT_TRUE(sllPacket.isPacketOfType(pcpp::IP));
+	PTF_ASSERT_EQUAL(pcpp::fastHash5Tuple(&rawPacket1), fastHash5TupleReference(sllPacket), u32);
+
+	READ_FILE_AND_CREATE_PACKET_LINKTYPE(2, "PacketExamples/NullLoopback1.dat", pcpp::LINKTYPE_NULL);
+	pcpp::Packet nullPacket(&rawPacket2);
+	PTF_ASSERT_TRUE(nullPacket.isPacketOfType(pcpp::IP));
+	PTF_ASSERT_EQUAL(pcpp::fastHash5Tuple(&rawPacket2), fastHash5TupleReference(nullPacket), u32);
+
+	// a raw IP packet hashes the same as the Ethernet packet it was taken from
+	READ_FILE_AND_CREATE_PACKET(3, "PacketExamples/TcpPacketWithOptions.dat");
+	PTF_ASSERT_EQUAL(pcpp::fastHash5Tuple(buffer3 + sizeof(pcpp::ether_header), bufferLength3 - sizeof(pcpp::ether_header), pcpp::LINKTYPE_RAW),
+		pcpp::fastHash5Tuple(&rawPacket3), u32);
+	PTF_ASSERT_EQUAL(pcpp::fastHash5Tuple(buffer3, 30), 0, u32);
+
+	// all fragments of a packet get the same hash
+	READ_FILE_AND_CREATE_PACKET(4, "PacketExamples/IPv4Frag1.dat");
+	READ_FILE_AND_CREATE_PACKET(5, "PacketExamples/IPv4Frag3.dat");
+	PTF_ASSERT_EQUAL(pcpp::fastHash5Tuple(&rawPacket4), pcpp::fastHash5Tuple(&rawPacket5), u32);
+
+	// non-IP packets
+	READ_FILE_AND_CREATE_PACKET(6, "PacketExamples/ArpRequestWithVlan.dat");
+	PTF_ASSERT_EQUAL(pcpp::fastHash5Tuple(&rawPacket6), 0, u32);
+	READ_FILE_AND_CREATE_PACKET(7, "PacketExamples/PPPoEDiscovery1.dat");
+	PTF_ASSERT_EQUAL(pcpp::fastHash5Tuple(&rawPacket7), 0, u32);
+
+	// the hash is symmetric and skips VLAN tags (including 802.1ad ones) and PPPoE session headers
+	pcpp::MacAddress srcMac("aa:aa:aa:aa:aa:aa");
+	pcpp::MacAddress dstMac("bb:bb:bb:bb:bb:bb");
+	pcpp::IPv4Address clientIP(std::string("10.0.0.1"));
+	pcpp::IPv4Address serverIP(std::string("192.168.100.200"));
+
+	pcpp::EthLayer ethLayer1(srcMac, dstMac, 0x88a8);
+	pcpp::VlanLayer outerVlanLayer(100, false, 1, PCPP_ETHERTYPE_VLAN);
+	pcpp::VlanLayer innerVlanLayer(200, false, 1, PCPP_ETHERTYPE_IP);
+	pcpp::IPv4Layer ipLayer1(clientIP, serverIP);
+	ipLayer1.getIPv4Header()->timeToLive = 64;
+	pcpp::TcpLayer tcpLayer1(43210, 443);
+	pcpp::Packet clientToServer(100);
+	PTF_ASSERT_TRUE(clientToServer.addLayer(&ethLayer1));
+	PTF_ASSERT_TRUE(clientToServer.addLayer(&outerVlanLayer));
+	PTF_ASSERT_TRUE(clientToServer.addLayer(&innerVlanLayer));
+	PTF_ASSERT_TRUE(clientToServer.addLayer(&ipLayer1));
+	PTF_ASSERT_TRUE(clientToServer.addLayer(&tcpLayer1));
+	clientToServer.computeCalculateFields();
+
+	pcpp::EthLayer ethLayer2(dstMac, srcMac, PCPP_ETHERTYPE_PPPOES);
+	pcpp::PPPoESessionLayer pppoeLayer(1, 1, 0x11, PCPP_PPP_IP);
+	pcpp::IPv4Layer ipLayer2(serverIP, clientIP);
+	ipLayer2.getIPv4Header()->timeToLive = 64;
+	pcpp::TcpLayer tcpLayer2(443, 43210);
+	pcpp::Packet serverToClient(100);
+	PTF_ASSERT_TRUE(serverToClient.addLayer(&ethLayer2));
+	PTF_ASSERT_TRUE(serverToClient.addLayer(&pppoeLayer));
+	PTF_ASSERT_TRUE(serverToClient.addLayer(&ipLayer2));
+	PTF_ASSERT_TRUE(serverToClient.addLayer(&tcpLayer2));
+	serverToClient.computeCalculateFields();
+
+	uint32_t clientToServerHash = pcpp::fastHash5Tuple(clientToServer.getRawPacket());
+	PTF_ASSERT_NOT_EQUAL(clientToServerHash, 0, u32);
+	PTF_ASSERT_EQUAL(clientToServerHash, fastHash5TupleReference(clientToServer), u32);
+	PTF_ASSERT_EQUAL(clientToServerHash, pcpp::fastHash5Tuple(serverToClient.getRawPacket()), u32);
+
+	// a different port gets a different hash
+	tcpLayer2.getTcpHeader()->portDst = htobe16(43211);
+	PTF_ASSERT_NOT_EQUAL(clientToServerHash, pcpp::fastHash5Tuple(serverToClient.getRawPacket()), u32);
+} // FastHash5TupleTest
+
+
+
+struct FlowTableClosedFlow
+{
+	pcpp::FlowKey key;
+	pcpp::FlowCloseReason reason;
+	int state;
+};
+
+static void flowTableOnFlowClosed(pcpp::FlowTable<int>::Flow& flow, pcpp::FlowCloseReason reason, void* userCookie)
+{
+	FlowTableClosedFlow closedFlow;
+	closedFlow.key = flow.getKey();
+	closedFlow.reason = reason;
+	closedFlow.state = flow.getState();
+	((std::vector<FlowTableClosedFlow>*)userCookie)->push_back(closedFlow);
+}
+
+static void flowTableCountFlows(pcpp::FlowTable<int>::Flow& flow, void* userCookie)
+{
+	(*(int*)userCookie)++;
+}
+
+struct FlowTableCallbackCheck
+{
+	pcpp::FlowTable<int>* table;
+	int numOfClosedFlows;
+	int numOfClosedFlowsFound;
+	size_t numOfFlows;
+	int numOfVisitedFlows;
+
+	FlowTableCallbackCheck() : table(NULL), numOfClosedFlows(0), numOfClosedFlowsFound(0), numOfFlows(0), numOfVisitedFlows(0) {}
+};
+
+static void flowTableCheckOnFlowClosed(pcpp::FlowTable<int>::Flow& flow, pcpp::FlowCloseReason reason, void* userCookie)
+{
+	FlowTableCallbackCheck* check = (FlowTableCallbackCheck*)userCookie;
+	check->numOfClosedFlows++;
+	if (check->table->getFlow(flow.getKey()) != NULL)
+		check->numOfClosedFlowsFound++;
+	check->numOfFlows = check->table->getNumOfFlows();
+	check->numOfVisitedFlows = 0;
+	check->table->forEachFlow(flowTableCountFlows, &check->numOfVisitedFlows);
+}
+
+PTF_TEST_CASE(FlowTableTest)
+{
+	timeval time;
+	gettimeofday(&time, NULL);
+
+	READ_FILE_AND_CREATE_PACKET(1, "PacketExamples/TwoHttpRequests1.dat");
+	READ_FILE_AND_CREATE_PACKET(2, "PacketExamples/IPv6UdpPacket.dat");
+	READ_FILE_AND_CREATE_PACKET(3, "PacketExamples/IcmpDestUnreachableUdp.dat");
+	READ_FILE_AND_CREATE_PACKET(4, "PacketExamples/ArpRequestPacket.dat");
+	READ_FILE_AND_CREATE_PACKET(5, "PacketExamples/ipv6_options_hop_by_hop.dat");
+	READ_FILE_AND_CREATE_PACKET(6, "PacketExamples/IPv6Frag2.dat");
+
+	// keys set from packets
+	pcpp::Packet tcpPacket(&rawPacket1);
+	pcpp::FlowKey tcpKey;
+	PTF_ASSERT_TRUE(tcpKey.setFromPacket(&tcpPacket));
+	PTF_ASSERT_TRUE(tcpKey.isValid());
+	pcpp::IPv4Layer* ipv4Layer = tcpPacket.getLayerOfType<pcpp::IPv4Layer>();
+	pcpp::TcpLayer* tcpLayer = tcpPacket.getLayerOfType<pcpp::TcpLayer>();
+	PTF_ASSERT_EQUAL(tcpKey.getSrcIP(), pcpp::IPAddress(ipv4Layer->getSrcIpAddress()), object);
+	PTF_ASSERT_EQUAL(tcpKey.getDstIP(), pcpp::IPAddress(ipv4Layer->getDstIpAddress()), object);
+	PTF_ASSERT_EQUAL(tcpKey.getSrcPort(), be16toh(tcpLayer->getTcpHeader()->portSrc), u16);
+	PTF_ASSERT_EQUAL(tcpKey.getDstPort(), be16toh(tcpLayer->getTcpHeader()->portDst), u16);
+	PTF_ASSERT_EQUAL(tcpKey.getProtocol(), pcpp::PACKETPP_IPPROTO_TCP, u8);
+
+	pcpp::FlowKey reverseTcpKey(tcpKey.getDstIP(), tcpKey.getSrcIP(), tcpKey.getDstPort(), tcpKey.getSrcPort(), pcpp::PACKETPP_IPPROTO_TCP);
+	PTF_ASSERT_TRUE(reverseTcpKey == tcpKey);
+	PTF_ASSERT_FALSE(reverseTcpKey.isSameDirection(tcpKey));
+	PTF_ASSERT_EQUAL(reverseTcpKey.getHash(), tcpKey.getHash(), u32);
+	PTF_ASSERT_EQUAL(reverseTcpKey.getSrcIP(), tcpKey.getDstIP(), object);
+	PTF_ASSERT_EQUAL(reverseTcpKey.getSrcPort(), tcpKey.getDstPort(), u16);
+	PTF_ASSERT_TRUE(pcpp::FlowKey(tcpKey.getSrcIP(), tcpKey.getDstIP(), tcpKey.getSrcPort(), tcpKey.getDstPort(), pcpp::PACKETPP_IPPROTO_TCP).isSameDirection(tcpKey));
+	PTF_ASSERT_TRUE(pcpp::FlowKey(tcpKey.getSrcIP(), tcpKey.getDstIP(), tcpKey.getSrcPort(), tcpKey.getDstPort(), pcpp::PACKETPP_IPPROTO_UDP) != tcpKey);
+	PTF_ASSERT_TRUE(pcpp::FlowKey(tcpKey.getSrcIP(), tcpKey.getDstIP(), tcpKey.getSrcPort(), tcpKey.getDstPort() + 1, pcpp::PACKETPP_IPPROTO_TCP) != tcpKey);
+
+	pcpp::Packet udpPacket(&rawPacket2);
+	pcpp::FlowKey udpKey;
+	PTF_ASSERT_TRUE(udpKey.setFromPacket(&udpPacket));
+	PTF_ASSERT_EQUAL(udpKey.getSrcIP(), pcpp::IPAddress(udpPacket.getLayerOfType<pcpp::IPv6Layer>()->getSrcIpAddress()), object);
+	PTF_ASSERT_EQUAL(udpKey.getDstPort(), be16toh(udpPacket.getLayerOfType<pcpp::UdpLayer>()->getUdpHeader()->portDst), u16);
+	PTF_ASSERT_EQUAL(udpKey.getProtocol(), pcpp::PACKETPP_IPPROTO_UDP, u8);
+
+	// the IP and UDP headers inside the ICMP message aren't used for the key
+	pcpp::Packet icmpPacket(&rawPacket3);
+	PTF_ASSERT_TRUE(icmpPacket.isPacketOfType(pcpp::UDP));
+	pcpp::FlowKey icmpKey;
+	PTF_ASSERT_TRUE(icmpKey.setFromPacket(&icmpPacket));
+	PTF_ASSERT_EQUAL(icmpKey.getSrcIP(), pcpp::IPAddress(icmpPacket.getLayerOfType<pcpp::IPv4Layer>()->getSrcIpAddress()), object);
+	PTF_ASSERT_EQUAL(icmpKey.getProtocol(), pcpp::PACKETPP_IPPROTO_ICMP, u8);
+	PTF_ASSERT_EQUAL(icmpKey.getSrcPort(), 0, u16);
+	PTF_ASSERT_EQUAL(icmpKey.getDstPort(), 0, u16);
+
+	// for IPv6 packets the protocol is taken from the last extension header
+	pcpp::Packet ipv6ExtPacket(&rawPacket5);
+	pcpp::FlowKey ipv6ExtKey;
+	PTF_ASSERT_TRUE(ipv6ExtKey.setFromPacket(&ipv6ExtPacket));
+	PTF_ASSERT_EQUAL(ipv6ExtKey.getProtocol(), pcpp::PACKETPP_IPPROTO_ICMPV6, u8);
+	pcpp::Packet ipv6FragPacket(&rawPacket6);
+	pcpp::FlowKey ipv6FragKey;
+	PTF_ASSERT_TRUE(ipv6FragKey.setFromPacket(&ipv6FragPacket));
+	PTF_ASSERT_EQUAL(ipv6FragKey.getProtocol(), pcpp::PACKETPP_IPPROTO_UDP, u8);
+	PTF_ASSERT_EQUAL(ipv6FragKey.getSrcPort(), 0, u16);
+
+	pcpp::Packet arpPacket(&rawPacket4);
+	pcpp::FlowKey arpKey;
+	PTF_ASSERT_FALSE(arpKey.setFromPacket(&arpPacket));
+	PTF_ASSERT_FALSE(arpKey.isValid());
+	PTF_ASSERT_FALSE(pcpp::FlowKey(pcpp::IPAddress(std::string("1.1.1.1")), pcpp::IPAddress(std::string("::1")), 1, 2, pcpp::PACKETPP_IPPROTO_TCP).isValid());
+
+	// bidirectional lookup and flow statistics
+	std::vector<FlowTableClosedFlow> closedFlows;
+	pcpp::FlowTable<int> flowTable(3, 10, 100, flowTableOnFlowClosed, &closedFlows);
+	pcpp::FlowTable<int>::Flow* flow;
+	pcpp::FlowDirection direction;
+	bool isNewFlow;
+
+	pcpp::IPAddress clientIP(std::string("10.0.0.1"));
+	pcpp::IPAddress serverIP(std::string("10.0.0.2"));
+	pcpp::FlowKey keyA(clientIP, serverIP, 5000, 80, pcpp::PACKETPP_IPPROTO_TCP);
+	pcpp::FlowKey keyB(clientIP, serverIP, 5001, 80, pcpp::PACKETPP_IPPROTO_TCP);
+	pcpp::FlowKey keyC(clientIP, serverIP, 5002, 80, pcpp::PACKETPP_IPPROTO_TCP);
+	pcpp::FlowKey keyD(clientIP, serverIP, 5003, 80, pcpp::PACKETPP_IPPROTO_TCP);
+	pcpp::FlowKey reverseKeyA(serverIP, clientIP, 80, 5000, pcpp::PACKETPP_IPPROTO_TCP);
+
+	flow = flowTable.processFlowPacket(reverseKeyA, 1000, 60, &direction, &isNewFlow);
+	PTF_ASSERT_NOT_NULL(flow);
+	PTF_ASSERT_TRUE(isNewFlow);
+	PTF_ASSERT_EQUAL(direction, pcpp::FlowDirectionFromInitiator, enum);
+	PTF_ASSERT_EQUAL(flow->getKey().getSrcPort(), 80, u16);
+	PTF_ASSERT_EQUAL(flow->getState(), 0, int);
+	flow->getState() = 1;
+
+	flow = flowTable.processFlowPacket(keyA, 1001, 1500, &direction, &isNewFlow);
+	PTF_ASSERT_NOT_NULL(flow);
+	PTF_ASSERT_FALSE(isNewFlow);
+	PTF_ASSERT_EQUAL(direction, pcpp::FlowDirectionFromResponder, enum);
+	PTF_ASSERT_EQUAL(flow->getState(), 1, int);
+	PTF_ASSERT_EQUAL(flow->getStartTime(), 1000, int);
+	PTF_ASSERT_EQUAL(flow->getLastSeenTime(), 1001, int);
+	PTF_ASSERT_EQUAL(flow->getNumOfPackets(pcpp::FlowDirectionFromInitiator), 1, u64);
+	PTF_ASSERT_EQUAL(flow->getNumOfPackets(pcpp::FlowDirectionFromResponder), 1, u64);
+	PTF_ASSERT_EQUAL(flow->getNumOfBytes(pcpp::FlowDirectionFromInitiator), 60, u64);
+	PTF_ASSERT_EQUAL(flow->getNumOfBytes(pcpp::FlowDirectionFromResponder), 1500, u64);
+	PTF_ASSERT_EQUAL(flowTable.getFlow(keyA), flow, object);
+	PTF_ASSERT_NULL(flowTable.getFlow(keyB));
+	PTF_ASSERT_NULL(flowTable.processFlowPacket(pcpp::FlowKey(), 1001, 60));
+
+	// a full table evicts the least recently active flow
+	PTF_ASSERT_NOT_NULL(flowTable.processFlowPacket(keyB, 1002, 60));
+	PTF_ASSERT_NOT_NULL(flowTable.processFlowPacket(keyC, 1002, 60));
+	PTF_ASSERT_EQUAL(flowTable.getNumOfFlows(), 3, size);
+	PTF_ASSERT_TRUE(closedFlows.empty());
+	PTF_ASSERT_NOT_NULL(flowTable.processFlowPacket(keyD, 1003, 60, NULL, &isNewFlow));
+	PTF_ASSERT_TRUE(isNewFlow);
+	PTF_ASSERT_EQUAL(flowTable.getNumOfFlows(), 3, size);
+	PTF_ASSERT_EQUAL(flowTable.getNumOfEvictedFlows(), 1, u64);
+	PTF_ASSERT_EQUAL(closedFlows.size(), 1, size);
+	PTF_ASSERT_TRUE(closedFlows[0].key == keyA);
+	PTF_ASSERT_EQUAL(closedFlows[0].reason, pcpp::FlowClosedByEviction, enum);
+	PTF_ASSERT_EQUAL(closedFlows[0].state, 1, int);
+	PTF_ASSERT_NULL(flowTable.getFlow(keyA));
+
+	// a flow that starts again gets a fresh state
+	closedFlows.clear();
+	flow = flowTable.processFlowPacket(keyA, 1003, 60, NULL, &isNewFlow);
+	PTF_ASSERT_TRUE(isNewFlow);
+	PTF_ASSERT_EQUAL(flow->getState(), 0, int);
+	PTF_ASSERT_TRUE(closedFlows[0].key == keyB);
+
+	// idle timeout: B is gone and C didn't see packets since 1002, D and A since 1003
+	closedFlows.clear();
+	PTF_ASSERT_NOT_NULL(flowTable.processFlowPacket(keyD, 1012, 60));
+	PTF_ASSERT_EQUAL(closedFlows.size(), 1, size);
+	PTF_ASSERT_TRUE(closedFlows[0].key == keyC);
+	PTF_ASSERT_EQUAL(closedFlows[0].reason, pcpp::FlowClosedByIdleTimeout, enum);
+	flowTable.purgeTimedOutFlows(1013);
+	PTF_ASSERT_EQUAL(closedFlows.size(), 2, size);
+	PTF_ASSERT_TRUE(closedFlows[1].key == keyA);
+	PTF_ASSERT_EQUAL(flowTable.getNumOfFlows(), 1, size);
+	PTF_ASSERT_EQUAL(flowTable.getNumOfTimedOutFlows(), 2, u64);
+
+	// the clock doesn't go backwards
+	flowTable.purgeTimedOutFlows(900);
+	PTF_ASSERT_EQUAL(flowTable.getCurrentTime(), 1013, int);
+
+	// active timeout: D started at 1003 and is closed at 1103 even though it's active
+	closedFlows.clear();
+	for (time_t curTime = 1015; curTime < 1103; curTime += 5)
+		PTF_ASSERT_NOT_NULL(flowTable.processFlowPacket(keyD, curTime, 60));
+	PTF_ASSERT_TRUE(closedFlows.empty());
+	flow = flowTable.processFlowPacket(keyD, 1103, 60, NULL, &isNewFlow);
+	PTF_ASSERT_TRUE(isNewFlow);
+	PTF_ASSERT_EQUAL(flow->getStartTime(), 1103, int);
+	PTF_ASSERT_EQUAL(closedFlows.size(), 1, size);
+	PTF_ASSERT_EQUAL(closedFlows[0].reason, pcpp::FlowClosedByActiveTimeout, enum);
+
+	// flows of real packets
+	closedFlows.clear();
+	flowTable.closeAllFlows();
+	PTF_ASSERT_EQUAL(closedFlows.size(), 1, size);
+	PTF_ASSERT_EQUAL(closedFlows[0].reason, pcpp::FlowClosedManually, enum);
+	PTF_ASSERT_EQUAL(flowTable.getNumOfFlows(), 0, size);
+	flow = flowTable.processPacket(&tcpPacket, &direction, &isNewFlow);
+	PTF_ASSERT_NOT_NULL(flow);
+	PTF_ASSERT_TRUE(flow->getKey() == tcpKey);
+	PTF_ASSERT_EQUAL(flow->getNumOfBytes(pcpp::FlowDirectionFromInitiator), (uint64_t)rawPacket1.getFrameLength(), u64);
+	PTF_ASSERT_EQUAL(flowTable.getCurrentTime(), time.tv_sec, int);
+	PTF_ASSERT_NOT_NULL(flowTable.processPacket(&udpPacket));
+	PTF_ASSERT_NOT_NULL(flowTable.processPacket(&icmpPacket));
+	PTF_ASSERT_NULL(flowTable.processPacket(&arpPacket));
+	int numOfFlows = 0;
+	flowTable.forEachFlow(flowTableCountFlows, &numOfFlows);
+	PTF_ASSERT_EQUAL(numOfFlows, 3, int);
+	PTF_ASSERT_TRUE(flowTable.closeFlow(reverseTcpKey));
+	PTF_ASSERT_FALSE(flowTable.closeFlow(reverseTcpKey));
+	PTF_ASSERT_EQUAL(flowTable.getNumOfFlows(), 2, size);
+
+	// a table without capacity doesn't track anything
+	pcpp::FlowTable<int> emptyTable(0);
+	PTF_ASSERT_NULL(emptyTable.processFlowPacket(keyA, 1000, 60));
+	PTF_ASSERT_NULL(emptyTable.getFlow(keyA));
+
+	// a closed flow is removed from the table before the callback is called, so the callback sees a consistent table
+	FlowTableCallbackCheck callbackCheck;
+	pcpp::FlowTable<int> checkedTable(2, 0, 0, flowTableCheckOnFlowClosed, &callbackCheck);
+	callbackCheck.table = &checkedTable;
+	PTF_ASSERT_NOT_NULL(checkedTable.processFlowPacket(keyA, 1000, 60));
+	PTF_ASSERT_NOT_NULL(checkedTable.processFlowPacket(keyB, 1001, 60));
+	PTF_ASSERT_NOT_NULL(checkedTable.processFlowPacket(keyC, 1002, 60));
+	PTF_ASSERT_EQUAL(callbackCheck.numOfClosedFlows, 1, int);
+	PTF_ASSERT_EQUAL(callbackCheck.numOfClosedFlowsFound, 0, int);
+	PTF_ASSERT_EQUAL(callbackCheck.numOfFlows, 1, size);
+	PTF_ASSERT_EQUAL(callbackCheck.numOfVisitedFlows, 1, int);
+	PTF_ASSERT_TRUE(checkedTable.closeFlow(keyB));
+	PTF_ASSERT_EQUAL(callbackCheck.numOfClosedFlows, 2, int);
+	PTF_ASSERT_EQUAL(callbackCheck.numOfClosedFlowsFound, 0, int);
+	PTF_ASSERT_EQUAL(callbackCheck.numOfFlows, 1, size);
+	PTF_ASSERT_EQUAL(callbackCheck.numOfVisitedFlows, 1, int);
+	PTF_ASSERT_NOT_NULL(checkedTable.getFlow(keyC));
+
+	// flows are linked by 32-bit indices, so larger tables are clamped
+	PTF_ASSERT_TRUE(pcpp::FlowTable<int>::getMaxSupportedNumOfFlows() <= 0xFFFFFFFF);
+	PTF_ASSERT_GREATER_THAN(pcpp::FlowTable<int>::getMaxSupportedNumOfFlows(), 0x3FFFFFFE, size);
+} // FlowTableTest
+
+
+
+#define CONCURRENT_FLOW_TABLE_NUM_OF_THREADS 4
+#define CONCURRENT_FLOW_TABLE_NUM_OF_FLOWS 200
+#define CONCURRENT_FLOW_TABLE_NUM_OF_ROUNDS 50
+
+static void concurrentFlowTableOnFlowPacket(pcpp::ConcurrentFlowTable<int>::Flow& flow, pcpp::FlowDirection direction, bool isNewFlow, void* userCookie)
+{
+	flow.getState()++;
+}
+
+static void concurrentFlowTableSumStates(pcpp::ConcurrentFlowTable<int>::Flow& flow, void* userCookie)
+{
+	*(int*)userCookie += flow.getState();
+}
+
+static void* concurrentFlowTableThread(void* cookie)
+{
+	pcpp::ConcurrentFlowTable<int>* flowTable = (pcpp::ConcurrentFlowTable<int>*)cookie;
+	pcpp::IPAddress clientIP(std::string("10.0.0.1"));
+	pcpp::IPAddress serverIP(std::string("10.0.0.2"));
+	for (int round = 0; round < CONCURRENT_FLOW_TABLE_NUM_OF_ROUNDS; round++)
+	{
+		for (uint16_t i = 0; i < CONCURRENT_FLOW_TABLE_NUM_OF_FLOWS; i++)
+		{
+			// half of the packets go from the server to the client
+			pcpp::FlowKey key = (i % 2 == 0 ? pcpp::FlowKey(clientIP, serverIP, 10000 + i, 80, pcpp::PACKETPP_IPPROTO_TCP) :
+					pcpp::FlowKey(serverIP, clientIP, 80, 10000 + i, pcpp::PACKETPP_IPPROTO_TCP));
+			flowTable->processFlowPacket(key, 1000, 100, concurrentFlowTableOnFlowPacket, NULL);
+		}
+	}
+
+	return NULL;
+}
+
+PTF_TEST_CASE(ConcurrentFlowTableTest)
+{
+	pcpp::ConcurrentFlowTable<int> flowTable(8, 2 * CONCURRENT_FLOW_TABLE_NUM_OF_FLOWS);
+	PTF_ASSERT_EQUAL(flowTable.getNumOfShards(), 8, size);
+	PTF_ASSERT_EQUAL(flowTable.getMaxNumOfFlows(), 2 * CONCURRENT_FLOW_TABLE_NUM_OF_FLOWS, size);
+
+	pthread_t threads[CONCURRENT_FLOW_TABLE_NUM_OF_THREADS];
+	for (int i = 0; i < CONCURRENT_FLOW_TABLE_NUM_OF_THREADS; i++)
+		PTF_ASSERT_EQUAL(pthread_create(&threads[i], NULL, concurrentFlowTableThread, &flowTable), 0, int);
+	for (int i = 0; i < CONCURRENT_FLOW_TABLE_NUM_OF_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	// every packet was counted exactly once
+	PTF_ASSERT_EQUAL(flowTable.getNumOfFlows(), CONCURRENT_FLOW_TABLE_NUM_OF_FLOWS, size);
+	PTF_ASSERT_EQUAL(flowTable.getNumOfEvictedFlows(), 0, u64);
+	int sumOfStates = 0;
+	flowTable.forEachFlow(concurrentFlowTableSumStates, &sumOfStates);
+	PTF_ASSERT_EQUAL(sumOfStates, CONCURRENT_FLOW_TABLE_NUM_OF_THREADS * CONCURRENT_FLOW_TABLE_NUM_OF_ROUNDS * CONCURRENT_FLOW_TABLE_NUM_OF_FLOWS, int);
+
+	pcpp::FlowKey key(pcpp::IPAddress(std::string("10.0.0.2")), pcpp::IPAddress(std::string("10.0.0.1")), 80, 10000, pcpp::PACKETPP_IPPROTO_TCP);
+	sumOfStates = 0;
+	PTF_ASSERT_TRUE(flowTable.visitFlow(key, concurrentFlowTableSumStates, &sumOfStates));
+	PTF_ASSERT_EQUAL(sumOfStates, CONCURRENT_FLOW_TABLE_NUM_OF_THREADS * CONCURRENT_FLOW_TABLE_NUM_OF_ROUNDS, int);
+	PTF_ASSERT_TRUE(flowTable.closeFlow(key));
+	PTF_ASSERT_FALSE(flowTable.visitFlow(key, concurrentFlowTableSumStates, &sumOfStates));
+
+	// timeouts are applied to all shards
+	pcpp::ConcurrentFlowTable<int> idleFlowTable(4, 100, 10);
+	for (uint16_t i = 0; i < 20; i++)
+		PTF_ASSERT_TRUE(idleFlowTable.processFlowPacket(pcpp::FlowKey(key.getSrcIP(), key.getDstIP(), i, 80, pcpp::PACKETPP_IPPROTO_UDP), 1000, 100, NULL, NULL));
+	PTF_ASSERT_EQUAL(idleFlowTable.getNumOfFlows(), 20, size);
+	idleFlowTable.purgeTimedOutFlows(1010);
+	PTF_ASSERT_EQUAL(idleFlowTable.getNumOfFlows(), 0, size);
+	PTF_ASSERT_EQUAL(idleFlowTable.getNumOfTimedOutFlows(), 20, u64);
+} // ConcurrentFlowTableTest
+
+
+struct PayloadMatcherTestResults
+{
+	std::vector<std::pair<int, uint64_t> > matches;
+	size_t maxMatches;
+
+	PayloadMatcherTestResults() : maxMatches(0) {}
+};
+
+static bool onPayloadMatcherTestMatch(int patternId, uint64_t endOffset, void* userCookie)
+{
+	PayloadMatcherTestResults* results = (PayloadMatcherTestResults*)userCookie;
+	results->matches.push_back(std::make_pair(patternId, endOffset));
+	return results->maxMatches == 0 || results->matches.size() < results->maxMatches;
+}
+
+static size_t countPatternOccurrences(const std::vector<std::string>& patterns, const std::string& data)
+{
+	size_t count = 0;
+	for (std::vector<std::string>::const_iterator iter = patterns.begin(); iter != patterns.end(); ++iter)
+	{
+		for (size_t pos = data.find(*iter); pos != std::string::npos; pos = data.find(*iter, pos + 1))
+			count++;
+	}
+
+	return count;
+}
+
+
+
+PTF_TEST_CASE(PayloadMatcherTest)
+{
+	timeval time;
+	gettimeofday(&time, NULL);
+
+	// the classic Aho-Corasick example: overlapping patterns and patterns which are suffixes of other patterns
+	pcpp::PayloadMatcher matcher;
+	PTF_ASSERT_FALSE(matcher.isCompiled());
+	pcpp::LoggerPP::getInstance().supressErrors();
+	PTF_ASSERT_FALSE(matcher.compile());
+	PTF_ASSERT_EQUAL(matcher.addPattern(""), -1, int);
+	PTF_ASSERT_FALSE(matcher.matchAny((const uint8_t*)"he", 2));
+	pcpp::LoggerPP::getInstance().enableErrors();
+	PTF_ASSERT_EQUAL(matcher.addPattern("he"), 0, int);
+	PTF_ASSERT_EQUAL(matcher.addPattern("she"), 1, int);
+	PTF_ASSERT_EQUAL(matcher.addPattern("his"), 2, int);
+	PTF_ASSERT_EQUAL(matcher.addPattern("hers"), 3, int);
+	PTF_ASSERT_TRUE(matcher.compile());
+	PTF_ASSERT_TRUE(matcher.isCompiled());
+	PTF_ASSERT_EQUAL(matcher.getNumOfPatterns(), 4, size);
+	PTF_ASSERT_EQUAL(matcher.getNumOfStates(), 10, size);
+	PTF_ASSERT_EQUAL(matcher.getPatternLength(3), 4, size);
+	PTF_ASSERT_EQUAL(matcher.getPatternLength(4), 0, size);
+	pcpp::LoggerPP::getInstance().supressErrors();
+	PTF_ASSERT_EQUAL(matcher.addPattern("her"), -1, int);
+	PTF_ASSERT_FALSE(matcher.compile());
+	pcpp::LoggerPP::getInstance().enableErrors();
+
+	std::string text = "ushers";
+	const uint8_t* textData = (const uint8_t*)text.data();
+	PayloadMatcherTestResults results;
+	PTF_ASSERT_EQUAL(matcher.findMatches(textData, text.length(), onPayloadMatcherTestMatch, &results), 3, size);
+	PTF_ASSERT_EQUAL(results.matches.size(), 3, size);
+	PTF_ASSERT_EQUAL(results.matches[0].first, 1, int);
+	PTF_ASSERT_EQUAL(results.matches[0].second, 4, u64);
+	PTF_ASSERT_EQUAL(results.matches[1].first, 0, int);
+	PTF_ASSERT_EQUAL(results.matches[1].second, 4, u64);
+	PTF_ASSERT_EQUAL(results.matches[2].first, 3, int);
+	PTF_ASSERT_EQUAL(results.matches[2].second, 6, u64);
+	PTF_ASSERT_EQUAL(matcher.findMatches(textData, text.length()), 3, size);
+	PTF_ASSERT_TRUE(matcher.matchAny(textData, text.length()));
+	PTF_ASSERT_FALSE(matcher.matchAny(textData, 3));
+	PTF_ASSERT_EQUAL(matcher.findMatches((const uint8_t*)"USHERS", 6), 0, size);
+
+	// the callback can stop the search
+	results.matches.clear();
+	results.maxMatches = 1;
+	PTF_ASSERT_EQUAL(matcher.findMatches(textData, text.length(), onPayloadMatcherTestMatch, &results), 1, size);
+	PTF_ASSERT_EQUAL(results.matches.size(), 1, size);
+	results.maxMatches = 0;
+
+	// a stream: the same matches are found wherever the data is split
+	for (size_t split = 0; split <= text.length(); split++)
+	{
+		pcpp::PayloadMatcher::StreamState state;
+		results.matches.clear();
+		size_t numOfMatches = matcher.findMatches(state, textData, split, onPayloadMatcherTestMatch, &results);
+		numOfMatches += matcher.findMatches(state, textData + split, text.length() - split, onPayloadMatcherTestMatch, &results);
+		PTF_ASSERT_EQUAL(numOfMatches, 3, size);
+		PTF_ASSERT_EQUAL(results.matches[2].first, 3, int);
+		PTF_ASSERT_EQUAL(results.matches[2].second, 6, u64);
+		PTF_ASSERT_EQUAL(state.getOffset(), 6, u64);
+		state.reset();
+		PTF_ASSERT_EQUAL(state.getOffset(), 0, u64);
+		PTF_ASSERT_EQUAL(matcher.findMatches(state, textData + split, text.length() - split), (split <= 1 ? 3 : (split == 2 ? 2 : 0)), size);
+	}
+
+	// case-insensitive matching
+	pcpp::PayloadMatcher caseInsensitiveMatcher(true);
+	PTF_ASSERT_TRUE(caseInsensitiveMatcher.isCaseInsensitive());
+	caseInsensitiveMatcher.addPattern("HeRs");
+	caseInsensitiveMatcher.addPattern("1.2.3");
+	PTF_ASSERT_TRUE(caseInsensitiveMatcher.compile());
+	PTF_ASSERT_EQUAL(caseInsensitiveMatcher.findMatches((const uint8_t*)"USHERS ushers 1.2.3", 19), 3, size);
+
+	// compare to a naive search on pseudo-random data, once with patterns that start with a few distinct bytes (using the SIMD
+	// prefilter where it's supported) and once with patterns that start with many
+	std::string randomData;
+	uint32_t seed = 12345;
+	for (int i = 0; i < 20000; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		uint8_t value = (uint8_t)(seed >> 16);
+		// long runs of bytes that don't start any pattern, so the prefilter has something to skip
+		if (value < 64)
+			randomData.append(value % 40, 'x');
+		else
+			randomData.push_back((char)('a' + value % 8));
+	}
+
+	const char* fewStartBytesPatterns[] = { "abc", "acab", "ba", "bbbb", "cad", "caxx" };
+	const char* manyStartBytesPatterns[] = { "abc", "bca", "cab", "dd", "ea", "fab", "a", "hgf" };
+	for (int i = 0; i < 2; i++)
+	{
+		std::vector<std::string> patterns;
+		if (i == 0)
+			patterns.assign(fewStartBytesPatterns, fewStartBytesPatterns + sizeof(fewStartBytesPatterns)/sizeof(fewStartBytesPatterns[0]));
+		else
+			patterns.assign(manyStartBytesPatterns, manyStartBytesPatterns + sizeof(manyStartBytesPatterns)/sizeof(manyStartBytesPatterns[0]));
+
+		pcpp::PayloadMatcher randomDataMatcher;
+		for (std::vector<std::string>::iterator iter = patterns.begin(); iter != patterns.end(); ++iter)
+			randomDataMatcher.addPattern(*iter);
+		PTF_ASSERT_TRUE(randomDataMatcher.compile());
+
+		size_t expectedNumOfMatches = countPatternOccurrences(patterns, randomData);
+		PTF_ASSERT_GREATER_THAN(expectedNumOfMatches, 0, size);
+		PTF_ASSERT_EQUAL(randomDataMatcher.findMatches((const uint8_t*)randomData.data(), randomData.length()), expectedNumOfMatches, size);
+
+		pcpp::PayloadMatcher::StreamState state;
+		size_t numOfMatches = 0;
+		for (size_t pos = 0; pos < randomData.length(); pos += 37)
+			numOfMatches += randomDataMatcher.findMatches(state, (const uint8_t*)randomData.data() + pos, std::min<size_t>(37, randomData.length() - pos));
+		PTF_ASSERT_EQUAL(numOfMatches, expectedNumOfMatches, size);
+		PTF_ASSERT_EQUAL(state.getOffset(), randomData.length(), u64);
+	}
+
+	// the payload of a packet parsed only up to TCP
+	READ_FILE_AND_CREATE_PACKET(1, "PacketExamples/TwoHttpRequests1.dat");
+	pcpp::Packet httpPacket(&rawPacket1, pcpp::TCP);
+	PTF_ASSERT_NULL(httpPacket.getLayerOfType<pcpp::HttpRequestLayer>());
+
+	pcpp::PayloadMatcher httpMatcher(true);
+	httpMatcher.addPattern("YNET.CO.IL");
+	httpMatcher.addPattern("ml");
+	PTF_ASSERT_TRUE(httpMatcher.compile());
+	PTF_ASSERT_TRUE(httpMatcher.matchPacket(httpPacket));
+	results.matches.clear();
+	PTF_ASSERT_EQUAL(httpMatcher.findMatches(httpPacket, onPayloadMatcherTestMatch, &results), 7, size);
+	PTF_ASSERT_EQUAL(results.matches[0].first, 1, int);
+	PTF_ASSERT_EQUAL(results.matches[0].second, 28, u64);
+	PTF_ASSERT_EQUAL(results.matches[1].first, 0, int);
+	PTF_ASSERT_EQUAL(results.matches[1].second, 59, u64);
+
+	PTF_ASSERT_FALSE(matcher.matchPacket(httpPacket));
+	PTF_ASSERT_EQUAL(matcher.findMatches(httpPacket), 0, size);
+} // PayloadMatcherTest
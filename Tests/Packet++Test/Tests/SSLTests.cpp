@@ -3,6 +3,9 @@
 #include "EndianPortable.h"
 #include "Packet.h"
 #include "SSLLayer.h"
+#include "SSLHelloReader.h"
+#include "SSLFingerprint.h"
+#include "TcpLayer.h"
 #include "SystemUtils.h"
 
 
@@ -480,4 +483,185 @@ PTF_TEST_CASE(SSLNewSessionTicketParseTest)
 	PTF_ASSERT_EQUAL(newSessionTicketMsg->getSessionTicketData()[0], 0, hex);
 	PTF_ASSERT_EQUAL(newSessionTicketMsg->getSessionTicketData()[16], 0xf9, hex);
 	PTF_ASSERT_EQUAL(newSessionTicketMsg->getSessionTicketData()[213], 0x75, hex);
-} // SSLNewSessionTicketParseTest
\ No newline at end of file
+} // SSLNewSessionTicketParseTest
+
+
+PTF_TEST_CASE(SSLHelloReaderTest)
+{
+	timeval time;
+	gettimeofday(&time, NULL);
+
+	// client-hello: the reader must give the same values SSLClientHelloMessage does
+	READ_FILE_AND_CREATE_PACKET(1, "PacketExamples/SSL-ClientHello1.dat");
+	pcpp::Packet clientHelloPacket(&rawPacket1, pcpp::TCP);
+	pcpp::TcpLayer* tcpLayer = clientHelloPacket.getLayerOfType<pcpp::TcpLayer>();
+	PTF_ASSERT_NOT_NULL(tcpLayer);
+	PTF_ASSERT_NULL(clientHelloPacket.getLayerOfType<pcpp::SSLHandshakeLayer>());
+
+	pcpp::SSLHelloReader reader;
+	PTF_ASSERT_FALSE(reader.isValid());
+	PTF_ASSERT_TRUE(reader.parseRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayloadSize()));
+	PTF_ASSERT_TRUE(reader.isValid());
+	PTF_ASSERT_EQUAL(reader.getHandshakeType(), pcpp::SSL_CLIENT_HELLO, enum);
+	PTF_ASSERT_EQUAL(reader.getHandshakeVersion(), pcpp::TLS1_2, u16);
+
+	pcpp::Packet fullClientHelloPacket(&rawPacket1);
+	pcpp::SSLClientHelloMessage* clientHelloMessage = fullClientHelloPacket.getLayerOfType<pcpp::SSLHandshakeLayer>()->getHandshakeMessageOfType<pcpp::SSLClientHelloMessage>();
+	PTF_ASSERT_NOT_NULL(clientHelloMessage);
+	PTF_ASSERT_EQUAL(reader.getCipherSuiteCount(), (size_t)clientHelloMessage->getCipherSuiteCount(), size);
+	for (int i = 0; i < clientHelloMessage->getCipherSuiteCount(); i++)
+	{
+		bool isValid = false;
+		PTF_ASSERT_EQUAL(reader.getCipherSuiteID(i), clientHelloMessage->getCipherSuite(i)->getID(), u16);
+		PTF_ASSERT_EQUAL(clientHelloMessage->getCipherSuiteID(i, isValid), clientHelloMessage->getCipherSuite(i)->getID(), u16);
+		PTF_ASSERT_TRUE(isValid);
+	}
+	bool isValid = true;
+	PTF_ASSERT_EQUAL(clientHelloMessage->getCipherSuiteID(clientHelloMessage->getCipherSuiteCount(), isValid), 0, u16);
+	PTF_ASSERT_FALSE(isValid);
+	PTF_ASSERT_EQUAL(reader.getCipherSuiteID(reader.getCipherSuiteCount()), 0, u16);
+
+	size_t pos = 0;
+	uint16_t extType = 0;
+	uint16_t extDataLen = 0;
+	const uint8_t* extData = NULL;
+	int extCount = 0;
+	while (reader.getNextExtension(pos, extType, extData, extDataLen))
+	{
+		pcpp::SSLExtension* ext = clientHelloMessage->getExtension(extCount++);
+		PTF_ASSERT_EQUAL(extType, ext->getTypeAsInt(), u16);
+		PTF_ASSERT_EQUAL(extDataLen, ext->getLength(), u16);
+		PTF_ASSERT_TRUE(extData == ext->getData());
+	}
+	PTF_ASSERT_EQUAL(extCount, clientHelloMessage->getExtensionCount(), int);
+
+	PTF_ASSERT_TRUE(reader.getExtensionOfType(pcpp::SSL_EXT_EC_POINT_FORMATS, extDataLen) == clientHelloMessage->getExtensionOfType(pcpp::SSL_EXT_EC_POINT_FORMATS)->getData());
+	PTF_ASSERT_EQUAL(extDataLen, 2, u16);
+	PTF_ASSERT_NULL(reader.getExtensionOfType(pcpp::SSL_EXT_HEARTBEAT, extDataLen));
+
+	size_t serverNameLen = 0;
+	const char* serverName = reader.getServerName(serverNameLen);
+	PTF_ASSERT_NOT_NULL(serverName);
+	PTF_ASSERT_EQUAL(std::string(serverName, serverNameLen), "www.google.com", string);
+
+	// server-hello which isn't the last record in the packet
+	READ_FILE_AND_CREATE_PACKET(2, "PacketExamples/SSL-MultipleRecords1.dat");
+	pcpp::Packet serverHelloPacket(&rawPacket2);
+	pcpp::SSLHandshakeLayer* handshakeLayer = serverHelloPacket.getLayerOfType<pcpp::SSLHandshakeLayer>();
+	PTF_ASSERT_NOT_NULL(handshakeLayer);
+	PTF_ASSERT_TRUE(reader.parseRecord(handshakeLayer->getData(), handshakeLayer->getDataLen()));
+	PTF_ASSERT_EQUAL(reader.getHandshakeType(), pcpp::SSL_SERVER_HELLO, enum);
+	PTF_ASSERT_EQUAL(reader.getCipherSuiteCount(), 1, size);
+	PTF_ASSERT_EQUAL(reader.getCipherSuiteID(0), 0xc02b, u16);
+	pcpp::SSLServerHelloMessage* serverHelloMessage = handshakeLayer->getHandshakeMessageOfType<pcpp::SSLServerHelloMessage>();
+	PTF_ASSERT_EQUAL(serverHelloMessage->getCipherSuiteID(isValid), 0xc02b, u16);
+	PTF_ASSERT_TRUE(isValid);
+	pos = 0;
+	extCount = 0;
+	while (reader.getNextExtension(pos, extType, extData, extDataLen))
+	{
+		PTF_ASSERT_EQUAL(extType, serverHelloMessage->getExtension(extCount++)->getTypeAsInt(), u16);
+	}
+	PTF_ASSERT_EQUAL(extCount, 3, int);
+	PTF_ASSERT_NULL(reader.getServerName(serverNameLen));
+
+	// records that don't contain a hello message
+	pcpp::SSLHandshakeLayer* secondHandshakeLayer = serverHelloPacket.getNextLayerOfType<pcpp::SSLHandshakeLayer>(handshakeLayer);
+	PTF_ASSERT_NOT_NULL(secondHandshakeLayer);
+	PTF_ASSERT_FALSE(reader.parseRecord(secondHandshakeLayer->getData(), secondHandshakeLayer->getDataLen()));
+	PTF_ASSERT_FALSE(reader.isValid());
+	PTF_ASSERT_EQUAL(reader.getHandshakeType(), pcpp::SSL_HANDSHAKE_UNKNOWN, enum);
+	pcpp::SSLChangeCipherSpecLayer* ccsLayer = serverHelloPacket.getLayerOfType<pcpp::SSLChangeCipherSpecLayer>();
+	PTF_ASSERT_FALSE(reader.parseRecord(ccsLayer->getData(), ccsLayer->getDataLen()));
+
+	// a client-hello truncated in the middle of the cipher-suite list
+	PTF_ASSERT_TRUE(reader.parseRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayloadSize()));
+	PTF_ASSERT_FALSE(reader.parseRecord(tcpLayer->getLayerPayload(), 50));
+	PTF_ASSERT_FALSE(reader.parse(NULL, 0));
+} // SSLHelloReaderTest
+
+
+PTF_TEST_CASE(SSLFingerprintTest)
+{
+	timeval time;
+	gettimeofday(&time, NULL);
+
+	READ_FILE_AND_CREATE_PACKET(1, "PacketExamples/SSL-ClientHello1.dat");
+	READ_FILE_AND_CREATE_PACKET(2, "PacketExamples/SSL-MultipleRecords1.dat");
+	READ_FILE_AND_CREATE_PACKET(3, "PacketExamples/SSL-PartialCertificate1.dat");
+	READ_FILE_AND_CREATE_PACKET(4, "PacketExamples/SSL-AlertClear.dat");
+	READ_FILE_AND_CREATE_PACKET(5, "PacketExamples/Dns1.dat");
+
+	// JA3 of a client-hello
+	pcpp::Packet clientHelloPacket(&rawPacket1, pcpp::TCP);
+	pcpp::TcpLayer* tcpLayer = clientHelloPacket.getLayerOfType<pcpp::TcpLayer>();
+	PTF_ASSERT_NOT_NULL(tcpLayer);
+
+	pcpp::SSLFingerprint fingerprint;
+	PTF_ASSERT_FALSE(fingerprint.isValid());
+	PTF_ASSERT_EQUAL(fingerprint.getDigestString(), "", string);
+
+	char fingerprintStr[256];
+	PTF_ASSERT_TRUE(fingerprint.computeFromRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayloadSize(), fingerprintStr, sizeof(fingerprintStr)));
+	PTF_ASSERT_TRUE(fingerprint.isValid());
+	PTF_ASSERT_TRUE(fingerprint.isJA3());
+	PTF_ASSERT_FALSE(fingerprint.isJA3S());
+	std::string expectedJA3 = "771,49195-49199-49162-49161-49171-49172-51-57-47-53-10,0-65281-10-11-35-13172-16-5-13,23-24-25,0";
+	PTF_ASSERT_EQUAL(std::string(fingerprintStr), expectedJA3, string);
+	PTF_ASSERT_EQUAL(fingerprint.getStringLength(), expectedJA3.length(), size);
+	PTF_ASSERT_EQUAL(fingerprint.getDigestString(), "07b4162d4db57554961824a21c4a0fde", string);
+
+	// the same fingerprint computed from a reader, without the fingerprint string and with a truncated string
+	pcpp::SSLHelloReader reader;
+	PTF_ASSERT_TRUE(reader.parseRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayloadSize()));
+	pcpp::SSLFingerprint fingerprintFromReader;
+	PTF_ASSERT_TRUE(fingerprintFromReader.compute(reader));
+	PTF_ASSERT_TRUE(fingerprintFromReader == fingerprint);
+	PTF_ASSERT_EQUAL(fingerprintFromReader.getStringLength(), expectedJA3.length(), size);
+
+	char shortFingerprintStr[10];
+	PTF_ASSERT_TRUE(fingerprintFromReader.compute(reader, shortFingerprintStr, sizeof(shortFingerprintStr)));
+	PTF_ASSERT_EQUAL(std::string(shortFingerprintStr), expectedJA3.substr(0, sizeof(shortFingerprintStr) - 1), string);
+	PTF_ASSERT_EQUAL(fingerprintFromReader.getDigestString(), "07b4162d4db57554961824a21c4a0fde", string);
+
+	// GREASE values are skipped
+	std::vector<uint8_t> greaseRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayload() + tcpLayer->getLayerPayloadSize());
+	size_t sessionIdLenOffset = sizeof(pcpp::ssl_tls_record_layer) + sizeof(pcpp::ssl_tls_client_server_hello);
+	size_t firstCipherSuiteOffset = sessionIdLenOffset + sizeof(uint8_t) + greaseRecord[sessionIdLenOffset] + sizeof(uint16_t);
+	greaseRecord[firstCipherSuiteOffset] = 0x3a;
+	greaseRecord[firstCipherSuiteOffset + 1] = 0x3a;
+	PTF_ASSERT_TRUE(fingerprint.computeFromRecord(&greaseRecord[0], greaseRecord.size(), fingerprintStr, sizeof(fingerprintStr)));
+	PTF_ASSERT_EQUAL(std::string(fingerprintStr), "771,49199-49162-49161-49171-49172-51-57-47-53-10,0-65281-10-11-35-13172-16-5-13,23-24-25,0", string);
+	PTF_ASSERT_EQUAL(fingerprint.getDigestString(), "61d65345687a5ef847c6a594ef6e954b", string);
+	PTF_ASSERT_TRUE(fingerprint != fingerprintFromReader);
+
+	// JA3S of a server-hello which is followed by other records
+	pcpp::Packet serverHelloPacket(&rawPacket2, pcpp::TCP);
+	tcpLayer = serverHelloPacket.getLayerOfType<pcpp::TcpLayer>();
+	PTF_ASSERT_TRUE(fingerprint.computeFromRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayloadSize(), fingerprintStr, sizeof(fingerprintStr)));
+	PTF_ASSERT_TRUE(fingerprint.isJA3S());
+	PTF_ASSERT_EQUAL(std::string(fingerprintStr), "771,49195,65281-16-11", string);
+	PTF_ASSERT_EQUAL(fingerprint.getDigestString(), "554786d4c84f8a7953b7e453c6371067", string);
+
+	// a record which isn't a hello message
+	pcpp::Packet alertPacket(&rawPacket4, pcpp::TCP);
+	tcpLayer = alertPacket.getLayerOfType<pcpp::TcpLayer>();
+	PTF_ASSERT_FALSE(fingerprint.computeFromRecord(tcpLayer->getLayerPayload(), tcpLayer->getLayerPayloadSize(), fingerprintStr, sizeof(fingerprintStr)));
+	PTF_ASSERT_FALSE(fingerprint.isValid());
+	PTF_ASSERT_EQUAL(std::string(fingerprintStr), "", string);
+	PTF_ASSERT_FALSE(fingerprint.computeFromRecord(NULL, 0));
+
+	// batch mode
+	pcpp::RawPacket* rawPackets[] = { &rawPacket1, &rawPacket2, &rawPacket3, &rawPacket4, &rawPacket5, NULL };
+	pcpp::SSLFingerprint results[6];
+	PTF_ASSERT_EQUAL(pcpp::SSLFingerprint::computeBatch(rawPackets, 6, results), 3, size);
+	PTF_ASSERT_EQUAL(results[0].getDigestString(), "07b4162d4db57554961824a21c4a0fde", string);
+	PTF_ASSERT_TRUE(results[0].isJA3());
+	PTF_ASSERT_EQUAL(results[1].getDigestString(), "554786d4c84f8a7953b7e453c6371067", string);
+	PTF_ASSERT_EQUAL(results[2].getDigestString(), "ab1e32eeaf70ee94c0af00f08d126891", string);
+	PTF_ASSERT_TRUE(results[2].isJA3S());
+	PTF_ASSERT_EQUAL(results[2].getStringLength(), 7, size);
+	PTF_ASSERT_FALSE(results[3].isValid());
+	PTF_ASSERT_FALSE(results[4].isValid());
+	PTF_ASSERT_FALSE(results[5].isValid());
+} // SSLFingerprintTest
\ No newline at end of file
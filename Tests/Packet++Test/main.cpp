@@ -117,6 +117,7 @@ int main(int argc, char* argv[])
 	PTF_RUN_TEST(IPv4OptionsParsingTest, "ipv4");
 	PTF_RUN_TEST(IPv4OptionsEditTest, "ipv4");
 	PTF_RUN_TEST(IPv4UdpChecksum, "ipv4");
+	PTF_RUN_TEST(ChecksumComputeAndUpdateTest, "ipv4;checksum");
 
 	PTF_RUN_TEST(IPv6UdpPacketParseAndCreate, "ipv6");
 	PTF_RUN_TEST(IPv6FragmentationTest, "ipv6");
@@ -134,14 +135,22 @@ int main(int argc, char* argv[])
 	PTF_RUN_TEST(RemoveLayerTest, "packet;remove_layer");
 	PTF_RUN_TEST(CopyLayerAndPacketTest, "packet;copy_layer");
 	PTF_RUN_TEST(PacketLayerLookupTest, "packet");
+	PTF_RUN_TEST(LayerLookupBenchmarkTest, "packet;benchmark");
 	PTF_RUN_TEST(RawPacketTimeStampSetterTest, "packet");
 	PTF_RUN_TEST(ParsePartialPacketTest, "packet;partial_packet");
 	PTF_RUN_TEST(PacketTrailerTest, "packet;packet_trailer");
 	PTF_RUN_TEST(ResizeLayerTest, "packet;resize");
+	PTF_RUN_TEST(ReuseParsedPacketTest, "packet;reuse_packet");
+	PTF_RUN_TEST(LazyPacketParsingTest, "packet;lazy_parsing");
+	PTF_RUN_TEST(FastHash5TupleTest, "packet;hash");
+	PTF_RUN_TEST(FlowTableTest, "packet;flow_table");
+	PTF_RUN_TEST(ConcurrentFlowTableTest, "packet;flow_table");
+	PTF_RUN_TEST(PayloadMatcherTest, "packet;payload_matcher");
 
 	PTF_RUN_TEST(HttpRequestLayerParsingTest, "http");
 	PTF_RUN_TEST(HttpRequestLayerCreationTest, "http");
 	PTF_RUN_TEST(HttpRequestLayerEditTest, "http");
+	PTF_RUN_TEST(HttpMessageFieldLookupTest, "http");
 	PTF_RUN_TEST(HttpResponseLayerParsingTest, "http");
 	PTF_RUN_TEST(HttpResponseLayerCreationTest, "http");
 	PTF_RUN_TEST(HttpResponseLayerEditTest, "http");
@@ -156,6 +165,7 @@ int main(int argc, char* argv[])
 	PTF_RUN_TEST(DnsLayerResourceCreationTest, "dns");
 	PTF_RUN_TEST(DnsLayerEditTest, "dns");
 	PTF_RUN_TEST(DnsLayerRemoveResourceTest, "dns");
+	PTF_RUN_TEST(DnsRecordIteratorTest, "dns");
 
 	PTF_RUN_TEST(IcmpParsingTest, "icmp");
 	PTF_RUN_TEST(IcmpCreationTest, "icmp");
@@ -174,6 +184,8 @@ int main(int argc, char* argv[])
 	PTF_RUN_TEST(SSLMultipleRecordParsing4Test, "ssl");
 	PTF_RUN_TEST(SSLPartialCertificateParseTest, "ssl");
 	PTF_RUN_TEST(SSLNewSessionTicketParseTest, "ssl");
+	PTF_RUN_TEST(SSLHelloReaderTest, "ssl");
+	PTF_RUN_TEST(SSLFingerprintTest, "ssl");
 
 	PTF_RUN_TEST(SllPacketParsingTest, "sll");
 	PTF_RUN_TEST(SllPacketCreationTest, "sll");
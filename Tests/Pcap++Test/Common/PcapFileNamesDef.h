@@ -2,6 +2,11 @@
 #define EXAMPLE_PCAP_WRITE_PATH "PcapExamples/example_copy.pcap"
 #define EXAMPLE_PCAP_PATH "PcapExamples/example.pcap"
 #define EXAMPLE2_PCAP_PATH "PcapExamples/example2.pcap"
+#define EXAMPLE_PCAP_BIG_ENDIAN_NSEC_WRITE_PATH "PcapExamples/example_big_endian_nsec.pcap"
+#define EXAMPLE_PCAP_TRUNCATED_WRITE_PATH "PcapExamples/example_truncated.pcap"
+#define EXAMPLE_PCAP_SNAPLEN_WRITE_PATH "PcapExamples/example_snaplen.pcap"
+#define EXAMPLE_PCAP_INTERLEAVED_WRITE_PATH "PcapExamples/example_interleaved.pcap"
+#define EXAMPLE_PCAP_INDEXED_WRITE_PATH "PcapExamples/example_indexed.pcap"
 #define EXAMPLE_PCAP_HTTP_REQUEST "PcapExamples/4KHttpRequests.pcap"
 #define EXAMPLE_PCAP_HTTP_RESPONSE "PcapExamples/650HttpResponses.pcap"
 #define EXAMPLE_PCAP_VLAN "PcapExamples/VlanPackets.pcap"
@@ -7,6 +7,8 @@ PTF_TEST_CASE(TestIPAddress);
 PTF_TEST_CASE(TestMacAddress);
 PTF_TEST_CASE(TestLRUList);
 PTF_TEST_CASE(TestGeneralUtils);
+PTF_TEST_CASE(TestSystemCoreUtils);
+PTF_TEST_CASE(TestLoggerUtils);
 PTF_TEST_CASE(TestGetMacAddress);
 
 // Implemented in FileTests.cpp
@@ -14,6 +16,9 @@ PTF_TEST_CASE(TestPcapFileReadWrite);
 PTF_TEST_CASE(TestPcapSllFileReadWrite);
 PTF_TEST_CASE(TestPcapRawIPFileReadWrite);
 PTF_TEST_CASE(TestPcapFileAppend);
+PTF_TEST_CASE(TestPcapFileReadZeroCopyAndBatch);
+PTF_TEST_CASE(TestMmapPcapFileRead);
+PTF_TEST_CASE(TestParallelPcapFileRead);
 PTF_TEST_CASE(TestPcapNgFileReadWrite);
 PTF_TEST_CASE(TestPcapNgFileReadWriteAdv);
 
@@ -34,6 +39,8 @@ PTF_TEST_CASE(TestRemoteCapture);
 PTF_TEST_CASE(TestPcapFiltersLive);
 PTF_TEST_CASE(TestPcapFilters_General_BPFStr);
 PTF_TEST_CASE(TestPcapFiltersOffline);
+PTF_TEST_CASE(TestPcapFiltersNative);
+PTF_TEST_CASE(TestCompiledFilter);
 
 // Implemented in PacketParsingTests.cpp
 PTF_TEST_CASE(TestHttpRequestParsing);
@@ -46,6 +53,7 @@ PTF_TEST_CASE(TestTcpReassemblySanity);
 PTF_TEST_CASE(TestTcpReassemblyRetran);
 PTF_TEST_CASE(TestTcpReassemblyMissingData);
 PTF_TEST_CASE(TestTcpReassemblyOutOfOrder);
+PTF_TEST_CASE(TestTcpReassemblyOutOfOrderLimits);
 PTF_TEST_CASE(TestTcpReassemblyWithFIN_RST);
 PTF_TEST_CASE(TestTcpReassemblyMalformedPkts);
 PTF_TEST_CASE(TestTcpReassemblyMultipleConns);
@@ -53,7 +61,12 @@ PTF_TEST_CASE(TestTcpReassemblyIPv6);
 PTF_TEST_CASE(TestTcpReassemblyIPv6MultConns);
 PTF_TEST_CASE(TestTcpReassemblyIPv6_OOO);
 PTF_TEST_CASE(TestTcpReassemblyCleanup);
+PTF_TEST_CASE(TestTcpReassemblyCleanupPacketTimestamps);
 PTF_TEST_CASE(TestTcpReassemblyMaxSeq);
+PTF_TEST_CASE(TestTcpReassemblyIdleTimeout);
+PTF_TEST_CASE(TestTcpReassemblyMaxConnections);
+PTF_TEST_CASE(TestTcpReassemblyHashCollision);
+PTF_TEST_CASE(TestTcpReassemblyPayloadMatcher);
 
 // Implemented in IPFragmentationTests.cpp
 PTF_TEST_CASE(TestIPFragmentationSanity);
@@ -62,6 +75,8 @@ PTF_TEST_CASE(TestIPFragPartialData);
 PTF_TEST_CASE(TestIPFragMultipleFrags);
 PTF_TEST_CASE(TestIPFragMapOverflow);
 PTF_TEST_CASE(TestIPFragRemove);
+PTF_TEST_CASE(TestIPFragHashCollision);
+PTF_TEST_CASE(TestIPFragTimeoutAndMemoryLimit);
 
 // Implemented in PfRingTests.cpp
 PTF_TEST_CASE(TestPfRingDevice);
@@ -86,3 +101,6 @@ PTF_TEST_CASE(TestKniDeviceSendReceive);
 
 // Implemented in RawSocketTests.cpp
 PTF_TEST_CASE(TestRawSockets);
+
+// Implemented in AfPacketTests.cpp
+PTF_TEST_CASE(TestAfPacketDevice);
@@ -0,0 +1,162 @@
+#include "../TestDefinition.h"
+#include "Packet.h"
+#include "IPv4Layer.h"
+#include "UdpLayer.h"
+#include "EndianPortable.h"
+#include "Logger.h"
+#ifdef LINUX
+#include "AfPacketDevice.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string.h>
+#endif
+
+#ifdef LINUX
+
+#define AF_PACKET_TEST_PORT 47808
+#define AF_PACKET_TEST_NUM_OF_FLOWS 16
+#define AF_PACKET_TEST_PACKETS_PER_FLOW 10
+
+struct AfPacketTestStats
+{
+	int packetCount[PCPP_AF_PACKET_MAX_NUM_OF_RINGS];
+	int blockCount[PCPP_AF_PACKET_MAX_NUM_OF_RINGS];
+	bool allPacketsValid;
+};
+
+static void onAfPacketPacketsArrive(pcpp::RawPacket* packets, uint32_t numOfPackets, uint8_t ringId, pcpp::AfPacketDevice* device, void* userCookie)
+{
+	// each ring has its own counters so no locking is needed
+	AfPacketTestStats* stats = (AfPacketTestStats*)userCookie;
+	stats->blockCount[ringId]++;
+	for (uint32_t i = 0; i < numOfPackets; i++)
+	{
+		pcpp::Packet packet(&packets[i]);
+		pcpp::UdpLayer* udpLayer = packet.getLayerOfType<pcpp::UdpLayer>();
+		if (udpLayer == NULL || be16toh(udpLayer->getUdpHeader()->portDst) != AF_PACKET_TEST_PORT)
+			continue;
+
+		if (udpLayer->getLayerPayloadSize() != 4 || memcmp(udpLayer->getLayerPayload(), "pcpp", 4) != 0)
+			stats->allPacketsValid = false;
+
+		stats->packetCount[ringId]++;
+	}
+}
+
+static bool sendAfPacketTestFlows()
+{
+	struct sockaddr_in dstAddr;
+	memset(&dstAddr, 0, sizeof(dstAddr));
+	dstAddr.sin_family = AF_INET;
+	dstAddr.sin_port = htons(AF_PACKET_TEST_PORT);
+	dstAddr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+	// each socket gets a different source port, so each one is a different flow
+	for (int i = 0; i < AF_PACKET_TEST_NUM_OF_FLOWS; i++)
+	{
+		int fd = socket(AF_INET, SOCK_DGRAM, 0);
+		if (fd < 0)
+			return false;
+
+		for (int j = 0; j < AF_PACKET_TEST_PACKETS_PER_FLOW; j++)
+			sendto(fd, "pcpp", 4, 0, (struct sockaddr*)&dstAddr, sizeof(dstAddr));
+
+		close(fd);
+	}
+
+	return true;
+}
+
+static int sumAfPacketTestCounts(const int* counts, int numOfRings)
+{
+	int sum = 0;
+	for (int i = 0; i < numOfRings; i++)
+		sum += counts[i];
+	return sum;
+}
+
+#endif // LINUX
+
+
+PTF_TEST_CASE(TestAfPacketDevice)
+{
+#ifdef LINUX
+	const int numOfPackets = AF_PACKET_TEST_NUM_OF_FLOWS * AF_PACKET_TEST_PACKETS_PER_FLOW;
+
+	// invalid configurations and interfaces
+	pcpp::LoggerPP::getInstance().supressErrors();
+	pcpp::AfPacketDevice::AfPacketConfig config;
+	config.blockSize = 1000;
+	pcpp::AfPacketDevice badBlockSizeDev("lo", config);
+	PTF_ASSERT_FALSE(badBlockSizeDev.open());
+	pcpp::AfPacketDevice badInterfaceDev("no_such_interface0");
+	PTF_ASSERT_FALSE(badInterfaceDev.open());
+	pcpp::LoggerPP::getInstance().enableErrors();
+
+	// multi-threaded capture with fanout between 2 rings
+	config = pcpp::AfPacketDevice::AfPacketConfig();
+	config.blockSize = 1 << 16;
+	config.numOfBlocks = 16;
+	config.numOfRings = 2;
+	config.promiscuous = false;
+	pcpp::AfPacketDevice dev("lo", config);
+	PTF_ASSERT_TRUE(dev.open());
+	PTF_ASSERT_EQUAL(dev.getNumOfRings(), 2, u8);
+	PTF_ASSERT_EQUAL(dev.getLinkLayerType(), pcpp::LINKTYPE_ETHERNET, enum);
+	PTF_ASSERT_TRUE(dev.clearFilter());
+
+	AfPacketTestStats stats;
+	memset(&stats, 0, sizeof(stats));
+	stats.allPacketsValid = true;
+	PTF_ASSERT_TRUE(dev.startCapture(onAfPacketPacketsArrive, &stats, pcpp::getCoreMaskForAllMachineCores()));
+	PTF_ASSERT_TRUE(dev.captureActive());
+	PTF_ASSERT_FALSE(dev.startCapture(onAfPacketPacketsArrive, &stats));
+	PTF_ASSERT_TRUE(sendAfPacketTestFlows());
+
+	// blocks which aren't full are handed to user space when the block timeout expires
+	for (int i = 0; i < 200 && sumAfPacketTestCounts(stats.packetCount, 2) < numOfPackets; i++)
+		usleep(10000);
+
+	dev.stopCapture();
+	PTF_ASSERT_FALSE(dev.captureActive());
+	PTF_ASSERT_TRUE(stats.allPacketsValid);
+	PTF_ASSERT_GREATER_OR_EQUAL_THAN(sumAfPacketTestCounts(stats.packetCount, 2), numOfPackets, int);
+	PTF_ASSERT_GREATER_THAN(stats.packetCount[0], 0, int);
+	PTF_ASSERT_GREATER_THAN(stats.packetCount[1], 0, int);
+
+	pcpp::AfPacketDevice::AfPacketStats devStats, ringStats;
+	dev.getStatistics(devStats);
+	PTF_ASSERT_GREATER_OR_EQUAL_THAN(devStats.packetsDelivered, (uint64_t)numOfPackets, u64);
+	PTF_ASSERT_GREATER_OR_EQUAL_THAN(devStats.packetsReceived, devStats.packetsDelivered, u64);
+	PTF_ASSERT_EQUAL(devStats.blocksDelivered, (uint64_t)sumAfPacketTestCounts(stats.blockCount, 2), u64);
+	dev.getRingStatistics(0, ringStats);
+	PTF_ASSERT_GREATER_OR_EQUAL_THAN(ringStats.packetsDelivered, (uint64_t)stats.packetCount[0], u64);
+	PTF_ASSERT_LOWER_THAN(ringStats.packetsDelivered, devStats.packetsDelivered, u64);
+	dev.close();
+	PTF_ASSERT_FALSE(dev.isOpened());
+
+	// receiving in the calling thread from a single ring
+	config.numOfRings = 1;
+	pcpp::AfPacketDevice singleRingDev("lo", config);
+	PTF_ASSERT_TRUE(singleRingDev.open());
+	memset(&stats, 0, sizeof(stats));
+	stats.allPacketsValid = true;
+	PTF_ASSERT_TRUE(sendAfPacketTestFlows());
+	for (int i = 0; i < 200 && stats.packetCount[0] < numOfPackets; i++)
+	{
+		PTF_ASSERT_GREATER_OR_EQUAL_THAN(singleRingDev.receivePackets(0, onAfPacketPacketsArrive, &stats, 10), 0, int);
+	}
+	PTF_ASSERT_TRUE(stats.allPacketsValid);
+	PTF_ASSERT_GREATER_OR_EQUAL_THAN(stats.packetCount[0], numOfPackets, int);
+
+	pcpp::LoggerPP::getInstance().supressErrors();
+	PTF_ASSERT_EQUAL(singleRingDev.receivePackets(1, onAfPacketPacketsArrive, &stats, 0), -1, int);
+	PTF_ASSERT_EQUAL(singleRingDev.receivePackets(0, NULL, &stats, 0), -1, int);
+	pcpp::LoggerPP::getInstance().enableErrors();
+	singleRingDev.close();
+#else
+	PTF_SKIP_TEST("AF_PACKET is supported on Linux only");
+#endif
+} // TestAfPacketDevice
@@ -2,7 +2,17 @@
 #include "Logger.h"
 #include "Packet.h"
 #include "PcapFileDevice.h"
+#include "ParallelPcapFileReader.h"
+#include "TcpLayer.h"
+#include "UdpLayer.h"
 #include "../Common/PcapFileNamesDef.h"
+#include <fstream>
+#include <stdio.h>
+#ifdef _MSC_VER
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
 
 
 class FileReaderTeardown
@@ -267,6 +277,668 @@ PTF_TEST_CASE(TestPcapFileAppend)
 
 
 
+PTF_TEST_CASE(TestPcapFileReadZeroCopyAndBatch)
+{
+	pcpp::PcapFileReaderDevice copyReaderDev(EXAMPLE_PCAP_PATH);
+	pcpp::PcapFileReaderDevice zeroCopyReaderDev(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(copyReaderDev.open());
+	PTF_ASSERT_TRUE(zeroCopyReaderDev.open());
+	PTF_ASSERT_FALSE(zeroCopyReaderDev.isZeroCopyMode());
+	zeroCopyReaderDev.setZeroCopyMode(true);
+	PTF_ASSERT_TRUE(zeroCopyReaderDev.isZeroCopyMode());
+
+	// read the file packet by packet in zero-copy mode and compare to a regular read
+	pcpp::RawPacket copyRawPacket;
+	pcpp::RawPacket zeroCopyRawPacket;
+	int packetCount = 0;
+	while (copyReaderDev.getNextPacket(copyRawPacket))
+	{
+		PTF_ASSERT_TRUE(zeroCopyReaderDev.getNextPacket(zeroCopyRawPacket));
+		PTF_ASSERT_EQUAL(zeroCopyRawPacket.getRawDataLen(), copyRawPacket.getRawDataLen(), int);
+		PTF_ASSERT_EQUAL(zeroCopyRawPacket.getFrameLength(), copyRawPacket.getFrameLength(), int);
+		PTF_ASSERT_EQUAL(zeroCopyRawPacket.getPacketTimeStamp().tv_nsec, copyRawPacket.getPacketTimeStamp().tv_nsec, u64);
+		PTF_ASSERT_BUF_COMPARE(zeroCopyRawPacket.getRawData(), copyRawPacket.getRawData(), copyRawPacket.getRawDataLen());
+		packetCount++;
+	}
+	PTF_ASSERT_FALSE(zeroCopyReaderDev.getNextPacket(zeroCopyRawPacket));
+	PTF_ASSERT_EQUAL(packetCount, 4631, int);
+	copyReaderDev.close();
+	zeroCopyReaderDev.close();
+
+	// read the file in batches, with and without zero-copy mode. Packets of a batch must stay valid until the next batch
+	for (int zeroCopy = 0; zeroCopy < 2; zeroCopy++)
+	{
+		pcpp::PcapFileReaderDevice referenceReaderDev(EXAMPLE_PCAP_PATH);
+		pcpp::PcapFileReaderDevice batchReaderDev(EXAMPLE_PCAP_PATH);
+		PTF_ASSERT_TRUE(referenceReaderDev.open());
+		PTF_ASSERT_TRUE(batchReaderDev.open());
+		batchReaderDev.setZeroCopyMode(zeroCopy == 1);
+
+		pcpp::RawPacket batch[64];
+		int tcpCount = 0;
+		int udpCount = 0;
+		packetCount = 0;
+		int numOfPacketsRead;
+		while ((numOfPacketsRead = batchReaderDev.getNextPackets(batch, 64)) > 0)
+		{
+			for (int i = 0; i < numOfPacketsRead; i++)
+			{
+				pcpp::RawPacket referenceRawPacket;
+				PTF_ASSERT_TRUE(referenceReaderDev.getNextPacket(referenceRawPacket));
+				PTF_ASSERT_EQUAL(batch[i].getRawDataLen(), referenceRawPacket.getRawDataLen(), int);
+				PTF_ASSERT_BUF_COMPARE(batch[i].getRawData(), referenceRawPacket.getRawData(), referenceRawPacket.getRawDataLen());
+
+				pcpp::Packet packet(&batch[i]);
+				if (packet.isPacketOfType(pcpp::TCP))
+					tcpCount++;
+				if (packet.isPacketOfType(pcpp::UDP))
+					udpCount++;
+			}
+
+			packetCount += numOfPacketsRead;
+		}
+
+		PTF_ASSERT_EQUAL(packetCount, 4631, int);
+		PTF_ASSERT_EQUAL(tcpCount, 4492, int);
+		PTF_ASSERT_EQUAL(udpCount, 139, int);
+	}
+
+	// packets read into a RawPacketVector must own their data even in zero-copy mode
+	pcpp::PcapFileReaderDevice vecReaderDev(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(vecReaderDev.open());
+	vecReaderDev.setZeroCopyMode(true);
+	pcpp::RawPacketVector packetVec;
+	PTF_ASSERT_EQUAL(vecReaderDev.getNextPackets(packetVec, 10), 10, int);
+	PTF_ASSERT_TRUE(vecReaderDev.isZeroCopyMode());
+
+	pcpp::PcapFileReaderDevice vecReferenceReaderDev(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(vecReferenceReaderDev.open());
+	for (pcpp::RawPacketVector::VectorIterator iter = packetVec.begin(); iter != packetVec.end(); iter++)
+	{
+		pcpp::RawPacket referenceRawPacket;
+		PTF_ASSERT_TRUE(vecReferenceReaderDev.getNextPacket(referenceRawPacket));
+		PTF_ASSERT_BUF_COMPARE((*iter)->getRawData(), referenceRawPacket.getRawData(), referenceRawPacket.getRawDataLen());
+	}
+
+	// zero-copy mode with a pcapng file
+	pcpp::PcapNgFileReaderDevice ngCopyReaderDev(EXAMPLE2_PCAPNG_PATH);
+	pcpp::PcapNgFileReaderDevice ngZeroCopyReaderDev(EXAMPLE2_PCAPNG_PATH);
+	PTF_ASSERT_TRUE(ngCopyReaderDev.open());
+	PTF_ASSERT_TRUE(ngZeroCopyReaderDev.open());
+	ngZeroCopyReaderDev.setZeroCopyMode(true);
+	packetCount = 0;
+	while (ngCopyReaderDev.getNextPacket(copyRawPacket))
+	{
+		PTF_ASSERT_TRUE(ngZeroCopyReaderDev.getNextPacket(zeroCopyRawPacket));
+		PTF_ASSERT_EQUAL(zeroCopyRawPacket.getRawDataLen(), copyRawPacket.getRawDataLen(), int);
+		PTF_ASSERT_BUF_COMPARE(zeroCopyRawPacket.getRawData(), copyRawPacket.getRawData(), copyRawPacket.getRawDataLen());
+		packetCount++;
+	}
+	PTF_ASSERT_FALSE(ngZeroCopyReaderDev.getNextPacket(zeroCopyRawPacket));
+	PTF_ASSERT_GREATER_THAN(packetCount, 0, int);
+} // TestPcapFileReadZeroCopyAndBatch
+
+
+
+static void writeUint32(std::ofstream& out, uint32_t value, bool bigEndian)
+{
+	uint8_t bytes[4];
+	for (int i = 0; i < 4; i++)
+		bytes[bigEndian ? 3 - i : i] = (uint8_t)(value >> (8*i));
+	out.write((const char*)bytes, 4);
+}
+
+static void writeUint16(std::ofstream& out, uint16_t value, bool bigEndian)
+{
+	uint8_t bytes[2];
+	bytes[bigEndian ? 1 : 0] = (uint8_t)value;
+	bytes[bigEndian ? 0 : 1] = (uint8_t)(value >> 8);
+	out.write((const char*)bytes, 2);
+}
+
+PTF_TEST_CASE(TestMmapPcapFileRead)
+{
+	// getReader() picks the reader by extension and magic number, the memory-mapped reader is used only when requested
+	pcpp::IFileReaderDevice* genericReader = pcpp::IFileReaderDevice::getReader(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_NULL(dynamic_cast<pcpp::MmapPcapFileReaderDevice*>(genericReader));
+	PTF_ASSERT_NOT_NULL(dynamic_cast<pcpp::PcapFileReaderDevice*>(genericReader));
+	delete genericReader;
+	genericReader = pcpp::IFileReaderDevice::getReader(EXAMPLE_PCAP_PATH, true);
+	PTF_ASSERT_NOT_NULL(dynamic_cast<pcpp::MmapPcapFileReaderDevice*>(genericReader));
+	PTF_ASSERT_NOT_NULL(dynamic_cast<pcpp::PcapFileReaderDevice*>(genericReader));
+	delete genericReader;
+	genericReader = pcpp::IFileReaderDevice::getReader(EXAMPLE2_PCAPNG_PATH, true);
+	PTF_ASSERT_NOT_NULL(dynamic_cast<pcpp::PcapNgFileReaderDevice*>(genericReader));
+	delete genericReader;
+
+	// compare to the libpcap-based reader, with and without zero-copy mode
+	for (int zeroCopy = 0; zeroCopy < 2; zeroCopy++)
+	{
+		pcpp::PcapFileReaderDevice pcapReaderDev(EXAMPLE_PCAP_PATH);
+		pcpp::MmapPcapFileReaderDevice mmapReaderDev(EXAMPLE_PCAP_PATH);
+		PTF_ASSERT_TRUE(pcapReaderDev.open());
+		PTF_ASSERT_TRUE(mmapReaderDev.open());
+		mmapReaderDev.setZeroCopyMode(zeroCopy == 1);
+		PTF_ASSERT_FALSE(mmapReaderDev.isNanoSecondPrecision());
+		PTF_ASSERT_EQUAL(mmapReaderDev.getLinkLayerType(), pcapReaderDev.getLinkLayerType(), enum);
+
+		pcpp::RawPacket pcapRawPacket;
+		pcpp::RawPacket mmapRawPacket;
+		int packetCount = 0;
+		while (pcapReaderDev.getNextPacket(pcapRawPacket))
+		{
+			PTF_ASSERT_TRUE(mmapReaderDev.getNextPacket(mmapRawPacket));
+			PTF_ASSERT_EQUAL(mmapRawPacket.getRawDataLen(), pcapRawPacket.getRawDataLen(), int);
+			PTF_ASSERT_EQUAL(mmapRawPacket.getFrameLength(), pcapRawPacket.getFrameLength(), int);
+			PTF_ASSERT_EQUAL(mmapRawPacket.getLinkLayerType(), pcapRawPacket.getLinkLayerType(), enum);
+			PTF_ASSERT_EQUAL(mmapRawPacket.getPacketTimeStamp().tv_sec, pcapRawPacket.getPacketTimeStamp().tv_sec, u64);
+			PTF_ASSERT_EQUAL(mmapRawPacket.getPacketTimeStamp().tv_nsec, pcapRawPacket.getPacketTimeStamp().tv_nsec, u64);
+			PTF_ASSERT_BUF_COMPARE(mmapRawPacket.getRawData(), pcapRawPacket.getRawData(), pcapRawPacket.getRawDataLen());
+			packetCount++;
+		}
+		PTF_ASSERT_FALSE(mmapReaderDev.getNextPacket(mmapRawPacket));
+		PTF_ASSERT_EQUAL(packetCount, 4631, int);
+
+		pcap_stat readerStatistics;
+		mmapReaderDev.getStatistics(readerStatistics);
+		PTF_ASSERT_EQUAL((uint32_t)readerStatistics.ps_recv, 4631, u32);
+	}
+
+	// in zero-copy mode batches point into the mapped file and stay valid until the file is closed
+	pcpp::MmapPcapFileReaderDevice batchReaderDev(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(batchReaderDev.open());
+	batchReaderDev.setZeroCopyMode(true);
+	pcpp::RawPacket batch1[16];
+	pcpp::RawPacket batch2[16];
+	PTF_ASSERT_EQUAL(batchReaderDev.getNextPackets(batch1, 16), 16, int);
+	PTF_ASSERT_EQUAL(batchReaderDev.getNextPackets(batch2, 16), 16, int);
+	pcpp::PcapFileReaderDevice batchReferenceReaderDev(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(batchReferenceReaderDev.open());
+	for (int i = 0; i < 32; i++)
+	{
+		pcpp::RawPacket referenceRawPacket;
+		PTF_ASSERT_TRUE(batchReferenceReaderDev.getNextPacket(referenceRawPacket));
+		pcpp::RawPacket& batchRawPacket = (i < 16 ? batch1[i] : batch2[i-16]);
+		PTF_ASSERT_BUF_COMPARE(batchRawPacket.getRawData(), referenceRawPacket.getRawData(), referenceRawPacket.getRawDataLen());
+	}
+	batchReaderDev.close();
+
+	// raw IP files get the same link type as with libpcap
+	pcpp::PcapFileReaderDevice rawIpPcapReaderDev(RAW_IP_PCAP_PATH);
+	pcpp::MmapPcapFileReaderDevice rawIpMmapReaderDev(RAW_IP_PCAP_PATH);
+	PTF_ASSERT_TRUE(rawIpPcapReaderDev.open());
+	PTF_ASSERT_TRUE(rawIpMmapReaderDev.open());
+	PTF_ASSERT_EQUAL(rawIpMmapReaderDev.getLinkLayerType(), rawIpPcapReaderDev.getLinkLayerType(), enum);
+
+	// convert the first packets of the example file to a big-endian file with nanosecond precision
+	pcpp::PcapFileReaderDevice origReaderDev(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(origReaderDev.open());
+	std::ofstream bigEndianFile(EXAMPLE_PCAP_BIG_ENDIAN_NSEC_WRITE_PATH, std::ofstream::binary | std::ofstream::trunc);
+	writeUint32(bigEndianFile, 0xa1b23c4d, true);
+	writeUint16(bigEndianFile, 2, true);
+	writeUint16(bigEndianFile, 4, true);
+	writeUint32(bigEndianFile, 0, true);
+	writeUint32(bigEndianFile, 0, true);
+	writeUint32(bigEndianFile, 65535, true);
+	writeUint32(bigEndianFile, 1, true);
+	pcpp::RawPacket origRawPacket;
+	for (int i = 0; i < 100; i++)
+	{
+		PTF_ASSERT_TRUE(origReaderDev.getNextPacket(origRawPacket));
+		writeUint32(bigEndianFile, (uint32_t)origRawPacket.getPacketTimeStamp().tv_sec, true);
+		writeUint32(bigEndianFile, (uint32_t)origRawPacket.getPacketTimeStamp().tv_nsec + i, true);
+		writeUint32(bigEndianFile, (uint32_t)origRawPacket.getRawDataLen(), true);
+		writeUint32(bigEndianFile, (uint32_t)origRawPacket.getFrameLength(), true);
+		bigEndianFile.write((const char*)origRawPacket.getRawData(), origRawPacket.getRawDataLen());
+	}
+	bigEndianFile.close();
+	origReaderDev.close();
+
+	PTF_ASSERT_TRUE(origReaderDev.open());
+	pcpp::MmapPcapFileReaderDevice bigEndianReaderDev(EXAMPLE_PCAP_BIG_ENDIAN_NSEC_WRITE_PATH);
+	PTF_ASSERT_TRUE(bigEndianReaderDev.open());
+	PTF_ASSERT_TRUE(bigEndianReaderDev.isNanoSecondPrecision());
+	PTF_ASSERT_EQUAL(bigEndianReaderDev.getSnapshotLength(), 65535, u32);
+	PTF_ASSERT_EQUAL(bigEndianReaderDev.getLinkLayerType(), pcpp::LINKTYPE_ETHERNET, enum);
+	pcpp::RawPacket bigEndianRawPacket;
+	for (int i = 0; i < 100; i++)
+	{
+		PTF_ASSERT_TRUE(origReaderDev.getNextPacket(origRawPacket));
+		PTF_ASSERT_TRUE(bigEndianReaderDev.getNextPacket(bigEndianRawPacket));
+		PTF_ASSERT_EQUAL(bigEndianRawPacket.getRawDataLen(), origRawPacket.getRawDataLen(), int);
+		PTF_ASSERT_EQUAL(bigEndianRawPacket.getPacketTimeStamp().tv_sec, origRawPacket.getPacketTimeStamp().tv_sec, u64);
+		PTF_ASSERT_EQUAL(bigEndianRawPacket.getPacketTimeStamp().tv_nsec, origRawPacket.getPacketTimeStamp().tv_nsec + i, u64);
+		PTF_ASSERT_BUF_COMPARE(bigEndianRawPacket.getRawData(), origRawPacket.getRawData(), origRawPacket.getRawDataLen());
+	}
+	PTF_ASSERT_FALSE(bigEndianReaderDev.getNextPacket(bigEndianRawPacket));
+	bigEndianReaderDev.close();
+
+	// a truncated last record ends the read
+	std::ofstream truncatedFile(EXAMPLE_PCAP_TRUNCATED_WRITE_PATH, std::ofstream::binary | std::ofstream::trunc);
+	writeUint32(truncatedFile, 0xa1b2c3d4, false);
+	writeUint16(truncatedFile, 2, false);
+	writeUint16(truncatedFile, 4, false);
+	writeUint32(truncatedFile, 0, false);
+	writeUint32(truncatedFile, 0, false);
+	writeUint32(truncatedFile, 65535, false);
+	writeUint32(truncatedFile, 1, false);
+	for (int i = 0; i < 2; i++)
+	{
+		writeUint32(truncatedFile, 0, false);
+		writeUint32(truncatedFile, 0, false);
+		writeUint32(truncatedFile, (uint32_t)origRawPacket.getRawDataLen(), false);
+		writeUint32(truncatedFile, (uint32_t)origRawPacket.getRawDataLen(), false);
+		truncatedFile.write((const char*)origRawPacket.getRawData(), (i == 0 ? origRawPacket.getRawDataLen() : 10));
+	}
+	truncatedFile.close();
+
+	pcpp::MmapPcapFileReaderDevice truncatedReaderDev(EXAMPLE_PCAP_TRUNCATED_WRITE_PATH);
+	PTF_ASSERT_TRUE(truncatedReaderDev.open());
+	pcpp::RawPacket truncatedRawPacket;
+	PTF_ASSERT_TRUE(truncatedReaderDev.getNextPacket(truncatedRawPacket));
+	pcpp::LoggerPP::getInstance().supressErrors();
+	PTF_ASSERT_FALSE(truncatedReaderDev.getNextPacket(truncatedRawPacket));
+	PTF_ASSERT_FALSE(truncatedReaderDev.getNextPacket(truncatedRawPacket));
+	pcpp::LoggerPP::getInstance().enableErrors();
+
+	// a record longer than the snapshot length is cut to the snapshot length and the next record is read from the right offset
+	std::ofstream snapLenFile(EXAMPLE_PCAP_SNAPLEN_WRITE_PATH, std::ofstream::binary | std::ofstream::trunc);
+	writeUint32(snapLenFile, 0xa1b2c3d4, false);
+	writeUint16(snapLenFile, 2, false);
+	writeUint16(snapLenFile, 4, false);
+	writeUint32(snapLenFile, 0, false);
+	writeUint32(snapLenFile, 0, false);
+	writeUint32(snapLenFile, 64, false);
+	writeUint32(snapLenFile, 1, false);
+	for (int i = 0; i < 2; i++)
+	{
+		uint32_t capLen = (i == 0 ? (uint32_t)origRawPacket.getRawDataLen() : 64);
+		writeUint32(snapLenFile, i, false);
+		writeUint32(snapLenFile, 0, false);
+		writeUint32(snapLenFile, capLen, false);
+		writeUint32(snapLenFile, (uint32_t)origRawPacket.getRawDataLen(), false);
+		snapLenFile.write((const char*)origRawPacket.getRawData(), capLen);
+	}
+	snapLenFile.close();
+
+	pcpp::MmapPcapFileReaderDevice snapLenReaderDev(EXAMPLE_PCAP_SNAPLEN_WRITE_PATH);
+	PTF_ASSERT_TRUE(snapLenReaderDev.open());
+	pcpp::RawPacket snapLenRawPacket;
+	for (int i = 0; i < 2; i++)
+	{
+		PTF_ASSERT_TRUE(snapLenReaderDev.getNextPacket(snapLenRawPacket));
+		PTF_ASSERT_EQUAL(snapLenRawPacket.getPacketTimeStamp().tv_sec, i, u64);
+		PTF_ASSERT_EQUAL(snapLenRawPacket.getRawDataLen(), 64, int);
+		PTF_ASSERT_EQUAL(snapLenRawPacket.getFrameLength(), origRawPacket.getRawDataLen(), int);
+		PTF_ASSERT_BUF_COMPARE(snapLenRawPacket.getRawData(), origRawPacket.getRawData(), 64);
+	}
+	PTF_ASSERT_FALSE(snapLenReaderDev.getNextPacket(snapLenRawPacket));
+	snapLenReaderDev.close();
+	pcpp::LoggerPP::getInstance().supressErrors();
+
+	// pcap-ng files and non-existing files can't be opened
+	pcpp::MmapPcapFileReaderDevice pcapngReaderDev(EXAMPLE2_PCAPNG_PATH);
+	PTF_ASSERT_FALSE(pcapngReaderDev.open());
+	pcpp::MmapPcapFileReaderDevice nonExistingReaderDev("PcapExamples/non_existing_file.pcap");
+	PTF_ASSERT_FALSE(nonExistingReaderDev.open());
+	pcpp::LoggerPP::getInstance().enableErrors();
+} // TestMmapPcapFileRead
+
+
+
+struct ParallelReadStats
+{
+	int packetCount[8];
+	int tcpCount[8];
+	int udpCount[8];
+};
+
+static bool countParallelPackets(pcpp::Packet& packet, int workerId, void* userCookie)
+{
+	ParallelReadStats* stats = (ParallelReadStats*)userCookie;
+	stats->packetCount[workerId]++;
+	if (packet.isPacketOfType(pcpp::TCP))
+		stats->tcpCount[workerId]++;
+	if (packet.isPacketOfType(pcpp::UDP))
+		stats->udpCount[workerId]++;
+	return true;
+}
+
+static bool keepUdpPackets(pcpp::Packet& packet, int workerId, void* userCookie)
+{
+	return packet.isPacketOfType(pcpp::UDP);
+}
+
+struct OrderedReadStats
+{
+	int packetCount;
+	bool inFileOrder;
+	bool allUdp;
+	bool udpOnly;
+	pcpp::IFileReaderDevice* referenceReader;
+};
+
+static void collectOrderedPackets(pcpp::Packet& packet, void* userCookie)
+{
+	OrderedReadStats* stats = (OrderedReadStats*)userCookie;
+
+	// compare the packet to the next one a sequential reader returns (skipping the ones the workers dropped)
+	pcpp::RawPacket referenceRawPacket;
+	while (true)
+	{
+		if (!stats->referenceReader->getNextPacket(referenceRawPacket))
+		{
+			stats->inFileOrder = false;
+			break;
+		}
+
+		pcpp::Packet referencePacket(&referenceRawPacket);
+		if (stats->udpOnly && !referencePacket.isPacketOfType(pcpp::UDP))
+			continue;
+
+		if (referenceRawPacket.getRawDataLen() != packet.getRawPacket()->getRawDataLen() ||
+				memcmp(referenceRawPacket.getRawData(), packet.getRawPacket()->getRawData(), referenceRawPacket.getRawDataLen()) != 0)
+			stats->inFileOrder = false;
+		break;
+	}
+
+	if (!packet.isPacketOfType(pcpp::UDP))
+		stats->allUdp = false;
+	stats->packetCount++;
+}
+
+struct TimestampOrderStats
+{
+	int packetCount;
+	bool sorted;
+	timespec firstTimestamp;
+	timespec lastTimestamp;
+};
+
+static void collectTimestampOrderedPackets(pcpp::Packet& packet, void* userCookie)
+{
+	TimestampOrderStats* stats = (TimestampOrderStats*)userCookie;
+	timespec timestamp = packet.getRawPacket()->getPacketTimeStamp();
+	if (stats->packetCount == 0)
+		stats->firstTimestamp = timestamp;
+	else if (timestamp.tv_sec < stats->lastTimestamp.tv_sec || (timestamp.tv_sec == stats->lastTimestamp.tv_sec && timestamp.tv_nsec < stats->lastTimestamp.tv_nsec))
+		stats->sorted = false;
+
+	stats->lastTimestamp = timestamp;
+	stats->packetCount++;
+}
+
+static bool overwriteIndexEntry(const std::string& indexFileName, size_t numOfEntries, size_t entryIndex, uint64_t offset)
+{
+	// the entry offsets are at the end of the index file
+	std::fstream indexFile(indexFileName.c_str(), std::ios::in | std::ios::out | std::ios::binary | std::ios::ate);
+	if (!indexFile.is_open())
+		return false;
+
+	std::streamoff entriesStart = (std::streamoff)indexFile.tellp() - (std::streamoff)(numOfEntries * sizeof(uint64_t));
+	indexFile.seekp(entriesStart + (std::streamoff)(entryIndex * sizeof(uint64_t)));
+	indexFile.write((const char*)&offset, sizeof(offset));
+	return indexFile.good();
+}
+
+PTF_TEST_CASE(TestParallelPcapFileRead)
+{
+	// build an index, save it and load it back
+	pcpp::PcapFileIndex index;
+	PTF_ASSERT_FALSE(index.isValid());
+	PTF_ASSERT_TRUE(index.build(EXAMPLE_PCAP_PATH, 100));
+	PTF_ASSERT_TRUE(index.isValid());
+	PTF_ASSERT_EQUAL(index.getNumOfPackets(), 4631, u64);
+	PTF_ASSERT_EQUAL(index.getNumOfEntries(), 47, size);
+	PTF_ASSERT_EQUAL(index.getEntryOffset(0), 24, u64);
+
+	std::string sidecarFileName = pcpp::PcapFileIndex::getSidecarFileName(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_EQUAL(sidecarFileName, std::string(EXAMPLE_PCAP_PATH) + ".pcppidx", string);
+	PTF_ASSERT_TRUE(index.save(sidecarFileName));
+	pcpp::PcapFileIndex loadedIndex;
+	PTF_ASSERT_TRUE(loadedIndex.load(EXAMPLE_PCAP_PATH, sidecarFileName));
+	PTF_ASSERT_EQUAL(loadedIndex.getNumOfPackets(), 4631, u64);
+	PTF_ASSERT_EQUAL(loadedIndex.getPacketsPerEntry(), 100, u32);
+	PTF_ASSERT_EQUAL(loadedIndex.getNumOfEntries(), index.getNumOfEntries(), size);
+	for (size_t i = 0; i < index.getNumOfEntries(); i++)
+	{
+		PTF_ASSERT_EQUAL(loadedIndex.getEntryOffset(i), index.getEntryOffset(i), u64);
+	}
+
+	// an index doesn't match a different file
+	PTF_ASSERT_FALSE(loadedIndex.load(EXAMPLE2_PCAP_PATH, sidecarFileName));
+	PTF_ASSERT_FALSE(loadedIndex.isValid());
+
+	// an index doesn't match its file after the file is modified, even if its size stays the same. loadOrBuild() rebuilds it
+	{
+		std::ifstream exampleFile(EXAMPLE_PCAP_PATH, std::ios::binary);
+		std::ofstream indexedFile(EXAMPLE_PCAP_INDEXED_WRITE_PATH, std::ios::binary);
+		indexedFile << exampleFile.rdbuf();
+	}
+	std::string indexedSidecarFileName = pcpp::PcapFileIndex::getSidecarFileName(EXAMPLE_PCAP_INDEXED_WRITE_PATH);
+	pcpp::PcapFileIndex indexedFileIndex;
+	PTF_ASSERT_TRUE(indexedFileIndex.build(EXAMPLE_PCAP_INDEXED_WRITE_PATH, 100));
+	PTF_ASSERT_TRUE(indexedFileIndex.save(indexedSidecarFileName));
+	PTF_ASSERT_TRUE(loadedIndex.load(EXAMPLE_PCAP_INDEXED_WRITE_PATH, indexedSidecarFileName));
+	PTF_ASSERT_EQUAL(loadedIndex.getPcapFileModificationTime(), indexedFileIndex.getPcapFileModificationTime(), u64);
+	struct utimbuf newFileTimes;
+	newFileTimes.actime = (time_t)indexedFileIndex.getPcapFileModificationTime() + 10;
+	newFileTimes.modtime = newFileTimes.actime;
+	PTF_ASSERT_EQUAL(utime(EXAMPLE_PCAP_INDEXED_WRITE_PATH, &newFileTimes), 0, int);
+	PTF_ASSERT_FALSE(loadedIndex.load(EXAMPLE_PCAP_INDEXED_WRITE_PATH, indexedSidecarFileName));
+	PTF_ASSERT_TRUE(loadedIndex.loadOrBuild(EXAMPLE_PCAP_INDEXED_WRITE_PATH, true, 200));
+	PTF_ASSERT_EQUAL(loadedIndex.getPacketsPerEntry(), 200, u32);
+	PTF_ASSERT_TRUE(loadedIndex.load(EXAMPLE_PCAP_INDEXED_WRITE_PATH, indexedSidecarFileName));
+	PTF_ASSERT_EQUAL(loadedIndex.getPacketsPerEntry(), 200, u32);
+
+	// an index whose offsets are before the first packet record, after the packet data or out of order isn't loaded
+	pcpp::PcapFileIndex validIndex;
+	PTF_ASSERT_TRUE(validIndex.build(EXAMPLE_PCAP_INDEXED_WRITE_PATH, 200));
+	size_t numOfEntries = validIndex.getNumOfEntries();
+	pcpp::LoggerPP::getInstance().supressErrors();
+	PTF_ASSERT_TRUE(overwriteIndexEntry(indexedSidecarFileName, numOfEntries, 0, 0));
+	PTF_ASSERT_FALSE(loadedIndex.load(EXAMPLE_PCAP_INDEXED_WRITE_PATH, indexedSidecarFileName));
+	PTF_ASSERT_TRUE(validIndex.save(indexedSidecarFileName));
+	PTF_ASSERT_TRUE(overwriteIndexEntry(indexedSidecarFileName, numOfEntries, numOfEntries - 1, validIndex.getPcapFileSize()));
+	PTF_ASSERT_FALSE(loadedIndex.load(EXAMPLE_PCAP_INDEXED_WRITE_PATH, indexedSidecarFileName));
+	PTF_ASSERT_TRUE(validIndex.save(indexedSidecarFileName));
+	PTF_ASSERT_TRUE(overwriteIndexEntry(indexedSidecarFileName, numOfEntries, 2, validIndex.getEntryOffset(1)));
+	PTF_ASSERT_FALSE(loadedIndex.load(EXAMPLE_PCAP_INDEXED_WRITE_PATH, indexedSidecarFileName));
+	PTF_ASSERT_TRUE(loadedIndex.loadOrBuild(EXAMPLE_PCAP_INDEXED_WRITE_PATH, false, 300));
+	pcpp::LoggerPP::getInstance().enableErrors();
+	PTF_ASSERT_EQUAL(loadedIndex.getPacketsPerEntry(), 300, u32);
+	PTF_ASSERT_TRUE(validIndex.save(indexedSidecarFileName));
+	PTF_ASSERT_TRUE(loadedIndex.load(EXAMPLE_PCAP_INDEXED_WRITE_PATH, indexedSidecarFileName));
+	PTF_ASSERT_EQUAL(remove(indexedSidecarFileName.c_str()), 0, int);
+	PTF_ASSERT_EQUAL(remove(EXAMPLE_PCAP_INDEXED_WRITE_PATH), 0, int);
+
+	// chunks cover all packets with no gaps, and each chunk starts where its first packet is
+	std::vector<pcpp::PcapFileChunk> chunks;
+	PTF_ASSERT_EQUAL(index.getChunks(3, chunks), 3, size);
+	uint64_t totalPackets = 0;
+	pcpp::MmapPcapFileReaderDevice chunkReaderDev(EXAMPLE_PCAP_PATH);
+	pcpp::PcapFileReaderDevice referenceReaderDev(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(chunkReaderDev.open());
+	PTF_ASSERT_TRUE(referenceReaderDev.open());
+	pcpp::RawPacket chunkRawPacket;
+	pcpp::RawPacket referenceRawPacket;
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		PTF_ASSERT_EQUAL(chunks[i].firstPacketIndex, totalPackets, u64);
+		if (i > 0)
+		{
+			PTF_ASSERT_EQUAL(chunks[i].startOffset, chunks[i-1].endOffset, u64);
+		}
+		PTF_ASSERT_TRUE(chunkReaderDev.setReadOffset(chunks[i].startOffset));
+		for (uint64_t j = 0; j < chunks[i].numOfPackets; j++)
+		{
+			PTF_ASSERT_TRUE(chunkReaderDev.getNextPacket(chunkRawPacket));
+			PTF_ASSERT_TRUE(referenceReaderDev.getNextPacket(referenceRawPacket));
+			PTF_ASSERT_BUF_COMPARE(chunkRawPacket.getRawData(), referenceRawPacket.getRawData(), referenceRawPacket.getRawDataLen());
+		}
+		PTF_ASSERT_EQUAL(chunkReaderDev.getReadOffset(), chunks[i].endOffset, u64);
+		totalPackets += chunks[i].numOfPackets;
+	}
+	PTF_ASSERT_EQUAL(totalPackets, 4631, u64);
+	PTF_ASSERT_EQUAL(chunks[2].endOffset, index.getPcapFileSize(), u64);
+	PTF_ASSERT_EQUAL(index.getChunks(100, chunks), 47, size);
+	chunkReaderDev.close();
+
+	// the reader picks up the sidecar index
+	pcpp::ParallelPcapFileReader parallelReader(EXAMPLE_PCAP_PATH, 4);
+	PTF_ASSERT_FALSE(parallelReader.isOpened());
+	PTF_ASSERT_TRUE(parallelReader.open());
+	PTF_ASSERT_EQUAL(parallelReader.getIndex().getPacketsPerEntry(), 100, u32);
+	PTF_ASSERT_EQUAL(parallelReader.getLinkLayerType(), pcpp::LINKTYPE_ETHERNET, enum);
+	PTF_ASSERT_EQUAL(remove(sidecarFileName.c_str()), 0, int);
+
+	// unordered processing
+	ParallelReadStats stats;
+	memset(&stats, 0, sizeof(stats));
+	PTF_ASSERT_TRUE(parallelReader.processPackets(countParallelPackets, &stats));
+	int packetCount = 0, tcpCount = 0, udpCount = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		PTF_ASSERT_GREATER_THAN(stats.packetCount[i], 0, int);
+		packetCount += stats.packetCount[i];
+		tcpCount += stats.tcpCount[i];
+		udpCount += stats.udpCount[i];
+	}
+	PTF_ASSERT_EQUAL(packetCount, 4631, int);
+	PTF_ASSERT_EQUAL(tcpCount, 4492, int);
+	PTF_ASSERT_EQUAL(udpCount, 139, int);
+	PTF_ASSERT_EQUAL(parallelReader.getNumOfPacketsProcessed(), 4631, u64);
+
+	// ordered processing, with and without filtering in the workers. Packets are handed in file order
+	OrderedReadStats orderedStats;
+	memset(&orderedStats, 0, sizeof(orderedStats));
+	orderedStats.inFileOrder = true;
+	orderedStats.allUdp = true;
+	orderedStats.referenceReader = new pcpp::PcapFileReaderDevice(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(orderedStats.referenceReader->open());
+	PTF_ASSERT_TRUE(parallelReader.processPacketsOrdered(NULL, NULL, collectOrderedPackets, &orderedStats));
+	PTF_ASSERT_EQUAL(orderedStats.packetCount, 4631, int);
+	PTF_ASSERT_TRUE(orderedStats.inFileOrder);
+	delete orderedStats.referenceReader;
+
+	memset(&orderedStats, 0, sizeof(orderedStats));
+	orderedStats.inFileOrder = true;
+	orderedStats.allUdp = true;
+	orderedStats.udpOnly = true;
+	orderedStats.referenceReader = new pcpp::PcapFileReaderDevice(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(orderedStats.referenceReader->open());
+	PTF_ASSERT_TRUE(parallelReader.processPacketsOrdered(keepUdpPackets, NULL, collectOrderedPackets, &orderedStats));
+	PTF_ASSERT_EQUAL(orderedStats.packetCount, 139, int);
+	PTF_ASSERT_TRUE(orderedStats.inFileOrder);
+	PTF_ASSERT_TRUE(orderedStats.allUdp);
+	delete orderedStats.referenceReader;
+	parallelReader.close();
+	PTF_ASSERT_FALSE(parallelReader.isOpened());
+
+	// a reader with the default index and more workers than index entries
+	pcpp::ParallelPcapFileReader defaultIndexReader(EXAMPLE_PCAP_PATH, 8);
+	PTF_ASSERT_TRUE(defaultIndexReader.open());
+	PTF_ASSERT_EQUAL(defaultIndexReader.getIndex().getNumOfEntries(), 2, size);
+	memset(&orderedStats, 0, sizeof(orderedStats));
+	orderedStats.inFileOrder = true;
+	orderedStats.referenceReader = new pcpp::PcapFileReaderDevice(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(orderedStats.referenceReader->open());
+	PTF_ASSERT_TRUE(defaultIndexReader.processPacketsOrdered(NULL, NULL, collectOrderedPackets, &orderedStats));
+	PTF_ASSERT_EQUAL(orderedStats.packetCount, 4631, int);
+	PTF_ASSERT_TRUE(orderedStats.inFileOrder);
+	delete orderedStats.referenceReader;
+
+	// a filter is compiled once and shared by all workers
+	pcpp::ProtoFilter udpFilter(pcpp::UDP);
+	PTF_ASSERT_TRUE(defaultIndexReader.setFilter(udpFilter));
+	memset(&stats, 0, sizeof(stats));
+	PTF_ASSERT_TRUE(defaultIndexReader.processPackets(countParallelPackets, &stats));
+	PTF_ASSERT_EQUAL(defaultIndexReader.getNumOfPacketsProcessed(), 139, u64);
+	PTF_ASSERT_FALSE(defaultIndexReader.setFilter("bla bla bla"));
+	defaultIndexReader.close();
+
+	// packets are handed in file order even if their timestamps aren't monotonic
+	pcpp::PcapFileReaderDevice sortedReaderDev(EXAMPLE_PCAP_PATH);
+	pcpp::PcapFileWriterDevice unsortedWriterDev(EXAMPLE_PCAP_WRITE_PATH);
+	PTF_ASSERT_TRUE(sortedReaderDev.open());
+	PTF_ASSERT_TRUE(unsortedWriterDev.open());
+	pcpp::RawPacket rawPacket;
+	time_t timestamp = 1000000;
+	while (sortedReaderDev.getNextPacket(rawPacket))
+	{
+		timeval packetTimestamp = { timestamp--, 0 };
+		rawPacket.setPacketTimeStamp(packetTimestamp);
+		PTF_ASSERT_TRUE(unsortedWriterDev.writePacket(rawPacket));
+	}
+	sortedReaderDev.close();
+	unsortedWriterDev.close();
+
+	pcpp::ParallelPcapFileReader unsortedReader(EXAMPLE_PCAP_WRITE_PATH, 4);
+	PTF_ASSERT_TRUE(unsortedReader.open());
+	memset(&orderedStats, 0, sizeof(orderedStats));
+	orderedStats.inFileOrder = true;
+	orderedStats.referenceReader = new pcpp::PcapFileReaderDevice(EXAMPLE_PCAP_WRITE_PATH);
+	PTF_ASSERT_TRUE(orderedStats.referenceReader->open());
+	PTF_ASSERT_TRUE(unsortedReader.processPacketsOrdered(NULL, NULL, collectOrderedPackets, &orderedStats));
+	PTF_ASSERT_EQUAL(orderedStats.packetCount, 4631, int);
+	PTF_ASSERT_TRUE(orderedStats.inFileOrder);
+	delete orderedStats.referenceReader;
+
+	// in timestamp order the chunks (packets 0-4095 and 4096-4630) are merged by their next packets. All packets of the second chunk are
+	// earlier than those of the first one, so it's handed first
+	PTF_ASSERT_EQUAL(unsortedReader.getIndex().getNumOfEntries(), 2, size);
+	TimestampOrderStats timestampStats;
+	memset(&timestampStats, 0, sizeof(timestampStats));
+	timestampStats.sorted = true;
+	PTF_ASSERT_TRUE(unsortedReader.processPacketsOrdered(NULL, NULL, collectTimestampOrderedPackets, &timestampStats, pcpp::ParallelPcapFileReader::TimestampOrder));
+	PTF_ASSERT_EQUAL(timestampStats.packetCount, 4631, int);
+	PTF_ASSERT_EQUAL(timestampStats.firstTimestamp.tv_sec, 1000000 - 4096, u64);
+	PTF_ASSERT_EQUAL(timestampStats.lastTimestamp.tv_sec, 1000000 - 4095, u64);
+	PTF_ASSERT_FALSE(timestampStats.sorted);
+	unsortedReader.close();
+
+	// when each chunk is sorted by timestamp the merge sorts the whole file, while file order keeps the chunks apart
+	PTF_ASSERT_TRUE(sortedReaderDev.open());
+	pcpp::PcapFileWriterDevice interleavedWriterDev(EXAMPLE_PCAP_INTERLEAVED_WRITE_PATH);
+	PTF_ASSERT_TRUE(interleavedWriterDev.open());
+	for (int i = 0; sortedReaderDev.getNextPacket(rawPacket); i++)
+	{
+		timeval packetTimestamp = { 1000000 + (i < 4096 ? 2 * i : 2 * (i - 4096) + 1), 0 };
+		rawPacket.setPacketTimeStamp(packetTimestamp);
+		PTF_ASSERT_TRUE(interleavedWriterDev.writePacket(rawPacket));
+	}
+	sortedReaderDev.close();
+	interleavedWriterDev.close();
+
+	pcpp::ParallelPcapFileReader interleavedReader(EXAMPLE_PCAP_INTERLEAVED_WRITE_PATH, 2);
+	PTF_ASSERT_TRUE(interleavedReader.open());
+	memset(&timestampStats, 0, sizeof(timestampStats));
+	timestampStats.sorted = true;
+	PTF_ASSERT_TRUE(interleavedReader.processPacketsOrdered(NULL, NULL, collectTimestampOrderedPackets, &timestampStats, pcpp::ParallelPcapFileReader::TimestampOrder));
+	PTF_ASSERT_EQUAL(timestampStats.packetCount, 4631, int);
+	PTF_ASSERT_TRUE(timestampStats.sorted);
+	PTF_ASSERT_EQUAL(timestampStats.firstTimestamp.tv_sec, 1000000, u64);
+	PTF_ASSERT_EQUAL(timestampStats.lastTimestamp.tv_sec, 1000000 + 2 * 4095, u64);
+
+	memset(&timestampStats, 0, sizeof(timestampStats));
+	timestampStats.sorted = true;
+	PTF_ASSERT_TRUE(interleavedReader.processPacketsOrdered(NULL, NULL, collectTimestampOrderedPackets, &timestampStats, pcpp::ParallelPcapFileReader::FileOrder));
+	PTF_ASSERT_EQUAL(timestampStats.packetCount, 4631, int);
+	PTF_ASSERT_FALSE(timestampStats.sorted);
+	PTF_ASSERT_EQUAL(timestampStats.lastTimestamp.tv_sec, 1000000 + 2 * (4630 - 4096) + 1, u64);
+
+	// a filter applies in timestamp order as well
+	PTF_ASSERT_TRUE(interleavedReader.setFilter(udpFilter));
+	memset(&timestampStats, 0, sizeof(timestampStats));
+	timestampStats.sorted = true;
+	PTF_ASSERT_TRUE(interleavedReader.processPacketsOrdered(NULL, NULL, collectTimestampOrderedPackets, &timestampStats, pcpp::ParallelPcapFileReader::TimestampOrder));
+	PTF_ASSERT_EQUAL(timestampStats.packetCount, 139, int);
+	PTF_ASSERT_TRUE(timestampStats.sorted);
+	interleavedReader.close();
+} // TestParallelPcapFileRead
+
+
+
 PTF_TEST_CASE(TestPcapNgFileReadWrite)
 {
 	pcpp::PcapNgFileReaderDevice readerDev(EXAMPLE_PCAPNG_PATH);
@@ -7,10 +7,14 @@
 #include "UdpLayer.h"
 #include "PcapLiveDeviceList.h"
 #include "PcapFileDevice.h"
+#include "NativeFilterProgram.h"
+#include "CompiledFilter.h"
+#include "IPv6Layer.h"
 #include "../Common/GlobalTestArgs.h"
 #include "../Common/PcapFileNamesDef.h"
 #include "../Common/TestUtils.h"
 #include "PlatformSpecificUtils.h"
+#include <algorithm>
 
 
 extern PcapTestArgs PcapTestGlobalArgs;
@@ -712,4 +716,296 @@ PTF_TEST_CASE(TestPcapFiltersOffline)
 
 	}
 	rawPacketVec.clear();
-}
\ No newline at end of file
+} // TestPcapFiltersOffline
+
+
+
+
+static int countMatchingPackets(pcpp::GeneralFilter& filter, pcpp::RawPacketVector& rawPacketVec)
+{
+	int count = 0;
+	for (pcpp::RawPacketVector::VectorIterator iter = rawPacketVec.begin(); iter != rawPacketVec.end(); iter++)
+	{
+		if (filter.matchPacketWithFilter(*iter))
+			count++;
+	}
+
+	return count;
+}
+
+PTF_TEST_CASE(TestPcapFiltersNative)
+{
+	// the expected counts are the same as matching the BPF string of each filter with libpcap
+	pcpp::RawPacketVector vlanPackets, examplePackets, grePackets, igmpPackets;
+
+	pcpp::PcapFileReaderDevice fileReaderDev(EXAMPLE_PCAP_VLAN);
+	PTF_ASSERT_TRUE(fileReaderDev.open());
+	fileReaderDev.getNextPackets(vlanPackets);
+	fileReaderDev.close();
+
+	pcpp::PcapFileReaderDevice fileReaderDev2(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(fileReaderDev2.open());
+	fileReaderDev2.getNextPackets(examplePackets);
+	fileReaderDev2.close();
+
+	pcpp::PcapFileReaderDevice fileReaderDev3(EXAMPLE_PCAP_GRE);
+	PTF_ASSERT_TRUE(fileReaderDev3.open());
+	fileReaderDev3.getNextPackets(grePackets);
+	fileReaderDev3.close();
+
+	pcpp::PcapFileReaderDevice fileReaderDev4(EXAMPLE_PCAP_IGMP);
+	PTF_ASSERT_TRUE(fileReaderDev4.open());
+	fileReaderDev4.getNextPackets(igmpPackets);
+	fileReaderDev4.close();
+
+
+	//-----------------------
+	// Filters which compile
+	//-----------------------
+
+	pcpp::MacAddressFilter macFilter(pcpp::MacAddress("00:13:c3:df:ae:18"), pcpp::DST);
+	pcpp::NativeFilterProgram program;
+	PTF_ASSERT_TRUE(program.compile(macFilter));
+	PTF_ASSERT_TRUE(program.isUpToDate());
+	PTF_ASSERT_EQUAL(countMatchingPackets(macFilter, vlanPackets), 5, int);
+
+	pcpp::EtherTypeFilter ethTypeFilter(PCPP_ETHERTYPE_VLAN);
+	PTF_ASSERT_EQUAL(countMatchingPackets(ethTypeFilter, vlanPackets), 24, int);
+
+	pcpp::IPv4IDFilter ipIDFilter(0x9900, pcpp::GREATER_THAN);
+	PTF_ASSERT_EQUAL(countMatchingPackets(ipIDFilter, examplePackets), 1423, int);
+
+	pcpp::IPv4TotalLengthFilter totalLengthFilter(576, pcpp::LESS_OR_EQUAL);
+	PTF_ASSERT_EQUAL(countMatchingPackets(totalLengthFilter, examplePackets), 2066, int);
+
+	pcpp::TcpWindowSizeFilter windowSizeFilter(8312, pcpp::NOT_EQUALS);
+	PTF_ASSERT_EQUAL(countMatchingPackets(windowSizeFilter, examplePackets), 4249, int);
+
+	pcpp::UdpLengthFilter udpLengthFilter(46, pcpp::EQUALS);
+	PTF_ASSERT_EQUAL(countMatchingPackets(udpLengthFilter, examplePackets), 4, int);
+
+	pcpp::IPFilter ipFilter("212.199.202.9", pcpp::SRC, "255.255.255.0");
+	PTF_ASSERT_EQUAL(countMatchingPackets(ipFilter, examplePackets), 2536, int);
+	ipFilter.setLen(24);
+	PTF_ASSERT_EQUAL(countMatchingPackets(ipFilter, examplePackets), 2536, int);
+
+	pcpp::PortRangeFilter portRangeFilter(40000, 50000, pcpp::SRC);
+	PTF_ASSERT_EQUAL(countMatchingPackets(portRangeFilter, examplePackets), 1464, int);
+
+	pcpp::TcpFlagsFilter tcpFlagsFilter(pcpp::TcpFlagsFilter::tcpSyn | pcpp::TcpFlagsFilter::tcpAck, pcpp::TcpFlagsFilter::MatchAll);
+	PTF_ASSERT_EQUAL(countMatchingPackets(tcpFlagsFilter, examplePackets), 65, int);
+	tcpFlagsFilter.setTcpFlagsBitMask(pcpp::TcpFlagsFilter::tcpSyn | pcpp::TcpFlagsFilter::tcpAck, pcpp::TcpFlagsFilter::MatchOneAtLeast);
+	PTF_ASSERT_EQUAL(countMatchingPackets(tcpFlagsFilter, examplePackets), 4489, int);
+
+	pcpp::IPFilter ipFilter2("10.0.0.6", pcpp::SRC);
+	pcpp::ProtoFilter protoFilter(pcpp::UDP);
+	std::vector<pcpp::GeneralFilter*> filterVec;
+	filterVec.push_back(&ipFilter2);
+	filterVec.push_back(&protoFilter);
+	pcpp::AndFilter andFilter(filterVec);
+	PTF_ASSERT_EQUAL(countMatchingPackets(andFilter, examplePackets), 69, int);
+
+	pcpp::ProtoFilter arpFilter(pcpp::ARP);
+	PTF_ASSERT_EQUAL(countMatchingPackets(arpFilter, grePackets), 2, int);
+	pcpp::ProtoFilter tcpFilter(pcpp::TCP);
+	PTF_ASSERT_EQUAL(countMatchingPackets(tcpFilter, grePackets), 9, int);
+	pcpp::ProtoFilter greFilter(pcpp::GRE);
+	PTF_ASSERT_EQUAL(countMatchingPackets(greFilter, grePackets), 17, int);
+
+	pcpp::IPFilter ipFilter3("20.0.0.1", pcpp::SRC_OR_DST);
+	filterVec.clear();
+	filterVec.push_back(&greFilter);
+	filterVec.push_back(&ipFilter3);
+	pcpp::AndFilter andFilter2(filterVec);
+	filterVec.clear();
+	filterVec.push_back(&arpFilter);
+	filterVec.push_back(&andFilter2);
+	pcpp::OrFilter orFilter(filterVec);
+	PTF_ASSERT_EQUAL(countMatchingPackets(orFilter, grePackets), 19, int);
+
+	pcpp::ProtoFilter udpFilter(pcpp::UDP);
+	PTF_ASSERT_EQUAL(countMatchingPackets(udpFilter, igmpPackets), 38, int);
+	pcpp::ProtoFilter igmpFilter(pcpp::IGMP);
+	PTF_ASSERT_EQUAL(countMatchingPackets(igmpFilter, igmpPackets), 6, int);
+
+
+	//-------------------------------------------------------
+	// Modifying a filter in a tree recompiles the program
+	//-------------------------------------------------------
+
+	PTF_ASSERT_TRUE(program.compile(andFilter));
+	PTF_ASSERT_TRUE(program.isUpToDate());
+	ipFilter2.setLen(8);
+	PTF_ASSERT_FALSE(program.isUpToDate());
+
+	int expectedCount = 0;
+	for (pcpp::RawPacketVector::VectorIterator iter = examplePackets.begin(); iter != examplePackets.end(); iter++)
+	{
+		pcpp::Packet packet(*iter);
+		pcpp::IPv4Layer* ipv4Layer = packet.getLayerOfType<pcpp::IPv4Layer>();
+		if (ipv4Layer != NULL && packet.isPacketOfType(pcpp::UDP) && (ipv4Layer->getSrcIpAddress().toInt() & 0xff) == 10)
+			expectedCount++;
+	}
+
+	PTF_ASSERT_GREATER_THAN(expectedCount, 69, int);
+	PTF_ASSERT_EQUAL(countMatchingPackets(andFilter, examplePackets), expectedCount, int);
+	PTF_ASSERT_TRUE(program.compile(andFilter));
+	PTF_ASSERT_TRUE(program.isUpToDate());
+
+
+	//-----------------------------------------
+	// Filters which fall back to libpcap BPF
+	//-----------------------------------------
+
+	pcpp::VlanFilter vlanFilter(118);
+	PTF_ASSERT_FALSE(program.compile(vlanFilter));
+	PTF_ASSERT_FALSE(program.isCompiled());
+	pcpp::BPFStringFilter bpfStringFilter("udp");
+	PTF_ASSERT_FALSE(program.compile(bpfStringFilter));
+	pcpp::IPFilter ipv6Filter("2001:db8::1", pcpp::SRC);
+	PTF_ASSERT_FALSE(program.compile(ipv6Filter));
+	filterVec.clear();
+	filterVec.push_back(&udpFilter);
+	filterVec.push_back(&vlanFilter);
+	pcpp::OrFilter mixedFilter(filterVec);
+	PTF_ASSERT_FALSE(program.compile(mixedFilter));
+	PTF_ASSERT_FALSE(program.matchPacket(examplePackets.front()));
+
+
+	//------------
+	// Edge cases
+	//------------
+
+	// ports of UDP over IPv6
+	pcpp::Packet ipv6Packet(100);
+	pcpp::EthLayer ethLayer(pcpp::MacAddress("00:11:22:33:44:55"), pcpp::MacAddress("66:77:88:99:aa:bb"), PCPP_ETHERTYPE_IPV6);
+	pcpp::IPv6Layer ipv6Layer(pcpp::IPv6Address(std::string("2001:db8::1")), pcpp::IPv6Address(std::string("2001:db8::2")));
+	pcpp::UdpLayer udpLayer(12345, 53);
+	PTF_ASSERT_TRUE(ipv6Packet.addLayer(&ethLayer));
+	PTF_ASSERT_TRUE(ipv6Packet.addLayer(&ipv6Layer));
+	PTF_ASSERT_TRUE(ipv6Packet.addLayer(&udpLayer));
+	ipv6Packet.computeCalculateFields();
+
+	pcpp::PortFilter portFilter(53, pcpp::DST);
+	PTF_ASSERT_TRUE(portFilter.matchPacketWithFilter(ipv6Packet.getRawPacket()));
+	portFilter.setDirection(pcpp::SRC);
+	PTF_ASSERT_FALSE(portFilter.matchPacketWithFilter(ipv6Packet.getRawPacket()));
+	PTF_ASSERT_TRUE(udpFilter.matchPacketWithFilter(ipv6Packet.getRawPacket()));
+	pcpp::ProtoFilter icmpFilter(pcpp::ICMP);
+	PTF_ASSERT_FALSE(icmpFilter.matchPacketWithFilter(ipv6Packet.getRawPacket()));
+
+	// a field beyond the end of the packet fails the whole filter, even under a NotFilter
+	uint8_t truncatedData[20];
+	memcpy(truncatedData, ipv6Packet.getRawPacket()->getRawData(), sizeof(truncatedData));
+	pcpp::NotFilter notFilter(&portFilter);
+	PTF_ASSERT_TRUE(program.compile(notFilter));
+	PTF_ASSERT_FALSE(program.matchPacket(truncatedData, sizeof(truncatedData)));
+	PTF_ASSERT_TRUE(program.matchPacket(ipv6Packet.getRawPacket()));
+} // TestPcapFiltersNative
+
+
+
+
+// a raw packet class of a different size than RawPacket, like MBufRawPacket
+struct TaggedRawPacket : public pcpp::RawPacket
+{
+	uint64_t tag;
+
+	TaggedRawPacket(const pcpp::RawPacket& other) : pcpp::RawPacket(other), tag(0) {}
+};
+
+struct CompiledFilterThreadArgs
+{
+	const pcpp::CompiledFilter* filter;
+	pcpp::RawPacket** rawPackets;
+	size_t numOfPackets;
+	size_t numOfMatches;
+};
+
+static void* matchCompiledFilterThread(void* threadArgs)
+{
+	CompiledFilterThreadArgs* args = (CompiledFilterThreadArgs*)threadArgs;
+	bool* results = new bool[args->numOfPackets];
+	args->numOfMatches = 0;
+	for (int i = 0; i < 10; i++)
+		args->numOfMatches += args->filter->match(args->rawPackets, args->numOfPackets, results);
+	delete [] results;
+	return NULL;
+}
+
+PTF_TEST_CASE(TestCompiledFilter)
+{
+	pcpp::RawPacketVector examplePackets;
+	pcpp::PcapFileReaderDevice fileReaderDev(EXAMPLE_PCAP_PATH);
+	PTF_ASSERT_TRUE(fileReaderDev.open());
+	fileReaderDev.getNextPackets(examplePackets);
+	fileReaderDev.close();
+
+	std::vector<pcpp::RawPacket*> rawPackets(examplePackets.begin(), examplePackets.end());
+	bool* results = new bool[rawPackets.size()];
+
+	// a filter tree is compiled natively and later changes to the tree don't affect the compiled filter
+	pcpp::PortRangeFilter portRangeFilter(40000, 50000, pcpp::SRC);
+	pcpp::CompiledFilter compiledFilter(portRangeFilter);
+	PTF_ASSERT_TRUE(compiledFilter.isValid());
+	PTF_ASSERT_TRUE(compiledFilter.isNative());
+	PTF_ASSERT_EQUAL(compiledFilter.getFilterAsString(), "src portrange 40000-50000", string);
+	portRangeFilter.setFromPort(1);
+	PTF_ASSERT_EQUAL(compiledFilter.match(&rawPackets[0], rawPackets.size(), results), 1464, size);
+	for (size_t i = 0; i < rawPackets.size(); i++)
+	{
+		PTF_ASSERT_TRUE(results[i] == compiledFilter.match(rawPackets[i]));
+	}
+
+	// contiguous arrays of packets are indexed by their element type
+	std::vector<pcpp::RawPacket> packetArray;
+	std::vector<TaggedRawPacket> taggedPacketArray;
+	for (size_t i = 0; i < rawPackets.size(); i++)
+	{
+		packetArray.push_back(*rawPackets[i]);
+		taggedPacketArray.push_back(TaggedRawPacket(*rawPackets[i]));
+	}
+	bool* arrayResults = new bool[rawPackets.size()];
+	PTF_ASSERT_EQUAL(compiledFilter.match(&packetArray[0], packetArray.size(), arrayResults), 1464, size);
+	PTF_ASSERT_TRUE(std::equal(results, results + rawPackets.size(), arrayResults));
+	PTF_ASSERT_EQUAL(compiledFilter.match(&taggedPacketArray[0], taggedPacketArray.size(), arrayResults), 1464, size);
+	PTF_ASSERT_TRUE(std::equal(results, results + rawPackets.size(), arrayResults));
+	delete [] arrayResults;
+
+	// a single compiled filter is shared by several threads
+	const int numOfThreads = 4;
+	pthread_t threads[numOfThreads];
+	CompiledFilterThreadArgs threadArgs[numOfThreads];
+	for (int i = 0; i < numOfThreads; i++)
+	{
+		threadArgs[i].filter = &compiledFilter;
+		threadArgs[i].rawPackets = &rawPackets[0];
+		threadArgs[i].numOfPackets = rawPackets.size();
+		PTF_ASSERT_EQUAL(pthread_create(&threads[i], NULL, matchCompiledFilterThread, &threadArgs[i]), 0, int);
+	}
+	for (int i = 0; i < numOfThreads; i++)
+	{
+		pthread_join(threads[i], NULL);
+		PTF_ASSERT_EQUAL(threadArgs[i].numOfMatches, 14640, size);
+	}
+
+	// filters which can't be matched natively are compiled to BPF, invalid filters don't match anything
+	pcpp::VlanFilter vlanFilter(118);
+	pcpp::CompiledFilter vlanCompiledFilter(vlanFilter);
+	PTF_ASSERT_FALSE(vlanCompiledFilter.isNative());
+	pcpp::TcpFlagsFilter tcpFlagsFilter(pcpp::TcpFlagsFilter::tcpSyn, pcpp::TcpFlagsFilter::MatchAll);
+	pcpp::CompiledFilter nonEthernetCompiledFilter(tcpFlagsFilter, pcpp::LINKTYPE_LINUX_SLL);
+	PTF_ASSERT_FALSE(nonEthernetCompiledFilter.isNative());
+	pcpp::CompiledFilter invalidFilter("bla bla bla");
+	PTF_ASSERT_FALSE(invalidFilter.isValid());
+	PTF_ASSERT_EQUAL(invalidFilter.match(&rawPackets[0], rawPackets.size(), results), 0, size);
+	PTF_ASSERT_FALSE(results[0]);
+	PTF_ASSERT_FALSE(invalidFilter.match(NULL));
+
+	// as in libpcap, an empty filter matches all packets
+	pcpp::CompiledFilter emptyFilter("");
+	PTF_ASSERT_TRUE(emptyFilter.isValid());
+	PTF_ASSERT_EQUAL(emptyFilter.match(&rawPackets[0], rawPackets.size(), results), rawPackets.size(), size);
+
+	delete [] results;
+} // TestCompiledFilter
@@ -1,6 +1,7 @@
 #include "../TestDefinition.h"
 #include "../Common/TestUtils.h"
 #include "IPReassembly.h"
+#include "IPv4Layer.h"
 #include "IPv6Layer.h"
 #include "HttpLayer.h"
 #include "PcapFileDevice.h"
@@ -14,6 +15,22 @@ static void ipReassemblyOnFragmentsClean(const pcpp::IPReassembly::PacketKey* ke
 }
 
 
+static pcpp::RawPacket ipReassemblyChangeFragment(pcpp::RawPacket rawPacket, const pcpp::IPv4Address& srcIP, const pcpp::IPv4Address& dstIP, uint16_t ipID, time_t timestampSec)
+{
+	pcpp::Packet packet(&rawPacket, pcpp::IPv4);
+	pcpp::IPv4Layer* ipLayer = packet.getLayerOfType<pcpp::IPv4Layer>();
+	ipLayer->setSrcIpAddress(srcIP);
+	ipLayer->setDstIpAddress(dstIP);
+	ipLayer->getIPv4Header()->ipId = htobe16(ipID);
+
+	timespec timestamp;
+	timestamp.tv_sec = timestampSec;
+	timestamp.tv_nsec = 0;
+	rawPacket.setPacketTimeStamp(timestamp);
+	return rawPacket;
+}
+
+
 PTF_TEST_CASE(TestIPFragmentationSanity)
 {
 	std::vector<pcpp::RawPacket> packetStream;
@@ -1081,4 +1098,151 @@ PTF_TEST_CASE(TestIPFragRemove)
 
 	ipReassembly.processPacket(ip4Packet8Frags.at(0), status);
 	PTF_ASSERT_EQUAL(ipReassembly.getCurrentCapacity(), 6, size);
-} // TestIPFragRemove
\ No newline at end of file
+} // TestIPFragRemove
+
+
+
+
+PTF_TEST_CASE(TestIPFragHashCollision)
+{
+	std::vector<pcpp::RawPacket> packetStream;
+	std::string errMsg;
+
+	PTF_ASSERT_TRUE(readPcapIntoPacketVec("PcapExamples/frag_http_req.pcap", packetStream, errMsg));
+
+	// these 2 packet keys have the same hash value
+	pcpp::IPv4Address dstIP(std::string("10.118.213.211"));
+	pcpp::IPv4Address srcIP1(std::string("10.118.213.58"));
+	pcpp::IPv4Address srcIP2(std::string("10.118.213.127"));
+	pcpp::IPReassembly::IPv4PacketKey key1(0x4d32, srcIP1, dstIP);
+	pcpp::IPReassembly::IPv4PacketKey key2(0x8000, srcIP2, dstIP);
+	PTF_ASSERT_EQUAL(key1.getHashValue(), key2.getHashValue(), u32);
+
+	pcpp::IPReassembly ipReassembly;
+	pcpp::IPReassembly::ReassemblyStatus status;
+
+	// interleave the fragments of both packets
+	pcpp::Packet* result1 = NULL;
+	pcpp::Packet* result2 = NULL;
+	for (size_t i = 0; i < packetStream.size(); i++)
+	{
+		pcpp::RawPacket frag1 = ipReassemblyChangeFragment(packetStream.at(i), srcIP1, dstIP, 0x4d32, 0);
+		pcpp::RawPacket frag2 = ipReassemblyChangeFragment(packetStream.at(i), srcIP2, dstIP, 0x8000, 0);
+
+		result1 = ipReassembly.processPacket(&frag1, status);
+		PTF_ASSERT_EQUAL(status, (i == 0 ? pcpp::IPReassembly::FIRST_FRAGMENT : (i < packetStream.size() - 1 ? pcpp::IPReassembly::FRAGMENT : pcpp::IPReassembly::REASSEMBLED)), enum);
+		result2 = ipReassembly.processPacket(&frag2, status);
+		PTF_ASSERT_EQUAL(status, (i == 0 ? pcpp::IPReassembly::FIRST_FRAGMENT : (i < packetStream.size() - 1 ? pcpp::IPReassembly::FRAGMENT : pcpp::IPReassembly::REASSEMBLED)), enum);
+
+		if (i == 0)
+			PTF_ASSERT_EQUAL(ipReassembly.getCurrentCapacity(), 2, size);
+	}
+
+	PTF_ASSERT_EQUAL(ipReassembly.getCurrentCapacity(), 0, size);
+	PTF_ASSERT_NOT_NULL(result1);
+	PTF_ASSERT_NOT_NULL(result2);
+
+	// both packets were reassembled separately
+	int bufferLength = 0;
+	uint8_t* buffer = readFileIntoBuffer("PcapExamples/frag_http_req_reassembled.txt", bufferLength);
+	pcpp::IPv4Layer* ipLayer1 = result1->getLayerOfType<pcpp::IPv4Layer>();
+	pcpp::IPv4Layer* ipLayer2 = result2->getLayerOfType<pcpp::IPv4Layer>();
+	PTF_ASSERT_EQUAL(ipLayer1->getSrcIpAddress(), srcIP1, object);
+	PTF_ASSERT_EQUAL(ipLayer2->getSrcIpAddress(), srcIP2, object);
+	PTF_ASSERT_EQUAL(ipLayer1->getLayerPayloadSize(), ipLayer2->getLayerPayloadSize(), size);
+	PTF_ASSERT_EQUAL(result1->getRawPacket()->getRawDataLen(), bufferLength, int);
+	PTF_ASSERT_BUF_COMPARE(ipLayer1->getLayerPayload(), ipLayer2->getLayerPayload(), ipLayer1->getLayerPayloadSize());
+
+	delete result1;
+	delete result2;
+	delete [] buffer;
+} // TestIPFragHashCollision
+
+
+
+
+PTF_TEST_CASE(TestIPFragTimeoutAndMemoryLimit)
+{
+	std::vector<pcpp::RawPacket> packetStream;
+	std::string errMsg;
+
+	PTF_ASSERT_TRUE(readPcapIntoPacketVec("PcapExamples/frag_http_req.pcap", packetStream, errMsg));
+
+	pcpp::IPv4Address dstIP(std::string("10.0.0.2"));
+	pcpp::IPv4Address srcIP(std::string("10.0.0.1"));
+	pcpp::IPReassembly::ReassemblyStatus status;
+
+	// packet timeout
+	// ==============
+
+	pcpp::PointerVector<pcpp::IPReassembly::PacketKey> packetsRemoved;
+	pcpp::IPReassembly ipReassembly(ipReassemblyOnFragmentsClean, &packetsRemoved, 100, 0, 10);
+	PTF_ASSERT_EQUAL(ipReassembly.getPacketTimeout(), 10, u32);
+
+	pcpp::RawPacket frag = ipReassemblyChangeFragment(packetStream.at(0), srcIP, dstIP, 1, 1000);
+	ipReassembly.processPacket(&frag, status);
+	frag = ipReassemblyChangeFragment(packetStream.at(0), srcIP, dstIP, 2, 1005);
+	ipReassembly.processPacket(&frag, status);
+	frag = ipReassemblyChangeFragment(packetStream.at(1), srcIP, dstIP, 1, 1010);
+	ipReassembly.processPacket(&frag, status);
+	PTF_ASSERT_EQUAL(status, pcpp::IPReassembly::FRAGMENT, enum);
+	PTF_ASSERT_EQUAL(ipReassembly.getCurrentCapacity(), 2, size);
+	PTF_ASSERT_EQUAL(ipReassembly.getNumOfTimedOutPackets(), 0, u64);
+
+	// more than 10 seconds after the first packet was first seen, it times out before this fragment is processed
+	frag = ipReassemblyChangeFragment(packetStream.at(0), srcIP, dstIP, 3, 1011);
+	ipReassembly.processPacket(&frag, status);
+	PTF_ASSERT_EQUAL(ipReassembly.getCurrentCapacity(), 2, size);
+	PTF_ASSERT_EQUAL(ipReassembly.getNumOfTimedOutPackets(), 1, u64);
+	PTF_ASSERT_EQUAL(ipReassembly.getNumOfEvictedPackets(), 0, u64);
+	PTF_ASSERT_EQUAL(packetsRemoved.size(), 1, size);
+	pcpp::IPReassembly::IPv4PacketKey* ip4Key = dynamic_cast<pcpp::IPReassembly::IPv4PacketKey*>(packetsRemoved.front());
+	PTF_ASSERT_NOT_NULL(ip4Key);
+	PTF_ASSERT_EQUAL(ip4Key->getIpID(), 1, u16);
+
+	// an older timestamp doesn't move the clock backwards, and the next fragment of the timed out packet starts a new packet
+	frag = ipReassemblyChangeFragment(packetStream.at(2), srcIP, dstIP, 1, 900);
+	ipReassembly.processPacket(&frag, status);
+	PTF_ASSERT_EQUAL(ipReassembly.getCurrentCapacity(), 3, size);
+	PTF_ASSERT_EQUAL(ipReassembly.getNumOfTimedOutPackets(), 1, u64);
+
+	// all packets time out
+	frag = ipReassemblyChangeFragment(packetStream.at(0), srcIP, dstIP, 4, 2000);
+	ipReassembly.processPacket(&frag, status);
+	PTF_ASSERT_EQUAL(ipReassembly.getCurrentCapacity(), 1, size);
+	PTF_ASSERT_EQUAL(ipReassembly.getNumOfTimedOutPackets(), 4, u64);
+	PTF_ASSERT_EQUAL(packetsRemoved.size(), 4, size);
+
+	// memory limit
+	// ============
+
+	size_t firstFragSize = packetStream.at(0).getRawDataLen();
+	size_t secondFragSize = packetStream.at(1).getRawDataLen() - (packetStream.at(0).getRawDataLen() - pcpp::Packet(&packetStream.at(0)).getLayerOfType<pcpp::IPv4Layer>()->getLayerPayloadSize());
+	pcpp::IPReassembly ipReassembly2(NULL, NULL, 100, 2 * firstFragSize);
+	PTF_ASSERT_EQUAL(ipReassembly2.getMaxMemory(), 2 * firstFragSize, size);
+
+	frag = ipReassemblyChangeFragment(packetStream.at(0), srcIP, dstIP, 1, 0);
+	ipReassembly2.processPacket(&frag, status);
+	frag = ipReassemblyChangeFragment(packetStream.at(0), srcIP, dstIP, 2, 0);
+	ipReassembly2.processPacket(&frag, status);
+	PTF_ASSERT_EQUAL(ipReassembly2.getCurrentCapacity(), 2, size);
+	PTF_ASSERT_EQUAL(ipReassembly2.getCurrentMemoryUsage(), 2 * firstFragSize, size);
+
+	// adding data to the first packet makes it the most recently used one, so the second packet is dropped
+	frag = ipReassemblyChangeFragment(packetStream.at(1), srcIP, dstIP, 1, 0);
+	ipReassembly2.processPacket(&frag, status);
+	PTF_ASSERT_EQUAL(status, pcpp::IPReassembly::FRAGMENT, enum);
+	PTF_ASSERT_EQUAL(ipReassembly2.getCurrentCapacity(), 1, size);
+	PTF_ASSERT_EQUAL(ipReassembly2.getCurrentMemoryUsage(), firstFragSize + secondFragSize, size);
+	PTF_ASSERT_EQUAL(ipReassembly2.getNumOfEvictedPackets(), 1, u64);
+	PTF_ASSERT_EQUAL(ipReassembly2.getNumOfTimedOutPackets(), 0, u64);
+
+	// a packet that exceeds the limit by itself is dropped too
+	pcpp::IPReassembly ipReassembly3(NULL, NULL, 100, firstFragSize - 1);
+	frag = ipReassemblyChangeFragment(packetStream.at(0), srcIP, dstIP, 1, 0);
+	ipReassembly3.processPacket(&frag, status);
+	PTF_ASSERT_EQUAL(status, pcpp::IPReassembly::FIRST_FRAGMENT, enum);
+	PTF_ASSERT_EQUAL(ipReassembly3.getCurrentCapacity(), 0, size);
+	PTF_ASSERT_EQUAL(ipReassembly3.getCurrentMemoryUsage(), 0, size);
+	PTF_ASSERT_EQUAL(ipReassembly3.getNumOfEvictedPackets(), 1, u64);
+} // TestIPFragTimeoutAndMemoryLimit
@@ -3,6 +3,7 @@
 #include "../Common/GlobalTestArgs.h"
 #include <sstream>
 #include <algorithm>
+#include <string.h>
 #include "EndianPortable.h"
 #include "Logger.h"
 #include "GeneralUtils.h"
@@ -12,6 +13,9 @@
 #include "NetworkUtils.h"
 #include "PcapLiveDeviceList.h"
 #include "SystemUtils.h"
+#if !defined(WIN32) && !defined(WINx64)
+#include <unistd.h>
+#endif
 
 
 extern PcapTestArgs PcapTestGlobalArgs;
@@ -150,6 +154,70 @@ PTF_TEST_CASE(TestLRUList)
 	lruList.eraseElement(2);
 	lruList.eraseElement(3);
 	PTF_ASSERT_EQUAL(lruList.getSize(), 0, size);
+
+	// touch an element to make it the most recently used one
+	pcpp::LRUList<uint32_t> lruList2(3);
+	PTF_ASSERT_EQUAL(lruList2.put(10), 0, int);
+	PTF_ASSERT_EQUAL(lruList2.put(20), 0, int);
+	PTF_ASSERT_EQUAL(lruList2.put(30), 0, int);
+	PTF_ASSERT_EQUAL(lruList2.getMRUElement(), 30, u32);
+	PTF_ASSERT_EQUAL(lruList2.getLRUElement(), 10, u32);
+	PTF_ASSERT_TRUE(lruList2.touch(10));
+	PTF_ASSERT_FALSE(lruList2.touch(40));
+	PTF_ASSERT_EQUAL(lruList2.getMRUElement(), 10, u32);
+	PTF_ASSERT_EQUAL(lruList2.getLRUElement(), 20, u32);
+	PTF_ASSERT_TRUE(lruList2.contains(20));
+	PTF_ASSERT_FALSE(lruList2.contains(40));
+	PTF_ASSERT_EQUAL(lruList2.getLRUElement(), 20, u32);
+
+	PTF_ASSERT_EQUAL(lruList2.put(40, &deletedValue), 1, int);
+	PTF_ASSERT_EQUAL(deletedValue, 20, u32);
+	PTF_ASSERT_EQUAL(lruList2.put(10, &deletedValue), 0, int);
+	PTF_ASSERT_EQUAL(lruList2.put(50, &deletedValue), 1, int);
+	PTF_ASSERT_EQUAL(deletedValue, 30, u32);
+	PTF_ASSERT_EQUAL(lruList2.getSize(), 3, size);
+
+	// erased elements free room for new ones
+	lruList2.eraseElement(40);
+	PTF_ASSERT_FALSE(lruList2.contains(40));
+	PTF_ASSERT_EQUAL(lruList2.put(60, &deletedValue), 0, int);
+	PTF_ASSERT_EQUAL(lruList2.getLRUElement(), 10, u32);
+	PTF_ASSERT_EQUAL(lruList2.getMRUElement(), 60, u32);
+
+	// many elements colliding in the same hash chains
+	pcpp::LRUList<uint32_t> lruList3(100);
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		int result = lruList3.put(i * 1024, &deletedValue);
+		PTF_ASSERT_EQUAL(result, (i < 100 ? 0 : 1), int);
+		if (i >= 100)
+			PTF_ASSERT_EQUAL(deletedValue, (i - 100) * 1024, u32);
+	}
+	PTF_ASSERT_EQUAL(lruList3.getSize(), 100, size);
+	PTF_ASSERT_TRUE(lruList3.contains(999 * 1024));
+	PTF_ASSERT_FALSE(lruList3.contains(899 * 1024));
+
+	// string elements
+	pcpp::LRUList<std::string> lruList4(1);
+	std::string deletedString;
+	PTF_ASSERT_EQUAL(lruList4.put("a"), 0, int);
+	PTF_ASSERT_EQUAL(lruList4.put("b", &deletedString), 1, int);
+	PTF_ASSERT_EQUAL(deletedString, "a", string);
+
+	// pair elements are hashed member by member
+	pcpp::LRUList<std::pair<uint32_t, std::string> > lruList5(2);
+	std::pair<uint32_t, std::string> deletedPair;
+	PTF_ASSERT_EQUAL(lruList5.put(std::make_pair(1, std::string("a"))), 0, int);
+	PTF_ASSERT_EQUAL(lruList5.put(std::make_pair(1, std::string("b"))), 0, int);
+	PTF_ASSERT_TRUE(lruList5.contains(std::make_pair(1, std::string("a"))));
+	PTF_ASSERT_FALSE(lruList5.contains(std::make_pair(2, std::string("a"))));
+	PTF_ASSERT_EQUAL(lruList5.put(std::make_pair(2, std::string("a")), &deletedPair), 1, int);
+	PTF_ASSERT_EQUAL(deletedPair.first, 1, u32);
+	PTF_ASSERT_EQUAL(deletedPair.second, "a", string);
+
+	// the max size is limited by the 32-bit node indices
+	PTF_ASSERT_TRUE(pcpp::LRUList<uint32_t>::getMaxSupportedSize() <= 0xFFFFFFFF);
+	PTF_ASSERT_GREATER_THAN(pcpp::LRUList<uint32_t>::getMaxSupportedSize(), 0x3FFFFFFE, size);
 } // TestLRUList
 
 
@@ -182,6 +250,168 @@ PTF_TEST_CASE(TestGeneralUtils)
 
 
 
+PTF_TEST_CASE(TestSystemCoreUtils)
+{
+	pcpp::CoreSet coreSet;
+	PTF_ASSERT_TRUE(coreSet.isEmpty());
+	PTF_ASSERT_EQUAL(coreSet.getFirstCore(), -1, int);
+	PTF_ASSERT_TRUE(coreSet.addCore(0));
+	PTF_ASSERT_TRUE(coreSet.addCore(3));
+	PTF_ASSERT_TRUE(coreSet.addCore(40));
+	PTF_ASSERT_TRUE(coreSet.addCore(MAX_NUM_OF_CORES_IN_CORE_SET - 1));
+	pcpp::LoggerPP::getInstance().supressErrors();
+	PTF_ASSERT_FALSE(coreSet.addCore(MAX_NUM_OF_CORES_IN_CORE_SET));
+	PTF_ASSERT_FALSE(coreSet.addCore(-1));
+	pcpp::LoggerPP::getInstance().enableErrors();
+	PTF_ASSERT_EQUAL(coreSet.getCoreCount(), 4, int);
+	PTF_ASSERT_TRUE(coreSet.containsCore(40));
+	PTF_ASSERT_FALSE(coreSet.containsCore(39));
+	PTF_ASSERT_FALSE(coreSet.containsCore(MAX_NUM_OF_CORES_IN_CORE_SET));
+
+	// iteration is in ascending order
+	PTF_ASSERT_EQUAL(coreSet.getFirstCore(), 0, int);
+	PTF_ASSERT_EQUAL(coreSet.getNextCore(0), 3, int);
+	PTF_ASSERT_EQUAL(coreSet.getNextCore(3), 40, int);
+	PTF_ASSERT_EQUAL(coreSet.getNextCore(40), MAX_NUM_OF_CORES_IN_CORE_SET - 1, int);
+	PTF_ASSERT_EQUAL(coreSet.getNextCore(MAX_NUM_OF_CORES_IN_CORE_SET - 1), -1, int);
+	std::vector<int> coreIds;
+	coreSet.getCoreIds(coreIds);
+	PTF_ASSERT_EQUAL(coreIds.size(), 4, size);
+	PTF_ASSERT_EQUAL(coreIds[2], 40, int);
+
+	// only cores 0-31 are represented in a core mask
+	PTF_ASSERT_EQUAL(coreSet.toCoreMask(), 0x9, u32);
+	coreSet.removeCore(MAX_NUM_OF_CORES_IN_CORE_SET - 1);
+	PTF_ASSERT_EQUAL(coreSet.getCoreCount(), 3, int);
+
+	// string conversion
+	PTF_ASSERT_EQUAL(coreSet.toString(), "0,3,40", string);
+	pcpp::CoreSet parsedCoreSet;
+	PTF_ASSERT_TRUE(parsedCoreSet.fromString("0-3,8,10-11"));
+	PTF_ASSERT_EQUAL(parsedCoreSet.getCoreCount(), 7, int);
+	PTF_ASSERT_EQUAL(parsedCoreSet.toString(), "0-3,8,10-11", string);
+	PTF_ASSERT_TRUE(parsedCoreSet.fromString(" 1, 2 ,70-72"));
+	PTF_ASSERT_EQUAL(parsedCoreSet.toString(), "1-2,70-72", string);
+	pcpp::LoggerPP::getInstance().supressErrors();
+	PTF_ASSERT_FALSE(parsedCoreSet.fromString("3-1"));
+	PTF_ASSERT_TRUE(parsedCoreSet.isEmpty());
+	PTF_ASSERT_FALSE(parsedCoreSet.fromString("a"));
+	PTF_ASSERT_FALSE(parsedCoreSet.fromString("1,,2"));
+	PTF_ASSERT_FALSE(parsedCoreSet.fromString("2000"));
+	pcpp::LoggerPP::getInstance().enableErrors();
+	PTF_ASSERT_TRUE(parsedCoreSet.fromString(""));
+	PTF_ASSERT_TRUE(parsedCoreSet.isEmpty());
+
+	// core mask conversion and set operations
+	pcpp::CoreSet maskCoreSet = (pcpp::CoreMask)0x11;
+	PTF_ASSERT_EQUAL(maskCoreSet.toString(), "0,4", string);
+	std::vector<int> vecCoreIds;
+	vecCoreIds.push_back(4);
+	vecCoreIds.push_back(33);
+	pcpp::CoreSet vecCoreSet(vecCoreIds);
+	pcpp::CoreSet unionCoreSet = maskCoreSet;
+	unionCoreSet |= vecCoreSet;
+	PTF_ASSERT_EQUAL(unionCoreSet.toString(), "0,4,33", string);
+	unionCoreSet &= vecCoreSet;
+	PTF_ASSERT_TRUE(unionCoreSet == vecCoreSet);
+	PTF_ASSERT_TRUE(unionCoreSet != maskCoreSet);
+
+	// machine cores and NUMA nodes
+	pcpp::CoreSet allCores = pcpp::getCoreSetForAllMachineCores();
+	PTF_ASSERT_EQUAL(allCores.getCoreCount(), pcpp::getNumOfCores(), int);
+	PTF_ASSERT_TRUE(allCores.containsCore(0));
+	int numOfNumaNodes = pcpp::getNumOfNumaNodes();
+	PTF_ASSERT_GREATER_OR_EQUAL_THAN(numOfNumaNodes, 1, int);
+	PTF_ASSERT_GREATER_OR_EQUAL_THAN(pcpp::getNumaNodeOfCore(0), 0, int);
+	PTF_ASSERT_EQUAL(pcpp::getNumaNodeOfCore(-1), -1, int);
+	pcpp::CoreSet numaCores;
+	for (int node = 0; node < numOfNumaNodes; node++)
+		numaCores |= pcpp::getCoreSetForNumaNode(node);
+	PTF_ASSERT_TRUE(numaCores.containsCore(0));
+	PTF_ASSERT_TRUE(pcpp::getCoreSetForNumaNode(pcpp::getNumaNodeOfCore(0)).containsCore(0));
+
+	// SystemCore of a core above 31 has no mask bit
+	pcpp::SystemCore core40 = pcpp::getSystemCoreById(40);
+	PTF_ASSERT_EQUAL(core40.Id, 40, int);
+	PTF_ASSERT_EQUAL(core40.Mask, 0, u32);
+	PTF_ASSERT_EQUAL(pcpp::getSystemCoreById(5).Mask, 0x20, u32);
+} // TestSystemCoreUtils
+
+
+
+#if !defined(WIN32) && !defined(WINx64)
+#define ASYNC_LOG_TEST_MESSAGES_PER_THREAD 200
+
+static void* asyncLogTestThreadMain(void*)
+{
+	for (int i = 0; i < ASYNC_LOG_TEST_MESSAGES_PER_THREAD; i++)
+		LOG_ERROR("Async log test message #%d from worker thread", i);
+
+	return NULL;
+}
+#endif
+
+PTF_TEST_CASE(TestLoggerUtils)
+{
+	pcpp::LoggerPP& logger = pcpp::LoggerPP::getInstance();
+
+	// error rate limit
+	char errorString[128];
+	logger.setErrorString(errorString, sizeof(errorString));
+	logger.setErrorRateLimit(3);
+	PTF_ASSERT_EQUAL(logger.getErrorRateLimit(), 3, u32);
+	uint64_t rateLimitedErrorsBefore = logger.getNumOfRateLimitedErrors();
+	for (int i = 0; i < 10; i++)
+		LOG_ERROR("Rate limited error #%d", i);
+	logger.setErrorRateLimit(0);
+	logger.setErrorString(NULL, 0);
+	// if the second changed during the loop up to 6 errors are printed
+	PTF_ASSERT_GREATER_OR_EQUAL_THAN(logger.getNumOfRateLimitedErrors() - rateLimitedErrorsBefore, 4, u64);
+	PTF_ASSERT_LOWER_OR_EQUAL_THAN(logger.getNumOfRateLimitedErrors() - rateLimitedErrorsBefore, 7, u64);
+	PTF_ASSERT_TRUE(strncmp(errorString, "Rate limited error #", strlen("Rate limited error #")) == 0);
+
+#if !defined(WIN32) && !defined(WINx64)
+	// asynchronous logging from two threads, stderr is redirected to a temp file
+	FILE* logFile = tmpfile();
+	PTF_ASSERT_NOT_NULL(logFile);
+	fflush(stderr);
+	int origStderr = dup(STDERR_FILENO);
+	dup2(fileno(logFile), STDERR_FILENO);
+
+	bool asyncLogEnabled = logger.enableAsyncLogging(2 * ASYNC_LOG_TEST_MESSAGES_PER_THREAD);
+	bool isAsyncLogEnabled = logger.isAsyncLoggingEnabled();
+	pthread_t workerThread;
+	int threadErr = pthread_create(&workerThread, NULL, asyncLogTestThreadMain, NULL);
+	for (int i = 0; i < ASYNC_LOG_TEST_MESSAGES_PER_THREAD; i++)
+		LOG_ERROR("Async log test message #%d from main thread", i);
+	if (threadErr == 0)
+		pthread_join(workerThread, NULL);
+	logger.flushAsyncLog();
+	uint64_t droppedMessages = logger.getNumOfDroppedLogMessages();
+	logger.disableAsyncLogging();
+
+	fflush(stderr);
+	dup2(origStderr, STDERR_FILENO);
+	close(origStderr);
+
+	int numOfLines = 0;
+	char line[256];
+	rewind(logFile);
+	while (fgets(line, sizeof(line), logFile) != NULL)
+		numOfLines++;
+	fclose(logFile);
+
+	PTF_ASSERT_TRUE(asyncLogEnabled);
+	PTF_ASSERT_TRUE(isAsyncLogEnabled);
+	PTF_ASSERT_EQUAL(threadErr, 0, int);
+	PTF_ASSERT_FALSE(logger.isAsyncLoggingEnabled());
+	PTF_ASSERT_EQUAL(droppedMessages, 0, u64);
+	PTF_ASSERT_EQUAL(numOfLines, 2 * ASYNC_LOG_TEST_MESSAGES_PER_THREAD, int);
+#endif
+} // TestLoggerUtils
+
+
+
 PTF_TEST_CASE(TestGetMacAddress)
 {
 	pcpp::PcapLiveDevice* liveDev = NULL;
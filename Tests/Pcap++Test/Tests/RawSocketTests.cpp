@@ -29,6 +29,7 @@ PTF_TEST_CASE(TestRawSockets)
 		PTF_ASSERT_FALSE(rawSock.open());
 		PTF_ASSERT_EQUAL(rawSock.receivePacket(rawPacket, true, 10), pcpp::RawSocketDevice::RecvError, enum);
 		PTF_ASSERT_FALSE(rawSock.sendPacket(&rawPacket));
+		PTF_ASSERT_EQUAL(rawSock.receivePackets(&rawPacket, 1), -1, int);
 		pcpp::LoggerPP::getInstance().enableErrors();
 	}
 
@@ -67,6 +68,26 @@ PTF_TEST_CASE(TestRawSockets)
 		PTF_ASSERT_TRUE(parsedPacket.isPacketOfType(protocol));
 	}
 
+	// receive a batch of packets into an array
+	pcpp::RawPacket rawPacketArr[PCPP_RAW_SOCKET_MAX_BATCH_SIZE];
+	int numOfPackets = 0;
+	for (int i = 0; i < 10 && numOfPackets == 0; i++)
+	{
+		numOfPackets = rawSock.receivePackets(rawPacketArr, PCPP_RAW_SOCKET_MAX_BATCH_SIZE, true, 2);
+		PTF_ASSERT_GREATER_OR_EQUAL_THAN(numOfPackets, 0, int);
+	}
+
+	PTF_ASSERT_GREATER_THAN(numOfPackets, 0, int);
+	PTF_ASSERT_LOWER_OR_EQUAL_THAN(numOfPackets, PCPP_RAW_SOCKET_MAX_BATCH_SIZE, int);
+	for (int i = 0; i < numOfPackets; i++)
+	{
+		pcpp::Packet parsedPacket(&rawPacketArr[i]);
+		PTF_ASSERT_TRUE(parsedPacket.isPacketOfType(protocol));
+	}
+
+	// receive a batch in non-blocking mode
+	PTF_ASSERT_GREATER_OR_EQUAL_THAN(rawSock.receivePackets(rawPacketArr, PCPP_RAW_SOCKET_MAX_BATCH_SIZE, false), 0, int);
+
 	// receive with timeout
 	pcpp::RawSocketDevice::RecvPacketResult res = pcpp::RawSocketDevice::RecvSuccess;
 	for (int i = 0; i < 30; i++)
@@ -102,6 +123,7 @@ PTF_TEST_CASE(TestRawSockets)
 	pcpp::LoggerPP::getInstance().supressErrors();
 	PTF_ASSERT_EQUAL(rawSock.receivePacket(tempPacket, true, 2), pcpp::RawSocketDevice::RecvError, enum);
 	PTF_ASSERT_FALSE(rawSock.sendPacket(packetVec.at(0)));
+	PTF_ASSERT_EQUAL(rawSock.receivePackets(rawPacketArr, PCPP_RAW_SOCKET_MAX_BATCH_SIZE), -1, int);
 	pcpp::LoggerPP::getInstance().enableErrors();
 
 	PTF_ASSERT_TRUE(rawSock.open());
@@ -5,9 +5,12 @@
 #include <algorithm>
 #include "EndianPortable.h"
 #include "TcpReassembly.h"
+#include "EthLayer.h"
 #include "IPv4Layer.h"
 #include "TcpLayer.h"
 #include "PayloadLayer.h"
+#include "PayloadMatcher.h"
+#include "PacketUtils.h"
 #include "PcapFileDevice.h"
 #include "PlatformSpecificUtils.h"
 
@@ -146,6 +149,90 @@ static void tcpReassemblyConnectionEndCallback(const pcpp::ConnectionData& conne
 }
 
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// tcpReassemblyConnectionEndReasonCallback()
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+typedef std::map<uint32_t, pcpp::TcpReassembly::ConnectionEndReason> TcpReassemblyEndReasons;
+
+static void tcpReassemblyConnectionEndReasonCallback(const pcpp::ConnectionData& connectionData, pcpp::TcpReassembly::ConnectionEndReason reason, void* userCookie)
+{
+	TcpReassemblyEndReasons* endReasons = (TcpReassemblyEndReasons*)userCookie;
+	(*endReasons)[connectionData.flowKey] = reason;
+}
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// TcpReassemblyPayloadMatcherStats
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct TcpReassemblyPayloadMatcherStats
+{
+	pcpp::TcpStreamMatcher* streamMatcher;
+	int curSide;
+	int numOfMatches[2][3];
+
+	TcpReassemblyPayloadMatcherStats(pcpp::TcpStreamMatcher* matcher) : streamMatcher(matcher), curSide(0) { memset(numOfMatches, 0, sizeof(numOfMatches)); }
+};
+
+static bool tcpReassemblyPayloadMatcherOnMatch(int patternId, uint64_t endOffset, void* userCookie)
+{
+	TcpReassemblyPayloadMatcherStats* stats = (TcpReassemblyPayloadMatcherStats*)userCookie;
+	stats->numOfMatches[stats->curSide][patternId]++;
+	return true;
+}
+
+static void tcpReassemblyPayloadMatcherMsgReadyCallback(int sideIndex, const pcpp::TcpStreamData& tcpData, void* userCookie)
+{
+	TcpReassemblyPayloadMatcherStats* stats = (TcpReassemblyPayloadMatcherStats*)userCookie;
+	stats->curSide = sideIndex;
+	stats->streamMatcher->findMatches(sideIndex, tcpData, tcpReassemblyPayloadMatcherOnMatch, stats);
+}
+
+static void tcpReassemblyPayloadMatcherConnectionEndCallback(const pcpp::ConnectionData& connectionData, pcpp::TcpReassembly::ConnectionEndReason reason, void* userCookie)
+{
+	((TcpReassemblyPayloadMatcherStats*)userCookie)->streamMatcher->removeConnection(connectionData.flowKey);
+}
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// tcpReassemblySetPacketTimestamp()
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static pcpp::RawPacket tcpReassemblySetPacketTimestamp(pcpp::RawPacket rawPacket, time_t timestampSec)
+{
+	timespec timestamp;
+	timestamp.tv_sec = timestampSec;
+	timestamp.tv_nsec = 0;
+	rawPacket.setPacketTimeStamp(timestamp);
+	return rawPacket;
+}
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// tcpReassemblyCreatePacket()
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+static pcpp::RawPacket tcpReassemblyCreatePacket(uint16_t srcPort, uint16_t dstPort, uint32_t seq, const std::string& payload)
+{
+	pcpp::EthLayer ethLayer(pcpp::MacAddress("00:50:56:c0:00:08"), pcpp::MacAddress("00:0c:29:1a:2b:3c"));
+	pcpp::IPv4Layer ipLayer(pcpp::IPv4Address(std::string("172.16.133.132")), pcpp::IPv4Address(std::string("212.199.202.9")));
+	ipLayer.getIPv4Header()->timeToLive = 64;
+	pcpp::TcpLayer tcpLayer(srcPort, dstPort);
+	tcpLayer.getTcpHeader()->sequenceNumber = htobe32(seq);
+	tcpLayer.getTcpHeader()->ackFlag = 1;
+	pcpp::PayloadLayer payloadLayer((const uint8_t*)payload.c_str(), payload.length(), false);
+
+	pcpp::Packet packet(100);
+	packet.addLayer(&ethLayer);
+	packet.addLayer(&ipLayer);
+	packet.addLayer(&tcpLayer);
+	packet.addLayer(&payloadLayer);
+	packet.computeCalculateFields();
+	return *packet.getRawPacket();
+}
+
+
 // ~~~~~~~~~~~~~~~~~~~
 // tcpReassemblyTest()
 // ~~~~~~~~~~~~~~~~~~~
@@ -458,6 +545,58 @@ PTF_TEST_CASE(TestTcpReassemblyOutOfOrder)
 
 
 
+PTF_TEST_CASE(TestTcpReassemblyOutOfOrderLimits)
+{
+	std::string errMsg;
+	std::vector<pcpp::RawPacket> packetStream;
+
+	PTF_ASSERT_TRUE(readPcapIntoPacketVec("PcapExamples/one_tcp_stream.pcap", packetStream, errMsg));
+
+	// remove one packet so all packets after it in the same message are buffered as out-of-order
+	packetStream.erase(packetStream.begin() + 9);
+
+	// run once without limits, once with a per-connection limit and once with a global limit
+	pcpp::TcpReassemblyConfiguration configs[3];
+	configs[1].maxOutOfOrderBytesPerConnection = 3000;
+	configs[2].maxOutOfOrderBytes = 3000;
+
+	TcpReassemblyMultipleConnStats results[3];
+	size_t maxOutOfOrderBytes[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		pcpp::TcpReassembly tcpReassembly(tcpReassemblyMsgReadyCallback, &results[i], NULL, NULL, configs[i]);
+		maxOutOfOrderBytes[i] = 0;
+
+		for (std::vector<pcpp::RawPacket>::iterator iter = packetStream.begin(); iter != packetStream.end(); iter++)
+		{
+			pcpp::Packet packet(&(*iter));
+			tcpReassembly.reassemblePacket(packet);
+			if (tcpReassembly.getNumOfOutOfOrderBytes() > maxOutOfOrderBytes[i])
+				maxOutOfOrderBytes[i] = tcpReassembly.getNumOfOutOfOrderBytes();
+		}
+
+		tcpReassembly.closeAllConnections();
+		PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOutOfOrderBytes(), 0, size);
+	}
+
+	// without limits more than the limit is buffered, with limits the buffered data never exceeds them
+	PTF_ASSERT_GREATER_THAN(maxOutOfOrderBytes[0], 3000, size);
+	PTF_ASSERT_LOWER_OR_EQUAL_THAN(maxOutOfOrderBytes[1], 3000, size);
+	PTF_ASSERT_LOWER_OR_EQUAL_THAN(maxOutOfOrderBytes[2], 3000, size);
+
+	// flushing the out-of-order data early marks the same gap as missing data, so the reassembled data is the same
+	PTF_ASSERT_EQUAL(results[0].stats.size(), 1, size);
+	PTF_ASSERT_EQUAL(results[1].stats.size(), 1, size);
+	PTF_ASSERT_EQUAL(results[2].stats.size(), 1, size);
+	std::string reassembledData = results[0].stats.begin()->second.reassembledData;
+	PTF_ASSERT_TRUE(reassembledData.find("bytes missing]") != std::string::npos);
+	PTF_ASSERT_EQUAL(results[1].stats.begin()->second.reassembledData, reassembledData, string);
+	PTF_ASSERT_EQUAL(results[2].stats.begin()->second.reassembledData, reassembledData, string);
+} // TestTcpReassemblyOutOfOrderLimits
+
+
+
 PTF_TEST_CASE(TestTcpReassemblyWithFIN_RST)
 {
 	std::string errMsg;
@@ -947,6 +1086,49 @@ PTF_TEST_CASE(TestTcpReassemblyCleanup)
 
 
 
+PTF_TEST_CASE(TestTcpReassemblyCleanupPacketTimestamps)
+{
+	TcpReassemblyMultipleConnStats results;
+	std::string errMsg;
+
+	pcpp::TcpReassemblyConfiguration config(true, 2, 1, 0, 0, true);
+	pcpp::TcpReassembly tcpReassembly(tcpReassemblyMsgReadyCallback, &results, tcpReassemblyConnectionStartCallback, tcpReassemblyConnectionEndCallback, config);
+
+	std::vector<pcpp::RawPacket> packetStream;
+	PTF_ASSERT_TRUE(readPcapIntoPacketVec("PcapExamples/three_http_streams.pcap", packetStream, errMsg));
+
+	pcpp::RawPacket lastPacket = packetStream.back();
+	packetStream.pop_back();
+
+	for(std::vector<pcpp::RawPacket>::iterator iter = packetStream.begin(); iter != packetStream.end(); iter++)
+	{
+		pcpp::Packet packet(&(*iter));
+		tcpReassembly.reassemblePacket(packet);
+	}
+
+	PTF_ASSERT_EQUAL(tcpReassembly.getConnectionInformation().size(), 3, size);
+	PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOpenConnections(), 0, u32);
+
+	// all connections were closed in the same second, by packet time. One second later they're still within the delay
+	time_t closeTime = lastPacket.getPacketTimeStamp().tv_sec;
+	pcpp::RawPacket timedPacket = tcpReassemblySetPacketTimestamp(lastPacket, closeTime + 1);
+	tcpReassembly.reassemblePacket(&timedPacket);
+	PTF_ASSERT_EQUAL(tcpReassembly.getConnectionInformation().size(), 3, size);
+
+	// 3 seconds later by packet time (without waiting in real time) the automatic cleanup removes 1 item
+	timedPacket = tcpReassemblySetPacketTimestamp(lastPacket, closeTime + 3);
+	tcpReassembly.reassemblePacket(&timedPacket);
+	PTF_ASSERT_EQUAL(tcpReassembly.getConnectionInformation().size(), 2, size);
+
+	// an older packet doesn't move the clock backwards
+	timedPacket = tcpReassemblySetPacketTimestamp(lastPacket, closeTime);
+	tcpReassembly.reassemblePacket(&timedPacket);
+	PTF_ASSERT_EQUAL(tcpReassembly.purgeClosedConnections(0xFFFFFFFF), 2, u32);
+	PTF_ASSERT_EQUAL(tcpReassembly.getConnectionInformation().size(), 0, size);
+} // TestTcpReassemblyCleanupPacketTimestamps
+
+
+
 PTF_TEST_CASE(TestTcpReassemblyMaxSeq)
 {
 	std::string errMsg;
@@ -978,4 +1160,234 @@ PTF_TEST_CASE(TestTcpReassemblyMaxSeq)
 
 	std::string expectedReassemblyData = readFileIntoString(std::string("PcapExamples/one_tcp_stream_output.txt"));
 	PTF_ASSERT_EQUAL(expectedReassemblyData, stats.begin()->second.reassembledData, string);
-} //TestTcpReassemblyMaxSeq
\ No newline at end of file
+} //TestTcpReassemblyMaxSeq
+
+
+
+PTF_TEST_CASE(TestTcpReassemblyIdleTimeout)
+{
+	std::string errMsg;
+	std::vector<pcpp::RawPacket> packetStream;
+	PTF_ASSERT_TRUE(readPcapIntoPacketVec("PcapExamples/three_http_streams.pcap", packetStream, errMsg));
+
+	TcpReassemblyEndReasons endReasons;
+	pcpp::TcpReassemblyConfiguration config(true, 5, 30, 10);
+	pcpp::TcpReassembly tcpReassembly(NULL, &endReasons, NULL, tcpReassemblyConnectionEndReasonCallback, config);
+
+	// feed all packets except FIN packets so none of the connections ends naturally
+	for (std::vector<pcpp::RawPacket>::iterator iter = packetStream.begin(); iter != packetStream.end(); iter++)
+	{
+		pcpp::Packet packet(&(*iter));
+		if (packet.getLayerOfType<pcpp::TcpLayer>()->getTcpHeader()->finFlag == 0)
+			tcpReassembly.reassemblePacket(packet);
+	}
+
+	PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOpenConnections(), 3, u32);
+
+	// all packets in the file are in the same second. Packet #5 is data of the first connection, packet #8 is data of the second one
+	time_t baseTime = packetStream.at(0).getPacketTimeStamp().tv_sec;
+	pcpp::Packet firstConnPacket(&packetStream.at(5));
+	pcpp::Packet secondConnPacket(&packetStream.at(8));
+	uint32_t firstConnFlowKey = pcpp::hash5Tuple(&firstConnPacket);
+	uint32_t secondConnFlowKey = pcpp::hash5Tuple(&secondConnPacket);
+
+	// the first connection is active 6 seconds later so it's not idle, and no connection reached the timeout yet
+	pcpp::RawPacket keepAlivePacket = tcpReassemblySetPacketTimestamp(packetStream.at(5), baseTime + 6);
+	PTF_ASSERT_EQUAL(tcpReassembly.reassemblePacket(&keepAlivePacket), pcpp::TcpReassembly::Ignore_Retransimission, enum);
+	PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOpenConnections(), 3, u32);
+	PTF_ASSERT_EQUAL(endReasons.size(), 0, size);
+
+	// 12 seconds later the other 2 connections are idle for more than 10 seconds
+	keepAlivePacket = tcpReassemblySetPacketTimestamp(packetStream.at(5), baseTime + 12);
+	PTF_ASSERT_EQUAL(tcpReassembly.reassemblePacket(&keepAlivePacket), pcpp::TcpReassembly::Ignore_Retransimission, enum);
+	PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOpenConnections(), 1, u32);
+	PTF_ASSERT_EQUAL(endReasons.size(), 2, size);
+	PTF_ASSERT_TRUE(endReasons.find(firstConnFlowKey) == endReasons.end());
+	for (TcpReassemblyEndReasons::iterator iter = endReasons.begin(); iter != endReasons.end(); iter++)
+	{
+		PTF_ASSERT_EQUAL(iter->second, pcpp::TcpReassembly::TcpReassemblyConnectionClosedByIdleTimeout, enum);
+	}
+
+	// the first connection is closed before a late packet of the second connection is processed, and the second connection is already closed
+	pcpp::RawPacket latePacket = tcpReassemblySetPacketTimestamp(packetStream.at(8), baseTime + 30);
+	PTF_ASSERT_EQUAL(tcpReassembly.reassemblePacket(&latePacket), pcpp::TcpReassembly::Ignore_PacketOfClosedFlow, enum);
+	PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOpenConnections(), 0, u32);
+	PTF_ASSERT_EQUAL(endReasons.size(), 3, size);
+	PTF_ASSERT_EQUAL(endReasons[firstConnFlowKey], pcpp::TcpReassembly::TcpReassemblyConnectionClosedByIdleTimeout, enum);
+
+	pcpp::ConnectionData secondConnData;
+	secondConnData.flowKey = secondConnFlowKey;
+	PTF_ASSERT_EQUAL(tcpReassembly.isConnectionOpen(secondConnData), 0, int);
+} // TestTcpReassemblyIdleTimeout
+
+
+
+PTF_TEST_CASE(TestTcpReassemblyMaxConnections)
+{
+	std::string errMsg;
+	std::vector<pcpp::RawPacket> packetStream;
+	PTF_ASSERT_TRUE(readPcapIntoPacketVec("PcapExamples/three_http_streams.pcap", packetStream, errMsg));
+
+	TcpReassemblyEndReasons endReasons;
+	pcpp::TcpReassemblyConfiguration config(true, 5, 30, 0, 2);
+	pcpp::TcpReassembly tcpReassembly(NULL, &endReasons, NULL, tcpReassemblyConnectionEndReasonCallback, config);
+
+	// packets #0, #1 and #2 are the SYN packets of the 3 connections, packet #6 is the SYN/ACK of the second connection.
+	// Re-time them so each connection is active in a different second
+	time_t baseTime = packetStream.at(0).getPacketTimeStamp().tv_sec;
+	pcpp::RawPacket firstConnSyn = tcpReassemblySetPacketTimestamp(packetStream.at(0), baseTime);
+	pcpp::RawPacket secondConnSyn = tcpReassemblySetPacketTimestamp(packetStream.at(1), baseTime + 1);
+	pcpp::RawPacket thirdConnSyn = tcpReassemblySetPacketTimestamp(packetStream.at(2), baseTime + 2);
+	pcpp::RawPacket secondConnSynAck = tcpReassemblySetPacketTimestamp(packetStream.at(6), baseTime + 3);
+
+	// a 4th connection which is the first connection with a different client port
+	pcpp::RawPacket fourthConnSyn = tcpReassemblySetPacketTimestamp(packetStream.at(0), baseTime + 4);
+	pcpp::Packet fourthConnPacket(&fourthConnSyn);
+	fourthConnPacket.getLayerOfType<pcpp::TcpLayer>()->getTcpHeader()->portSrc = htobe16(12345);
+
+	pcpp::Packet firstConnPacket(&firstConnSyn);
+	pcpp::Packet secondConnPacket(&secondConnSyn);
+	pcpp::Packet thirdConnPacket(&thirdConnSyn);
+	pcpp::ConnectionData firstConnData, secondConnData, thirdConnData, fourthConnData;
+	firstConnData.flowKey = pcpp::hash5Tuple(&firstConnPacket);
+	secondConnData.flowKey = pcpp::hash5Tuple(&secondConnPacket);
+	thirdConnData.flowKey = pcpp::hash5Tuple(&thirdConnPacket);
+	fourthConnData.flowKey = pcpp::hash5Tuple(&fourthConnPacket);
+
+	tcpReassembly.reassemblePacket(&firstConnSyn);
+	tcpReassembly.reassemblePacket(&secondConnSyn);
+	PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOpenConnections(), 2, u32);
+	PTF_ASSERT_EQUAL(endReasons.size(), 0, size);
+
+	// the 3rd connection makes room for itself by closing the idlest connection, which is the first one
+	tcpReassembly.reassemblePacket(&thirdConnSyn);
+	PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOpenConnections(), 2, u32);
+	PTF_ASSERT_EQUAL(endReasons.size(), 1, size);
+	PTF_ASSERT_EQUAL(endReasons[firstConnData.flowKey], pcpp::TcpReassembly::TcpReassemblyConnectionClosedByMaxConnections, enum);
+	PTF_ASSERT_EQUAL(tcpReassembly.isConnectionOpen(firstConnData), 0, int);
+
+	// the second connection is now more recently active than the third one, so the 4th connection closes the third one
+	tcpReassembly.reassemblePacket(&secondConnSynAck);
+	tcpReassembly.reassemblePacket(&fourthConnSyn);
+	PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOpenConnections(), 2, u32);
+	PTF_ASSERT_EQUAL(endReasons.size(), 2, size);
+	PTF_ASSERT_EQUAL(endReasons[thirdConnData.flowKey], pcpp::TcpReassembly::TcpReassemblyConnectionClosedByMaxConnections, enum);
+	PTF_ASSERT_GREATER_THAN(tcpReassembly.isConnectionOpen(secondConnData), 0, int);
+	PTF_ASSERT_EQUAL(tcpReassembly.isConnectionOpen(thirdConnData), 0, int);
+	PTF_ASSERT_GREATER_THAN(tcpReassembly.isConnectionOpen(fourthConnData), 0, int);
+
+	tcpReassembly.closeAllConnections();
+	PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOpenConnections(), 0, u32);
+	PTF_ASSERT_EQUAL(endReasons[secondConnData.flowKey], pcpp::TcpReassembly::TcpReassemblyConnectionClosedManually, enum);
+	PTF_ASSERT_EQUAL(endReasons[fourthConnData.flowKey], pcpp::TcpReassembly::TcpReassemblyConnectionClosedManually, enum);
+} // TestTcpReassemblyMaxConnections
+
+
+
+PTF_TEST_CASE(TestTcpReassemblyHashCollision)
+{
+	// these 2 connections between the same hosts have the same hash5Tuple() value
+	pcpp::RawPacket firstConnPacket = tcpReassemblyCreatePacket(8981, 80, 1000, "first connection");
+	pcpp::RawPacket secondConnPacket = tcpReassemblyCreatePacket(37781, 84, 5000, "second connection");
+	pcpp::RawPacket firstConnNextPacket = tcpReassemblyCreatePacket(8981, 80, 1016, " continues");
+	pcpp::Packet firstConnParsed(&firstConnPacket);
+	pcpp::Packet secondConnParsed(&secondConnPacket);
+	uint32_t flowHash = pcpp::hash5Tuple(&firstConnParsed);
+	PTF_ASSERT_EQUAL(pcpp::hash5Tuple(&secondConnParsed), flowHash, u32);
+
+	TcpReassemblyMultipleConnStats results;
+	pcpp::TcpReassembly tcpReassembly(tcpReassemblyMsgReadyCallback, &results, tcpReassemblyConnectionStartCallback, tcpReassemblyConnectionEndCallback);
+	PTF_ASSERT_EQUAL(tcpReassembly.reassemblePacket(&firstConnPacket), pcpp::TcpReassembly::TcpMessageHandled, enum);
+	PTF_ASSERT_EQUAL(tcpReassembly.reassemblePacket(&secondConnPacket), pcpp::TcpReassembly::TcpMessageHandled, enum);
+	PTF_ASSERT_EQUAL(tcpReassembly.reassemblePacket(&firstConnNextPacket), pcpp::TcpReassembly::TcpMessageHandled, enum);
+
+	// the connections aren't mixed: each one gets its own flow key and its own data
+	PTF_ASSERT_EQUAL(tcpReassembly.getNumOfOpenConnections(), 2, u32);
+	PTF_ASSERT_EQUAL(results.flowKeysList.size(), 2, size);
+	uint32_t firstConnFlowKey = results.flowKeysList[0];
+	uint32_t secondConnFlowKey = results.flowKeysList[1];
+	PTF_ASSERT_EQUAL(firstConnFlowKey, flowHash, u32);
+	PTF_ASSERT_NOT_EQUAL(secondConnFlowKey, flowHash, u32);
+	PTF_ASSERT_EQUAL(results.stats[firstConnFlowKey].connData.srcPort, 8981, u16);
+	PTF_ASSERT_EQUAL(results.stats[firstConnFlowKey].reassembledData, "first connection continues", string);
+	PTF_ASSERT_EQUAL(results.stats[secondConnFlowKey].connData.srcPort, 37781, u16);
+	PTF_ASSERT_EQUAL(results.stats[secondConnFlowKey].reassembledData, "second connection", string);
+
+	// closing one connection by its flow key leaves the other one open
+	tcpReassembly.closeConnection(secondConnFlowKey);
+	PTF_ASSERT_TRUE(results.stats[secondConnFlowKey].connectionsEndedManually);
+	PTF_ASSERT_FALSE(results.stats[firstConnFlowKey].connectionsEndedManually);
+	PTF_ASSERT_EQUAL(tcpReassembly.isConnectionOpen(results.stats[secondConnFlowKey].connData), 0, int);
+	PTF_ASSERT_GREATER_THAN(tcpReassembly.isConnectionOpen(results.stats[firstConnFlowKey].connData), 0, int);
+	PTF_ASSERT_EQUAL(tcpReassembly.reassemblePacket(&secondConnPacket), pcpp::TcpReassembly::Ignore_PacketOfClosedFlow, enum);
+	PTF_ASSERT_EQUAL(tcpReassembly.getConnectionInformation().size(), 2, size);
+} // TestTcpReassemblyHashCollision
+
+
+
+PTF_TEST_CASE(TestTcpReassemblyPayloadMatcher)
+{
+	std::string errMsg;
+	std::vector<pcpp::RawPacket> packetStream;
+	PTF_ASSERT_TRUE(readPcapIntoPacketVec("PcapExamples/one_tcp_stream.pcap", packetStream, errMsg));
+
+	// "a lot more user" appears once in a single segment sent by the client and once split between 2 segments sent by the server.
+	// "igmpv1%2c+igmpv2" appears once, split between 2 segments sent by the server
+	pcpp::PayloadMatcher matcher;
+	PTF_ASSERT_EQUAL(matcher.addPattern("a lot more user"), 0, int);
+	PTF_ASSERT_EQUAL(matcher.addPattern("igmpv1%2c+igmpv2"), 1, int);
+	PTF_ASSERT_EQUAL(matcher.addPattern("HTTP/1.1"), 2, int);
+	PTF_ASSERT_TRUE(matcher.compile());
+
+	// matching each packet separately misses the occurrences which are split between segments
+	size_t numOfPacketMatches = 0;
+	for (std::vector<pcpp::RawPacket>::iterator iter = packetStream.begin(); iter != packetStream.end(); iter++)
+	{
+		pcpp::Packet packet(&(*iter), pcpp::TCP);
+		numOfPacketMatches += matcher.findMatches(packet);
+	}
+	PTF_ASSERT_EQUAL(numOfPacketMatches, 5, size);
+
+	// matching the reassembled streams finds them
+	pcpp::TcpStreamMatcher streamMatcher(matcher);
+	TcpReassemblyPayloadMatcherStats stats(&streamMatcher);
+	pcpp::TcpReassembly tcpReassembly(tcpReassemblyPayloadMatcherMsgReadyCallback, &stats, NULL, tcpReassemblyPayloadMatcherConnectionEndCallback);
+	for (std::vector<pcpp::RawPacket>::iterator iter = packetStream.begin(); iter != packetStream.end(); iter++)
+		tcpReassembly.reassemblePacket(&(*iter));
+
+	PTF_ASSERT_EQUAL(streamMatcher.getNumOfConnections(), 1, size);
+	PTF_ASSERT_EQUAL(stats.numOfMatches[0][0], 1, int);
+	PTF_ASSERT_EQUAL(stats.numOfMatches[0][1], 0, int);
+	PTF_ASSERT_EQUAL(stats.numOfMatches[0][2], 2, int);
+	PTF_ASSERT_EQUAL(stats.numOfMatches[1][0], 1, int);
+	PTF_ASSERT_EQUAL(stats.numOfMatches[1][1], 1, int);
+	PTF_ASSERT_EQUAL(stats.numOfMatches[1][2], 2, int);
+
+	tcpReassembly.closeAllConnections();
+	PTF_ASSERT_EQUAL(streamMatcher.getNumOfConnections(), 0, size);
+
+	// the "[X bytes missing]" text added for missing data isn't matched
+	std::vector<pcpp::RawPacket> missingDataStream;
+	PTF_ASSERT_TRUE(readPcapIntoPacketVec("PcapExamples/one_tcp_stream.pcap", missingDataStream, errMsg));
+	missingDataStream.erase(missingDataStream.begin() + 9);
+
+	pcpp::PayloadMatcher missingTextMatcher;
+	PTF_ASSERT_EQUAL(missingTextMatcher.addPattern("bytes missing]"), 0, int);
+	PTF_ASSERT_TRUE(missingTextMatcher.compile());
+	pcpp::TcpStreamMatcher missingTextStreamMatcher(missingTextMatcher);
+	TcpReassemblyPayloadMatcherStats missingTextStats(&missingTextStreamMatcher);
+	TcpReassemblyMultipleConnStats missingDataResults;
+	pcpp::TcpReassembly missingTextReassembly(tcpReassemblyPayloadMatcherMsgReadyCallback, &missingTextStats, NULL, tcpReassemblyPayloadMatcherConnectionEndCallback);
+	pcpp::TcpReassembly missingDataReassembly(tcpReassemblyMsgReadyCallback, &missingDataResults);
+	for (std::vector<pcpp::RawPacket>::iterator iter = missingDataStream.begin(); iter != missingDataStream.end(); iter++)
+	{
+		missingTextReassembly.reassemblePacket(&(*iter));
+		missingDataReassembly.reassemblePacket(&(*iter));
+	}
+	missingTextReassembly.closeAllConnections();
+	missingDataReassembly.closeAllConnections();
+
+	PTF_ASSERT_TRUE(missingDataResults.stats.begin()->second.reassembledData.find("bytes missing]") != std::string::npos);
+	PTF_ASSERT_EQUAL(missingTextStats.numOfMatches[0][0], 0, int);
+	PTF_ASSERT_EQUAL(missingTextStats.numOfMatches[1][0], 0, int);
+} // TestTcpReassemblyPayloadMatcher
\ No newline at end of file
@@ -199,12 +199,17 @@ int main(int argc, char* argv[])
 	PTF_RUN_TEST(TestMacAddress, "no_network;mac");
 	PTF_RUN_TEST(TestLRUList, "no_network");
 	PTF_RUN_TEST(TestGeneralUtils, "no_network");
+	PTF_RUN_TEST(TestSystemCoreUtils, "no_network;system_utils");
+	PTF_RUN_TEST(TestLoggerUtils, "no_network;logger");
 	PTF_RUN_TEST(TestGetMacAddress, "mac");
 
 	PTF_RUN_TEST(TestPcapFileReadWrite, "no_network;pcap");
 	PTF_RUN_TEST(TestPcapSllFileReadWrite, "no_network;pcap");
 	PTF_RUN_TEST(TestPcapRawIPFileReadWrite, "no_network;pcap");
 	PTF_RUN_TEST(TestPcapFileAppend, "no_network;pcap");
+	PTF_RUN_TEST(TestPcapFileReadZeroCopyAndBatch, "no_network;pcap");
+	PTF_RUN_TEST(TestMmapPcapFileRead, "no_network;pcap");
+	PTF_RUN_TEST(TestParallelPcapFileRead, "no_network;pcap;skip_mem_leak_check");
 	PTF_RUN_TEST(TestPcapNgFileReadWrite, "no_network;pcap;pcapng");
 	PTF_RUN_TEST(TestPcapNgFileReadWriteAdv, "no_network;pcap;pcapng");
 
@@ -223,6 +228,8 @@ int main(int argc, char* argv[])
 	PTF_RUN_TEST(TestPcapFiltersLive, "filters");
 	PTF_RUN_TEST(TestPcapFilters_General_BPFStr, "no_network;filters;skip_mem_leak_check");
 	PTF_RUN_TEST(TestPcapFiltersOffline, "no_network;filters");
+	PTF_RUN_TEST(TestPcapFiltersNative, "no_network;filters");
+	PTF_RUN_TEST(TestCompiledFilter, "no_network;filters");
 
 	PTF_RUN_TEST(TestHttpRequestParsing, "no_network;http");
 	PTF_RUN_TEST(TestHttpResponseParsing, "no_network;http");
@@ -251,6 +258,7 @@ int main(int argc, char* argv[])
 	PTF_RUN_TEST(TestTcpReassemblyRetran, "no_network;tcp_reassembly");
 	PTF_RUN_TEST(TestTcpReassemblyMissingData, "no_network;tcp_reassembly");
 	PTF_RUN_TEST(TestTcpReassemblyOutOfOrder, "no_network;tcp_reassembly");
+	PTF_RUN_TEST(TestTcpReassemblyOutOfOrderLimits, "no_network;tcp_reassembly");
 	PTF_RUN_TEST(TestTcpReassemblyWithFIN_RST, "no_network;tcp_reassembly");
 	PTF_RUN_TEST(TestTcpReassemblyMalformedPkts, "no_network;tcp_reassembly");
 	PTF_RUN_TEST(TestTcpReassemblyMultipleConns, "no_network;tcp_reassembly");
@@ -258,7 +266,12 @@ int main(int argc, char* argv[])
 	PTF_RUN_TEST(TestTcpReassemblyIPv6MultConns, "no_network;tcp_reassembly");
 	PTF_RUN_TEST(TestTcpReassemblyIPv6_OOO, "no_network;tcp_reassembly");
 	PTF_RUN_TEST(TestTcpReassemblyCleanup, "no_network;tcp_reassembly");
+	PTF_RUN_TEST(TestTcpReassemblyCleanupPacketTimestamps, "no_network;tcp_reassembly");
 	PTF_RUN_TEST(TestTcpReassemblyMaxSeq, "no_network;tcp_reassembly");
+	PTF_RUN_TEST(TestTcpReassemblyIdleTimeout, "no_network;tcp_reassembly");
+	PTF_RUN_TEST(TestTcpReassemblyMaxConnections, "no_network;tcp_reassembly");
+	PTF_RUN_TEST(TestTcpReassemblyHashCollision, "no_network;tcp_reassembly");
+	PTF_RUN_TEST(TestTcpReassemblyPayloadMatcher, "no_network;tcp_reassembly");
 
 	PTF_RUN_TEST(TestIPFragmentationSanity, "no_network;ip_frag");
 	PTF_RUN_TEST(TestIPFragOutOfOrder, "no_network;ip_frag");
@@ -266,9 +279,13 @@ int main(int argc, char* argv[])
 	PTF_RUN_TEST(TestIPFragMultipleFrags, "no_network;ip_frag");
 	PTF_RUN_TEST(TestIPFragMapOverflow, "no_network;ip_frag");
 	PTF_RUN_TEST(TestIPFragRemove, "no_network;ip_frag");
+	PTF_RUN_TEST(TestIPFragHashCollision, "no_network;ip_frag");
+	PTF_RUN_TEST(TestIPFragTimeoutAndMemoryLimit, "no_network;ip_frag");
 
 	PTF_RUN_TEST(TestRawSockets, "raw_sockets");
 
+	PTF_RUN_TEST(TestAfPacketDevice, "af_packet");
+
 	PTF_END_RUNNING_TESTS;
 }
 
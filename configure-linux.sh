@@ -16,7 +16,7 @@ function HELP {
    echo "  1) Without any switches. In this case the script will guide you through using wizards"
    echo "  2) With switches, as described below"
    echo ""
-   echo -e "Basic usage: $SCRIPT [-h] [--pf-ring] [--pf-ring-home] [--dpdk] [--dpdk-home] [--use-immediate-mode] [--set-direction-enabled] [--install-dir] [--libpcap-include-dir] [--libpcap-lib-dir] [--use-zstd]"\\n
+   echo -e "Basic usage: $SCRIPT [-h] [--pf-ring] [--pf-ring-home] [--dpdk] [--dpdk-home] [--use-immediate-mode] [--set-direction-enabled] [--install-dir] [--libpcap-include-dir] [--libpcap-lib-dir] [--use-zstd] [--disable-debug-log]"\\n
    echo "The following switches are recognized:"
    echo "--default                --Setup PcapPlusPlus for Linux without PF_RING or DPDK. In this case you must not set --pf-ring or --dpdk"
    echo ""
@@ -38,6 +38,9 @@ function HELP {
    echo "                           the lib file in the default lib paths"
    echo "--use-zstd               --Use Zstd for pcapng files compression/decompression. This parameter is optional"
    echo ""
+   echo "--disable-debug-log      --Remove debug log messages at compile time. LOG_DEBUG statements won't be compiled and debug"
+   echo "                           log level can't be enabled at runtime. This parameter is optional"
+   echo ""
    echo -e "-h|--help                --Displays this help message and exits. No further actions are performed"\\n
    echo -e "Examples:"
    echo -e "      $SCRIPT --default"
@@ -123,7 +126,7 @@ if [ $NUMARGS -eq 0 ]; then
 else
 
    # these are all the possible switches
-   OPTS=`getopt -o h --long default,pf-ring,pf-ring-home:,dpdk,dpdk-home:,help,use-immediate-mode,set-direction-enabled,install-dir:,libpcap-include-dir:,libpcap-lib-dir:,use-zstd -- "$@"`
+   OPTS=`getopt -o h --long default,pf-ring,pf-ring-home:,dpdk,dpdk-home:,help,use-immediate-mode,set-direction-enabled,install-dir:,libpcap-include-dir:,libpcap-lib-dir:,use-zstd,disable-debug-log -- "$@"`
 
    # if user put an illegal switch - print HELP and exit
    if [ $? -ne 0 ]; then
@@ -201,6 +204,11 @@ else
          USE_ZSTD=1
          shift ;;
 
+       # remove debug logs at compile time
+       --disable-debug-log)
+         DISABLE_DEBUG_LOG=1
+         shift ;;
+
        # help switch - display help and exit
        -h|--help)
          HELP
@@ -330,6 +338,10 @@ if [ -n "$USE_ZSTD" ]; then
    cat mk/PcapPlusPlus.mk.zstd >> $PCAPPLUSPLUS_MK
 fi
 
+if [ -n "$DISABLE_DEBUG_LOG" ]; then
+   echo -e "# compile only error log messages\nPCAPPP_BUILD_FLAGS += -DPCPP_MIN_LOG_LEVEL=1\n" >> $PCAPPLUSPLUS_MK
+fi
+
 # non-default libpcap include dir
 if [ -n "$LIBPCAP_INLCUDE_DIR" ]; then
    echo -e "# non-default libpcap include dir" >> $PCAPPLUSPLUS_MK
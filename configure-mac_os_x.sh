@@ -12,7 +12,7 @@ SCRIPT=`basename ${BASH_SOURCE[0]}`
 # help function
 function HELP {
    echo -e \\n"Help documentation for ${SCRIPT}."\\n
-   echo -e "Basic usage: $SCRIPT [-h] [--use-immediate-mode] [--set-direction-enabled] [--install-dir] [--libpcap-include-dir] [--libpcap-lib-dir] [--use-zstd]"\\n
+   echo -e "Basic usage: $SCRIPT [-h] [--use-immediate-mode] [--set-direction-enabled] [--install-dir] [--libpcap-include-dir] [--libpcap-lib-dir] [--use-zstd] [--disable-debug-log]"\\n
    echo "The following switches are recognized:"
    echo "--use-immediate-mode     --Use libpcap immediate mode which enables getting packets as fast as possible (supported on libpcap>=1.5)"
    echo ""
@@ -26,6 +26,9 @@ function HELP {
    echo "                           the lib file in the default lib paths"
    echo "--use-zstd               --Use Zstd for pcapng files compression/decompression. This parameter is optional"
    echo ""
+   echo "--disable-debug-log      --Remove debug log messages at compile time. LOG_DEBUG statements won't be compiled and debug"
+   echo "                           log level can't be enabled at runtime. This parameter is optional"
+   echo ""
    echo -e "-h|--help                --Displays this help message and exits. No further actions are performed"\\n
    echo -e "Examples:"
    echo -e "      $SCRIPT"
@@ -102,6 +105,11 @@ case $key in
      USE_ZSTD=1
      shift ;;     
 
+   # remove debug logs at compile time
+   --disable-debug-log)
+     DISABLE_DEBUG_LOG=1
+     shift ;;
+
    # help switch - display help and exit
    -h|--help)
      HELP ;;
@@ -165,6 +173,10 @@ if [ -n "$USE_ZSTD" ]; then
    cat mk/PcapPlusPlus.mk.zstd >> $PCAPPLUSPLUS_MK
 fi
 
+if [ -n "$DISABLE_DEBUG_LOG" ]; then
+   echo -e "# compile only error log messages\nPCAPPP_BUILD_FLAGS += -DPCPP_MIN_LOG_LEVEL=1\n" >> $PCAPPLUSPLUS_MK
+fi
+
 # generate installation and uninstallation scripts
 cp mk/install.sh.template mk/install.sh
 sed -i.bak "s|{{INSTALL_DIR}}|$INSTALL_DIR|g" mk/install.sh && rm mk/install.sh.bak